@@ -0,0 +1,24 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _ASM_POWERPC_FAST_CLOCK_H
+#define _ASM_POWERPC_FAST_CLOCK_H
+
+#include <linux/ktime.h>
+#include <asm/time.h>
+
+/*
+ * The fast clock is the timebase: reading it is mftb (mftbu/mftb/mftbu
+ * on 32-bit), with no seqcount and no scaling.
+ */
+static inline u64 fast_clock_now(void)
+{
+	return get_tb();
+}
+
+static inline u64 fast_clock_to_ns(u64 delta)
+{
+	return tb_to_ns(delta);
+}
+
+ktime_t fast_clock_to_ktime(u64 stamp);
+
+#endif /* _ASM_POWERPC_FAST_CLOCK_H */
@@ -9,9 +9,14 @@
 
 #include <linux/compiler.h>
 #include <linux/types.h>
+#include <asm/time.h>
 
 extern u64 notrace trace_clock_ppc_tb(void);
 
 #define ARCH_TRACE_CLOCKS { trace_clock_ppc_tb, "ppc-tb", 0 },
 
+/* the fixed-record rings store the raw timebase */
+#define trace_fixed_clock()	get_tb()
+#define TRACE_FIXED_CLOCK	"ppc-tb"
+
 #endif  /* _ASM_PPC_TRACE_CLOCK_H */
@@ -0,0 +1,19 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Nintendo Wii kexec state handoff area
+ */
+#ifndef __ASM_POWERPC_WII_HANDOFF_H__
+#define __ASM_POWERPC_WII_HANDOFF_H__
+
+struct kimage;
+
+#if defined(CONFIG_WII_HANDOFF) && defined(CONFIG_KEXEC_CORE)
+extern int wii_handoff_kexec_prepare(struct kimage *image);
+#else
+static inline int wii_handoff_kexec_prepare(struct kimage *image)
+{
+	return 0;
+}
+#endif
+
+#endif /* __ASM_POWERPC_WII_HANDOFF_H__ */
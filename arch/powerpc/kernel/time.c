@@ -63,6 +63,7 @@
 #include <asm/machdep.h>
 #include <linux/uaccess.h>
 #include <asm/time.h>
+#include <asm/fast_clock.h>
 #include <asm/prom.h>
 #include <asm/irq.h>
 #include <asm/div64.h>
@@ -670,6 +671,24 @@ unsigned long long tb_to_ns(unsigned long long ticks)
 }
 EXPORT_SYMBOL_GPL(tb_to_ns);
 
+/*
+ * Convert a timebase value from fast_clock_now() to CLOCK_MONOTONIC, by
+ * taking its age off the current time. Only the frequency adjustment
+ * over that age is lost, which is negligible for the packet and frame
+ * stamps this is meant for.
+ */
+ktime_t fast_clock_to_ktime(u64 stamp)
+{
+	u64 tb = get_tb();
+	ktime_t now = ktime_get();
+
+	if (unlikely(stamp > tb))
+		return now;
+
+	return ktime_sub_ns(now, tb_to_ns(tb - stamp));
+}
+EXPORT_SYMBOL_GPL(fast_clock_to_ktime);
+
 /*
  * Scheduler clock - returns current time in nanosec units.
  *
@@ -90,6 +90,17 @@ static int find_free_bat(void)
 	return -1;
 }
 
+static int __init num_used_bats(void)
+{
+	int b, used = 0;
+	int n = mmu_has_feature(MMU_FTR_USE_HIGH_BATS) ? 8 : 4;
+
+	for (b = 0; b < n; b++)
+		if (BATS[b][1].batu & 3)
+			used++;
+	return used;
+}
+
 /*
  * This function calculates the size of the larger block usable to map the
  * beginning of an area based on the start address and size of that area:
@@ -156,12 +167,12 @@ static unsigned long __init __mmu_mapin_ram(unsigned long base, unsigned long to
 	return base;
 }
 
-unsigned long __init mmu_mapin_ram(unsigned long base, unsigned long top)
+static unsigned long __init mmu_mapin_ram_bats(unsigned long base,
+					       unsigned long top)
 {
 	unsigned long done;
 	unsigned long border = (unsigned long)__init_begin - PAGE_OFFSET;
 
-
 	if (debug_pagealloc_enabled_or_kfence() || __map_without_bats) {
 		pr_debug_once("Read-Write memory mapped without BATs\n");
 		if (base >= border)
@@ -180,6 +191,22 @@ unsigned long __init mmu_mapin_ram(unsigned long base, unsigned long top)
 	return __mmu_mapin_ram(border, top);
 }
 
+/*
+ * Called by mapin_ram() for each memory region, so on the Wii once for
+ * MEM1 and once for MEM2. What is not BAT mapped is left for the hash
+ * table.
+ */
+unsigned long __init mmu_mapin_ram(unsigned long base, unsigned long top)
+{
+	unsigned long done = mmu_mapin_ram_bats(base, top);
+
+	pr_info("RAM 0x%08lx-0x%08lx: %luK BAT mapped, %luK page mapped, %d of %d BATs used\n",
+		base, top - 1, (done - base) >> 10, (top - done) >> 10,
+		num_used_bats(), mmu_has_feature(MMU_FTR_USE_HIGH_BATS) ? 8 : 4);
+
+	return done;
+}
+
 static bool is_module_segment(unsigned long addr)
 {
 	if (!IS_ENABLED(CONFIG_MODULES))
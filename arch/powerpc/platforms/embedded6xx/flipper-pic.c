@@ -208,9 +208,10 @@ void __init flipper_pic_probe(void)
  */
 void flipper_quiesce(void)
 {
-	void __iomem *io_base = flipper_irq_host->host_data;
+	if (!flipper_irq_host)
+		return;
 
-	__flipper_quiesce(io_base);
+	__flipper_quiesce(flipper_irq_host->host_data);
 }
 
 /*
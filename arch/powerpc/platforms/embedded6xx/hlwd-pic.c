@@ -10,10 +10,12 @@
 #define pr_fmt(fmt) DRV_MODULE_NAME ": " fmt
 
 #include <linux/kernel.h>
+#include <linux/debugfs.h>
 #include <linux/irq.h>
 #include <linux/of.h>
 #include <linux/of_address.h>
 #include <linux/of_irq.h>
+#include <linux/ratelimit.h>
 #include <asm/io.h>
 
 #include "hlwd-pic.h"
@@ -33,6 +35,20 @@
 #define HW_STARLET_ICR		0x08
 #define HW_STARLET_IMR		0x0c
 
+/*
+ * Software copy of the Broadway IMR. Only this driver writes that
+ * register, so mask and unmask update the copy and do a single write
+ * instead of an uncached read-modify-write, and the cascade handler
+ * only has to read ICR. The chip hooks run with interrupts disabled
+ * and the platform is UP-only, so no further locking is needed.
+ */
+static u32 hlwd_broadway_imr;
+
+static void hlwd_pic_write_imr(void __iomem *io_base, u32 imr)
+{
+	hlwd_broadway_imr = imr;
+	out_be32(io_base + HW_BROADWAY_IMR, imr);
+}
 
 /*
  * IRQ chip hooks.
@@ -45,7 +61,7 @@ static void hlwd_pic_mask_and_ack(struct irq_data *d)
 	void __iomem *io_base = irq_data_get_irq_chip_data(d);
 	u32 mask = 1 << irq;
 
-	clrbits32(io_base + HW_BROADWAY_IMR, mask);
+	hlwd_pic_write_imr(io_base, hlwd_broadway_imr & ~mask);
 	out_be32(io_base + HW_BROADWAY_ICR, mask);
 }
 
@@ -62,7 +78,7 @@ static void hlwd_pic_mask(struct irq_data *d)
 	int irq = irqd_to_hwirq(d);
 	void __iomem *io_base = irq_data_get_irq_chip_data(d);
 
-	clrbits32(io_base + HW_BROADWAY_IMR, 1 << irq);
+	hlwd_pic_write_imr(io_base, hlwd_broadway_imr & ~(1 << irq));
 }
 
 static void hlwd_pic_unmask(struct irq_data *d)
@@ -70,7 +86,7 @@ static void hlwd_pic_unmask(struct irq_data *d)
 	int irq = irqd_to_hwirq(d);
 	void __iomem *io_base = irq_data_get_irq_chip_data(d);
 
-	setbits32(io_base + HW_BROADWAY_IMR, 1 << irq);
+	hlwd_pic_write_imr(io_base, hlwd_broadway_imr | (1 << irq));
 
 	/* Make sure the ARM (aka. Starlet) doesn't handle this interrupt. */
 	clrbits32(io_base + HW_STARLET_IMR, 1 << irq);
@@ -83,6 +99,8 @@ static struct irq_chip hlwd_pic = {
 	.irq_mask_ack	= hlwd_pic_mask_and_ack,
 	.irq_mask	= hlwd_pic_mask,
 	.irq_unmask	= hlwd_pic_unmask,
+	/* no wakeup configuration, the lines stay wired to Broadway */
+	.flags		= IRQCHIP_SKIP_SET_WAKE,
 };
 
 /*
@@ -105,34 +123,63 @@ static const struct irq_domain_ops hlwd_irq_domain_ops = {
 	.map = hlwd_pic_map,
 };
 
-static unsigned int __hlwd_pic_get_irq(struct irq_domain *h)
+static u32 __hlwd_pic_get_pending(struct irq_domain *h)
 {
 	void __iomem *io_base = h->host_data;
+
+	return in_be32(io_base + HW_BROADWAY_ICR) & hlwd_broadway_imr;
+}
+
+static unsigned int __hlwd_pic_get_irq(struct irq_domain *h)
+{
 	u32 irq_status;
 
-	irq_status = in_be32(io_base + HW_BROADWAY_ICR) &
-		     in_be32(io_base + HW_BROADWAY_IMR);
+	irq_status = __hlwd_pic_get_pending(h);
 	if (irq_status == 0)
 		return 0;	/* no more IRQs pending */
 
 	return __ffs(irq_status);
 }
 
+/*
+ * Spurious cascade interrupts are counted, and only reported, deferred and
+ * rate limited, as a storm of them must not also be written out to a slow
+ * console from the interrupt.
+ */
+static u32 hlwd_pic_spurious;
+static DEFINE_RATELIMIT_STATE(hlwd_pic_spurious_rs, DEFAULT_RATELIMIT_INTERVAL,
+			      DEFAULT_RATELIMIT_BURST);
+
 static void hlwd_pic_irq_cascade(struct irq_desc *desc)
 {
 	struct irq_chip *chip = irq_desc_get_chip(desc);
 	struct irq_domain *irq_domain = irq_desc_get_handler_data(desc);
 	unsigned int hwirq;
+	u32 pending;
 
 	raw_spin_lock(&desc->lock);
 	chip->irq_mask(&desc->irq_data); /* IRQ_LEVEL */
 	raw_spin_unlock(&desc->lock);
 
-	hwirq = __hlwd_pic_get_irq(irq_domain);
-	if (hwirq)
+	/*
+	 * Dispatch everything that was pending at the time of the read,
+	 * and only go back to the hardware once that set is drained.
+	 */
+	pending = __hlwd_pic_get_pending(irq_domain);
+	if (!pending) {
+		hlwd_pic_spurious++;
+		if (__ratelimit(&hlwd_pic_spurious_rs))
+			printk_deferred(KERN_ERR pr_fmt("spurious interrupt!\n"));
+	}
+
+	while (pending) {
+		hwirq = __ffs(pending);
+		pending &= ~(1 << hwirq);
 		generic_handle_domain_irq(irq_domain, hwirq);
-	else
-		pr_err("spurious interrupt!\n");
+
+		if (!pending)
+			pending = __hlwd_pic_get_pending(irq_domain);
+	}
 
 	raw_spin_lock(&desc->lock);
 	chip->irq_ack(&desc->irq_data); /* IRQ_LEVEL */
@@ -149,7 +196,7 @@ static void hlwd_pic_irq_cascade(struct irq_desc *desc)
 static void __hlwd_quiesce(void __iomem *io_base)
 {
 	/* mask and ack all IRQs */
-	out_be32(io_base + HW_BROADWAY_IMR, 0);
+	hlwd_pic_write_imr(io_base, 0);
 	out_be32(io_base + HW_BROADWAY_ICR, 0xffffffff);
 }
 
@@ -219,6 +266,15 @@ void hlwd_pic_probe(void)
 	}
 }
 
+static int __init hlwd_pic_debugfs_init(void)
+{
+	if (hlwd_irq_host)
+		debugfs_create_u32("hlwd_pic_spurious", 0400, arch_debugfs_dir,
+				   &hlwd_pic_spurious);
+	return 0;
+}
+device_initcall(hlwd_pic_debugfs_init);
+
 /**
  * hlwd_quiesce() - quiesce hollywood irq controller
  *
@@ -227,8 +283,9 @@ void hlwd_pic_probe(void)
  */
 void hlwd_quiesce(void)
 {
-	void __iomem *io_base = hlwd_irq_host->host_data;
+	if (!hlwd_irq_host)
+		return;
 
-	__hlwd_quiesce(io_base);
+	__hlwd_quiesce(hlwd_irq_host->host_data);
 }
 
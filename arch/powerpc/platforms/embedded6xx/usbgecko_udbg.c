@@ -5,8 +5,29 @@
  * udbg serial input/output routines for the USB Gecko adapter.
  * Copyright (C) 2008-2009 The GameCube Linux Team
  * Copyright (C) 2008,2009 Albert Herranz
+ *
+ * Once the kernel is up, output is queued in a ring buffer and drained
+ * from a timer as fast as the adapter takes it, instead of busy-waiting
+ * on every character. Console text that does not fit in the buffer is
+ * dropped and the loss reported once there is room again. Oopses and
+ * panics still go out synchronously.
+ *
+ * Binary data (e.g. ftrace's trace_pipe_raw) can be sent over the same
+ * link by writing it to debugfs powerpc/usbgecko. Each write becomes a
+ * frame of a zero byte, a 16 bit big endian payload length and the
+ * payload. Console text never contains zero bytes, so host tools can
+ * tell the two apart.
  */
 
+#include <linux/debugfs.h>
+#include <linux/init.h>
+#include <linux/kfifo.h>
+#include <linux/mutex.h>
+#include <linux/spinlock.h>
+#include <linux/timer.h>
+#include <linux/uaccess.h>
+#include <linux/wait.h>
+
 #include <mm/mmu_decl.h>
 
 #include <asm/io.h>
@@ -36,9 +57,19 @@
 #define UG_READ_ATTEMPTS	100
 #define UG_WRITE_ATTEMPTS	100
 
+#define UG_FIFO_SIZE		16384	/* power of 2 */
+#define UG_DRAIN_BATCH		64	/* bytes per ug_fifo_lock hold */
+#define UG_FRAME_MAX		1024	/* stream payload per frame */
+
 
 static void __iomem *ug_io_base;
 
+static DEFINE_SPINLOCK(ug_fifo_lock);
+static DEFINE_KFIFO(ug_fifo, u8, UG_FIFO_SIZE);
+static DECLARE_WAIT_QUEUE_HEAD(ug_fifo_wait);
+static struct timer_list ug_drain_timer;
+static unsigned long ug_fifo_dropped;
+
 /*
  * Performs one input/output transaction between the exi host and the usbgecko.
  */
@@ -100,25 +131,33 @@ static void ug_raw_putc(char ch)
 }
 
 /*
- * Transmits a character.
+ * Transmits a byte as is.
  * It silently fails if the TX fifo is not ready after a number of retries.
  */
-static void ug_putc(char ch)
+static void __ug_putc(char ch)
 {
 	int count = UG_WRITE_ATTEMPTS;
 
-	if (!ug_io_base)
-		return;
-
-	if (ch == '\n')
-		ug_putc('\r');
-
 	while (!ug_is_txfifo_ready() && count--)
 		barrier();
 	if (count >= 0)
 		ug_raw_putc(ch);
 }
 
+/*
+ * Transmits a character.
+ * It silently fails if the TX fifo is not ready after a number of retries.
+ */
+static void ug_putc(char ch)
+{
+	if (!ug_io_base)
+		return;
+
+	if (ch == '\n')
+		__ug_putc('\r');
+	__ug_putc(ch);
+}
+
 /*
  * Returns true if the RX fifo is ready for transmission.
  */
@@ -169,6 +208,111 @@ static void ug_udbg_putc(char ch)
 	ug_putc(ch);
 }
 
+/*
+ * Sends everything queued, busy-waiting on the adapter.
+ * Called with ug_fifo_lock held.
+ */
+static void ug_flush_locked(void)
+{
+	u8 ch;
+
+	while (kfifo_get(&ug_fifo, &ch))
+		__ug_putc(ch);
+}
+
+static void ug_flush(void)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&ug_fifo_lock, flags);
+	ug_flush_locked();
+	spin_unlock_irqrestore(&ug_fifo_lock, flags);
+}
+
+/*
+ * Queues a character, or sends it right away when an oops is in
+ * progress. Drops it when the buffer is full.
+ */
+static void ug_udbg_putc_buffered(char ch)
+{
+	unsigned long flags;
+	int locked = 1;
+
+	if (oops_in_progress)
+		locked = spin_trylock_irqsave(&ug_fifo_lock, flags);
+	else
+		spin_lock_irqsave(&ug_fifo_lock, flags);
+
+	if (oops_in_progress) {
+		if (locked)
+			ug_flush_locked();
+		ug_putc(ch);
+	} else if (kfifo_avail(&ug_fifo) < 2) {
+		ug_fifo_dropped++;
+	} else if (ch) {
+		if (ch == '\n')
+			kfifo_put(&ug_fifo, '\r');
+		kfifo_put(&ug_fifo, ch);
+		if (!timer_pending(&ug_drain_timer))
+			mod_timer(&ug_drain_timer, jiffies + 1);
+	}
+
+	if (locked)
+		spin_unlock_irqrestore(&ug_fifo_lock, flags);
+}
+
+/*
+ * Queues a note about console text lost to a full buffer.
+ * Called with ug_fifo_lock held.
+ */
+static void ug_note_dropped_locked(void)
+{
+	char note[40];
+	int len;
+
+	len = scnprintf(note, sizeof(note), "\r\n[usbgecko: %lu dropped]\r\n",
+			ug_fifo_dropped);
+	if (kfifo_avail(&ug_fifo) < len)
+		return;
+	kfifo_in(&ug_fifo, note, len);
+	ug_fifo_dropped = 0;
+}
+
+/*
+ * Sends queued bytes until the buffer is empty, as long as the adapter
+ * takes them without waiting, and comes back on the next tick if it
+ * does not. The lock is dropped every UG_DRAIN_BATCH bytes so that
+ * interrupts are not held off for the whole buffer.
+ */
+static void ug_drain(struct timer_list *unused)
+{
+	unsigned int sent;
+	unsigned long flags;
+	bool more, ready;
+	u8 ch;
+
+	do {
+		sent = 0;
+		spin_lock_irqsave(&ug_fifo_lock, flags);
+		if (ug_fifo_dropped && kfifo_is_empty(&ug_fifo))
+			ug_note_dropped_locked();
+		while (sent < UG_DRAIN_BATCH &&
+		       (ready = ug_is_txfifo_ready()) &&
+		       kfifo_get(&ug_fifo, &ch)) {
+			ug_raw_putc(ch);
+			sent++;
+		}
+		more = !kfifo_is_empty(&ug_fifo) || ug_fifo_dropped;
+		spin_unlock_irqrestore(&ug_fifo_lock, flags);
+
+		if (sent)
+			wake_up(&ug_fifo_wait);
+	} while (more && ready);
+
+	if (more)
+		mod_timer(&ug_drain_timer, jiffies + 1);
+}
+
 /*
  * Receives a character. Waits until a character is available.
  */
@@ -176,6 +320,9 @@ static int ug_udbg_getc(void)
 {
 	int ch;
 
+	/* whoever waits for input (e.g. xmon) wants its prompt out first */
+	ug_flush();
+
 	while ((ch = ug_getc()) == -1)
 		barrier();
 	return ch;
@@ -186,6 +333,8 @@ static int ug_udbg_getc(void)
  */
 static int ug_udbg_getc_poll(void)
 {
+	ug_flush();
+
 	if (!ug_is_rxfifo_ready())
 		return -1;
 	return ug_getc();
@@ -267,6 +416,79 @@ void __init ug_udbg_init(void)
 	return;
 }
 
+static DEFINE_MUTEX(ug_stream_mutex);
+static u8 ug_frame[3 + UG_FRAME_MAX];
+
+/*
+ * Sends one frame of binary data, waiting for room in the buffer.
+ */
+static ssize_t ug_stream_write(struct file *file, const char __user *ubuf,
+			       size_t count, loff_t *ppos)
+{
+	size_t len = min_t(size_t, count, UG_FRAME_MAX);
+	unsigned long flags;
+	ssize_t ret;
+
+	if (!len)
+		return 0;
+
+	mutex_lock(&ug_stream_mutex);
+
+	if (copy_from_user(ug_frame + 3, ubuf, len)) {
+		ret = -EFAULT;
+		goto out;
+	}
+	ug_frame[0] = 0;
+	ug_frame[1] = len >> 8;
+	ug_frame[2] = len & 0xff;
+
+	for (;;) {
+		ret = wait_event_interruptible(ug_fifo_wait,
+					       kfifo_avail(&ug_fifo) >= len + 3);
+		if (ret)
+			goto out;
+
+		spin_lock_irqsave(&ug_fifo_lock, flags);
+		if (kfifo_avail(&ug_fifo) >= len + 3)
+			break;
+		spin_unlock_irqrestore(&ug_fifo_lock, flags);
+	}
+
+	kfifo_in(&ug_fifo, ug_frame, len + 3);
+	if (!timer_pending(&ug_drain_timer))
+		mod_timer(&ug_drain_timer, jiffies + 1);
+	spin_unlock_irqrestore(&ug_fifo_lock, flags);
+
+	ret = len;
+out:
+	mutex_unlock(&ug_stream_mutex);
+	return ret;
+}
+
+static const struct file_operations ug_stream_fops = {
+	.owner	= THIS_MODULE,
+	.open	= simple_open,
+	.write	= ug_stream_write,
+	.llseek	= noop_llseek,
+};
+
+/*
+ * Switches the udbg output to the buffered path once timers work.
+ */
+static int __init ug_udbg_buffered_init(void)
+{
+	if (udbg_putc != ug_udbg_putc)
+		return 0;
+
+	timer_setup(&ug_drain_timer, ug_drain, 0);
+	udbg_putc = ug_udbg_putc_buffered;
+
+	debugfs_create_file("usbgecko", 0200, arch_debugfs_dir, NULL,
+			    &ug_stream_fops);
+	return 0;
+}
+late_initcall(ug_udbg_buffered_init);
+
 #ifdef CONFIG_PPC_EARLY_DEBUG_USBGECKO
 
 static phys_addr_t __init ug_early_grab_io_addr(void)
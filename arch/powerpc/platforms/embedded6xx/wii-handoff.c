@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * arch/powerpc/platforms/embedded6xx/wii-handoff.c
+ *
+ * Nintendo Wii kexec state handoff area
+ *
+ * wii_handoff=<size>@<addr> sets aside a fixed range of RAM that the
+ * kernel leaves alone. A kernel started through kexec with the same
+ * parameter finds in it whatever the previous one left there, which lets
+ * a title switch hand its state over without going through the firmware.
+ * The area is read and written through /sys/firmware/wii_handoff, and
+ * kexec images that would load into it are refused.
+ */
+#define DRV_MODULE_NAME "wii-handoff"
+#define pr_fmt(fmt) DRV_MODULE_NAME ": " fmt
+
+#include <linux/kernel.h>
+#include <linux/init.h>
+#include <linux/kexec.h>
+#include <linux/kobject.h>
+#include <linux/memblock.h>
+#include <linux/sysfs.h>
+
+#include <asm/cacheflush.h>
+#include <asm/sections.h>
+#include <asm/wii_handoff.h>
+
+static phys_addr_t handoff_base;
+static phys_addr_t handoff_size;
+
+/*
+ * Parsed from early_init_devtree(), once memblock knows about the memory
+ * but before anything is allocated from it.
+ */
+static int __init wii_handoff_setup(char *str)
+{
+	phys_addr_t base, size;
+	char *cur = str;
+
+	size = memparse(cur, &cur);
+	if (!size || *cur != '@')
+		return -EINVAL;
+	base = memparse(cur + 1, NULL);
+
+	if (!PAGE_ALIGNED(base) || !PAGE_ALIGNED(size) ||
+	    base < __pa(_end) || !memblock_is_region_memory(base, size) ||
+	    memblock_is_region_reserved(base, size)) {
+		pr_err("%pa@%pa is not a free page aligned range\n",
+		       &size, &base);
+		return -EINVAL;
+	}
+
+	memblock_reserve(base, size);
+	handoff_base = base;
+	handoff_size = size;
+	return 0;
+}
+early_param("wii_handoff", wii_handoff_setup);
+
+#ifdef CONFIG_KEXEC_CORE
+int wii_handoff_kexec_prepare(struct kimage *image)
+{
+	unsigned long i;
+
+	for (i = 0; i < image->nr_segments; i++) {
+		phys_addr_t mem = image->segment[i].mem;
+		size_t memsz = image->segment[i].memsz;
+
+		if (mem < handoff_base + handoff_size &&
+		    mem + memsz > handoff_base) {
+			pr_err("kexec segment at %pa overlaps the handoff area\n",
+			       &mem);
+			return -EBUSY;
+		}
+	}
+	return 0;
+}
+#endif
+
+static ssize_t wii_handoff_read(struct file *file, struct kobject *kobj,
+		struct bin_attribute *attr, char *buf, loff_t off, size_t count)
+{
+	memcpy(buf, __va(handoff_base) + off, count);
+	return count;
+}
+
+/* flushed, the next kernel may look at the area with the caches off */
+static ssize_t wii_handoff_write(struct file *file, struct kobject *kobj,
+		struct bin_attribute *attr, char *buf, loff_t off, size_t count)
+{
+	void *dst = __va(handoff_base) + off;
+
+	memcpy(dst, buf, count);
+	flush_dcache_range((unsigned long)dst, (unsigned long)dst + count);
+	return count;
+}
+
+static struct bin_attribute wii_handoff_attr =
+	__BIN_ATTR(wii_handoff, 0600, wii_handoff_read, wii_handoff_write, 0);
+
+static int __init wii_handoff_init(void)
+{
+	int error;
+
+	if (!handoff_size)
+		return 0;
+
+	wii_handoff_attr.size = handoff_size;
+	error = sysfs_create_bin_file(firmware_kobj, &wii_handoff_attr);
+	if (error) {
+		pr_err("failed to create the sysfs file: %d\n", error);
+		return error;
+	}
+
+	pr_info("%pa bytes at %pa\n", &handoff_size, &handoff_base);
+	return 0;
+}
+device_initcall(wii_handoff_init);
@@ -9,19 +9,23 @@
 #define DRV_MODULE_NAME "wii"
 #define pr_fmt(fmt) DRV_MODULE_NAME ": " fmt
 
+#include <linux/async.h>
 #include <linux/kernel.h>
 #include <linux/init.h>
 #include <linux/irq.h>
+#include <linux/kexec.h>
 #include <linux/seq_file.h>
 #include <linux/of_platform.h>
 #include <linux/memblock.h>
 #include <mm/mmu_decl.h>
 
+#include <asm/cpu_has_feature.h>
 #include <asm/io.h>
 #include <asm/machdep.h>
 #include <asm/prom.h>
 #include <asm/time.h>
 #include <asm/udbg.h>
+#include <asm/wii_handoff.h>
 
 #include "flipper-pic.h"
 #include "hlwd-pic.h"
@@ -101,6 +105,16 @@ static void __iomem *wii_ioremap_hw_regs(char *name, char *compatible)
 
 static void __init wii_setup_arch(void)
 {
+	/*
+	 * Broadway is the only CPU and devices DMA to non-coherent memory,
+	 * so the loss of snooping while napping does not matter. Nap instead
+	 * of doze when idle; the powersave-nap sysctl can still turn it off.
+	 */
+	if (cpu_has_feature(CPU_FTR_CAN_NAP)) {
+		powersave_nap = 1;
+		pr_debug("Processor NAP mode on idle enabled.\n");
+	}
+
 	hw_ctrl = wii_ioremap_hw_regs("hw_ctrl", HW_CTRL_COMPATIBLE);
 	hw_gpio = wii_ioremap_hw_regs("hw_gpio", HW_GPIO_COMPATIBLE);
 	if (hw_gpio) {
@@ -166,23 +180,52 @@ static int __init wii_probe(void)
 	return 1;
 }
 
+/*
+ * Also the last step before a kexec: the drivers' shutdown methods have
+ * stopped the DMA of their devices, and nothing may interrupt the new
+ * kernel before it sets up its own controllers.
+ */
 static void wii_shutdown(void)
 {
 	hlwd_quiesce();
 	flipper_quiesce();
 }
 
+#ifdef CONFIG_KEXEC_CORE
+static int wii_kexec_prepare(struct kimage *image)
+{
+	int error;
+
+	error = default_machine_kexec_prepare(image);
+	if (error)
+		return error;
+
+	return wii_handoff_kexec_prepare(image);
+}
+#endif
+
 static const struct of_device_id wii_of_bus[] = {
 	{ .compatible = "nintendo,hollywood", },
 	{ },
 };
 
+static void __init wii_populate(void *data, async_cookie_t cookie)
+{
+	of_platform_populate(NULL, wii_of_bus, NULL, NULL);
+}
+
+/*
+ * Several of the Hollywood devices wait on hardware timeouts while they
+ * probe, so create them from an async thread to take these waits off the
+ * initcall sequence. Mounting the root filesystem still waits for the
+ * probes through wait_for_device_probe().
+ */
 static int __init wii_device_probe(void)
 {
 	if (!machine_is(wii))
 		return 0;
 
-	of_platform_populate(NULL, wii_of_bus, NULL, NULL);
+	async_schedule(wii_populate, NULL);
 	return 0;
 }
 device_initcall(wii_device_probe);
@@ -198,4 +241,7 @@ define_machine(wii) {
 	.calibrate_decr		= generic_calibrate_decr,
 	.progress		= udbg_progress,
 	.machine_shutdown	= wii_shutdown,
+#ifdef CONFIG_KEXEC_CORE
+	.machine_kexec_prepare	= wii_kexec_prepare,
+#endif
 };
@@ -358,9 +358,22 @@ void bfqg_stats_update_legacy_io(struct request_queue *q, struct request *rq)
 	blkg_rwstat_add(&bfqg->stats.ios, rq->cmd_flags, 1);
 }
 
+/* Called on dispatch of a request of an interactive bfqq. */
+void bfqg_stats_update_interactive(struct bfq_group *bfqg, struct request *rq)
+{
+	u64 now = ktime_get_ns();
+
+	if (now > rq->start_time_ns)
+		blkg_rwstat_add(&bfqg->stats.interactive_wait_time,
+				rq->cmd_flags, now - rq->start_time_ns);
+	blkg_rwstat_add(&bfqg->stats.interactive_ios, rq->cmd_flags, 1);
+}
+
 /* @stats = 0 */
 static void bfqg_stats_reset(struct bfqg_stats *stats)
 {
+	blkg_rwstat_reset(&stats->interactive_wait_time);
+	blkg_rwstat_reset(&stats->interactive_ios);
 #ifdef CONFIG_BFQ_CGROUP_DEBUG
 	/* queued stats shouldn't be cleared */
 	blkg_rwstat_reset(&stats->merged);
@@ -382,6 +395,9 @@ static void bfqg_stats_add_aux(struct bfqg_stats *to, struct bfqg_stats *from)
 	if (!to || !from)
 		return;
 
+	blkg_rwstat_add_aux(&to->interactive_wait_time,
+			    &from->interactive_wait_time);
+	blkg_rwstat_add_aux(&to->interactive_ios, &from->interactive_ios);
 #ifdef CONFIG_BFQ_CGROUP_DEBUG
 	/* queued stats shouldn't be cleared */
 	blkg_rwstat_add_aux(&to->merged, &from->merged);
@@ -444,6 +460,8 @@ static void bfqg_stats_exit(struct bfqg_stats *stats)
 {
 	blkg_rwstat_exit(&stats->bytes);
 	blkg_rwstat_exit(&stats->ios);
+	blkg_rwstat_exit(&stats->interactive_wait_time);
+	blkg_rwstat_exit(&stats->interactive_ios);
 #ifdef CONFIG_BFQ_CGROUP_DEBUG
 	blkg_rwstat_exit(&stats->merged);
 	blkg_rwstat_exit(&stats->service_time);
@@ -465,6 +483,12 @@ static int bfqg_stats_init(struct bfqg_stats *stats, gfp_t gfp)
 	    blkg_rwstat_init(&stats->ios, gfp))
 		return -ENOMEM;
 
+	if (blkg_rwstat_init(&stats->interactive_wait_time, gfp) ||
+	    blkg_rwstat_init(&stats->interactive_ios, gfp)) {
+		bfqg_stats_exit(stats);
+		return -ENOMEM;
+	}
+
 #ifdef CONFIG_BFQ_CGROUP_DEBUG
 	if (blkg_rwstat_init(&stats->merged, gfp) ||
 	    blkg_rwstat_init(&stats->service_time, gfp) ||
@@ -1280,6 +1304,16 @@ struct cftype bfq_blkcg_legacy_files[] = {
 		.private = offsetof(struct bfq_group, stats.ios),
 		.seq_show = bfqg_print_rwstat,
 	},
+	{
+		.name = "bfq.interactive_wait_time",
+		.private = offsetof(struct bfq_group, stats.interactive_wait_time),
+		.seq_show = bfqg_print_rwstat,
+	},
+	{
+		.name = "bfq.interactive_serviced",
+		.private = offsetof(struct bfq_group, stats.interactive_ios),
+		.seq_show = bfqg_print_rwstat,
+	},
 #ifdef CONFIG_BFQ_CGROUP_DEBUG
 	{
 		.name = "bfq.time",
@@ -1323,6 +1357,16 @@ struct cftype bfq_blkcg_legacy_files[] = {
 		.private = offsetof(struct bfq_group, stats.ios),
 		.seq_show = bfqg_print_rwstat_recursive,
 	},
+	{
+		.name = "bfq.interactive_wait_time_recursive",
+		.private = offsetof(struct bfq_group, stats.interactive_wait_time),
+		.seq_show = bfqg_print_rwstat_recursive,
+	},
+	{
+		.name = "bfq.interactive_serviced_recursive",
+		.private = offsetof(struct bfq_group, stats.interactive_ios),
+		.seq_show = bfqg_print_rwstat_recursive,
+	},
 #ifdef CONFIG_BFQ_CGROUP_DEBUG
 	{
 		.name = "bfq.time_recursive",
@@ -1388,6 +1432,16 @@ struct cftype bfq_blkg_files[] = {
 		.seq_show = bfq_io_show_weight,
 		.write = bfq_io_set_weight,
 	},
+	{
+		.name = "bfq.interactive_wait_time",
+		.private = offsetof(struct bfq_group, stats.interactive_wait_time),
+		.seq_show = bfqg_print_rwstat_recursive,
+	},
+	{
+		.name = "bfq.interactive_serviced",
+		.private = offsetof(struct bfq_group, stats.interactive_ios),
+		.seq_show = bfqg_print_rwstat_recursive,
+	},
 	{} /* terminate */
 };
 
@@ -1411,6 +1465,9 @@ void bfq_init_entity(struct bfq_entity *entity, struct bfq_group *bfqg)
 
 void bfq_bic_update_cgroup(struct bfq_io_cq *bic, struct bio *bio) {}
 
+void bfqg_stats_update_interactive(struct bfq_group *bfqg,
+				   struct request *rq) {}
+
 void bfq_end_wr_async(struct bfq_data *bfqd)
 {
 	bfq_end_wr_async_queues(bfqd, bfqd->root_group);
@@ -160,6 +160,7 @@ BFQ_BFQQ_FNS(in_large_burst);
 BFQ_BFQQ_FNS(coop);
 BFQ_BFQQ_FNS(split_coop);
 BFQ_BFQQ_FNS(softrt_update);
+BFQ_BFQQ_FNS(interactive);
 #undef BFQ_BFQQ_FNS						\
 
 /* Expiration time of async (0) and sync (1) requests, in ns. */
@@ -1737,8 +1738,9 @@ static void bfq_bfqq_handle_idle_busy_switch(struct bfq_data *bfqd,
 		time_is_before_jiffies(bfqq->soft_rt_next_start) &&
 		bfqq->dispatched == 0 &&
 		bfqq->entity.new_weight == 40;
-	*interactive = !in_burst && idle_for_long_time &&
-		bfqq->entity.new_weight == 40;
+	*interactive = (!in_burst && idle_for_long_time &&
+			bfqq->entity.new_weight == 40) ||
+		bfq_bfqq_interactive(bfqq);
 	/*
 	 * Merged bfq_queues are kept out of weight-raising
 	 * (low-latency) mechanisms. The reason is that these queues
@@ -1750,12 +1752,17 @@ static void bfq_bfqq_handle_idle_busy_switch(struct bfq_data *bfqd,
 	 * application, if the application happens to spawn multiple
 	 * processes. So let also stably-merged queued enjoy weight
 	 * raising.
+	 *
+	 * Queues carrying the interactive hint have asked for low
+	 * latency explicitly, so they are raised even with
+	 * low_latency off.
 	 */
-	wr_or_deserves_wr = bfqd->low_latency &&
-		(bfqq->wr_coeff > 1 ||
-		 (bfq_bfqq_sync(bfqq) &&
-		  (bfqq->bic || RQ_BIC(rq)->stably_merged) &&
-		   (*interactive || soft_rt)));
+	wr_or_deserves_wr = bfq_bfqq_interactive(bfqq) ||
+		(bfqd->low_latency &&
+		 (bfqq->wr_coeff > 1 ||
+		  (bfq_bfqq_sync(bfqq) &&
+		   (bfqq->bic || RQ_BIC(rq)->stably_merged) &&
+		   (*interactive || soft_rt))));
 
 	/*
 	 * Using the last flag, update budget and check whether bfqq
@@ -1789,7 +1796,7 @@ static void bfq_bfqq_handle_idle_busy_switch(struct bfq_data *bfqd,
 
 	bfq_clear_bfqq_just_created(bfqq);
 
-	if (bfqd->low_latency) {
+	if (bfqd->low_latency || bfq_bfqq_interactive(bfqq)) {
 		if (unlikely(time_is_after_jiffies(bfqq->split_time)))
 			/* wraparound */
 			bfqq->split_time =
@@ -1857,10 +1864,16 @@ static void bfq_bfqq_handle_idle_busy_switch(struct bfq_data *bfqd,
 	 * was better to plug I/O dispatch, and to wait for a new
 	 * request to arrive for the currently in-service queue, but
 	 * (2) this switch of bfqq to busy changes the scenario.
+	 *
+	 * Finally, a queue with the interactive hint always preempts
+	 * one without it, to bound the time its requests wait for the
+	 * in-service queue to finish its budget.
 	 */
 	if (bfqd->in_service_queue &&
 	    ((bfqq_wants_to_preempt &&
 	      bfqq->wr_coeff >= bfqd->in_service_queue->wr_coeff) ||
+	     (bfq_bfqq_interactive(bfqq) &&
+	      !bfq_bfqq_interactive(bfqd->in_service_queue)) ||
 	     bfq_bfqq_higher_class_or_weight(bfqq, bfqd->in_service_queue) ||
 	     !bfq_better_to_idle(bfqd->in_service_queue)) &&
 	    next_queue_may_preempt(bfqd))
@@ -2084,6 +2097,19 @@ static void bfq_add_request(struct request *rq)
 	bfqq->queued[rq_is_sync(rq)]++;
 	bfqd->queued++;
 
+	/*
+	 * The hint comes either from the ioprio of the task, through
+	 * the bic, or from the cgroup, through the request.
+	 */
+	if (bfq_bfqq_sync(bfqq)) {
+		if (IOPRIO_PRIO_HINT(rq->ioprio) == IOPRIO_HINT_INTERACTIVE ||
+		    IOPRIO_PRIO_HINT(RQ_BIC(rq)->ioprio) ==
+		    IOPRIO_HINT_INTERACTIVE)
+			bfq_mark_bfqq_interactive(bfqq);
+		else
+			bfq_clear_bfqq_interactive(bfqq);
+	}
+
 	if (RB_EMPTY_ROOT(&bfqq->sort_list) && bfq_bfqq_sync(bfqq)) {
 		bfq_check_waker(bfqd, bfqq, now_ns);
 
@@ -4815,11 +4841,19 @@ static void bfq_update_wr_data(struct bfq_data *bfqd, struct bfq_queue *bfqq)
 			bfq_log_bfqq(bfqd, bfqq, "WARN: pending prio change");
 
 		/*
-		 * If the queue was activated in a burst, or too much
-		 * time has elapsed from the beginning of this
-		 * weight-raising period, then end weight raising.
+		 * Queues with the interactive hint stay raised for as
+		 * long as they carry it: recharge their raising
+		 * instead of ending it. Otherwise, if the queue was
+		 * activated in a burst, or too much time has elapsed
+		 * from the beginning of this weight-raising period,
+		 * then end weight raising.
 		 */
-		if (bfq_bfqq_in_large_burst(bfqq))
+		if (bfq_bfqq_interactive(bfqq)) {
+			if (time_is_before_jiffies(bfqq->last_wr_start_finish +
+						   bfqq->wr_cur_max_time))
+				bfqq->last_wr_start_finish = jiffies;
+			bfqq->service_from_wr = 0;
+		} else if (bfq_bfqq_in_large_burst(bfqq))
 			bfq_bfqq_end_wr(bfqq);
 		else if (time_is_before_jiffies(bfqq->last_wr_start_finish +
 						bfqq->wr_cur_max_time)) {
@@ -4884,6 +4918,9 @@ static struct request *bfq_dispatch_rq_from_bfqq(struct bfq_data *bfqd,
 
 	bfq_dispatch_remove(bfqd->queue, rq);
 
+	if (bfq_bfqq_interactive(bfqq))
+		bfqg_stats_update_interactive(bfqq_group(bfqq), rq);
+
 	if (bfqq != bfqd->in_service_queue)
 		goto return_rq;
 
@@ -5290,11 +5327,11 @@ bfq_set_next_ioprio_data(struct bfq_queue *bfqq, struct bfq_io_cq *bic)
 		bfqq->new_ioprio_class = task_nice_ioclass(tsk);
 		break;
 	case IOPRIO_CLASS_RT:
-		bfqq->new_ioprio = IOPRIO_PRIO_DATA(bic->ioprio);
+		bfqq->new_ioprio = IOPRIO_PRIO_LEVEL(bic->ioprio);
 		bfqq->new_ioprio_class = IOPRIO_CLASS_RT;
 		break;
 	case IOPRIO_CLASS_BE:
-		bfqq->new_ioprio = IOPRIO_PRIO_DATA(bic->ioprio);
+		bfqq->new_ioprio = IOPRIO_PRIO_LEVEL(bic->ioprio);
 		bfqq->new_ioprio_class = IOPRIO_CLASS_BE;
 		break;
 	case IOPRIO_CLASS_IDLE:
@@ -5583,7 +5620,7 @@ static struct bfq_queue *bfq_get_queue(struct bfq_data *bfqd,
 				       struct bfq_io_cq *bic,
 				       bool respawn)
 {
-	const int ioprio = IOPRIO_PRIO_DATA(bic->ioprio);
+	const int ioprio = IOPRIO_PRIO_LEVEL(bic->ioprio);
 	const int ioprio_class = IOPRIO_PRIO_CLASS(bic->ioprio);
 	struct bfq_queue **async_bfqq = NULL;
 	struct bfq_queue *bfqq;
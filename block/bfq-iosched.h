@@ -796,6 +796,7 @@ enum bfqq_state_flags {
 				 */
 	BFQQF_coop,		/* bfqq is shared */
 	BFQQF_split_coop,	/* shared bfqq will be split */
+	BFQQF_interactive,	/* carries I/O of the interactive hint */
 };
 
 #define BFQ_BFQQ_FNS(name)						\
@@ -815,6 +816,7 @@ BFQ_BFQQ_FNS(in_large_burst);
 BFQ_BFQQ_FNS(coop);
 BFQ_BFQQ_FNS(split_coop);
 BFQ_BFQQ_FNS(softrt_update);
+BFQ_BFQQ_FNS(interactive);
 #undef BFQ_BFQQ_FNS
 
 /* Expiration reasons. */
@@ -838,6 +840,9 @@ struct bfqg_stats {
 	/* basic stats */
 	struct blkg_rwstat		bytes;
 	struct blkg_rwstat		ios;
+	/* time spent in the scheduler by interactive ios in ns, and their number */
+	struct blkg_rwstat		interactive_wait_time;
+	struct blkg_rwstat		interactive_ios;
 #ifdef CONFIG_BFQ_CGROUP_DEBUG
 	/* number of ios merged */
 	struct blkg_rwstat		merged;
@@ -986,6 +991,7 @@ void bfq_put_async_queues(struct bfq_data *bfqd, struct bfq_group *bfqg);
 /* ---------------- cgroups-support interface ---------------- */
 
 void bfqg_stats_update_legacy_io(struct request_queue *q, struct request *rq);
+void bfqg_stats_update_interactive(struct bfq_group *bfqg, struct request *rq);
 void bfqg_stats_update_io_add(struct bfq_group *bfqg, struct bfq_queue *bfqq,
 			      unsigned int op);
 void bfqg_stats_update_io_remove(struct bfq_group *bfqg, unsigned int op);
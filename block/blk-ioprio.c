@@ -27,6 +27,9 @@
  * @POLICY_RESTRICT_TO_BE: modify IOPRIO_CLASS_NONE and IOPRIO_CLASS_RT into
  *		IOPRIO_CLASS_BE.
  * @POLICY_ALL_TO_IDLE: change the I/O priority class into IOPRIO_CLASS_IDLE.
+ * @POLICY_INTERACTIVE: keep the I/O priority class and add
+ *		IOPRIO_HINT_INTERACTIVE, for the cgroup of a foreground
+ *		application.
  *
  * See also <linux/ioprio.h>.
  */
@@ -35,6 +38,7 @@ enum prio_policy {
 	POLICY_NONE_TO_RT	= 1,
 	POLICY_RESTRICT_TO_BE	= 2,
 	POLICY_ALL_TO_IDLE	= 3,
+	POLICY_INTERACTIVE	= 4,
 };
 
 static const char *policy_name[] = {
@@ -42,6 +46,7 @@ static const char *policy_name[] = {
 	[POLICY_NONE_TO_RT]	= "none-to-rt",
 	[POLICY_RESTRICT_TO_BE]	= "restrict-to-be",
 	[POLICY_ALL_TO_IDLE]	= "idle",
+	[POLICY_INTERACTIVE]	= "interactive",
 };
 
 static struct blkcg_policy ioprio_policy;
@@ -191,6 +196,14 @@ static void blkcg_ioprio_track(struct rq_qos *rqos, struct request *rq,
 {
 	struct ioprio_blkcg *blkcg = ioprio_blkcg_from_bio(bio);
 
+	if (blkcg->prio_policy == POLICY_INTERACTIVE) {
+		/* an idle class bio stays idle, see ioprio_check_cap() */
+		if (IOPRIO_PRIO_CLASS(bio->bi_ioprio) != IOPRIO_CLASS_IDLE)
+			bio->bi_ioprio |= IOPRIO_PRIO_VALUE_HINT(IOPRIO_CLASS_NONE,
+					0, IOPRIO_HINT_INTERACTIVE);
+		return;
+	}
+
 	/*
 	 * Except for IOPRIO_CLASS_NONE, higher I/O priority numbers
 	 * correspond to a lower priority. Hence, the max_t() below selects
@@ -65,7 +65,22 @@ EXPORT_SYMBOL_GPL(set_task_ioprio);
 int ioprio_check_cap(int ioprio)
 {
 	int class = IOPRIO_PRIO_CLASS(ioprio);
-	int data = IOPRIO_PRIO_DATA(ioprio);
+	int data = IOPRIO_PRIO_LEVEL(ioprio);
+	int hint = IOPRIO_PRIO_HINT(ioprio);
+
+	switch (hint) {
+	case IOPRIO_HINT_NONE:
+		break;
+	case IOPRIO_HINT_INTERACTIVE:
+		/* served ahead of everyone else, like RT */
+		if (class == IOPRIO_CLASS_IDLE)
+			return -EINVAL;
+		if (!capable(CAP_SYS_NICE) && !capable(CAP_SYS_ADMIN))
+			return -EPERM;
+		break;
+	default:
+		return -EINVAL;
+	}
 
 	switch (class) {
 		case IOPRIO_CLASS_RT:
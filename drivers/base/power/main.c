@@ -64,6 +64,7 @@ static LIST_HEAD(dpm_noirq_list);
 struct suspend_stats suspend_stats;
 static DEFINE_MUTEX(dpm_list_mtx);
 static pm_message_t pm_transition;
+static ktime_t dpm_resume_start;
 
 static int async_error;
 
@@ -678,6 +679,24 @@ static bool dpm_async_fn(struct device *dev, async_func_t func)
 	return false;
 }
 
+/*
+ * Advance the async threads of a resume phase upfront, those of the devices
+ * with a resume priority first, in case the starting of async threads is
+ * delayed by non-async resuming devices.
+ */
+static void dpm_async_resume_list(struct list_head *list, async_func_t func)
+{
+	struct device *dev;
+
+	list_for_each_entry(dev, list, power.entry)
+		if (dev->power.resume_priority)
+			dpm_async_fn(dev, func);
+
+	list_for_each_entry(dev, list, power.entry)
+		if (!dev->power.resume_priority)
+			dpm_async_fn(dev, func);
+}
+
 static void async_resume_noirq(void *data, async_cookie_t cookie)
 {
 	struct device *dev = (struct device *)data;
@@ -699,13 +718,7 @@ static void dpm_noirq_resume_devices(pm_message_t state)
 	mutex_lock(&dpm_list_mtx);
 	pm_transition = state;
 
-	/*
-	 * Advanced the async threads upfront,
-	 * in case the starting of async threads is
-	 * delayed by non-async resuming devices.
-	 */
-	list_for_each_entry(dev, &dpm_noirq_list, power.entry)
-		dpm_async_fn(dev, async_resume_noirq);
+	dpm_async_resume_list(&dpm_noirq_list, async_resume_noirq);
 
 	while (!list_empty(&dpm_noirq_list)) {
 		dev = to_device(dpm_noirq_list.next);
@@ -840,13 +853,7 @@ void dpm_resume_early(pm_message_t state)
 	mutex_lock(&dpm_list_mtx);
 	pm_transition = state;
 
-	/*
-	 * Advanced the async threads upfront,
-	 * in case the starting of async threads is
-	 * delayed by non-async resuming devices.
-	 */
-	list_for_each_entry(dev, &dpm_late_early_list, power.entry)
-		dpm_async_fn(dev, async_resume_early);
+	dpm_async_resume_list(&dpm_late_early_list, async_resume_early);
 
 	while (!list_empty(&dpm_late_early_list)) {
 		dev = to_device(dpm_late_early_list.next);
@@ -895,6 +902,7 @@ static int device_resume(struct device *dev, pm_message_t state, bool async)
 {
 	pm_callback_t callback = NULL;
 	const char *info = NULL;
+	ktime_t starttime = 0;
 	int error = 0;
 	DECLARE_DPM_WATCHDOG_ON_STACK(wd);
 
@@ -913,6 +921,7 @@ static int device_resume(struct device *dev, pm_message_t state, bool async)
 	if (!dpm_wait_for_superior(dev, async))
 		goto Complete;
 
+	starttime = ktime_get();
 	dpm_watchdog_set(&wd, dev);
 	device_lock(dev);
 
@@ -971,6 +980,14 @@ static int device_resume(struct device *dev, pm_message_t state, bool async)
  Complete:
 	complete_all(&dev->power.completion);
 
+	if (starttime) {
+		ktime_t now = ktime_get();
+
+		trace_device_pm_resumed(dev,
+				ktime_us_delta(now, dpm_resume_start),
+				ktime_us_delta(now, starttime), async);
+	}
+
 	TRACE_RESUME(error);
 
 	return error;
@@ -1005,9 +1022,9 @@ void dpm_resume(pm_message_t state)
 	mutex_lock(&dpm_list_mtx);
 	pm_transition = state;
 	async_error = 0;
+	dpm_resume_start = starttime;
 
-	list_for_each_entry(dev, &dpm_suspended_list, power.entry)
-		dpm_async_fn(dev, async_resume);
+	dpm_async_resume_list(&dpm_suspended_list, async_resume);
 
 	while (!list_empty(&dpm_suspended_list)) {
 		dev = to_device(dpm_suspended_list.next);
@@ -1940,6 +1957,27 @@ void __suspend_report_result(const char *function, void *fn, int ret)
 }
 EXPORT_SYMBOL_GPL(__suspend_report_result);
 
+/**
+ * device_set_resume_priority - Resume a device ahead of the others.
+ * @dev: Device to handle.
+ *
+ * Make @dev resume asynchronously, and start its async thread before those
+ * of the other devices in every resume phase. For the devices the user is
+ * likely to touch first after a wakeup, such as input devices. The device
+ * still waits for its parent and suppliers, which are left as they are.
+ * The priority lasts for the lifetime of the device.
+ */
+void device_set_resume_priority(struct device *dev)
+{
+	mutex_lock(&dpm_list_mtx);
+	if (!dev->power.is_prepared) {
+		dev->power.resume_priority = true;
+		dev->power.async_suspend = true;
+	}
+	mutex_unlock(&dpm_list_mtx);
+}
+EXPORT_SYMBOL_GPL(device_set_resume_priority);
+
 /**
  * device_pm_wait_for_dev - Wait for suspend/resume of a device to complete.
  * @subordinate: Device that needs to wait for @dev.
@@ -53,6 +53,8 @@ struct hlwd_gpio {
 	int irq;
 	u32 edge_emulation;
 	u32 rising_edge, falling_edge;
+	u32 intmask;	/* copy of HW_GPIOB_INTMASK */
+	u32 wakeup;
 };
 
 static void hlwd_gpio_irqhandler(struct irq_desc *desc)
@@ -67,7 +69,7 @@ static void hlwd_gpio_irqhandler(struct irq_desc *desc)
 
 	spin_lock_irqsave(&hlwd->gpioc.bgpio_lock, flags);
 	pending = ioread32be(hlwd->regs + HW_GPIOB_INTFLAG);
-	pending &= ioread32be(hlwd->regs + HW_GPIOB_INTMASK);
+	pending &= hlwd->intmask;
 
 	/* Treat interrupts due to edge trigger emulation separately */
 	emulated_pending = hlwd->edge_emulation & pending;
@@ -116,12 +118,10 @@ static void hlwd_gpio_irq_mask(struct irq_data *data)
 	struct hlwd_gpio *hlwd =
 		gpiochip_get_data(irq_data_get_irq_chip_data(data));
 	unsigned long flags;
-	u32 mask;
 
 	spin_lock_irqsave(&hlwd->gpioc.bgpio_lock, flags);
-	mask = ioread32be(hlwd->regs + HW_GPIOB_INTMASK);
-	mask &= ~BIT(data->hwirq);
-	iowrite32be(mask, hlwd->regs + HW_GPIOB_INTMASK);
+	hlwd->intmask &= ~BIT(data->hwirq);
+	iowrite32be(hlwd->intmask, hlwd->regs + HW_GPIOB_INTMASK);
 	spin_unlock_irqrestore(&hlwd->gpioc.bgpio_lock, flags);
 }
 
@@ -130,12 +130,10 @@ static void hlwd_gpio_irq_unmask(struct irq_data *data)
 	struct hlwd_gpio *hlwd =
 		gpiochip_get_data(irq_data_get_irq_chip_data(data));
 	unsigned long flags;
-	u32 mask;
 
 	spin_lock_irqsave(&hlwd->gpioc.bgpio_lock, flags);
-	mask = ioread32be(hlwd->regs + HW_GPIOB_INTMASK);
-	mask |= BIT(data->hwirq);
-	iowrite32be(mask, hlwd->regs + HW_GPIOB_INTMASK);
+	hlwd->intmask |= BIT(data->hwirq);
+	iowrite32be(hlwd->intmask, hlwd->regs + HW_GPIOB_INTMASK);
 	spin_unlock_irqrestore(&hlwd->gpioc.bgpio_lock, flags);
 }
 
@@ -145,6 +143,31 @@ static void hlwd_gpio_irq_enable(struct irq_data *data)
 	hlwd_gpio_irq_unmask(data);
 }
 
+/*
+ * Wakeup lines stay unmasked across suspend (IRQCHIP_MASK_ON_SUSPEND takes
+ * care of the others); the parent interrupt has to stay enabled as long
+ * as any line is a wakeup source.
+ */
+static int hlwd_gpio_irq_set_wake(struct irq_data *data, unsigned int on)
+{
+	struct hlwd_gpio *hlwd =
+		gpiochip_get_data(irq_data_get_irq_chip_data(data));
+	u32 wakeup = hlwd->wakeup;
+	int ret = 0;
+
+	if (on)
+		wakeup |= BIT(data->hwirq);
+	else
+		wakeup &= ~BIT(data->hwirq);
+
+	if (!wakeup != !hlwd->wakeup)
+		ret = irq_set_irq_wake(hlwd->irq, !!wakeup);
+	if (!ret)
+		hlwd->wakeup = wakeup;
+
+	return ret;
+}
+
 static void hlwd_gpio_irq_setup_emulation(struct hlwd_gpio *hlwd, int hwirq,
 					  unsigned int flow_type)
 {
@@ -242,6 +265,7 @@ static int hlwd_gpio_probe(struct platform_device *pdev)
 	hlwd->gpioc.ngpio = ngpios;
 
 	/* Mask and ack all interrupts */
+	hlwd->intmask = 0;
 	iowrite32be(0, hlwd->regs + HW_GPIOB_INTMASK);
 	iowrite32be(0xffffffff, hlwd->regs + HW_GPIOB_INTFLAG);
 
@@ -264,6 +288,8 @@ static int hlwd_gpio_probe(struct platform_device *pdev)
 		hlwd->irqc.irq_unmask = hlwd_gpio_irq_unmask;
 		hlwd->irqc.irq_enable = hlwd_gpio_irq_enable;
 		hlwd->irqc.irq_set_type = hlwd_gpio_irq_set_type;
+		hlwd->irqc.irq_set_wake = hlwd_gpio_irq_set_wake;
+		hlwd->irqc.flags = IRQCHIP_MASK_ON_SUSPEND;
 
 		girq = &hlwd->gpioc.irq;
 		girq->chip = &hlwd->irqc;
@@ -44,6 +44,7 @@
 
 #include "drm_crtc_helper_internal.h"
 #include "drm_crtc_internal.h"
+#include "drm_trace.h"
 
 /**
  * DOC: overview
@@ -1657,9 +1658,13 @@ static void commit_tail(struct drm_atomic_state *old_state)
 	 * drm_atomic_helper_commit_hw_done() so figure out which crtc's have
 	 * self-refresh active beforehand:
 	 */
-	for_each_new_crtc_in_state(old_state, crtc, new_crtc_state, i)
+	for_each_new_crtc_in_state(old_state, crtc, new_crtc_state, i) {
 		if (new_crtc_state->self_refresh_active)
 			new_self_refresh_mask |= BIT(i);
+		if (new_crtc_state->commit)
+			trace_drm_atomic_commit_tail(new_crtc_state->commit,
+						     drm_crtc_index(crtc));
+	}
 
 	if (funcs && funcs->atomic_commit_tail)
 		funcs->atomic_commit_tail(old_state);
@@ -2103,6 +2108,8 @@ int drm_atomic_helper_setup_commit(struct drm_atomic_state *state,
 		init_commit(commit, crtc);
 
 		new_crtc_state->commit = commit;
+		trace_drm_atomic_commit_setup(commit, drm_crtc_index(crtc),
+					      nonblock);
 
 		ret = stall_checks(crtc, nonblock);
 		if (ret)
@@ -2318,6 +2325,7 @@ void drm_atomic_helper_commit_hw_done(struct drm_atomic_state *old_state)
 
 		/* backend must have consumed any event by now */
 		WARN_ON(new_crtc_state->event);
+		trace_drm_atomic_commit_hw_done(commit, drm_crtc_index(crtc));
 		complete_all(&commit->hw_done);
 	}
 
@@ -12,6 +12,8 @@
 #include <linux/slab.h>
 #include <linux/io.h>
 
+#include <asm/unaligned.h>
+
 #include <drm/drm_format_helper.h>
 #include <drm/drm_framebuffer.h>
 #include <drm/drm_fourcc.h>
@@ -23,6 +25,47 @@ static unsigned int clip_offset(struct drm_rect *clip,
 	return clip->y1 * pitch + clip->x1 * cpp;
 }
 
+/* Two 16-bit pixels in one 32-bit word, in memory order */
+static inline u32 pack_u16_pair(u16 first, u16 second)
+{
+#ifdef __LITTLE_ENDIAN
+	return first | (u32)second << 16;
+#else
+	return (u32)first << 16 | second;
+#endif
+}
+
+static void drm_fb_swab16_line(u16 *dbuf, const u16 *sbuf,
+			       unsigned int pixels)
+{
+	unsigned int x = 0;
+
+	/* swap the bytes of two pixels at once when both buffers allow it */
+	if (IS_ALIGNED((unsigned long)dbuf | (unsigned long)sbuf, 4)) {
+		const u32 *s32 = (const u32 *)sbuf;
+		u32 *d32 = (u32 *)dbuf;
+
+		for (; x + 1 < pixels; x += 2) {
+			u32 val = *s32++;
+
+			*d32++ = ((val & 0x00ff00ff) << 8) |
+				 ((val & 0xff00ff00) >> 8);
+		}
+	}
+
+	for (; x < pixels; x++)
+		dbuf[x] = swab16(sbuf[x]);
+}
+
+static void drm_fb_swab32_line(u32 *dbuf, const u32 *sbuf,
+			       unsigned int pixels)
+{
+	unsigned int x;
+
+	for (x = 0; x < pixels; x++)
+		dbuf[x] = swab32(sbuf[x]);
+}
+
 /**
  * drm_fb_memcpy - Copy clip buffer
  * @dst: Destination buffer
@@ -97,11 +140,11 @@ void drm_fb_swab(void *dst, void *src, struct drm_framebuffer *fb,
 		 struct drm_rect *clip, bool cached)
 {
 	u8 cpp = fb->format->cpp[0];
-	size_t len = drm_rect_width(clip) * cpp;
-	u16 *src16, *dst16 = dst;
-	u32 *src32, *dst32 = dst;
-	unsigned int x, y;
+	unsigned int pixels = drm_rect_width(clip);
+	size_t len = pixels * cpp;
+	unsigned int y;
 	void *buf = NULL;
+	void *line;
 
 	if (WARN_ON_ONCE(cpp != 2 && cpp != 4))
 		return;
@@ -114,43 +157,54 @@ void drm_fb_swab(void *dst, void *src, struct drm_framebuffer *fb,
 	for (y = clip->y1; y < clip->y2; y++) {
 		if (buf) {
 			memcpy(buf, src, len);
-			src16 = buf;
-			src32 = buf;
+			line = buf;
 		} else {
-			src16 = src;
-			src32 = src;
+			line = src;
 		}
 
-		for (x = clip->x1; x < clip->x2; x++) {
-			if (cpp == 4)
-				*dst32++ = swab32(*src32++);
-			else
-				*dst16++ = swab16(*src16++);
-		}
+		if (cpp == 4)
+			drm_fb_swab32_line(dst, line, pixels);
+		else
+			drm_fb_swab16_line(dst, line, pixels);
 
 		src += fb->pitches[0];
+		dst += len;
 	}
 
 	kfree(buf);
 }
 EXPORT_SYMBOL(drm_fb_swab);
 
+static inline u16 xrgb8888_to_rgb565(u32 pix, bool swab)
+{
+	u16 val16 = ((pix & 0x00F80000) >> 8) |
+		    ((pix & 0x0000FC00) >> 5) |
+		    ((pix & 0x000000F8) >> 3);
+
+	return swab ? swab16(val16) : val16;
+}
+
 static void drm_fb_xrgb8888_to_rgb565_line(u16 *dbuf, u32 *sbuf,
 					   unsigned int pixels,
 					   bool swab)
 {
-	unsigned int x;
-	u16 val16;
-
-	for (x = 0; x < pixels; x++) {
-		val16 = ((sbuf[x] & 0x00F80000) >> 8) |
-			((sbuf[x] & 0x0000FC00) >> 5) |
-			((sbuf[x] & 0x000000F8) >> 3);
-		if (swab)
-			dbuf[x] = swab16(val16);
-		else
-			dbuf[x] = val16;
+	unsigned int x = 0;
+	u32 *dbuf32;
+
+	/* one 16-bit store to word align the destination, if needed */
+	if (pixels && !IS_ALIGNED((unsigned long)dbuf, 4)) {
+		dbuf[0] = xrgb8888_to_rgb565(sbuf[0], swab);
+		x = 1;
 	}
+
+	/* then two pixels per 32-bit store */
+	dbuf32 = (u32 *)(dbuf + x);
+	for (; x + 1 < pixels; x += 2)
+		*dbuf32++ = pack_u16_pair(xrgb8888_to_rgb565(sbuf[x], swab),
+					  xrgb8888_to_rgb565(sbuf[x + 1], swab));
+
+	if (x < pixels)
+		dbuf[x] = xrgb8888_to_rgb565(sbuf[x], swab);
 }
 
 /**
@@ -241,9 +295,22 @@ EXPORT_SYMBOL(drm_fb_xrgb8888_to_rgb565_dstclip);
 static void drm_fb_xrgb8888_to_rgb888_line(u8 *dbuf, u32 *sbuf,
 					   unsigned int pixels)
 {
-	unsigned int x;
+	unsigned int x = 0;
+
+	/* four pixels make three 32-bit words: BGRB GRBG RBGR */
+	for (; x + 3 < pixels; x += 4) {
+		u32 p0 = sbuf[x], p1 = sbuf[x + 1];
+		u32 p2 = sbuf[x + 2], p3 = sbuf[x + 3];
+
+		put_unaligned_le32((p0 & 0x00FFFFFF) | (p1 << 24), dbuf);
+		put_unaligned_le32(((p1 >> 8) & 0x0000FFFF) | (p2 << 16),
+				   dbuf + 4);
+		put_unaligned_le32(((p2 >> 16) & 0x000000FF) | (p3 << 8),
+				   dbuf + 8);
+		dbuf += 12;
+	}
 
-	for (x = 0; x < pixels; x++) {
+	for (; x < pixels; x++) {
 		*dbuf++ = (sbuf[x] & 0x000000FF) >>  0;
 		*dbuf++ = (sbuf[x] & 0x0000FF00) >>  8;
 		*dbuf++ = (sbuf[x] & 0x00FF0000) >> 16;
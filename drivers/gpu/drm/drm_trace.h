@@ -6,6 +6,7 @@
 #include <linux/types.h>
 #include <linux/tracepoint.h>
 
+struct drm_crtc_commit;
 struct drm_file;
 
 #undef TRACE_SYSTEM
@@ -66,6 +67,59 @@ TRACE_EVENT(drm_vblank_event_delivered,
 		      __entry->seq)
 );
 
+/*
+ * Stages of an atomic commit on one CRTC, keyed by the commit so the
+ * latency between them can be measured with hist triggers, e.g.
+ * drm_atomic_commit_setup to drm_atomic_commit_flip_done per crtc.
+ */
+DECLARE_EVENT_CLASS(drm_atomic_commit_stage,
+	    TP_PROTO(const struct drm_crtc_commit *commit, unsigned int crtc),
+	    TP_ARGS(commit, crtc),
+	    TP_STRUCT__entry(
+		    __field(const struct drm_crtc_commit *, commit)
+		    __field(unsigned int, crtc)
+		    ),
+	    TP_fast_assign(
+		    __entry->commit = commit;
+		    __entry->crtc = crtc;
+		    ),
+	    TP_printk("commit=%p, crtc=%u", __entry->commit, __entry->crtc)
+);
+
+TRACE_EVENT(drm_atomic_commit_setup,
+	    TP_PROTO(const struct drm_crtc_commit *commit, unsigned int crtc,
+		     bool nonblock),
+	    TP_ARGS(commit, crtc, nonblock),
+	    TP_STRUCT__entry(
+		    __field(const struct drm_crtc_commit *, commit)
+		    __field(unsigned int, crtc)
+		    __field(bool, nonblock)
+		    ),
+	    TP_fast_assign(
+		    __entry->commit = commit;
+		    __entry->crtc = crtc;
+		    __entry->nonblock = nonblock;
+		    ),
+	    TP_printk("commit=%p, crtc=%u, nonblock=%s", __entry->commit,
+		      __entry->crtc, __entry->nonblock ? "true" : "false")
+);
+
+/* fences and preceding commits waited for, the driver starts programming */
+DEFINE_EVENT(drm_atomic_commit_stage, drm_atomic_commit_tail,
+	    TP_PROTO(const struct drm_crtc_commit *commit, unsigned int crtc),
+	    TP_ARGS(commit, crtc)
+);
+
+DEFINE_EVENT(drm_atomic_commit_stage, drm_atomic_commit_hw_done,
+	    TP_PROTO(const struct drm_crtc_commit *commit, unsigned int crtc),
+	    TP_ARGS(commit, crtc)
+);
+
+DEFINE_EVENT(drm_atomic_commit_stage, drm_atomic_commit_flip_done,
+	    TP_PROTO(const struct drm_crtc_commit *commit, unsigned int crtc),
+	    TP_ARGS(commit, crtc)
+);
+
 #endif /* _DRM_TRACE_H_ */
 
 /* This part must be outside protection */
@@ -3,3 +3,8 @@
 
 #define CREATE_TRACE_POINTS
 #include "drm_trace.h"
+
+/* fired from the atomic helpers in drm_kms_helper */
+EXPORT_TRACEPOINT_SYMBOL_GPL(drm_atomic_commit_setup);
+EXPORT_TRACEPOINT_SYMBOL_GPL(drm_atomic_commit_tail);
+EXPORT_TRACEPOINT_SYMBOL_GPL(drm_atomic_commit_hw_done);
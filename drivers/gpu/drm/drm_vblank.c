@@ -28,6 +28,7 @@
 #include <linux/kthread.h>
 #include <linux/moduleparam.h>
 
+#include <drm/drm_atomic.h>
 #include <drm/drm_crtc.h>
 #include <drm/drm_drv.h>
 #include <drm/drm_framebuffer.h>
@@ -1006,6 +1007,12 @@ static void send_vblank_event(struct drm_device *dev,
 		break;
 	}
 	trace_drm_vblank_event_delivered(e->base.file_priv, e->pipe, seq);
+	/* only the atomic helpers hook a completion, the commit's flip_done */
+	if (e->base.completion)
+		trace_drm_atomic_commit_flip_done(container_of(e->base.completion,
+							       struct drm_crtc_commit,
+							       flip_done),
+						  e->pipe);
 	/*
 	 * Use the same timestamp for any associated fence signal to avoid
 	 * mismatch in timestamps for vsync & fence events triggered by the
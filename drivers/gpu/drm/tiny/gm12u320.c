@@ -88,6 +88,8 @@ struct gm12u320_device {
 	struct drm_connector	         conn;
 	unsigned char                   *cmd_buf;
 	unsigned char                   *data_buf[GM12U320_BLOCK_COUNT];
+	struct urb                      *data_urb;
+	struct completion                data_done;
 	struct {
 		struct delayed_work       work;
 		struct mutex             lock;
@@ -161,15 +163,31 @@ static inline struct usb_device *gm12u320_to_usb_device(struct gm12u320_device *
 	return interface_to_usbdev(to_usb_interface(gm12u320->dev.dev));
 }
 
+static void gm12u320_usb_free_urb(struct drm_device *dev, void *urb)
+{
+	usb_free_urb(urb);
+}
+
 static int gm12u320_usb_alloc(struct gm12u320_device *gm12u320)
 {
-	int i, block_size;
+	int i, ret, block_size;
 	const char *hdr;
 
 	gm12u320->cmd_buf = drmm_kmalloc(&gm12u320->dev, CMD_SIZE, GFP_KERNEL);
 	if (!gm12u320->cmd_buf)
 		return -ENOMEM;
 
+	gm12u320->data_urb = usb_alloc_urb(0, GFP_KERNEL);
+	if (!gm12u320->data_urb)
+		return -ENOMEM;
+
+	ret = drmm_add_action_or_reset(&gm12u320->dev, gm12u320_usb_free_urb,
+				       gm12u320->data_urb);
+	if (ret)
+		return ret;
+
+	init_completion(&gm12u320->data_done);
+
 	for (i = 0; i < GM12U320_BLOCK_COUNT; i++) {
 		if (i == GM12U320_BLOCK_COUNT - 1) {
 			block_size = DATA_LAST_BLOCK_SIZE;
@@ -248,71 +266,103 @@ static void gm12u320_32bpp_to_24bpp_packed(u8 *dst, u8 *src, int len)
 	}
 }
 
-static void gm12u320_copy_fb_to_blocks(struct gm12u320_device *gm12u320)
+/*
+ * Converts the part of @rect of @fb that lands in @block. Blocks are
+ * converted one at a time while the previous one is on the wire, so @fb
+ * may have been replaced by a newer framebuffer in the meantime, whose
+ * commit is about to unmap it. Returns false in that case (or on error),
+ * and the remaining blocks of this frame are not converted; the newer
+ * framebuffer has queued another update already.
+ */
+static bool gm12u320_copy_fb_to_block(struct gm12u320_device *gm12u320,
+				      struct drm_framebuffer *fb,
+				      const struct drm_rect *rect, int block)
 {
-	int block, dst_offset, len, remain, ret, x1, x2, y1, y2;
-	struct drm_framebuffer *fb;
+	const int row_len = GM12U320_REAL_WIDTH * 3;
+	const int x_off = (GM12U320_REAL_WIDTH - GM12U320_USER_WIDTH) / 2;
+	int block_start = block * DATA_BLOCK_CONTENT_SIZE;
+	int block_end = block_start + DATA_BLOCK_CONTENT_SIZE;
+	int start, end, row, y, y1, y2, ret;
+	bool valid = true;
 	void *vaddr;
 	u8 *src;
 
 	mutex_lock(&gm12u320->fb_update.lock);
 
-	if (!gm12u320->fb_update.fb)
+	if (gm12u320->fb_update.fb && gm12u320->fb_update.fb != fb) {
+		valid = false;
 		goto unlock;
+	}
 
-	fb = gm12u320->fb_update.fb;
-	x1 = gm12u320->fb_update.rect.x1;
-	x2 = gm12u320->fb_update.rect.x2;
-	y1 = gm12u320->fb_update.rect.y1;
-	y2 = gm12u320->fb_update.rect.y2;
 	vaddr = gm12u320->fb_update.src_map.vaddr; /* TODO: Use mapping abstraction properly */
 
 	ret = drm_gem_fb_begin_cpu_access(fb, DMA_FROM_DEVICE);
 	if (ret) {
 		GM12U320_ERR("drm_gem_fb_begin_cpu_access err: %d\n", ret);
-		goto put_fb;
+		valid = false;
+		goto unlock;
+	}
+
+	y1 = max(rect->y1, block_start / row_len);
+	y2 = min(rect->y2, DIV_ROUND_UP(block_end, row_len));
+
+	for (y = y1; y < y2; y++) {
+		row = y * row_len;
+		start = max(row + (rect->x1 + x_off) * 3, block_start);
+		end = min(row + (rect->x2 + x_off) * 3, block_end);
+		if (start >= end)
+			continue;
+
+		/* block boundaries fall on pixels, the content size is 3 * n */
+		src = vaddr + y * fb->pitches[0] +
+		      ((start - row) / 3 - x_off) * 4;
+		gm12u320_32bpp_to_24bpp_packed(gm12u320->data_buf[block] +
+					       DATA_BLOCK_HEADER_SIZE +
+					       start - block_start,
+					       src, (end - start) / 3);
 	}
 
-	src = vaddr + y1 * fb->pitches[0] + x1 * 4;
+	drm_gem_fb_end_cpu_access(fb, DMA_FROM_DEVICE);
+unlock:
+	mutex_unlock(&gm12u320->fb_update.lock);
+	return valid;
+}
 
-	x1 += (GM12U320_REAL_WIDTH - GM12U320_USER_WIDTH) / 2;
-	x2 += (GM12U320_REAL_WIDTH - GM12U320_USER_WIDTH) / 2;
+static void gm12u320_data_complete(struct urb *urb)
+{
+	struct gm12u320_device *gm12u320 = urb->context;
 
-	for (; y1 < y2; y1++) {
-		remain = 0;
-		len = (x2 - x1) * 3;
-		dst_offset = (y1 * GM12U320_REAL_WIDTH + x1) * 3;
-		block = dst_offset / DATA_BLOCK_CONTENT_SIZE;
-		dst_offset %= DATA_BLOCK_CONTENT_SIZE;
+	complete(&gm12u320->data_done);
+}
 
-		if ((dst_offset + len) > DATA_BLOCK_CONTENT_SIZE) {
-			remain = dst_offset + len - DATA_BLOCK_CONTENT_SIZE;
-			len = DATA_BLOCK_CONTENT_SIZE - dst_offset;
-		}
+static int gm12u320_submit_block(struct gm12u320_device *gm12u320,
+				 int block, int block_size)
+{
+	struct usb_device *udev = gm12u320_to_usb_device(gm12u320);
 
-		dst_offset += DATA_BLOCK_HEADER_SIZE;
-		len /= 3;
+	reinit_completion(&gm12u320->data_done);
+	usb_fill_bulk_urb(gm12u320->data_urb, udev,
+			  usb_sndbulkpipe(udev, DATA_SND_EPT),
+			  gm12u320->data_buf[block], block_size,
+			  gm12u320_data_complete, gm12u320);
 
-		gm12u320_32bpp_to_24bpp_packed(
-			gm12u320->data_buf[block] + dst_offset,
-			src, len);
+	return usb_submit_urb(gm12u320->data_urb, GFP_KERNEL);
+}
 
-		if (remain) {
-			block++;
-			dst_offset = DATA_BLOCK_HEADER_SIZE;
-			gm12u320_32bpp_to_24bpp_packed(
-				gm12u320->data_buf[block] + dst_offset,
-				src + len * 4, remain / 3);
-		}
-		src += fb->pitches[0];
+static int gm12u320_wait_block(struct gm12u320_device *gm12u320,
+			       int block_size)
+{
+	struct urb *urb = gm12u320->data_urb;
+
+	if (!wait_for_completion_timeout(&gm12u320->data_done, DATA_TIMEOUT)) {
+		usb_kill_urb(urb);
+		return -ETIMEDOUT;
 	}
 
-	drm_gem_fb_end_cpu_access(fb, DMA_FROM_DEVICE);
-put_fb:
-	drm_framebuffer_put(fb);
-	gm12u320->fb_update.fb = NULL;
-unlock:
-	mutex_unlock(&gm12u320->fb_update.lock);
+	if (urb->status)
+		return urb->status;
+
+	return urb->actual_length == block_size ? 0 : -EIO;
 }
 
 static void gm12u320_fb_update_work(struct work_struct *work)
@@ -322,9 +372,19 @@ static void gm12u320_fb_update_work(struct work_struct *work)
 			     fb_update.work);
 	struct usb_device *udev = gm12u320_to_usb_device(gm12u320);
 	int block, block_size, len;
+	struct drm_framebuffer *fb;
+	struct drm_rect rect;
+	bool convert;
 	int ret = 0;
 
-	gm12u320_copy_fb_to_blocks(gm12u320);
+	/* Take over the pending update, a new one may be queued meanwhile */
+	mutex_lock(&gm12u320->fb_update.lock);
+	fb = gm12u320->fb_update.fb;
+	rect = gm12u320->fb_update.rect;
+	gm12u320->fb_update.fb = NULL;
+	mutex_unlock(&gm12u320->fb_update.lock);
+
+	convert = fb && gm12u320_copy_fb_to_block(gm12u320, fb, &rect, 0);
 
 	for (block = 0; block < GM12U320_BLOCK_COUNT; block++) {
 		if (block == GM12U320_BLOCK_COUNT - 1)
@@ -347,12 +407,17 @@ static void gm12u320_fb_update_work(struct work_struct *work)
 		if (ret || len != CMD_SIZE)
 			goto err;
 
-		/* Send data block to device */
-		ret = usb_bulk_msg(udev,
-				   usb_sndbulkpipe(udev, DATA_SND_EPT),
-				   gm12u320->data_buf[block], block_size,
-				   &len, DATA_TIMEOUT);
-		if (ret || len != block_size)
+		/* Send data block to device, converting the next one meanwhile */
+		ret = gm12u320_submit_block(gm12u320, block, block_size);
+		if (ret)
+			goto err;
+
+		if (convert && block + 1 < GM12U320_BLOCK_COUNT)
+			convert = gm12u320_copy_fb_to_block(gm12u320, fb, &rect,
+							    block + 1);
+
+		ret = gm12u320_wait_block(gm12u320, block_size);
+		if (ret)
 			goto err;
 
 		/* Read status */
@@ -388,11 +453,14 @@ static void gm12u320_fb_update_work(struct work_struct *work)
 	queue_delayed_work(system_long_wq, &gm12u320->fb_update.work,
 			   IDLE_TIMEOUT);
 
-	return;
+	goto put_fb;
 err:
 	/* Do not log errors caused by module unload or device unplug */
 	if (ret != -ENODEV && ret != -ECONNRESET && ret != -ESHUTDOWN)
 		GM12U320_ERR("Frame update error: %d\n", ret);
+put_fb:
+	if (fb)
+		drm_framebuffer_put(fb);
 }
 
 static void gm12u320_fb_mark_dirty(struct drm_framebuffer *fb, const struct dma_buf_map *map,
@@ -62,6 +62,12 @@ struct udl_device {
 
 	char mode_buf[1024];
 	uint32_t mode_buf_len;
+
+	/* copy of what has been sent to the device, in framebuffer format */
+	u8 *back;
+	size_t back_pitch;
+	unsigned int back_width, back_height, back_cpp;
+	bool back_valid;
 };
 
 #define to_udl(x) container_of(x, struct udl_device, drm)
@@ -83,7 +89,7 @@ void udl_urb_completion(struct urb *urb);
 int udl_init(struct udl_device *udl);
 
 int udl_render_hline(struct drm_device *dev, int log_bpp, struct urb **urb_ptr,
-		     const char *front, char **urb_buf_ptr,
+		     const char *front, u8 *back, char **urb_buf_ptr,
 		     u32 byte_offset, u32 device_byte_offset, u32 byte_width);
 
 int udl_drop_usb(struct drm_device *dev);
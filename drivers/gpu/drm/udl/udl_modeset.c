@@ -8,6 +8,9 @@
  * Copyright (C) 2009 Bernie Thompson <bernie@plugable.com>
  */
 
+#include <linux/mm.h>
+#include <linux/moduleparam.h>
+
 #include <drm/drm_atomic_helper.h>
 #include <drm/drm_crtc_helper.h>
 #include <drm/drm_damage_helper.h>
@@ -15,6 +18,7 @@
 #include <drm/drm_gem_atomic_helper.h>
 #include <drm/drm_gem_framebuffer_helper.h>
 #include <drm/drm_gem_shmem_helper.h>
+#include <drm/drm_managed.h>
 #include <drm/drm_modeset_helper_vtables.h>
 #include <drm/drm_vblank.h>
 
@@ -264,11 +268,58 @@ static int udl_aligned_damage_clip(struct drm_rect *clip, int x, int y,
 	return 0;
 }
 
+static bool backbuffer = true;
+module_param(backbuffer, bool, 0644);
+MODULE_PARM_DESC(backbuffer, "Keep a copy of the device framebuffer to skip unchanged pixels (default: true)");
+
+/*
+ * The back buffer trades a copy of each sent line for not sending the
+ * unchanged pixels at both ends of it, which is most of a damage clip
+ * for blinking cursors or clients that damage more than they draw.
+ */
+static void udl_back_alloc(struct udl_device *udl, struct drm_framebuffer *fb)
+{
+	unsigned int cpp = fb->format->cpp[0];
+	size_t pitch = ALIGN(fb->width * cpp, sizeof(unsigned long));
+
+	udl->back_valid = false;
+
+	if (udl->back && udl->back_width == fb->width &&
+	    udl->back_height == fb->height && udl->back_cpp == cpp)
+		return;
+
+	kvfree(udl->back);
+	udl->back = NULL;
+	if (!backbuffer)
+		return;
+
+	udl->back = kvmalloc(pitch * fb->height, GFP_KERNEL);
+	if (!udl->back)
+		return;
+	udl->back_pitch = pitch;
+	udl->back_width = fb->width;
+	udl->back_height = fb->height;
+	udl->back_cpp = cpp;
+}
+
+static void udl_back_release(struct drm_device *dev, void *res)
+{
+	struct udl_device *udl = to_udl(dev);
+
+	kvfree(udl->back);
+}
+
+/*
+ * Compresses the clip straight from the framebuffer mapping into URBs.
+ * The caller brackets the calls with drm_gem_fb_{begin,end}_cpu_access().
+ */
 static int udl_handle_damage(struct drm_framebuffer *fb, const struct dma_buf_map *map,
 			     int x, int y, int width, int height)
 {
 	struct drm_device *dev = fb->dev;
+	struct udl_device *udl = to_udl(dev);
 	void *vaddr = map->vaddr; /* TODO: Use mapping abstraction properly */
+	bool use_back;
 	int i, ret;
 	char *cmd;
 	struct urb *urb;
@@ -286,15 +337,17 @@ static int udl_handle_damage(struct drm_framebuffer *fb, const struct dma_buf_ma
 	else if ((clip.x2 > fb->width) || (clip.y2 > fb->height))
 		return -EINVAL;
 
-	ret = drm_gem_fb_begin_cpu_access(fb, DMA_FROM_DEVICE);
-	if (ret)
-		return ret;
+	/* udl_trim_hline() compares whole longs */
+	use_back = udl->back && udl->back_width == fb->width &&
+		   udl->back_height == fb->height &&
+		   udl->back_cpp == fb->format->cpp[0] &&
+		   IS_ALIGNED(fb->pitches[0], sizeof(unsigned long));
+	if (!use_back)
+		udl->back_valid = false;
 
 	urb = udl_get_urb(dev);
-	if (!urb) {
-		ret = -ENOMEM;
-		goto out_drm_gem_fb_end_cpu_access;
-	}
+	if (!urb)
+		return -ENOMEM;
 	cmd = urb->transfer_buffer;
 
 	for (i = clip.y1; i < clip.y2; i++) {
@@ -302,11 +355,16 @@ static int udl_handle_damage(struct drm_framebuffer *fb, const struct dma_buf_ma
 		const int byte_offset = line_offset + (clip.x1 << log_bpp);
 		const int dev_byte_offset = (fb->width * i + clip.x1) << log_bpp;
 		const int byte_width = (clip.x2 - clip.x1) << log_bpp;
-		ret = udl_render_hline(dev, log_bpp, &urb, (char *)vaddr,
+		u8 *back = NULL;
+
+		if (use_back)
+			back = udl->back + udl->back_pitch * i +
+			       (clip.x1 << log_bpp);
+		ret = udl_render_hline(dev, log_bpp, &urb, (char *)vaddr, back,
 				       &cmd, byte_offset, dev_byte_offset,
 				       byte_width);
 		if (ret)
-			goto out_drm_gem_fb_end_cpu_access;
+			return ret;
 	}
 
 	if (cmd > (char *)urb->transfer_buffer) {
@@ -320,11 +378,7 @@ static int udl_handle_damage(struct drm_framebuffer *fb, const struct dma_buf_ma
 		udl_urb_completion(urb);
 	}
 
-	ret = 0;
-
-out_drm_gem_fb_end_cpu_access:
-	drm_gem_fb_end_cpu_access(fb, DMA_FROM_DEVICE);
-	return ret;
+	return 0;
 }
 
 /*
@@ -379,7 +433,15 @@ udl_simple_display_pipe_enable(struct drm_simple_display_pipe *pipe,
 
 	udl->mode_buf_len = wrptr - buf;
 
-	udl_handle_damage(fb, &shadow_plane_state->data[0], 0, 0, fb->width, fb->height);
+	/* the device content is lost, fill the back buffer from scratch */
+	udl_back_alloc(udl, fb);
+
+	if (!drm_gem_fb_begin_cpu_access(fb, DMA_FROM_DEVICE)) {
+		if (!udl_handle_damage(fb, &shadow_plane_state->data[0], 0, 0,
+				       fb->width, fb->height) && udl->back)
+			udl->back_valid = true;
+		drm_gem_fb_end_cpu_access(fb, DMA_FROM_DEVICE);
+	}
 
 	if (!crtc_state->mode_changed)
 		return;
@@ -416,14 +478,33 @@ udl_simple_display_pipe_update(struct drm_simple_display_pipe *pipe,
 	struct drm_plane_state *state = pipe->plane.state;
 	struct drm_shadow_plane_state *shadow_plane_state = to_drm_shadow_plane_state(state);
 	struct drm_framebuffer *fb = state->fb;
+	struct udl_device *udl = to_udl(pipe->crtc.dev);
+	struct drm_atomic_helper_damage_iter iter;
 	struct drm_rect rect;
 
 	if (!fb)
 		return;
 
-	if (drm_atomic_helper_damage_merged(old_plane_state, state, &rect))
-		udl_handle_damage(fb, &shadow_plane_state->data[0], rect.x1, rect.y1,
-				  rect.x2 - rect.x1, rect.y2 - rect.y1);
+	if (drm_gem_fb_begin_cpu_access(fb, DMA_FROM_DEVICE))
+		return;
+
+	/*
+	 * Send the damage clips one by one rather than their bounding box,
+	 * which for a cursor and a clock update at opposite corners is most
+	 * of the screen.
+	 */
+	drm_atomic_helper_damage_iter_init(&iter, old_plane_state, state);
+	drm_atomic_for_each_plane_damage(&iter, &rect) {
+		if (udl_handle_damage(fb, &shadow_plane_state->data[0],
+				      rect.x1, rect.y1, rect.x2 - rect.x1,
+				      rect.y2 - rect.y1)) {
+			/* lines may be in the back buffer but not sent */
+			udl->back_valid = false;
+			break;
+		}
+	}
+
+	drm_gem_fb_end_cpu_access(fb, DMA_FROM_DEVICE);
 }
 
 static const struct drm_simple_display_pipe_funcs udl_simple_display_pipe_funcs = {
@@ -455,6 +536,10 @@ int udl_modeset_init(struct drm_device *dev)
 	if (ret)
 		return ret;
 
+	ret = drmm_add_action(dev, udl_back_release, NULL);
+	if (ret)
+		return ret;
+
 	dev->mode_config.min_width = 640;
 	dev->mode_config.min_height = 480;
 
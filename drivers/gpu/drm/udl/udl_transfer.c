@@ -32,7 +32,6 @@
  * Assumes CPU natural alignment (unsigned long)
  * for back and front buffer ptrs and width
  */
-#if 0
 static int udl_trim_hline(const u8 *bback, const u8 **bfront, int *width_bytes)
 {
 	int j, k;
@@ -63,7 +62,6 @@ static int udl_trim_hline(const u8 *bback, const u8 **bfront, int *width_bytes)
 
 	return identical * sizeof(unsigned long);
 }
-#endif
 
 static inline u16 pixel32_to_be16(const uint32_t pixel)
 {
@@ -208,23 +206,41 @@ static void udl_compress_hline16(
  * client renders to, the actual framebuffer across the USB bus in hardware
  * (that we can only write to, slowly, and can never read), and (optionally)
  * our shadow copy that tracks what's been sent to that hardware buffer.
+ *
+ * With @back, the line segment of the shadow copy matching the front one,
+ * pixels that did not change at either end of the segment are not sent,
+ * and the shadow copy is updated with the ones that are.
  */
 int udl_render_hline(struct drm_device *dev, int log_bpp, struct urb **urb_ptr,
-		     const char *front, char **urb_buf_ptr,
+		     const char *front, u8 *back, char **urb_buf_ptr,
 		     u32 byte_offset, u32 device_byte_offset,
 		     u32 byte_width)
 {
+	struct udl_device *udl = to_udl(dev);
 	const u8 *line_start, *line_end, *next_pixel;
 	u32 base16 = 0 + (device_byte_offset >> log_bpp) * 2;
 	struct urb *urb = *urb_ptr;
 	u8 *cmd = *urb_buf_ptr;
 	u8 *cmd_end = (u8 *) urb->transfer_buffer + urb->transfer_buffer_length;
+	int width = byte_width;
 
 	BUG_ON(!(log_bpp == 1 || log_bpp == 2));
 
 	line_start = (u8 *) (front + byte_offset);
+
+	if (back) {
+		const u8 *front_start = line_start;
+		u32 skip;
+
+		if (udl->back_valid)
+			udl_trim_hline(back, &line_start, &width);
+		skip = line_start - front_start;
+		memcpy(back + skip, line_start, width);
+		base16 += (skip >> log_bpp) * 2;
+	}
+
 	next_pixel = line_start;
-	line_end = next_pixel + byte_width;
+	line_end = next_pixel + width;
 
 	while (next_pixel < line_end) {
 
@@ -0,0 +1,331 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * BPF programs filtering and rewriting HID reports
+ *
+ * BPF_PROG_TYPE_HID_REPORT programs are attached to a HID device through
+ * any of its hidraw nodes, with the same BPF_PROG_ATTACH interface as the
+ * LIRC programs. They run from hid_input_report() for every report of
+ * the device, before the driver's raw_event and before the report is
+ * seen by hidraw, hid-input or hiddev. A program may read and rewrite the
+ * report in place through direct packet access, keep state in maps, and
+ * drop the report by returning 0.
+ */
+
+#include <linux/bpf.h>
+#include <linux/bpf_hid.h>
+#include <linux/filter.h>
+#include <linux/hid.h>
+#include <linux/hidraw.h>
+#include <linux/mutex.h>
+
+#define HID_BPF_MAX_PROGS	64
+
+/* serializes the changes to hdev->bpf_progs */
+static DEFINE_MUTEX(hid_bpf_lock);
+
+#define hid_bpf_dereference(p)						\
+	rcu_dereference_protected(p, lockdep_is_held(&hid_bpf_lock))
+
+const struct bpf_prog_ops hid_report_prog_ops = {
+};
+
+static const struct bpf_func_proto *
+hid_report_func_proto(enum bpf_func_id func_id, const struct bpf_prog *prog)
+{
+	switch (func_id) {
+	case BPF_FUNC_map_lookup_elem:
+		return &bpf_map_lookup_elem_proto;
+	case BPF_FUNC_map_update_elem:
+		return &bpf_map_update_elem_proto;
+	case BPF_FUNC_map_delete_elem:
+		return &bpf_map_delete_elem_proto;
+	case BPF_FUNC_map_push_elem:
+		return &bpf_map_push_elem_proto;
+	case BPF_FUNC_map_pop_elem:
+		return &bpf_map_pop_elem_proto;
+	case BPF_FUNC_map_peek_elem:
+		return &bpf_map_peek_elem_proto;
+	case BPF_FUNC_ktime_get_ns:
+		return &bpf_ktime_get_ns_proto;
+	case BPF_FUNC_ktime_get_boot_ns:
+		return &bpf_ktime_get_boot_ns_proto;
+	case BPF_FUNC_tail_call:
+		return &bpf_tail_call_proto;
+	case BPF_FUNC_get_prandom_u32:
+		return &bpf_get_prandom_u32_proto;
+	case BPF_FUNC_get_smp_processor_id:
+		return &bpf_get_smp_processor_id_proto;
+	case BPF_FUNC_trace_printk:
+		if (perfmon_capable())
+			return bpf_get_trace_printk_proto();
+		fallthrough;
+	default:
+		return NULL;
+	}
+}
+
+static bool hid_report_is_valid_access(int off, int size,
+				       enum bpf_access_type type,
+				       const struct bpf_prog *prog,
+				       struct bpf_insn_access_aux *info)
+{
+	if (type == BPF_WRITE)
+		return false;
+	if (off < 0 || off >= sizeof(struct bpf_hid_report))
+		return false;
+	if (off % size != 0 || size != sizeof(__u32))
+		return false;
+
+	switch (off) {
+	case offsetof(struct bpf_hid_report, data):
+		info->reg_type = PTR_TO_PACKET;
+		break;
+	case offsetof(struct bpf_hid_report, data_end):
+		info->reg_type = PTR_TO_PACKET_END;
+		break;
+	}
+
+	return true;
+}
+
+static u32 hid_report_convert_ctx_access(enum bpf_access_type type,
+					 const struct bpf_insn *si,
+					 struct bpf_insn *insn_buf,
+					 struct bpf_prog *prog, u32 *target_size)
+{
+	struct bpf_insn *insn = insn_buf;
+
+	switch (si->off) {
+	case offsetof(struct bpf_hid_report, data):
+		*insn++ = BPF_LDX_MEM(BPF_FIELD_SIZEOF(struct bpf_hid_report_kern, data),
+				      si->dst_reg, si->src_reg,
+				      offsetof(struct bpf_hid_report_kern, data));
+		break;
+	case offsetof(struct bpf_hid_report, data_end):
+		*insn++ = BPF_LDX_MEM(BPF_FIELD_SIZEOF(struct bpf_hid_report_kern, data_end),
+				      si->dst_reg, si->src_reg,
+				      offsetof(struct bpf_hid_report_kern, data_end));
+		break;
+	case offsetof(struct bpf_hid_report, type):
+		*insn++ = BPF_LDX_MEM(BPF_FIELD_SIZEOF(struct bpf_hid_report_kern, type),
+				      si->dst_reg, si->src_reg,
+				      offsetof(struct bpf_hid_report_kern, type));
+		break;
+	case offsetof(struct bpf_hid_report, bus):
+		*insn++ = BPF_LDX_MEM(BPF_FIELD_SIZEOF(struct bpf_hid_report_kern, hdev),
+				      si->dst_reg, si->src_reg,
+				      offsetof(struct bpf_hid_report_kern, hdev));
+		*insn++ = BPF_LDX_MEM(BPF_FIELD_SIZEOF(struct hid_device, bus),
+				      si->dst_reg, si->dst_reg,
+				      offsetof(struct hid_device, bus));
+		break;
+	case offsetof(struct bpf_hid_report, vendor):
+		*insn++ = BPF_LDX_MEM(BPF_FIELD_SIZEOF(struct bpf_hid_report_kern, hdev),
+				      si->dst_reg, si->src_reg,
+				      offsetof(struct bpf_hid_report_kern, hdev));
+		*insn++ = BPF_LDX_MEM(BPF_FIELD_SIZEOF(struct hid_device, vendor),
+				      si->dst_reg, si->dst_reg,
+				      offsetof(struct hid_device, vendor));
+		break;
+	case offsetof(struct bpf_hid_report, product):
+		*insn++ = BPF_LDX_MEM(BPF_FIELD_SIZEOF(struct bpf_hid_report_kern, hdev),
+				      si->dst_reg, si->src_reg,
+				      offsetof(struct bpf_hid_report_kern, hdev));
+		*insn++ = BPF_LDX_MEM(BPF_FIELD_SIZEOF(struct hid_device, product),
+				      si->dst_reg, si->dst_reg,
+				      offsetof(struct hid_device, product));
+		break;
+	}
+
+	return insn - insn_buf;
+}
+
+/* The report buffer is owned by the caller, nothing needs unsharing. */
+static int hid_report_gen_prologue(struct bpf_insn *insn_buf,
+				   bool direct_write,
+				   const struct bpf_prog *prog)
+{
+	return 0;
+}
+
+const struct bpf_verifier_ops hid_report_verifier_ops = {
+	.get_func_proto		= hid_report_func_proto,
+	.is_valid_access	= hid_report_is_valid_access,
+	.convert_ctx_access	= hid_report_convert_ctx_access,
+	.gen_prologue		= hid_report_gen_prologue,
+};
+
+static int hid_bpf_attach(struct hid_device *hdev, struct bpf_prog *prog)
+{
+	struct bpf_prog_array *old_array;
+	struct bpf_prog_array *new_array;
+	int ret;
+
+	ret = mutex_lock_interruptible(&hid_bpf_lock);
+	if (ret)
+		return ret;
+
+	old_array = hid_bpf_dereference(hdev->bpf_progs);
+	if (old_array && bpf_prog_array_length(old_array) >= HID_BPF_MAX_PROGS) {
+		ret = -E2BIG;
+		goto unlock;
+	}
+
+	ret = bpf_prog_array_copy(old_array, NULL, prog, 0, &new_array);
+	if (ret < 0)
+		goto unlock;
+
+	rcu_assign_pointer(hdev->bpf_progs, new_array);
+	bpf_prog_array_free(old_array);
+
+unlock:
+	mutex_unlock(&hid_bpf_lock);
+	return ret;
+}
+
+static int hid_bpf_detach(struct hid_device *hdev, struct bpf_prog *prog)
+{
+	struct bpf_prog_array *old_array;
+	struct bpf_prog_array *new_array;
+	int ret;
+
+	ret = mutex_lock_interruptible(&hid_bpf_lock);
+	if (ret)
+		return ret;
+
+	old_array = hid_bpf_dereference(hdev->bpf_progs);
+	/* as in lirc_bpf_detach(), no dummy entry may be left behind */
+	ret = bpf_prog_array_copy(old_array, prog, NULL, 0, &new_array);
+	if (ret)
+		goto unlock;
+
+	rcu_assign_pointer(hdev->bpf_progs, new_array);
+	bpf_prog_array_free(old_array);
+	bpf_prog_put(prog);
+unlock:
+	mutex_unlock(&hid_bpf_lock);
+	return ret;
+}
+
+bool __hid_bpf_run_report(struct hid_device *hdev, int type, u8 *data,
+			  u32 size)
+{
+	struct bpf_hid_report_kern ctx = {
+		.hdev		= hdev,
+		.data		= data,
+		.data_end	= data + size,
+		.type		= type,
+	};
+
+	return BPF_PROG_RUN_ARRAY(hdev->bpf_progs, &ctx, bpf_prog_run);
+}
+
+/*
+ * Called when the last reference to @hdev is dropped, there can be no
+ * report being processed anymore.
+ */
+void hid_bpf_free(struct hid_device *hdev)
+{
+	struct bpf_prog_array_item *item;
+	struct bpf_prog_array *array;
+
+	array = rcu_dereference_protected(hdev->bpf_progs, 1);
+	if (!array)
+		return;
+
+	for (item = array->items; item->prog; item++)
+		bpf_prog_put(item->prog);
+
+	bpf_prog_array_free(array);
+}
+
+int hid_prog_attach(const union bpf_attr *attr, struct bpf_prog *prog)
+{
+	struct hid_device *hdev;
+	int ret;
+
+	if (attr->attach_flags)
+		return -EINVAL;
+
+	hdev = hidraw_get_hid_from_fd(attr->target_fd);
+	if (IS_ERR(hdev))
+		return PTR_ERR(hdev);
+
+	ret = hid_bpf_attach(hdev, prog);
+
+	put_device(&hdev->dev);
+
+	return ret;
+}
+
+int hid_prog_detach(const union bpf_attr *attr)
+{
+	struct hid_device *hdev;
+	struct bpf_prog *prog;
+	int ret;
+
+	if (attr->attach_flags)
+		return -EINVAL;
+
+	prog = bpf_prog_get_type(attr->attach_bpf_fd,
+				 BPF_PROG_TYPE_HID_REPORT);
+	if (IS_ERR(prog))
+		return PTR_ERR(prog);
+
+	hdev = hidraw_get_hid_from_fd(attr->target_fd);
+	if (IS_ERR(hdev)) {
+		bpf_prog_put(prog);
+		return PTR_ERR(hdev);
+	}
+
+	ret = hid_bpf_detach(hdev, prog);
+
+	bpf_prog_put(prog);
+	put_device(&hdev->dev);
+
+	return ret;
+}
+
+int hid_prog_query(const union bpf_attr *attr, union bpf_attr __user *uattr)
+{
+	__u32 __user *prog_ids = u64_to_user_ptr(attr->query.prog_ids);
+	struct bpf_prog_array *progs;
+	struct hid_device *hdev;
+	u32 cnt, flags = 0;
+	int ret;
+
+	if (attr->query.query_flags)
+		return -EINVAL;
+
+	hdev = hidraw_get_hid_from_fd(attr->query.target_fd);
+	if (IS_ERR(hdev))
+		return PTR_ERR(hdev);
+
+	ret = mutex_lock_interruptible(&hid_bpf_lock);
+	if (ret)
+		goto put;
+
+	progs = hid_bpf_dereference(hdev->bpf_progs);
+	cnt = progs ? bpf_prog_array_length(progs) : 0;
+
+	if (copy_to_user(&uattr->query.prog_cnt, &cnt, sizeof(cnt))) {
+		ret = -EFAULT;
+		goto unlock;
+	}
+
+	if (copy_to_user(&uattr->query.attach_flags, &flags, sizeof(flags))) {
+		ret = -EFAULT;
+		goto unlock;
+	}
+
+	if (attr->query.prog_cnt != 0 && prog_ids && cnt)
+		ret = bpf_prog_array_copy_to_user(progs, prog_ids,
+						  attr->query.prog_cnt);
+
+unlock:
+	mutex_unlock(&hid_bpf_lock);
+put:
+	put_device(&hdev->dev);
+
+	return ret;
+}
@@ -0,0 +1,411 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * KUnit tests for the HID core report decoding
+ *
+ * The decoding helpers of hid-core.c are checked against the
+ * straightforward bit-by-bit decoders below, on fixed report contents.
+ */
+
+#include <kunit/test.h>
+#include <linux/hid.h>
+#include <linux/module.h>
+
+#include "hid-core.h"
+
+static u32 ref_extract(const u8 *report, unsigned int offset, unsigned int n)
+{
+	unsigned int i;
+	u32 value = 0;
+
+	for (i = 0; i < n; i++)
+		if ((report[(offset + i) / 8] >> ((offset + i) % 8)) & 1)
+			value |= 1U << i;
+
+	return value;
+}
+
+static s32 ref_sign_extend(u32 value, unsigned int n)
+{
+	return n == 32 ? (s32)value : (s32)(value << (32 - n)) >> (32 - n);
+}
+
+static u32 ref_mask(unsigned int n)
+{
+	return n == 32 ? ~0U : (1U << n) - 1;
+}
+
+/* report contents that go through every byte value and mix the bits */
+static void hid_test_fill(u8 *buf, size_t len, u8 seed)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = seed + i * 0x9d;
+}
+
+static void hid_test_snto32(struct kunit *test)
+{
+	unsigned int n, i;
+	u32 value;
+
+	for (n = 1; n <= 32; n++) {
+		u32 samples[] = { 0, 1, ref_mask(n), ref_mask(n) >> 1,
+				  1U << (n - 1), 0x5a5a5a5a, 0xa5a5a5a5 };
+
+		for (i = 0; i < ARRAY_SIZE(samples); i++) {
+			value = samples[i] & ref_mask(n);
+			KUNIT_EXPECT_EQ_MSG(test, hid_snto32(value, n),
+					    ref_sign_extend(value, n),
+					    "value 0x%x, n %u", value, n);
+		}
+	}
+}
+
+static void hid_test_field_extract(struct kunit *test)
+{
+	unsigned int offset, n;
+	u8 report[16];
+
+	hid_test_fill(report, sizeof(report), 0x35);
+
+	for (offset = 0; offset < 64; offset++)
+		for (n = 1; n <= 32; n++)
+			KUNIT_EXPECT_EQ_MSG(test,
+					    hid_field_extract(NULL, report, offset, n),
+					    ref_extract(report, offset, n),
+					    "offset %u, n %u", offset, n);
+}
+
+static void hid_test_implement(struct kunit *test)
+{
+	static const u32 samples[] = { 0, ~0U, 0x5a5a5a5a, 0xa5a5a5a5 };
+	u8 before[16], after[16];
+	unsigned int offset, n, s, i;
+	u32 value;
+	bool bit;
+
+	for (offset = 0; offset < 64; offset++) {
+		for (n = 1; n <= 32; n++) {
+			for (s = 0; s < ARRAY_SIZE(samples); s++) {
+				hid_test_fill(before, sizeof(before), offset + s);
+				memcpy(after, before, sizeof(after));
+				value = samples[s] & ref_mask(n);
+
+				implement(NULL, after, offset, n, value);
+
+				for (i = 0; i < sizeof(after) * 8; i++) {
+					if (i >= offset && i < offset + n)
+						bit = (value >> (i - offset)) & 1;
+					else
+						bit = (before[i / 8] >> (i % 8)) & 1;
+
+					if (((after[i / 8] >> (i % 8)) & 1) != bit) {
+						KUNIT_FAIL(test,
+							   "offset %u, n %u, value 0x%x: bit %u clobbered",
+							   offset, n, value, i);
+						return;
+					}
+				}
+			}
+		}
+	}
+}
+
+/* layouts covering every extraction plan, including odd offsets */
+struct hid_test_layout {
+	const char *name;
+	unsigned int offset, size, count;
+	s32 logical_minimum;
+};
+
+static const struct hid_test_layout hid_test_layouts[] = {
+	{ "bits", 0, 1, 256, 0 },
+	{ "bits signed", 3, 1, 256, -1 },
+	{ "u8", 8, 8, 512, 0 },
+	{ "s8", 8, 8, 512, -128 },
+	{ "u8 unaligned", 5, 8, 512, 0 },
+	{ "u16", 16, 16, 256, 0 },
+	{ "s16", 16, 16, 256, -32768 },
+	{ "s16 unaligned", 11, 16, 256, -32768 },
+	{ "u32", 32, 32, 128, 0 },
+	{ "s12", 4, 12, 256, -2048 },
+	{ "u24 unaligned", 7, 24, 128, 0 },
+};
+
+struct hid_test_ctx {
+	struct hid_device *hid;
+	struct hid_field *field;
+	u8 *data;
+
+	/* events seen by the test driver */
+	unsigned int nr_events;
+	struct {
+		unsigned int index;
+		s32 value;
+	} events[16];
+};
+
+static struct hid_test_ctx *hid_test_ctx;
+
+static int hid_test_event(struct hid_device *hdev, struct hid_field *field,
+			  struct hid_usage *usage, __s32 value)
+{
+	struct hid_test_ctx *ctx = hid_test_ctx;
+
+	if (ctx->nr_events < ARRAY_SIZE(ctx->events)) {
+		ctx->events[ctx->nr_events].index = usage - field->usage;
+		ctx->events[ctx->nr_events].value = value;
+	}
+	ctx->nr_events++;
+
+	return 1;
+}
+
+static struct hid_driver hid_test_driver = {
+	.name = "hid-core-test",
+	.event = hid_test_event,
+};
+
+static int hid_test_init(struct kunit *test)
+{
+	struct hid_test_ctx *ctx;
+	unsigned int t;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, ctx);
+
+	ctx->hid = kunit_kzalloc(test, sizeof(*ctx->hid), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, ctx->hid);
+
+	for (t = 0; t < HID_REPORT_TYPES; t++)
+		INIT_LIST_HEAD(&ctx->hid->report_enum[t].report_list);
+	INIT_LIST_HEAD(&ctx->hid->debug_list);
+	ctx->hid->driver = &hid_test_driver;
+
+	test->priv = ctx;
+	hid_test_ctx = ctx;
+
+	return 0;
+}
+
+static void hid_test_exit(struct kunit *test)
+{
+	struct hid_test_ctx *ctx = test->priv;
+
+	hid_close_report(ctx->hid);
+	hid_test_ctx = NULL;
+}
+
+/*
+ * Register an input field with @layout and room for @usages usages, and a
+ * report covering it.
+ */
+static void hid_test_setup_field(struct kunit *test,
+				 const struct hid_test_layout *layout,
+				 unsigned int usages)
+{
+	struct hid_test_ctx *ctx = test->priv;
+	struct hid_report *report;
+	struct hid_field *field;
+	size_t len = (layout->offset + layout->size * layout->count) / 8 + 1;
+
+	report = hid_register_report(ctx->hid, HID_INPUT_REPORT, 0, 0);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, report);
+
+	field = hid_register_field(report, usages, HID_MAIN_ITEM_VARIABLE);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, field);
+
+	field->report_offset = layout->offset;
+	field->report_size = layout->size;
+	field->report_count = layout->count;
+	field->maxusage = usages;
+	field->logical_minimum = layout->logical_minimum;
+	field->logical_maximum = layout->logical_minimum +
+				 (s32)(ref_mask(layout->size) >> 1);
+	field->flags = HID_MAIN_ITEM_VARIABLE;
+
+	hid_plan_extraction(ctx->hid);
+
+	ctx->field = field;
+	ctx->data = kunit_kmalloc(test, len, GFP_KERNEL);
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, ctx->data);
+	hid_test_fill(ctx->data, len, layout->offset);
+}
+
+static s32 hid_test_ref_value(const struct hid_test_layout *layout,
+			      const u8 *data, unsigned int n)
+{
+	u32 raw = ref_extract(data, layout->offset + n * layout->size,
+			      layout->size);
+
+	return layout->logical_minimum < 0 ?
+		ref_sign_extend(raw, layout->size) : raw;
+}
+
+static void hid_test_input_field(struct kunit *test)
+{
+	const struct hid_test_layout *layout = test->param_value;
+	struct hid_test_ctx *ctx = test->priv;
+	unsigned int n;
+
+	hid_test_setup_field(test, layout, layout->count);
+
+	hid_input_field(ctx->hid, ctx->field, ctx->data, 1);
+
+	for (n = 0; n < layout->count; n++) {
+		s32 expected = hid_test_ref_value(layout, ctx->data, n);
+
+		if (ctx->field->value[n] != expected) {
+			KUNIT_FAIL(test, "%s: value %u is %d, expected %d",
+				   layout->name, n, ctx->field->value[n],
+				   expected);
+			return;
+		}
+	}
+
+	/* variable fields report every value to the driver */
+	KUNIT_EXPECT_EQ(test, ctx->nr_events, layout->count);
+}
+
+static void hid_test_array_report(struct kunit *test, const u8 *data)
+{
+	struct hid_test_ctx *ctx = test->priv;
+
+	ctx->nr_events = 0;
+	hid_input_field(ctx->hid, ctx->field, (u8 *)data, 1);
+}
+
+static void hid_test_array_field(struct kunit *test)
+{
+	static const struct hid_test_layout layout = { "array", 0, 8, 3, 0 };
+	struct hid_test_ctx *ctx = test->priv;
+	struct hid_field *field;
+	unsigned int i;
+
+	hid_test_setup_field(test, &layout, 8);
+
+	/* a keyboard-like array: index 0 is "no event", 1 is ErrorRollOver */
+	field = ctx->field;
+	field->flags = 0;
+	field->logical_maximum = 7;
+	field->usage[1].hid = HID_UP_KEYBOARD + 1;
+	for (i = 2; i < 8; i++)
+		field->usage[i].hid = HID_UP_KEYBOARD + 2 + i;
+
+	hid_test_array_report(test, (const u8[]){ 2, 0, 0 });
+	KUNIT_ASSERT_EQ(test, ctx->nr_events, 1U);
+	KUNIT_EXPECT_EQ(test, ctx->events[0].index, 2U);
+	KUNIT_EXPECT_EQ(test, ctx->events[0].value, 1);
+
+	hid_test_array_report(test, (const u8[]){ 2, 0, 0 });
+	KUNIT_EXPECT_EQ(test, ctx->nr_events, 0U);
+
+	hid_test_array_report(test, (const u8[]){ 3, 2, 0 });
+	KUNIT_ASSERT_EQ(test, ctx->nr_events, 1U);
+	KUNIT_EXPECT_EQ(test, ctx->events[0].index, 3U);
+	KUNIT_EXPECT_EQ(test, ctx->events[0].value, 1);
+
+	/* the same keys in another order are not a change */
+	hid_test_array_report(test, (const u8[]){ 2, 3, 0 });
+	KUNIT_EXPECT_EQ(test, ctx->nr_events, 0U);
+
+	/* ErrorRollOver keeps the previous state */
+	hid_test_array_report(test, (const u8[]){ 1, 1, 1 });
+	KUNIT_EXPECT_EQ(test, ctx->nr_events, 0U);
+	KUNIT_EXPECT_EQ(test, field->value[0], 2);
+
+	hid_test_array_report(test, (const u8[]){ 0, 0, 0 });
+	KUNIT_ASSERT_EQ(test, ctx->nr_events, 2U);
+	KUNIT_EXPECT_EQ(test, ctx->events[0].index, 2U);
+	KUNIT_EXPECT_EQ(test, ctx->events[0].value, 0);
+	KUNIT_EXPECT_EQ(test, ctx->events[1].index, 3U);
+	KUNIT_EXPECT_EQ(test, ctx->events[1].value, 0);
+
+	/* out of range values are ignored */
+	hid_test_array_report(test, (const u8[]){ 0x80, 0, 0 });
+	KUNIT_EXPECT_EQ(test, ctx->nr_events, 0U);
+}
+
+/* three button mouse with 8-bit relative X and Y */
+static const u8 hid_test_mouse_rdesc[] = {
+	0x05, 0x01, 0x09, 0x02, 0xa1, 0x01, 0x09, 0x01,
+	0xa1, 0x00, 0x05, 0x09, 0x19, 0x01, 0x29, 0x03,
+	0x15, 0x00, 0x25, 0x01, 0x95, 0x03, 0x75, 0x01,
+	0x81, 0x02, 0x95, 0x01, 0x75, 0x05, 0x81, 0x01,
+	0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x15, 0x81,
+	0x25, 0x7f, 0x75, 0x08, 0x95, 0x02, 0x81, 0x06,
+	0xc0, 0xc0,
+};
+
+static void hid_test_rdesc_cache(struct kunit *test)
+{
+	struct hid_test_ctx *ctx = test->priv;
+	struct hid_report *report;
+	struct hid_field *field;
+	unsigned long hits;
+
+	if (!hid_rdesc_cache_limit())
+		kunit_skip(test, "hid.rdesc_cache_kb is 0");
+
+	ctx->hid->dev_rdesc = (u8 *)hid_test_mouse_rdesc;
+	ctx->hid->dev_rsize = sizeof(hid_test_mouse_rdesc);
+
+	/* the first parse may already be a hit, the second one must be */
+	KUNIT_ASSERT_EQ(test, hid_open_report(ctx->hid), 0);
+	hid_close_report(ctx->hid);
+
+	hits = hid_rdesc_cache_hits;
+	KUNIT_ASSERT_EQ(test, hid_open_report(ctx->hid), 0);
+	KUNIT_EXPECT_EQ(test, hid_rdesc_cache_hits, hits + 1);
+
+	KUNIT_EXPECT_EQ(test, ctx->hid->maxcollection, 2U);
+	KUNIT_EXPECT_EQ(test, ctx->hid->maxapplication, 1U);
+
+	report = ctx->hid->report_enum[HID_INPUT_REPORT].report_id_hash[0];
+	KUNIT_ASSERT_NOT_ERR_OR_NULL(test, report);
+	KUNIT_EXPECT_PTR_EQ(test, report->device, ctx->hid);
+	KUNIT_EXPECT_EQ(test, report->size, 24U);
+	KUNIT_ASSERT_EQ(test, report->maxfield, 2U);
+
+	field = report->field[0];
+	KUNIT_EXPECT_PTR_EQ(test, field->report, report);
+	KUNIT_EXPECT_EQ(test, field->maxusage, 3U);
+	KUNIT_EXPECT_EQ(test, field->usage[2].hid, HID_UP_BUTTON + 3);
+
+	field = report->field[1];
+	KUNIT_EXPECT_EQ(test, field->index, 1U);
+	KUNIT_EXPECT_EQ(test, field->report_offset, 8U);
+	KUNIT_EXPECT_EQ(test, field->logical_minimum, -127);
+	KUNIT_EXPECT_EQ(test, field->usage[1].hid, HID_GD_Y);
+	KUNIT_EXPECT_EQ(test, field->extract, (unsigned int)HID_EXTRACT_8);
+}
+
+static void hid_test_layout_desc(const struct hid_test_layout *layout,
+				 char *desc)
+{
+	strscpy(desc, layout->name, KUNIT_PARAM_DESC_SIZE);
+}
+
+KUNIT_ARRAY_PARAM(hid_test_layout, hid_test_layouts, hid_test_layout_desc);
+
+static struct kunit_case hid_core_test_cases[] = {
+	KUNIT_CASE(hid_test_snto32),
+	KUNIT_CASE(hid_test_field_extract),
+	KUNIT_CASE(hid_test_implement),
+	KUNIT_CASE_PARAM(hid_test_input_field, hid_test_layout_gen_params),
+	KUNIT_CASE(hid_test_array_field),
+	KUNIT_CASE(hid_test_rdesc_cache),
+	{}
+};
+
+static struct kunit_suite hid_core_test_suite = {
+	.name = "hid-core",
+	.init = hid_test_init,
+	.exit = hid_test_exit,
+	.test_cases = hid_core_test_cases,
+};
+
+kunit_test_suite(hid_core_test_suite);
+
+MODULE_DESCRIPTION("KUnit tests for the HID core report decoding");
+MODULE_LICENSE("GPL");
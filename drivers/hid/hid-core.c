@@ -20,6 +20,7 @@
 #include <linux/list.h>
 #include <linux/mm.h>
 #include <linux/spinlock.h>
+#include <linux/bitmap.h>
 #include <asm/unaligned.h>
 #include <asm/byteorder.h>
 #include <linux/input.h>
@@ -27,13 +28,31 @@
 #include <linux/vmalloc.h>
 #include <linux/sched.h>
 #include <linux/semaphore.h>
+#include <linux/hashtable.h>
+#include <linux/irq_work.h>
+#include <linux/jhash.h>
+#include <linux/llist.h>
+#include <linux/mutex.h>
+#include <linux/sizes.h>
+#include <linux/fast_clock.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/seq_file.h>
+#include <linux/trace_fixed.h>
 
 #include <linux/hid.h>
 #include <linux/hiddev.h>
 #include <linux/hid-debug.h>
 #include <linux/hidraw.h>
+#include <linux/bpf_hid.h>
 
 #include "hid-ids.h"
+#include "hid-core.h"
+
+#define CREATE_TRACE_POINTS
+#include <trace/events/hid.h>
+
+EXPORT_TRACEPOINT_SYMBOL_GPL(hid_transport_report);
 
 /*
  * Version Information
@@ -86,11 +105,60 @@ struct hid_report *hid_register_report(struct hid_device *device,
 }
 EXPORT_SYMBOL_GPL(hid_register_report);
 
+/*
+ * Allocate a field with room for @usages usages. The usage table, the
+ * value tables and, for array fields, the usage bitmaps are allocated
+ * behind the field.
+ */
+
+static unsigned int hid_field_bitmap_longs(unsigned int usages,
+					   unsigned int flags)
+{
+	/* only array fields are diffed through the usage bitmaps */
+	if (flags & HID_MAIN_ITEM_VARIABLE)
+		return 0;
+	return BITS_TO_LONGS(usages);
+}
+
+static size_t hid_field_size(unsigned int usages, unsigned int flags)
+{
+	return sizeof(struct hid_field) +
+	       2 * hid_field_bitmap_longs(usages, flags) * sizeof(unsigned long) +
+	       usages * sizeof(struct hid_usage) +
+	       2 * usages * sizeof(unsigned);
+}
+
+static struct hid_field *hid_alloc_field(unsigned int usages,
+					 unsigned int flags)
+{
+	unsigned int longs = hid_field_bitmap_longs(usages, flags);
+	struct hid_field *field;
+	unsigned long *bits;
+
+	field = kzalloc(hid_field_size(usages, flags), GFP_KERNEL);
+	if (!field)
+		return NULL;
+
+	bits = (unsigned long *)(field + 1);
+	if (longs) {
+		field->usage_bits = bits;
+		field->new_usage_bits = bits + longs;
+		bits += 2 * longs;
+	}
+	field->usage = (struct hid_usage *)bits;
+	field->value = (s32 *)(field->usage + usages);
+	field->new_value = field->value + usages;
+
+	return field;
+}
+
 /*
  * Register a new field for this report.
  */
 
-static struct hid_field *hid_register_field(struct hid_report *report, unsigned usages)
+HID_VISIBLE_IF_KUNIT
+struct hid_field *hid_register_field(struct hid_report *report, unsigned usages,
+				     unsigned flags)
 {
 	struct hid_field *field;
 
@@ -99,20 +167,17 @@ static struct hid_field *hid_register_field(struct hid_report *report, unsigned
 		return NULL;
 	}
 
-	field = kzalloc((sizeof(struct hid_field) +
-			 usages * sizeof(struct hid_usage) +
-			 usages * sizeof(unsigned)), GFP_KERNEL);
+	field = hid_alloc_field(usages, flags);
 	if (!field)
 		return NULL;
 
 	field->index = report->maxfield++;
 	report->field[field->index] = field;
-	field->usage = (struct hid_usage *)(field + 1);
-	field->value = (s32 *)(field->usage + usages);
 	field->report = report;
 
 	return field;
 }
+HID_EXPORT_SYMBOL_IF_KUNIT(hid_register_field);
 
 /*
  * Open a collection. The type/usage is pushed on the stack.
@@ -300,7 +365,7 @@ static int hid_add_field(struct hid_parser *parser, unsigned report_type, unsign
 	usages = max_t(unsigned, parser->local.usage_index,
 				 parser->global.report_count);
 
-	field = hid_register_field(report, usages);
+	field = hid_register_field(report, usages, flags);
 	if (!field)
 		return 0;
 
@@ -647,9 +712,9 @@ static int hid_parser_reserved(struct hid_parser *parser, struct hid_item *item)
 }
 
 /*
- * Free a report and all registered fields. The field->usage and
- * field->value table's are allocated behind the field, so we need
- * only to free(field) itself.
+ * Free a report and all registered fields. The field->usage,
+ * field->value and field->new_value table's and the usage bitmaps are
+ * allocated behind the field, so we need only to free(field) itself.
  */
 
 static void hid_free_report(struct hid_report *report)
@@ -661,11 +726,7 @@ static void hid_free_report(struct hid_report *report)
 	kfree(report);
 }
 
-/*
- * Close report. This function returns the device
- * state to the point prior to hid_open_report().
- */
-static void hid_close_report(struct hid_device *device)
+static void hid_free_reports(struct hid_device *device)
 {
 	unsigned i, j;
 
@@ -680,6 +741,15 @@ static void hid_close_report(struct hid_device *device)
 		memset(report_enum, 0, sizeof(*report_enum));
 		INIT_LIST_HEAD(&report_enum->report_list);
 	}
+}
+
+/*
+ * Close report. This function returns the device
+ * state to the point prior to hid_open_report().
+ */
+HID_VISIBLE_IF_KUNIT void hid_close_report(struct hid_device *device)
+{
+	hid_free_reports(device);
 
 	kfree(device->rdesc);
 	device->rdesc = NULL;
@@ -693,6 +763,7 @@ static void hid_close_report(struct hid_device *device)
 
 	device->status &= ~HID_STAT_PARSED;
 }
+HID_EXPORT_SYMBOL_IF_KUNIT(hid_close_report);
 
 /*
  * Free a device structure, all reports, and all fields.
@@ -702,7 +773,9 @@ static void hid_device_release(struct device *dev)
 {
 	struct hid_device *hid = to_hid_device(dev);
 
+	hid_bpf_free(hid);
 	hid_close_report(hid);
+	kfree(hid->request_buf);
 	kfree(hid->dev_rdesc);
 	kfree(hid);
 }
@@ -1175,6 +1248,362 @@ void hid_setup_resolution_multiplier(struct hid_device *hid)
 }
 EXPORT_SYMBOL_GPL(hid_setup_resolution_multiplier);
 
+/*
+ * The layout of the reports is fixed once parsed, so pick for each field
+ * the cheapest way to extract its values: whole little endian bytes, words
+ * and double words, or single bits, instead of the generic bit by bit copy.
+ */
+
+HID_VISIBLE_IF_KUNIT void hid_plan_extraction(struct hid_device *device)
+{
+	struct hid_report *report;
+	struct hid_field *field;
+	unsigned int t, i;
+
+	for (t = 0; t < HID_REPORT_TYPES; t++) {
+		list_for_each_entry(report, &device->report_enum[t].report_list,
+				    list) {
+			for (i = 0; i < report->maxfield; i++) {
+				field = report->field[i];
+				field->extract = HID_EXTRACT_GENERIC;
+
+				if (field->report_size == 1) {
+					field->extract = HID_EXTRACT_BITS;
+					continue;
+				}
+				if (field->report_offset % 8)
+					continue;
+
+				switch (field->report_size) {
+				case 8:
+					field->extract = HID_EXTRACT_8;
+					break;
+				case 16:
+					field->extract = HID_EXTRACT_16;
+					break;
+				case 32:
+					field->extract = HID_EXTRACT_32;
+					break;
+				}
+			}
+		}
+	}
+}
+HID_EXPORT_SYMBOL_IF_KUNIT(hid_plan_extraction);
+
+/*
+ * Parsed report descriptor cache.
+ *
+ * Parsing builds the same tree of reports, fields and usages for every
+ * device with a given report descriptor, and devices reconnecting over
+ * Bluetooth parse it again on every connection. A copy of the tree, as it
+ * is right after parsing, is kept in a cache keyed by the hash of the
+ * fixed up descriptor and cloned by hid_open_report() for the next device
+ * with the same descriptor. The cache is limited to hid.rdesc_cache_kb
+ * kilobytes, the least recently used entries are dropped first.
+ */
+
+#define HID_RDESC_CACHE_BITS	6
+
+struct hid_rdesc_cache_entry {
+	struct hlist_node node;
+	struct list_head lru;
+	u32 hash;
+	size_t size;			/* memory accounted to the entry */
+	__u8 *rdesc;
+	unsigned int rsize;
+	struct hid_collection *collection;
+	unsigned int collection_size;
+	unsigned int maxcollection;
+	unsigned int maxapplication;
+	unsigned int numbered[HID_REPORT_TYPES];
+	struct list_head reports[HID_REPORT_TYPES];
+};
+
+static unsigned int hid_rdesc_cache_kb = 256;
+module_param_named(rdesc_cache_kb, hid_rdesc_cache_kb, uint, 0644);
+MODULE_PARM_DESC(rdesc_cache_kb, "Memory for the parsed report descriptor cache, in kilobytes (0 = off)");
+
+/* protects the cache and its counters */
+static DEFINE_MUTEX(hid_rdesc_cache_lock);
+static DEFINE_HASHTABLE(hid_rdesc_cache, HID_RDESC_CACHE_BITS);
+static LIST_HEAD(hid_rdesc_cache_lru);
+static size_t hid_rdesc_cache_used;
+HID_VISIBLE_IF_KUNIT unsigned long hid_rdesc_cache_hits;
+HID_EXPORT_SYMBOL_IF_KUNIT(hid_rdesc_cache_hits);
+static unsigned long hid_rdesc_cache_misses;
+static unsigned long hid_rdesc_cache_evictions;
+
+HID_VISIBLE_IF_KUNIT size_t hid_rdesc_cache_limit(void)
+{
+	return (size_t)READ_ONCE(hid_rdesc_cache_kb) * SZ_1K;
+}
+HID_EXPORT_SYMBOL_IF_KUNIT(hid_rdesc_cache_limit);
+
+/*
+ * Copy @src and its fields for @device. The values, which are only
+ * known once reports come in, and the hid-input data are not copied.
+ */
+static struct hid_report *hid_copy_report(const struct hid_report *src,
+					  struct hid_device *device,
+					  size_t *size)
+{
+	struct hid_report *report;
+	unsigned int n;
+
+	report = kzalloc(sizeof(*report), GFP_KERNEL);
+	if (!report)
+		return NULL;
+
+	report->id = src->id;
+	report->type = src->type;
+	report->application = src->application;
+	report->size = src->size;
+	report->device = device;
+	*size += sizeof(*report);
+
+	for (n = 0; n < src->maxfield; n++) {
+		const struct hid_field *sf = src->field[n];
+		struct hid_field *field;
+
+		field = hid_alloc_field(sf->maxusage, sf->flags);
+		if (!field) {
+			hid_free_report(report);
+			return NULL;
+		}
+
+		field->physical = sf->physical;
+		field->logical = sf->logical;
+		field->application = sf->application;
+		memcpy(field->usage, sf->usage,
+		       sf->maxusage * sizeof(*field->usage));
+		field->maxusage = sf->maxusage;
+		field->flags = sf->flags;
+		field->report_offset = sf->report_offset;
+		field->report_size = sf->report_size;
+		field->report_count = sf->report_count;
+		field->report_type = sf->report_type;
+		field->logical_minimum = sf->logical_minimum;
+		field->logical_maximum = sf->logical_maximum;
+		field->physical_minimum = sf->physical_minimum;
+		field->physical_maximum = sf->physical_maximum;
+		field->unit_exponent = sf->unit_exponent;
+		field->unit = sf->unit;
+		field->report = report;
+		field->index = n;
+
+		report->field[n] = field;
+		report->maxfield = n + 1;
+		*size += hid_field_size(sf->maxusage, sf->flags);
+	}
+
+	return report;
+}
+
+static void hid_rdesc_cache_free(struct hid_rdesc_cache_entry *entry)
+{
+	struct hid_report *report, *tmp;
+	unsigned int t;
+
+	for (t = 0; t < HID_REPORT_TYPES; t++)
+		list_for_each_entry_safe(report, tmp, &entry->reports[t], list)
+			hid_free_report(report);
+
+	kfree(entry->collection);
+	kfree(entry->rdesc);
+	kfree(entry);
+}
+
+/* Caller holds hid_rdesc_cache_lock. */
+static void hid_rdesc_cache_shrink(size_t limit)
+{
+	struct hid_rdesc_cache_entry *entry;
+
+	while (hid_rdesc_cache_used > limit) {
+		entry = list_last_entry(&hid_rdesc_cache_lru,
+					struct hid_rdesc_cache_entry, lru);
+		hash_del(&entry->node);
+		list_del(&entry->lru);
+		hid_rdesc_cache_used -= entry->size;
+		hid_rdesc_cache_evictions++;
+		hid_rdesc_cache_free(entry);
+	}
+}
+
+/* Caller holds hid_rdesc_cache_lock. */
+static struct hid_rdesc_cache_entry *
+hid_rdesc_cache_find(const __u8 *rdesc, unsigned int rsize, u32 hash)
+{
+	struct hid_rdesc_cache_entry *entry;
+
+	hash_for_each_possible(hid_rdesc_cache, entry, node, hash)
+		if (entry->hash == hash && entry->rsize == rsize &&
+		    !memcmp(entry->rdesc, rdesc, rsize))
+			return entry;
+
+	return NULL;
+}
+
+/*
+ * Keep a copy of the tree @device just parsed. Failing to allocate the
+ * copy only means the next device parses its descriptor again.
+ */
+static void hid_rdesc_cache_add(struct hid_device *device, u32 hash)
+{
+	size_t limit = hid_rdesc_cache_limit();
+	struct hid_rdesc_cache_entry *entry;
+	struct hid_report *report, *copy;
+	unsigned int t;
+
+	if (!limit)
+		return;
+
+	entry = kzalloc(sizeof(*entry), GFP_KERNEL);
+	if (!entry)
+		return;
+
+	for (t = 0; t < HID_REPORT_TYPES; t++)
+		INIT_LIST_HEAD(&entry->reports[t]);
+	entry->hash = hash;
+	entry->size = sizeof(*entry);
+
+	entry->rdesc = kmemdup(device->rdesc, device->rsize, GFP_KERNEL);
+	if (!entry->rdesc)
+		goto err;
+	entry->rsize = device->rsize;
+	entry->size += device->rsize;
+
+	entry->collection = kmemdup(device->collection,
+				    device->collection_size *
+				    sizeof(struct hid_collection), GFP_KERNEL);
+	if (!entry->collection)
+		goto err;
+	entry->collection_size = device->collection_size;
+	entry->maxcollection = device->maxcollection;
+	entry->maxapplication = device->maxapplication;
+	entry->size += device->collection_size * sizeof(struct hid_collection);
+
+	for (t = 0; t < HID_REPORT_TYPES; t++) {
+		struct hid_report_enum *report_enum = device->report_enum + t;
+
+		entry->numbered[t] = report_enum->numbered;
+		list_for_each_entry(report, &report_enum->report_list, list) {
+			copy = hid_copy_report(report, NULL, &entry->size);
+			if (!copy)
+				goto err;
+			list_add_tail(&copy->list, &entry->reports[t]);
+		}
+	}
+
+	if (entry->size > limit)
+		goto err;
+
+	mutex_lock(&hid_rdesc_cache_lock);
+	if (hid_rdesc_cache_find(entry->rdesc, entry->rsize, hash)) {
+		/* another device with the same descriptor was faster */
+		mutex_unlock(&hid_rdesc_cache_lock);
+		goto err;
+	}
+	hid_rdesc_cache_shrink(limit - entry->size);
+	hash_add(hid_rdesc_cache, &entry->node, hash);
+	list_add(&entry->lru, &hid_rdesc_cache_lru);
+	hid_rdesc_cache_used += entry->size;
+	mutex_unlock(&hid_rdesc_cache_lock);
+	return;
+
+err:
+	hid_rdesc_cache_free(entry);
+}
+
+/*
+ * Clone the cached tree of the descriptor set in @device->rdesc, if
+ * any. Returns false if @device has to parse it.
+ */
+static bool hid_rdesc_cache_get(struct hid_device *device, u32 hash)
+{
+	struct hid_rdesc_cache_entry *entry;
+	struct hid_report *src, *report;
+	size_t size = 0;
+	unsigned int t;
+
+	if (!hid_rdesc_cache_limit())
+		return false;
+
+	mutex_lock(&hid_rdesc_cache_lock);
+	entry = hid_rdesc_cache_find(device->rdesc, device->rsize, hash);
+	if (!entry) {
+		hid_rdesc_cache_misses++;
+		mutex_unlock(&hid_rdesc_cache_lock);
+		return false;
+	}
+	list_move(&entry->lru, &hid_rdesc_cache_lru);
+
+	device->collection = kmemdup(entry->collection,
+				     entry->collection_size *
+				     sizeof(struct hid_collection), GFP_KERNEL);
+	if (!device->collection)
+		goto err;
+	device->collection_size = entry->collection_size;
+	device->maxcollection = entry->maxcollection;
+	device->maxapplication = entry->maxapplication;
+
+	for (t = 0; t < HID_REPORT_TYPES; t++) {
+		struct hid_report_enum *report_enum = device->report_enum + t;
+
+		report_enum->numbered = entry->numbered[t];
+		list_for_each_entry(src, &entry->reports[t], list) {
+			report = hid_copy_report(src, device, &size);
+			if (!report)
+				goto err;
+			report_enum->report_id_hash[report->id] = report;
+			list_add_tail(&report->list, &report_enum->report_list);
+		}
+	}
+
+	hid_rdesc_cache_hits++;
+	mutex_unlock(&hid_rdesc_cache_lock);
+	return true;
+
+err:
+	hid_rdesc_cache_misses++;
+	mutex_unlock(&hid_rdesc_cache_lock);
+
+	hid_free_reports(device);
+	kfree(device->collection);
+	device->collection = NULL;
+	device->collection_size = 0;
+	device->maxcollection = 0;
+	device->maxapplication = 0;
+	return false;
+}
+
+static void hid_rdesc_cache_flush(void)
+{
+	mutex_lock(&hid_rdesc_cache_lock);
+	hid_rdesc_cache_shrink(0);
+	mutex_unlock(&hid_rdesc_cache_lock);
+}
+
+#ifdef CONFIG_DEBUG_FS
+void hid_rdesc_cache_show(struct seq_file *m)
+{
+	unsigned int entries = 0, bkt;
+	struct hid_rdesc_cache_entry *entry;
+
+	mutex_lock(&hid_rdesc_cache_lock);
+	hash_for_each(hid_rdesc_cache, bkt, entry, node)
+		entries++;
+
+	seq_printf(m, "entries: %u\n", entries);
+	seq_printf(m, "used: %zu\n", hid_rdesc_cache_used);
+	seq_printf(m, "limit: %zu\n", hid_rdesc_cache_limit());
+	seq_printf(m, "hits: %lu\n", hid_rdesc_cache_hits);
+	seq_printf(m, "misses: %lu\n", hid_rdesc_cache_misses);
+	seq_printf(m, "evictions: %lu\n", hid_rdesc_cache_evictions);
+	mutex_unlock(&hid_rdesc_cache_lock);
+}
+#endif
+
 /**
  * hid_open_report - open a driver-specific device report
  *
@@ -1196,6 +1625,7 @@ int hid_open_report(struct hid_device *device)
 	__u8 *buf;
 	__u8 *end;
 	__u8 *next;
+	u32 hash;
 	int ret;
 	static int (*dispatch_type[])(struct hid_parser *parser,
 				      struct hid_item *item) = {
@@ -1230,6 +1660,10 @@ int hid_open_report(struct hid_device *device)
 	device->rdesc = start;
 	device->rsize = size;
 
+	hash = jhash(start, size, 0);
+	if (hid_rdesc_cache_get(device, hash))
+		goto parsed;
+
 	parser = vzalloc(sizeof(struct hid_parser));
 	if (!parser) {
 		ret = -ENOMEM;
@@ -1274,17 +1708,10 @@ int hid_open_report(struct hid_device *device)
 				goto err;
 			}
 
-			/*
-			 * fetch initial values in case the device's
-			 * default multiplier isn't the recommended 1
-			 */
-			hid_setup_resolution_multiplier(device);
-
 			kfree(parser->collection_stack);
 			vfree(parser);
-			device->status |= HID_STAT_PARSED;
-
-			return 0;
+			hid_rdesc_cache_add(device, hash);
+			goto parsed;
 		}
 	}
 
@@ -1296,6 +1723,19 @@ int hid_open_report(struct hid_device *device)
 	vfree(parser);
 	hid_close_report(device);
 	return ret;
+
+parsed:
+	hid_plan_extraction(device);
+
+	/*
+	 * fetch initial values in case the device's
+	 * default multiplier isn't the recommended 1
+	 */
+	hid_setup_resolution_multiplier(device);
+
+	device->status |= HID_STAT_PARSED;
+
+	return 0;
 }
 EXPORT_SYMBOL_GPL(hid_open_report);
 
@@ -1415,8 +1855,8 @@ static void __implement(u8 *report, unsigned offset, int n, u32 value)
 	}
 }
 
-static void implement(const struct hid_device *hid, u8 *report,
-		      unsigned offset, unsigned n, u32 value)
+HID_VISIBLE_IF_KUNIT void implement(const struct hid_device *hid, u8 *report,
+				       unsigned offset, unsigned n, u32 value)
 {
 	if (unlikely(n > 32)) {
 		hid_warn(hid, "%s() called with n (%d) > 32! (%s)\n",
@@ -1436,18 +1876,41 @@ static void implement(const struct hid_device *hid, u8 *report,
 
 	__implement(report, offset, n, value);
 }
+HID_EXPORT_SYMBOL_IF_KUNIT(implement);
 
 /*
- * Search an array for a value.
+ * Return the usage index an array field value refers to, or -1 if the
+ * value is out of range.
  */
 
-static int search(__s32 *array, __s32 value, unsigned n)
+static int hid_array_usage(struct hid_field *field, __s32 value)
 {
-	while (n--) {
-		if (*array++ == value)
-			return 0;
-	}
-	return -1;
+	__s32 min = field->logical_minimum;
+
+	if (value < min || value > field->logical_maximum ||
+	    value - min >= field->maxusage)
+		return -1;
+	return value - min;
+}
+
+/*
+ * Whether the usage at index @idx is in @values, the values of an array
+ * field. @bits has the usages of @values set, unless the field was made
+ * an array by a driver after it was allocated without the bitmaps.
+ */
+
+static bool hid_array_has(struct hid_field *field, const unsigned long *bits,
+			  const __s32 *values, int idx)
+{
+	unsigned int n;
+
+	if (bits)
+		return test_bit(idx, bits);
+
+	for (n = 0; n < field->report_count; n++)
+		if (hid_array_usage(field, values[n]) == idx)
+			return true;
+	return false;
 }
 
 /**
@@ -1525,65 +1988,134 @@ static void hid_process_event(struct hid_device *hid, struct hid_field *field,
 }
 
 /*
- * Analyse a received field, and fetch the data from it. The field
- * content is stored for next report processing (we do differential
- * reporting to the layer).
+ * Fetch the values of a field following the plan picked by
+ * hid_plan_extraction().
  */
 
-static void hid_input_field(struct hid_device *hid, struct hid_field *field,
-			    __u8 *data, int interrupt)
+static void hid_extract_values(struct hid_device *hid, struct hid_field *field,
+			       __u8 *data, __s32 *value)
 {
 	unsigned n;
 	unsigned count = field->report_count;
 	unsigned offset = field->report_offset;
 	unsigned size = field->report_size;
-	__s32 min = field->logical_minimum;
-	__s32 max = field->logical_maximum;
-	__s32 *value;
+	bool sign = field->logical_minimum < 0;
+	__u8 *p = data + offset / 8;
+
+	switch (field->extract) {
+	case HID_EXTRACT_BITS:
+		for (n = 0; n < count; n++, offset++) {
+			value[n] = (data[offset / 8] >> (offset % 8)) & 1;
+			if (sign)
+				value[n] = -value[n];
+		}
+		break;
+	case HID_EXTRACT_8:
+		for (n = 0; n < count; n++)
+			value[n] = sign ? (__s8)p[n] : p[n];
+		break;
+	case HID_EXTRACT_16:
+		for (n = 0; n < count; n++, p += 2)
+			value[n] = sign ? (__s16)get_unaligned_le16(p) :
+					  get_unaligned_le16(p);
+		break;
+	case HID_EXTRACT_32:
+		for (n = 0; n < count; n++, p += 4)
+			value[n] = get_unaligned_le32(p);
+		break;
+	default:
+		for (n = 0; n < count; n++)
+			value[n] = sign ?
+				snto32(hid_field_extract(hid, data,
+							 offset + n * size,
+							 size), size) :
+				hid_field_extract(hid, data, offset + n * size,
+						  size);
+		break;
+	}
+}
 
-	value = kmalloc_array(count, sizeof(__s32), GFP_ATOMIC);
-	if (!value)
-		return;
+/*
+ * Analyse a received field, and fetch the data from it. The field
+ * content is stored for next report processing (we do differential
+ * reporting to the layer). The values are decoded into the scratch
+ * table preallocated behind the field, so this never allocates.
+ */
 
-	for (n = 0; n < count; n++) {
+HID_VISIBLE_IF_KUNIT
+void hid_input_field(struct hid_device *hid, struct hid_field *field,
+		     __u8 *data, int interrupt)
+{
+	unsigned n;
+	unsigned count = field->report_count;
+	unsigned long *old_bits = field->usage_bits;
+	unsigned long *new_bits = field->new_usage_bits;
+	__s32 *value = field->new_value;
+	bool rollover = false;
+	int old, new;
 
-		value[n] = min < 0 ?
-			snto32(hid_field_extract(hid, data, offset + n * size,
-			       size), size) :
-			hid_field_extract(hid, data, offset + n * size, size);
+	hid_extract_values(hid, field, data, value);
 
-		/* Ignore report if ErrorRollOver */
-		if (!(field->flags & HID_MAIN_ITEM_VARIABLE) &&
-		    value[n] >= min && value[n] <= max &&
-		    value[n] - min < field->maxusage &&
-		    field->usage[value[n] - min].hid == HID_UP_KEYBOARD + 1)
-			goto exit;
+	if (HID_MAIN_ITEM_VARIABLE & field->flags) {
+		for (n = 0; n < count; n++)
+			hid_process_event(hid, field, &field->usage[n], value[n], interrupt);
+		goto out;
 	}
 
+	/*
+	 * Collect the usages present in the previous and in this report,
+	 * so that a key which appears in only one of them is found with a
+	 * single bit test instead of searching the other array. The
+	 * bitmaps are left clear between reports, only the bits set here
+	 * are cleared again below.
+	 */
 	for (n = 0; n < count; n++) {
+		new = hid_array_usage(field, value[n]);
+		if (new >= 0) {
+			/* Ignore report if ErrorRollOver */
+			if (field->usage[new].hid == HID_UP_KEYBOARD + 1)
+				rollover = true;
+			if (new_bits)
+				__set_bit(new, new_bits);
+		}
 
-		if (HID_MAIN_ITEM_VARIABLE & field->flags) {
-			hid_process_event(hid, field, &field->usage[n], value[n], interrupt);
-			continue;
+		old = hid_array_usage(field, field->value[n]);
+		if (old >= 0 && old_bits)
+			__set_bit(old, old_bits);
+	}
+
+	if (!rollover &&
+	    !(old_bits && bitmap_equal(old_bits, new_bits, field->maxusage))) {
+		for (n = 0; n < count; n++) {
+			old = hid_array_usage(field, field->value[n]);
+			if (old >= 0 && field->usage[old].hid &&
+			    !hid_array_has(field, new_bits, value, old))
+				hid_process_event(hid, field, &field->usage[old], 0, interrupt);
+
+			new = hid_array_usage(field, value[n]);
+			if (new >= 0 && field->usage[new].hid &&
+			    !hid_array_has(field, old_bits, field->value, new))
+				hid_process_event(hid, field, &field->usage[new], 1, interrupt);
 		}
+	}
 
-		if (field->value[n] >= min && field->value[n] <= max
-			&& field->value[n] - min < field->maxusage
-			&& field->usage[field->value[n] - min].hid
-			&& search(value, field->value[n], count))
-				hid_process_event(hid, field, &field->usage[field->value[n] - min], 0, interrupt);
+	for (n = 0; n < count && old_bits; n++) {
+		new = hid_array_usage(field, value[n]);
+		if (new >= 0)
+			__clear_bit(new, new_bits);
 
-		if (value[n] >= min && value[n] <= max
-			&& value[n] - min < field->maxusage
-			&& field->usage[value[n] - min].hid
-			&& search(field->value, value[n], count))
-				hid_process_event(hid, field, &field->usage[value[n] - min], 1, interrupt);
+		old = hid_array_usage(field, field->value[n]);
+		if (old >= 0)
+			__clear_bit(old, old_bits);
 	}
 
+	if (rollover)
+		return;
+
+out:
 	memcpy(field->value, value, count * sizeof(__s32));
-exit:
-	kfree(value);
 }
+HID_EXPORT_SYMBOL_IF_KUNIT(hid_input_field);
 
 /*
  * Output the field into the report.
@@ -1652,6 +2184,141 @@ u8 *hid_alloc_report_buf(struct hid_report *report, gfp_t flags)
 }
 EXPORT_SYMBOL_GPL(hid_alloc_report_buf);
 
+struct workqueue_struct *hid_output_wq;
+EXPORT_SYMBOL_GPL(hid_output_wq);
+
+#define HID_OUTPUT_LAT_BUCKETS	12	/* log2 of microseconds, last one open */
+
+static struct {
+	spinlock_t lock;
+	u64 count;
+	u64 total_ns;
+	u64 max_ns;
+	u64 hist[HID_OUTPUT_LAT_BUCKETS];
+} hid_output_lat = {
+	.lock = __SPIN_LOCK_UNLOCKED(hid_output_lat.lock),
+};
+
+static void hid_output_work_fn(struct work_struct *work)
+{
+	struct hid_output_work *ow = container_of(work, struct hid_output_work,
+						  work);
+	u64 delta = fast_clock_to_ns(fast_clock_now() - READ_ONCE(ow->queued));
+	unsigned long flags;
+	unsigned int bucket;
+
+	bucket = min_t(unsigned int, ilog2(div_u64(delta, NSEC_PER_USEC) | 1),
+		       HID_OUTPUT_LAT_BUCKETS - 1);
+
+	spin_lock_irqsave(&hid_output_lat.lock, flags);
+	hid_output_lat.count++;
+	hid_output_lat.total_ns += delta;
+	hid_output_lat.max_ns = max(hid_output_lat.max_ns, delta);
+	hid_output_lat.hist[bucket]++;
+	spin_unlock_irqrestore(&hid_output_lat.lock, flags);
+
+	ow->func(work);
+}
+
+/**
+ * hid_init_output_work() - prepare output work for hid_output_wq
+ * @ow: the work
+ * @func: called from the workqueue, with &ow->work as argument
+ */
+void hid_init_output_work(struct hid_output_work *ow, work_func_t func)
+{
+	INIT_WORK(&ow->work, hid_output_work_fn);
+	ow->func = func;
+	ow->queued = 0;
+}
+EXPORT_SYMBOL_GPL(hid_init_output_work);
+
+/**
+ * hid_queue_output_work() - queue output work on hid_output_wq
+ * @ow: the work, set up with hid_init_output_work()
+ *
+ * Like queue_work(), returns false if the work was already pending. The
+ * latency is measured from the first queueing of a pending work.
+ */
+bool hid_queue_output_work(struct hid_output_work *ow)
+{
+	if (!work_pending(&ow->work))
+		WRITE_ONCE(ow->queued, fast_clock_now());
+	return queue_work(hid_output_wq, &ow->work);
+}
+EXPORT_SYMBOL_GPL(hid_queue_output_work);
+
+static void hid_raw_request_work(struct work_struct *work)
+{
+	struct hid_raw_request *req = container_of(work, struct hid_raw_request,
+						   work.work);
+	struct hid_device *hdev = req->hdev;
+
+	req->complete(req, hdev->ll_driver->raw_request(hdev, req->reportnum,
+							req->buf, req->len,
+							req->rtype,
+							req->reqtype));
+}
+
+/**
+ * hid_hw_raw_request_async() - queue a raw report request
+ * @hdev: hid device
+ * @req: the request, with all fields up to &hid_raw_request.context set
+ *
+ * Same as hid_hw_raw_request(), but returns as soon as the request is
+ * queued, so that several requests can be in flight. The transport sends
+ * them in order. Transports without &hid_ll_driver.raw_request_async get
+ * their synchronous request run from hid_output_wq, in which case the
+ * requests may run in parallel.
+ *
+ * Return: 0 if &hid_raw_request.complete is going to be called, negative
+ * error code otherwise.
+ */
+int hid_hw_raw_request_async(struct hid_device *hdev,
+			     struct hid_raw_request *req)
+{
+	if (req->len < 1 || req->len > HID_MAX_BUFFER_SIZE || !req->buf ||
+	    !req->complete)
+		return -EINVAL;
+
+	req->hdev = hdev;
+	hid_hw_note_output(hdev, req->reqtype);
+
+	if (hdev->ll_driver->raw_request_async)
+		return hdev->ll_driver->raw_request_async(hdev, req);
+
+	hid_init_output_work(&req->work, hid_raw_request_work);
+	hid_queue_output_work(&req->work);
+	return 0;
+}
+EXPORT_SYMBOL_GPL(hid_hw_raw_request_async);
+
+#ifdef CONFIG_DEBUG_FS
+void hid_output_latency_show(struct seq_file *m)
+{
+	u64 hist[HID_OUTPUT_LAT_BUCKETS];
+	u64 count, total, max;
+	unsigned long flags;
+	unsigned int i;
+
+	spin_lock_irqsave(&hid_output_lat.lock, flags);
+	count = hid_output_lat.count;
+	total = hid_output_lat.total_ns;
+	max = hid_output_lat.max_ns;
+	memcpy(hist, hid_output_lat.hist, sizeof(hist));
+	spin_unlock_irqrestore(&hid_output_lat.lock, flags);
+
+	seq_printf(m, "count: %llu\n", count);
+	seq_printf(m, "avg_ns: %llu\n", count ? div64_u64(total, count) : 0);
+	seq_printf(m, "max_ns: %llu\n", max);
+	for (i = 0; i < HID_OUTPUT_LAT_BUCKETS; i++)
+		seq_printf(m, "%s%5u us: %llu\n",
+			   i == HID_OUTPUT_LAT_BUCKETS - 1 ? ">=" : "< ",
+			   i == HID_OUTPUT_LAT_BUCKETS - 1 ? 1U << i : 2U << i,
+			   hist[i]);
+}
+#endif
+
 /*
  * Set a field value. The report this field belongs to has to be
  * created and transferred to the device, to set this value in the
@@ -1713,12 +2380,18 @@ int __hid_request(struct hid_device *hid, struct hid_report *report,
 	int ret;
 	u32 len;
 
-	buf = hid_alloc_report_buf(report, GFP_KERNEL);
-	if (!buf)
-		return -ENOMEM;
-
 	len = hid_report_len(report);
 
+	/* same 7 extra bytes as hid_alloc_report_buf() */
+	if (len + 7 <= hid->request_buf_size &&
+	    !test_and_set_bit_lock(0, &hid->request_buf_busy)) {
+		buf = hid->request_buf;
+	} else {
+		buf = hid_alloc_report_buf(report, GFP_KERNEL);
+		if (!buf)
+			return -ENOMEM;
+	}
+
 	if (reqtype == HID_REQ_SET_REPORT)
 		hid_output_report(report, buf);
 
@@ -1735,7 +2408,10 @@ int __hid_request(struct hid_device *hid, struct hid_report *report,
 	ret = 0;
 
 out:
-	kfree(buf);
+	if (buf == hid->request_buf)
+		clear_bit_unlock(0, &hid->request_buf_busy);
+	else
+		kfree(buf);
 	return ret;
 }
 EXPORT_SYMBOL_GPL(__hid_request);
@@ -1776,6 +2452,7 @@ int hid_report_raw_event(struct hid_device *hid, int type, u8 *data, u32 size,
 	if ((hid->claimed & HID_CLAIMED_HIDDEV) && hid->hiddev_report_event)
 		hid->hiddev_report_event(hid, report);
 	if (hid->claimed & HID_CLAIMED_HIDRAW) {
+		trace_hid_hidraw_report(hid, hid->input_seq, type, data, size);
 		ret = hidraw_report_event(hid, data, size);
 		if (ret)
 			goto out;
@@ -1796,36 +2473,26 @@ int hid_report_raw_event(struct hid_device *hid, int type, u8 *data, u32 size,
 }
 EXPORT_SYMBOL_GPL(hid_report_raw_event);
 
-/**
- * hid_input_report - report data from lower layer (usb, bt...)
- *
- * @hid: hid device
- * @type: HID report type (HID_*_REPORT)
- * @data: report contents
- * @size: size of data parameter
- * @interrupt: distinguish between interrupt and control transfers
- *
- * This is data entry for lower layers.
- */
-int hid_input_report(struct hid_device *hid, int type, u8 *data, u32 size, int interrupt)
+static int __hid_input_report(struct hid_device *hid, int type, u8 *data,
+			      u32 size, int interrupt)
 {
 	struct hid_report_enum *report_enum;
 	struct hid_driver *hdrv;
 	struct hid_report *report;
 	int ret = 0;
 
-	if (!hid)
-		return -ENODEV;
+	trace_hid_input_report(hid, ++hid->input_seq, type, data, size);
+	trace_fixed(TRACE_FIXED_HID_REPORT, hid->vendor << 16 | hid->product,
+		    hid->input_seq, type, size);
 
-	if (down_trylock(&hid->driver_input_lock))
-		return -EBUSY;
+	rcu_read_lock();
 
-	if (!hid->driver) {
+	hdrv = rcu_dereference(hid->input_driver);
+	if (!hdrv) {
 		ret = -ENODEV;
 		goto unlock;
 	}
 	report_enum = hid->report_enum + type;
-	hdrv = hid->driver;
 
 	if (!size) {
 		dbg_hid("empty report\n");
@@ -1833,6 +2500,9 @@ int hid_input_report(struct hid_device *hid, int type, u8 *data, u32 size, int i
 		goto unlock;
 	}
 
+	if (!hid_bpf_run_report(hid, type, data, size))
+		goto unlock;
+
 	/* Avoid unnecessary overhead if debugfs is disabled */
 	if (!list_empty(&hid->debug_list))
 		hid_dump_report(hid, type, data, size);
@@ -1844,20 +2514,252 @@ int hid_input_report(struct hid_device *hid, int type, u8 *data, u32 size, int i
 		goto unlock;
 	}
 
-	if (hdrv && hdrv->raw_event && hid_match_report(hid, report)) {
+	if (hdrv->raw_event && hid_match_report(hid, report)) {
+		trace_hid_raw_event(hid, hid->input_seq, type, data, size);
 		ret = hdrv->raw_event(hid, report, data, size);
 		if (ret < 0)
 			goto unlock;
+		if (ret == HID_RAW_EVENT_CONSUMED) {
+			ret = 0;
+			if (hid->claimed & HID_CLAIMED_HIDRAW) {
+				trace_hid_hidraw_report(hid, hid->input_seq,
+							type, data, size);
+				ret = hidraw_report_event(hid, data, size);
+			}
+			goto unlock;
+		}
 	}
 
 	ret = hid_report_raw_event(hid, type, data, size, interrupt);
 
 unlock:
-	up(&hid->driver_input_lock);
+	trace_hid_report_done(hid, hid->input_seq, type, data, size);
+	rcu_read_unlock();
 	return ret;
 }
+
+static int hid_process_report(struct hid_device *hid, int type, u8 *data,
+			      u32 size, int interrupt, ktime_t time)
+{
+	int ret;
+
+	/*
+	 * The fields, the driver and hid-input keep per report state, so
+	 * the reports of a device are processed one at a time. As with the
+	 * trylock of driver_input_lock this replaces, one coming in while
+	 * another is processed is dropped.
+	 */
+	if (test_and_set_bit_lock(0, &hid->input_busy))
+		return -EBUSY;
+
+	hid->input_time = time;
+	ret = __hid_input_report(hid, type, data, size, interrupt);
+	hid->input_time = 0;
+
+	clear_bit_unlock(0, &hid->input_busy);
+
+	return ret;
+}
+
+#ifdef CONFIG_SMP
+/*
+ * Report steering: with steer_cpu set, the interrupt reports of a device are
+ * copied to a lock-free queue of the chosen CPU and processed there from an
+ * irq_work, so that a busy CPU taking the interrupt does not also run the
+ * parsing and the wakeup of the readers. HID_STEER_READER picks the CPU the
+ * last hidraw reader ran on.
+ *
+ * Reports of a device must not be processed concurrently or out of order.
+ * So as long as some are in flight, all reports, control ones included, go
+ * to the queue these were queued to, whatever steer_cpu says meanwhile.
+ */
+struct hid_steer_queue {
+	struct llist_head reports;
+	struct irq_work work;
+};
+
+struct hid_steer_report {
+	struct llist_node node;
+	struct hid_device *hid;
+	ktime_t time;
+	int type;
+	int interrupt;
+	u32 size;
+	u8 data[];
+};
+
+static DEFINE_PER_CPU(struct hid_steer_queue, hid_steer_queues);
+
+static void hid_steer_run(struct irq_work *work)
+{
+	struct hid_steer_queue *q = container_of(work, struct hid_steer_queue,
+						 work);
+	struct hid_steer_report *r, *tmp;
+	struct llist_node *reports;
+
+	reports = llist_reverse_order(llist_del_all(&q->reports));
+	llist_for_each_entry_safe(r, tmp, reports, node) {
+		struct hid_device *hid = r->hid;
+
+		hid_process_report(hid, r->type, r->data, r->size,
+				   r->interrupt, r->time);
+		kfree(r);
+		if (atomic_dec_and_test(&hid->steer_inflight))
+			wake_up_var(&hid->steer_inflight);
+	}
+}
+
+/* Returns true if the report was queued, or has to be dropped. */
+static bool hid_steer(struct hid_device *hid, int type, u8 *data, u32 size,
+		      int interrupt, ktime_t time)
+{
+	bool inflight = atomic_read_acquire(&hid->steer_inflight);
+	struct hid_steer_report *r;
+	struct hid_report *report;
+	struct hid_steer_queue *q;
+	bool queued = inflight;
+	u32 len = size;
+	int cpu;
+
+	if (inflight)
+		cpu = hid->steer_queued_cpu;
+	else if (!interrupt)
+		return false;
+	else if ((cpu = READ_ONCE(hid->steer_cpu)) == HID_STEER_READER)
+		cpu = hidraw_reader_cpu(hid);
+
+	if (cpu < 0)
+		return false;
+
+	/* holds off the CPU going down, which runs what is queued to it */
+	preempt_disable();
+	if (!cpu_online(cpu)) {
+		queued = false;
+		goto out;
+	}
+
+	/* hid_report_raw_event() pads short reports up to their size */
+	report = size ? hid_get_report(hid->report_enum + type, data) : NULL;
+	if (report)
+		len = max_t(u32, size, min_t(u32, hid_report_len(report),
+						     HID_MAX_BUFFER_SIZE));
+
+	r = kmalloc(struct_size(r, data, len), GFP_ATOMIC);
+	if (!r)
+		goto out;
+	r->hid = hid;
+	/* the events still get the time the report came in */
+	r->time = time ?: ktime_get();
+	r->type = type;
+	r->interrupt = interrupt;
+	r->size = size;
+	memcpy(r->data, data, size);
+	memset(r->data + size, 0, len - size);
+
+	hid->steer_queued_cpu = cpu;
+	atomic_inc(&hid->steer_inflight);
+	q = per_cpu_ptr(&hid_steer_queues, cpu);
+	if (llist_add(&r->node, &q->reports))
+		irq_work_queue_on(&q->work, cpu);
+	queued = true;
+out:
+	preempt_enable();
+	return queued;
+}
+
+/* Wait for the reports queued for @hdev, which point at it, to be done. */
+static void hid_steer_drain(struct hid_device *hdev)
+{
+	wait_var_event(&hdev->steer_inflight,
+		       !atomic_read(&hdev->steer_inflight));
+}
+
+static void hid_steer_init(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct hid_steer_queue *q = per_cpu_ptr(&hid_steer_queues, cpu);
+
+		init_llist_head(&q->reports);
+		init_irq_work(&q->work, hid_steer_run);
+	}
+}
+
+static void hid_steer_exit(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		irq_work_sync(&per_cpu_ptr(&hid_steer_queues, cpu)->work);
+}
+#else
+static bool hid_steer(struct hid_device *hid, int type, u8 *data, u32 size,
+		      int interrupt, ktime_t time)
+{
+	return false;
+}
+
+static void hid_steer_drain(struct hid_device *hdev) { }
+static void hid_steer_init(void) { }
+static void hid_steer_exit(void) { }
+#endif /* CONFIG_SMP */
+
+/**
+ * hid_input_report - report data from lower layer (usb, bt...)
+ *
+ * @hid: hid device
+ * @type: HID report type (HID_*_REPORT)
+ * @data: report contents
+ * @size: size of data parameter
+ * @interrupt: distinguish between interrupt and control transfers
+ *
+ * This is data entry for lower layers. The driver is only looked up under
+ * RCU, so it may be called from any context. Reports are dropped with
+ * -ENODEV until the driver is bound or calls hid_device_io_start(), and
+ * with -EBUSY while another report of the same device is being processed.
+ * With report steering set up for the device, the report may be processed
+ * later on another CPU, and 0 is returned.
+ */
+int hid_input_report(struct hid_device *hid, int type, u8 *data, u32 size, int interrupt)
+{
+	if (!hid)
+		return -ENODEV;
+
+	if (hid_steer(hid, type, data, size, interrupt, 0))
+		return 0;
+
+	return hid_process_report(hid, type, data, size, interrupt, 0);
+}
 EXPORT_SYMBOL_GPL(hid_input_report);
 
+/**
+ * hid_input_report_time - report data from lower layer with its sample time
+ *
+ * @hid: hid device
+ * @type: HID report type (HID_*_REPORT)
+ * @data: report contents
+ * @size: size of data parameter
+ * @interrupt: distinguish between interrupt and control transfers
+ * @time: CLOCK_MONOTONIC time at which the report was sampled
+ *
+ * Like hid_input_report(), but input events and hidraw readers see @time
+ * instead of the time the report reached the HID core. Transports that add
+ * latency of their own use this so consumers can correct for it.
+ */
+int hid_input_report_time(struct hid_device *hid, int type, u8 *data, u32 size,
+			  int interrupt, ktime_t time)
+{
+	if (!hid)
+		return -ENODEV;
+
+	if (hid_steer(hid, type, data, size, interrupt, time))
+		return 0;
+
+	return hid_process_report(hid, type, data, size, interrupt, time);
+}
+EXPORT_SYMBOL_GPL(hid_input_report_time);
+
 bool hid_match_one_id(const struct hid_device *hdev,
 		      const struct hid_device_id *id)
 {
@@ -1928,6 +2830,33 @@ static const struct device_attribute dev_attr_country = {
 	.show = show_country,
 };
 
+/*
+ * Allocate the buffer __hid_request() uses, big enough for any report of
+ * the device, so that polling or setting reports does not allocate. Not
+ * having it is not fatal.
+ */
+static void hid_alloc_request_buf(struct hid_device *hdev)
+{
+	struct hid_report *report;
+	unsigned int type;
+	u32 size = 0;
+
+	if (hdev->request_buf)
+		return;
+
+	for (type = HID_INPUT_REPORT; type < HID_REPORT_TYPES; type++)
+		list_for_each_entry(report, &hdev->report_enum[type].report_list,
+				    list)
+			size = max(size, hid_report_len(report) + 7);
+
+	if (!size || size > HID_MAX_BUFFER_SIZE)
+		return;
+
+	hdev->request_buf = kmalloc(size, GFP_KERNEL);
+	if (hdev->request_buf)
+		hdev->request_buf_size = size;
+}
+
 int hid_connect(struct hid_device *hdev, unsigned int connect_mask)
 {
 	static const char *types[] = { "Device", "Pointer", "Mouse", "Device",
@@ -1940,6 +2869,8 @@ int hid_connect(struct hid_device *hdev, unsigned int connect_mask)
 	int len;
 	int ret;
 
+	hid_alloc_request_buf(hdev);
+
 	if (hdev->quirks & HID_QUIRK_HIDDEV_FORCE)
 		connect_mask |= (HID_CONNECT_HIDDEV_FORCE | HID_CONNECT_HIDDEV);
 	if (hdev->quirks & HID_QUIRK_HIDINPUT_FORCE)
@@ -2241,6 +3172,16 @@ bool hid_compare_device_paths(struct hid_device *hdev_a,
 }
 EXPORT_SYMBOL_GPL(hid_compare_device_paths);
 
+/*
+ * Stop delivering input to the driver, and wait for the reports already
+ * being processed. Called with driver_input_lock held.
+ */
+static void hid_device_stop_input(struct hid_device *hdev)
+{
+	if (hdev->io_started)
+		hid_device_io_stop(hdev);
+}
+
 static int hid_device_probe(struct device *dev)
 {
 	struct hid_driver *hdrv = to_hid_driver(dev->driver);
@@ -2252,7 +3193,6 @@ static int hid_device_probe(struct device *dev)
 		ret = -EINTR;
 		goto end;
 	}
-	hdev->io_started = false;
 
 	clear_bit(ffs(HID_STAT_REPROBED), &hdev->status);
 
@@ -2291,13 +3231,16 @@ static int hid_device_probe(struct device *dev)
 				ret = hid_hw_start(hdev, HID_CONNECT_DEFAULT);
 		}
 		if (ret) {
+			hid_device_stop_input(hdev);
 			hid_close_report(hdev);
 			hdev->driver = NULL;
+		} else {
+			hdev->io_started = true;
+			rcu_assign_pointer(hdev->input_driver, hdrv);
 		}
 	}
 unlock:
-	if (!hdev->io_started)
-		up(&hdev->driver_input_lock);
+	up(&hdev->driver_input_lock);
 end:
 	return ret;
 }
@@ -2308,7 +3251,7 @@ static void hid_device_remove(struct device *dev)
 	struct hid_driver *hdrv;
 
 	down(&hdev->driver_input_lock);
-	hdev->io_started = false;
+	hid_device_stop_input(hdev);
 
 	hdrv = hdev->driver;
 	if (hdrv) {
@@ -2316,12 +3259,12 @@ static void hid_device_remove(struct device *dev)
 			hdrv->remove(hdev);
 		else /* default remove */
 			hid_hw_stop(hdev);
+		hid_device_stop_input(hdev);
 		hid_close_report(hdev);
 		hdev->driver = NULL;
 	}
 
-	if (!hdev->io_started)
-		up(&hdev->driver_input_lock);
+	up(&hdev->driver_input_lock);
 }
 
 static ssize_t modalias_show(struct device *dev, struct device_attribute *a,
@@ -2334,8 +3277,53 @@ static ssize_t modalias_show(struct device *dev, struct device_attribute *a,
 }
 static DEVICE_ATTR_RO(modalias);
 
+#ifdef CONFIG_SMP
+static ssize_t steer_cpu_show(struct device *dev, struct device_attribute *a,
+			      char *buf)
+{
+	struct hid_device *hdev = to_hid_device(dev);
+	int cpu = READ_ONCE(hdev->steer_cpu);
+
+	if (cpu == HID_STEER_OFF)
+		return sysfs_emit(buf, "off\n");
+	if (cpu == HID_STEER_READER)
+		return sysfs_emit(buf, "reader\n");
+	return sysfs_emit(buf, "%d\n", cpu);
+}
+
+static ssize_t steer_cpu_store(struct device *dev, struct device_attribute *a,
+			       const char *buf, size_t count)
+{
+	struct hid_device *hdev = to_hid_device(dev);
+	unsigned int cpu;
+	int ret;
+
+	if (sysfs_streq(buf, "off")) {
+		WRITE_ONCE(hdev->steer_cpu, HID_STEER_OFF);
+		return count;
+	}
+	if (sysfs_streq(buf, "reader")) {
+		WRITE_ONCE(hdev->steer_cpu, HID_STEER_READER);
+		return count;
+	}
+
+	ret = kstrtouint(buf, 0, &cpu);
+	if (ret)
+		return ret;
+	if (cpu >= nr_cpu_ids || !cpu_possible(cpu))
+		return -EINVAL;
+
+	WRITE_ONCE(hdev->steer_cpu, cpu);
+	return count;
+}
+static DEVICE_ATTR_RW(steer_cpu);
+#endif
+
 static struct attribute *hid_dev_attrs[] = {
 	&dev_attr_modalias.attr,
+#ifdef CONFIG_SMP
+	&dev_attr_steer_cpu.attr,
+#endif
 	NULL,
 };
 static struct bin_attribute *hid_dev_bin_attrs[] = {
@@ -2474,6 +3462,7 @@ struct hid_device *hid_allocate_device(void)
 	spin_lock_init(&hdev->debug_list_lock);
 	sema_init(&hdev->driver_input_lock, 1);
 	mutex_init(&hdev->ll_open_lock);
+	hdev->steer_cpu = HID_STEER_OFF;
 
 	return hdev;
 }
@@ -2502,6 +3491,7 @@ static void hid_remove_device(struct hid_device *hdev)
 void hid_destroy_device(struct hid_device *hdev)
 {
 	hid_remove_device(hdev);
+	hid_steer_drain(hdev);
 	put_device(&hdev->dev);
 }
 EXPORT_SYMBOL_GPL(hid_destroy_device);
@@ -2601,13 +3591,27 @@ static int __init hid_init(void)
 		goto err;
 	}
 
+	/*
+	 * WQ_SYSFS exposes cpumask and nice under
+	 * /sys/devices/virtual/workqueue/hid_output.
+	 */
+	hid_output_wq = alloc_workqueue("hid_output",
+					WQ_UNBOUND | WQ_HIGHPRI | WQ_SYSFS, 0);
+	if (!hid_output_wq) {
+		ret = -ENOMEM;
+		goto err_bus;
+	}
+
 	ret = hidraw_init();
 	if (ret)
-		goto err_bus;
+		goto err_wq;
 
+	hid_steer_init();
 	hid_debug_init();
 
 	return 0;
+err_wq:
+	destroy_workqueue(hid_output_wq);
 err_bus:
 	bus_unregister(&hid_bus_type);
 err:
@@ -2618,8 +3622,11 @@ static void __exit hid_exit(void)
 {
 	hid_debug_exit();
 	hidraw_exit();
+	hid_steer_exit();
+	destroy_workqueue(hid_output_wq);
 	bus_unregister(&hid_bus_type);
 	hid_quirks_exit(HID_BUS_ANY);
+	hid_rdesc_cache_flush();
 }
 
 module_init(hid_init);
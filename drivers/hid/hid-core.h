@@ -0,0 +1,40 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * HID core internals, shared with the HID core KUnit tests
+ */
+
+#ifndef __HID_CORE_H
+#define __HID_CORE_H
+
+#include <linux/hid.h>
+
+/* how hid_input_field() fetches the values of a field */
+enum hid_field_extract {
+	HID_EXTRACT_GENERIC,
+	HID_EXTRACT_BITS,
+	HID_EXTRACT_8,
+	HID_EXTRACT_16,
+	HID_EXTRACT_32,
+};
+
+#if IS_ENABLED(CONFIG_HID_KUNIT_TEST)
+#define HID_VISIBLE_IF_KUNIT
+#define HID_EXPORT_SYMBOL_IF_KUNIT(sym)	EXPORT_SYMBOL_GPL(sym)
+
+extern unsigned long hid_rdesc_cache_hits;
+
+struct hid_field *hid_register_field(struct hid_report *report, unsigned usages,
+				     unsigned flags);
+void hid_close_report(struct hid_device *device);
+void hid_plan_extraction(struct hid_device *device);
+size_t hid_rdesc_cache_limit(void);
+void implement(const struct hid_device *hid, u8 *report,
+	       unsigned offset, unsigned n, u32 value);
+void hid_input_field(struct hid_device *hid, struct hid_field *field,
+		     __u8 *data, int interrupt);
+#else
+#define HID_VISIBLE_IF_KUNIT		static
+#define HID_EXPORT_SYMBOL_IF_KUNIT(sym)
+#endif
+
+#endif
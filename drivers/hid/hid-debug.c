@@ -19,6 +19,7 @@
 #include <linux/debugfs.h>
 #include <linux/seq_file.h>
 #include <linux/kfifo.h>
+#include <linux/ktime.h>
 #include <linux/sched/signal.h>
 #include <linux/export.h>
 #include <linux/slab.h>
@@ -649,68 +650,119 @@ void hid_dump_device(struct hid_device *device, struct seq_file *f)
 }
 EXPORT_SYMBOL_GPL(hid_dump_device);
 
-/* enqueue string to 'events' ring buffer */
-void hid_debug_event(struct hid_device *hdev, char *buf)
+/*
+ * Enqueue a record to the 'events' ring buffer of every reader. This runs
+ * in the report path, so the record is only copied: it is formatted when
+ * read. A record which does not fit is dropped as a whole.
+ */
+static void hid_debug_queue(struct hid_device *hdev,
+			    struct hid_debug_record *rec, const void *payload)
 {
 	struct hid_debug_list *list;
 	unsigned long flags;
 
+	rec->time = ktime_get_ns();
+
 	spin_lock_irqsave(&hdev->debug_list_lock, flags);
-	list_for_each_entry(list, &hdev->debug_list, node)
-		kfifo_in(&list->hid_debug_fifo, buf, strlen(buf));
+	list_for_each_entry(list, &hdev->debug_list, node) {
+		if (kfifo_avail(&list->hid_debug_fifo) < sizeof(*rec) + rec->len)
+			continue;
+		kfifo_in(&list->hid_debug_fifo, (char *)rec, sizeof(*rec));
+		kfifo_in(&list->hid_debug_fifo, payload, rec->len);
+	}
 	spin_unlock_irqrestore(&hdev->debug_list_lock, flags);
 
 	wake_up_interruptible(&hdev->debug_wait);
 }
+
+/* enqueue string to 'events' ring buffer */
+void hid_debug_event(struct hid_device *hdev, char *buf)
+{
+	struct hid_debug_record rec = { .kind = HID_DEBUG_TEXT };
+
+	rec.size = strlen(buf);
+	rec.len = min_t(unsigned int, rec.size, HID_DEBUG_PAYLOAD_MAX);
+	hid_debug_queue(hdev, &rec, buf);
+}
 EXPORT_SYMBOL_GPL(hid_debug_event);
 
 void hid_dump_report(struct hid_device *hid, int type, u8 *data,
 		int size)
 {
-	struct hid_report_enum *report_enum;
-	char *buf;
-	unsigned int i;
-
-	buf = kmalloc(HID_DEBUG_BUFSIZE, GFP_ATOMIC);
-
-	if (!buf)
-		return;
-
-	report_enum = hid->report_enum + type;
-
-	/* dump the report */
-	snprintf(buf, HID_DEBUG_BUFSIZE - 1,
-			"\nreport (size %u) (%snumbered) = ", size,
-			report_enum->numbered ? "" : "un");
-	hid_debug_event(hid, buf);
-
-	for (i = 0; i < size; i++) {
-		snprintf(buf, HID_DEBUG_BUFSIZE - 1,
-				" %02x", data[i]);
-		hid_debug_event(hid, buf);
-	}
-	hid_debug_event(hid, "\n");
-	kfree(buf);
+	struct hid_debug_record rec = {
+		.kind = HID_DEBUG_REPORT,
+		.type = type,
+		.size = size,
+		.len = min(size, HID_DEBUG_PAYLOAD_MAX),
+	};
+
+	hid_debug_queue(hid, &rec, data);
 }
 EXPORT_SYMBOL_GPL(hid_dump_report);
 
 void hid_dump_input(struct hid_device *hdev, struct hid_usage *usage, __s32 value)
 {
+	struct hid_debug_record rec = {
+		.kind = HID_DEBUG_INPUT,
+		.usage = usage->hid,
+		.value = value,
+	};
+
+	hid_debug_queue(hdev, &rec, NULL);
+}
+EXPORT_SYMBOL_GPL(hid_dump_input);
+
+/*
+ * Dequeue the next record and format it to list->text, as the events used
+ * to be formatted when they were queued as text.
+ */
+static bool hid_debug_format_record(struct hid_debug_list *list)
+{
+	struct hid_device *hdev = list->hdev;
+	struct hid_debug_record rec;
+	char *text = list->text;
+	unsigned int i, len = 0;
 	char *buf;
-	int len;
 
-	buf = hid_resolv_usage(usage->hid, NULL);
-	if (!buf)
-		return;
-	len = strlen(buf);
-	snprintf(buf + len, HID_DEBUG_BUFSIZE - len - 1, " = %d\n", value);
+	if (kfifo_out(&list->hid_debug_fifo, (char *)&rec, sizeof(rec)) != sizeof(rec))
+		return false;
+	if (kfifo_out(&list->hid_debug_fifo, list->payload, rec.len) != rec.len)
+		return false;
+
+	switch (rec.kind) {
+	case HID_DEBUG_TEXT:
+		memcpy(text, list->payload, rec.len);
+		len = rec.len;
+		break;
+	case HID_DEBUG_REPORT:
+		len = scnprintf(text, HID_DEBUG_TEXTSIZE,
+				"\nreport (size %u) (%snumbered) = ", rec.size,
+				hdev->report_enum[rec.type].numbered ? "" : "un");
+		for (i = 0; i < rec.len; i++)
+			len += scnprintf(text + len, HID_DEBUG_TEXTSIZE - len,
+					 " %02x", list->payload[i]);
+		len += scnprintf(text + len, HID_DEBUG_TEXTSIZE - len, "\n");
+		break;
+	case HID_DEBUG_INPUT:
+		buf = hid_resolv_usage(rec.usage, NULL);
+		if (!buf)
+			break;
+		len = scnprintf(text, HID_DEBUG_TEXTSIZE, "%s = %d\n",
+				buf, rec.value);
+		kfree(buf);
+		break;
+	}
 
-	hid_debug_event(hdev, buf);
+	list->text_len = len;
+	list->text_pos = 0;
+	return true;
+}
 
-	kfree(buf);
-	wake_up_interruptible(&hdev->debug_wait);
+static bool hid_debug_list_empty(struct hid_debug_list *list)
+{
+	return list->text_pos == list->text_len &&
+	       kfifo_is_empty(&list->hid_debug_fifo);
 }
-EXPORT_SYMBOL_GPL(hid_dump_input);
 
 static const char *events[EV_MAX + 1] = {
 	[EV_SYN] = "Sync",			[EV_KEY] = "Key",
@@ -1086,8 +1138,17 @@ static int hid_debug_events_open(struct inode *inode, struct file *file)
 		goto out;
 	}
 
+	list->text = kmalloc(HID_DEBUG_TEXTSIZE + HID_DEBUG_PAYLOAD_MAX, GFP_KERNEL);
+	if (!list->text) {
+		kfree(list);
+		err = -ENOMEM;
+		goto out;
+	}
+	list->payload = list->text + HID_DEBUG_TEXTSIZE;
+
 	err = kfifo_alloc(&list->hid_debug_fifo, HID_DEBUG_FIFOSIZE, GFP_KERNEL);
 	if (err) {
+		kfree(list->text);
 		kfree(list);
 		goto out;
 	}
@@ -1103,19 +1164,18 @@ static int hid_debug_events_open(struct inode *inode, struct file *file)
 	return err;
 }
 
-static ssize_t hid_debug_events_read(struct file *file, char __user *buffer,
-		size_t count, loff_t *ppos)
+/* wait for events, called with list->read_mutex held */
+static int hid_debug_events_wait(struct file *file,
+				 struct hid_debug_list *list)
 {
-	struct hid_debug_list *list = file->private_data;
-	int ret = 0, copied;
+	int ret = 0;
 	DECLARE_WAITQUEUE(wait, current);
 
-	mutex_lock(&list->read_mutex);
-	if (kfifo_is_empty(&list->hid_debug_fifo)) {
+	if (hid_debug_list_empty(list)) {
 		add_wait_queue(&list->hdev->debug_wait, &wait);
 		set_current_state(TASK_INTERRUPTIBLE);
 
-		while (kfifo_is_empty(&list->hid_debug_fifo)) {
+		while (hid_debug_list_empty(list)) {
 			if (signal_pending(current)) {
 				ret = -ERESTARTSYS;
 				break;
@@ -1127,9 +1187,8 @@ static ssize_t hid_debug_events_read(struct file *file, char __user *buffer,
 			 * if we add remove_wait_queue() here we can hit a race.
 			 */
 			if (!list->hdev || !list->hdev->debug) {
-				ret = -EIO;
 				set_current_state(TASK_RUNNING);
-				goto out;
+				return -EIO;
 			}
 
 			if (file->f_flags & O_NONBLOCK) {
@@ -1146,18 +1205,80 @@ static ssize_t hid_debug_events_read(struct file *file, char __user *buffer,
 
 		__set_current_state(TASK_RUNNING);
 		remove_wait_queue(&list->hdev->debug_wait, &wait);
+	}
 
-		if (ret)
+	return ret;
+}
+
+static ssize_t hid_debug_events_read(struct file *file, char __user *buffer,
+		size_t count, loff_t *ppos)
+{
+	struct hid_debug_list *list = file->private_data;
+	unsigned int len;
+	size_t copied = 0;
+	int ret;
+
+	mutex_lock(&list->read_mutex);
+	ret = hid_debug_events_wait(file, list);
+	if (ret)
+		goto out;
+
+	/* format the records as they are passed to userspace, locking is not
+	 * needed with only one concurrent reader and one concurrent writer
+	 */
+	while (copied < count) {
+		if (list->text_pos == list->text_len &&
+		    !hid_debug_format_record(list))
+			break;
+
+		len = min_t(size_t, count - copied,
+			    list->text_len - list->text_pos);
+		if (copy_to_user(buffer + copied, list->text + list->text_pos, len)) {
+			ret = -EFAULT;
 			goto out;
+		}
+		list->text_pos += len;
+		copied += len;
 	}
+	ret = copied;
+out:
+	mutex_unlock(&list->read_mutex);
+	return ret;
+}
 
-	/* pass the fifo content to userspace, locking is not needed with only
-	 * one concurrent reader and one concurrent writer
-	 */
-	ret = kfifo_to_user(&list->hid_debug_fifo, buffer, count, &copied);
+/*
+ * Pass whole struct hid_debug_record records, each followed by its payload,
+ * to userspace.
+ */
+static ssize_t hid_debug_events_raw_read(struct file *file, char __user *buffer,
+		size_t count, loff_t *ppos)
+{
+	struct hid_debug_list *list = file->private_data;
+	struct hid_debug_record rec;
+	unsigned int len, copied;
+	size_t total = 0;
+	int ret;
+
+	mutex_lock(&list->read_mutex);
+	ret = hid_debug_events_wait(file, list);
 	if (ret)
 		goto out;
-	ret = copied;
+
+	while (kfifo_out_peek(&list->hid_debug_fifo, (char *)&rec,
+			      sizeof(rec)) == sizeof(rec)) {
+		len = sizeof(rec) + rec.len;
+		if (total + len > count)
+			break;
+
+		ret = kfifo_to_user(&list->hid_debug_fifo, buffer + total, len,
+				    &copied);
+		if (ret)
+			goto out;
+		total += copied;
+	}
+
+	/* the buffer cannot hold a single record */
+	ret = total ? total : -EINVAL;
 out:
 	mutex_unlock(&list->read_mutex);
 	return ret;
@@ -1168,7 +1289,7 @@ static __poll_t hid_debug_events_poll(struct file *file, poll_table *wait)
 	struct hid_debug_list *list = file->private_data;
 
 	poll_wait(file, &list->hdev->debug_wait, wait);
-	if (!kfifo_is_empty(&list->hid_debug_fifo))
+	if (!hid_debug_list_empty(list))
 		return EPOLLIN | EPOLLRDNORM;
 	if (!list->hdev->debug)
 		return EPOLLERR | EPOLLHUP;
@@ -1184,6 +1305,7 @@ static int hid_debug_events_release(struct inode *inode, struct file *file)
 	list_del(&list->node);
 	spin_unlock_irqrestore(&list->hdev->debug_list_lock, flags);
 	kfifo_free(&list->hid_debug_fifo);
+	kfree(list->text);
 	kfree(list);
 
 	return 0;
@@ -1200,6 +1322,15 @@ static const struct file_operations hid_debug_events_fops = {
 	.llseek		= noop_llseek,
 };
 
+static const struct file_operations hid_debug_events_raw_fops = {
+	.owner =        THIS_MODULE,
+	.open           = hid_debug_events_open,
+	.read           = hid_debug_events_raw_read,
+	.poll		= hid_debug_events_poll,
+	.release        = hid_debug_events_release,
+	.llseek		= noop_llseek,
+};
+
 
 void hid_debug_register(struct hid_device *hdev, const char *name)
 {
@@ -1208,6 +1339,10 @@ void hid_debug_register(struct hid_device *hdev, const char *name)
 			hdev->debug_dir, hdev, &hid_debug_rdesc_fops);
 	hdev->debug_events = debugfs_create_file("events", 0400,
 			hdev->debug_dir, hdev, &hid_debug_events_fops);
+	hdev->debug_events_raw = debugfs_create_file("events_raw", 0400,
+			hdev->debug_dir, hdev, &hid_debug_events_raw_fops);
+	debugfs_create_atomic_t("log_dropped", 0400, hdev->debug_dir,
+				&hdev->log_dropped);
 	hdev->debug = 1;
 }
 
@@ -1217,12 +1352,31 @@ void hid_debug_unregister(struct hid_device *hdev)
 	wake_up_interruptible(&hdev->debug_wait);
 	debugfs_remove(hdev->debug_rdesc);
 	debugfs_remove(hdev->debug_events);
+	debugfs_remove(hdev->debug_events_raw);
 	debugfs_remove(hdev->debug_dir);
 }
 
+static int hid_output_latency_seq_show(struct seq_file *m, void *unused)
+{
+	hid_output_latency_show(m);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(hid_output_latency_seq);
+
+static int hid_rdesc_cache_seq_show(struct seq_file *m, void *unused)
+{
+	hid_rdesc_cache_show(m);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(hid_rdesc_cache_seq);
+
 void hid_debug_init(void)
 {
 	hid_debug_root = debugfs_create_dir("hid", NULL);
+	debugfs_create_file("output_latency", 0400, hid_debug_root, NULL,
+			    &hid_output_latency_seq_fops);
+	debugfs_create_file("rdesc_cache", 0400, hid_debug_root, NULL,
+			    &hid_rdesc_cache_seq_fops);
 }
 
 void hid_debug_exit(void)
@@ -16,6 +16,10 @@
 #include <linux/module.h>
 #include <linux/slab.h>
 #include <linux/kernel.h>
+#include <linux/hash.h>
+#include <linux/log2.h>
+#include <linux/mm.h>
+#include <linux/spinlock.h>
 
 #include <linux/hid.h>
 #include <linux/hid-debug.h>
@@ -111,6 +115,134 @@ static struct hid_usage *hidinput_find_key(struct hid_device *hid,
 	return NULL;
 }
 
+/*
+ * The usages hidinput_find_key() walks, by index, with a hash table of
+ * their scancodes and the number of EV_KEY usages mapped to each keycode,
+ * so that the EVIOCGKEYCODE and EVIOCSKEYCODE storms of udev remapping a
+ * keyboard don't walk all the reports for every key. Built once the
+ * usages are mapped in hidinput_connect(), until then the lookups walk
+ * the reports.
+ */
+struct hid_keymap {
+	spinlock_t lock;		/* serializes the remaps of all inputs */
+	unsigned int count;
+	unsigned int hash_bits;
+	u32 *heads;			/* first index of each scancode bucket */
+	u32 *next;			/* next index in the same bucket */
+	unsigned int key_users[KEY_CNT];
+	struct hid_usage *usage[];
+};
+
+#define HID_KEYMAP_END	U32_MAX
+
+static u32 hidinput_scancode(const struct hid_usage *usage)
+{
+	return usage->hid & (HID_USAGE_PAGE | HID_USAGE);
+}
+
+/* Count the usages of the keymap, storing them in @usage if not NULL. */
+static unsigned int hidinput_collect_keys(struct hid_device *hid,
+					  struct hid_usage **usage)
+{
+	unsigned int i, j, k, count = 0;
+	struct hid_report *report;
+	struct hid_field *field;
+
+	for (k = HID_INPUT_REPORT; k <= HID_OUTPUT_REPORT; k++) {
+		list_for_each_entry(report, &hid->report_enum[k].report_list, list) {
+			for (i = 0; i < report->maxfield; i++) {
+				field = report->field[i];
+				for (j = 0; j < field->maxusage; j++) {
+					if (field->usage[j].type != EV_KEY &&
+					    field->usage[j].type != 0)
+						continue;
+					if (usage)
+						usage[count] = field->usage + j;
+					count++;
+				}
+			}
+		}
+	}
+
+	return count;
+}
+
+static void hidinput_build_keymap(struct hid_device *hid)
+{
+	struct hid_keymap *km;
+	struct hid_usage *usage;
+	unsigned int count, buckets, bits, i;
+	u32 hash;
+
+	count = hidinput_collect_keys(hid, NULL);
+	if (!count)
+		return;
+
+	bits = max(order_base_2(count), 1);
+	buckets = 1U << bits;
+
+	km = kvzalloc(struct_size(km, usage, count) +
+		      (count + buckets) * sizeof(u32), GFP_KERNEL);
+	if (!km)
+		return;
+
+	spin_lock_init(&km->lock);
+	km->count = count;
+	km->hash_bits = bits;
+	km->next = (u32 *)(km->usage + count);
+	km->heads = km->next + count;
+	memset(km->heads, 0xff, buckets * sizeof(u32));
+
+	hidinput_collect_keys(hid, km->usage);
+
+	/* backwards, so that each bucket lists the lowest index first */
+	for (i = count; i-- > 0; ) {
+		usage = km->usage[i];
+		hash = hash_32(hidinput_scancode(usage), bits);
+		km->next[i] = km->heads[hash];
+		km->heads[hash] = i;
+
+		if (usage->type == EV_KEY && usage->code < KEY_CNT)
+			km->key_users[usage->code]++;
+	}
+
+	hid->keymap = km;
+}
+
+static void hidinput_free_keymap(struct hid_device *hid)
+{
+	kvfree(hid->keymap);
+	hid->keymap = NULL;
+}
+
+static struct hid_usage *hidinput_keymap_find(struct hid_keymap *km,
+					const struct input_keymap_entry *ke,
+					unsigned int *index)
+{
+	unsigned int scancode;
+	u32 i;
+
+	if (ke->flags & INPUT_KEYMAP_BY_INDEX) {
+		if (ke->index >= km->count)
+			return NULL;
+		i = ke->index;
+	} else {
+		if (input_scancode_to_scalar(ke, &scancode))
+			return NULL;
+
+		i = km->heads[hash_32(scancode, km->hash_bits)];
+		while (i != HID_KEYMAP_END &&
+		       hidinput_scancode(km->usage[i]) != scancode)
+			i = km->next[i];
+		if (i == HID_KEYMAP_END)
+			return NULL;
+	}
+
+	if (index)
+		*index = i;
+	return km->usage[i];
+}
+
 static struct hid_usage *hidinput_locate_usage(struct hid_device *hid,
 					const struct input_keymap_entry *ke,
 					unsigned int *index)
@@ -118,6 +250,9 @@ static struct hid_usage *hidinput_locate_usage(struct hid_device *hid,
 	struct hid_usage *usage;
 	unsigned int scancode;
 
+	if (hid->keymap)
+		return hidinput_keymap_find(hid->keymap, ke, index);
+
 	if (ke->flags & INPUT_KEYMAP_BY_INDEX)
 		usage = hidinput_find_key(hid, match_index, ke->index, index);
 	else if (input_scancode_to_scalar(ke, &scancode) == 0)
@@ -154,7 +289,12 @@ static int hidinput_setkeycode(struct input_dev *dev,
 			       unsigned int *old_keycode)
 {
 	struct hid_device *hid = input_get_drvdata(dev);
+	struct hid_keymap *km = hid->keymap;
 	struct hid_usage *usage;
+	bool old_used;
+
+	if (km)
+		spin_lock(&km->lock);
 
 	usage = hidinput_locate_usage(hid, ke, NULL);
 	if (usage) {
@@ -162,6 +302,11 @@ static int hidinput_setkeycode(struct input_dev *dev,
 				usage->code : KEY_RESERVED;
 		usage->code = ke->keycode;
 
+		if (km && usage->type == EV_KEY) {
+			km->key_users[*old_keycode]--;
+			km->key_users[usage->code]++;
+		}
+
 		clear_bit(*old_keycode, dev->keybit);
 		set_bit(usage->code, dev->keybit);
 		dbg_hid("Assigned keycode %d to HID usage code %x\n",
@@ -171,13 +316,19 @@ static int hidinput_setkeycode(struct input_dev *dev,
 		 * Set the keybit for the old keycode if the old keycode is used
 		 * by another key
 		 */
-		if (hidinput_find_key(hid, match_keycode, *old_keycode, NULL))
+		if (km)
+			old_used = km->key_users[*old_keycode];
+		else
+			old_used = hidinput_find_key(hid, match_keycode,
+						     *old_keycode, NULL);
+		if (old_used)
 			set_bit(*old_keycode, dev->keybit);
-
-		return 0;
 	}
 
-	return -EINVAL;
+	if (km)
+		spin_unlock(&km->lock);
+
+	return usage ? 0 : -EINVAL;
 }
 
 
@@ -290,6 +441,16 @@ static enum power_supply_property hidinput_battery_props[] = {
 	POWER_SUPPLY_PROP_SCOPE,
 };
 
+static int hid_battery_min_delta = 1;
+module_param_named(battery_min_delta, hid_battery_min_delta, int, 0644);
+MODULE_PARM_DESC(battery_min_delta,
+		 "Smallest battery capacity change notified at once, in percent");
+
+static unsigned int hid_battery_min_interval;
+module_param_named(battery_min_interval_ms, hid_battery_min_interval, uint, 0644);
+MODULE_PARM_DESC(battery_min_interval_ms,
+		 "Shortest time between battery capacity notifications, in ms");
+
 #define HID_BATTERY_QUIRK_PERCENT	(1 << 0) /* always reports percent */
 #define HID_BATTERY_QUIRK_FEATURE	(1 << 1) /* ask for feature report */
 #define HID_BATTERY_QUIRK_IGNORE	(1 << 2) /* completely ignore the battery */
@@ -488,6 +649,8 @@ static int hidinput_setup_battery(struct hid_device *dev, unsigned report_type,
 	dev->battery_max = max;
 	dev->battery_report_type = report_type;
 	dev->battery_report_id = field->report->id;
+	dev->battery_min_delta = max(hid_battery_min_delta, 1);
+	dev->battery_min_interval = hid_battery_min_interval;
 
 	/*
 	 * Stylus is normally not connected to the device and thus we
@@ -531,6 +694,8 @@ static void hidinput_cleanup_battery(struct hid_device *dev)
 
 static void hidinput_update_battery(struct hid_device *dev, int value)
 {
+	ktime_t now = ktime_get_coarse();
+	bool changed;
 	int capacity;
 
 	if (!dev->battery)
@@ -541,13 +706,21 @@ static void hidinput_update_battery(struct hid_device *dev, int value)
 
 	capacity = hidinput_scale_battery_capacity(dev, value);
 
-	if (dev->battery_status != HID_BATTERY_REPORTED ||
-	    capacity != dev->battery_capacity ||
-	    ktime_after(ktime_get_coarse(), dev->battery_ratelimit_time)) {
+	/*
+	 * A capacity sitting on a scaling boundary flaps between two values,
+	 * so only changes past the hysteresis are notified at once. Becoming
+	 * REPORTED changes the status and is always notified.
+	 */
+	changed = abs(capacity - dev->battery_capacity) >= dev->battery_min_delta &&
+		  !ktime_before(now, dev->battery_change_time);
+
+	if (dev->battery_status != HID_BATTERY_REPORTED || changed ||
+	    ktime_after(now, dev->battery_ratelimit_time)) {
 		dev->battery_capacity = capacity;
 		dev->battery_status = HID_BATTERY_REPORTED;
-		dev->battery_ratelimit_time =
-			ktime_add_ms(ktime_get_coarse(), 30 * 1000);
+		dev->battery_ratelimit_time = ktime_add_ms(now, 30 * 1000);
+		dev->battery_change_time =
+			ktime_add_ms(now, dev->battery_min_interval);
 		power_supply_changed(dev->battery);
 	}
 }
@@ -1455,8 +1628,11 @@ void hidinput_report_event(struct hid_device *hid, struct hid_report *report)
 	if (hid->quirks & HID_QUIRK_NO_INPUT_SYNC)
 		return;
 
-	list_for_each_entry(hidinput, &hid->inputs, list)
+	list_for_each_entry(hidinput, &hid->inputs, list) {
+		if (hid->input_time)
+			input_set_timestamp(hidinput->input, hid->input_time);
 		input_sync(hidinput->input);
+	}
 }
 EXPORT_SYMBOL_GPL(hidinput_report_event);
 
@@ -1522,7 +1698,7 @@ EXPORT_SYMBOL_GPL(hidinput_count_leds);
 static void hidinput_led_worker(struct work_struct *work)
 {
 	struct hid_device *hid = container_of(work, struct hid_device,
-					      led_work);
+					      led_work.work);
 	struct hid_field *field;
 	struct hid_report *report;
 	int ret;
@@ -1587,7 +1763,7 @@ static int hidinput_input_event(struct input_dev *dev, unsigned int type,
 
 	hid_set_field(field, offset, value);
 
-	schedule_work(&hid->led_work);
+	hid_queue_output_work(&hid->led_work);
 	return 0;
 }
 
@@ -1932,7 +2108,7 @@ int hidinput_connect(struct hid_device *hid, unsigned int force)
 	int i, k;
 
 	INIT_LIST_HEAD(&hid->inputs);
-	INIT_WORK(&hid->led_work, hidinput_led_worker);
+	hid_init_output_work(&hid->led_work, hidinput_led_worker);
 
 	hid->status &= ~HID_STAT_DUP_DETECTED;
 
@@ -1991,6 +2167,9 @@ int hidinput_connect(struct hid_device *hid, unsigned int force)
 
 	hidinput_change_resolution_multipliers(hid);
 
+	/* before the input devices can be asked for their keycodes */
+	hidinput_build_keymap(hid);
+
 	list_for_each_entry_safe(hidinput, next, &hid->inputs, list) {
 		if (drv->input_configured &&
 		    drv->input_configured(hid, hidinput))
@@ -2042,10 +2221,12 @@ void hidinput_disconnect(struct hid_device *hid)
 		kfree(hidinput);
 	}
 
+	hidinput_free_keymap(hid);
+
 	/* led_work is spawned by input_dev callbacks, but doesn't access the
 	 * parent input_dev at all. Once all input devices are removed, we
 	 * know that led_work will never get restarted, so we can cancel it
 	 * synchronously and are safe. */
-	cancel_work_sync(&hid->led_work);
+	cancel_work_sync(&hid->led_work.work);
 }
 EXPORT_SYMBOL_GPL(hidinput_disconnect);
@@ -177,6 +177,20 @@ struct hidpp_scroll_counter {
 	unsigned long long last_time;
 };
 
+#define HIDPP_FEATURE_CACHE_SIZE	16
+
+/**
+ * struct hidpp_feature - a cached root feature lookup
+ * @feature: the feature page
+ * @index: its index in the device's feature table, 0 if not supported
+ * @type: the feature type flags
+ */
+struct hidpp_feature {
+	u16 feature;
+	u8 index;
+	u8 type;
+};
+
 struct hidpp_device {
 	struct hid_device *hid_dev;
 	struct input_dev *input;
@@ -204,6 +218,10 @@ struct hidpp_device {
 	struct hidpp_scroll_counter vertical_wheel_counter;
 
 	u8 wireless_feature_index;
+
+	spinlock_t feature_lock;
+	unsigned int num_features;
+	struct hidpp_feature features[HIDPP_FEATURE_CACHE_SIZE];
 };
 
 /* HID++ 1.0 error codes */
@@ -222,6 +240,7 @@ struct hidpp_device {
 #define HIDPP_ERROR_INVALID_PARAM_VALUE		0x0b
 #define HIDPP_ERROR_WRONG_PIN_CODE		0x0c
 /* HID++ 2.0 error codes */
+#define HIDPP20_ERROR_INVALID_FEATURE_INDEX	0x06
 #define HIDPP20_ERROR				0xff
 
 static void hidpp_connect_event(struct hidpp_device *hidpp_dev);
@@ -263,6 +282,62 @@ static int __hidpp_send_report(struct hid_device *hdev,
 	return ret == fields_count ? 0 : -1;
 }
 
+/*
+ * The feature table of a device only changes with its firmware, so the
+ * root lookups are kept for as long as the device is bound, and dropped
+ * when the device tells us that an index we used is not valid anymore.
+ */
+static void hidpp_flush_features(struct hidpp_device *hidpp)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&hidpp->feature_lock, flags);
+	hidpp->num_features = 0;
+	spin_unlock_irqrestore(&hidpp->feature_lock, flags);
+}
+
+static bool hidpp_lookup_feature(struct hidpp_device *hidpp, u16 feature,
+				 u8 *feature_index, u8 *feature_type)
+{
+	unsigned long flags;
+	bool found = false;
+	unsigned int i;
+
+	spin_lock_irqsave(&hidpp->feature_lock, flags);
+	for (i = 0; i < hidpp->num_features; i++) {
+		if (hidpp->features[i].feature == feature) {
+			*feature_index = hidpp->features[i].index;
+			*feature_type = hidpp->features[i].type;
+			found = true;
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&hidpp->feature_lock, flags);
+
+	return found;
+}
+
+static void hidpp_cache_feature(struct hidpp_device *hidpp, u16 feature,
+				u8 feature_index, u8 feature_type)
+{
+	unsigned long flags;
+	unsigned int i;
+
+	spin_lock_irqsave(&hidpp->feature_lock, flags);
+	for (i = 0; i < hidpp->num_features; i++)
+		if (hidpp->features[i].feature == feature)
+			goto out;
+
+	if (hidpp->num_features < HIDPP_FEATURE_CACHE_SIZE) {
+		hidpp->features[i].feature = feature;
+		hidpp->features[i].index = feature_index;
+		hidpp->features[i].type = feature_type;
+		hidpp->num_features++;
+	}
+out:
+	spin_unlock_irqrestore(&hidpp->feature_lock, flags);
+}
+
 /*
  * hidpp_send_message_sync() returns 0 in case of success, and something else
  * in case of a failure.
@@ -315,6 +390,8 @@ static int hidpp_send_message_sync(struct hidpp_device *hidpp,
 			response->fap.feature_index == HIDPP20_ERROR) {
 		ret = response->fap.params[1];
 		dbg_hid("%s:got hidpp 2.0 error %02X\n", __func__, ret);
+		if (ret == HIDPP20_ERROR_INVALID_FEATURE_INDEX)
+			hidpp_flush_features(hidpp);
 		goto exit;
 	}
 
@@ -865,21 +942,28 @@ static int hidpp_root_get_feature(struct hidpp_device *hidpp, u16 feature,
 	struct hidpp_report response;
 	int ret;
 	u8 params[2] = { feature >> 8, feature & 0x00FF };
+	u8 index, type;
 
-	ret = hidpp_send_fap_command_sync(hidpp,
-			HIDPP_PAGE_ROOT_IDX,
-			CMD_ROOT_GET_FEATURE,
-			params, 2, &response);
-	if (ret)
-		return ret;
+	if (!hidpp_lookup_feature(hidpp, feature, &index, &type)) {
+		ret = hidpp_send_fap_command_sync(hidpp,
+				HIDPP_PAGE_ROOT_IDX,
+				CMD_ROOT_GET_FEATURE,
+				params, 2, &response);
+		if (ret)
+			return ret;
 
-	if (response.fap.params[0] == 0)
+		index = response.fap.params[0];
+		type = response.fap.params[1];
+		hidpp_cache_feature(hidpp, feature, index, type);
+	}
+
+	if (index == 0)
 		return -ENOENT;
 
-	*feature_index = response.fap.params[0];
-	*feature_type = response.fap.params[1];
+	*feature_index = index;
+	*feature_type = type;
 
-	return ret;
+	return 0;
 }
 
 static int hidpp_root_get_protocol_version(struct hidpp_device *hidpp)
@@ -3923,6 +4007,27 @@ static void hidpp_connect_event(struct hidpp_device *hidpp)
 		}
 	}
 
+	/*
+	 * Create the input node before probing the optional features, so
+	 * that the device is usable while the battery and wheel queries,
+	 * which take a round trip through the receiver each, are running.
+	 */
+	if ((hidpp->quirks & HIDPP_QUIRK_NO_HIDINPUT) && !hidpp->delayed_input) {
+		input = hidpp_allocate_input(hdev);
+		if (!input) {
+			hid_err(hdev, "cannot allocate new input device: %d\n", ret);
+			return;
+		}
+
+		hidpp_populate_input(hidpp, input);
+
+		ret = input_register_device(input);
+		if (ret)
+			input_free_device(input);
+
+		hidpp->delayed_input = input;
+	}
+
 	hidpp_initialize_battery(hidpp);
 
 	/* forward current battery state */
@@ -3945,24 +4050,6 @@ static void hidpp_connect_event(struct hidpp_device *hidpp)
 
 	if (hidpp->quirks & HIDPP_QUIRK_HI_RES_SCROLL)
 		hi_res_scroll_enable(hidpp);
-
-	if (!(hidpp->quirks & HIDPP_QUIRK_NO_HIDINPUT) || hidpp->delayed_input)
-		/* if the input nodes are already created, we can stop now */
-		return;
-
-	input = hidpp_allocate_input(hdev);
-	if (!input) {
-		hid_err(hdev, "cannot allocate new input device: %d\n", ret);
-		return;
-	}
-
-	hidpp_populate_input(hidpp, input);
-
-	ret = input_register_device(input);
-	if (ret)
-		input_free_device(input);
-
-	hidpp->delayed_input = input;
 }
 
 static DEVICE_ATTR(builtin_power_supply, 0000, NULL, NULL);
@@ -4106,6 +4193,7 @@ static int hidpp_probe(struct hid_device *hdev, const struct hid_device_id *id)
 
 	INIT_WORK(&hidpp->work, delayed_work_cb);
 	mutex_init(&hidpp->send_mutex);
+	spin_lock_init(&hidpp->feature_lock);
 	init_waitqueue_head(&hidpp->wait);
 
 	/* indicates we are handling the battery properties in the kernel */
@@ -101,6 +101,7 @@ struct mt_usages {
 	bool *tip_state;	/* is the touch valid? */
 	bool *inrange_state;	/* is the finger in proximity of the sensor? */
 	bool *confidence_state;	/* is the touch made by a finger? */
+	int last_slot;		/* input_mt slot of the previous frame */
 };
 
 struct mt_application {
@@ -149,11 +150,24 @@ struct mt_class {
 	bool export_all_inputs;	/* do not ignore mouse, keyboards, etc... */
 };
 
+struct mt_report_event {
+	struct hid_field *field;
+	unsigned int index;
+};
+
 struct mt_report_data {
 	struct list_head list;
 	struct hid_report *report;
 	struct mt_application *application;
 	bool is_mt_collection;
+
+	/*
+	 * Mapped usages of the report that are not part of a contact, so
+	 * that mt_touch_report() does not have to walk every usage of
+	 * every contact to find the few buttons it still has to report.
+	 */
+	struct mt_report_event *events;
+	unsigned int num_events;
 };
 
 struct mt_device {
@@ -527,6 +541,7 @@ static struct mt_usages *mt_allocate_usage(struct hid_device *hdev,
 	usage->tip_state = DEFAULT_FALSE;
 	usage->inrange_state = DEFAULT_FALSE;
 	usage->confidence_state = DEFAULT_TRUE;
+	usage->last_slot = -1;
 
 	list_add_tail(&usage->list, &application->mt_usages);
 
@@ -648,6 +663,59 @@ static struct mt_report_data *mt_find_report_data(struct mt_device *td,
 	return rdata;
 }
 
+/*
+ * Called once hid-input mapped the usages: contacts are reported from
+ * the application's mt_usages, everything else from the list built here.
+ */
+static int mt_setup_report_events(struct mt_device *td,
+				  struct mt_report_data *rdata)
+{
+	struct hid_report *report = rdata->report;
+	struct hid_field *field;
+	unsigned int count = 0;
+	int r, n;
+
+	if (rdata->events)
+		return 0;
+
+	for (r = 0; r < report->maxfield; r++) {
+		field = report->field[r];
+
+		if (!(HID_MAIN_ITEM_VARIABLE & field->flags))
+			continue;
+
+		for (n = 0; n < field->report_count; n++)
+			if (field->usage[n].type)
+				count++;
+	}
+
+	if (!count)
+		return 0;
+
+	rdata->events = devm_kcalloc(&td->hdev->dev, count,
+				     sizeof(*rdata->events), GFP_KERNEL);
+	if (!rdata->events)
+		return -ENOMEM;
+
+	for (r = 0; r < report->maxfield; r++) {
+		field = report->field[r];
+
+		if (!(HID_MAIN_ITEM_VARIABLE & field->flags))
+			continue;
+
+		for (n = 0; n < field->report_count; n++) {
+			if (!field->usage[n].type)
+				continue;
+
+			rdata->events[rdata->num_events].field = field;
+			rdata->events[rdata->num_events].index = n;
+			rdata->num_events++;
+		}
+	}
+
+	return 0;
+}
+
 static void mt_store_field(struct hid_device *hdev,
 			   struct mt_application *application,
 			   __s32 *value,
@@ -904,7 +972,20 @@ static int mt_compute_slot(struct mt_device *td, struct mt_application *app,
 	if (quirks & MT_QUIRK_SLOT_IS_CONTACTID_MINUS_ONE)
 		return *slot->contactid - 1;
 
-	return input_mt_get_slot_by_key(input, *slot->contactid);
+	/*
+	 * Most devices report a given contact at the same position in
+	 * consecutive reports, so try the slot it had in the previous
+	 * frame before searching all of them.
+	 */
+	if (input->mt && slot->last_slot >= 0) {
+		struct input_mt_slot *s = &input->mt->slots[slot->last_slot];
+
+		if (input_mt_is_active(s) && s->key == *slot->contactid)
+			return slot->last_slot;
+	}
+
+	slot->last_slot = input_mt_get_slot_by_key(input, *slot->contactid);
+	return slot->last_slot;
 }
 
 static void mt_release_pending_palms(struct mt_device *td,
@@ -1061,6 +1142,7 @@ static int mt_process_slot(struct mt_device *td, struct input_dev *input,
 	input_mt_report_slot_state(input, tool, active);
 	if (active) {
 		/* this finger is in proximity of the sensor */
+		struct input_value vals[9];
 		int wide = (*slot->w > *slot->h);
 		int major = max(*slot->w, *slot->h);
 		int minor = min(*slot->w, *slot->h);
@@ -1096,15 +1178,20 @@ static int mt_process_slot(struct mt_device *td, struct input_dev *input,
 			minor = minor >> 1;
 		}
 
-		input_event(input, EV_ABS, ABS_MT_POSITION_X, *slot->x);
-		input_event(input, EV_ABS, ABS_MT_POSITION_Y, *slot->y);
-		input_event(input, EV_ABS, ABS_MT_TOOL_X, *slot->cx);
-		input_event(input, EV_ABS, ABS_MT_TOOL_Y, *slot->cy);
-		input_event(input, EV_ABS, ABS_MT_DISTANCE, !*slot->tip_state);
-		input_event(input, EV_ABS, ABS_MT_ORIENTATION, orientation);
-		input_event(input, EV_ABS, ABS_MT_PRESSURE, *slot->p);
-		input_event(input, EV_ABS, ABS_MT_TOUCH_MAJOR, major);
-		input_event(input, EV_ABS, ABS_MT_TOUCH_MINOR, minor);
+		vals[0] = (struct input_value) { EV_ABS, ABS_MT_POSITION_X, *slot->x };
+		vals[1] = (struct input_value) { EV_ABS, ABS_MT_POSITION_Y, *slot->y };
+		vals[2] = (struct input_value) { EV_ABS, ABS_MT_TOOL_X, *slot->cx };
+		vals[3] = (struct input_value) { EV_ABS, ABS_MT_TOOL_Y, *slot->cy };
+		vals[4] = (struct input_value) {
+			EV_ABS, ABS_MT_DISTANCE, !*slot->tip_state
+		};
+		vals[5] = (struct input_value) {
+			EV_ABS, ABS_MT_ORIENTATION, orientation
+		};
+		vals[6] = (struct input_value) { EV_ABS, ABS_MT_PRESSURE, *slot->p };
+		vals[7] = (struct input_value) { EV_ABS, ABS_MT_TOUCH_MAJOR, major };
+		vals[8] = (struct input_value) { EV_ABS, ABS_MT_TOUCH_MINOR, minor };
+		input_event_values(input, vals, ARRAY_SIZE(vals));
 
 		set_bit(MT_IO_FLAGS_ACTIVE_SLOTS, &td->mt_io_flags);
 	}
@@ -1157,12 +1244,10 @@ static void mt_touch_report(struct hid_device *hid,
 	struct mt_device *td = hid_get_drvdata(hid);
 	struct hid_report *report = rdata->report;
 	struct mt_application *app = rdata->application;
-	struct hid_field *field;
+	struct mt_report_event *ev;
 	struct input_dev *input;
 	struct mt_usages *slot;
 	bool first_packet;
-	unsigned count;
-	int r, n;
 	int scantime = 0;
 	int contact_count = -1;
 
@@ -1206,18 +1291,10 @@ static void mt_touch_report(struct hid_device *hid,
 			app->num_received++;
 	}
 
-	for (r = 0; r < report->maxfield; r++) {
-		field = report->field[r];
-		count = field->report_count;
-
-		if (!(HID_MAIN_ITEM_VARIABLE & field->flags))
-			continue;
-
-		for (n = 0; n < count; n++)
-			mt_process_mt_event(hid, app, field,
-					    &field->usage[n], field->value[n],
-					    first_packet);
-	}
+	for (ev = rdata->events; ev != rdata->events + rdata->num_events; ev++)
+		mt_process_mt_event(hid, app, ev->field,
+				    &ev->field->usage[ev->index],
+				    ev->field->value[ev->index], first_packet);
 
 	if (app->num_received >= app->num_expected)
 		mt_sync_frame(td, app, input);
@@ -1570,6 +1647,10 @@ static int mt_input_configured(struct hid_device *hdev, struct hid_input *hi)
 		mt_application = rdata->application;
 
 		if (rdata->is_mt_collection) {
+			ret = mt_setup_report_events(td, rdata);
+			if (ret)
+				return ret;
+
 			ret = mt_touch_input_configured(hdev, hi,
 							mt_application);
 			if (ret)
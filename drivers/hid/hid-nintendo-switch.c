@@ -25,15 +25,26 @@
 #include "hid-ids.h"
 #include "hid-nintendo.h"
 #include <asm/unaligned.h>
+#include <linux/completion.h>
 #include <linux/delay.h>
 #include <linux/device.h>
+#ifdef CONFIG_HID_NINTENDO_SWITCH_IIO
+#include <linux/iio/buffer.h>
+#include <linux/iio/iio.h>
+#include <linux/iio/kfifo_buf.h>
+#endif
 #include <linux/kernel.h>
 #include <linux/hid.h>
+#include <linux/indirect_call_wrapper.h>
 #include <linux/input.h>
 #include <linux/jiffies.h>
 #include <linux/leds.h>
+#include <linux/list.h>
 #include <linux/power_supply.h>
+#include <linux/rcupdate.h>
+#include <linux/slab.h>
 #include <linux/spinlock.h>
+#include <linux/workqueue.h>
 
 /*
  * Reference the url below for the following HID report defines:
@@ -127,8 +138,32 @@ static const u16 JC_IMU_CAL_USR_DATA_ADDR	= 0x8028;
 
 /* The raw analog joystick values will be mapped in terms of this magnitude */
 static const u16 JC_MAX_STICK_MAG		= 32767;
-static const u16 JC_STICK_FUZZ			= 250;
-static const u16 JC_STICK_FLAT			= 500;
+
+/*
+ * Mapped values closer to the center than stick_deadzone are reported as the
+ * center itself, so that an untouched stick doesn't generate any event.
+ */
+static unsigned int stick_deadzone = 500;
+module_param(stick_deadzone, uint, 0444);
+MODULE_PARM_DESC(stick_deadzone,
+		 "Distance from the stick center reported as the center (default 500)");
+
+static unsigned int stick_fuzz = 250;
+module_param(stick_fuzz, uint, 0444);
+MODULE_PARM_DESC(stick_fuzz,
+		 "Stick noise filtered out by the input core (default 250)");
+
+/*
+ * Left and right Joy-Cons connected over bluetooth are additionally presented
+ * as one combined gamepad, pairing them in the order they connect.
+ */
+static bool combine_pairs;
+module_param(combine_pairs, bool, 0444);
+MODULE_PARM_DESC(combine_pairs,
+		 "Combine left and right Joy-Cons into one input device (default N)");
+
+/* The product id userspace mergers already use for the combined device */
+#define JC_PAIR_PRODUCT		0x2008
 
 /* Hat values for pro controller's d-pad */
 static const u16 JC_MAX_DPAD_MAG		= 1;
@@ -310,6 +345,8 @@ struct joycon_stick_cal {
 	s32 center;
 };
 
+struct joycon_parser;
+
 struct joycon_imu_cal {
 	s16 offset[3];
 	s16 scale[3];
@@ -345,7 +382,6 @@ static const u32 JC_BTN_ZL	= BIT(23);
 enum joycon_msg_type {
 	JOYCON_MSG_TYPE_NONE,
 	JOYCON_MSG_TYPE_USB,
-	JOYCON_MSG_TYPE_SUBCMD,
 };
 
 struct joycon_rumble_output {
@@ -394,9 +430,43 @@ struct joycon_input_report {
 } __packed;
 
 #define JC_MAX_RESP_SIZE	(sizeof(struct joycon_input_report) + 35)
+
+/*
+ * Subcommands are queued and sent by subcmd_work, one per send slot. Several
+ * of them may wait for their reply at the same time, replies are matched by
+ * subcommand ID, and also by address for SPI flash reads.
+ */
+#define JC_SUBCMD_MAX_DATA	5
+#define JC_SUBCMD_MAX_INFLIGHT	4
+/*
+ * The controller occasionally seems to drop subcommands. In testing, doing
+ * one retry after a timeout appears to always work.
+ */
+#define JC_SUBCMD_TRIES		2
+
+struct joycon_subcmd {
+	struct list_head node;
+	u8 id;
+	u8 len;
+	u8 data[JC_SUBCMD_MAX_DATA];
+	unsigned long timeout;
+	unsigned long deadline;
+	int tries;
+	int status; /* -EINPROGRESS until answered or failed */
+	u8 reply[JC_MAX_RESP_SIZE];
+	struct completion done;
+};
+
 #define JC_RUMBLE_DATA_SIZE	8
 #define JC_RUMBLE_QUEUE_SIZE	8
 
+/* Upper bound of the values reported for one input report, including SYN */
+#define JC_MAX_FRAME_VALUES	32
+/* Each IMU sample is a timestamp, six axes and a SYN */
+#define JC_IMU_SAMPLE_VALUES	8
+#define JC_VALUE(_type, _code, _value) \
+	((struct input_value) { .type = (_type), .code = (_code), .value = (_value) })
+
 static const u16 JC_RUMBLE_DFLT_LOW_FREQ = 160;
 static const u16 JC_RUMBLE_DFLT_HIGH_FREQ = 320;
 static const u16 JC_RUMBLE_PERIOD_MS = 50;
@@ -410,6 +480,15 @@ static const char * const joycon_player_led_names[] = {
 };
 #define JC_NUM_LEDS		ARRAY_SIZE(joycon_player_led_names)
 
+struct joycon_ctlr;
+
+/* A left and a right Joy-Con reported as a single gamepad */
+struct joycon_pair {
+	struct input_dev *input;
+	struct joycon_ctlr *left;
+	struct joycon_ctlr *right;
+};
+
 /* Each physical controller is associated with a joycon_ctlr struct */
 struct joycon_ctlr {
 	enum nintendo_driver driver;
@@ -422,8 +501,9 @@ struct joycon_ctlr {
 	u8 mac_addr[6];
 	char *mac_addr_str;
 	enum joycon_ctlr_type ctlr_type;
+	const struct joycon_parser *parser; /* picked from ctlr_type */
 
-	/* The following members are used for synchronous sends/receives */
+	/* The following members are used for synchronous USB sends/receives */
 	enum joycon_msg_type msg_type;
 	u8 subcmd_num;
 	struct mutex output_mutex;
@@ -431,10 +511,22 @@ struct joycon_ctlr {
 	wait_queue_head_t wait;
 	bool received_resp;
 	u8 usb_ack_match;
-	u8 subcmd_ack_match;
 	bool received_input_report;
 	unsigned int last_subcmd_sent_msecs;
 
+	/* subcommands, protected by lock and sent by subcmd_work */
+	struct list_head subcmd_queue;
+	struct list_head subcmd_inflight;
+	struct list_head subcmd_done;
+	unsigned int subcmd_inflight_count;
+	struct delayed_work subcmd_work;
+	/* player leds mask, sent by leds_cmd on the next slot when dirty */
+	u8 player_leds;
+	bool player_leds_dirty;
+	struct joycon_subcmd leds_cmd;
+	/* reads the calibration once the input devices are registered */
+	struct work_struct cal_work;
+
 	/* factory calibration data */
 	struct joycon_stick_cal left_stick_cal_x;
 	struct joycon_stick_cal left_stick_cal_y;
@@ -459,17 +551,20 @@ struct joycon_ctlr {
 	u8 rumble_data[JC_RUMBLE_QUEUE_SIZE][JC_RUMBLE_DATA_SIZE];
 	int rumble_queue_head;
 	int rumble_queue_tail;
-	struct workqueue_struct *rumble_queue;
-	struct work_struct rumble_worker;
+	struct hid_output_work rumble_worker;
 	unsigned int rumble_msecs;
 	u16 rumble_ll_freq;
 	u16 rumble_lh_freq;
 	u16 rumble_rl_freq;
 	u16 rumble_rh_freq;
 	unsigned short rumble_zero_countdown;
+	bool rumble_pending; /* a new effect waits for the next report */
 
 	/* imu */
 	struct input_dev *imu_input;
+#ifdef CONFIG_HID_NINTENDO_SWITCH_IIO
+	struct iio_dev *indio_dev;
+#endif
 	bool imu_first_packet_received; /* helps in initiating timestamp */
 	unsigned int imu_timestamp_us; /* timestamp we report to userspace */
 	unsigned int imu_last_pkt_ms; /* used to calc imu report delta */
@@ -477,6 +572,10 @@ struct joycon_ctlr {
 	unsigned int imu_delta_samples_count;
 	unsigned int imu_delta_samples_sum;
 	unsigned int imu_avg_delta_ms;
+
+	/* combined device, protected by joycon_pair_mutex and rcu */
+	struct joycon_pair __rcu *pair;
+	struct list_head pair_node; /* on joycon_unpaired while unpaired */
 };
 
 /* Helper macros for checking controller type */
@@ -534,8 +633,8 @@ static void joycon_wait_for_input_report(struct joycon_ctlr *ctlr)
 					 HZ / 4);
 		/* We will still proceed, even with a timeout here */
 		if (!ret)
-			hid_warn(ctlr->hdev,
-				 "timeout waiting for input report\n");
+			hid_warn_ratelimited(ctlr->hdev,
+					     "timeout waiting for input report\n");
 	}
 }
 
@@ -549,6 +648,16 @@ static void joycon_enforce_subcmd_rate(struct joycon_ctlr *ctlr)
 	unsigned int current_ms = jiffies_to_msecs(jiffies);
 	unsigned int delta_ms = current_ms - ctlr->last_subcmd_sent_msecs;
 
+	/*
+	 * Without input reports to synchronize with, back to back subcommands
+	 * still have to be spaced out.
+	 */
+	if (delta_ms < max_subcmd_rate_ms &&
+	    ctlr->ctlr_state == JOYCON_CTLR_STATE_INIT) {
+		msleep(max_subcmd_rate_ms - delta_ms);
+		current_ms = jiffies_to_msecs(jiffies);
+	}
+
 	while (delta_ms < max_subcmd_rate_ms &&
 	       ctlr->ctlr_state == JOYCON_CTLR_STATE_READ) {
 		joycon_wait_for_input_report(ctlr);
@@ -562,12 +671,8 @@ static int joycon_hid_send_sync(struct joycon_ctlr *ctlr, u8 *data, size_t len,
 				u32 timeout)
 {
 	int ret;
-	int tries = 2;
+	int tries = JC_SUBCMD_TRIES;
 
-	/*
-	 * The controller occasionally seems to drop subcommands. In testing,
-	 * doing one retry after a timeout appears to always work.
-	 */
 	while (tries--) {
 		joycon_enforce_subcmd_rate(ctlr);
 
@@ -612,39 +717,310 @@ static int joycon_send_usb(struct joycon_ctlr *ctlr, u8 cmd, u32 timeout)
 	return ret;
 }
 
-static int joycon_send_subcmd(struct joycon_ctlr *ctlr,
-			      struct joycon_subcmd_request *subcmd,
-			      size_t data_len, u32 timeout)
+/* Must be called with ctlr->lock held */
+static void joycon_subcmd_kick(struct joycon_ctlr *ctlr, unsigned long delay)
+{
+	if (ctlr->ctlr_state != JOYCON_CTLR_STATE_REMOVED)
+		mod_delayed_work(hid_output_wq, &ctlr->subcmd_work, delay);
+}
+
+static bool joycon_subcmd_match(const struct joycon_subcmd *cmd, u8 id,
+				const u8 *data)
 {
+	if (cmd->id != id)
+		return false;
+
+	/* SPI flash read replies start with the address and size read */
+	if (id == JC_SUBCMD_SPI_FLASH_READ)
+		return !memcmp(cmd->data, data, cmd->len);
+
+	return true;
+}
+
+/*
+ * Returns the subcommand to send in the next slot, if any. Must be called with
+ * ctlr->lock held.
+ */
+static struct joycon_subcmd *joycon_subcmd_next(struct joycon_ctlr *ctlr)
+{
+	struct joycon_subcmd *cmd, *sent;
+
+	if (ctlr->subcmd_inflight_count >= JC_SUBCMD_MAX_INFLIGHT)
+		return NULL;
+
+	cmd = list_first_entry_or_null(&ctlr->subcmd_queue,
+				       struct joycon_subcmd, node);
+	if (!cmd)
+		return NULL;
+
+	/* The replies couldn't be told apart, keep the order meanwhile */
+	list_for_each_entry(sent, &ctlr->subcmd_inflight, node)
+		if (joycon_subcmd_match(sent, cmd->id, cmd->data))
+			return NULL;
+
+	return cmd;
+}
+
+/* Must be called with ctlr->lock held */
+static void joycon_subcmd_expire(struct joycon_ctlr *ctlr)
+{
+	struct joycon_subcmd *cmd, *tmp;
+
+	list_for_each_entry_safe(cmd, tmp, &ctlr->subcmd_inflight, node) {
+		if (time_before(jiffies, cmd->deadline))
+			continue;
+
+		ctlr->subcmd_inflight_count--;
+		if (--cmd->tries) {
+			hid_dbg(ctlr->hdev, "retrying subcommand 0x%02x after timeout\n",
+				cmd->id);
+			list_move(&cmd->node, &ctlr->subcmd_queue);
+		} else {
+			hid_dbg(ctlr->hdev, "subcommand 0x%02x timed out\n",
+				cmd->id);
+			cmd->status = -ETIMEDOUT;
+			list_move_tail(&cmd->node, &ctlr->subcmd_done);
+		}
+	}
+}
+
+static void joycon_subcmd_complete(struct list_head *done)
+{
+	struct joycon_subcmd *cmd, *tmp;
+
+	list_for_each_entry_safe(cmd, tmp, done, node) {
+		list_del_init(&cmd->node);
+		complete(&cmd->done);
+	}
+}
+
+static void joycon_subcmd_init(struct joycon_subcmd *cmd, u8 id,
+			       const u8 *data, u8 len, unsigned long timeout);
+
+/*
+ * Queues the player leds subcommand if the mask changed since it was last
+ * sent and it isn't already on its way. The mask is read when the subcommand
+ * is sent, so any number of led writes in between cost a single subcommand.
+ * Returns true if it was queued.
+ */
+static bool joycon_queue_player_leds(struct joycon_ctlr *ctlr)
+{
+	struct joycon_subcmd *cmd = &ctlr->leds_cmd;
+	unsigned long flags;
+	bool queued = false;
+
+	spin_lock_irqsave(&ctlr->lock, flags);
+	if (!ctlr->player_leds_dirty || !list_empty(&cmd->node) ||
+	    ctlr->ctlr_state == JOYCON_CTLR_STATE_REMOVED)
+		goto out;
+
+	if (cmd->status < 0 && cmd->status != -EINPROGRESS &&
+	    cmd->status != -ENODEV)
+		hid_warn(ctlr->hdev, "Failed to set leds; ret=%d\n",
+			 cmd->status);
+
+	joycon_subcmd_init(cmd, JC_SUBCMD_SET_PLAYER_LIGHTS,
+			   &ctlr->player_leds, 1, HZ/4);
+	list_add_tail(&cmd->node, &ctlr->subcmd_queue);
+	joycon_subcmd_kick(ctlr, 0);
+	queued = true;
+out:
+	spin_unlock_irqrestore(&ctlr->lock, flags);
+	return queued;
+}
+
+static void joycon_subcmd_worker(struct work_struct *work)
+{
+	struct joycon_ctlr *ctlr = container_of(to_delayed_work(work),
+						struct joycon_ctlr,
+						subcmd_work);
+	u8 buffer[sizeof(struct joycon_subcmd_request) + JC_SUBCMD_MAX_DATA];
+	struct joycon_subcmd_request *req;
+	struct joycon_subcmd *cmd;
+	unsigned long flags;
+	unsigned long next;
+	LIST_HEAD(done);
+	size_t len;
 	int ret;
+
+	req = (struct joycon_subcmd_request *)buffer;
+
+	mutex_lock(&ctlr->output_mutex);
+	for (;;) {
+		spin_lock_irqsave(&ctlr->lock, flags);
+		joycon_subcmd_expire(ctlr);
+		list_splice_tail_init(&ctlr->subcmd_done, &done);
+		cmd = joycon_subcmd_next(ctlr);
+		spin_unlock_irqrestore(&ctlr->lock, flags);
+
+		/* Don't keep the answered ones waiting for the next slot */
+		joycon_subcmd_complete(&done);
+		if (!cmd && joycon_queue_player_leds(ctlr))
+			continue;
+		if (!cmd)
+			break;
+
+		/* Only this worker takes subcommands off the queue */
+		joycon_enforce_subcmd_rate(ctlr);
+
+		spin_lock_irqsave(&ctlr->lock, flags);
+		memcpy(req->rumble_data,
+		       ctlr->rumble_data[ctlr->rumble_queue_tail],
+		       JC_RUMBLE_DATA_SIZE);
+		req->output_id = JC_OUTPUT_RUMBLE_AND_SUBCMD;
+		req->packet_num = ctlr->subcmd_num;
+		req->subcmd_id = cmd->id;
+		if (cmd == &ctlr->leds_cmd) {
+			cmd->data[0] = ctlr->player_leds;
+			ctlr->player_leds_dirty = false;
+		}
+		memcpy(req->data, cmd->data, cmd->len);
+		len = sizeof(*req) + cmd->len;
+		cmd->deadline = jiffies + cmd->timeout;
+		list_move_tail(&cmd->node, &ctlr->subcmd_inflight);
+		ctlr->subcmd_inflight_count++;
+		spin_unlock_irqrestore(&ctlr->lock, flags);
+
+		if (++ctlr->subcmd_num > 0xF)
+			ctlr->subcmd_num = 0;
+
+		ret = __joycon_hid_send(ctlr->hdev, buffer, len);
+		if (ret < 0) {
+			/* Completions only happen here, cmd is still valid */
+			spin_lock_irqsave(&ctlr->lock, flags);
+			if (cmd->status == -EINPROGRESS) {
+				ctlr->subcmd_inflight_count--;
+				cmd->status = ret;
+				list_move_tail(&cmd->node, &ctlr->subcmd_done);
+			}
+			spin_unlock_irqrestore(&ctlr->lock, flags);
+		}
+	}
+	mutex_unlock(&ctlr->output_mutex);
+
+	/* Come back for new replies, or when the oldest reply is overdue */
+	spin_lock_irqsave(&ctlr->lock, flags);
+	if (!list_empty(&ctlr->subcmd_done) || joycon_subcmd_next(ctlr)) {
+		joycon_subcmd_kick(ctlr, 0);
+	} else if (!list_empty(&ctlr->subcmd_inflight)) {
+		cmd = list_first_entry(&ctlr->subcmd_inflight,
+				       struct joycon_subcmd, node);
+		next = cmd->deadline;
+		list_for_each_entry(cmd, &ctlr->subcmd_inflight, node)
+			if (time_before(cmd->deadline, next))
+				next = cmd->deadline;
+		joycon_subcmd_kick(ctlr, time_after(next, jiffies) ?
+					 next - jiffies : 0);
+	}
+	spin_unlock_irqrestore(&ctlr->lock, flags);
+}
+
+/* Returns true if the report answered one of the subcommands in flight */
+static bool joycon_subcmd_reply(struct joycon_ctlr *ctlr, u8 *data, int size)
+{
+	struct joycon_input_report *report = (struct joycon_input_report *)data;
+	struct joycon_subcmd *cmd;
+	unsigned long flags;
+	bool match = false;
+
+	spin_lock_irqsave(&ctlr->lock, flags);
+	list_for_each_entry(cmd, &ctlr->subcmd_inflight, node) {
+		if (!joycon_subcmd_match(cmd, report->subcmd_reply.id,
+					 report->subcmd_reply.data))
+			continue;
+
+		memcpy(cmd->reply, data, min(size, (int)JC_MAX_RESP_SIZE));
+		cmd->status = 0;
+		ctlr->subcmd_inflight_count--;
+		list_move_tail(&cmd->node, &ctlr->subcmd_done);
+		joycon_subcmd_kick(ctlr, 0);
+		match = true;
+		break;
+	}
+	spin_unlock_irqrestore(&ctlr->lock, flags);
+
+	return match;
+}
+
+static void joycon_subcmd_init(struct joycon_subcmd *cmd, u8 id,
+			       const u8 *data, u8 len, unsigned long timeout)
+{
+	INIT_LIST_HEAD(&cmd->node);
+	cmd->id = id;
+	cmd->len = len;
+	memcpy(cmd->data, data, len);
+	cmd->timeout = timeout;
+	cmd->tries = JC_SUBCMD_TRIES;
+	cmd->status = -EINPROGRESS;
+	init_completion(&cmd->done);
+}
+
+/*
+ * Queues a subcommand, which must stay valid until joycon_subcmd_wait() has
+ * returned for it.
+ */
+static void joycon_subcmd_submit(struct joycon_ctlr *ctlr,
+				 struct joycon_subcmd *cmd)
+{
 	unsigned long flags;
 
 	spin_lock_irqsave(&ctlr->lock, flags);
 	/*
-	 * If the controller has been removed, just return ENODEV so the LED
+	 * If the controller has been removed, just fail with ENODEV so the LED
 	 * subsystem doesn't print invalid errors on removal.
 	 */
 	if (ctlr->ctlr_state == JOYCON_CTLR_STATE_REMOVED) {
 		spin_unlock_irqrestore(&ctlr->lock, flags);
-		return -ENODEV;
+		cmd->status = -ENODEV;
+		complete(&cmd->done);
+		return;
 	}
-	memcpy(subcmd->rumble_data, ctlr->rumble_data[ctlr->rumble_queue_tail],
-	       JC_RUMBLE_DATA_SIZE);
+	list_add_tail(&cmd->node, &ctlr->subcmd_queue);
+	joycon_subcmd_kick(ctlr, 0);
 	spin_unlock_irqrestore(&ctlr->lock, flags);
+}
 
-	subcmd->output_id = JC_OUTPUT_RUMBLE_AND_SUBCMD;
-	subcmd->packet_num = ctlr->subcmd_num;
-	if (++ctlr->subcmd_num > 0xF)
-		ctlr->subcmd_num = 0;
-	ctlr->subcmd_ack_match = subcmd->subcmd_id;
-	ctlr->msg_type = JOYCON_MSG_TYPE_SUBCMD;
+static int joycon_subcmd_wait(struct joycon_subcmd *cmd)
+{
+	wait_for_completion(&cmd->done);
+	return cmd->status;
+}
 
-	ret = joycon_hid_send_sync(ctlr, (u8 *)subcmd,
-				   sizeof(*subcmd) + data_len, timeout);
+/* Fails all the subcommands left once the controller is removed */
+static void joycon_subcmd_flush(struct joycon_ctlr *ctlr)
+{
+	struct joycon_subcmd *cmd;
+	unsigned long flags;
+	LIST_HEAD(done);
+
+	spin_lock_irqsave(&ctlr->lock, flags);
+	list_splice_tail_init(&ctlr->subcmd_inflight, &done);
+	list_splice_tail_init(&ctlr->subcmd_queue, &done);
+	list_for_each_entry(cmd, &done, node)
+		cmd->status = -ENODEV;
+	list_splice_init(&ctlr->subcmd_done, &done);
+	ctlr->subcmd_inflight_count = 0;
+	spin_unlock_irqrestore(&ctlr->lock, flags);
+
+	joycon_subcmd_complete(&done);
+}
+
+static int joycon_send_subcmd(struct joycon_ctlr *ctlr,
+			      struct joycon_subcmd_request *subcmd,
+			      size_t data_len, u32 timeout)
+{
+	struct joycon_subcmd cmd;
+	int ret;
+
+	if (WARN_ON(data_len > JC_SUBCMD_MAX_DATA))
+		return -EINVAL;
+
+	joycon_subcmd_init(&cmd, subcmd->subcmd_id, subcmd->data, data_len,
+			   timeout);
+	joycon_subcmd_submit(ctlr, &cmd);
+	ret = joycon_subcmd_wait(&cmd);
 	if (ret < 0)
 		hid_dbg(ctlr->hdev, "send subcommand failed; ret=%d\n", ret);
-	else
-		ret = 0;
 	return ret;
 }
 
@@ -662,54 +1038,61 @@ static int joycon_set_player_leds(struct joycon_ctlr *ctlr, u8 flash, u8 on)
 	return joycon_send_subcmd(ctlr, req, 1, HZ/4);
 }
 
-static int joycon_request_spi_flash_read(struct joycon_ctlr *ctlr,
-					 u32 start_addr, u8 size, u8 **reply)
+static void joycon_request_spi_flash_read(struct joycon_ctlr *ctlr,
+					  struct joycon_subcmd *cmd,
+					  u32 start_addr, u8 size)
 {
-	struct joycon_subcmd_request *req;
-	struct joycon_input_report *report;
-	u8 buffer[sizeof(*req) + 5] = { 0 };
-	u8 *data;
-	int ret;
+	u8 data[5];
 
-	if (!reply)
-		return -EINVAL;
-
-	req = (struct joycon_subcmd_request *)buffer;
-	req->subcmd_id = JC_SUBCMD_SPI_FLASH_READ;
-	data = req->data;
 	put_unaligned_le32(start_addr, data);
 	data[4] = size;
 
 	hid_dbg(ctlr->hdev, "requesting SPI flash data\n");
-	ret = joycon_send_subcmd(ctlr, req, 5, HZ);
+	joycon_subcmd_init(cmd, JC_SUBCMD_SPI_FLASH_READ, data, sizeof(data),
+			   HZ);
+	joycon_subcmd_submit(ctlr, cmd);
+}
+
+/* Waits for a read queued by joycon_request_spi_flash_read() */
+static int joycon_wait_spi_flash_read(struct joycon_ctlr *ctlr,
+				      struct joycon_subcmd *cmd, u8 **reply)
+{
+	struct joycon_input_report *report;
+	int ret;
+
+	ret = joycon_subcmd_wait(cmd);
 	if (ret) {
 		hid_err(ctlr->hdev, "failed reading SPI flash; ret=%d\n", ret);
-	} else {
-		report = (struct joycon_input_report *)ctlr->input_buf;
-		/* The read data starts at the 6th byte */
-		*reply = &report->subcmd_reply.data[5];
+		return ret;
 	}
-	return ret;
+
+	report = (struct joycon_input_report *)cmd->reply;
+	/* The read data starts at the 6th byte */
+	*reply = &report->subcmd_reply.data[5];
+	return 0;
 }
 
 /*
  * User calibration's presence is denoted with a magic byte preceding it.
+ * Waits for the read of the magic queued in cmd.
  * returns 0 if magic val is present, 1 if not present, < 0 on error
  */
-static int joycon_check_for_cal_magic(struct joycon_ctlr *ctlr, u32 flash_addr)
+static int joycon_check_for_cal_magic(struct joycon_ctlr *ctlr,
+				      struct joycon_subcmd *cmd)
 {
 	int ret;
 	u8 *reply;
 
-	ret = joycon_request_spi_flash_read(ctlr, flash_addr,
-					    JC_CAL_USR_MAGIC_SIZE, &reply);
+	ret = joycon_wait_spi_flash_read(ctlr, cmd, &reply);
 	if (ret)
 		return ret;
 
 	return reply[0] != JC_CAL_USR_MAGIC_0 || reply[1] != JC_CAL_USR_MAGIC_1;
 }
 
-static int joycon_read_stick_calibration(struct joycon_ctlr *ctlr, u16 cal_addr,
+/* Waits for the read of the stick calibration queued in cmd */
+static int joycon_read_stick_calibration(struct joycon_ctlr *ctlr,
+					 struct joycon_subcmd *cmd,
 					 struct joycon_stick_cal *cal_x,
 					 struct joycon_stick_cal *cal_y,
 					 bool left_stick)
@@ -721,8 +1104,7 @@ static int joycon_read_stick_calibration(struct joycon_ctlr *ctlr, u16 cal_addr,
 	u8 *raw_cal;
 	int ret;
 
-	ret = joycon_request_spi_flash_read(ctlr, cal_addr,
-					    JC_CAL_STICK_DATA_SIZE, &raw_cal);
+	ret = joycon_wait_spi_flash_read(ctlr, cmd, &raw_cal);
 	if (ret)
 		return ret;
 
@@ -766,85 +1148,92 @@ static int joycon_read_stick_calibration(struct joycon_ctlr *ctlr, u16 cal_addr,
 static const u16 DFLT_STICK_CAL_CEN = 2000;
 static const u16 DFLT_STICK_CAL_MAX = 3500;
 static const u16 DFLT_STICK_CAL_MIN = 500;
+static void joycon_use_default_stick_cal(struct joycon_stick_cal *cal)
+{
+	cal->center = DFLT_STICK_CAL_CEN;
+	cal->max = DFLT_STICK_CAL_MAX;
+	cal->min = DFLT_STICK_CAL_MIN;
+}
+
 static int joycon_request_calibration(struct joycon_ctlr *ctlr)
 {
 	u16 left_stick_addr = JC_CAL_FCT_DATA_LEFT_ADDR;
 	u16 right_stick_addr = JC_CAL_FCT_DATA_RIGHT_ADDR;
+	struct joycon_stick_cal left_x, left_y, right_x, right_y;
+	struct joycon_subcmd left, right;
+	unsigned long flags;
+	int err = 0;
 	int ret;
 
 	hid_dbg(ctlr->hdev, "requesting cal data\n");
 
 	/* check if user stick calibrations are present */
-	if (!joycon_check_for_cal_magic(ctlr, JC_CAL_USR_LEFT_MAGIC_ADDR)) {
+	joycon_request_spi_flash_read(ctlr, &left, JC_CAL_USR_LEFT_MAGIC_ADDR,
+				      JC_CAL_USR_MAGIC_SIZE);
+	joycon_request_spi_flash_read(ctlr, &right, JC_CAL_USR_RIGHT_MAGIC_ADDR,
+				      JC_CAL_USR_MAGIC_SIZE);
+	if (!joycon_check_for_cal_magic(ctlr, &left)) {
 		left_stick_addr = JC_CAL_USR_LEFT_DATA_ADDR;
 		hid_info(ctlr->hdev, "using user cal for left stick\n");
 	} else {
 		hid_info(ctlr->hdev, "using factory cal for left stick\n");
 	}
-	if (!joycon_check_for_cal_magic(ctlr, JC_CAL_USR_RIGHT_MAGIC_ADDR)) {
+	if (!joycon_check_for_cal_magic(ctlr, &right)) {
 		right_stick_addr = JC_CAL_USR_RIGHT_DATA_ADDR;
 		hid_info(ctlr->hdev, "using user cal for right stick\n");
 	} else {
 		hid_info(ctlr->hdev, "using factory cal for right stick\n");
 	}
 
-	/* read the left stick calibration data */
-	ret = joycon_read_stick_calibration(ctlr, left_stick_addr,
-					    &ctlr->left_stick_cal_x,
-					    &ctlr->left_stick_cal_y,
+	/* read the calibration data of both sticks */
+	joycon_request_spi_flash_read(ctlr, &left, left_stick_addr,
+				      JC_CAL_STICK_DATA_SIZE);
+	joycon_request_spi_flash_read(ctlr, &right, right_stick_addr,
+				      JC_CAL_STICK_DATA_SIZE);
+
+	ret = joycon_read_stick_calibration(ctlr, &left, &left_x, &left_y,
 					    true);
 	if (ret) {
 		hid_warn(ctlr->hdev,
 			 "Failed to read left stick cal, using dflts; e=%d\n",
 			 ret);
 
-		ctlr->left_stick_cal_x.center = DFLT_STICK_CAL_CEN;
-		ctlr->left_stick_cal_x.max = DFLT_STICK_CAL_MAX;
-		ctlr->left_stick_cal_x.min = DFLT_STICK_CAL_MIN;
-
-		ctlr->left_stick_cal_y.center = DFLT_STICK_CAL_CEN;
-		ctlr->left_stick_cal_y.max = DFLT_STICK_CAL_MAX;
-		ctlr->left_stick_cal_y.min = DFLT_STICK_CAL_MIN;
+		joycon_use_default_stick_cal(&left_x);
+		joycon_use_default_stick_cal(&left_y);
+		err = ret;
 	}
 
-	/* read the right stick calibration data */
-	ret = joycon_read_stick_calibration(ctlr, right_stick_addr,
-					    &ctlr->right_stick_cal_x,
-					    &ctlr->right_stick_cal_y,
+	ret = joycon_read_stick_calibration(ctlr, &right, &right_x, &right_y,
 					    false);
 	if (ret) {
 		hid_warn(ctlr->hdev,
 			 "Failed to read right stick cal, using dflts; e=%d\n",
 			 ret);
 
-		ctlr->right_stick_cal_x.center = DFLT_STICK_CAL_CEN;
-		ctlr->right_stick_cal_x.max = DFLT_STICK_CAL_MAX;
-		ctlr->right_stick_cal_x.min = DFLT_STICK_CAL_MIN;
-
-		ctlr->right_stick_cal_y.center = DFLT_STICK_CAL_CEN;
-		ctlr->right_stick_cal_y.max = DFLT_STICK_CAL_MAX;
-		ctlr->right_stick_cal_y.min = DFLT_STICK_CAL_MIN;
+		joycon_use_default_stick_cal(&right_x);
+		joycon_use_default_stick_cal(&right_y);
+		err = ret;
 	}
 
+	/* the input reports are already being parsed */
+	spin_lock_irqsave(&ctlr->lock, flags);
+	ctlr->left_stick_cal_x = left_x;
+	ctlr->left_stick_cal_y = left_y;
+	ctlr->right_stick_cal_x = right_x;
+	ctlr->right_stick_cal_y = right_y;
+	spin_unlock_irqrestore(&ctlr->lock, flags);
+
 	hid_dbg(ctlr->hdev, "calibration:\n"
 			    "l_x_c=%d l_x_max=%d l_x_min=%d\n"
 			    "l_y_c=%d l_y_max=%d l_y_min=%d\n"
 			    "r_x_c=%d r_x_max=%d r_x_min=%d\n"
 			    "r_y_c=%d r_y_max=%d r_y_min=%d\n",
-			    ctlr->left_stick_cal_x.center,
-			    ctlr->left_stick_cal_x.max,
-			    ctlr->left_stick_cal_x.min,
-			    ctlr->left_stick_cal_y.center,
-			    ctlr->left_stick_cal_y.max,
-			    ctlr->left_stick_cal_y.min,
-			    ctlr->right_stick_cal_x.center,
-			    ctlr->right_stick_cal_x.max,
-			    ctlr->right_stick_cal_x.min,
-			    ctlr->right_stick_cal_y.center,
-			    ctlr->right_stick_cal_y.max,
-			    ctlr->right_stick_cal_y.min);
+			    left_x.center, left_x.max, left_x.min,
+			    left_y.center, left_y.max, left_y.min,
+			    right_x.center, right_x.max, right_x.min,
+			    right_y.center, right_y.max, right_y.min);
 
-	return 0;
+	return err;
 }
 
 /*
@@ -868,15 +1257,33 @@ static const s16 DFLT_ACCEL_OFFSET /*= 0*/;
 static const s16 DFLT_ACCEL_SCALE = 16384;
 static const s16 DFLT_GYRO_OFFSET /*= 0*/;
 static const s16 DFLT_GYRO_SCALE  = 13371;
+static void joycon_use_default_imu_cal(struct joycon_ctlr *ctlr)
+{
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		ctlr->accel_cal.offset[i] = DFLT_ACCEL_OFFSET;
+		ctlr->accel_cal.scale[i] = DFLT_ACCEL_SCALE;
+		ctlr->gyro_cal.offset[i] = DFLT_GYRO_OFFSET;
+		ctlr->gyro_cal.scale[i] = DFLT_GYRO_SCALE;
+	}
+	joycon_calc_imu_cal_divisors(ctlr);
+}
+
 static int joycon_request_imu_calibration(struct joycon_ctlr *ctlr)
 {
 	u16 imu_cal_addr = JC_IMU_CAL_FCT_DATA_ADDR;
+	struct joycon_imu_cal accel_cal, gyro_cal;
+	struct joycon_subcmd cmd;
+	unsigned long flags;
 	u8 *raw_cal;
 	int ret;
 	int i;
 
 	/* check if user calibration exists */
-	if (!joycon_check_for_cal_magic(ctlr, JC_IMU_CAL_USR_MAGIC_ADDR)) {
+	joycon_request_spi_flash_read(ctlr, &cmd, JC_IMU_CAL_USR_MAGIC_ADDR,
+				      JC_CAL_USR_MAGIC_SIZE);
+	if (!joycon_check_for_cal_magic(ctlr, &cmd)) {
 		imu_cal_addr = JC_IMU_CAL_USR_DATA_ADDR;
 		hid_info(ctlr->hdev, "using user cal for IMU\n");
 	} else {
@@ -885,20 +1292,13 @@ static int joycon_request_imu_calibration(struct joycon_ctlr *ctlr)
 
 	/* request IMU calibration data */
 	hid_dbg(ctlr->hdev, "requesting IMU cal data\n");
-	ret = joycon_request_spi_flash_read(ctlr, imu_cal_addr,
-					    JC_IMU_CAL_DATA_SIZE, &raw_cal);
+	joycon_request_spi_flash_read(ctlr, &cmd, imu_cal_addr,
+				      JC_IMU_CAL_DATA_SIZE);
+	ret = joycon_wait_spi_flash_read(ctlr, &cmd, &raw_cal);
 	if (ret) {
 		hid_warn(ctlr->hdev,
 			 "Failed to read IMU cal, using defaults; ret=%d\n",
 			 ret);
-
-		for (i = 0; i < 3; i++) {
-			ctlr->accel_cal.offset[i] = DFLT_ACCEL_OFFSET;
-			ctlr->accel_cal.scale[i] = DFLT_ACCEL_SCALE;
-			ctlr->gyro_cal.offset[i] = DFLT_GYRO_OFFSET;
-			ctlr->gyro_cal.scale[i] = DFLT_GYRO_SCALE;
-		}
-		joycon_calc_imu_cal_divisors(ctlr);
 		return ret;
 	}
 
@@ -906,90 +1306,483 @@ static int joycon_request_imu_calibration(struct joycon_ctlr *ctlr)
 	for (i = 0; i < 3; i++) {
 		int j = i * 2;
 
-		ctlr->accel_cal.offset[i] = get_unaligned_le16(raw_cal + j);
-		ctlr->accel_cal.scale[i] = get_unaligned_le16(raw_cal + j + 6);
-		ctlr->gyro_cal.offset[i] = get_unaligned_le16(raw_cal + j + 12);
-		ctlr->gyro_cal.scale[i] = get_unaligned_le16(raw_cal + j + 18);
+		accel_cal.offset[i] = get_unaligned_le16(raw_cal + j);
+		accel_cal.scale[i] = get_unaligned_le16(raw_cal + j + 6);
+		gyro_cal.offset[i] = get_unaligned_le16(raw_cal + j + 12);
+		gyro_cal.scale[i] = get_unaligned_le16(raw_cal + j + 18);
 	}
 
+	/* the IMU reports are already being parsed */
+	spin_lock_irqsave(&ctlr->lock, flags);
+	ctlr->accel_cal = accel_cal;
+	ctlr->gyro_cal = gyro_cal;
 	joycon_calc_imu_cal_divisors(ctlr);
+	spin_unlock_irqrestore(&ctlr->lock, flags);
 
 	hid_dbg(ctlr->hdev, "IMU calibration:\n"
 			    "a_o[0]=%d a_o[1]=%d a_o[2]=%d\n"
 			    "a_s[0]=%d a_s[1]=%d a_s[2]=%d\n"
 			    "g_o[0]=%d g_o[1]=%d g_o[2]=%d\n"
 			    "g_s[0]=%d g_s[1]=%d g_s[2]=%d\n",
-			    ctlr->accel_cal.offset[0],
-			    ctlr->accel_cal.offset[1],
-			    ctlr->accel_cal.offset[2],
-			    ctlr->accel_cal.scale[0],
-			    ctlr->accel_cal.scale[1],
-			    ctlr->accel_cal.scale[2],
-			    ctlr->gyro_cal.offset[0],
-			    ctlr->gyro_cal.offset[1],
-			    ctlr->gyro_cal.offset[2],
-			    ctlr->gyro_cal.scale[0],
-			    ctlr->gyro_cal.scale[1],
-			    ctlr->gyro_cal.scale[2]);
+			    accel_cal.offset[0],
+			    accel_cal.offset[1],
+			    accel_cal.offset[2],
+			    accel_cal.scale[0],
+			    accel_cal.scale[1],
+			    accel_cal.scale[2],
+			    gyro_cal.offset[0],
+			    gyro_cal.offset[1],
+			    gyro_cal.offset[2],
+			    gyro_cal.scale[0],
+			    gyro_cal.scale[1],
+			    gyro_cal.scale[2]);
 
 	return 0;
 }
 
-static int joycon_set_report_mode(struct joycon_ctlr *ctlr)
+/*
+ * The calibration read from the SPI flash is kept across reconnects, keyed by
+ * the MAC address of the controller, so that these skip the flash reads.
+ */
+#define JC_CAL_CACHE_SIZE	16
+
+struct joycon_cal_cache_entry {
+	struct list_head node;
+	u8 mac_addr[6];
+	struct joycon_stick_cal left_stick_cal_x;
+	struct joycon_stick_cal left_stick_cal_y;
+	struct joycon_stick_cal right_stick_cal_x;
+	struct joycon_stick_cal right_stick_cal_y;
+	struct joycon_imu_cal accel_cal;
+	struct joycon_imu_cal gyro_cal;
+};
+
+/* Most recently used first */
+static LIST_HEAD(joycon_cal_cache);
+static unsigned int joycon_cal_cache_len;
+static DEFINE_MUTEX(joycon_cal_cache_mutex);
+
+static void joycon_cal_cache_flush(void)
+{
+	struct joycon_cal_cache_entry *entry, *tmp;
+
+	mutex_lock(&joycon_cal_cache_mutex);
+	list_for_each_entry_safe(entry, tmp, &joycon_cal_cache, node) {
+		list_del(&entry->node);
+		kfree(entry);
+	}
+	joycon_cal_cache_len = 0;
+	mutex_unlock(&joycon_cal_cache_mutex);
+}
+
+static bool cal_cache = true;
+
+static int cal_cache_set(const char *val, const struct kernel_param *kp)
 {
-	struct joycon_subcmd_request *req;
-	u8 buffer[sizeof(*req) + 1] = { 0 };
+	int ret = param_set_bool(val, kp);
 
-	req = (struct joycon_subcmd_request *)buffer;
-	req->subcmd_id = JC_SUBCMD_SET_REPORT_MODE;
-	req->data[0] = 0x30; /* standard, full report mode */
+	/* Any write invalidates what has been cached so far */
+	if (!ret)
+		joycon_cal_cache_flush();
+	return ret;
+}
 
-	hid_dbg(ctlr->hdev, "setting controller report mode\n");
-	return joycon_send_subcmd(ctlr, req, 1, HZ);
+static const struct kernel_param_ops cal_cache_ops = {
+	.set = cal_cache_set,
+	.get = param_get_bool,
+};
+module_param_cb(cal_cache, &cal_cache_ops, &cal_cache, 0644);
+MODULE_PARM_DESC(cal_cache,
+		 "Reuse the calibration of reconnecting controllers, any write clears the cache (default true)");
+
+/* Must be called with joycon_cal_cache_mutex held */
+static struct joycon_cal_cache_entry *
+joycon_cal_cache_find(struct joycon_ctlr *ctlr)
+{
+	struct joycon_cal_cache_entry *entry;
+
+	list_for_each_entry(entry, &joycon_cal_cache, node)
+		if (!memcmp(entry->mac_addr, ctlr->mac_addr,
+			    sizeof(entry->mac_addr)))
+			return entry;
+
+	return NULL;
 }
 
-static int joycon_enable_rumble(struct joycon_ctlr *ctlr)
+/* Installs the cached calibration, before the input devices are running */
+static bool joycon_cal_cache_get(struct joycon_ctlr *ctlr)
 {
-	struct joycon_subcmd_request *req;
-	u8 buffer[sizeof(*req) + 1] = { 0 };
+	struct joycon_cal_cache_entry *entry;
+
+	if (!READ_ONCE(cal_cache))
+		return false;
+
+	mutex_lock(&joycon_cal_cache_mutex);
+	entry = joycon_cal_cache_find(ctlr);
+	if (entry) {
+		list_move(&entry->node, &joycon_cal_cache);
+		ctlr->left_stick_cal_x = entry->left_stick_cal_x;
+		ctlr->left_stick_cal_y = entry->left_stick_cal_y;
+		ctlr->right_stick_cal_x = entry->right_stick_cal_x;
+		ctlr->right_stick_cal_y = entry->right_stick_cal_y;
+		ctlr->accel_cal = entry->accel_cal;
+		ctlr->gyro_cal = entry->gyro_cal;
+		joycon_calc_imu_cal_divisors(ctlr);
+	}
+	mutex_unlock(&joycon_cal_cache_mutex);
 
-	req = (struct joycon_subcmd_request *)buffer;
-	req->subcmd_id = JC_SUBCMD_ENABLE_VIBRATION;
-	req->data[0] = 0x01; /* note: 0x00 would disable */
+	if (!entry)
+		return false;
 
-	hid_dbg(ctlr->hdev, "enabling rumble\n");
-	return joycon_send_subcmd(ctlr, req, 1, HZ/4);
+	hid_dbg(ctlr->hdev, "using cached calibration\n");
+	return true;
 }
 
-static int joycon_enable_imu(struct joycon_ctlr *ctlr)
+static void joycon_cal_cache_put(struct joycon_ctlr *ctlr)
 {
-	struct joycon_subcmd_request *req;
-	u8 buffer[sizeof(*req) + 1] = { 0 };
+	struct joycon_cal_cache_entry *entry;
+
+	if (!READ_ONCE(cal_cache))
+		return;
+
+	mutex_lock(&joycon_cal_cache_mutex);
+	entry = joycon_cal_cache_find(ctlr);
+	if (!entry && joycon_cal_cache_len >= JC_CAL_CACHE_SIZE) {
+		/* Reuse the least recently used entry */
+		entry = list_last_entry(&joycon_cal_cache,
+					struct joycon_cal_cache_entry, node);
+	} else if (!entry) {
+		entry = kzalloc(sizeof(*entry), GFP_KERNEL);
+		if (!entry)
+			goto out;
+		list_add(&entry->node, &joycon_cal_cache);
+		joycon_cal_cache_len++;
+	}
 
-	req = (struct joycon_subcmd_request *)buffer;
-	req->subcmd_id = JC_SUBCMD_ENABLE_IMU;
-	req->data[0] = 0x01; /* note: 0x00 would disable */
+	list_move(&entry->node, &joycon_cal_cache);
+	memcpy(entry->mac_addr, ctlr->mac_addr, sizeof(entry->mac_addr));
+	/* Only this controller's cal_work writes these */
+	entry->left_stick_cal_x = ctlr->left_stick_cal_x;
+	entry->left_stick_cal_y = ctlr->left_stick_cal_y;
+	entry->right_stick_cal_x = ctlr->right_stick_cal_x;
+	entry->right_stick_cal_y = ctlr->right_stick_cal_y;
+	entry->accel_cal = ctlr->accel_cal;
+	entry->gyro_cal = ctlr->gyro_cal;
+out:
+	mutex_unlock(&joycon_cal_cache_mutex);
+}
+
+/*
+ * Reading the calibration takes several round trips to the SPI flash, the
+ * input devices start with the default calibration and this updates it.
+ */
+static void joycon_cal_worker(struct work_struct *work)
+{
+	struct joycon_ctlr *ctlr = container_of(work, struct joycon_ctlr,
+						cal_work);
+	bool complete = true;
+	int ret;
+
+	/* get controller calibration data, and parse it */
+	ret = joycon_request_calibration(ctlr);
+	if (ret) {
+		/*
+		 * We can function with default calibration, but it may be
+		 * inaccurate. Provide a warning, and continue on.
+		 */
+		hid_warn(ctlr->hdev, "Analog stick positions may be inaccurate\n");
+		complete = false;
+	}
+
+	/* get IMU calibration data, and parse it */
+	ret = joycon_request_imu_calibration(ctlr);
+	if (ret) {
+		/*
+		 * We can function with default calibration, but it may be
+		 * inaccurate. Provide a warning, and continue on.
+		 */
+		hid_warn(ctlr->hdev, "Unable to read IMU calibration data\n");
+		complete = false;
+	}
+
+	/* Don't let the defaults stick for the next connections */
+	if (complete)
+		joycon_cal_cache_put(ctlr);
+}
+
+static void joycon_set_report_mode(struct joycon_ctlr *ctlr,
+				   struct joycon_subcmd *cmd)
+{
+	static const u8 mode = 0x30; /* standard, full report mode */
+
+	hid_dbg(ctlr->hdev, "setting controller report mode\n");
+	joycon_subcmd_init(cmd, JC_SUBCMD_SET_REPORT_MODE, &mode, 1, HZ);
+	joycon_subcmd_submit(ctlr, cmd);
+}
+
+static void joycon_enable_rumble(struct joycon_ctlr *ctlr,
+				 struct joycon_subcmd *cmd)
+{
+	static const u8 enable = 0x01; /* note: 0x00 would disable */
+
+	hid_dbg(ctlr->hdev, "enabling rumble\n");
+	joycon_subcmd_init(cmd, JC_SUBCMD_ENABLE_VIBRATION, &enable, 1, HZ/4);
+	joycon_subcmd_submit(ctlr, cmd);
+}
+
+static void joycon_enable_imu(struct joycon_ctlr *ctlr,
+			      struct joycon_subcmd *cmd)
+{
+	static const u8 enable = 0x01; /* note: 0x00 would disable */
 
 	hid_dbg(ctlr->hdev, "enabling IMU\n");
-	return joycon_send_subcmd(ctlr, req, 1, HZ);
+	joycon_subcmd_init(cmd, JC_SUBCMD_ENABLE_IMU, &enable, 1, HZ);
+	joycon_subcmd_submit(ctlr, cmd);
+}
+
+static s32 joycon_map_stick_val(struct joycon_stick_cal *cal, s32 val)
+{
+	s32 center = cal->center;
+	s32 min = cal->min;
+	s32 max = cal->max;
+	s32 new_val;
+
+	if (val > center) {
+		new_val = (val - center) * JC_MAX_STICK_MAG;
+		new_val /= (max - center);
+	} else {
+		new_val = (center - val) * -JC_MAX_STICK_MAG;
+		new_val /= (center - min);
+	}
+	new_val = clamp(new_val, (s32)-JC_MAX_STICK_MAG, (s32)JC_MAX_STICK_MAG);
+	if (abs(new_val) <= stick_deadzone)
+		new_val = 0;
+	return new_val;
+}
+
+/* Snapshot of the stick calibration, taken under the lock for each report */
+struct joycon_sticks_cal {
+	struct joycon_stick_cal left_x, left_y, right_x, right_y;
+};
+
+/*
+ * The report parsing specialised for each type of controller, so that the
+ * type, which never changes once known, is not tested again per report. A
+ * Joy-Con in the charging grip is parsed as the Joy-Con it is.
+ */
+struct joycon_parser {
+	/* fills in the values for the buttons and sticks, returns how many */
+	unsigned int (*parse)(struct joycon_ctlr *ctlr,
+			      struct joycon_input_report *rep,
+			      struct joycon_sticks_cal *cal,
+			      struct input_value *vals);
+	/* multiplies the gyro x/y/z then accel x/y/z values */
+	s8 imu_sign[6];
+	/* the S buttons, which a pair does not report */
+	u16 s_btns[2];
+};
+
+struct joycon_btn {
+	u32 mask;
+	u16 code;
+};
+
+static const struct joycon_btn joycon_left_btns[] = {
+	{ JC_BTN_L,	 BTN_TL },
+	{ JC_BTN_ZL,	 BTN_TL2 },
+	{ JC_BTN_MINUS,	 BTN_SELECT },
+	{ JC_BTN_LSTICK, BTN_THUMBL },
+	{ JC_BTN_CAP,	 BTN_Z },
+	/* the S buttons as the non-existent triggers */
+	{ JC_BTN_SL_L,	 BTN_TR },
+	{ JC_BTN_SR_L,	 BTN_TR2 },
+	/* the d-pad as digital buttons */
+	{ JC_BTN_DOWN,	 BTN_DPAD_DOWN },
+	{ JC_BTN_UP,	 BTN_DPAD_UP },
+	{ JC_BTN_RIGHT,	 BTN_DPAD_RIGHT },
+	{ JC_BTN_LEFT,	 BTN_DPAD_LEFT },
+};
+
+static const struct joycon_btn joycon_right_btns[] = {
+	{ JC_BTN_R,	 BTN_TR },
+	{ JC_BTN_ZR,	 BTN_TR2 },
+	/* the S buttons as the non-existent triggers */
+	{ JC_BTN_SL_R,	 BTN_TL },
+	{ JC_BTN_SR_R,	 BTN_TL2 },
+	{ JC_BTN_PLUS,	 BTN_START },
+	{ JC_BTN_RSTICK, BTN_THUMBR },
+	{ JC_BTN_HOME,	 BTN_MODE },
+	{ JC_BTN_Y,	 BTN_WEST },
+	{ JC_BTN_X,	 BTN_NORTH },
+	{ JC_BTN_A,	 BTN_EAST },
+	{ JC_BTN_B,	 BTN_SOUTH },
+};
+
+static const struct joycon_btn joycon_pro_left_btns[] = {
+	{ JC_BTN_L,	 BTN_TL },
+	{ JC_BTN_ZL,	 BTN_TL2 },
+	{ JC_BTN_MINUS,	 BTN_SELECT },
+	{ JC_BTN_LSTICK, BTN_THUMBL },
+	{ JC_BTN_CAP,	 BTN_Z },
+};
+
+static const struct joycon_btn joycon_pro_right_btns[] = {
+	{ JC_BTN_R,	 BTN_TR },
+	{ JC_BTN_ZR,	 BTN_TR2 },
+	{ JC_BTN_PLUS,	 BTN_START },
+	{ JC_BTN_RSTICK, BTN_THUMBR },
+	{ JC_BTN_HOME,	 BTN_MODE },
+	{ JC_BTN_Y,	 BTN_WEST },
+	{ JC_BTN_X,	 BTN_NORTH },
+	{ JC_BTN_A,	 BTN_EAST },
+	{ JC_BTN_B,	 BTN_SOUTH },
+};
+
+static unsigned int joycon_report_btns(u32 btns, const struct joycon_btn *map,
+				       unsigned int count,
+				       struct input_value *vals)
+{
+	unsigned int i;
+
+	for (i = 0; i < count; i++)
+		vals[i] = JC_VALUE(EV_KEY, map[i].code, !!(btns & map[i].mask));
+	return count;
+}
+
+static unsigned int joycon_report_stick(struct joycon_ctlr *ctlr, u8 *raw,
+					struct joycon_stick_cal *cal_x,
+					struct joycon_stick_cal *cal_y,
+					unsigned int code_x,
+					unsigned int code_y,
+					struct input_value *vals)
+{
+	u16 raw_x = hid_field_extract(ctlr->hdev, raw, 0, 12);
+	u16 raw_y = hid_field_extract(ctlr->hdev, raw + 1, 4, 12);
+
+	vals[0] = JC_VALUE(EV_ABS, code_x, joycon_map_stick_val(cal_x, raw_x));
+	vals[1] = JC_VALUE(EV_ABS, code_y, -joycon_map_stick_val(cal_y, raw_y));
+	return 2;
+}
+
+static u32 joycon_report_btns_status(struct joycon_ctlr *ctlr,
+				     struct joycon_input_report *rep)
+{
+	return hid_field_extract(ctlr->hdev, rep->button_status, 0, 24);
+}
+
+static unsigned int joycon_parse_left(struct joycon_ctlr *ctlr,
+				      struct joycon_input_report *rep,
+				      struct joycon_sticks_cal *cal,
+				      struct input_value *vals)
+{
+	u32 btns = joycon_report_btns_status(ctlr, rep);
+	unsigned int n;
+
+	n = joycon_report_stick(ctlr, rep->left_stick, &cal->left_x,
+				&cal->left_y, ABS_X, ABS_Y, vals);
+	n += joycon_report_btns(btns, joycon_left_btns,
+				ARRAY_SIZE(joycon_left_btns), vals + n);
+	return n;
+}
+
+static unsigned int joycon_parse_right(struct joycon_ctlr *ctlr,
+				       struct joycon_input_report *rep,
+				       struct joycon_sticks_cal *cal,
+				       struct input_value *vals)
+{
+	u32 btns = joycon_report_btns_status(ctlr, rep);
+	unsigned int n;
+
+	n = joycon_report_stick(ctlr, rep->right_stick, &cal->right_x,
+				&cal->right_y, ABS_RX, ABS_RY, vals);
+	n += joycon_report_btns(btns, joycon_right_btns,
+				ARRAY_SIZE(joycon_right_btns), vals + n);
+	return n;
+}
+
+static unsigned int joycon_parse_pro(struct joycon_ctlr *ctlr,
+				     struct joycon_input_report *rep,
+				     struct joycon_sticks_cal *cal,
+				     struct input_value *vals)
+{
+	u32 btns = joycon_report_btns_status(ctlr, rep);
+	int hatx = 0;
+	int haty = 0;
+	unsigned int n;
+
+	n = joycon_report_stick(ctlr, rep->left_stick, &cal->left_x,
+				&cal->left_y, ABS_X, ABS_Y, vals);
+	n += joycon_report_btns(btns, joycon_pro_left_btns,
+				ARRAY_SIZE(joycon_pro_left_btns), vals + n);
+
+	/* d-pad x */
+	if (btns & JC_BTN_LEFT)
+		hatx = -1;
+	else if (btns & JC_BTN_RIGHT)
+		hatx = 1;
+	vals[n++] = JC_VALUE(EV_ABS, ABS_HAT0X, hatx);
+
+	/* d-pad y */
+	if (btns & JC_BTN_UP)
+		haty = -1;
+	else if (btns & JC_BTN_DOWN)
+		haty = 1;
+	vals[n++] = JC_VALUE(EV_ABS, ABS_HAT0Y, haty);
+
+	n += joycon_report_stick(ctlr, rep->right_stick, &cal->right_x,
+				 &cal->right_y, ABS_RX, ABS_RY, vals + n);
+	n += joycon_report_btns(btns, joycon_pro_right_btns,
+				ARRAY_SIZE(joycon_pro_right_btns), vals + n);
+	return n;
 }
 
-static s32 joycon_map_stick_val(struct joycon_stick_cal *cal, s32 val)
+/* Until the type is known, or if it is not one we know of */
+static unsigned int joycon_parse_none(struct joycon_ctlr *ctlr,
+				      struct joycon_input_report *rep,
+				      struct joycon_sticks_cal *cal,
+				      struct input_value *vals)
 {
-	s32 center = cal->center;
-	s32 min = cal->min;
-	s32 max = cal->max;
-	s32 new_val;
+	return 0;
+}
 
-	if (val > center) {
-		new_val = (val - center) * JC_MAX_STICK_MAG;
-		new_val /= (max - center);
-	} else {
-		new_val = (center - val) * -JC_MAX_STICK_MAG;
-		new_val /= (center - min);
-	}
-	new_val = clamp(new_val, (s32)-JC_MAX_STICK_MAG, (s32)JC_MAX_STICK_MAG);
-	return new_val;
+static const struct joycon_parser joycon_parser_none = {
+	.parse = joycon_parse_none,
+	.imu_sign = { 1, 1, 1, 1, 1, 1 },
+};
+
+static const struct joycon_parser joycon_parsers[] = {
+	[JOYCON_CTLR_TYPE_JCL] = {
+		.parse = joycon_parse_left,
+		.imu_sign = { 1, 1, 1, 1, 1, 1 },
+		.s_btns = { BTN_TR, BTN_TR2 },
+	},
+	[JOYCON_CTLR_TYPE_JCR] = {
+		.parse = joycon_parse_right,
+		/*
+		 * The right joy-con has 2 axes negated, Y and Z. This is due
+		 * to the orientation of the IMU in the controller. We negate
+		 * those axes' values in order to be consistent with the left
+		 * joy-con and the pro controller:
+		 *   X: positive is pointing toward the triggers
+		 *   Y: positive is pointing to the left
+		 *   Z: positive is pointing up (out of the buttons/sticks)
+		 * The axes follow the right-hand rule.
+		 */
+		.imu_sign = { 1, -1, -1, 1, -1, -1 },
+		.s_btns = { BTN_TL, BTN_TL2 },
+	},
+	[JOYCON_CTLR_TYPE_PRO] = {
+		.parse = joycon_parse_pro,
+		.imu_sign = { 1, 1, 1, 1, 1, 1 },
+	},
+};
+
+static const struct joycon_parser *
+joycon_get_parser(enum joycon_ctlr_type type)
+{
+	if (type >= ARRAY_SIZE(joycon_parsers) || !joycon_parsers[type].parse)
+		return &joycon_parser_none;
+	return &joycon_parsers[type];
 }
 
 static void joycon_input_report_parse_imu_data(struct joycon_ctlr *ctlr,
@@ -1013,18 +1806,62 @@ static void joycon_input_report_parse_imu_data(struct joycon_ctlr *ctlr,
 	}
 }
 
+#ifdef CONFIG_HID_NINTENDO_SWITCH_IIO
+/* One buffer scan, in the order of joycon_iio_channels */
+struct joycon_iio_scan {
+	s32 accel[3];
+	s32 gyro[3];
+	s64 timestamp __aligned(8);
+};
+
+static void joycon_push_imu(struct joycon_ctlr *ctlr,
+			    const struct joycon_iio_scan *scans)
+{
+	struct iio_dev *indio_dev = ctlr->indio_dev;
+	s64 now, period;
+	int i;
+
+	if (!indio_dev || !iio_buffer_enabled(indio_dev))
+		return;
+
+	/* The three samples were taken over the period before the report */
+	now = iio_get_time_ns(indio_dev);
+	period = ctlr->imu_avg_delta_ms * NSEC_PER_MSEC / 3;
+	for (i = 0; i < 3; i++)
+		iio_push_to_buffers_with_timestamp(indio_dev, (void *)&scans[i],
+						   now - (2 - i) * period);
+}
+#endif
+
 static void joycon_parse_imu_report(struct joycon_ctlr *ctlr,
 				    struct joycon_input_report *rep)
 {
 	struct joycon_imu_data imu_data[3] = {0}; /* 3 reports per packet */
 	struct input_dev *idev = ctlr->imu_input;
+	struct input_value vals[JC_IMU_SAMPLE_VALUES * 3];
+	unsigned int n = 0;
 	unsigned int msecs = jiffies_to_msecs(jiffies);
 	unsigned int last_msecs = ctlr->imu_last_pkt_ms;
-	int i;
+	struct joycon_imu_cal accel_cal, gyro_cal;
+	s32 accel_divisor[3], gyro_divisor[3];
+	const s8 *imu_sign = ctlr->parser->imu_sign;
+#ifdef CONFIG_HID_NINTENDO_SWITCH_IIO
+	struct joycon_iio_scan scans[3];
+#endif
+	unsigned long flags;
+	int i, j;
 	int value[6];
 
 	joycon_input_report_parse_imu_data(ctlr, rep, imu_data);
 
+	/* cal_work may update the calibration at any time */
+	spin_lock_irqsave(&ctlr->lock, flags);
+	accel_cal = ctlr->accel_cal;
+	gyro_cal = ctlr->gyro_cal;
+	memcpy(accel_divisor, ctlr->imu_cal_accel_divisor, sizeof(accel_divisor));
+	memcpy(gyro_divisor, ctlr->imu_cal_gyro_divisor, sizeof(gyro_divisor));
+	spin_unlock_irqrestore(&ctlr->lock, flags);
+
 	/*
 	 * There are complexities surrounding how we determine the timestamps we
 	 * associate with the samples we pass to userspace. The IMU input
@@ -1123,8 +1960,8 @@ static void joycon_parse_imu_report(struct joycon_ctlr *ctlr,
 
 	/* Each IMU input report contains three samples */
 	for (i = 0; i < 3; i++) {
-		input_event(idev, EV_MSC, MSC_TIMESTAMP,
-			    ctlr->imu_timestamp_us);
+		vals[n++] = JC_VALUE(EV_MSC, MSC_TIMESTAMP,
+				     ctlr->imu_timestamp_us);
 
 		/*
 		 * These calculations (which use the controller's calibration
@@ -1146,29 +1983,29 @@ static void joycon_parse_imu_report(struct joycon_ctlr *ctlr,
 		 */
 		value[0] = mult_frac((JC_IMU_PREC_RANGE_SCALE *
 				      (imu_data[i].gyro_x -
-				       ctlr->gyro_cal.offset[0])),
-				     ctlr->gyro_cal.scale[0],
-				     ctlr->imu_cal_gyro_divisor[0]);
+				       gyro_cal.offset[0])),
+				     gyro_cal.scale[0],
+				     gyro_divisor[0]);
 		value[1] = mult_frac((JC_IMU_PREC_RANGE_SCALE *
 				      (imu_data[i].gyro_y -
-				       ctlr->gyro_cal.offset[1])),
-				     ctlr->gyro_cal.scale[1],
-				     ctlr->imu_cal_gyro_divisor[1]);
+				       gyro_cal.offset[1])),
+				     gyro_cal.scale[1],
+				     gyro_divisor[1]);
 		value[2] = mult_frac((JC_IMU_PREC_RANGE_SCALE *
 				      (imu_data[i].gyro_z -
-				       ctlr->gyro_cal.offset[2])),
-				     ctlr->gyro_cal.scale[2],
-				     ctlr->imu_cal_gyro_divisor[2]);
+				       gyro_cal.offset[2])),
+				     gyro_cal.scale[2],
+				     gyro_divisor[2]);
 
 		value[3] = ((s32)imu_data[i].accel_x *
-			    ctlr->accel_cal.scale[0]) /
-			    ctlr->imu_cal_accel_divisor[0];
+			    accel_cal.scale[0]) /
+			    accel_divisor[0];
 		value[4] = ((s32)imu_data[i].accel_y *
-			    ctlr->accel_cal.scale[1]) /
-			    ctlr->imu_cal_accel_divisor[1];
+			    accel_cal.scale[1]) /
+			    accel_divisor[1];
 		value[5] = ((s32)imu_data[i].accel_z *
-			    ctlr->accel_cal.scale[2]) /
-			    ctlr->imu_cal_accel_divisor[2];
+			    accel_cal.scale[2]) /
+			    accel_divisor[2];
 
 		hid_dbg(ctlr->hdev, "raw_gyro: g_x=%d g_y=%d g_z=%d\n",
 			imu_data[i].gyro_x, imu_data[i].gyro_y,
@@ -1177,50 +2014,80 @@ static void joycon_parse_imu_report(struct joycon_ctlr *ctlr,
 			imu_data[i].accel_x, imu_data[i].accel_y,
 			imu_data[i].accel_z);
 
-		/*
-		 * The right joy-con has 2 axes negated, Y and Z. This is due to
-		 * the orientation of the IMU in the controller. We negate those
-		 * axes' values in order to be consistent with the left joy-con
-		 * and the pro controller:
-		 *   X: positive is pointing toward the triggers
-		 *   Y: positive is pointing to the left
-		 *   Z: positive is pointing up (out of the buttons/sticks)
-		 * The axes follow the right-hand rule.
-		 */
-		if (jc_type_is_joycon(ctlr) && jc_type_has_right(ctlr)) {
-			int j;
-
-			/* negate all but x axis */
-			for (j = 1; j < 6; ++j) {
-				if (j == 3)
-					continue;
-				value[j] *= -1;
-			}
-		}
-
-		input_report_abs(idev, ABS_RX, value[0]);
-		input_report_abs(idev, ABS_RY, value[1]);
-		input_report_abs(idev, ABS_RZ, value[2]);
-		input_report_abs(idev, ABS_X, value[3]);
-		input_report_abs(idev, ABS_Y, value[4]);
-		input_report_abs(idev, ABS_Z, value[5]);
-		input_sync(idev);
+		/* orient the axes the same for all, see joycon_parsers */
+		for (j = 0; j < 6; j++)
+			value[j] *= imu_sign[j];
+
+		vals[n++] = JC_VALUE(EV_ABS, ABS_RX, value[0]);
+		vals[n++] = JC_VALUE(EV_ABS, ABS_RY, value[1]);
+		vals[n++] = JC_VALUE(EV_ABS, ABS_RZ, value[2]);
+		vals[n++] = JC_VALUE(EV_ABS, ABS_X, value[3]);
+		vals[n++] = JC_VALUE(EV_ABS, ABS_Y, value[4]);
+		vals[n++] = JC_VALUE(EV_ABS, ABS_Z, value[5]);
+		vals[n++] = JC_VALUE(EV_SYN, SYN_REPORT, 0);
 		/* convert to micros and divide by 3 (3 samples per report). */
 		ctlr->imu_timestamp_us += ctlr->imu_avg_delta_ms * 1000 / 3;
+
+#ifdef CONFIG_HID_NINTENDO_SWITCH_IIO
+		memcpy(scans[i].gyro, &value[0], sizeof(scans[i].gyro));
+		memcpy(scans[i].accel, &value[3], sizeof(scans[i].accel));
+#endif
+	}
+
+	/* All three samples are submitted as separate frames in one go */
+	input_event_values(idev, vals, n);
+#ifdef CONFIG_HID_NINTENDO_SWITCH_IIO
+	joycon_push_imu(ctlr, scans);
+#endif
+}
+
+/* The S buttons of a Joy-Con are meaningless once it is part of a pair */
+static bool joycon_is_s_button(struct joycon_ctlr *ctlr,
+			       const struct input_value *val)
+{
+	const u16 *s_btns = ctlr->parser->s_btns;
+
+	return val->type == EV_KEY &&
+		(val->code == s_btns[0] || val->code == s_btns[1]);
+}
+
+static void joycon_pair_report(struct joycon_ctlr *ctlr,
+			       const struct input_value *vals,
+			       unsigned int count)
+{
+	struct input_value pair_vals[JC_MAX_FRAME_VALUES];
+	struct joycon_pair *pair;
+	unsigned int i;
+	unsigned int n = 0;
+
+	rcu_read_lock();
+	pair = rcu_dereference(ctlr->pair);
+	if (pair) {
+		for (i = 0; i < count; i++)
+			if (!joycon_is_s_button(ctlr, &vals[i]))
+				pair_vals[n++] = vals[i];
+		input_event_values(pair->input, pair_vals, n);
 	}
+	rcu_read_unlock();
 }
 
 static void joycon_parse_report(struct joycon_ctlr *ctlr,
 				struct joycon_input_report *rep)
 {
 	struct input_dev *dev = ctlr->input;
+	const struct joycon_parser *parser = ctlr->parser;
+	struct input_value vals[JC_MAX_FRAME_VALUES];
+	struct joycon_sticks_cal cal;
+	unsigned int n;
 	unsigned long flags;
 	u8 tmp;
-	u32 btns;
 	unsigned long msecs = jiffies_to_msecs(jiffies);
 
 	spin_lock_irqsave(&ctlr->lock, flags);
-	if (IS_ENABLED(CONFIG_NINTENDO_FF) && rep->vibrator_report &&
+	if (IS_ENABLED(CONFIG_NINTENDO_FF) && ctlr->rumble_pending) {
+		/* Right after a report is the best time for a new effect */
+		hid_queue_output_work(&ctlr->rumble_worker);
+	} else if (IS_ENABLED(CONFIG_NINTENDO_FF) && rep->vibrator_report &&
 	    (msecs - ctlr->rumble_msecs) >= JC_RUMBLE_PERIOD_MS &&
 	    (ctlr->rumble_queue_head != ctlr->rumble_queue_tail ||
 	     ctlr->rumble_zero_countdown > 0)) {
@@ -1232,7 +2099,7 @@ static void joycon_parse_report(struct joycon_ctlr *ctlr,
 		 */
 		if (ctlr->rumble_zero_countdown > 0)
 			ctlr->rumble_zero_countdown--;
-		queue_work(ctlr->rumble_queue, &ctlr->rumble_worker);
+		hid_queue_output_work(&ctlr->rumble_worker);
 	}
 
 	/* Parse the battery status */
@@ -1261,102 +2128,22 @@ static void joycon_parse_report(struct joycon_ctlr *ctlr,
 		hid_warn(ctlr->hdev, "Invalid battery status\n");
 		break;
 	}
+
+	/* cal_work may update the calibration at any time */
+	cal.left_x = ctlr->left_stick_cal_x;
+	cal.left_y = ctlr->left_stick_cal_y;
+	cal.right_x = ctlr->right_stick_cal_x;
+	cal.right_y = ctlr->right_stick_cal_y;
 	spin_unlock_irqrestore(&ctlr->lock, flags);
 
 	/* Parse the buttons and sticks */
-	btns = hid_field_extract(ctlr->hdev, rep->button_status, 0, 24);
+	n = INDIRECT_CALL_3(parser->parse, joycon_parse_pro, joycon_parse_left,
+			    joycon_parse_right, ctlr, rep, &cal, vals);
 
-	if (jc_type_has_left(ctlr)) {
-		u16 raw_x;
-		u16 raw_y;
-		s32 x;
-		s32 y;
-
-		/* get raw stick values */
-		raw_x = hid_field_extract(ctlr->hdev, rep->left_stick, 0, 12);
-		raw_y = hid_field_extract(ctlr->hdev,
-					  rep->left_stick + 1, 4, 12);
-		/* map the stick values */
-		x = joycon_map_stick_val(&ctlr->left_stick_cal_x, raw_x);
-		y = -joycon_map_stick_val(&ctlr->left_stick_cal_y, raw_y);
-		/* report sticks */
-		input_report_abs(dev, ABS_X, x);
-		input_report_abs(dev, ABS_Y, y);
-
-		/* report buttons */
-		input_report_key(dev, BTN_TL, btns & JC_BTN_L);
-		input_report_key(dev, BTN_TL2, btns & JC_BTN_ZL);
-		input_report_key(dev, BTN_SELECT, btns & JC_BTN_MINUS);
-		input_report_key(dev, BTN_THUMBL, btns & JC_BTN_LSTICK);
-		input_report_key(dev, BTN_Z, btns & JC_BTN_CAP);
-
-		if (jc_type_is_joycon(ctlr)) {
-			/* Report the S buttons as the non-existent triggers */
-			input_report_key(dev, BTN_TR, btns & JC_BTN_SL_L);
-			input_report_key(dev, BTN_TR2, btns & JC_BTN_SR_L);
-
-			/* Report d-pad as digital buttons for the joy-cons */
-			input_report_key(dev, BTN_DPAD_DOWN,
-					 btns & JC_BTN_DOWN);
-			input_report_key(dev, BTN_DPAD_UP, btns & JC_BTN_UP);
-			input_report_key(dev, BTN_DPAD_RIGHT,
-					 btns & JC_BTN_RIGHT);
-			input_report_key(dev, BTN_DPAD_LEFT,
-					 btns & JC_BTN_LEFT);
-		} else {
-			int hatx = 0;
-			int haty = 0;
-
-			/* d-pad x */
-			if (btns & JC_BTN_LEFT)
-				hatx = -1;
-			else if (btns & JC_BTN_RIGHT)
-				hatx = 1;
-			input_report_abs(dev, ABS_HAT0X, hatx);
-
-			/* d-pad y */
-			if (btns & JC_BTN_UP)
-				haty = -1;
-			else if (btns & JC_BTN_DOWN)
-				haty = 1;
-			input_report_abs(dev, ABS_HAT0Y, haty);
-		}
-	}
-	if (jc_type_has_right(ctlr)) {
-		u16 raw_x;
-		u16 raw_y;
-		s32 x;
-		s32 y;
-
-		/* get raw stick values */
-		raw_x = hid_field_extract(ctlr->hdev, rep->right_stick, 0, 12);
-		raw_y = hid_field_extract(ctlr->hdev,
-					  rep->right_stick + 1, 4, 12);
-		/* map stick values */
-		x = joycon_map_stick_val(&ctlr->right_stick_cal_x, raw_x);
-		y = -joycon_map_stick_val(&ctlr->right_stick_cal_y, raw_y);
-		/* report sticks */
-		input_report_abs(dev, ABS_RX, x);
-		input_report_abs(dev, ABS_RY, y);
-
-		/* report buttons */
-		input_report_key(dev, BTN_TR, btns & JC_BTN_R);
-		input_report_key(dev, BTN_TR2, btns & JC_BTN_ZR);
-		if (jc_type_is_joycon(ctlr)) {
-			/* Report the S buttons as the non-existent triggers */
-			input_report_key(dev, BTN_TL, btns & JC_BTN_SL_R);
-			input_report_key(dev, BTN_TL2, btns & JC_BTN_SR_R);
-		}
-		input_report_key(dev, BTN_START, btns & JC_BTN_PLUS);
-		input_report_key(dev, BTN_THUMBR, btns & JC_BTN_RSTICK);
-		input_report_key(dev, BTN_MODE, btns & JC_BTN_HOME);
-		input_report_key(dev, BTN_WEST, btns & JC_BTN_Y);
-		input_report_key(dev, BTN_NORTH, btns & JC_BTN_X);
-		input_report_key(dev, BTN_EAST, btns & JC_BTN_A);
-		input_report_key(dev, BTN_SOUTH, btns & JC_BTN_B);
-	}
+	vals[n++] = JC_VALUE(EV_SYN, SYN_REPORT, 0);
 
-	input_sync(dev);
+	input_event_values(dev, vals, n);
+	joycon_pair_report(ctlr, vals, n);
 
 	/*
 	 * Immediately after receiving a report is the most reliable time to
@@ -1373,6 +2160,9 @@ static void joycon_parse_report(struct joycon_ctlr *ctlr,
 	/* parse IMU data if present */
 	if (rep->id == JC_INPUT_IMU_DATA)
 		joycon_parse_imu_report(ctlr, rep);
+
+	/* The buttons and IMU frames above are one report. */
+	input_group_sync(dev);
 }
 
 static int joycon_send_rumble_data(struct joycon_ctlr *ctlr)
@@ -1410,64 +2200,73 @@ static int joycon_send_rumble_data(struct joycon_ctlr *ctlr)
 static void joycon_rumble_worker(struct work_struct *work)
 {
 	struct joycon_ctlr *ctlr = container_of(work, struct joycon_ctlr,
-							rumble_worker);
+							rumble_worker.work);
 	unsigned long flags;
-	bool again = true;
 	int ret;
 
-	while (again) {
-		mutex_lock(&ctlr->output_mutex);
-		ret = joycon_send_rumble_data(ctlr);
-		mutex_unlock(&ctlr->output_mutex);
+	/*
+	 * Only the latest amplitude matters, the entries it replaced would
+	 * just play late.
+	 */
+	spin_lock_irqsave(&ctlr->lock, flags);
+	ctlr->rumble_queue_tail = ctlr->rumble_queue_head;
+	ctlr->rumble_pending = false;
+	spin_unlock_irqrestore(&ctlr->lock, flags);
 
-		/* -ENODEV means the controller was just unplugged */
-		spin_lock_irqsave(&ctlr->lock, flags);
-		if (ret < 0 && ret != -ENODEV &&
-		    ctlr->ctlr_state != JOYCON_CTLR_STATE_REMOVED)
-			hid_warn(ctlr->hdev, "Failed to set rumble; e=%d", ret);
-
-		ctlr->rumble_msecs = jiffies_to_msecs(jiffies);
-		if (ctlr->rumble_queue_tail != ctlr->rumble_queue_head) {
-			if (++ctlr->rumble_queue_tail >= JC_RUMBLE_QUEUE_SIZE)
-				ctlr->rumble_queue_tail = 0;
-		} else {
-			again = false;
-		}
-		spin_unlock_irqrestore(&ctlr->lock, flags);
-	}
+	mutex_lock(&ctlr->output_mutex);
+	ret = joycon_send_rumble_data(ctlr);
+	mutex_unlock(&ctlr->output_mutex);
+
+	/* -ENODEV means the controller was just unplugged */
+	spin_lock_irqsave(&ctlr->lock, flags);
+	if (ret < 0 && ret != -ENODEV &&
+	    ctlr->ctlr_state != JOYCON_CTLR_STATE_REMOVED)
+		hid_warn_ratelimited(ctlr->hdev, "Failed to set rumble; e=%d\n",
+				     ret);
+
+	ctlr->rumble_msecs = jiffies_to_msecs(jiffies);
+	spin_unlock_irqrestore(&ctlr->lock, flags);
 }
 
 #if IS_ENABLED(CONFIG_NINTENDO_FF)
+/*
+ * Both tables are sorted, the entry to use is the first one which is at least
+ * as large as the request, or the last one.
+ */
 static struct joycon_rumble_freq_data joycon_find_rumble_freq(u16 freq)
 {
-	const size_t length = ARRAY_SIZE(joycon_rumble_frequencies);
 	const struct joycon_rumble_freq_data *data = joycon_rumble_frequencies;
-	int i = 0;
+	size_t lo = 0;
+	size_t hi = ARRAY_SIZE(joycon_rumble_frequencies) - 1;
 
-	if (freq > data[0].freq) {
-		for (i = 1; i < length - 1; i++) {
-			if (freq > data[i - 1].freq && freq <= data[i].freq)
-				break;
-		}
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+
+		if (data[mid].freq < freq)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
 
-	return data[i];
+	return data[lo];
 }
 
 static struct joycon_rumble_amp_data joycon_find_rumble_amp(u16 amp)
 {
-	const size_t length = ARRAY_SIZE(joycon_rumble_amplitudes);
 	const struct joycon_rumble_amp_data *data = joycon_rumble_amplitudes;
-	int i = 0;
+	size_t lo = 0;
+	size_t hi = ARRAY_SIZE(joycon_rumble_amplitudes) - 1;
 
-	if (amp > data[0].amp) {
-		for (i = 1; i < length - 1; i++) {
-			if (amp > data[i - 1].amp && amp <= data[i].amp)
-				break;
-		}
+	while (lo < hi) {
+		size_t mid = (lo + hi) / 2;
+
+		if (data[mid].amp < amp)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
 
-	return data[i];
+	return data[lo];
 }
 
 static void joycon_encode_rumble(u8 *data, u16 freq_low, u16 freq_high, u16 amp)
@@ -1545,11 +2344,17 @@ static int joycon_set_rumble(struct joycon_ctlr *ctlr, u16 amp_r, u16 amp_l,
 		ctlr->rumble_queue_head = 0;
 	memcpy(ctlr->rumble_data[ctlr->rumble_queue_head], data,
 	       JC_RUMBLE_DATA_SIZE);
-	spin_unlock_irqrestore(&ctlr->lock, flags);
 
-	/* don't wait for the periodic send (reduces latency) */
-	if (schedule_now)
-		queue_work(ctlr->rumble_queue, &ctlr->rumble_worker);
+	/*
+	 * Don't wait for the periodic send (reduces latency), but go out right
+	 * after the next report, which is when the controller takes it best.
+	 */
+	if (schedule_now) {
+		ctlr->rumble_pending = true;
+		if (ctlr->ctlr_state != JOYCON_CTLR_STATE_READ)
+			hid_queue_output_work(&ctlr->rumble_worker);
+	}
+	spin_unlock_irqrestore(&ctlr->lock, flags);
 
 	return 0;
 }
@@ -1639,10 +2444,10 @@ static int joycon_input_create(struct joycon_ctlr *ctlr)
 	if (jc_type_has_left(ctlr)) {
 		input_set_abs_params(ctlr->input, ABS_X,
 				     -JC_MAX_STICK_MAG, JC_MAX_STICK_MAG,
-				     JC_STICK_FUZZ, JC_STICK_FLAT);
+				     stick_fuzz, stick_deadzone);
 		input_set_abs_params(ctlr->input, ABS_Y,
 				     -JC_MAX_STICK_MAG, JC_MAX_STICK_MAG,
-				     JC_STICK_FUZZ, JC_STICK_FLAT);
+				     stick_fuzz, stick_deadzone);
 
 		for (i = 0; joycon_button_inputs_l[i] > 0; i++)
 			input_set_capability(ctlr->input, EV_KEY,
@@ -1665,10 +2470,10 @@ static int joycon_input_create(struct joycon_ctlr *ctlr)
 	if (jc_type_has_right(ctlr)) {
 		input_set_abs_params(ctlr->input, ABS_RX,
 				     -JC_MAX_STICK_MAG, JC_MAX_STICK_MAG,
-				     JC_STICK_FUZZ, JC_STICK_FLAT);
+				     stick_fuzz, stick_deadzone);
 		input_set_abs_params(ctlr->input, ABS_RY,
 				     -JC_MAX_STICK_MAG, JC_MAX_STICK_MAG,
-				     JC_STICK_FUZZ, JC_STICK_FLAT);
+				     stick_fuzz, stick_deadzone);
 
 		for (i = 0; joycon_button_inputs_r[i] > 0; i++)
 			input_set_capability(ctlr->input, EV_KEY,
@@ -1684,10 +2489,17 @@ static int joycon_input_create(struct joycon_ctlr *ctlr)
 		input_set_capability(ctlr->input, EV_KEY, BTN_TL2);
 	}
 
+	/* Every button may change in one report, keep it in one frame. */
+	input_set_events_per_packet(ctlr->input, JC_MAX_FRAME_VALUES);
+
 #if IS_ENABLED(CONFIG_NINTENDO_FF)
 	/* set up rumble */
 	input_set_capability(ctlr->input, EV_FF, FF_RUMBLE);
 	input_ff_create_memless(ctlr->input, NULL, joycon_play_effect);
+	/* rumble is sent along with the input reports, one per period */
+	if (ctlr->input->ff)
+		input_ff_memless_set_period(ctlr->input,
+					    JC_IMU_DFLT_AVG_DELTA_MS * USEC_PER_MSEC);
 	ctlr->rumble_ll_freq = JC_RUMBLE_DFLT_LOW_FREQ;
 	ctlr->rumble_lh_freq = JC_RUMBLE_DFLT_HIGH_FREQ;
 	ctlr->rumble_rl_freq = JC_RUMBLE_DFLT_LOW_FREQ;
@@ -1753,21 +2565,147 @@ static int joycon_input_create(struct joycon_ctlr *ctlr)
 	return 0;
 }
 
-static int joycon_player_led_brightness_set(struct led_classdev *led,
-					    enum led_brightness brightness)
+/* Joy-Cons waiting for their other half, protected by joycon_pair_mutex */
+static LIST_HEAD(joycon_unpaired);
+static DEFINE_MUTEX(joycon_pair_mutex);
+
+static struct input_dev *joycon_pair_input_create(struct joycon_ctlr *left)
+{
+	struct hid_device *hdev = left->hdev;
+	struct input_dev *input;
+	int ret;
+	int i;
+
+	input = input_allocate_device();
+	if (!input)
+		return ERR_PTR(-ENOMEM);
+
+	input->dev.parent = &hdev->dev;
+	input->id.bustype = hdev->bus;
+	input->id.vendor = hdev->vendor;
+	input->id.product = JC_PAIR_PRODUCT;
+	input->id.version = hdev->version;
+	input->name = "Nintendo Switch Combined Joy-Cons";
+
+	input_set_abs_params(input, ABS_X, -JC_MAX_STICK_MAG, JC_MAX_STICK_MAG,
+			     stick_fuzz, stick_deadzone);
+	input_set_abs_params(input, ABS_Y, -JC_MAX_STICK_MAG, JC_MAX_STICK_MAG,
+			     stick_fuzz, stick_deadzone);
+	input_set_abs_params(input, ABS_RX, -JC_MAX_STICK_MAG, JC_MAX_STICK_MAG,
+			     stick_fuzz, stick_deadzone);
+	input_set_abs_params(input, ABS_RY, -JC_MAX_STICK_MAG, JC_MAX_STICK_MAG,
+			     stick_fuzz, stick_deadzone);
+
+	for (i = 0; joycon_button_inputs_l[i] > 0; i++)
+		input_set_capability(input, EV_KEY, joycon_button_inputs_l[i]);
+	for (i = 0; joycon_button_inputs_r[i] > 0; i++)
+		input_set_capability(input, EV_KEY, joycon_button_inputs_r[i]);
+	for (i = 0; i < ARRAY_SIZE(joycon_dpad_inputs_jc); i++)
+		input_set_capability(input, EV_KEY, joycon_dpad_inputs_jc[i]);
+
+	input_set_events_per_packet(input, JC_MAX_FRAME_VALUES);
+
+	ret = input_register_device(input);
+	if (ret) {
+		input_free_device(input);
+		return ERR_PTR(ret);
+	}
+
+	return input;
+}
+
+static void __joycon_pair_add(struct joycon_ctlr *ctlr)
+{
+	struct joycon_ctlr *other = NULL;
+	struct joycon_ctlr *iter;
+	struct joycon_pair *pair;
+	struct input_dev *input;
+
+	lockdep_assert_held(&joycon_pair_mutex);
+
+	list_for_each_entry(iter, &joycon_unpaired, pair_node) {
+		if (iter->ctlr_type != ctlr->ctlr_type) {
+			other = iter;
+			break;
+		}
+	}
+	if (!other)
+		goto wait;
+
+	pair = kzalloc(sizeof(*pair), GFP_KERNEL);
+	if (!pair)
+		goto err;
+	pair->left = jc_type_has_left(ctlr) ? ctlr : other;
+	pair->right = jc_type_has_left(ctlr) ? other : ctlr;
+
+	input = joycon_pair_input_create(pair->left);
+	if (IS_ERR(input)) {
+		kfree(pair);
+		goto err;
+	}
+	pair->input = input;
+
+	list_del_init(&other->pair_node);
+	rcu_assign_pointer(pair->left->pair, pair);
+	rcu_assign_pointer(pair->right->pair, pair);
+	hid_info(ctlr->hdev, "combined with %s\n", dev_name(&other->hdev->dev));
+	return;
+
+err:
+	hid_warn(ctlr->hdev, "Failed to combine Joy-Con pair\n");
+wait:
+	list_add_tail(&ctlr->pair_node, &joycon_unpaired);
+}
+
+static void joycon_pair_add(struct joycon_ctlr *ctlr)
+{
+	if (!combine_pairs ||
+	    (ctlr->hdev->product != USB_DEVICE_ID_NINTENDO_JOYCONL &&
+	     ctlr->hdev->product != USB_DEVICE_ID_NINTENDO_JOYCONR))
+		return;
+
+	mutex_lock(&joycon_pair_mutex);
+	__joycon_pair_add(ctlr);
+	mutex_unlock(&joycon_pair_mutex);
+}
+
+static void joycon_pair_del(struct joycon_ctlr *ctlr)
+{
+	struct joycon_ctlr *other;
+	struct joycon_pair *pair;
+
+	mutex_lock(&joycon_pair_mutex);
+	list_del_init(&ctlr->pair_node);
+	pair = rcu_dereference_protected(ctlr->pair,
+					 lockdep_is_held(&joycon_pair_mutex));
+	if (pair) {
+		other = pair->left == ctlr ? pair->right : pair->left;
+		RCU_INIT_POINTER(pair->left->pair, NULL);
+		RCU_INIT_POINTER(pair->right->pair, NULL);
+		/* wait for both report parsers to let go of the device */
+		synchronize_rcu();
+		input_unregister_device(pair->input);
+		kfree(pair);
+
+		/* the other half waits for a new partner */
+		__joycon_pair_add(other);
+	}
+	mutex_unlock(&joycon_pair_mutex);
+}
+
+static void joycon_player_led_brightness_set(struct led_classdev *led,
+					     enum led_brightness brightness)
 {
 	struct device *dev = led->dev->parent;
 	struct hid_device *hdev = to_hid_device(dev);
 	struct joycon_ctlr *ctlr;
-	int val = 0;
-	int i;
-	int ret;
+	unsigned long flags;
 	int num;
 
 	ctlr = hid_get_drvdata(hdev);
 	if (!ctlr) {
 		hid_err(hdev, "No controller data\n");
-		return -ENODEV;
+		return;
 	}
 
 	/* determine which player led this is */
@@ -1776,19 +2714,17 @@ static int joycon_player_led_brightness_set(struct led_classdev *led,
 			break;
 	}
 	if (num >= JC_NUM_LEDS)
-		return -EINVAL;
+		return;
 
-	mutex_lock(&ctlr->output_mutex);
-	for (i = 0; i < JC_NUM_LEDS; i++) {
-		if (i == num)
-			val |= brightness << i;
-		else
-			val |= ctlr->leds[i].brightness << i;
-	}
-	ret = joycon_set_player_leds(ctlr, 0, val);
-	mutex_unlock(&ctlr->output_mutex);
+	spin_lock_irqsave(&ctlr->lock, flags);
+	if (brightness)
+		ctlr->player_leds |= BIT(num);
+	else
+		ctlr->player_leds &= ~BIT(num);
+	ctlr->player_leds_dirty = true;
+	spin_unlock_irqrestore(&ctlr->lock, flags);
 
-	return ret;
+	joycon_queue_player_leds(ctlr);
 }
 
 static int joycon_home_led_brightness_set(struct led_classdev *led,
@@ -1800,7 +2736,6 @@ static int joycon_home_led_brightness_set(struct led_classdev *led,
 	struct joycon_subcmd_request *req;
 	u8 buffer[sizeof(*req) + 5] = { 0 };
 	u8 *data;
-	int ret;
 
 	ctlr = hid_get_drvdata(hdev);
 	if (!ctlr) {
@@ -1818,12 +2753,61 @@ static int joycon_home_led_brightness_set(struct led_classdev *led,
 	data[4] = 0x11;
 
 	hid_dbg(hdev, "setting home led brightness\n");
-	mutex_lock(&ctlr->output_mutex);
-	ret = joycon_send_subcmd(ctlr, req, 5, HZ/4);
-	mutex_unlock(&ctlr->output_mutex);
+	return joycon_send_subcmd(ctlr, req, 5, HZ/4);
+}
 
-	return ret;
+#ifdef CONFIG_HID_NINTENDO_SWITCH_IIO
+/* The values are in the units of the evdev IMU device axes */
+static const struct iio_chan_spec joycon_iio_channels[] = {
+	NINTENDO_IIO_CHANNEL(IIO_ACCEL, X, 0, 32),
+	NINTENDO_IIO_CHANNEL(IIO_ACCEL, Y, 1, 32),
+	NINTENDO_IIO_CHANNEL(IIO_ACCEL, Z, 2, 32),
+	NINTENDO_IIO_CHANNEL(IIO_ANGL_VEL, X, 3, 32),
+	NINTENDO_IIO_CHANNEL(IIO_ANGL_VEL, Y, 4, 32),
+	NINTENDO_IIO_CHANNEL(IIO_ANGL_VEL, Z, 5, 32),
+	IIO_CHAN_SOFT_TIMESTAMP(6),
+};
+
+/* Full scans are always pushed, the IIO core demuxes them as needed. */
+static const unsigned long joycon_iio_scan_masks[] = { GENMASK(5, 0), 0 };
+
+/* Only buffered capture is supported, without any sysfs attribute. */
+static const struct iio_info joycon_iio_info = { };
+
+/*
+ * Like the Wii U gamepad, the IMU is also exposed as a buffered IIO device,
+ * so that sensor fusion can read many timestamped samples at once instead of
+ * parsing eight evdev events per sample.
+ */
+static int joycon_iio_create(struct joycon_ctlr *ctlr)
+{
+	struct hid_device *hdev = ctlr->hdev;
+	struct iio_dev *indio_dev;
+	int ret;
+
+	indio_dev = devm_iio_device_alloc(&hdev->dev, 0);
+	if (!indio_dev)
+		return -ENOMEM;
+
+	indio_dev->name = "nintendo-switch-imu";
+	indio_dev->info = &joycon_iio_info;
+	indio_dev->channels = joycon_iio_channels;
+	indio_dev->num_channels = ARRAY_SIZE(joycon_iio_channels);
+	indio_dev->available_scan_masks = joycon_iio_scan_masks;
+
+	ret = devm_iio_kfifo_buffer_setup(&hdev->dev, indio_dev,
+					  INDIO_BUFFER_SOFTWARE, NULL);
+	if (ret)
+		return ret;
+
+	ret = devm_iio_device_register(&hdev->dev, indio_dev);
+	if (ret)
+		return ret;
+
+	ctlr->indio_dev = indio_dev;
+	return 0;
 }
+#endif
 
 static DEFINE_MUTEX(joycon_input_num_mutex);
 static int joycon_leds_create(struct joycon_ctlr *ctlr)
@@ -1839,11 +2823,10 @@ static int joycon_leds_create(struct joycon_ctlr *ctlr)
 
 	/* Set the default controller player leds based on controller number */
 	mutex_lock(&joycon_input_num_mutex);
-	mutex_lock(&ctlr->output_mutex);
-	ret = joycon_set_player_leds(ctlr, 0, 0xF >> (4 - input_num));
+	ctlr->player_leds = 0xF >> (4 - input_num);
+	ret = joycon_set_player_leds(ctlr, 0, ctlr->player_leds);
 	if (ret)
 		hid_warn(ctlr->hdev, "Failed to set leds; ret=%d\n", ret);
-	mutex_unlock(&ctlr->output_mutex);
 
 	/* configure the player LEDs */
 	for (i = 0; i < JC_NUM_LEDS; i++) {
@@ -1858,8 +2841,7 @@ static int joycon_leds_create(struct joycon_ctlr *ctlr)
 		led->name = name;
 		led->brightness = ((i + 1) <= input_num) ? 1 : 0;
 		led->max_brightness = 1;
-		led->brightness_set_blocking =
-					joycon_player_led_brightness_set;
+		led->brightness_set = joycon_player_led_brightness_set;
 		led->flags = LED_CORE_SUSPENDRESUME | LED_HW_PLUGGABLE;
 
 		ret = devm_led_classdev_register(&hdev->dev, led);
@@ -1990,22 +2972,28 @@ static int joycon_power_supply_create(struct joycon_ctlr *ctlr)
 	return power_supply_powers(ctlr->battery, &hdev->dev);
 }
 
-static int joycon_read_info(struct joycon_ctlr *ctlr)
+static void joycon_request_info(struct joycon_ctlr *ctlr,
+				struct joycon_subcmd *cmd)
+{
+	joycon_subcmd_init(cmd, JC_SUBCMD_REQ_DEV_INFO, NULL, 0, HZ);
+	joycon_subcmd_submit(ctlr, cmd);
+}
+
+/* Waits for the info queued by joycon_request_info() */
+static int joycon_read_info(struct joycon_ctlr *ctlr, struct joycon_subcmd *cmd)
 {
 	int ret;
 	int i;
 	int j;
-	struct joycon_subcmd_request req = { 0 };
 	struct joycon_input_report *report;
 
-	req.subcmd_id = JC_SUBCMD_REQ_DEV_INFO;
-	ret = joycon_send_subcmd(ctlr, &req, 0, HZ);
+	ret = joycon_subcmd_wait(cmd);
 	if (ret) {
 		hid_err(ctlr->hdev, "Failed to get joycon info; ret=%d\n", ret);
 		return ret;
 	}
 
-	report = (struct joycon_input_report *)ctlr->input_buf;
+	report = (struct joycon_input_report *)cmd->reply;
 
 	for (i = 4, j = 0; j < 6; i++, j++)
 		ctlr->mac_addr[j] = report->subcmd_reply.data[i];
@@ -2024,6 +3012,52 @@ static int joycon_read_info(struct joycon_ctlr *ctlr)
 
 	/* Retrieve the type so we can distinguish for charging grip */
 	ctlr->ctlr_type = report->subcmd_reply.data[2];
+	ctlr->parser = joycon_get_parser(ctlr->ctlr_type);
+
+	return 0;
+}
+
+/*
+ * The whole setup is queued at once, so that its subcommands go out in
+ * consecutive send slots instead of each waiting for the previous reply.
+ */
+static int joycon_setup(struct joycon_ctlr *ctlr)
+{
+	struct joycon_subcmd mode, rumble, imu, info;
+	int ret_mode, ret_rumble, ret_imu, ret_info;
+
+	/* Set the reporting mode to 0x30, which is the full report mode */
+	joycon_set_report_mode(ctlr, &mode);
+	joycon_enable_rumble(ctlr, &rumble);
+	joycon_enable_imu(ctlr, &imu);
+	joycon_request_info(ctlr, &info);
+
+	ret_mode = joycon_subcmd_wait(&mode);
+	ret_rumble = joycon_subcmd_wait(&rumble);
+	ret_imu = joycon_subcmd_wait(&imu);
+	ret_info = joycon_read_info(ctlr, &info);
+
+	if (ret_mode) {
+		hid_err(ctlr->hdev, "Failed to set report mode; ret=%d\n",
+			ret_mode);
+		return ret_mode;
+	}
+	if (ret_rumble) {
+		hid_err(ctlr->hdev, "Failed to enable rumble; ret=%d\n",
+			ret_rumble);
+		return ret_rumble;
+	}
+	if (ret_imu) {
+		hid_err(ctlr->hdev, "Failed to enable the IMU; ret=%d\n",
+			ret_imu);
+		return ret_imu;
+	}
+	if (ret_info) {
+		hid_err(ctlr->hdev,
+			"Failed to retrieve controller info; ret=%d\n",
+			ret_info);
+		return ret_info;
+	}
 
 	return 0;
 }
@@ -2046,41 +3080,24 @@ static int joycon_ctlr_handle_event(struct joycon_ctlr *ctlr, u8 *data,
 							      int size)
 {
 	int ret = 0;
-	bool match = false;
-	struct joycon_input_report *report;
 
-	if (unlikely(mutex_is_locked(&ctlr->output_mutex)) &&
-	    ctlr->msg_type != JOYCON_MSG_TYPE_NONE) {
-		switch (ctlr->msg_type) {
-		case JOYCON_MSG_TYPE_USB:
-			if (size < 2)
-				break;
-			if (data[0] == JC_INPUT_USB_RESPONSE &&
-			    data[1] == ctlr->usb_ack_match)
-				match = true;
-			break;
-		case JOYCON_MSG_TYPE_SUBCMD:
-			if (size < sizeof(struct joycon_input_report) ||
-			    data[0] != JC_INPUT_SUBCMD_REPLY)
-				break;
-			report = (struct joycon_input_report *)data;
-			if (report->subcmd_reply.id == ctlr->subcmd_ack_match)
-				match = true;
-			break;
-		default:
-			break;
-		}
+	/* This message has been handled if it answers a subcommand */
+	if (data[0] == JC_INPUT_SUBCMD_REPLY &&
+	    size >= sizeof(struct joycon_input_report) &&
+	    joycon_subcmd_reply(ctlr, data, size))
+		return 1;
 
-		if (match) {
-			memcpy(ctlr->input_buf, data,
-			       min(size, (int)JC_MAX_RESP_SIZE));
-			ctlr->msg_type = JOYCON_MSG_TYPE_NONE;
-			ctlr->received_resp = true;
-			wake_up(&ctlr->wait);
+	if (unlikely(mutex_is_locked(&ctlr->output_mutex)) &&
+	    ctlr->msg_type == JOYCON_MSG_TYPE_USB &&
+	    size >= 2 && data[0] == JC_INPUT_USB_RESPONSE &&
+	    data[1] == ctlr->usb_ack_match) {
+		memcpy(ctlr->input_buf, data, min(size, (int)JC_MAX_RESP_SIZE));
+		ctlr->msg_type = JOYCON_MSG_TYPE_NONE;
+		ctlr->received_resp = true;
+		wake_up(&ctlr->wait);
 
-			/* This message has been handled */
-			return 1;
-		}
+		/* This message has been handled */
+		return 1;
 	}
 
 	if (ctlr->ctlr_state == JOYCON_CTLR_STATE_READ)
@@ -2105,6 +3122,8 @@ int switch_hid_probe(struct hid_device *hdev,
 {
 	int ret;
 	struct joycon_ctlr *ctlr;
+	unsigned long flags;
+	bool cached_cal;
 
 	hid_dbg(hdev, "probe - start\n");
 
@@ -2116,16 +3135,22 @@ int switch_hid_probe(struct hid_device *hdev,
 
 	ctlr->driver = NINTENDO_SWITCH;
 	ctlr->hdev = hdev;
+	ctlr->parser = &joycon_parser_none;
 	ctlr->ctlr_state = JOYCON_CTLR_STATE_INIT;
 	ctlr->rumble_queue_head = JC_RUMBLE_QUEUE_SIZE - 1;
 	ctlr->rumble_queue_tail = 0;
 	hid_set_drvdata(hdev, ctlr);
 	mutex_init(&ctlr->output_mutex);
+	INIT_LIST_HEAD(&ctlr->leds_cmd.node);
 	init_waitqueue_head(&ctlr->wait);
 	spin_lock_init(&ctlr->lock);
-	ctlr->rumble_queue = alloc_workqueue("hid-nintendo-rumble_wq",
-					     WQ_FREEZABLE | WQ_MEM_RECLAIM, 0);
-	INIT_WORK(&ctlr->rumble_worker, joycon_rumble_worker);
+	INIT_LIST_HEAD(&ctlr->subcmd_queue);
+	INIT_LIST_HEAD(&ctlr->subcmd_inflight);
+	INIT_LIST_HEAD(&ctlr->subcmd_done);
+	INIT_LIST_HEAD(&ctlr->pair_node);
+	INIT_DELAYED_WORK(&ctlr->subcmd_work, joycon_subcmd_worker);
+	INIT_WORK(&ctlr->cal_work, joycon_cal_worker);
+	hid_init_output_work(&ctlr->rumble_worker, joycon_rumble_worker);
 
 	ret = hid_parse(hdev);
 	if (ret) {
@@ -2185,55 +3210,24 @@ int switch_hid_probe(struct hid_device *hdev,
 		goto err_mutex;
 	}
 
-	/* get controller calibration data, and parse it */
-	ret = joycon_request_calibration(ctlr);
-	if (ret) {
-		/*
-		 * We can function with default calibration, but it may be
-		 * inaccurate. Provide a warning, and continue on.
-		 */
-		hid_warn(hdev, "Analog stick positions may be inaccurate\n");
-	}
-
-	/* get IMU calibration data, and parse it */
-	ret = joycon_request_imu_calibration(ctlr);
-	if (ret) {
-		/*
-		 * We can function with default calibration, but it may be
-		 * inaccurate. Provide a warning, and continue on.
-		 */
-		hid_warn(hdev, "Unable to read IMU calibration data\n");
-	}
-
-	/* Set the reporting mode to 0x30, which is the full report mode */
-	ret = joycon_set_report_mode(ctlr);
-	if (ret) {
-		hid_err(hdev, "Failed to set report mode; ret=%d\n", ret);
-		goto err_mutex;
-	}
-
-	/* Enable rumble */
-	ret = joycon_enable_rumble(ctlr);
-	if (ret) {
-		hid_err(hdev, "Failed to enable rumble; ret=%d\n", ret);
-		goto err_mutex;
-	}
+	mutex_unlock(&ctlr->output_mutex);
 
-	/* Enable the IMU */
-	ret = joycon_enable_imu(ctlr);
-	if (ret) {
-		hid_err(hdev, "Failed to enable the IMU; ret=%d\n", ret);
-		goto err_mutex;
-	}
+	/*
+	 * Unless it is cached, the calibration is read by cal_work once the
+	 * input devices are registered, until then the defaults are used.
+	 */
+	joycon_use_default_stick_cal(&ctlr->left_stick_cal_x);
+	joycon_use_default_stick_cal(&ctlr->left_stick_cal_y);
+	joycon_use_default_stick_cal(&ctlr->right_stick_cal_x);
+	joycon_use_default_stick_cal(&ctlr->right_stick_cal_y);
+	joycon_use_default_imu_cal(ctlr);
 
-	ret = joycon_read_info(ctlr);
-	if (ret) {
-		hid_err(hdev, "Failed to retrieve controller info; ret=%d\n",
-			ret);
-		goto err_mutex;
-	}
+	ret = joycon_setup(ctlr);
+	if (ret)
+		goto err_close;
 
-	mutex_unlock(&ctlr->output_mutex);
+	/* A reconnecting controller doesn't need to read it again */
+	cached_cal = joycon_cal_cache_get(ctlr);
 
 	/* Initialize the leds */
 	ret = joycon_leds_create(ctlr);
@@ -2255,7 +3249,17 @@ int switch_hid_probe(struct hid_device *hdev,
 		goto err_close;
 	}
 
+#ifdef CONFIG_HID_NINTENDO_SWITCH_IIO
+	ret = joycon_iio_create(ctlr);
+	if (ret)
+		hid_warn(hdev, "could not register IIO device: %d\n", ret);
+#endif
+
 	ctlr->ctlr_state = JOYCON_CTLR_STATE_READ;
+	if (!cached_cal)
+		schedule_work(&ctlr->cal_work);
+
+	joycon_pair_add(ctlr);
 
 	hid_dbg(hdev, "probe - success\n");
 	return 0;
@@ -2267,7 +3271,11 @@ int switch_hid_probe(struct hid_device *hdev,
 err_stop:
 	hid_hw_stop(hdev);
 err_wq:
-	destroy_workqueue(ctlr->rumble_queue);
+	spin_lock_irqsave(&ctlr->lock, flags);
+	ctlr->ctlr_state = JOYCON_CTLR_STATE_REMOVED;
+	spin_unlock_irqrestore(&ctlr->lock, flags);
+	cancel_work_sync(&ctlr->rumble_worker.work);
+	cancel_delayed_work_sync(&ctlr->subcmd_work);
 err:
 	hid_err(hdev, "probe - fail = %d\n", ret);
 	return ret;
@@ -2280,13 +3288,23 @@ void switch_hid_remove(struct hid_device *hdev)
 
 	hid_dbg(hdev, "remove\n");
 
+	joycon_pair_del(ctlr);
+
 	/* Prevent further attempts at sending subcommands. */
 	spin_lock_irqsave(&ctlr->lock, flags);
 	ctlr->ctlr_state = JOYCON_CTLR_STATE_REMOVED;
 	spin_unlock_irqrestore(&ctlr->lock, flags);
 
-	destroy_workqueue(ctlr->rumble_queue);
+	cancel_work_sync(&ctlr->rumble_worker.work);
+	cancel_delayed_work_sync(&ctlr->subcmd_work);
+	joycon_subcmd_flush(ctlr);
+	cancel_work_sync(&ctlr->cal_work);
 
 	hid_hw_close(hdev);
 	hid_hw_stop(hdev);
 }
+
+void switch_hid_exit(void)
+{
+	joycon_cal_cache_flush();
+}
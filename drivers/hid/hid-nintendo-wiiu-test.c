@@ -0,0 +1,576 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * KUnit tests for the Wii U gamepad report decoding
+ *
+ * A DRC is set up with its real input devices, minus the hardware, and
+ * reports built from known field values are fed through wiiu_hid_event().
+ * A test input handler records what reaches the handlers, which is
+ * compared with the expected event streams, after the filtering of the
+ * input core.
+ */
+
+#include <asm/unaligned.h>
+#include <kunit/test.h>
+#include <linux/hid.h>
+#include <linux/input.h>
+#include <linux/ktime.h>
+#include <linux/slab.h>
+
+#include "hid-nintendo-wiiu.h"
+
+/* Constant in every report, so that the battery is never notified. */
+#define WIIU_TEST_BATTERY	160
+
+enum { WIIU_TEST_JOY, WIIU_TEST_TOUCH, WIIU_TEST_MOTION };
+
+struct wiiu_test_event {
+	unsigned int dev;
+	u16 type;
+	u16 code;
+	s32 value;
+};
+
+/* Field values a test report is built from */
+struct wiiu_test_report {
+	u16 seq;
+	u32 buttons;
+	u16 sticks[NUM_STICK_AXES];
+	u8 volume;
+	bool touch;
+	u16 touch_x;
+	u16 touch_y;
+	s16 accel[3];
+	s32 gyro[3];
+	s16 magn[3];
+};
+
+struct wiiu_test_ctx {
+	struct hid_device *hdev;
+	struct drh *drh;
+	struct drc *drc;
+	struct input_handler handler;
+	bool handler_registered;
+	unsigned int saved_idle_timeout_ms;
+	unsigned int saved_idle_divider;
+	unsigned int saved_stick_deadzone;
+	unsigned int saved_stick_fuzz;
+	bool saved_touch_mt;
+
+	/* events seen by the test handler, counted past the end */
+	unsigned int nr_events;
+	struct wiiu_test_event events[64];
+};
+
+static struct wiiu_test_ctx *wiiu_test_ctx;
+
+/* The DRC of the first pad is created by the test, never by the driver. */
+static void wiiu_test_pad_work(struct work_struct *work)
+{
+}
+
+static void wiiu_test_put_le24(u8 *p, s32 val)
+{
+	p[0] = val;
+	p[1] = val >> 8;
+	p[2] = val >> 16;
+}
+
+/* Inverse of drc_handle_report(), see there for the layout. */
+static void wiiu_test_build(u8 *data, const struct wiiu_test_report *r)
+{
+	int i, base;
+
+	memset(data, 0, REPORT_LEN);
+
+	put_unaligned_be16(r->seq, &data[REPORT_SEQ]);
+	data[2] = r->buttons >> 8;
+	data[3] = r->buttons;
+	data[4] = r->buttons >> 24;
+	data[80] = r->buttons >> 16;
+	data[5] = WIIU_TEST_BATTERY;
+
+	for (i = 0; i < NUM_STICK_AXES; i++)
+		put_unaligned_le16(r->sticks[i], &data[REPORT_STICKS + 2 * i]);
+	data[REPORT_VOLUME] = r->volume;
+
+	for (i = 0; i < 3; i++) {
+		put_unaligned_le16(r->accel[i], &data[15 + 2 * i]);
+		wiiu_test_put_le24(&data[21 + 3 * i], r->gyro[i]);
+		put_unaligned_le16(r->magn[i], &data[30 + 2 * i]);
+	}
+
+	if (!r->touch)
+		return;
+
+	for (i = 0; i < NUM_TOUCH_POINTS; i++) {
+		base = REPORT_TOUCH + 4 * i;
+		data[base] = r->touch_x;
+		data[base + 1] = (r->touch_x >> 8) & 0xf;
+		data[base + 2] = r->touch_y;
+		data[base + 3] = (r->touch_y >> 8) & 0xf;
+	}
+	/* the lowest pressure bit of the first point */
+	data[37] |= 0x10;
+}
+
+static void wiiu_test_feed(struct wiiu_test_ctx *ctx,
+			   const struct wiiu_test_report *r)
+{
+	struct hid_report report = { .id = 0 };
+	u8 data[REPORT_LEN];
+
+	wiiu_test_build(data, r);
+	wiiu_hid_event(ctx->hdev, &report, data, sizeof(data));
+}
+
+static unsigned int wiiu_test_dev(struct wiiu_test_ctx *ctx,
+				  struct input_dev *dev)
+{
+	if (dev == ctx->drc->joy_input_dev)
+		return WIIU_TEST_JOY;
+	if (dev == ctx->drc->touch_input_dev)
+		return WIIU_TEST_TOUCH;
+	return WIIU_TEST_MOTION;
+}
+
+static void wiiu_test_events(struct input_handle *handle,
+			     const struct input_value *vals, unsigned int count)
+{
+	struct wiiu_test_ctx *ctx = handle->private;
+	unsigned int dev = wiiu_test_dev(ctx, handle->dev);
+	unsigned int i;
+
+	for (i = 0; i < count; i++, ctx->nr_events++)
+		if (ctx->nr_events < ARRAY_SIZE(ctx->events))
+			ctx->events[ctx->nr_events] = (struct wiiu_test_event) {
+				dev, vals[i].type, vals[i].code, vals[i].value
+			};
+}
+
+static bool wiiu_test_match(struct input_handler *handler,
+			    struct input_dev *dev)
+{
+	return input_get_drvdata(dev) == wiiu_test_ctx->drc;
+}
+
+static int wiiu_test_connect(struct input_handler *handler,
+			     struct input_dev *dev,
+			     const struct input_device_id *id)
+{
+	struct input_handle *handle;
+	int error;
+
+	handle = kzalloc(sizeof(*handle), GFP_KERNEL);
+	if (!handle)
+		return -ENOMEM;
+
+	handle->dev = dev;
+	handle->handler = handler;
+	handle->name = "wiiu-test";
+	handle->private = wiiu_test_ctx;
+
+	error = input_register_handle(handle);
+	if (error)
+		goto err_free;
+
+	error = input_open_device(handle);
+	if (error)
+		goto err_unregister;
+
+	return 0;
+
+err_unregister:
+	input_unregister_handle(handle);
+err_free:
+	kfree(handle);
+	return error;
+}
+
+static void wiiu_test_disconnect(struct input_handle *handle)
+{
+	input_close_device(handle);
+	input_unregister_handle(handle);
+	kfree(handle);
+}
+
+static const struct input_device_id wiiu_test_ids[] = {
+	{ .driver_info = 1 },	/* Matches all devices, see wiiu_test_match */
+	{ },
+};
+
+/*
+ * The input devices have no parent and no open() method, the HID device
+ * is never added.
+ */
+static int wiiu_test_register(struct input_dev *dev)
+{
+	dev->dev.parent = NULL;
+	dev->open = NULL;
+	dev->close = NULL;
+	return input_register_device(dev);
+}
+
+static int wiiu_test_init(struct kunit *test)
+{
+	struct wiiu_test_ctx *ctx;
+	struct hid_device *hdev;
+	struct drh *drh;
+	struct drc *drc;
+
+	ctx = kunit_kzalloc(test, sizeof(*ctx), GFP_KERNEL);
+	drh = kunit_kzalloc(test, sizeof(*drh), GFP_KERNEL);
+	drc = kunit_kzalloc(test, sizeof(*drc), GFP_KERNEL);
+	if (!ctx || !drh || !drc)
+		return -ENOMEM;
+
+	drh->shared = kunit_kzalloc(test, sizeof(*drh->shared), GFP_KERNEL);
+	if (!drh->shared)
+		return -ENOMEM;
+
+	hdev = hid_allocate_device();
+	if (IS_ERR(hdev))
+		return PTR_ERR(hdev);
+
+	/* idle decimation depends on the timing, the fuzz filters values */
+	ctx->saved_idle_timeout_ms = idle_timeout_ms;
+	ctx->saved_idle_divider = idle_divider;
+	ctx->saved_stick_deadzone = stick_deadzone;
+	ctx->saved_stick_fuzz = stick_fuzz;
+	ctx->saved_touch_mt = touch_mt;
+	idle_timeout_ms = 0;
+	idle_divider = 8;
+	stick_deadzone = 40;
+	stick_fuzz = 8;
+	touch_mt = false;
+
+	ctx->hdev = hdev;
+	ctx->drh = drh;
+	ctx->drc = drc;
+	test->priv = ctx;
+	wiiu_test_ctx = ctx;
+
+	drh->driver = NINTENDO_WIIU;
+	drh->hdev = hdev;
+	INIT_WORK(&drh->pad_work, wiiu_test_pad_work);
+	set_bit(0, &drh->pads_requested);
+	hid_set_drvdata(hdev, drh);
+
+	drc->drh = drh;
+	drc->hdev = hdev;
+	drc->shared = &drh->shared->pads[0];
+	drc->name = DEVICE_NAME;
+	drc->phys = "wiiu-test";
+#ifdef CONFIG_HID_BATTERY_STRENGTH
+	atomic_set(&drc->battery_state,
+		   BATTERY_STATE(WIIU_TEST_BATTERY,
+				 POWER_SUPPLY_STATUS_DISCHARGING));
+#endif
+
+	if (!drc_setup_joypad(drc, hdev) || !drc_setup_touch(drc, hdev) ||
+	    !drc_setup_accel(drc, hdev))
+		return -ENOMEM;
+
+	if (wiiu_test_register(drc->joy_input_dev) ||
+	    wiiu_test_register(drc->touch_input_dev) ||
+	    wiiu_test_register(drc->accel_input_dev))
+		return -ENODEV;
+
+	ctx->handler.events = wiiu_test_events;
+	ctx->handler.match = wiiu_test_match;
+	ctx->handler.connect = wiiu_test_connect;
+	ctx->handler.disconnect = wiiu_test_disconnect;
+	ctx->handler.name = "wiiu-test";
+	ctx->handler.id_table = wiiu_test_ids;
+	if (input_register_handler(&ctx->handler))
+		return -ENODEV;
+	ctx->handler_registered = true;
+
+	smp_store_release(&drh->pads[0], drc);
+	return 0;
+}
+
+static void wiiu_test_exit(struct kunit *test)
+{
+	struct wiiu_test_ctx *ctx = test->priv;
+
+	if (!ctx)
+		return;
+
+	if (ctx->handler_registered)
+		input_unregister_handler(&ctx->handler);
+	/* releases the devm input devices */
+	hid_destroy_device(ctx->hdev);
+
+	idle_timeout_ms = ctx->saved_idle_timeout_ms;
+	idle_divider = ctx->saved_idle_divider;
+	stick_deadzone = ctx->saved_stick_deadzone;
+	stick_fuzz = ctx->saved_stick_fuzz;
+	touch_mt = ctx->saved_touch_mt;
+	wiiu_test_ctx = NULL;
+}
+
+static void wiiu_test_expect(struct kunit *test, const char *step,
+			     const struct wiiu_test_event *expected,
+			     unsigned int count)
+{
+	struct wiiu_test_ctx *ctx = test->priv;
+	unsigned int i;
+
+	KUNIT_ASSERT_EQ_MSG(test, ctx->nr_events, count, "%s: event count",
+			    step);
+
+	for (i = 0; i < count; i++) {
+		const struct wiiu_test_event *e = &ctx->events[i];
+
+		KUNIT_EXPECT_TRUE_MSG(test,
+			e->dev == expected[i].dev &&
+			e->type == expected[i].type &&
+			e->code == expected[i].code &&
+			e->value == expected[i].value,
+			"%s: event %u is %u/%u/%u/%d, expected %u/%u/%u/%d",
+			step, i, e->dev, e->type, e->code, e->value,
+			expected[i].dev, expected[i].type, expected[i].code,
+			expected[i].value);
+	}
+
+	ctx->nr_events = 0;
+}
+
+#define WIIU_TEST_EXPECT(test, step, ...)				\
+	do {								\
+		static const struct wiiu_test_event __e[] = { __VA_ARGS__ }; \
+		wiiu_test_expect(test, step, __e, ARRAY_SIZE(__e));	\
+	} while (0)
+
+static const struct wiiu_test_report wiiu_test_idle = {
+	.seq = 1,
+	.buttons = BUTTON_A,
+	/* learnt as the stick centers */
+	.sticks = { 2060, 2040, 2050, 2045 },
+	.volume = 0x80,
+	.accel = { 100, -200, -7900 },
+	.gyro = { 1000, -1000, 50000 },
+	.magn = { 10, 20, 30 },
+};
+
+/*
+ * The first report sets everything which differs from the initial state,
+ * then only changes are reported: no event at all for a repeated report.
+ */
+static void wiiu_test_golden(struct kunit *test)
+{
+	struct wiiu_test_ctx *ctx = test->priv;
+	struct wiiu_test_report r = wiiu_test_idle;
+
+	wiiu_test_feed(ctx, &r);
+	WIIU_TEST_EXPECT(test, "first",
+		{ WIIU_TEST_JOY, EV_KEY, BTN_EAST, 1 },
+		{ WIIU_TEST_JOY, EV_ABS, ABS_X, STICK_CENTER },
+		{ WIIU_TEST_JOY, EV_ABS, ABS_Y, STICK_CENTER },
+		{ WIIU_TEST_JOY, EV_ABS, ABS_RX, STICK_CENTER },
+		{ WIIU_TEST_JOY, EV_ABS, ABS_RY, STICK_CENTER },
+		{ WIIU_TEST_JOY, EV_ABS, ABS_VOLUME, 0x80 },
+		{ WIIU_TEST_JOY, EV_SYN, SYN_REPORT, 0 },
+		{ WIIU_TEST_MOTION, EV_ABS, ABS_X, 100 },
+		{ WIIU_TEST_MOTION, EV_ABS, ABS_Y, -200 },
+		{ WIIU_TEST_MOTION, EV_ABS, ABS_Z, -7900 },
+		{ WIIU_TEST_MOTION, EV_ABS, ABS_RX, 1000 },
+		{ WIIU_TEST_MOTION, EV_ABS, ABS_RY, -1000 },
+		{ WIIU_TEST_MOTION, EV_ABS, ABS_RZ, 50000 },
+		{ WIIU_TEST_MOTION, EV_ABS, ABS_THROTTLE, 10 },
+		{ WIIU_TEST_MOTION, EV_ABS, ABS_RUDDER, 20 },
+		{ WIIU_TEST_MOTION, EV_ABS, ABS_WHEEL, 30 },
+		{ WIIU_TEST_MOTION, EV_SYN, SYN_REPORT, 0 });
+
+	/* 500 steps off the learnt center; the deadzone hides the others */
+	r.seq = 2;
+	r.buttons = BUTTON_B;
+	r.sticks[0] = 2560;
+	r.sticks[1] = 2040 + 30;
+	r.touch = true;
+	r.touch_x = 1000;
+	r.touch_y = 1500;
+	wiiu_test_feed(ctx, &r);
+	WIIU_TEST_EXPECT(test, "press",
+		{ WIIU_TEST_JOY, EV_KEY, BTN_EAST, 0 },
+		{ WIIU_TEST_JOY, EV_KEY, BTN_SOUTH, 1 },
+		{ WIIU_TEST_JOY, EV_ABS, ABS_X, STICK_CENTER + 500 },
+		{ WIIU_TEST_JOY, EV_SYN, SYN_REPORT, 0 },
+		{ WIIU_TEST_TOUCH, EV_KEY, BTN_TOUCH, 1 },
+		{ WIIU_TEST_TOUCH, EV_KEY, BTN_TOOL_FINGER, 1 },
+		{ WIIU_TEST_TOUCH, EV_ABS, ABS_X, 1000 },
+		{ WIIU_TEST_TOUCH, EV_ABS, ABS_Y, MAX_TOUCH_RES - 1500 },
+		{ WIIU_TEST_TOUCH, EV_SYN, SYN_REPORT, 0 });
+
+	KUNIT_EXPECT_EQ(test, ctx->drc->shared->report_seq, 2);
+	KUNIT_EXPECT_EQ(test, ctx->drc->shared->buttons, (u32)BUTTON_B);
+	KUNIT_EXPECT_EQ(test, ctx->drc->shared->seq % 2, 0U);
+
+	r.seq = 3;
+	wiiu_test_feed(ctx, &r);
+	KUNIT_EXPECT_EQ_MSG(test, ctx->nr_events, 0U, "repeat: event count");
+
+	r.seq = 4;
+	r.buttons = 0;
+	r.touch = false;
+	r.accel[0] = 150;
+	wiiu_test_feed(ctx, &r);
+	WIIU_TEST_EXPECT(test, "release",
+		{ WIIU_TEST_JOY, EV_KEY, BTN_SOUTH, 0 },
+		{ WIIU_TEST_JOY, EV_SYN, SYN_REPORT, 0 },
+		{ WIIU_TEST_TOUCH, EV_KEY, BTN_TOUCH, 0 },
+		{ WIIU_TEST_TOUCH, EV_KEY, BTN_TOOL_FINGER, 0 },
+		{ WIIU_TEST_TOUCH, EV_SYN, SYN_REPORT, 0 },
+		{ WIIU_TEST_MOTION, EV_ABS, ABS_X, 150 },
+		{ WIIU_TEST_MOTION, EV_SYN, SYN_REPORT, 0 });
+}
+
+/* Every button lands on its own bit of the four bytes it is spread over. */
+static void wiiu_test_buttons(struct kunit *test)
+{
+	static const struct {
+		u32 mask;
+		u16 code;
+	} buttons[] = {
+		{ BUTTON_RIGHT,	BTN_DPAD_RIGHT },
+		{ BUTTON_DOWN,	BTN_DPAD_DOWN },
+		{ BUTTON_LEFT,	BTN_DPAD_LEFT },
+		{ BUTTON_UP,	BTN_DPAD_UP },
+		{ BUTTON_A,	BTN_EAST },
+		{ BUTTON_B,	BTN_SOUTH },
+		{ BUTTON_X,	BTN_NORTH },
+		{ BUTTON_Y,	BTN_WEST },
+		{ BUTTON_L,	BTN_TL },
+		{ BUTTON_ZL,	BTN_TL2 },
+		{ BUTTON_R,	BTN_TR },
+		{ BUTTON_ZR,	BTN_TR2 },
+		{ BUTTON_TV,	BTN_Z },
+		{ BUTTON_L3,	BTN_THUMBL },
+		{ BUTTON_R3,	BTN_THUMBR },
+		{ BUTTON_MINUS,	BTN_SELECT },
+		{ BUTTON_PLUS,	BTN_START },
+		{ BUTTON_HOME,	BTN_MODE },
+		{ BUTTON_POWER,	BTN_DEAD },
+	};
+	struct wiiu_test_ctx *ctx = test->priv;
+	struct wiiu_test_report r = wiiu_test_idle;
+	unsigned int i;
+
+	r.buttons = 0;
+	wiiu_test_feed(ctx, &r);
+	ctx->nr_events = 0;
+
+	for (i = 0; i < ARRAY_SIZE(buttons); i++) {
+		struct wiiu_test_event expected[] = {
+			{ WIIU_TEST_JOY, EV_KEY, buttons[i].code, 1 },
+			{ WIIU_TEST_JOY, EV_SYN, SYN_REPORT, 0 },
+			{ WIIU_TEST_JOY, EV_KEY, buttons[i].code, 0 },
+			{ WIIU_TEST_JOY, EV_SYN, SYN_REPORT, 0 },
+		};
+
+		r.seq++;
+		r.buttons = buttons[i].mask;
+		wiiu_test_feed(ctx, &r);
+		r.seq++;
+		r.buttons = 0;
+		wiiu_test_feed(ctx, &r);
+		wiiu_test_expect(test, "button", expected, ARRAY_SIZE(expected));
+	}
+}
+
+/*
+ * Signed 24-bit gyroscope fields, around both ends of their range. Every
+ * axis changes at each step, so that none is filtered out.
+ */
+static void wiiu_test_gyro(struct kunit *test)
+{
+	static const s32 steps[][3] = {
+		{ GYRO_MIN, GYRO_MAX, -1 },
+		{ -1, 1, GYRO_MIN },
+		{ GYRO_MAX, GYRO_MIN, 0x123456 },
+		{ 1, -1, -0x123456 },
+	};
+	struct wiiu_test_ctx *ctx = test->priv;
+	struct wiiu_test_report r = wiiu_test_idle;
+	unsigned int i;
+
+	wiiu_test_feed(ctx, &r);
+	ctx->nr_events = 0;
+
+	for (i = 0; i < ARRAY_SIZE(steps); i++) {
+		struct wiiu_test_event expected[] = {
+			{ WIIU_TEST_MOTION, EV_ABS, ABS_RX, steps[i][0] },
+			{ WIIU_TEST_MOTION, EV_ABS, ABS_RY, steps[i][1] },
+			{ WIIU_TEST_MOTION, EV_ABS, ABS_RZ, steps[i][2] },
+			{ WIIU_TEST_MOTION, EV_SYN, SYN_REPORT, 0 },
+		};
+
+		r.seq++;
+		memcpy(r.gyro, steps[i], sizeof(r.gyro));
+		wiiu_test_feed(ctx, &r);
+		wiiu_test_expect(test, "gyro", expected, ARRAY_SIZE(expected));
+	}
+}
+
+/*
+ * Once idle, repeated reports are skipped, and a change is still decoded
+ * with the first report carrying it.
+ */
+static void wiiu_test_idle_decimate(struct kunit *test)
+{
+	struct wiiu_test_ctx *ctx = test->priv;
+	struct wiiu_test_report r = wiiu_test_idle;
+	unsigned int i;
+
+	idle_timeout_ms = 1000;
+	wiiu_test_feed(ctx, &r);
+	/* the motion differs from the initial idle sample: still active */
+	r.seq++;
+	wiiu_test_feed(ctx, &r);
+	KUNIT_EXPECT_FALSE(test, ctx->drc->idle);
+	ctx->nr_events = 0;
+
+	/* the last activity is a whole timeout ago */
+	ctx->drc->last_active = ktime_sub_ms(ctx->drc->last_active,
+					     idle_timeout_ms);
+
+	/*
+	 * Motion noise below the threshold: the first idle_divider - 1
+	 * reports are skipped, the last one is decoded.
+	 */
+	for (i = 0; i < idle_divider; i++) {
+		r.seq++;
+		r.accel[0] = wiiu_test_idle.accel[0] + (i & 1);
+		wiiu_test_feed(ctx, &r);
+		if (i == 0)
+			KUNIT_EXPECT_TRUE(test, ctx->drc->idle);
+	}
+	WIIU_TEST_EXPECT(test, "idle",
+		{ WIIU_TEST_MOTION, EV_ABS, ABS_X, 101 },
+		{ WIIU_TEST_MOTION, EV_SYN, SYN_REPORT, 0 });
+
+	r.seq++;
+	r.buttons = BUTTON_HOME;
+	wiiu_test_feed(ctx, &r);
+	KUNIT_EXPECT_FALSE(test, ctx->drc->idle);
+	KUNIT_ASSERT_GE(test, ctx->nr_events, 2U);
+	KUNIT_EXPECT_EQ(test, ctx->events[0].code, BTN_EAST);
+	KUNIT_EXPECT_EQ(test, ctx->events[1].code, BTN_MODE);
+}
+
+static struct kunit_case wiiu_test_cases[] = {
+	KUNIT_CASE(wiiu_test_golden),
+	KUNIT_CASE(wiiu_test_buttons),
+	KUNIT_CASE(wiiu_test_gyro),
+	KUNIT_CASE(wiiu_test_idle_decimate),
+	{}
+};
+
+static struct kunit_suite wiiu_test_suite = {
+	.name = "hid-nintendo-wiiu",
+	.init = wiiu_test_init,
+	.exit = wiiu_test_exit,
+	.test_cases = wiiu_test_cases,
+};
+
+kunit_test_suite(wiiu_test_suite);
@@ -12,101 +12,574 @@
  * Driver based on hid-udraw-ps3.c.
  */
 
+#include <asm/unaligned.h>
+#include <linux/debugfs.h>
 #include <linux/device.h>
 #include <linux/hid.h>
+#include <linux/hid-nintendo-wiiu.h>
 #include <linux/input.h>
+#include <linux/input/mt.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
 #include <linux/minmax.h>
+#include <linux/mm.h>
 #include <linux/module.h>
+#include <linux/seq_file.h>
+#include <linux/sysfs.h>
+#include <linux/workqueue.h>
+#ifdef CONFIG_HID_NINTENDO_WIIU_IIO
+#include <linux/iio/buffer.h>
+#include <linux/iio/iio.h>
+#include <linux/iio/kfifo_buf.h>
+#endif
 #ifdef CONFIG_HID_BATTERY_STRENGTH
 #include <linux/fixp-arith.h>
 #include <linux/power_supply.h>
-#include <linux/spinlock.h>
 #endif
 #include "hid-ids.h"
 #include "hid-nintendo.h"
-
-#define DEVICE_NAME	"Nintendo Wii U gamepad (DRC)"
-
-/* Button and stick constants */
-#define VOLUME_MIN	0
-#define VOLUME_MAX	255
-#define NUM_STICK_AXES	4
-#define STICK_MIN	900
-#define STICK_MAX	3200
-
-#define BUTTON_SYNC	BIT(0)
-#define BUTTON_HOME	BIT(1)
-#define BUTTON_MINUS	BIT(2)
-#define BUTTON_PLUS	BIT(3)
-#define BUTTON_R	BIT(4)
-#define BUTTON_L	BIT(5)
-#define BUTTON_ZR	BIT(6)
-#define BUTTON_ZL	BIT(7)
-#define BUTTON_DOWN	BIT(8)
-#define BUTTON_UP	BIT(9)
-#define BUTTON_RIGHT	BIT(10)
-#define BUTTON_LEFT	BIT(11)
-#define BUTTON_Y	BIT(12)
-#define BUTTON_X	BIT(13)
-#define BUTTON_B	BIT(14)
-#define BUTTON_A	BIT(15)
-
-#define BUTTON_TV	BIT(21)
-#define BUTTON_R3	BIT(22)
-#define BUTTON_L3	BIT(23)
-
-#define BUTTON_POWER	BIT(25)
-
-/* Touch constants */
-/* Resolution in pixels */
-#define RES_X		854
-#define RES_Y		480
-/* Display/touch size in mm */
-#define WIDTH		138
-#define HEIGHT		79
-#define NUM_TOUCH_POINTS 10
-#define MAX_TOUCH_RES	(1 << 12)
-#define TOUCH_BORDER_X	100
-#define TOUCH_BORDER_Y	200
-
-/* Accelerometer, gyroscope and magnetometer constants */
-#define ACCEL_MIN	-(1 << 15)
-#define ACCEL_MAX	((1 << 15) - 1)
-#define GYRO_MIN	-(1 << 23)
-#define GYRO_MAX	((1 << 23) - 1)
-#define MAGNET_MIN	-(1 << 15)
-#define MAGNET_MAX	((1 << 15) - 1)
-
-/* ADC constants for the battery */
-#define BATTERY_CHARGING_BIT	BIT(6)
-#define BATTERY_MIN	142
-#define BATTERY_MAX	178
-#define VOLTAGE_MIN	3270000
-#define VOLTAGE_MAX	4100000
+#include "hid-nintendo-wiiu.h"
 
 /*
- * The device is setup with multiple input devices:
- * - A joypad with the buttons and sticks.
- * - The touch area which works as a touchscreen.
- * - An accelerometer + gyroscope + magnetometer device.
+ * The sticks of each DRC rest a few dozen ADC steps away from STICK_CENTER
+ * and jitter around that point, their actual center is learnt from the first
+ * report and everything closer to it than stick_deadzone is reported as
+ * STICK_CENTER, so that an untouched pad doesn't generate any event.
  */
+WIIU_VISIBLE_IF_KUNIT unsigned int stick_deadzone = 40;
+module_param(stick_deadzone, uint, 0444);
+MODULE_PARM_DESC(stick_deadzone,
+		 "Distance from the stick center reported as the center, in ADC steps (default 40)");
+
+WIIU_VISIBLE_IF_KUNIT unsigned int stick_fuzz = 8;
+module_param(stick_fuzz, uint, 0444);
+MODULE_PARM_DESC(stick_fuzz,
+		 "Stick noise filtered out by the input core, in ADC steps (default 8)");
 
-struct drc {
-	enum nintendo_driver driver;
-	struct hid_device *hdev;
-	struct input_dev *joy_input_dev;
-	struct input_dev *touch_input_dev;
-	struct input_dev *accel_input_dev;
+WIIU_VISIBLE_IF_KUNIT bool touch_mt;
+module_param(touch_mt, bool, 0444);
+MODULE_PARM_DESC(touch_mt,
+		 "Report every touch sample with its pressure through a multi-touch touchscreen (default false)");
+
+/*
+ * A DRC lying untouched on a table keeps sending full-rate reports whose
+ * motion samples only differ by noise. After idle_timeout_ms without any
+ * button, stick, volume or touch change and with the accelerometer and
+ * gyroscope within the thresholds of where they were, only one report out
+ * of idle_divider is decoded, until the first change.
+ *
+ * This decimation is done on the host only. No command to lower the report
+ * rate of the DRC is known, so it keeps sending at full rate: the decoding
+ * time is saved, not the DRC battery or the radio airtime.
+ */
+WIIU_VISIBLE_IF_KUNIT unsigned int idle_timeout_ms = 10000;
+module_param(idle_timeout_ms, uint, 0644);
+MODULE_PARM_DESC(idle_timeout_ms,
+		 "Time without activity after which the host decimates the reports, 0 to disable (default 10000)");
+
+WIIU_VISIBLE_IF_KUNIT unsigned int idle_divider = 8;
+module_param(idle_divider, uint, 0644);
+MODULE_PARM_DESC(idle_divider,
+		 "One report out of this many is decoded while idle (default 8)");
+
+static unsigned int idle_accel_threshold = 200;
+module_param(idle_accel_threshold, uint, 0644);
+MODULE_PARM_DESC(idle_accel_threshold,
+		 "Accelerometer change ending the idle state, in raw units (default 200)");
+
+static unsigned int idle_gyro_threshold = 20000;
+module_param(idle_gyro_threshold, uint, 0644);
+MODULE_PARM_DESC(idle_gyro_threshold,
+		 "Gyroscope change ending the idle state, in raw units (default 20000)");
 
 #ifdef CONFIG_HID_BATTERY_STRENGTH
-	struct power_supply *battery;
-	struct power_supply_desc battery_desc;
-	spinlock_t battery_lock;
-	u8 battery_energy;
-	int battery_status;
+static unsigned int battery_step = 5;
+module_param(battery_step, uint, 0644);
+MODULE_PARM_DESC(battery_step,
+		 "Battery capacity change in percent which triggers a notification (default 5)");
 #endif
+
+static const struct {
+	u32 mask;
+	u16 code;
+} drc_buttons[] = {
+	{ BUTTON_RIGHT,	BTN_DPAD_RIGHT },
+	{ BUTTON_DOWN,	BTN_DPAD_DOWN },
+	{ BUTTON_LEFT,	BTN_DPAD_LEFT },
+	{ BUTTON_UP,	BTN_DPAD_UP },
+	{ BUTTON_A,	BTN_EAST },
+	{ BUTTON_B,	BTN_SOUTH },
+	{ BUTTON_X,	BTN_NORTH },
+	{ BUTTON_Y,	BTN_WEST },
+	{ BUTTON_L,	BTN_TL },
+	{ BUTTON_ZL,	BTN_TL2 },
+	{ BUTTON_R,	BTN_TR },
+	{ BUTTON_ZR,	BTN_TR2 },
+	{ BUTTON_TV,	BTN_Z },
+	{ BUTTON_L3,	BTN_THUMBL },
+	{ BUTTON_R3,	BTN_THUMBR },
+	{ BUTTON_MINUS,	BTN_SELECT },
+	{ BUTTON_PLUS,	BTN_START },
+	{ BUTTON_HOME,	BTN_MODE },
+	{ BUTTON_POWER,	BTN_DEAD },
 };
 
+/* All buttons, the four stick axes, the volume slider and a SYN_REPORT */
+#define JOYPAD_MAX_VALUES	(ARRAY_SIZE(drc_buttons) + NUM_STICK_AXES + 2)
+
+static void drc_report_joypad(struct drc *drc, const u8 *data, u32 changed)
+{
+	struct drc_state *state = &drc->state;
+	static const unsigned int stick_axes[NUM_STICK_AXES] = {
+		ABS_X, ABS_Y, ABS_RX, ABS_RY,
+	};
+	struct input_value vals[JOYPAD_MAX_VALUES];
+	unsigned int n = 0;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(drc_buttons); i++)
+		if (changed & drc_buttons[i].mask)
+			vals[n++] = (struct input_value) {
+				EV_KEY, drc_buttons[i].code,
+				!!(state->buttons & drc_buttons[i].mask)
+			};
+
+	for (i = 0; i < NUM_STICK_AXES; i++)
+		vals[n++] = (struct input_value) {
+			EV_ABS, stick_axes[i], state->sticks[i]
+		};
+
+	vals[n++] = (struct input_value) { EV_ABS, ABS_VOLUME, data[REPORT_VOLUME] };
+	vals[n++] = (struct input_value) { EV_SYN, SYN_REPORT, 0 };
+
+	input_set_timestamp(drc->joy_input_dev, state->time);
+	input_event_values(drc->joy_input_dev, vals, n);
+}
+
+static void drc_calibrate_sticks(struct drc *drc, const u8 *data)
+{
+	int i;
+
+	for (i = 0; i < NUM_STICK_AXES; i++) {
+		s16 val = get_unaligned_le16(&data[REPORT_STICKS + 2 * i]);
+
+		if (abs(val - STICK_CENTER) > STICK_CENTER_RANGE) {
+			hid_dbg(drc->hdev, "stick axis %d held at %d, not calibrated\n",
+				i, val);
+			val = STICK_CENTER;
+		}
+		drc->stick_center[i] = val;
+	}
+}
+
+/* Recenter a raw stick value and apply the deadzone around its center */
+static s16 drc_map_stick(const struct drc *drc, int axis, s16 val)
+{
+	int offset = val - drc->stick_center[axis];
+
+	if (abs(offset) <= stick_deadzone)
+		return STICK_CENTER;
+	return clamp(STICK_CENTER + offset, STICK_MIN, STICK_MAX);
+}
+
+static void drc_report_touch(struct drc *drc)
+{
+	struct drc_state *state = &drc->state;
+	struct input_value vals[5];
+	unsigned int n = 0;
+
+	vals[n++] = (struct input_value) { EV_KEY, BTN_TOUCH, state->touch };
+	vals[n++] = (struct input_value) { EV_KEY, BTN_TOOL_FINGER, state->touch };
+	if (state->touch) {
+		vals[n++] = (struct input_value) { EV_ABS, ABS_X, state->touch_x };
+		vals[n++] = (struct input_value) {
+			EV_ABS, ABS_Y, MAX_TOUCH_RES - state->touch_y
+		};
+	}
+	vals[n++] = (struct input_value) { EV_SYN, SYN_REPORT, 0 };
+
+	input_set_timestamp(drc->touch_input_dev, state->time);
+	input_event_values(drc->touch_input_dev, vals, n);
+}
+
+/*
+ * In multi-touch mode, each of the ten touch samples of the report is sent
+ * as its own frame, timestamped as if they were evenly spread over the
+ * report period, the first one being the oldest.
+ */
+static void drc_report_touch_mt(struct drc *drc, const u8 *data, int pressure)
+{
+	struct input_dev *input_dev = drc->touch_input_dev;
+	u32 interval = drc->clock.period_ns / NUM_TOUCH_POINTS;
+	bool touch = pressure != 0;
+	int i, base, x, y;
+
+	/* A release only needs a single frame. */
+	for (i = touch ? 0 : NUM_TOUCH_POINTS - 1; i < NUM_TOUCH_POINTS; i++) {
+		base = REPORT_TOUCH + 4 * i;
+		x = ((data[base + 1] & 0xF) << 8) | data[base];
+		y = ((data[base + 3] & 0xF) << 8) | data[base + 2];
+
+		input_set_timestamp(input_dev,
+				    ktime_sub_ns(drc->state.time,
+						 (NUM_TOUCH_POINTS - 1 - i) * interval));
+		input_mt_slot(input_dev, 0);
+		input_mt_report_slot_state(input_dev, MT_TOOL_FINGER, touch);
+		if (touch) {
+			input_report_abs(input_dev, ABS_MT_POSITION_X, x);
+			input_report_abs(input_dev, ABS_MT_POSITION_Y,
+					 MAX_TOUCH_RES - y);
+			input_report_abs(input_dev, ABS_MT_PRESSURE, pressure);
+		}
+		input_mt_sync_frame(input_dev);
+		input_sync(input_dev);
+	}
+}
+
+static void drc_decode_motion(const u8 *data, struct drc_motion *motion)
+{
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		motion->accel[i] = get_unaligned_le16(&data[15 + 2 * i]);
+		motion->magn[i] = get_unaligned_le16(&data[30 + 2 * i]);
+		motion->gyro[i] = sign_extend32(get_unaligned_le24(&data[21 + 3 * i]), 23);
+	}
+}
+
+static void drc_report_motion(struct drc *drc, const struct drc_motion *motion)
+{
+	struct input_value vals[] = {
+		/* accelerometer */
+		{ EV_ABS, ABS_X, motion->accel[0] },
+		{ EV_ABS, ABS_Y, motion->accel[1] },
+		{ EV_ABS, ABS_Z, motion->accel[2] },
+		/* gyroscope */
+		{ EV_ABS, ABS_RX, motion->gyro[0] },
+		{ EV_ABS, ABS_RY, motion->gyro[1] },
+		{ EV_ABS, ABS_RZ, motion->gyro[2] },
+		/* magnetometer */
+		{ EV_ABS, ABS_THROTTLE, motion->magn[0] },
+		{ EV_ABS, ABS_RUDDER, motion->magn[1] },
+		{ EV_ABS, ABS_WHEEL, motion->magn[2] },
+		{ EV_SYN, SYN_REPORT, 0 },
+	};
+
+	input_set_timestamp(drc->accel_input_dev, drc->state.time);
+	input_event_values(drc->accel_input_dev, vals, ARRAY_SIZE(vals));
+}
+
+#ifdef CONFIG_HID_NINTENDO_WIIU_IIO
+static void drc_push_motion(struct drc *drc, const struct drc_motion *motion)
+{
+	struct iio_dev *indio_dev = drc->indio_dev;
+	s64 latency;
+
+	if (!indio_dev || !iio_buffer_enabled(indio_dev))
+		return;
+
+	/* The IIO timestamp clock is configurable, only reuse our latency. */
+	latency = ktime_to_ns(ktime_sub(ktime_get(), drc->state.time));
+
+	drc->scan.motion = *motion;
+	iio_push_to_buffers_with_timestamp(indio_dev, &drc->scan,
+					   iio_get_time_ns(indio_dev) - latency);
+}
+#endif
+
+/*
+ * Returns the host time at which the report with sequence number @seq was
+ * sampled on the DRC, given its arrival time @now.  The DRC numbers its
+ * reports with a big-endian 16-bit counter in the first two bytes.
+ *
+ * The radio link, the DRH and USB only ever add latency, so the sample time
+ * is predicted from the previous one and the sequence delta, and only slowly
+ * slewed towards the arrival time to follow the drift between both clocks.
+ * A report arriving earlier than predicted means the model is late, in which
+ * case it is snapped back to the arrival time.
+ */
+static ktime_t drc_clock_update(struct drc_clock *clock, u16 seq, ktime_t now)
+{
+	u16 delta = seq - clock->seq;
+	u16 window;
+	ktime_t time;
+	s64 err;
+
+	if (!clock->valid || !delta || delta > CLOCK_MAX_GAP) {
+		if (!clock->period_ns)
+			clock->period_ns = CLOCK_DFLT_PERIOD_NS;
+		clock->valid = true;
+		clock->seq = seq;
+		clock->time = now;
+		clock->window_seq = seq;
+		clock->window_start = now;
+		return now;
+	}
+
+	time = ktime_add_ns(clock->time, (u64)delta * clock->period_ns);
+	err = ktime_to_ns(ktime_sub(now, time));
+	if (err < 0)
+		time = now;
+	else
+		time = ktime_add_ns(time, err >> CLOCK_SLEW_SHIFT);
+
+	clock->seq = seq;
+	clock->time = time;
+
+	window = seq - clock->window_seq;
+	if (window >= CLOCK_WINDOW) {
+		u64 elapsed = ktime_to_ns(ktime_sub(now, clock->window_start));
+
+		clock->period_ns = clamp_t(u64, div_u64(elapsed, window),
+					   CLOCK_DFLT_PERIOD_NS / 2,
+					   CLOCK_DFLT_PERIOD_NS * 2);
+		clock->window_seq = seq;
+		clock->window_start = now;
+	}
+
+	return time;
+}
+
+static bool drc_motion_moved(const struct drc_motion *a,
+			     const struct drc_motion *b)
+{
+	int i;
+
+	for (i = 0; i < 3; i++)
+		if (abs(a->accel[i] - b->accel[i]) > idle_accel_threshold ||
+		    abs(a->gyro[i] - b->gyro[i]) > idle_gyro_threshold)
+			return true;
+
+	return false;
+}
+
+/*
+ * Returns true if the report is dropped by the host side decimation, see
+ * idle_timeout_ms. It is compared with the last decoded one, so that a
+ * change is never lost.
+ */
+static bool drc_idle_decimate(struct drc *drc, const u8 *data, u32 buttons,
+			      const s16 *sticks, ktime_t now)
+{
+	const struct drc_state *state = &drc->state;
+	struct drc_motion motion;
+	unsigned int timeout = READ_ONCE(idle_timeout_ms);
+	bool active;
+
+	if (!timeout)
+		return false;
+
+	drc_decode_motion(data, &motion);
+
+	/* pressure is only 0 with no touch, see drc_handle_report() */
+	active = buttons != state->buttons ||
+		 memcmp(sticks, state->sticks, sizeof(state->sticks)) ||
+		 data[REPORT_VOLUME] != state->volume ||
+		 state->touch || (data[37] & 0x70) || (data[39] & 0x70) ||
+		 (data[41] & 0x70) || (data[43] & 0x70) ||
+		 drc_motion_moved(&motion, &drc->idle_motion);
+
+	if (active) {
+		if (drc->idle)
+			hid_dbg(drc->hdev, "DRC %u active\n", drc->index + 1);
+		drc->idle = false;
+		drc->idle_count = 0;
+		drc->last_active = now;
+		drc->idle_motion = motion;
+		return false;
+	}
+
+	if (!drc->idle) {
+		if (ktime_ms_delta(now, drc->last_active) < timeout)
+			return false;
+		hid_dbg(drc->hdev, "DRC %u idle\n", drc->index + 1);
+		drc->idle = true;
+	}
+
+	if (++drc->idle_count < READ_ONCE(idle_divider))
+		return true;
+
+	drc->idle_count = 0;
+	return false;
+}
+
+#ifdef CONFIG_DEBUG_FS
+static void drc_stats_update(struct drc_stats *stats, u16 seq, ktime_t now)
+{
+	if (stats->accepted) {
+		s64 us = ktime_us_delta(now, stats->last_arrival);
+		u16 delta = seq - stats->last_seq;
+		int bucket = us > 0 ? ilog2(us) + 1 : 0;
+
+		stats->hist[min(bucket, STATS_HIST_BUCKETS - 1)]++;
+
+		if (delta != 1) {
+			stats->gaps++;
+			if (delta)
+				stats->lost += delta - 1;
+		}
+	} else {
+		stats->first_arrival = now;
+	}
+
+	stats->accepted++;
+	stats->last_seq = seq;
+	stats->last_arrival = now;
+}
+#endif
+
+#ifdef CONFIG_HID_BATTERY_STRENGTH
+static int drc_battery_capacity(u8 battery_energy)
+{
+	return fixp_linear_interpolate(BATTERY_MIN, 0, BATTERY_MAX, 100,
+				       battery_energy);
+}
+
+/*
+ * Userspace is only notified of a status change, or of a capacity change of
+ * at least battery_step percent since the last notification, so that the
+ * ADC noise doesn't wake it up on every report.
+ */
+static void drc_battery_update(struct drc *drc, u8 battery_energy,
+			       bool charging)
+{
+	int status, state, capacity;
+
+	if (battery_energy == BATTERY_MAX)
+		status = POWER_SUPPLY_STATUS_FULL;
+	else if (charging)
+		status = POWER_SUPPLY_STATUS_CHARGING;
+	else
+		status = POWER_SUPPLY_STATUS_DISCHARGING;
+
+	/* The battery changes every few minutes at most, skip the common case. */
+	state = BATTERY_STATE(battery_energy, status);
+	if (state == atomic_read(&drc->battery_state))
+		return;
+	atomic_set(&drc->battery_state, state);
+
+	capacity = drc_battery_capacity(battery_energy);
+	if (status != drc->battery_notified_status ||
+	    abs(capacity - drc->battery_notified_capacity) >= max(battery_step, 1U)) {
+		drc->battery_notified_status = status;
+		drc->battery_notified_capacity = capacity;
+		power_supply_changed(drc->battery);
+	}
+}
+#endif
+
+#if IS_ENABLED(CONFIG_NINTENDO_FF)
+static u8 drc_rumble_pattern(u16 magnitude)
+{
+	unsigned int on = DIV_ROUND_UP(magnitude * RUMBLE_PATTERN_BITS, 0xffff);
+	u8 pattern = 0;
+	int i;
+
+	/* Spread the enabled slots as evenly as possible. */
+	for (i = 0; i < RUMBLE_PATTERN_BITS; i++)
+		if ((i * on) / RUMBLE_PATTERN_BITS !=
+		    ((i + 1) * on) / RUMBLE_PATTERN_BITS)
+			pattern |= BIT(i);
+
+	return pattern;
+}
+
+static void drc_rumble_work(struct work_struct *work)
+{
+	struct drc_rumble_work *rw = container_of(work, struct drc_rumble_work,
+						  work.work);
+	struct drc *drc = container_of(rw, struct drc, rumble_work);
+	u8 report_id = READ_ONCE(rw->report_id);
+	u8 *buf = drc->rumble_buf;
+	size_t len = RUMBLE_REPORT_LEN;
+	u8 pattern;
+	int ret;
+
+	if (READ_ONCE(drc->drh->removed))
+		return;
+
+	pattern = drc_rumble_pattern(READ_ONCE(drc->rumble_magnitude));
+	if (pattern == drc->rumble_pattern)
+		return;
+
+	if (report_id) {
+		*buf++ = report_id;
+		len++;
+	}
+	buf[0] = RUMBLE_REPORT_CMD;
+	buf[1] = RUMBLE_PATTERN_BITS;
+	buf[2] = pattern;
+	buf[3] = 0;
+
+	ret = hid_hw_output_report(drc->hdev, drc->rumble_buf, len);
+	if (ret < 0) {
+		hid_dbg(drc->hdev, "failed to send rumble report to DRC %u: %d\n",
+			rw->pad + 1, ret);
+		return;
+	}
+
+	drc->rumble_pattern = pattern;
+}
+
+/* Called with the input report rate, which bounds the rumble report rate. */
+static void drc_rumble_flush(struct drc *drc)
+{
+	if (READ_ONCE(drc->rumble_pending) && !READ_ONCE(drc->drh->removed)) {
+		WRITE_ONCE(drc->rumble_pending, false);
+		hid_queue_output_work(&drc->rumble_work.work);
+	}
+}
+
+static int drc_play_effect(struct input_dev *dev, void *data,
+			   struct ff_effect *effect)
+{
+	struct drc *drc = input_get_drvdata(dev);
+
+	if (effect->type != FF_RUMBLE)
+		return 0;
+
+	WRITE_ONCE(drc->rumble_magnitude,
+		   max(effect->u.rumble.strong_magnitude,
+		       effect->u.rumble.weak_magnitude));
+	WRITE_ONCE(drc->rumble_pending, true);
+
+	return 0;
+}
+#endif
+
+/*
+ * Copies the state decoded from a report to the shared page, with the
+ * update protocol described with struct wiiu_drc_state. Reports of a DRC
+ * are never handled concurrently, so there is a single writer per slot.
+ */
+static void drc_publish_state(struct drc *drc, u16 seq,
+			      const struct drc_motion *motion)
+{
+	const struct drc_state *state = &drc->state;
+	struct wiiu_drc_state *s = drc->shared;
+	u32 count = s->seq;
+
+	WRITE_ONCE(s->seq, count + 1);
+	smp_wmb();
+
+	s->report_seq = seq;
+	s->volume = state->volume;
+	s->touch = state->touch;
+	s->time_ns = ktime_to_ns(state->time);
+	s->buttons = state->buttons;
+	memcpy(s->sticks, state->sticks, sizeof(s->sticks));
+	s->touch_x = state->touch_x;
+	s->touch_y = state->touch_y;
+	if (motion) {
+		memcpy(s->accel, motion->accel, sizeof(s->accel));
+		memcpy(s->magn, motion->magn, sizeof(s->magn));
+		memcpy(s->gyro, motion->gyro, sizeof(s->gyro));
+	}
+
+	smp_wmb();
+	WRITE_ONCE(s->seq, count + 2);
+}
+
 /*
  * The format of this report has been reversed by the libdrc project, the
  * documentation can be found here:
@@ -114,74 +587,68 @@ struct drc {
  *
  * We receive this report from USB, but it is actually formed on the DRC, the
  * DRH only retransmits it over USB.
+ *
+ * Only the parts of the report which changed since the previous one are
+ * forwarded to the input devices, so that idle reports cost next to nothing.
+ * Each DRC has its own state and input devices, so nothing is shared with
+ * the decoding of the other DRC's reports.
  */
-int wiiu_hid_event(struct hid_device *hdev, struct hid_report *report,
-		   u8 *data, int len)
+static void drc_handle_report(struct drc *drc, const u8 *data)
 {
-	struct drc *drc = hid_get_drvdata(hdev);
-	int i, x, y, z, pressure, base;
-	u32 buttons;
-#ifdef CONFIG_HID_BATTERY_STRENGTH
-	unsigned long flags;
+	struct drc_state *state = &drc->state;
+	const struct drc_motion *moved = NULL;
+	struct drc_motion motion;
+	int i, x, y, pressure, base;
+	s16 sticks[NUM_STICK_AXES];
+	bool touch, first;
+	u32 buttons, changed;
+	ktime_t now;
+	u16 seq;
+
+	seq = get_unaligned_be16(&data[REPORT_SEQ]);
+	now = ktime_get();
+#ifdef CONFIG_DEBUG_FS
+	drc_stats_update(&drc->stats, seq, now);
 #endif
 
-	if (len != 128)
-		return -EINVAL;
+	first = !state->valid;
+	state->valid = true;
+	state->time = drc_clock_update(&drc->clock, seq, now);
 
-	buttons = (data[4] << 24) | (data[80] << 16) | (data[2] << 8) | data[3];
 	/* joypad */
-	input_report_key(drc->joy_input_dev, BTN_DPAD_RIGHT, buttons & BUTTON_RIGHT);
-	input_report_key(drc->joy_input_dev, BTN_DPAD_DOWN, buttons & BUTTON_DOWN);
-	input_report_key(drc->joy_input_dev, BTN_DPAD_LEFT, buttons & BUTTON_LEFT);
-	input_report_key(drc->joy_input_dev, BTN_DPAD_UP, buttons & BUTTON_UP);
-
-	input_report_key(drc->joy_input_dev, BTN_EAST, buttons & BUTTON_A);
-	input_report_key(drc->joy_input_dev, BTN_SOUTH, buttons & BUTTON_B);
-	input_report_key(drc->joy_input_dev, BTN_NORTH, buttons & BUTTON_X);
-	input_report_key(drc->joy_input_dev, BTN_WEST, buttons & BUTTON_Y);
-
-	input_report_key(drc->joy_input_dev, BTN_TL, buttons & BUTTON_L);
-	input_report_key(drc->joy_input_dev, BTN_TL2, buttons & BUTTON_ZL);
-	input_report_key(drc->joy_input_dev, BTN_TR, buttons & BUTTON_R);
-	input_report_key(drc->joy_input_dev, BTN_TR2, buttons & BUTTON_ZR);
+	if (first)
+		drc_calibrate_sticks(drc, data);
+	for (i = 0; i < NUM_STICK_AXES; i++)
+		sticks[i] = drc_map_stick(drc, i,
+				get_unaligned_le16(&data[REPORT_STICKS + 2 * i]));
 
-	input_report_key(drc->joy_input_dev, BTN_Z, buttons & BUTTON_TV);
-	input_report_key(drc->joy_input_dev, BTN_THUMBL, buttons & BUTTON_L3);
-	input_report_key(drc->joy_input_dev, BTN_THUMBR, buttons & BUTTON_R3);
-
-	input_report_key(drc->joy_input_dev, BTN_SELECT, buttons & BUTTON_MINUS);
-	input_report_key(drc->joy_input_dev, BTN_START, buttons & BUTTON_PLUS);
-	input_report_key(drc->joy_input_dev, BTN_MODE, buttons & BUTTON_HOME);
-
-	input_report_key(drc->joy_input_dev, BTN_DEAD, buttons & BUTTON_POWER);
+	buttons = (data[4] << 24) | (data[80] << 16) | (data[2] << 8) | data[3];
 
-	for (i = 0; i < NUM_STICK_AXES; i++) {
-		s16 val = (data[7 + 2*i] << 8) | data[6 + 2*i];
-
-		val = clamp(val, (s16)STICK_MIN, (s16)STICK_MAX);
-
-		switch (i) {
-		case 0:
-			input_report_abs(drc->joy_input_dev, ABS_X, val);
-			break;
-		case 1:
-			input_report_abs(drc->joy_input_dev, ABS_Y, val);
-			break;
-		case 2:
-			input_report_abs(drc->joy_input_dev, ABS_RX, val);
-			break;
-		case 3:
-			input_report_abs(drc->joy_input_dev, ABS_RY, val);
-			break;
-		default:
-			break;
-		}
+	if (!first && drc_idle_decimate(drc, data, buttons, sticks, now)) {
+#ifdef CONFIG_DEBUG_FS
+		drc->stats.idle_decimated++;
+#endif
+		return;
 	}
 
-	input_report_abs(drc->joy_input_dev, ABS_VOLUME, data[14]);
-	input_sync(drc->joy_input_dev);
+	changed = first ? ~0U : buttons ^ state->buttons;
+	if (changed || memcmp(state->sticks, sticks, sizeof(sticks)) ||
+	    state->volume != data[REPORT_VOLUME]) {
+		state->buttons = buttons;
+		memcpy(state->sticks, sticks, sizeof(sticks));
+		state->volume = data[REPORT_VOLUME];
+		drc_report_joypad(drc, data, changed);
+	}
 
 	/* touch */
+	/* Pressure reporting isn’t properly understood, only multi-touch mode reports it. */
+	pressure = 0;
+	pressure |= ((data[37] >> 4) & 7) << 0;
+	pressure |= ((data[39] >> 4) & 7) << 3;
+	pressure |= ((data[41] >> 4) & 7) << 6;
+	pressure |= ((data[43] >> 4) & 7) << 9;
+	touch = pressure != 0;
+
 	/*
 	 * Average touch points for improved accuracy.  Sadly these are always
 	 * reported extremely close from each other…  Even when the user
@@ -190,7 +657,7 @@ int wiiu_hid_event(struct hid_device *hdev, struct hid_report *report,
 	 */
 	x = y = 0;
 	for (i = 0; i < NUM_TOUCH_POINTS; i++) {
-		base = 36 + 4 * i;
+		base = REPORT_TOUCH + 4 * i;
 
 		x += ((data[base + 1] & 0xF) << 8) | data[base];
 		y += ((data[base + 3] & 0xF) << 8) | data[base + 2];
@@ -198,65 +665,94 @@ int wiiu_hid_event(struct hid_device *hdev, struct hid_report *report,
 	x /= NUM_TOUCH_POINTS;
 	y /= NUM_TOUCH_POINTS;
 
-	/* Pressure reporting isn’t properly understood, so we don’t report it yet. */
-	pressure = 0;
-	pressure |= ((data[37] >> 4) & 7) << 0;
-	pressure |= ((data[39] >> 4) & 7) << 3;
-	pressure |= ((data[41] >> 4) & 7) << 6;
-	pressure |= ((data[43] >> 4) & 7) << 9;
+	if (touch_mt) {
+		/* the averaged position is only kept for the shared page */
+		state->touch_x = x;
+		state->touch_y = y;
+		if (first || touch || state->touch) {
+			state->touch = touch;
+			drc_report_touch_mt(drc, data, pressure);
+		}
+		goto motion;
+	}
 
-	if (pressure != 0) {
-		input_report_key(drc->touch_input_dev, BTN_TOUCH, 1);
-		input_report_key(drc->touch_input_dev, BTN_TOOL_FINGER, 1);
+	/* The coordinates are meaningless while the screen isn’t touched. */
+	if (first || touch != state->touch ||
+	    (touch && (x != state->touch_x || y != state->touch_y))) {
+		state->touch = touch;
+		state->touch_x = x;
+		state->touch_y = y;
+		drc_report_touch(drc);
+	}
 
-		input_report_abs(drc->touch_input_dev, ABS_X, x);
-		input_report_abs(drc->touch_input_dev, ABS_Y, MAX_TOUCH_RES - y);
-	} else {
-		input_report_key(drc->touch_input_dev, BTN_TOUCH, 0);
-		input_report_key(drc->touch_input_dev, BTN_TOOL_FINGER, 0);
+motion:
+	/* accelerometer, gyroscope and magnetometer */
+	if (first ||
+	    memcmp(state->motion, &data[REPORT_MOTION], REPORT_MOTION_LEN)) {
+		memcpy(state->motion, &data[REPORT_MOTION], REPORT_MOTION_LEN);
+		drc_decode_motion(data, &motion);
+		drc_report_motion(drc, &motion);
+#ifdef CONFIG_HID_NINTENDO_WIIU_IIO
+		drc_push_motion(drc, &motion);
+#endif
+		moved = &motion;
 	}
-	input_sync(drc->touch_input_dev);
 
-	/* accelerometer */
-	x = (data[16] << 8) | data[15];
-	y = (data[18] << 8) | data[17];
-	z = (data[20] << 8) | data[19];
-	input_report_abs(drc->accel_input_dev, ABS_X, (int16_t)x);
-	input_report_abs(drc->accel_input_dev, ABS_Y, (int16_t)y);
-	input_report_abs(drc->accel_input_dev, ABS_Z, (int16_t)z);
+#ifdef CONFIG_HID_BATTERY_STRENGTH
+	/* battery */
+	drc_battery_update(drc, data[5], data[4] & BATTERY_CHARGING_BIT);
+#endif
 
-	/* gyroscope */
-	x = (data[23] << 24) | (data[22] << 16) | (data[21] << 8);
-	y = (data[26] << 24) | (data[25] << 16) | (data[24] << 8);
-	z = (data[29] << 24) | (data[28] << 16) | (data[27] << 8);
-	input_report_abs(drc->accel_input_dev, ABS_RX, x >> 8);
-	input_report_abs(drc->accel_input_dev, ABS_RY, y >> 8);
-	input_report_abs(drc->accel_input_dev, ABS_RZ, z >> 8);
+	drc_publish_state(drc, seq, moved);
 
-	/* magnetometer */
-	x = (data[31] << 8) | data[30];
-	y = (data[33] << 8) | data[32];
-	z = (data[35] << 8) | data[34];
-	input_report_abs(drc->accel_input_dev, ABS_THROTTLE, (int16_t)x);
-	input_report_abs(drc->accel_input_dev, ABS_RUDDER, (int16_t)y);
-	input_report_abs(drc->accel_input_dev, ABS_WHEEL, (int16_t)z);
-	input_sync(drc->accel_input_dev);
+	/* The joypad, touch and motion frames above are one report. */
+	input_group_sync(drc->joy_input_dev);
+}
 
-#ifdef CONFIG_HID_BATTERY_STRENGTH
-	/* battery */
-	spin_lock_irqsave(&drc->battery_lock, flags);
-	drc->battery_energy = data[5];
-	if (drc->battery_energy == BATTERY_MAX)
-		drc->battery_status = POWER_SUPPLY_STATUS_FULL;
-	else if (data[4] & BATTERY_CHARGING_BIT)
-		drc->battery_status = POWER_SUPPLY_STATUS_CHARGING;
-	else
-		drc->battery_status = POWER_SUPPLY_STATUS_DISCHARGING;
-	spin_unlock_irqrestore(&drc->battery_lock, flags);
+int wiiu_hid_event(struct hid_device *hdev, struct hid_report *report,
+		   u8 *data, int len)
+{
+	struct drh *drh = hid_get_drvdata(hdev);
+	unsigned int index = 0;
+	struct drc *drc;
+
+	/* Numbered reports carry the pad index plus one as their ID. */
+	if (report->id) {
+		index = report->id - 1;
+		data++;
+		len--;
+	}
+	if (index >= DRH_MAX_PADS)
+		return -EINVAL;
+
+	drc = smp_load_acquire(&drh->pads[index]);
+	if (!drc) {
+		if (!test_and_set_bit(index, &drh->pads_requested) &&
+		    !READ_ONCE(drh->removed))
+			schedule_work(&drh->pad_work);
+		return HID_RAW_EVENT_CONSUMED;
+	}
+
+	if (len != REPORT_LEN) {
+#ifdef CONFIG_DEBUG_FS
+		drc->stats.rejected++;
 #endif
+		return -EINVAL;
+	}
 
-	/* let hidraw and hiddev handle the report */
-	return 0;
+	drc_handle_report(drc, data);
+
+#if IS_ENABLED(CONFIG_NINTENDO_FF)
+	/* the first pad's reports are numbered once a second one is supported */
+	if (unlikely(drc->rumble_work.report_id != report->id))
+		WRITE_ONCE(drc->rumble_work.report_id, report->id);
+
+	/* also from skipped reports, rumble must not wait for activity */
+	drc_rumble_flush(drc);
+#endif
+
+	/* the descriptor only describes a vendor blob, leave it to hidraw */
+	return HID_RAW_EVENT_CONSUMED;
 }
 
 static int drc_open(struct input_dev *dev)
@@ -270,20 +766,29 @@ static void drc_close(struct input_dev *dev)
 {
 	struct drc *drc = input_get_drvdata(dev);
 
+#if IS_ENABLED(CONFIG_NINTENDO_FF)
+	/* No more input report may come to send the final rumble update. */
+	drc_rumble_flush(drc);
+#endif
+
 	hid_hw_close(drc->hdev);
 }
 
-static struct input_dev *allocate_and_setup(struct hid_device *hdev,
+static struct input_dev *allocate_and_setup(struct drc *drc,
 					    const char *name)
 {
+	struct hid_device *hdev = drc->hdev;
 	struct input_dev *input_dev;
 
 	input_dev = devm_input_allocate_device(&hdev->dev);
 	if (!input_dev)
 		return NULL;
 
-	input_dev->name = name;
-	input_dev->phys = hdev->phys;
+	input_dev->name = devm_kasprintf(&hdev->dev, GFP_KERNEL, "%s %s",
+					 drc->name, name);
+	if (!input_dev->name)
+		return NULL;
+	input_dev->phys = drc->phys;
 	input_dev->dev.parent = &hdev->dev;
 	input_dev->open = drc_open;
 	input_dev->close = drc_close;
@@ -292,17 +797,17 @@ static struct input_dev *allocate_and_setup(struct hid_device *hdev,
 	input_dev->id.vendor  = hdev->vendor;
 	input_dev->id.product = hdev->product;
 	input_dev->id.version = hdev->version;
-	input_set_drvdata(input_dev, hid_get_drvdata(hdev));
+	input_set_drvdata(input_dev, drc);
 
 	return input_dev;
 }
 
-static bool drc_setup_joypad(struct drc *drc,
-			     struct hid_device *hdev)
+WIIU_VISIBLE_IF_KUNIT bool drc_setup_joypad(struct drc *drc,
+					    struct hid_device *hdev)
 {
 	struct input_dev *input_dev;
 
-	input_dev = allocate_and_setup(hdev, DEVICE_NAME " buttons and sticks");
+	input_dev = allocate_and_setup(drc, "buttons and sticks");
 	if (!input_dev)
 		return false;
 
@@ -337,26 +842,46 @@ static bool drc_setup_joypad(struct drc *drc,
 	input_set_capability(input_dev, EV_KEY, BTN_Z);
 	input_set_capability(input_dev, EV_KEY, BTN_DEAD);
 
-	input_set_abs_params(input_dev, ABS_X, STICK_MIN, STICK_MAX, 0, 0);
-	input_set_abs_params(input_dev, ABS_Y, STICK_MIN, STICK_MAX, 0, 0);
-	input_set_abs_params(input_dev, ABS_RX, STICK_MIN, STICK_MAX, 0, 0);
-	input_set_abs_params(input_dev, ABS_RY, STICK_MIN, STICK_MAX, 0, 0);
+	input_set_abs_params(input_dev, ABS_X, STICK_MIN, STICK_MAX,
+			     stick_fuzz, stick_deadzone);
+	input_set_abs_params(input_dev, ABS_Y, STICK_MIN, STICK_MAX,
+			     stick_fuzz, stick_deadzone);
+	input_set_abs_params(input_dev, ABS_RX, STICK_MIN, STICK_MAX,
+			     stick_fuzz, stick_deadzone);
+	input_set_abs_params(input_dev, ABS_RY, STICK_MIN, STICK_MAX,
+			     stick_fuzz, stick_deadzone);
 	input_set_abs_params(input_dev, ABS_VOLUME, VOLUME_MIN, VOLUME_MAX, 0, 0);
 
+	/* Every button may change in one report, keep it in one frame. */
+	input_set_events_per_packet(input_dev, JOYPAD_MAX_VALUES);
+
 	return true;
 }
 
-static bool drc_setup_touch(struct drc *drc,
-			    struct hid_device *hdev)
+WIIU_VISIBLE_IF_KUNIT bool drc_setup_touch(struct drc *drc,
+					   struct hid_device *hdev)
 {
 	struct input_dev *input_dev;
 
-	input_dev = allocate_and_setup(hdev, DEVICE_NAME " touchscreen");
+	input_dev = allocate_and_setup(drc, "touchscreen");
 	if (!input_dev)
 		return false;
 
 	drc->touch_input_dev = input_dev;
 
+	if (touch_mt) {
+		input_set_abs_params(input_dev, ABS_MT_POSITION_X, TOUCH_BORDER_X,
+				     MAX_TOUCH_RES - TOUCH_BORDER_X, 0, 0);
+		input_abs_set_res(input_dev, ABS_MT_POSITION_X, RES_X / WIDTH);
+		input_set_abs_params(input_dev, ABS_MT_POSITION_Y, TOUCH_BORDER_Y,
+				     MAX_TOUCH_RES - TOUCH_BORDER_Y, 0, 0);
+		input_abs_set_res(input_dev, ABS_MT_POSITION_Y, RES_Y / HEIGHT);
+		input_set_abs_params(input_dev, ABS_MT_PRESSURE, 0, MAX_PRESSURE, 0, 0);
+
+		/* This also sets up the single-touch emulation axes. */
+		return input_mt_init_slots(input_dev, 1, INPUT_MT_DIRECT) == 0;
+	}
+
 	set_bit(INPUT_PROP_DIRECT, input_dev->propbit);
 
 	input_set_abs_params(input_dev, ABS_X, TOUCH_BORDER_X, MAX_TOUCH_RES - TOUCH_BORDER_X, 20, 0);
@@ -370,12 +895,12 @@ static bool drc_setup_touch(struct drc *drc,
 	return true;
 }
 
-static bool drc_setup_accel(struct drc *drc,
-			    struct hid_device *hdev)
+WIIU_VISIBLE_IF_KUNIT bool drc_setup_accel(struct drc *drc,
+					   struct hid_device *hdev)
 {
 	struct input_dev *input_dev;
 
-	input_dev = allocate_and_setup(hdev, DEVICE_NAME " accelerometer, gyroscope and magnetometer");
+	input_dev = allocate_and_setup(drc, "accelerometer, gyroscope and magnetometer");
 	if (!input_dev)
 		return false;
 
@@ -404,6 +929,138 @@ static bool drc_setup_accel(struct drc *drc,
 	return true;
 }
 
+#if IS_ENABLED(CONFIG_NINTENDO_FF)
+static int drc_setup_rumble(struct drc *drc, struct hid_device *hdev)
+{
+	/* room for a report ID in front */
+	drc->rumble_buf = devm_kzalloc(&hdev->dev, RUMBLE_REPORT_LEN + 1,
+				       GFP_KERNEL);
+	if (!drc->rumble_buf)
+		return -ENOMEM;
+
+	hid_init_output_work(&drc->rumble_work.work, drc_rumble_work);
+	drc->rumble_work.pad = drc->index;
+	/* pads other than the first are only seen in numbered reports */
+	drc->rumble_work.report_id = drc->index ? drc->index + 1 : 0;
+
+	input_set_capability(drc->joy_input_dev, EV_FF, FF_RUMBLE);
+	return input_ff_create_memless(drc->joy_input_dev, NULL, drc_play_effect);
+}
+#endif
+
+#ifdef CONFIG_HID_NINTENDO_WIIU_IIO
+static const struct iio_chan_spec drc_iio_channels[] = {
+	NINTENDO_IIO_CHANNEL(IIO_ACCEL, X, 0, 16),
+	NINTENDO_IIO_CHANNEL(IIO_ACCEL, Y, 1, 16),
+	NINTENDO_IIO_CHANNEL(IIO_ACCEL, Z, 2, 16),
+	NINTENDO_IIO_CHANNEL(IIO_MAGN, X, 3, 16),
+	NINTENDO_IIO_CHANNEL(IIO_MAGN, Y, 4, 16),
+	NINTENDO_IIO_CHANNEL(IIO_MAGN, Z, 5, 16),
+	NINTENDO_IIO_CHANNEL(IIO_ANGL_VEL, X, 6, 24),
+	NINTENDO_IIO_CHANNEL(IIO_ANGL_VEL, Y, 7, 24),
+	NINTENDO_IIO_CHANNEL(IIO_ANGL_VEL, Z, 8, 24),
+	IIO_CHAN_SOFT_TIMESTAMP(9),
+};
+
+/* Full scans are always pushed, the IIO core demuxes them as needed. */
+static const unsigned long drc_iio_scan_masks[] = { GENMASK(8, 0), 0 };
+
+/* Only buffered capture is supported, without any sysfs attribute. */
+static const struct iio_info drc_iio_info = { };
+
+/*
+ * The motion samples are also exposed as a buffered IIO device, so that
+ * sensor fusion can read many timestamped samples at once instead of
+ * parsing ten evdev events per sample.  This is optional, the evdev device
+ * stays available in any case.
+ */
+static int drc_setup_iio(struct drc *drc, struct hid_device *hdev)
+{
+	struct iio_dev *indio_dev;
+	int ret;
+
+	indio_dev = devm_iio_device_alloc(&hdev->dev, 0);
+	if (!indio_dev)
+		return -ENOMEM;
+
+	indio_dev->name = "wiiu-drc-motion";
+	indio_dev->info = &drc_iio_info;
+	indio_dev->channels = drc_iio_channels;
+	indio_dev->num_channels = ARRAY_SIZE(drc_iio_channels);
+	indio_dev->available_scan_masks = drc_iio_scan_masks;
+
+	ret = devm_iio_kfifo_buffer_setup(&hdev->dev, indio_dev,
+					  INDIO_BUFFER_SOFTWARE, NULL);
+	if (ret)
+		return ret;
+
+	ret = devm_iio_device_register(&hdev->dev, indio_dev);
+	if (ret)
+		return ret;
+
+	drc->indio_dev = indio_dev;
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_DEBUG_FS
+static int drc_stats_show(struct seq_file *f, void *unused)
+{
+	struct drc *drc = f->private;
+	struct drc_stats *stats = &drc->stats;
+	s64 span = ktime_to_ns(ktime_sub(stats->last_arrival,
+					 stats->first_arrival));
+	u64 rate = 0;
+	u32 rate_frac;
+	int i;
+
+	/* average since the first report, in mHz */
+	if (stats->accepted > 1 && span > 0)
+		rate = mul_u64_u64_div_u64(stats->accepted - 1,
+					   NSEC_PER_SEC * 1000ULL, span);
+
+	seq_printf(f, "accepted:\t%llu\n", stats->accepted);
+	seq_printf(f, "rejected:\t%llu\n", stats->rejected);
+	seq_printf(f, "idle decimated:\t%llu\n", stats->idle_decimated);
+	seq_printf(f, "idle:\t\t%d\n", drc->idle);
+	seq_printf(f, "gaps:\t\t%llu\n", stats->gaps);
+	seq_printf(f, "lost:\t\t%llu\n", stats->lost);
+	seq_printf(f, "first (ns):\t%lld\n", ktime_to_ns(stats->first_arrival));
+	rate = div_u64_rem(rate, 1000, &rate_frac);
+	seq_printf(f, "rate (Hz):\t%llu.%03u\n", rate, rate_frac);
+
+	seq_puts(f, "inter-arrival time (us):\n");
+	for (i = 0; i < STATS_HIST_BUCKETS; i++) {
+		if (i == STATS_HIST_BUCKETS - 1)
+			seq_printf(f, "%8u-\t", 1U << (i - 1));
+		else
+			seq_printf(f, "%8u-%u\t", i ? 1U << (i - 1) : 0, (1U << i) - 1);
+		seq_printf(f, "%llu\n", stats->hist[i]);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(drc_stats);
+
+static void drc_debugfs_remove(void *data)
+{
+	debugfs_remove_recursive(data);
+}
+
+static void drc_setup_debugfs(struct drc *drc, struct hid_device *hdev)
+{
+	struct dentry *dir;
+	char name[8];
+
+	snprintf(name, sizeof(name), "drc%u", drc->index);
+	dir = debugfs_create_dir(name, hdev->debug_dir);
+	debugfs_create_file("stats", 0400, dir, drc, &drc_stats_fops);
+
+	if (devm_add_action_or_reset(&hdev->dev, drc_debugfs_remove, dir))
+		hid_warn(hdev, "could not register debugfs cleanup\n");
+}
+#endif
+
 #ifdef CONFIG_HID_BATTERY_STRENGTH
 static enum power_supply_property drc_battery_props[] = {
 	POWER_SUPPLY_PROP_STATUS,
@@ -420,15 +1077,10 @@ static int drc_battery_get_property(struct power_supply *psy,
 				    union power_supply_propval *val)
 {
 	struct drc *drc = power_supply_get_drvdata(psy);
-	unsigned long flags;
+	int state = atomic_read(&drc->battery_state);
+	u8 battery_energy = BATTERY_ENERGY(state);
+	int battery_status = BATTERY_STATUS(state);
 	int ret = 0;
-	u8 battery_energy;
-	int battery_status;
-
-	spin_lock_irqsave(&drc->battery_lock, flags);
-	battery_energy = drc->battery_energy;
-	battery_status = drc->battery_status;
-	spin_unlock_irqrestore(&drc->battery_lock, flags);
 
 	switch (psp) {
 	case POWER_SUPPLY_PROP_STATUS:
@@ -449,9 +1101,7 @@ static int drc_battery_get_property(struct power_supply *psy,
 						      battery_energy);
 		break;
 	case POWER_SUPPLY_PROP_CAPACITY:
-		val->intval = fixp_linear_interpolate(BATTERY_MIN, 0,
-						      BATTERY_MAX, 100,
-						      battery_energy);
+		val->intval = drc_battery_capacity(battery_energy);
 		break;
 	case POWER_SUPPLY_PROP_SCOPE:
 		val->intval = POWER_SUPPLY_SCOPE_DEVICE;
@@ -470,7 +1120,9 @@ static int drc_setup_battery(struct drc *drc,
 	static atomic_t drc_num = ATOMIC_INIT(0);
 	int ret;
 
-	spin_lock_init(&drc->battery_lock);
+	atomic_set(&drc->battery_state,
+		   BATTERY_STATE(0, POWER_SUPPLY_STATUS_UNKNOWN));
+	drc->battery_notified_status = POWER_SUPPLY_STATUS_UNKNOWN;
 
 	drc->battery_desc.properties = drc_battery_props;
 	drc->battery_desc.num_properties = ARRAY_SIZE(drc_battery_props);
@@ -496,9 +1148,13 @@ static int drc_setup_battery(struct drc *drc,
 }
 #endif
 
-int wiiu_hid_probe(struct hid_device *hdev,
-		   const struct hid_device_id *id)
+/*
+ * Allocates every device of the DRC at @index, and publishes it to the event
+ * path once they are all registered.
+ */
+static int drc_create(struct drh *drh, unsigned int index)
 {
+	struct hid_device *hdev = drh->hdev;
 	struct drc *drc;
 	int ret;
 
@@ -506,17 +1162,26 @@ int wiiu_hid_probe(struct hid_device *hdev,
 	if (!drc)
 		return -ENOMEM;
 
-	drc->driver = NINTENDO_WIIU;
+	drc->drh = drh;
 	drc->hdev = hdev;
-
-	hid_set_drvdata(hdev, drc);
-
-	ret = hid_parse(hdev);
-	if (ret) {
-		hid_err(hdev, "parse failed\n");
-		return ret;
+	drc->index = index;
+	drc->shared = &drh->shared->pads[index];
+	if (index) {
+		drc->name = devm_kasprintf(&hdev->dev, GFP_KERNEL, "%s %u",
+					   DEVICE_NAME, index + 1);
+		drc->phys = devm_kasprintf(&hdev->dev, GFP_KERNEL, "%s/%u",
+					   hdev->phys, index);
+		if (!drc->name || !drc->phys)
+			return -ENOMEM;
+	} else {
+		drc->name = DEVICE_NAME;
+		drc->phys = hdev->phys;
 	}
 
+#ifdef CONFIG_DEBUG_FS
+	drc_setup_debugfs(drc, hdev);
+#endif
+
 	if (!drc_setup_joypad(drc, hdev) ||
 	    !drc_setup_touch(drc, hdev) ||
 	    !drc_setup_accel(drc, hdev)) {
@@ -524,6 +1189,14 @@ int wiiu_hid_probe(struct hid_device *hdev,
 		return -ENOMEM;
 	}
 
+#if IS_ENABLED(CONFIG_NINTENDO_FF)
+	ret = drc_setup_rumble(drc, hdev);
+	if (ret) {
+		hid_err(hdev, "could not set up rumble\n");
+		return ret;
+	}
+#endif
+
 #ifdef CONFIG_HID_BATTERY_STRENGTH
 	ret = drc_setup_battery(drc, hdev);
 	if (ret) {
@@ -532,19 +1205,171 @@ int wiiu_hid_probe(struct hid_device *hdev,
 	}
 #endif
 
+	ret = input_register_device(drc->joy_input_dev);
+	if (!ret)
+		ret = input_register_device(drc->touch_input_dev);
+	if (!ret)
+		ret = input_register_device(drc->accel_input_dev);
+	if (ret) {
+		hid_err(hdev, "failed to register interfaces: %d\n", ret);
+		return ret;
+	}
+
+#ifdef CONFIG_HID_NINTENDO_WIIU_IIO
+	ret = drc_setup_iio(drc, hdev);
+	if (ret)
+		hid_warn(hdev, "could not register IIO device: %d\n", ret);
+#endif
+
+	smp_store_release(&drh->pads[index], drc);
+	return 0;
+}
+
+static void drh_pad_work(struct work_struct *work)
+{
+	struct drh *drh = container_of(work, struct drh, pad_work);
+	unsigned int index;
+	int ret;
+
+	for (index = 0; index < DRH_MAX_PADS; index++) {
+		if (READ_ONCE(drh->removed))
+			return;
+		if (!test_bit(index, &drh->pads_requested) || drh->pads[index])
+			continue;
+
+		ret = drc_create(drh, index);
+		if (ret)
+			hid_err(drh->hdev, "could not create DRC %u: %d\n",
+				index + 1, ret);
+		else
+			hid_info(drh->hdev, "DRC %u connected\n", index + 1);
+	}
+}
+
+static ssize_t drc_state_read(struct file *filp, struct kobject *kobj,
+			      struct bin_attribute *attr, char *buf,
+			      loff_t off, size_t count)
+{
+	struct drh *drh = hid_get_drvdata(to_hid_device(kobj_to_dev(kobj)));
+
+	return memory_read_from_buffer(buf, count, &off, drh->shared,
+				       sizeof(*drh->shared));
+}
+
+/* The page is only ever mapped read-only, as a whole. */
+static int drc_state_mmap(struct file *filp, struct kobject *kobj,
+			  struct bin_attribute *attr,
+			  struct vm_area_struct *vma)
+{
+	struct drh *drh = hid_get_drvdata(to_hid_device(kobj_to_dev(kobj)));
+
+	if (vma->vm_pgoff || vma_pages(vma) != 1)
+		return -EINVAL;
+	if (vma->vm_flags & VM_WRITE)
+		return -EPERM;
+	vma->vm_flags &= ~VM_MAYWRITE;
+
+	return vm_insert_page(vma, vma->vm_start, virt_to_page(drh->shared));
+}
+
+static struct bin_attribute bin_attr_drc_state = {
+	.attr	= { .name = "drc_state", .mode = 0444 },
+	.size	= PAGE_SIZE,
+	.read	= drc_state_read,
+	.mmap	= drc_state_mmap,
+};
+
+static void drh_free_shared(void *data)
+{
+	free_page((unsigned long)data);
+}
+
+/*
+ * The works may still send output reports, so they are all done before the
+ * transport is stopped. Once pad_work is done, no more pads get created.
+ */
+static void drh_stop(struct drh *drh)
+{
+#if IS_ENABLED(CONFIG_NINTENDO_FF)
+	unsigned int index;
+#endif
+
+	WRITE_ONCE(drh->removed, true);
+	cancel_work_sync(&drh->pad_work);
+
+#if IS_ENABLED(CONFIG_NINTENDO_FF)
+	for (index = 0; index < DRH_MAX_PADS; index++)
+		if (drh->pads[index])
+			cancel_work_sync(&drh->pads[index]->rumble_work.work.work);
+#endif
+
+	hid_hw_stop(drh->hdev);
+}
+
+int wiiu_hid_probe(struct hid_device *hdev,
+		   const struct hid_device_id *id)
+{
+	struct drh *drh;
+	int ret;
+
+	drh = devm_kzalloc(&hdev->dev, sizeof(struct drh), GFP_KERNEL);
+	if (!drh)
+		return -ENOMEM;
+
+	BUILD_BUG_ON(sizeof(*drh->shared) > PAGE_SIZE);
+	BUILD_BUG_ON(ARRAY_SIZE(drh->shared->pads) < DRH_MAX_PADS);
+	drh->shared = (void *)get_zeroed_page(GFP_KERNEL);
+	if (!drh->shared)
+		return -ENOMEM;
+	ret = devm_add_action_or_reset(&hdev->dev, drh_free_shared,
+				       drh->shared);
+	if (ret)
+		return ret;
+
+	drh->driver = NINTENDO_WIIU;
+	drh->hdev = hdev;
+	INIT_WORK(&drh->pad_work, drh_pad_work);
+
+	/* The first DRC is created below, never from the work. */
+	set_bit(0, &drh->pads_requested);
+
+	hid_set_drvdata(hdev, drh);
+
+	ret = hid_parse(hdev);
+	if (ret) {
+		hid_err(hdev, "parse failed\n");
+		return ret;
+	}
+
 	ret = hid_hw_start(hdev, HID_CONNECT_HIDRAW | HID_CONNECT_DRIVER);
 	if (ret) {
 		hid_err(hdev, "hw start failed\n");
 		return ret;
 	}
 
-	ret = input_register_device(drc->joy_input_dev) ||
-	      input_register_device(drc->touch_input_dev) ||
-	      input_register_device(drc->accel_input_dev);
+	ret = drc_create(drh, 0);
+	if (ret)
+		goto err_stop;
+
+	ret = device_create_bin_file(&hdev->dev, &bin_attr_drc_state);
 	if (ret) {
-		hid_err(hdev, "failed to register interfaces\n");
-		return ret;
+		hid_err(hdev, "could not create drc_state: %d\n", ret);
+		goto err_stop;
 	}
 
+	device_set_resume_priority(&hdev->dev);
+
 	return 0;
+
+err_stop:
+	drh_stop(drh);
+	return ret;
+}
+
+void wiiu_hid_remove(struct hid_device *hdev)
+{
+	struct drh *drh = hid_get_drvdata(hdev);
+
+	device_remove_bin_file(&hdev->dev, &bin_attr_drc_state);
+	drh_stop(drh);
 }
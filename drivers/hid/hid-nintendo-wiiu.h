@@ -0,0 +1,295 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * Report layout and state of the Nintendo Wii U gamepad (DRC) driver,
+ * shared with its KUnit tests
+ */
+
+#ifndef __HID_NINTENDO_WIIU_H
+#define __HID_NINTENDO_WIIU_H
+
+#include <linux/hid.h>
+#include <linux/input.h>
+#include <linux/ktime.h>
+#include <linux/workqueue.h>
+#include <linux/hid-nintendo-wiiu.h>
+#ifdef CONFIG_HID_BATTERY_STRENGTH
+#include <linux/power_supply.h>
+#endif
+
+#include "hid-nintendo.h"
+
+struct iio_dev;
+
+#define DEVICE_NAME	"Nintendo Wii U gamepad (DRC)"
+
+/* Button and stick constants */
+#define VOLUME_MIN	0
+#define VOLUME_MAX	255
+#define NUM_STICK_AXES	4
+#define STICK_MIN	900
+#define STICK_MAX	3200
+#define STICK_CENTER	((STICK_MIN + STICK_MAX) / 2)
+/* How far from STICK_CENTER a resting stick may be to be trusted as such */
+#define STICK_CENTER_RANGE	300
+
+#define BUTTON_SYNC	BIT(0)
+#define BUTTON_HOME	BIT(1)
+#define BUTTON_MINUS	BIT(2)
+#define BUTTON_PLUS	BIT(3)
+#define BUTTON_R	BIT(4)
+#define BUTTON_L	BIT(5)
+#define BUTTON_ZR	BIT(6)
+#define BUTTON_ZL	BIT(7)
+#define BUTTON_DOWN	BIT(8)
+#define BUTTON_UP	BIT(9)
+#define BUTTON_RIGHT	BIT(10)
+#define BUTTON_LEFT	BIT(11)
+#define BUTTON_Y	BIT(12)
+#define BUTTON_X	BIT(13)
+#define BUTTON_B	BIT(14)
+#define BUTTON_A	BIT(15)
+
+#define BUTTON_TV	BIT(21)
+#define BUTTON_R3	BIT(22)
+#define BUTTON_L3	BIT(23)
+
+#define BUTTON_POWER	BIT(25)
+
+/* Touch constants */
+/* Resolution in pixels */
+#define RES_X		854
+#define RES_Y		480
+/* Display/touch size in mm */
+#define WIDTH		138
+#define HEIGHT		79
+#define NUM_TOUCH_POINTS 10
+#define MAX_TOUCH_RES	(1 << 12)
+#define TOUCH_BORDER_X	100
+#define TOUCH_BORDER_Y	200
+#define MAX_PRESSURE	((1 << 12) - 1)
+
+/* Accelerometer, gyroscope and magnetometer constants */
+#define ACCEL_MIN	-(1 << 15)
+#define ACCEL_MAX	((1 << 15) - 1)
+#define GYRO_MIN	-(1 << 23)
+#define GYRO_MAX	((1 << 23) - 1)
+#define MAGNET_MIN	-(1 << 15)
+#define MAGNET_MAX	((1 << 15) - 1)
+
+/* ADC constants for the battery */
+#define BATTERY_CHARGING_BIT	BIT(6)
+#define BATTERY_MIN	142
+#define BATTERY_MAX	178
+#define VOLTAGE_MIN	3270000
+#define VOLTAGE_MAX	4100000
+
+/*
+ * The battery energy and status are published as a single word, so that the
+ * report path and sysfs readers never need a lock.
+ */
+#define BATTERY_STATE(energy, status)	((energy) | ((status) << 8))
+#define BATTERY_ENERGY(state)		((state) & 0xff)
+#define BATTERY_STATUS(state)		((state) >> 8)
+
+/*
+ * The rumble motor is either on or off, its strength is approximated by the
+ * duty cycle of a pattern of RUMBLE_PATTERN_BITS slots, which the DRC plays
+ * in a loop until the next rumble report.
+ */
+#define RUMBLE_REPORT_LEN	4
+#define RUMBLE_REPORT_CMD	0x01
+#define RUMBLE_PATTERN_BITS	8
+
+#if IS_ENABLED(CONFIG_NINTENDO_FF)
+/*
+ * Sends the rumble report of one DRC. When the DRH numbers its reports,
+ * the report goes out with the ID of the pad's input reports in front.
+ */
+struct drc_rumble_work {
+	struct hid_output_work work;
+	unsigned int pad;	/* index of the DRC */
+	u8 report_id;		/* of the pad's input reports, 0 if unnumbered */
+};
+#endif
+
+/* Offsets into the input report */
+#define REPORT_LEN		128
+#define REPORT_SEQ		0
+#define REPORT_STICKS		6
+#define REPORT_STICKS_LEN	(2 * NUM_STICK_AXES)
+#define REPORT_VOLUME		14
+#define REPORT_MOTION		15
+#define REPORT_MOTION_LEN	21
+#define REPORT_TOUCH		36
+
+/*
+ * Reports are sent by the DRC at about 180 Hz, the period is refined from the
+ * arrival times over a window of reports, and the clock model is reset when
+ * too many reports are lost at once.
+ */
+#define CLOCK_DFLT_PERIOD_NS	(NSEC_PER_SEC / 180)
+#define CLOCK_WINDOW		256
+#define CLOCK_MAX_GAP		32
+#define CLOCK_SLEW_SHIFT	4
+
+/*
+ * The DRH can serve up to two DRCs, whose reports are numbered with the pad
+ * index plus one when more than one is supported.
+ */
+#define DRH_MAX_PADS		2
+
+/*
+ * Each DRC is setup with multiple input devices:
+ * - A joypad with the buttons and sticks.
+ * - The touch area which works as a touchscreen.
+ * - An accelerometer + gyroscope + magnetometer device.
+ */
+
+/*
+ * Packed copy of the last decoded report, only the differences with the next
+ * report are pushed to the input devices.
+ */
+struct drc_state {
+	bool valid;
+	ktime_t time;
+	u32 buttons;
+	s16 sticks[NUM_STICK_AXES];
+	u8 volume;
+	bool touch;
+	u16 touch_x;
+	u16 touch_y;
+	u8 motion[REPORT_MOTION_LEN];
+};
+
+/* Decoded accelerometer, magnetometer and gyroscope sample */
+struct drc_motion {
+	s16 accel[3];
+	s16 magn[3];
+	s32 gyro[3];
+};
+
+/* Inter-arrival times histogram, in log2 buckets of microseconds */
+#define STATS_HIST_BUCKETS	16
+
+/*
+ * Statistics exposed in debugfs, updated from the event path only and read
+ * without any synchronisation.
+ */
+struct drc_stats {
+	u64 accepted;
+	u64 rejected;
+	u64 idle_decimated;
+	u64 gaps;
+	u64 lost;
+	u16 last_seq;
+	ktime_t first_arrival;
+	ktime_t last_arrival;
+	u64 hist[STATS_HIST_BUCKETS];
+};
+
+/*
+ * Model of the DRC sampling clock, in host time, derived from the sequence
+ * number of each report.
+ */
+struct drc_clock {
+	bool valid;
+	u16 seq;
+	ktime_t time;
+	u32 period_ns;
+	u16 window_seq;
+	ktime_t window_start;
+};
+
+struct drh;
+
+struct drc {
+	struct drh *drh;
+	struct hid_device *hdev;
+	unsigned int index;
+	const char *name;
+	const char *phys;
+	struct input_dev *joy_input_dev;
+	struct input_dev *touch_input_dev;
+	struct input_dev *accel_input_dev;
+	struct drc_state state;
+	struct drc_clock clock;
+	/* This DRC's slot in drh->shared */
+	struct wiiu_drc_state *shared;
+	/* Raw resting position of each stick axis, see stick_deadzone */
+	s16 stick_center[NUM_STICK_AXES];
+	/* See idle_timeout_ms, idle_motion is the sample the motion is compared to */
+	bool idle;
+	unsigned int idle_count;
+	ktime_t last_active;
+	struct drc_motion idle_motion;
+#ifdef CONFIG_DEBUG_FS
+	struct drc_stats stats;
+#endif
+
+#if IS_ENABLED(CONFIG_NINTENDO_FF)
+	/*
+	 * Effects only record the requested magnitude, the rumble report is
+	 * sent from rumble_work, scheduled at most once per input report.
+	 */
+	struct drc_rumble_work rumble_work;
+	u8 *rumble_buf;
+	u16 rumble_magnitude;
+	u8 rumble_pattern;
+	bool rumble_pending;
+#endif
+
+#ifdef CONFIG_HID_NINTENDO_WIIU_IIO
+	struct iio_dev *indio_dev;
+	/* One buffer scan, in the order of drc_iio_channels */
+	struct {
+		struct drc_motion motion;
+		s64 timestamp __aligned(8);
+	} scan;
+#endif
+
+#ifdef CONFIG_HID_BATTERY_STRENGTH
+	struct power_supply *battery;
+	struct power_supply_desc battery_desc;
+	/* Packed energy and status, see BATTERY_STATE() */
+	atomic_t battery_state;
+	/* Last values userspace has been notified of */
+	int battery_notified_status;
+	int battery_notified_capacity;
+#endif
+};
+
+/*
+ * The DRCs are created on demand, the first time one of their reports is
+ * received, except for the first one which always exists.  Once published in
+ * pads[], they live until the DRH is removed.
+ *
+ * The latest state of every DRC is also kept in the shared page, which
+ * userspace maps read-only through the drc_state attribute.
+ */
+struct drh {
+	enum nintendo_driver driver;
+	struct hid_device *hdev;
+	struct wiiu_drh_state *shared;
+	struct drc *pads[DRH_MAX_PADS];
+	unsigned long pads_requested;
+	struct work_struct pad_work;
+	bool removed;
+};
+
+#ifdef CONFIG_HID_NINTENDO_WIIU_KUNIT_TEST
+#define WIIU_VISIBLE_IF_KUNIT
+
+extern unsigned int stick_deadzone;
+extern unsigned int stick_fuzz;
+extern bool touch_mt;
+extern unsigned int idle_timeout_ms;
+extern unsigned int idle_divider;
+
+bool drc_setup_joypad(struct drc *drc, struct hid_device *hdev);
+bool drc_setup_touch(struct drc *drc, struct hid_device *hdev);
+bool drc_setup_accel(struct drc *drc, struct hid_device *hdev);
+#else
+#define WIIU_VISIBLE_IF_KUNIT	static
+#endif
+
+#endif
@@ -49,9 +49,15 @@ static int nintendo_hid_probe(struct hid_device *hdev,
 
 static void nintendo_hid_remove(struct hid_device *hdev)
 {
-#ifdef CONFIG_HID_NINTENDO_SWITCH
+#if defined(CONFIG_HID_NINTENDO_SWITCH) || defined(CONFIG_HID_NINTENDO_WIIU)
 	enum nintendo_driver *driver = hid_get_drvdata(hdev);
+#endif
 
+#ifdef CONFIG_HID_NINTENDO_WIIU
+	if (*driver == NINTENDO_WIIU)
+		wiiu_hid_remove(hdev);
+#endif
+#ifdef CONFIG_HID_NINTENDO_SWITCH
 	if (*driver == NINTENDO_SWITCH)
 		switch_hid_remove(hdev);
 #endif
@@ -87,7 +93,22 @@ static struct hid_driver nintendo_hid_driver = {
 	.remove		= nintendo_hid_remove,
 	.raw_event	= nintendo_hid_event,
 };
-module_hid_driver(nintendo_hid_driver);
+
+static int __init nintendo_init(void)
+{
+	return hid_register_driver(&nintendo_hid_driver);
+}
+
+static void __exit nintendo_exit(void)
+{
+	hid_unregister_driver(&nintendo_hid_driver);
+#ifdef CONFIG_HID_NINTENDO_SWITCH
+	switch_hid_exit();
+#endif
+}
+
+module_init(nintendo_init);
+module_exit(nintendo_exit);
 
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("Emmanuel Gil Peyrot <linkmauve@linkmauve.fr>");
@@ -1,5 +1,8 @@
 // SPDX-License-Identifier: GPL-2.0+
 
+#ifndef __HID_NINTENDO_H
+#define __HID_NINTENDO_H
+
 #include <linux/kernel.h>
 #include <linux/hid.h>
 
@@ -10,13 +13,34 @@ enum nintendo_driver {
 	NINTENDO_SWITCH,
 };
 
+/*
+ * Signed motion channel of an IIO buffer scan, for the drivers exposing their
+ * motion sensors through IIO.
+ */
+#define NINTENDO_IIO_CHANNEL(_type, _axis, _index, _bits) {	\
+	.type = (_type),					\
+	.modified = 1,						\
+	.channel2 = IIO_MOD_##_axis,				\
+	.scan_index = (_index),					\
+	.scan_type = {						\
+		.sign = 's',					\
+		.realbits = (_bits),				\
+		.storagebits = (_bits) > 16 ? 32 : 16,		\
+		.endianness = IIO_CPU,				\
+	},							\
+}
+
 int wiiu_hid_event(struct hid_device *hdev, struct hid_report *report,
 		   u8 *data, int len);
 int wiiu_hid_probe(struct hid_device *hdev,
 		   const struct hid_device_id *id);
+void wiiu_hid_remove(struct hid_device *hdev);
 
 int switch_hid_event(struct hid_device *hdev,
 		     struct hid_report *report, u8 *raw_data, int size);
 int switch_hid_probe(struct hid_device *hdev,
 		     const struct hid_device_id *id);
 void switch_hid_remove(struct hid_device *hdev);
+void switch_hid_exit(void);
+
+#endif
@@ -68,6 +68,9 @@ struct ps_led_info {
 #define PS_OUTPUT_CRC32_SEED	0xA2
 #define PS_FEATURE_CRC32_SEED	0xA3
 
+/* CRC32 state after the seed byte of each report type, set up at init. */
+static uint32_t ps_crc32_prefix[PS_FEATURE_CRC32_SEED - PS_INPUT_CRC32_SEED + 1];
+
 #define DS_INPUT_REPORT_USB			0x01
 #define DS_INPUT_REPORT_USB_SIZE		64
 #define DS_INPUT_REPORT_BT			0x31
@@ -172,8 +175,10 @@ struct dualsense {
 	bool update_player_leds;
 	uint8_t player_leds_state;
 	struct led_classdev player_leds[5];
+	struct led_classdev *player_led_ptrs[5];
+	struct led_group player_led_group;
 
-	struct work_struct output_worker;
+	struct hid_output_work output_worker;
 	void *output_report_dmabuf;
 	uint8_t output_seq; /* Sequence number for output report. */
 };
@@ -454,15 +459,24 @@ static int ps_device_register_battery(struct ps_device *dev)
 	return 0;
 }
 
-/* Compute crc32 of HID data and compare against expected CRC. */
-static bool ps_check_crc32(uint8_t seed, uint8_t *data, size_t len, uint32_t report_crc)
+static void ps_crc32_init(void)
 {
-	uint32_t crc;
+	uint8_t seed;
 
-	crc = crc32_le(0xFFFFFFFF, &seed, 1);
-	crc = ~crc32_le(crc, data, len);
+	for (seed = PS_INPUT_CRC32_SEED; seed <= PS_FEATURE_CRC32_SEED; seed++)
+		ps_crc32_prefix[seed - PS_INPUT_CRC32_SEED] = crc32_le(0xFFFFFFFF, &seed, 1);
+}
 
-	return crc == report_crc;
+/* Compute crc32 of HID data, prefixed by the seed of its report type. */
+static uint32_t ps_crc32(uint8_t seed, const uint8_t *data, size_t len)
+{
+	return ~crc32_le(ps_crc32_prefix[seed - PS_INPUT_CRC32_SEED], data, len);
+}
+
+/* Compute crc32 of HID data and compare against expected CRC. */
+static bool ps_check_crc32(uint8_t seed, uint8_t *data, size_t len, uint32_t report_crc)
+{
+	return ps_crc32(seed, data, len) == report_crc;
 }
 
 static struct input_dev *ps_gamepad_create(struct hid_device *hdev,
@@ -881,7 +895,31 @@ static int dualsense_player_led_set_brightness(struct led_classdev *led, enum le
 	ds->update_player_leds = true;
 	spin_unlock_irqrestore(&ds->base.lock, flags);
 
-	schedule_work(&ds->output_worker);
+	hid_queue_output_work(&ds->output_worker);
+
+	return 0;
+}
+
+/* All the player leds in one output report. */
+static int dualsense_player_leds_set(struct led_group *group,
+				     const enum led_brightness *brightness)
+{
+	struct dualsense *ds = container_of(group, struct dualsense,
+					    player_led_group);
+	unsigned long flags;
+	uint8_t state = 0;
+	unsigned int i;
+
+	for (i = 0; i < group->num_leds; i++)
+		if (brightness[i] != LED_OFF)
+			state |= BIT(i);
+
+	spin_lock_irqsave(&ds->base.lock, flags);
+	ds->player_leds_state = state;
+	ds->update_player_leds = true;
+	spin_unlock_irqrestore(&ds->base.lock, flags);
+
+	hid_queue_output_work(&ds->output_worker);
 
 	return 0;
 }
@@ -936,11 +974,7 @@ static void dualsense_send_output_report(struct dualsense *ds,
 
 	/* Bluetooth packets need to be signed with a CRC in the last 4 bytes. */
 	if (report->bt) {
-		uint32_t crc;
-		uint8_t seed = PS_OUTPUT_CRC32_SEED;
-
-		crc = crc32_le(0xFFFFFFFF, &seed, 1);
-		crc = ~crc32_le(crc, report->data, report->len - 4);
+		uint32_t crc = ps_crc32(PS_OUTPUT_CRC32_SEED, report->data, report->len - 4);
 
 		report->bt->crc32 = cpu_to_le32(crc);
 	}
@@ -950,7 +984,8 @@ static void dualsense_send_output_report(struct dualsense *ds,
 
 static void dualsense_output_worker(struct work_struct *work)
 {
-	struct dualsense *ds = container_of(work, struct dualsense, output_worker);
+	struct dualsense *ds = container_of(work, struct dualsense,
+					    output_worker.work);
 	struct dualsense_output_report report;
 	struct dualsense_output_report_common *common;
 	unsigned long flags;
@@ -1085,7 +1120,7 @@ static int dualsense_parse_report(struct ps_device *ps_dev, struct hid_report *r
 		spin_unlock_irqrestore(&ps_dev->lock, flags);
 
 		/* Schedule updating of microphone state at hardware level. */
-		schedule_work(&ds->output_worker);
+		hid_queue_output_work(&ds->output_worker);
 	}
 	ds->last_btn_mic_state = btn_mic_state;
 
@@ -1200,7 +1235,7 @@ static int dualsense_play_effect(struct input_dev *dev, void *data, struct ff_ef
 	ds->motor_right = effect->u.rumble.weak_magnitude / 256;
 	spin_unlock_irqrestore(&ds->base.lock, flags);
 
-	schedule_work(&ds->output_worker);
+	hid_queue_output_work(&ds->output_worker);
 	return 0;
 }
 
@@ -1240,7 +1275,7 @@ static void dualsense_set_lightbar(struct dualsense *ds, uint8_t red, uint8_t gr
 	ds->lightbar_blue = blue;
 	spin_unlock_irqrestore(&ds->base.lock, flags);
 
-	schedule_work(&ds->output_worker);
+	hid_queue_output_work(&ds->output_worker);
 }
 
 static void dualsense_set_player_leds(struct dualsense *ds)
@@ -1263,7 +1298,7 @@ static void dualsense_set_player_leds(struct dualsense *ds)
 
 	ds->update_player_leds = true;
 	ds->player_leds_state = player_ids[player_id];
-	schedule_work(&ds->output_worker);
+	hid_queue_output_work(&ds->output_worker);
 }
 
 static struct ps_device *dualsense_create(struct hid_device *hdev)
@@ -1302,7 +1337,7 @@ static struct ps_device *dualsense_create(struct hid_device *hdev)
 	ps_dev->battery_capacity = 100; /* initial value until parse_report. */
 	ps_dev->battery_status = POWER_SUPPLY_STATUS_UNKNOWN;
 	ps_dev->parse_report = dualsense_parse_report;
-	INIT_WORK(&ds->output_worker, dualsense_output_worker);
+	hid_init_output_work(&ds->output_worker, dualsense_output_worker);
 	hid_set_drvdata(hdev, ds);
 
 	max_output_report_size = sizeof(struct dualsense_output_report_bt);
@@ -1380,6 +1415,17 @@ static struct ps_device *dualsense_create(struct hid_device *hdev)
 		ret = ps_led_register(ps_dev, &ds->player_leds[i], led_info);
 		if (ret < 0)
 			goto err;
+		ds->player_led_ptrs[i] = &ds->player_leds[i];
+	}
+
+	ds->player_led_group.name = "player_leds";
+	ds->player_led_group.leds = ds->player_led_ptrs;
+	ds->player_led_group.num_leds = ARRAY_SIZE(ds->player_led_ptrs);
+	ds->player_led_group.brightness_set = dualsense_player_leds_set;
+	ret = devm_led_group_register(&hdev->dev, &ds->player_led_group);
+	if (ret) {
+		hid_err(hdev, "Failed to register player LED group: %d\n", ret);
+		goto err;
 	}
 
 	ret = ps_device_set_player_id(ps_dev);
@@ -1491,6 +1537,8 @@ static struct hid_driver ps_driver = {
 
 static int __init ps_init(void)
 {
+	ps_crc32_init();
+
 	return hid_register_driver(&ps_driver);
 }
 
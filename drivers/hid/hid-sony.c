@@ -532,6 +532,9 @@ struct motion_output_report_02 {
 #define DS4_GYRO_RES_PER_DEG_S 1024
 #define DS4_ACC_RES_PER_G      8192
 
+#define SIXAXIS_INPUT_REPORT_BUTTON_OFFSET   2
+#define SIXAXIS_INPUT_REPORT_AXIS_OFFSET     6
+#define SIXAXIS_INPUT_REPORT_TRIGGER_OFFSET 18
 #define SIXAXIS_INPUT_REPORT_ACC_X_OFFSET 41
 #define SIXAXIS_ACC_RES_PER_G 113
 
@@ -610,6 +613,7 @@ struct sony_sc {
 	/* GH Live */
 	struct urb *ghl_urb;
 	struct timer_list ghl_poke_timer;
+	unsigned long ghl_output_jiffies;
 };
 
 static void sony_set_leds(struct sony_sc *sc);
@@ -647,10 +651,26 @@ static void ghl_magic_poke(struct timer_list *t)
 {
 	int ret;
 	struct sony_sc *sc = from_timer(sc, t, ghl_poke_timer);
+	unsigned long output = READ_ONCE(sc->hdev->output_jiffies);
+
+	/*
+	 * The dongle only needs poking while somebody reads the guitar,
+	 * through an input device or hidraw, and not if other outputs
+	 * were sent to it since the last tick.
+	 */
+	if (!READ_ONCE(sc->hdev->ll_open_count) ||
+	    output != sc->ghl_output_jiffies) {
+		sc->ghl_output_jiffies = output;
+		goto rearm;
+	}
 
 	ret = usb_submit_urb(sc->ghl_urb, GFP_ATOMIC);
-	if (ret < 0)
-		hid_err(sc->hdev, "usb_submit_urb failed: %d", ret);
+	if (!ret)
+		return;
+
+	hid_err(sc->hdev, "usb_submit_urb failed: %d", ret);
+rearm:
+	mod_timer(&sc->ghl_poke_timer, jiffies + GHL_GUITAR_POKE_INTERVAL*HZ);
 }
 
 static int ghl_init_urb(struct sony_sc *sc, struct usb_device *usbdev,
@@ -1017,7 +1037,35 @@ static void sixaxis_parse_report(struct sony_sc *sc, u8 *rd, int size)
 	spin_unlock_irqrestore(&sc->lock, flags);
 
 	if (sc->quirks & SIXAXIS_CONTROLLER) {
-		int val;
+		struct hid_input *hidinput = list_first_entry(&sc->hdev->inputs,
+							      struct hid_input, list);
+		struct input_dev *input_dev = hidinput->input;
+		u32 buttons;
+		int val, n;
+
+		/*
+		 * Decode what sixaxis_mapping() maps, so that sony_raw_event()
+		 * can skip the generic parsing of the report: 17 buttons in
+		 * the keymap order, the sticks, and the analog L2 and R2
+		 * which are the 9th and 10th of the analog button values.
+		 */
+		offset = SIXAXIS_INPUT_REPORT_BUTTON_OFFSET;
+		buttons = rd[offset] | (rd[offset+1] << 8) | (rd[offset+2] << 16);
+		for (n = 1; n < ARRAY_SIZE(sixaxis_keymap); n++)
+			input_report_key(input_dev, sixaxis_keymap[n],
+					 buttons & BIT(n - 1));
+
+		offset = SIXAXIS_INPUT_REPORT_AXIS_OFFSET;
+		input_report_abs(input_dev, ABS_X, rd[offset]);
+		input_report_abs(input_dev, ABS_Y, rd[offset+1]);
+		input_report_abs(input_dev, ABS_RX, rd[offset+2]);
+		input_report_abs(input_dev, ABS_RY, rd[offset+3]);
+
+		offset = SIXAXIS_INPUT_REPORT_TRIGGER_OFFSET;
+		input_report_abs(input_dev, ABS_Z, rd[offset]);
+		input_report_abs(input_dev, ABS_RZ, rd[offset+1]);
+
+		input_sync(input_dev);
 
 		offset = SIXAXIS_INPUT_REPORT_ACC_X_OFFSET;
 		val = ((rd[offset+1] << 8) | rd[offset]) - 511;
@@ -1041,6 +1089,7 @@ static void dualshock4_parse_report(struct sony_sc *sc, u8 *rd, int size)
 	struct input_dev *input_dev = hidinput->input;
 	unsigned long flags;
 	int n, m, offset, num_touch_data, max_touch_data;
+	int value;
 	u8 cable_state, battery_capacity;
 	int battery_status;
 	u16 timestamp;
@@ -1065,43 +1114,42 @@ static void dualshock4_parse_report(struct sony_sc *sc, u8 *rd, int size)
 	 * operating systems. If the descriptors wouldn't match some
 	 * applications e.g. games on Wine would not be able to function due
 	 * to different descriptors, which such applications are not parsing.
+	 *
+	 * Report 1 over USB has the same layout, and is decoded here as well
+	 * so that sony_raw_event() can skip its generic parsing.
 	 */
-	if (rd[0] == 17) {
-		int value;
-
-		offset = data_offset + DS4_INPUT_REPORT_AXIS_OFFSET;
-		input_report_abs(input_dev, ABS_X, rd[offset]);
-		input_report_abs(input_dev, ABS_Y, rd[offset+1]);
-		input_report_abs(input_dev, ABS_RX, rd[offset+2]);
-		input_report_abs(input_dev, ABS_RY, rd[offset+3]);
-
-		value = rd[offset+4] & 0xf;
-		if (value > 7)
-			value = 8; /* Center 0, 0 */
-		input_report_abs(input_dev, ABS_HAT0X, ds4_hat_mapping[value].x);
-		input_report_abs(input_dev, ABS_HAT0Y, ds4_hat_mapping[value].y);
-
-		input_report_key(input_dev, BTN_WEST, rd[offset+4] & 0x10);
-		input_report_key(input_dev, BTN_SOUTH, rd[offset+4] & 0x20);
-		input_report_key(input_dev, BTN_EAST, rd[offset+4] & 0x40);
-		input_report_key(input_dev, BTN_NORTH, rd[offset+4] & 0x80);
-
-		input_report_key(input_dev, BTN_TL, rd[offset+5] & 0x1);
-		input_report_key(input_dev, BTN_TR, rd[offset+5] & 0x2);
-		input_report_key(input_dev, BTN_TL2, rd[offset+5] & 0x4);
-		input_report_key(input_dev, BTN_TR2, rd[offset+5] & 0x8);
-		input_report_key(input_dev, BTN_SELECT, rd[offset+5] & 0x10);
-		input_report_key(input_dev, BTN_START, rd[offset+5] & 0x20);
-		input_report_key(input_dev, BTN_THUMBL, rd[offset+5] & 0x40);
-		input_report_key(input_dev, BTN_THUMBR, rd[offset+5] & 0x80);
-
-		input_report_key(input_dev, BTN_MODE, rd[offset+6] & 0x1);
-
-		input_report_abs(input_dev, ABS_Z, rd[offset+7]);
-		input_report_abs(input_dev, ABS_RZ, rd[offset+8]);
-
-		input_sync(input_dev);
-	}
+	offset = data_offset + DS4_INPUT_REPORT_AXIS_OFFSET;
+	input_report_abs(input_dev, ABS_X, rd[offset]);
+	input_report_abs(input_dev, ABS_Y, rd[offset+1]);
+	input_report_abs(input_dev, ABS_RX, rd[offset+2]);
+	input_report_abs(input_dev, ABS_RY, rd[offset+3]);
+
+	value = rd[offset+4] & 0xf;
+	if (value > 7)
+		value = 8; /* Center 0, 0 */
+	input_report_abs(input_dev, ABS_HAT0X, ds4_hat_mapping[value].x);
+	input_report_abs(input_dev, ABS_HAT0Y, ds4_hat_mapping[value].y);
+
+	input_report_key(input_dev, BTN_WEST, rd[offset+4] & 0x10);
+	input_report_key(input_dev, BTN_SOUTH, rd[offset+4] & 0x20);
+	input_report_key(input_dev, BTN_EAST, rd[offset+4] & 0x40);
+	input_report_key(input_dev, BTN_NORTH, rd[offset+4] & 0x80);
+
+	input_report_key(input_dev, BTN_TL, rd[offset+5] & 0x1);
+	input_report_key(input_dev, BTN_TR, rd[offset+5] & 0x2);
+	input_report_key(input_dev, BTN_TL2, rd[offset+5] & 0x4);
+	input_report_key(input_dev, BTN_TR2, rd[offset+5] & 0x8);
+	input_report_key(input_dev, BTN_SELECT, rd[offset+5] & 0x10);
+	input_report_key(input_dev, BTN_START, rd[offset+5] & 0x20);
+	input_report_key(input_dev, BTN_THUMBL, rd[offset+5] & 0x40);
+	input_report_key(input_dev, BTN_THUMBR, rd[offset+5] & 0x80);
+
+	input_report_key(input_dev, BTN_MODE, rd[offset+6] & 0x1);
+
+	input_report_abs(input_dev, ABS_Z, rd[offset+7]);
+	input_report_abs(input_dev, ABS_RZ, rd[offset+8]);
+
+	input_sync(input_dev);
 
 	/* Convert timestamp (in 5.33us unit) to timestamp_us */
 	offset = data_offset + DS4_INPUT_REPORT_TIMESTAMP_OFFSET;
@@ -1322,6 +1370,7 @@ static int sony_raw_event(struct hid_device *hdev, struct hid_report *report,
 		u8 *rd, int size)
 {
 	struct sony_sc *sc = hid_get_drvdata(hdev);
+	int ret = 0;
 
 	/*
 	 * Sixaxis HID report has acclerometers/gyro with MSByte first, this
@@ -1345,6 +1394,7 @@ static int sony_raw_event(struct hid_device *hdev, struct hid_report *report,
 		swap(rd[47], rd[48]);
 
 		sixaxis_parse_report(sc, rd, size);
+		ret = HID_RAW_EVENT_CONSUMED;
 	} else if ((sc->quirks & MOTION_CONTROLLER_BT) && rd[0] == 0x01 && size == 49) {
 		sixaxis_parse_report(sc, rd, size);
 	} else if ((sc->quirks & NAVIGATION_CONTROLLER) && rd[0] == 0x01 &&
@@ -1353,6 +1403,7 @@ static int sony_raw_event(struct hid_device *hdev, struct hid_report *report,
 	} else if ((sc->quirks & DUALSHOCK4_CONTROLLER_USB) && rd[0] == 0x01 &&
 			size == 64) {
 		dualshock4_parse_report(sc, rd, size);
+		ret = HID_RAW_EVENT_CONSUMED;
 	} else if (((sc->quirks & DUALSHOCK4_CONTROLLER_BT) && rd[0] == 0x11 &&
 			size == 78)) {
 		/* CRC check */
@@ -1370,6 +1421,7 @@ static int sony_raw_event(struct hid_device *hdev, struct hid_report *report,
 		}
 
 		dualshock4_parse_report(sc, rd, size);
+		ret = HID_RAW_EVENT_CONSUMED;
 	} else if ((sc->quirks & DUALSHOCK4_DONGLE) && rd[0] == 0x01 &&
 			size == 64) {
 		unsigned long flags;
@@ -1426,7 +1478,7 @@ static int sony_raw_event(struct hid_device *hdev, struct hid_report *report,
 		}
 
 		dualshock4_parse_report(sc, rd, size);
-
+		ret = HID_RAW_EVENT_CONSUMED;
 	} else if ((sc->quirks & NSG_MRXU_REMOTE) && rd[0] == 0x02) {
 		nsg_mrxu_parse_report(sc, rd, size);
 		return 1;
@@ -1437,7 +1489,7 @@ static int sony_raw_event(struct hid_device *hdev, struct hid_report *report,
 		sony_schedule_work(sc, SONY_WORKER_STATE);
 	}
 
-	return 0;
+	return ret;
 }
 
 static int sony_mapping(struct hid_device *hdev, struct hid_input *hi,
@@ -3058,7 +3110,10 @@ static int sony_probe(struct hid_device *hdev, const struct hid_device_id *id)
 			return ret;
 		}
 
-		timer_setup(&sc->ghl_poke_timer, ghl_magic_poke, 0);
+		/* no need to wake an idle CPU for the poke */
+		sc->ghl_output_jiffies = READ_ONCE(hdev->output_jiffies);
+		timer_setup(&sc->ghl_poke_timer, ghl_magic_poke,
+			    TIMER_DEFERRABLE);
 		mod_timer(&sc->ghl_poke_timer,
 			  jiffies + GHL_GUITAR_POKE_INTERVAL*HZ);
 	}
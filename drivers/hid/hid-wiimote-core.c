@@ -41,7 +41,7 @@ static int wiimote_hid_send(struct hid_device *hdev, __u8 *buffer,
 static void wiimote_queue_worker(struct work_struct *work)
 {
 	struct wiimote_queue *queue = container_of(work, struct wiimote_queue,
-						   worker);
+						   worker.work);
 	struct wiimote_data *wdata = container_of(queue, struct wiimote_data,
 						  queue);
 	unsigned long flags;
@@ -98,7 +98,7 @@ static void wiimote_queue(struct wiimote_data *wdata, const __u8 *buffer,
 
 	if (wdata->queue.head == wdata->queue.tail) {
 		wdata->queue.head = newhead;
-		schedule_work(&wdata->queue.worker);
+		hid_queue_output_work(&wdata->queue.worker);
 	} else if (newhead != wdata->queue.tail) {
 		wdata->queue.head = newhead;
 	} else {
@@ -407,43 +407,121 @@ ssize_t wiimote_cmd_read(struct wiimote_data *wdata, __u32 offset, __u8 *rmem,
 	return ret;
 }
 
-/* requires the cmd-mutex to be held */
-static int wiimote_cmd_init_ext(struct wiimote_data *wdata)
+/* requires the state.lock spinlock to be held */
+static void wiimote_cmd_expect_op(struct wiimote_data *wdata,
+				  struct wiimote_mem_op *op)
 {
-	__u8 wmem;
-	int ret;
+	wdata->state.cmd_ops = op;
+	wdata->state.cmd_err = 0;
+	if (op->wmem) {
+		wdata->state.cmd = WIIPROTO_REQ_WMEM;
+		wdata->state.opt = 0;
+	} else {
+		wdata->state.cmd_read_size = op->size;
+		wdata->state.cmd_read_buf = op->rmem;
+		wdata->state.cmd = WIIPROTO_REQ_RMEM;
+		wdata->state.opt = op->offset & 0xffff;
+	}
+}
 
-	/* initialize extension */
-	wmem = 0x55;
-	ret = wiimote_cmd_write(wdata, 0xa400f0, &wmem, sizeof(wmem));
-	if (ret)
-		return ret;
+/*
+ * Called by the reply handlers in place of wiimote_cmd_complete(). During a
+ * sequence, this moves on to the next access, which was sent already, and
+ * completes once the last one has been answered.
+ * requires the state.lock spinlock to be held
+ */
+static void wiimote_cmd_done(struct wiimote_data *wdata)
+{
+	struct wiimote_mem_op *op = wdata->state.cmd_ops;
 
-	/* disable default encryption */
-	wmem = 0x0;
-	ret = wiimote_cmd_write(wdata, 0xa400fb, &wmem, sizeof(wmem));
-	if (ret)
-		return ret;
+	if (!op) {
+		wiimote_cmd_complete(wdata);
+		return;
+	}
 
-	return 0;
+	if (op->wmem)
+		op->ret = wdata->state.cmd_err ? -EIO : 0;
+	else
+		op->ret = wdata->state.cmd_read_size ? : -EIO;
+
+	if (!--wdata->state.cmd_ops_left) {
+		wdata->state.cmd_ops = NULL;
+		wdata->state.cmd_read_buf = NULL;
+		wiimote_cmd_complete(wdata);
+		return;
+	}
+
+	wiimote_cmd_expect_op(wdata, op + 1);
 }
 
-/* requires the cmd-mutex to be held */
-static __u8 wiimote_cmd_read_ext(struct wiimote_data *wdata, __u8 *rmem)
+/*
+ * Sends a sequence of memory accesses back to back instead of waiting for
+ * each reply before sending the next request. The remote handles them in
+ * order, so the replies are matched in order, too. Returns 0 if all of them
+ * were answered; the result of each access is stored in its ret field.
+ * requires the cmd-mutex to be held
+ */
+int wiimote_cmd_mem_seq(struct wiimote_data *wdata,
+			struct wiimote_mem_op *ops, unsigned int num)
 {
-	int ret;
+	unsigned long flags;
+	unsigned int i;
+	int ret = 0;
 
-	/* read extension ID */
-	ret = wiimote_cmd_read(wdata, 0xa400fa, rmem, 6);
-	if (ret != 6)
-		return WIIMOTE_EXT_NONE;
+	if (!num)
+		return 0;
+
+	for (i = 0; i < num; ++i)
+		ops[i].ret = -EIO;
+
+	spin_lock_irqsave(&wdata->state.lock, flags);
+	reinit_completion(&wdata->state.ready);
+	wdata->state.cmd_ops_left = num;
+	wiimote_cmd_expect_op(wdata, ops);
+	for (i = 0; i < num; ++i) {
+		if (ops[i].wmem)
+			wiiproto_req_wreg(wdata, ops[i].offset, ops[i].wmem,
+					  ops[i].size);
+		else
+			wiiproto_req_rreg(wdata, ops[i].offset, ops[i].size);
+	}
+	spin_unlock_irqrestore(&wdata->state.lock, flags);
+
+	/* each access gets the time a single one is given */
+	if (!wait_for_completion_timeout(&wdata->state.ready, HZ * num))
+		ret = -EIO;
+
+	spin_lock_irqsave(&wdata->state.lock, flags);
+	if (wdata->state.cmd != WIIPROTO_REQ_NULL)
+		ret = -EIO;
+	wdata->state.cmd_ops = NULL;
+	wdata->state.cmd_read_buf = NULL;
+	spin_unlock_irqrestore(&wdata->state.lock, flags);
 
+	return ret;
+}
+
+static const __u8 wiimote_ext_init = 0x55;
+static const __u8 wiimote_ext_noenc = 0x00;
+
+/* requires the cmd-mutex to be held */
+static __u8 wiimote_ext_type(struct wiimote_data *wdata, const __u8 *rmem)
+{
 	hid_dbg(wdata->hdev, "extension ID: %6phC\n", rmem);
 
 	if (rmem[0] == 0xff && rmem[1] == 0xff && rmem[2] == 0xff &&
 	    rmem[3] == 0xff && rmem[4] == 0xff && rmem[5] == 0xff)
 		return WIIMOTE_EXT_NONE;
 
+	/*
+	 * Cached extension calibration survives unplugging and is only
+	 * dropped once another kind of extension shows up.
+	 */
+	if (memcmp(wdata->state.ext_id, rmem, 6)) {
+		memcpy(wdata->state.ext_id, rmem, 6);
+		wdata->state.ext_calib_valid = false;
+	}
+
 	if (rmem[4] == 0x00 && rmem[5] == 0x00)
 		return WIIMOTE_EXT_NUNCHUK;
 	if (rmem[4] == 0x01 && rmem[5] == 0x01)
@@ -463,24 +541,35 @@ static __u8 wiimote_cmd_read_ext(struct wiimote_data *wdata, __u8 *rmem)
 }
 
 /* requires the cmd-mutex to be held */
-static int wiimote_cmd_init_mp(struct wiimote_data *wdata)
+static __u8 wiimote_cmd_read_ext(struct wiimote_data *wdata, __u8 *rmem)
 {
-	__u8 wmem;
 	int ret;
 
-	/* initialize MP */
-	wmem = 0x55;
-	ret = wiimote_cmd_write(wdata, 0xa600f0, &wmem, sizeof(wmem));
-	if (ret)
-		return ret;
+	/* read extension ID */
+	ret = wiimote_cmd_read(wdata, 0xa400fa, rmem, 6);
+	if (ret != 6)
+		return WIIMOTE_EXT_NONE;
 
-	/* disable default encryption */
-	wmem = 0x0;
-	ret = wiimote_cmd_write(wdata, 0xa600fb, &wmem, sizeof(wmem));
-	if (ret)
-		return ret;
+	return wiimote_ext_type(wdata, rmem);
+}
 
-	return 0;
+/* Queues the writes initializing the extension (deactivates MP mapping) */
+static unsigned int wiimote_init_ext_ops(struct wiimote_mem_op *ops)
+{
+	/* initialize extension and disable default encryption */
+	ops[0] = WIIMOTE_MEM_WRITE(0xa400f0, &wiimote_ext_init, 1);
+	ops[1] = WIIMOTE_MEM_WRITE(0xa400fb, &wiimote_ext_noenc, 1);
+
+	return 2;
+}
+
+/* Same for MP, which stays at its own registers until it is mapped */
+static unsigned int wiimote_init_mp_ops(struct wiimote_mem_op *ops)
+{
+	ops[0] = WIIMOTE_MEM_WRITE(0xa600f0, &wiimote_ext_init, 1);
+	ops[1] = WIIMOTE_MEM_WRITE(0xa600fb, &wiimote_ext_noenc, 1);
+
+	return 2;
 }
 
 /* requires the cmd-mutex to be held */
@@ -506,16 +595,8 @@ static bool wiimote_cmd_map_mp(struct wiimote_data *wdata, __u8 exttype)
 	return wiimote_cmd_write(wdata, 0xa600fe, &wmem, sizeof(wmem));
 }
 
-/* requires the cmd-mutex to be held */
-static bool wiimote_cmd_read_mp(struct wiimote_data *wdata, __u8 *rmem)
+static bool wiimote_mp_present(struct wiimote_data *wdata, const __u8 *rmem)
 {
-	int ret;
-
-	/* read motion plus ID */
-	ret = wiimote_cmd_read(wdata, 0xa600fa, rmem, 6);
-	if (ret != 6)
-		return false;
-
 	hid_dbg(wdata->hdev, "motion plus ID: %6phC\n", rmem);
 
 	if (rmem[5] == 0x05)
@@ -863,6 +944,8 @@ static void wiimote_init_set_type(struct wiimote_data *wdata,
 static void wiimote_init_detect(struct wiimote_data *wdata)
 {
 	__u8 exttype = WIIMOTE_EXT_NONE, extdata[6];
+	struct wiimote_mem_op ops[3];
+	unsigned int n;
 	bool ext;
 	int ret;
 
@@ -885,8 +968,11 @@ static void wiimote_init_detect(struct wiimote_data *wdata)
 	if (!ext)
 		goto out_release;
 
-	wiimote_cmd_init_ext(wdata);
-	exttype = wiimote_cmd_read_ext(wdata, extdata);
+	n = wiimote_init_ext_ops(ops);
+	ops[n++] = WIIMOTE_MEM_READ(0xa400fa, extdata, sizeof(extdata));
+	wiimote_cmd_mem_seq(wdata, ops, n);
+	if (ops[n - 1].ret == sizeof(extdata))
+		exttype = wiimote_ext_type(wdata, extdata);
 
 out_release:
 	wiimote_cmd_release(wdata);
@@ -908,14 +994,20 @@ static void wiimote_init_detect(struct wiimote_data *wdata)
  */
 static void wiimote_init_poll_mp(struct wiimote_data *wdata)
 {
+	struct wiimote_mem_op ops[3];
+	unsigned int n;
 	bool mp;
 	__u8 mpdata[6];
 
+	n = wiimote_init_mp_ops(ops);
+	ops[n++] = WIIMOTE_MEM_READ(0xa600fa, mpdata, sizeof(mpdata));
+
 	wiimote_cmd_acquire_noint(wdata);
-	wiimote_cmd_init_mp(wdata);
-	mp = wiimote_cmd_read_mp(wdata, mpdata);
+	wiimote_cmd_mem_seq(wdata, ops, n);
 	wiimote_cmd_release(wdata);
 
+	mp = ops[n - 1].ret == sizeof(mpdata) && wiimote_mp_present(wdata, mpdata);
+
 	/* load/unload MP module if it changed */
 	if (mp) {
 		if (!wdata->state.mp) {
@@ -1094,9 +1186,11 @@ static const char *wiimote_exttype_names[WIIMOTE_EXT_NUM] = {
  */
 static void wiimote_init_hotplug(struct wiimote_data *wdata)
 {
-	__u8 exttype, extdata[6], mpdata[6];
+	__u8 exttype = WIIMOTE_EXT_NONE, extdata[6], mpdata[6];
+	struct wiimote_mem_op ops[6];
+	unsigned int n, mp_op = 0;
 	__u32 flags;
-	bool mp;
+	bool mp = false;
 
 	hid_dbg(wdata->hdev, "detect extensions..\n");
 
@@ -1113,15 +1207,23 @@ static void wiimote_init_hotplug(struct wiimote_data *wdata)
 
 	spin_unlock_irq(&wdata->state.lock);
 
-	/* init extension and MP (deactivates current extension or MP) */
-	wiimote_cmd_init_ext(wdata);
-	if (flags & WIIPROTO_FLAG_NO_MP) {
-		mp = false;
-	} else {
-		wiimote_cmd_init_mp(wdata);
-		mp = wiimote_cmd_read_mp(wdata, mpdata);
+	/*
+	 * init extension and MP (deactivates current extension or MP) and
+	 * read both IDs, all in one go
+	 */
+	n = wiimote_init_ext_ops(ops);
+	if (!(flags & WIIPROTO_FLAG_NO_MP)) {
+		n += wiimote_init_mp_ops(&ops[n]);
+		mp_op = n;
+		ops[n++] = WIIMOTE_MEM_READ(0xa600fa, mpdata, sizeof(mpdata));
 	}
-	exttype = wiimote_cmd_read_ext(wdata, extdata);
+	ops[n++] = WIIMOTE_MEM_READ(0xa400fa, extdata, sizeof(extdata));
+	wiimote_cmd_mem_seq(wdata, ops, n);
+
+	if (mp_op && ops[mp_op].ret == sizeof(mpdata))
+		mp = wiimote_mp_present(wdata, mpdata);
+	if (ops[n - 1].ret == sizeof(extdata))
+		exttype = wiimote_ext_type(wdata, extdata);
 
 	wiimote_cmd_release(wdata);
 
@@ -1467,7 +1569,7 @@ static void handler_data(struct wiimote_data *wdata, const __u8 *payload)
 		wdata->state.cmd_read_size = size;
 		if (wdata->state.cmd_read_buf)
 			memcpy(wdata->state.cmd_read_buf, &payload[5], size);
-		wiimote_cmd_complete(wdata);
+		wiimote_cmd_done(wdata);
 	}
 }
 
@@ -1480,7 +1582,7 @@ static void handler_return(struct wiimote_data *wdata, const __u8 *payload)
 
 	if (wiimote_cmd_pending(wdata, cmd, 0)) {
 		wdata->state.cmd_err = err;
-		wiimote_cmd_complete(wdata);
+		wiimote_cmd_done(wdata);
 	} else if (err) {
 		hid_warn(wdata->hdev, "Remote error %u on req %u\n", err,
 									cmd);
@@ -1738,7 +1840,7 @@ static struct wiimote_data *wiimote_create(struct hid_device *hdev)
 	hid_set_drvdata(hdev, wdata);
 
 	spin_lock_init(&wdata->queue.lock);
-	INIT_WORK(&wdata->queue.worker, wiimote_queue_worker);
+	hid_init_output_work(&wdata->queue.worker, wiimote_queue_worker);
 
 	spin_lock_init(&wdata->state.lock);
 	init_completion(&wdata->state.ready);
@@ -1772,7 +1874,7 @@ static void wiimote_destroy(struct wiimote_data *wdata)
 	wiimote_mp_unload(wdata);
 	wiimote_ext_unload(wdata);
 	wiimote_modules_unload(wdata);
-	cancel_work_sync(&wdata->queue.worker);
+	cancel_work_sync(&wdata->queue.worker.work);
 	hid_hw_close(wdata->hdev);
 	hid_hw_stop(wdata->hdev);
 
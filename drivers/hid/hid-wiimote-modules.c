@@ -120,7 +120,7 @@ static const struct wiimod_ops wiimod_keys = {
 static void wiimod_rumble_worker(struct work_struct *work)
 {
 	struct wiimote_data *wdata = container_of(work, struct wiimote_data,
-						  rumble_worker);
+						  rumble_worker.work);
 
 	spin_lock_irq(&wdata->state.lock);
 	wiiproto_req_rumble(wdata, wdata->state.cache_rumble);
@@ -147,7 +147,7 @@ static int wiimod_rumble_play(struct input_dev *dev, void *data,
 	/* Locking state.lock here might deadlock with input_event() calls.
 	 * schedule_work acts as barrier. Merging multiple changes is fine. */
 	wdata->state.cache_rumble = value;
-	schedule_work(&wdata->rumble_worker);
+	hid_queue_output_work(&wdata->rumble_worker);
 
 	return 0;
 }
@@ -155,7 +155,7 @@ static int wiimod_rumble_play(struct input_dev *dev, void *data,
 static int wiimod_rumble_probe(const struct wiimod_ops *ops,
 			       struct wiimote_data *wdata)
 {
-	INIT_WORK(&wdata->rumble_worker, wiimod_rumble_worker);
+	hid_init_output_work(&wdata->rumble_worker, wiimod_rumble_worker);
 
 	set_bit(FF_RUMBLE, wdata->input->ffbit);
 	if (input_ff_create_memless(wdata->input, NULL, wiimod_rumble_play))
@@ -169,7 +169,7 @@ static void wiimod_rumble_remove(const struct wiimod_ops *ops,
 {
 	unsigned long flags;
 
-	cancel_work_sync(&wdata->rumble_worker);
+	cancel_work_sync(&wdata->rumble_worker.work);
 
 	spin_lock_irqsave(&wdata->state.lock, flags);
 	wiiproto_req_rumble(wdata, 0);
@@ -478,6 +478,25 @@ static void wiimod_accel_close(struct input_dev *dev)
 	spin_unlock_irqrestore(&wdata->state.lock, flags);
 }
 
+/*
+ * Readers may mask the accelerometer axes; drop to a smaller DRM without
+ * accelerometer data if none of them reads any axis.
+ */
+static void wiimod_accel_interest(struct input_dev *dev)
+{
+	struct wiimote_data *wdata = input_get_drvdata(dev);
+	unsigned long flags;
+	bool wanted;
+
+	wanted = input_event_wanted(dev, EV_ABS, ABS_RX) ||
+		 input_event_wanted(dev, EV_ABS, ABS_RY) ||
+		 input_event_wanted(dev, EV_ABS, ABS_RZ);
+
+	spin_lock_irqsave(&wdata->state.lock, flags);
+	wiiproto_req_accel(wdata, wanted);
+	spin_unlock_irqrestore(&wdata->state.lock, flags);
+}
+
 static int wiimod_accel_probe(const struct wiimod_ops *ops,
 			      struct wiimote_data *wdata)
 {
@@ -490,6 +509,7 @@ static int wiimod_accel_probe(const struct wiimod_ops *ops,
 	input_set_drvdata(wdata->accel, wdata);
 	wdata->accel->open = wiimod_accel_open;
 	wdata->accel->close = wiimod_accel_close;
+	wdata->accel->interest = wiimod_accel_interest;
 	wdata->accel->dev.parent = &wdata->hdev->dev;
 	wdata->accel->id.bustype = wdata->hdev->bus;
 	wdata->accel->id.vendor = wdata->hdev->vendor;
@@ -730,6 +750,19 @@ static void wiimod_ir_close(struct input_dev *dev)
 	wiimod_ir_change(wdata, 0);
 }
 
+/* Same as the accelerometer, IR is only enabled while a slot is read. */
+static void wiimod_ir_interest(struct input_dev *dev)
+{
+	struct wiimote_data *wdata = input_get_drvdata(dev);
+	unsigned int code;
+	bool wanted = false;
+
+	for (code = ABS_HAT0X; code <= ABS_HAT3Y && !wanted; ++code)
+		wanted = input_event_wanted(dev, EV_ABS, code);
+
+	wiimod_ir_change(wdata, wanted ? WIIPROTO_FLAG_IR_BASIC : 0);
+}
+
 static int wiimod_ir_probe(const struct wiimod_ops *ops,
 			   struct wiimote_data *wdata)
 {
@@ -742,6 +775,7 @@ static int wiimod_ir_probe(const struct wiimod_ops *ops,
 	input_set_drvdata(wdata->ir, wdata);
 	wdata->ir->open = wiimod_ir_open;
 	wdata->ir->close = wiimod_ir_close;
+	wdata->ir->interest = wiimod_ir_interest;
 	wdata->ir->dev.parent = &wdata->hdev->dev;
 	wdata->ir->id.bustype = wdata->hdev->bus;
 	wdata->ir->id.vendor = wdata->hdev->vendor;
@@ -1410,31 +1444,21 @@ static void wiimod_bboard_close(struct input_dev *dev)
 	spin_unlock_irqrestore(&wdata->state.lock, flags);
 }
 
-static ssize_t wiimod_bboard_calib_show(struct device *dev,
-					struct device_attribute *attr,
-					char *out)
+/* requires the cmd-mutex to be held */
+static int wiimod_bboard_read_calib(struct wiimote_data *wdata)
 {
-	struct wiimote_data *wdata = dev_to_wii(dev);
-	int i, j, ret;
-	__u16 val;
+	struct wiimote_mem_op ops[2];
 	__u8 buf[24], offs;
+	int ret, i, j;
 
-	ret = wiimote_cmd_acquire(wdata);
+	/* both halves are requested at once */
+	ops[0] = WIIMOTE_MEM_READ(0xa40024, buf, 12);
+	ops[1] = WIIMOTE_MEM_READ(0xa40024 + 12, buf + 12, 12);
+	ret = wiimote_cmd_mem_seq(wdata, ops, ARRAY_SIZE(ops));
 	if (ret)
 		return ret;
-
-	ret = wiimote_cmd_read(wdata, 0xa40024, buf, 12);
-	if (ret != 12) {
-		wiimote_cmd_release(wdata);
-		return ret < 0 ? ret : -EIO;
-	}
-	ret = wiimote_cmd_read(wdata, 0xa40024 + 12, buf + 12, 12);
-	if (ret != 12) {
-		wiimote_cmd_release(wdata);
-		return ret < 0 ? ret : -EIO;
-	}
-
-	wiimote_cmd_release(wdata);
+	if (ops[0].ret != 12 || ops[1].ret != 12)
+		return -EIO;
 
 	spin_lock_irq(&wdata->state.lock);
 	offs = 0;
@@ -1446,8 +1470,29 @@ static ssize_t wiimod_bboard_calib_show(struct device *dev,
 			offs += 2;
 		}
 	}
+	wdata->state.ext_calib_valid = true;
 	spin_unlock_irq(&wdata->state.lock);
 
+	return 0;
+}
+
+static ssize_t wiimod_bboard_calib_show(struct device *dev,
+					struct device_attribute *attr,
+					char *out)
+{
+	struct wiimote_data *wdata = dev_to_wii(dev);
+	int i, j, ret;
+	__u16 val;
+
+	ret = wiimote_cmd_acquire(wdata);
+	if (ret)
+		return ret;
+
+	ret = wiimod_bboard_read_calib(wdata);
+	wiimote_cmd_release(wdata);
+	if (ret)
+		return ret;
+
 	ret = 0;
 	for (i = 0; i < 3; ++i) {
 		for (j = 0; j < 4; ++j) {
@@ -1467,33 +1512,14 @@ static DEVICE_ATTR(bboard_calib, S_IRUGO, wiimod_bboard_calib_show, NULL);
 static int wiimod_bboard_probe(const struct wiimod_ops *ops,
 			       struct wiimote_data *wdata)
 {
-	int ret, i, j;
-	__u8 buf[24], offs;
+	int ret;
 
+	/* a re-plugged board keeps the calibration read the last time */
 	wiimote_cmd_acquire_noint(wdata);
-
-	ret = wiimote_cmd_read(wdata, 0xa40024, buf, 12);
-	if (ret != 12) {
-		wiimote_cmd_release(wdata);
-		return ret < 0 ? ret : -EIO;
-	}
-	ret = wiimote_cmd_read(wdata, 0xa40024 + 12, buf + 12, 12);
-	if (ret != 12) {
-		wiimote_cmd_release(wdata);
-		return ret < 0 ? ret : -EIO;
-	}
-
+	ret = wdata->state.ext_calib_valid ? 0 : wiimod_bboard_read_calib(wdata);
 	wiimote_cmd_release(wdata);
-
-	offs = 0;
-	for (i = 0; i < 3; ++i) {
-		for (j = 0; j < 4; ++j) {
-			wdata->state.calib_bboard[j][i] = buf[offs];
-			wdata->state.calib_bboard[j][i] <<= 8;
-			wdata->state.calib_bboard[j][i] |= buf[offs + 1];
-			offs += 2;
-		}
-	}
+	if (ret)
+		return ret;
 
 	wdata->extension.input = input_allocate_device();
 	if (!wdata->extension.input)
@@ -1805,7 +1831,7 @@ static int wiimod_pro_play(struct input_dev *dev, void *data,
 	/* Locking state.lock here might deadlock with input_event() calls.
 	 * schedule_work acts as barrier. Merging multiple changes is fine. */
 	wdata->state.cache_rumble = value;
-	schedule_work(&wdata->rumble_worker);
+	hid_queue_output_work(&wdata->rumble_worker);
 
 	return 0;
 }
@@ -1865,7 +1891,7 @@ static int wiimod_pro_probe(const struct wiimod_ops *ops,
 	int ret, i;
 	unsigned long flags;
 
-	INIT_WORK(&wdata->rumble_worker, wiimod_rumble_worker);
+	hid_init_output_work(&wdata->rumble_worker, wiimod_rumble_worker);
 	wdata->state.calib_pro_sticks[0] = 0;
 	wdata->state.calib_pro_sticks[1] = 0;
 	wdata->state.calib_pro_sticks[2] = 0;
@@ -1948,7 +1974,7 @@ static void wiimod_pro_remove(const struct wiimod_ops *ops,
 
 	input_unregister_device(wdata->extension.input);
 	wdata->extension.input = NULL;
-	cancel_work_sync(&wdata->rumble_worker);
+	cancel_work_sync(&wdata->rumble_worker.work);
 	device_remove_file(&wdata->hdev->dev,
 			   &dev_attr_pro_calib);
 
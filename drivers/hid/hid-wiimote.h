@@ -99,6 +99,22 @@ enum wiimote_mptype {
 	WIIMOTE_MP_PASSTHROUGH_CLASSIC,
 };
 
+/* one memory access of a sequence sent by wiimote_cmd_mem_seq() */
+struct wiimote_mem_op {
+	__u32 offset;
+	const __u8 *wmem;	/* bytes to write, or NULL to read into rmem */
+	__u8 *rmem;
+	__u8 size;
+	ssize_t ret;		/* bytes read, 0 once written, or -EIO */
+};
+
+#define WIIMOTE_MEM_WRITE(_offset, _buf, _size) \
+	((struct wiimote_mem_op){ .offset = (_offset), .wmem = (_buf), \
+				  .size = (_size) })
+#define WIIMOTE_MEM_READ(_offset, _buf, _size) \
+	((struct wiimote_mem_op){ .offset = (_offset), .rmem = (_buf), \
+				  .size = (_size) })
+
 struct wiimote_buf {
 	__u8 data[HID_MAX_BUFFER_SIZE];
 	size_t size;
@@ -106,7 +122,7 @@ struct wiimote_buf {
 
 struct wiimote_queue {
 	spinlock_t lock;
-	struct work_struct worker;
+	struct hid_output_work worker;
 	__u8 head;
 	__u8 tail;
 	struct wiimote_buf outq[WIIMOTE_BUFSIZE];
@@ -133,6 +149,15 @@ struct wiimote_state {
 	__u8 *cmd_read_buf;
 	__u8 cmd_read_size;
 
+	/* pipelined memory accesses, the first one is the pending cmd */
+	struct wiimote_mem_op *cmd_ops;
+	unsigned int cmd_ops_left;
+
+	/* last extension ID read; the extension calibration below is valid
+	 * for it while ext_calib_valid is set */
+	__u8 ext_id[6];
+	bool ext_calib_valid;
+
 	/* calibration/cache data */
 	__u16 calib_bboard[4][3];
 	__s16 calib_pro_sticks[4];
@@ -143,7 +168,7 @@ struct wiimote_state {
 struct wiimote_data {
 	struct hid_device *hdev;
 	struct input_dev *input;
-	struct work_struct rumble_worker;
+	struct hid_output_work rumble_worker;
 	struct led_classdev *leds[4];
 	struct input_dev *accel;
 	struct input_dev *ir;
@@ -273,6 +298,8 @@ extern int wiimote_cmd_write(struct wiimote_data *wdata, __u32 offset,
 						const __u8 *wmem, __u8 size);
 extern ssize_t wiimote_cmd_read(struct wiimote_data *wdata, __u32 offset,
 							__u8 *rmem, __u8 size);
+extern int wiimote_cmd_mem_seq(struct wiimote_data *wdata,
+			       struct wiimote_mem_op *ops, unsigned int num);
 
 #define wiiproto_req_rreg(wdata, os, sz) \
 				wiiproto_req_rmem((wdata), false, (os), (sz))
@@ -13,6 +13,7 @@
 
 #define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
 
+#include <linux/file.h>
 #include <linux/fs.h>
 #include <linux/module.h>
 #include <linux/errno.h>
@@ -27,6 +28,12 @@
 #include <linux/mutex.h>
 #include <linux/sched/signal.h>
 #include <linux/string.h>
+#include <linux/uio.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/mempool.h>
+#include <linux/mm.h>
+#include <linux/vmalloc.h>
 
 #include <linux/hidraw.h>
 
@@ -35,14 +42,111 @@ static struct cdev hidraw_cdev;
 static struct class *hidraw_class;
 static struct hidraw *hidraw_table[HIDRAW_MAX_DEVICES];
 static DEFINE_MUTEX(minors_lock);
+static LIST_HEAD(hidraw_sinks);		/* protected by minors_lock */
 
-static ssize_t hidraw_read(struct file *file, char __user *buffer, size_t count, loff_t *ppos)
+/*
+ * Nearly all input reports fit in a full speed USB interrupt packet.
+ * Copies of those come from their own cache, with a reserve so that
+ * readers don't miss reports when memory is tight; larger ones are
+ * plain kmalloc()s.
+ */
+#define HIDRAW_REPORT_SMALL	64
+#define HIDRAW_REPORT_RESERVE	64
+
+static struct kmem_cache *hidraw_report_cache;
+static mempool_t *hidraw_report_pool;
+
+static u8 *hidraw_report_dup(const u8 *data, int len)
+{
+	u8 *value;
+
+	if (len > HIDRAW_REPORT_SMALL)
+		return kmemdup(data, len, GFP_ATOMIC);
+
+	value = mempool_alloc(hidraw_report_pool, GFP_ATOMIC);
+	if (value)
+		memcpy(value, data, len);
+	return value;
+}
+
+static void hidraw_report_free(struct hidraw_report *report)
+{
+	if (!report->value)
+		return;
+
+	if (report->len > HIDRAW_REPORT_SMALL)
+		kfree(report->value);
+	else
+		mempool_free(report->value, hidraw_report_pool);
+	report->value = NULL;
+}
+
+/*
+ * Copy as many queued reports as fit in the user buffer, each after a
+ * struct hidraw_event_header. Called with read_mutex held.
+ */
+static ssize_t hidraw_read_batch(struct hidraw_list *list, struct iov_iter *to)
+{
+	struct hidraw_event_header hdr = { };
+	struct hidraw_report *report;
+	size_t count = iov_iter_count(to);
+	size_t copied = 0, len;
+
+	while (list->tail != list->head) {
+		report = &list->buffer[list->tail];
+		len = sizeof(hdr) + ALIGN(report->len, 8);
+		if (copied + len > count)
+			break;
+
+		if (report->value) {
+			hdr.timestamp = report->time;
+			hdr.len = report->len;
+			if (copy_to_iter(&hdr, sizeof(hdr), to) != sizeof(hdr) ||
+			    copy_to_iter(report->value, report->len, to) !=
+					report->len ||
+			    iov_iter_zero(len - sizeof(hdr) - report->len, to) !=
+					len - sizeof(hdr) - report->len)
+				return -EFAULT;
+			copied += len;
+		}
+
+		hidraw_report_free(report);
+		list->tail = (list->tail + 1) & (list->buffer_size - 1);
+	}
+
+	/* the buffer cannot hold the first report */
+	if (!copied && list->tail != list->head)
+		return -EINVAL;
+
+	return copied;
+}
+
+/*
+ * With O_NONBLOCK or IOCB_NOWAIT the read neither sleeps for reports nor
+ * on read_mutex, so io_uring can issue it inline and retry from poll.
+ */
+static ssize_t hidraw_read_iter(struct kiocb *iocb, struct iov_iter *to)
 {
+	struct file *file = iocb->ki_filp;
 	struct hidraw_list *list = file->private_data;
+	size_t count = iov_iter_count(to);
+	bool nonblock = (file->f_flags & O_NONBLOCK) ||
+			(iocb->ki_flags & IOCB_NOWAIT);
 	int ret = 0, len;
 	DECLARE_WAITQUEUE(wait, current);
 
-	mutex_lock(&list->read_mutex);
+	/* reports go to the ring instead */
+	if (list->ring)
+		return -EINVAL;
+
+	WRITE_ONCE(list->hidraw->reader_cpu, raw_smp_processor_id());
+
+	if (iocb->ki_flags & IOCB_NOWAIT) {
+		if (!mutex_trylock(&list->read_mutex))
+			return -EAGAIN;
+	} else {
+		mutex_lock(&list->read_mutex);
+	}
 
 	while (ret == 0) {
 		if (list->head == list->tail) {
@@ -58,7 +162,7 @@ static ssize_t hidraw_read(struct file *file, char __user *buffer, size_t count,
 					ret = -EIO;
 					break;
 				}
-				if (file->f_flags & O_NONBLOCK) {
+				if (nonblock) {
 					ret = -EAGAIN;
 					break;
 				}
@@ -77,20 +181,25 @@ static ssize_t hidraw_read(struct file *file, char __user *buffer, size_t count,
 		if (ret)
 			goto out;
 
+		if (list->batch) {
+			ret = hidraw_read_batch(list, to);
+			continue;
+		}
+
 		len = list->buffer[list->tail].len > count ?
 			count : list->buffer[list->tail].len;
 
 		if (list->buffer[list->tail].value) {
-			if (copy_to_user(buffer, list->buffer[list->tail].value, len)) {
+			if (copy_to_iter(list->buffer[list->tail].value, len,
+					 to) != len) {
 				ret = -EFAULT;
 				goto out;
 			}
 			ret = len;
 		}
 
-		kfree(list->buffer[list->tail].value);
-		list->buffer[list->tail].value = NULL;
-		list->tail = (list->tail + 1) & (HIDRAW_BUFFER_SIZE - 1);
+		hidraw_report_free(&list->buffer[list->tail]);
+		list->tail = (list->tail + 1) & (list->buffer_size - 1);
 	}
 out:
 	mutex_unlock(&list->read_mutex);
@@ -251,9 +360,14 @@ static __poll_t hidraw_poll(struct file *file, poll_table *wait)
 	struct hidraw_list *list = file->private_data;
 	__poll_t mask = EPOLLOUT | EPOLLWRNORM; /* hidraw is always writable */
 
+	WRITE_ONCE(list->hidraw->reader_cpu, raw_smp_processor_id());
 	poll_wait(file, &list->hidraw->wait, wait);
-	if (list->head != list->tail)
+	if (list->ring) {
+		if (list->ring_head != READ_ONCE(list->ring->tail))
+			mask |= EPOLLIN | EPOLLRDNORM;
+	} else if (list->head != list->tail) {
 		mask |= EPOLLIN | EPOLLRDNORM;
+	}
 	if (!list->hidraw->exist)
 		mask |= EPOLLERR | EPOLLHUP;
 	return mask;
@@ -272,6 +386,14 @@ static int hidraw_open(struct inode *inode, struct file *file)
 		goto out;
 	}
 
+	list->buffer_size = HIDRAW_BUFFER_SIZE;
+	list->buffer = kcalloc(list->buffer_size, sizeof(*list->buffer),
+			       GFP_KERNEL);
+	if (!list->buffer) {
+		err = -ENOMEM;
+		goto out;
+	}
+
 	mutex_lock(&minors_lock);
 	if (!hidraw_table[minor] || !hidraw_table[minor]->exist) {
 		err = -ENODEV;
@@ -300,11 +422,15 @@ static int hidraw_open(struct inode *inode, struct file *file)
 	list_add_tail(&list->node, &hidraw_table[minor]->list);
 	spin_unlock_irqrestore(&hidraw_table[minor]->list_lock, flags);
 	file->private_data = list;
+	file->f_mode |= FMODE_NOWAIT;
 out_unlock:
 	mutex_unlock(&minors_lock);
 out:
-	if (err < 0)
+	if (err < 0) {
+		if (list)
+			kfree(list->buffer);
 		kfree(list);
+	}
 	return err;
 
 }
@@ -346,12 +472,19 @@ static int hidraw_release(struct inode * inode, struct file * file)
 	unsigned int minor = iminor(inode);
 	struct hidraw_list *list = file->private_data;
 	unsigned long flags;
+	unsigned int i;
 
 	mutex_lock(&minors_lock);
 
 	spin_lock_irqsave(&hidraw_table[minor]->list_lock, flags);
 	list_del(&list->node);
 	spin_unlock_irqrestore(&hidraw_table[minor]->list_lock, flags);
+	if (list->forward)
+		fput(list->forward);
+	for (i = 0; i < list->buffer_size; i++)
+		hidraw_report_free(&list->buffer[i]);
+	kfree(list->buffer);
+	vfree(list->ring);
 	kfree(list);
 
 	drop_ref(hidraw_table[minor], 0);
@@ -360,6 +493,197 @@ static int hidraw_release(struct inode * inode, struct file * file)
 	return 0;
 }
 
+/*
+ * Switch the reader to the mmap'able ring. Called with minors_lock held,
+ * and only once per open file.
+ */
+static int hidraw_setup_ring(struct hidraw_list *list,
+			     struct hidraw_ring_setup __user *arg)
+{
+	struct hidraw_ring_setup setup;
+	struct hidraw_ring *ring;
+	unsigned long flags;
+	size_t size;
+
+	if (copy_from_user(&setup, arg, sizeof(setup)))
+		return -EFAULT;
+
+	if (!is_power_of_2(setup.slots) ||
+	    setup.slots > HIDRAW_RING_MAX_SLOTS ||
+	    setup.slot_size <= sizeof(struct hidraw_ring_slot) ||
+	    setup.slot_size % 8 ||
+	    setup.slot_size > HID_MAX_BUFFER_SIZE + sizeof(struct hidraw_ring_slot))
+		return -EINVAL;
+
+	size = PAGE_SIZE + (size_t)setup.slots * setup.slot_size;
+	if (size > HIDRAW_RING_MAX_SIZE)
+		return -EINVAL;
+
+	if (list->ring)
+		return -EBUSY;
+
+	ring = vmalloc_user(size);
+	if (!ring)
+		return -ENOMEM;
+
+	ring->slots = setup.slots;
+	ring->slot_size = setup.slot_size;
+	ring->data_offset = PAGE_SIZE;
+
+	spin_lock_irqsave(&list->hidraw->list_lock, flags);
+	list->ring_head = 0;
+	list->ring_slots = setup.slots;
+	list->ring_slot_size = setup.slot_size;
+	/* pairs with hidraw_mmap(), which does not take any lock */
+	smp_store_release(&list->ring, ring);
+	spin_unlock_irqrestore(&list->hidraw->list_lock, flags);
+
+	return 0;
+}
+
+/*
+ * Resize the buffer of reports queued for read(), keeping the pending
+ * ones. Called with minors_lock held.
+ */
+static int hidraw_set_buffer_size(struct hidraw_list *list, int __user *arg)
+{
+	struct hidraw_report *buffer;
+	unsigned int size, pending, i;
+	unsigned long flags;
+	int ret = 0;
+
+	if (get_user(size, arg))
+		return -EFAULT;
+
+	if (size < 2 || size > HIDRAW_MAX_BUFFER_SIZE || !is_power_of_2(size))
+		return -EINVAL;
+
+	buffer = kcalloc(size, sizeof(*buffer), GFP_KERNEL);
+	if (!buffer)
+		return -ENOMEM;
+
+	mutex_lock(&list->read_mutex);
+	spin_lock_irqsave(&list->hidraw->list_lock, flags);
+
+	pending = (list->head - list->tail) & (list->buffer_size - 1);
+	if (pending >= size) {
+		ret = -EBUSY;
+	} else {
+		for (i = 0; i < pending; i++)
+			buffer[i] = list->buffer[(list->tail + i) &
+						 (list->buffer_size - 1)];
+		swap(list->buffer, buffer);
+		list->buffer_size = size;
+		list->tail = 0;
+		list->head = pending;
+	}
+
+	spin_unlock_irqrestore(&list->hidraw->list_lock, flags);
+	mutex_unlock(&list->read_mutex);
+
+	/* on success, this is the old array, its reports were moved */
+	kfree(buffer);
+	return ret;
+}
+
+/* Called with minors_lock held. */
+static int hidraw_set_filter(struct hidraw_list *list,
+			     struct hidraw_report_filter __user *arg)
+{
+	struct hidraw_report_filter filter;
+	DECLARE_BITMAP(ids, 256);
+	unsigned long flags;
+	unsigned int i;
+
+	if (copy_from_user(&filter, arg, sizeof(filter)))
+		return -EFAULT;
+
+	bitmap_zero(ids, 256);
+	for (i = 0; i < 256; i++)
+		if (filter.ids[i / 8] & BIT(i % 8))
+			__set_bit(i, ids);
+
+	spin_lock_irqsave(&list->hidraw->list_lock, flags);
+	bitmap_copy(list->filter, ids, 256);
+	list->filtered = !bitmap_empty(ids, 256);
+	spin_unlock_irqrestore(&list->hidraw->list_lock, flags);
+
+	return 0;
+}
+
+/*
+ * Register a kind of file that readers can forward their reports to
+ * with HIDIOCSFORWARD. Files being forwarded to keep the module
+ * providing @sink loaded.
+ */
+void hidraw_register_sink(struct hidraw_sink *sink)
+{
+	mutex_lock(&minors_lock);
+	list_add_tail(&sink->list, &hidraw_sinks);
+	mutex_unlock(&minors_lock);
+}
+EXPORT_SYMBOL_GPL(hidraw_register_sink);
+
+void hidraw_unregister_sink(struct hidraw_sink *sink)
+{
+	mutex_lock(&minors_lock);
+	list_del(&sink->list);
+	mutex_unlock(&minors_lock);
+}
+EXPORT_SYMBOL_GPL(hidraw_unregister_sink);
+
+/* Called with minors_lock held. */
+static int hidraw_set_forward(struct hidraw_list *list, int __user *arg)
+{
+	const struct hidraw_sink *sink = NULL, *tmp;
+	struct file *target = NULL, *old;
+	unsigned long flags;
+	int fd;
+
+	if (get_user(fd, arg))
+		return -EFAULT;
+
+	if (fd >= 0) {
+		target = fget(fd);
+		if (!target)
+			return -EBADF;
+
+		list_for_each_entry(tmp, &hidraw_sinks, list) {
+			if (target->f_op == tmp->fops) {
+				sink = tmp;
+				break;
+			}
+		}
+
+		if (!sink) {
+			fput(target);
+			return -EINVAL;
+		}
+	}
+
+	spin_lock_irqsave(&list->hidraw->list_lock, flags);
+	old = list->forward;
+	list->forward = target;
+	list->sink = sink;
+	spin_unlock_irqrestore(&list->hidraw->list_lock, flags);
+
+	if (old)
+		fput(old);
+
+	return 0;
+}
+
+static int hidraw_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct hidraw_list *list = file->private_data;
+	struct hidraw_ring *ring = smp_load_acquire(&list->ring);
+
+	if (!ring)
+		return -EINVAL;
+
+	return remap_vmalloc_range(vma, ring, vma->vm_pgoff);
+}
+
 static long hidraw_ioctl(struct file *file, unsigned int cmd,
 							unsigned long arg)
 {
@@ -409,6 +733,45 @@ static long hidraw_ioctl(struct file *file, unsigned int cmd,
 					ret = -EFAULT;
 				break;
 			}
+		case HIDIOCSRING:
+			ret = hidraw_setup_ring(file->private_data, user_arg);
+			break;
+
+		case HIDIOCSFILTER:
+			ret = hidraw_set_filter(file->private_data, user_arg);
+			break;
+
+		case HIDIOCSFORWARD:
+			ret = hidraw_set_forward(file->private_data, user_arg);
+			break;
+
+		case HIDIOCSBUFSIZE:
+			ret = hidraw_set_buffer_size(file->private_data, user_arg);
+			break;
+
+		case HIDIOCGDROPPED:
+			{
+				struct hidraw_list *list = file->private_data;
+
+				if (put_user(READ_ONCE(list->dropped), (__u32 __user *)arg))
+					ret = -EFAULT;
+				break;
+			}
+
+		case HIDIOCSREADMODE:
+			{
+				struct hidraw_list *list = file->private_data;
+				int mode;
+
+				if (get_user(mode, (int __user *)arg))
+					ret = -EFAULT;
+				else if (mode != HIDRAW_READ_SINGLE &&
+					 mode != HIDRAW_READ_BATCH)
+					ret = -EINVAL;
+				else
+					WRITE_ONCE(list->batch, mode == HIDRAW_READ_BATCH);
+				break;
+			}
 		default:
 			{
 				struct hid_device *hid = dev->hid;
@@ -493,42 +856,158 @@ static long hidraw_ioctl(struct file *file, unsigned int cmd,
 
 static const struct file_operations hidraw_ops = {
 	.owner =        THIS_MODULE,
-	.read =         hidraw_read,
+	.read_iter =    hidraw_read_iter,
 	.write =        hidraw_write,
 	.poll =         hidraw_poll,
 	.open =         hidraw_open,
 	.release =      hidraw_release,
 	.unlocked_ioctl = hidraw_ioctl,
+	.mmap =		hidraw_mmap,
 	.fasync =	hidraw_fasync,
 	.compat_ioctl   = compat_ptr_ioctl,
 	.llseek =	noop_llseek,
 };
 
+#ifdef CONFIG_HID_BPF
+/*
+ * Returns the HID device behind the hidraw file @fd with a reference
+ * held, for attaching BPF programs to it. As the programs may rewrite
+ * the reports, the file must be open for writing.
+ */
+struct hid_device *hidraw_get_hid_from_fd(int fd)
+{
+	struct fd f = fdget(fd);
+	struct hid_device *hid;
+	struct hidraw *dev;
+
+	if (!f.file)
+		return ERR_PTR(-EBADF);
+
+	if (f.file->f_op != &hidraw_ops) {
+		hid = ERR_PTR(-EINVAL);
+		goto out;
+	}
+	if (!(f.file->f_mode & FMODE_WRITE)) {
+		hid = ERR_PTR(-EPERM);
+		goto out;
+	}
+
+	mutex_lock(&minors_lock);
+	dev = ((struct hidraw_list *)f.file->private_data)->hidraw;
+	if (dev->exist) {
+		hid = dev->hid;
+		get_device(&hid->dev);
+	} else {
+		hid = ERR_PTR(-ENODEV);
+	}
+	mutex_unlock(&minors_lock);
+out:
+	fdput(f);
+	return hid;
+}
+#endif
+
+/*
+ * Store a report in the mmap'able ring of a reader. The page is written by
+ * userspace, so the geometry comes from the private copy in @list and the
+ * tail is only used to tell whether the ring is full. Returns true if the
+ * ring was empty, as the reader may then be waiting.
+ */
+static bool hidraw_ring_event(struct hidraw_list *list, u8 *data, int len)
+{
+	struct hidraw_ring *ring = list->ring;
+	struct hidraw_ring_slot *slot;
+	u32 head = list->ring_head;
+	u32 tail = smp_load_acquire(&ring->tail);
+	u32 slots = list->ring_slots;
+	u32 size = list->ring_slot_size - sizeof(*slot);
+
+	if (head - tail >= slots) {
+		ring->dropped++;
+		list->dropped++;
+		return false;
+	}
+
+	slot = (void *)ring + PAGE_SIZE +
+	       (size_t)(head & (slots - 1)) * list->ring_slot_size;
+	memcpy(slot->data, data, min_t(u32, len, size));
+	slot->len = len;
+
+	list->ring_head = head + 1;
+	smp_store_release(&ring->head, head + 1);
+
+	return head == tail;
+}
+
+/*
+ * The CPU the last reader of @hid read or polled on, for HID_STEER_READER.
+ * Called from the hid_input_report() context, like hidraw_report_event().
+ */
+int hidraw_reader_cpu(struct hid_device *hid)
+{
+	struct hidraw *dev = hid->hidraw;
+
+	if (!(hid->claimed & HID_CLAIMED_HIDRAW) || !dev)
+		return -1;
+
+	return READ_ONCE(dev->reader_cpu);
+}
+
 int hidraw_report_event(struct hid_device *hid, u8 *data, int len)
 {
 	struct hidraw *dev = hid->hidraw;
 	struct hidraw_list *list;
+	u64 time = hid->input_time ? ktime_to_ns(hid->input_time) :
+				     ktime_get_ns();
+	unsigned int id = 0;
+	bool wake = false;
 	int ret = 0;
 	unsigned long flags;
 
+	if (len && hid->report_enum[HID_INPUT_REPORT].numbered)
+		id = data[0];
+
 	spin_lock_irqsave(&dev->list_lock, flags);
 	list_for_each_entry(list, &dev->list, node) {
-		int new_head = (list->head + 1) & (HIDRAW_BUFFER_SIZE - 1);
+		int new_head = (list->head + 1) & (list->buffer_size - 1);
+
+		if (list->filtered && !test_bit(id, list->filter))
+			continue;
+
+		if (list->forward) {
+			if (list->sink->forward(list->forward, data, len))
+				list->dropped++;
+			continue;
+		}
+
+		if (list->ring) {
+			if (hidraw_ring_event(list, data, len)) {
+				kill_fasync(&list->fasync, SIGIO, POLL_IN);
+				wake = true;
+			}
+			continue;
+		}
 
-		if (new_head == list->tail)
+		if (new_head == list->tail) {
+			list->dropped++;
 			continue;
+		}
 
-		if (!(list->buffer[list->head].value = kmemdup(data, len, GFP_ATOMIC))) {
+		if (!(list->buffer[list->head].value = hidraw_report_dup(data, len))) {
+			list->dropped++;
 			ret = -ENOMEM;
 			break;
 		}
 		list->buffer[list->head].len = len;
+		list->buffer[list->head].time = time;
 		list->head = new_head;
 		kill_fasync(&list->fasync, SIGIO, POLL_IN);
+		wake = true;
 	}
 	spin_unlock_irqrestore(&dev->list_lock, flags);
 
-	wake_up_interruptible(&dev->wait);
+	if (wake)
+		wake_up_interruptible(&dev->wait);
 	return ret;
 }
 EXPORT_SYMBOL_GPL(hidraw_report_event);
@@ -579,6 +1058,7 @@ int hidraw_connect(struct hid_device *hid)
 
 	dev->hid = hid;
 	dev->minor = minor;
+	dev->reader_cpu = -1;
 
 	dev->exist = 1;
 	hid->hidraw = dev;
@@ -607,11 +1087,23 @@ int __init hidraw_init(void)
 	int result;
 	dev_t dev_id;
 
+	hidraw_report_cache = kmem_cache_create("hidraw_report",
+						HIDRAW_REPORT_SMALL, 0, 0, NULL);
+	if (!hidraw_report_cache)
+		return -ENOMEM;
+
+	hidraw_report_pool = mempool_create_slab_pool(HIDRAW_REPORT_RESERVE,
+						      hidraw_report_cache);
+	if (!hidraw_report_pool) {
+		result = -ENOMEM;
+		goto error_cache;
+	}
+
 	result = alloc_chrdev_region(&dev_id, HIDRAW_FIRST_MINOR,
 			HIDRAW_MAX_DEVICES, "hidraw");
 	if (result < 0) {
 		pr_warn("can't get major number\n");
-		goto out;
+		goto error_pool;
 	}
 
 	hidraw_major = MAJOR(dev_id);
@@ -635,6 +1127,10 @@ int __init hidraw_init(void)
 	class_destroy(hidraw_class);
 error_cdev:
 	unregister_chrdev_region(dev_id, HIDRAW_MAX_DEVICES);
+error_pool:
+	mempool_destroy(hidraw_report_pool);
+error_cache:
+	kmem_cache_destroy(hidraw_report_cache);
 	goto out;
 }
 
@@ -645,5 +1141,6 @@ void hidraw_exit(void)
 	cdev_del(&hidraw_cdev);
 	class_destroy(hidraw_class);
 	unregister_chrdev_region(dev_id, HIDRAW_MAX_DEVICES);
-
+	mempool_destroy(hidraw_report_pool);
+	kmem_cache_destroy(hidraw_report_cache);
 }
@@ -21,6 +21,7 @@
 #include <linux/module.h>
 #include <linux/i2c.h>
 #include <linux/interrupt.h>
+#include <linux/debugfs.h>
 #include <linux/input.h>
 #include <linux/irq.h>
 #include <linux/delay.h>
@@ -35,6 +36,10 @@
 #include <linux/kernel.h>
 #include <linux/hid.h>
 #include <linux/mutex.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/fast_clock.h>
+#include <uapi/linux/sched/types.h>
 
 #include "../hid-ids.h"
 #include "i2c-hid.h"
@@ -56,11 +61,20 @@
 #define I2C_HID_PWR_ON		0x00
 #define I2C_HID_PWR_SLEEP	0x01
 
+/* reports read per interrupt at most while the line stays asserted */
+#define I2C_HID_MAX_DRAIN	16
+/* read latency histogram buckets, powers of two in microseconds */
+#define I2C_HID_LAT_BUCKETS	12
+
 /* debug option */
 static bool debug;
 module_param(debug, bool, 0444);
 MODULE_PARM_DESC(debug, "print a lot of debug information");
 
+static unsigned int irq_priority;
+module_param(irq_priority, uint, 0644);
+MODULE_PARM_DESC(irq_priority, "SCHED_FIFO priority of the IRQ threads (1-99, 0 = default)");
+
 #define i2c_hid_dbg(ihid, fmt, arg...)					  \
 do {									  \
 	if (debug)							  \
@@ -153,9 +167,19 @@ struct i2c_hid {
 	wait_queue_head_t	wait;		/* For waiting the interrupt */
 
 	bool			irq_wake_enabled;
+	bool			irq_active_high; /* IRQ line level when asserted */
+	unsigned int		irq_prio;	/* irq_priority last applied */
 	struct mutex		reset_lock;
 
 	struct i2chid_ops	*ops;
+
+	/* input read statistics, updated by the IRQ thread only */
+	u64			irq_count;
+	u64			read_count;
+	u64			read_ns_total;
+	u64			read_ns_max;
+	unsigned int		drain_max;
+	u64			read_hist[I2C_HID_LAT_BUCKETS];
 };
 
 static const struct i2c_hid_quirks {
@@ -474,23 +498,38 @@ static int i2c_hid_hwreset(struct i2c_client *client)
 	return ret;
 }
 
-static void i2c_hid_get_input(struct i2c_hid *ihid)
+static void i2c_hid_account_read(struct i2c_hid *ihid, u64 ns)
+{
+	unsigned int bucket = ilog2(div_u64(ns, NSEC_PER_USEC) | 1);
+
+	ihid->read_count++;
+	ihid->read_ns_total += ns;
+	if (ns > ihid->read_ns_max)
+		ihid->read_ns_max = ns;
+	ihid->read_hist[min(bucket, I2C_HID_LAT_BUCKETS - 1)]++;
+}
+
+/* Returns true if a report was read, so more may be pending */
+static bool i2c_hid_get_input(struct i2c_hid *ihid)
 {
 	int ret;
 	u32 ret_size;
 	int size = le16_to_cpu(ihid->hdesc.wMaxInputLength);
+	u64 start;
 
 	if (size > ihid->bufsize)
 		size = ihid->bufsize;
 
+	start = fast_clock_now();
 	ret = i2c_master_recv(ihid->client, ihid->inbuf, size);
+	i2c_hid_account_read(ihid, fast_clock_to_ns(fast_clock_now() - start));
 	if (ret != size) {
 		if (ret < 0)
-			return;
+			return false;
 
 		dev_err(&ihid->client->dev, "%s: got %d data instead of %d\n",
 			__func__, ret, size);
-		return;
+		return false;
 	}
 
 	ret_size = ihid->inbuf[0] | ihid->inbuf[1] << 8;
@@ -499,13 +538,13 @@ static void i2c_hid_get_input(struct i2c_hid *ihid)
 		/* host or device initiated RESET completed */
 		if (test_and_clear_bit(I2C_HID_RESET_PENDING, &ihid->flags))
 			wake_up(&ihid->wait);
-		return;
+		return false;
 	}
 
 	if (ihid->quirks & I2C_HID_QUIRK_BOGUS_IRQ && ret_size == 0xffff) {
 		dev_warn_once(&ihid->client->dev, "%s: IRQ triggered but "
 			      "there's no data\n", __func__);
-		return;
+		return false;
 	}
 
 	if ((ret_size > size) || (ret_size < 2)) {
@@ -516,7 +555,7 @@ static void i2c_hid_get_input(struct i2c_hid *ihid)
 		} else {
 			dev_err(&ihid->client->dev, "%s: incomplete report (%d/%d)\n",
 				__func__, size, ret_size);
-			return;
+			return false;
 		}
 	}
 
@@ -526,17 +565,68 @@ static void i2c_hid_get_input(struct i2c_hid *ihid)
 		hid_input_report(ihid->hid, HID_INPUT_REPORT, ihid->inbuf + 2,
 				ret_size - 2, 1);
 
-	return;
+	return true;
+}
+
+/*
+ * Devices keep the interrupt asserted as long as they have reports queued.
+ * Not every interrupt controller can tell, in which case we read a single
+ * report and let the next interrupt pick up the rest.
+ */
+static bool i2c_hid_irq_asserted(struct i2c_hid *ihid)
+{
+	bool high;
+
+	if (irq_get_irqchip_state(ihid->client->irq, IRQCHIP_STATE_LINE_LEVEL,
+				  &high))
+		return false;
+
+	return high == ihid->irq_active_high;
+}
+
+/* called from the IRQ thread, so that it applies to current */
+static void i2c_hid_set_irq_prio(struct i2c_hid *ihid, unsigned int prio)
+{
+	struct sched_attr attr = {
+		.size = sizeof(attr),
+		.sched_policy = SCHED_FIFO,
+		/* what the IRQF_THREAD_INPUT class gives the thread */
+		.sched_priority = IRQ_THREAD_PRIO_INPUT,
+	};
+	int ret;
+
+	ihid->irq_prio = prio;
+	if (prio)
+		attr.sched_priority = min(prio, MAX_RT_PRIO - 1U);
+
+	ret = sched_setattr_nocheck(current, &attr);
+	if (ret)
+		dev_warn(&ihid->client->dev,
+			 "failed to set IRQ thread priority: %d\n", ret);
 }
 
 static irqreturn_t i2c_hid_irq(int irq, void *dev_id)
 {
 	struct i2c_hid *ihid = dev_id;
+	unsigned int prio = READ_ONCE(irq_priority);
+	unsigned int n = 0;
+
+	if (unlikely(prio != ihid->irq_prio))
+		i2c_hid_set_irq_prio(ihid, prio);
 
 	if (test_bit(I2C_HID_READ_PENDING, &ihid->flags))
 		return IRQ_HANDLED;
 
-	i2c_hid_get_input(ihid);
+	ihid->irq_count++;
+	while (n < I2C_HID_MAX_DRAIN && i2c_hid_get_input(ihid)) {
+		n++;
+		if (test_bit(I2C_HID_READ_PENDING, &ihid->flags) ||
+		    !i2c_hid_irq_asserted(ihid))
+			break;
+	}
+
+	if (n > ihid->drain_max)
+		ihid->drain_max = n;
 
 	return IRQ_HANDLED;
 }
@@ -828,8 +918,12 @@ static int i2c_hid_init_irq(struct i2c_client *client)
 	if (!irq_get_trigger_type(client->irq))
 		irqflags = IRQF_TRIGGER_LOW;
 
+	ihid->irq_active_high = irq_get_trigger_type(client->irq) &
+				(IRQ_TYPE_LEVEL_HIGH | IRQ_TYPE_EDGE_RISING);
+
 	ret = request_threaded_irq(client->irq, NULL, i2c_hid_irq,
-				   irqflags | IRQF_ONESHOT, client->name, ihid);
+				   irqflags | IRQF_ONESHOT | IRQF_THREAD_INPUT,
+				   client->name, ihid);
 	if (ret < 0) {
 		dev_warn(&client->dev,
 			"Could not register for %s interrupt, irq = %d,"
@@ -842,6 +936,38 @@ static int i2c_hid_init_irq(struct i2c_client *client)
 	return 0;
 }
 
+#ifdef CONFIG_DEBUG_FS
+static int i2c_hid_stats_show(struct seq_file *m, void *v)
+{
+	struct i2c_hid *ihid = m->private;
+	u64 count = ihid->read_count;
+	int i;
+
+	seq_printf(m, "irqs:            %llu\n", ihid->irq_count);
+	seq_printf(m, "reads:           %llu\n", count);
+	seq_printf(m, "max reads/irq:   %u\n", ihid->drain_max);
+	seq_printf(m, "read mean ns:    %llu\n",
+		   count ? div64_u64(ihid->read_ns_total, count) : 0);
+	seq_printf(m, "read max ns:     %llu\n", ihid->read_ns_max);
+	for (i = 0; i < I2C_HID_LAT_BUCKETS - 1; i++)
+		seq_printf(m, "read < %5u us: %llu\n", 2U << i,
+			   ihid->read_hist[i]);
+	seq_printf(m, "read >= %4u us: %llu\n", 1U << i, ihid->read_hist[i]);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(i2c_hid_stats);
+
+/* removed with the rest of the HID device's debugfs directory */
+static void i2c_hid_debugfs_init(struct i2c_hid *ihid)
+{
+	debugfs_create_file("i2c_stats", 0400, ihid->hid->debug_dir, ihid,
+			    &i2c_hid_stats_fops);
+}
+#else
+static inline void i2c_hid_debugfs_init(struct i2c_hid *ihid) { }
+#endif
+
 static int i2c_hid_fetch_hid_descriptor(struct i2c_hid *ihid)
 {
 	struct i2c_client *client = ihid->client;
@@ -1009,6 +1135,8 @@ int i2c_hid_core_probe(struct i2c_client *client, struct i2chid_ops *ops,
 		goto err_mem_free;
 	}
 
+	i2c_hid_debugfs_init(ihid);
+
 	return 0;
 
 err_mem_free:
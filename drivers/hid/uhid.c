@@ -11,20 +11,29 @@
 #include <linux/compat.h>
 #include <linux/cred.h>
 #include <linux/device.h>
+#include <linux/eventfd.h>
+#include <linux/file.h>
 #include <linux/fs.h>
 #include <linux/hid.h>
 #include <linux/input.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/mempool.h>
 #include <linux/miscdevice.h>
+#include <linux/mm.h>
 #include <linux/module.h>
 #include <linux/mutex.h>
 #include <linux/poll.h>
 #include <linux/sched.h>
+#include <linux/slab.h>
 #include <linux/spinlock.h>
 #include <linux/uhid.h>
+#include <linux/vmalloc.h>
 #include <linux/wait.h>
 
 #define UHID_NAME	"uhid"
 #define UHID_BUFSIZE	32
+#define UHID_EVENT_RESERVE	4
 
 struct uhid_device {
 	struct mutex devlock;
@@ -49,11 +58,46 @@ struct uhid_device {
 	u32 report_id;
 	u32 report_type;
 	struct uhid_event report_buf;
+	u32 report_seq;				/* last id handed out */
+	struct list_head async_reqs;		/* hid_raw_request waiting for a reply */
 	struct work_struct worker;
+
+	/* shared rings, set up once by UHID_RING_SETUP; ring set under qlock */
+	struct uhid_ring_header *ring;
+	struct uhid_ring ring_in, ring_out;	/* private copy of the geometry */
+	u32 ring_in_tail;
+	u32 ring_out_head;
+	struct eventfd_ctx *kick;
+	wait_queue_entry_t kick_wait;
+	poll_table kick_pt;
+	struct work_struct ring_work;
 };
 
 static struct miscdevice uhid_misc;
 
+/*
+ * Events to user-space are over 4k each, which kmalloc() would round up
+ * to 8k, so they come from their own cache, with a small reserve.
+ */
+static struct kmem_cache *uhid_event_cache;
+static mempool_t *uhid_event_pool;
+
+/* zeroed, as read() copies the whole event to user-space */
+static struct uhid_event *uhid_alloc_event(void)
+{
+	struct uhid_event *ev;
+
+	ev = mempool_alloc(uhid_event_pool, GFP_KERNEL);
+	if (ev)
+		memset(ev, 0, sizeof(*ev));
+	return ev;
+}
+
+static void uhid_free_event(struct uhid_event *ev)
+{
+	mempool_free(ev, uhid_event_pool);
+}
+
 static void uhid_device_add_worker(struct work_struct *work)
 {
 	struct uhid_device *uhid = container_of(work, struct uhid_device, worker);
@@ -80,8 +124,8 @@ static void uhid_queue(struct uhid_device *uhid, struct uhid_event *ev)
 		uhid->head = newhead;
 		wake_up_interruptible(&uhid->waitq);
 	} else {
-		hid_warn(uhid->hid, "Output queue is full\n");
-		kfree(ev);
+		hid_warn_ratelimited(uhid->hid, "Output queue is full\n");
+		uhid_free_event(ev);
 	}
 }
 
@@ -90,7 +134,7 @@ static int uhid_queue_event(struct uhid_device *uhid, __u32 event)
 	unsigned long flags;
 	struct uhid_event *ev;
 
-	ev = kzalloc(sizeof(*ev), GFP_KERNEL);
+	ev = uhid_alloc_event();
 	if (!ev)
 		return -ENOMEM;
 
@@ -109,7 +153,7 @@ static int uhid_hid_start(struct hid_device *hid)
 	struct uhid_event *ev;
 	unsigned long flags;
 
-	ev = kzalloc(sizeof(*ev), GFP_KERNEL);
+	ev = uhid_alloc_event();
 	if (!ev)
 		return -ENOMEM;
 
@@ -167,7 +211,7 @@ static int __uhid_report_queue_and_wait(struct uhid_device *uhid,
 	int ret;
 
 	spin_lock_irqsave(&uhid->qlock, flags);
-	*report_id = ++uhid->report_id;
+	*report_id = uhid->report_id = ++uhid->report_seq;
 	uhid->report_type = ev->type + 1;
 	uhid->report_running = true;
 	uhid_queue(uhid, ev);
@@ -188,13 +232,68 @@ static int __uhid_report_queue_and_wait(struct uhid_device *uhid,
 	return ret;
 }
 
+/* the reply type of an asynchronous request */
+static u32 uhid_async_reply_type(struct hid_raw_request *req)
+{
+	return req->reqtype == HID_REQ_GET_REPORT ? UHID_GET_REPORT_REPLY :
+						    UHID_SET_REPORT_REPLY;
+}
+
+static void uhid_complete_async(struct hid_raw_request *req,
+				const struct uhid_event *ev)
+{
+	const struct uhid_get_report_reply_req *rep;
+	int ret;
+
+	if (req->reqtype == HID_REQ_GET_REPORT) {
+		rep = &ev->u.get_report_reply;
+		if (rep->err) {
+			ret = -EIO;
+		} else {
+			ret = min3(req->len, (size_t)rep->size,
+				   (size_t)UHID_DATA_MAX);
+			memcpy(req->buf, rep->data, ret);
+		}
+	} else {
+		ret = ev->u.set_report_reply.err ? -EIO : req->len;
+	}
+
+	req->complete(req, ret);
+}
+
+static void uhid_fail_async(struct uhid_device *uhid)
+{
+	struct hid_raw_request *req, *tmp;
+	unsigned long flags;
+	LIST_HEAD(failed);
+
+	spin_lock_irqsave(&uhid->qlock, flags);
+	list_splice_init(&uhid->async_reqs, &failed);
+	spin_unlock_irqrestore(&uhid->qlock, flags);
+
+	list_for_each_entry_safe(req, tmp, &failed, entry) {
+		list_del(&req->entry);
+		req->complete(req, -EIO);
+	}
+}
+
 static void uhid_report_wake_up(struct uhid_device *uhid, u32 id,
 				const struct uhid_event *ev)
 {
+	struct hid_raw_request *req;
 	unsigned long flags;
 
 	spin_lock_irqsave(&uhid->qlock, flags);
 
+	list_for_each_entry(req, &uhid->async_reqs, entry) {
+		if (req->id == id && uhid_async_reply_type(req) == ev->type) {
+			list_del(&req->entry);
+			spin_unlock_irqrestore(&uhid->qlock, flags);
+			uhid_complete_async(req, ev);
+			return;
+		}
+	}
+
 	/* id for old report; drop it silently */
 	if (uhid->report_type != ev->type || uhid->report_id != id)
 		goto unlock;
@@ -220,7 +319,7 @@ static int uhid_hid_get_report(struct hid_device *hid, unsigned char rnum,
 	if (!uhid->running)
 		return -EIO;
 
-	ev = kzalloc(sizeof(*ev), GFP_KERNEL);
+	ev = uhid_alloc_event();
 	if (!ev)
 		return -ENOMEM;
 
@@ -230,7 +329,7 @@ static int uhid_hid_get_report(struct hid_device *hid, unsigned char rnum,
 
 	ret = mutex_lock_interruptible(&uhid->report_lock);
 	if (ret) {
-		kfree(ev);
+		uhid_free_event(ev);
 		return ret;
 	}
 
@@ -262,7 +361,7 @@ static int uhid_hid_set_report(struct hid_device *hid, unsigned char rnum,
 	if (!uhid->running || count > UHID_DATA_MAX)
 		return -EIO;
 
-	ev = kzalloc(sizeof(*ev), GFP_KERNEL);
+	ev = uhid_alloc_event();
 	if (!ev)
 		return -ENOMEM;
 
@@ -274,7 +373,7 @@ static int uhid_hid_set_report(struct hid_device *hid, unsigned char rnum,
 
 	ret = mutex_lock_interruptible(&uhid->report_lock);
 	if (ret) {
-		kfree(ev);
+		uhid_free_event(ev);
 		return ret;
 	}
 
@@ -293,25 +392,28 @@ static int uhid_hid_set_report(struct hid_device *hid, unsigned char rnum,
 	return ret;
 }
 
-static int uhid_hid_raw_request(struct hid_device *hid, unsigned char reportnum,
-				__u8 *buf, size_t len, unsigned char rtype,
-				int reqtype)
+static int uhid_rtype(unsigned char rtype)
 {
-	u8 u_rtype;
-
 	switch (rtype) {
 	case HID_FEATURE_REPORT:
-		u_rtype = UHID_FEATURE_REPORT;
-		break;
+		return UHID_FEATURE_REPORT;
 	case HID_OUTPUT_REPORT:
-		u_rtype = UHID_OUTPUT_REPORT;
-		break;
+		return UHID_OUTPUT_REPORT;
 	case HID_INPUT_REPORT:
-		u_rtype = UHID_INPUT_REPORT;
-		break;
+		return UHID_INPUT_REPORT;
 	default:
 		return -EINVAL;
 	}
+}
+
+static int uhid_hid_raw_request(struct hid_device *hid, unsigned char reportnum,
+				__u8 *buf, size_t len, unsigned char rtype,
+				int reqtype)
+{
+	int u_rtype = uhid_rtype(rtype);
+
+	if (u_rtype < 0)
+		return u_rtype;
 
 	switch (reqtype) {
 	case HID_REQ_GET_REPORT:
@@ -323,6 +425,105 @@ static int uhid_hid_raw_request(struct hid_device *hid, unsigned char reportnum,
 	}
 }
 
+/*
+ * Unlike the blocking requests, which are serialized by report_lock, any
+ * number of asynchronous requests can wait for their reply, told apart by
+ * their id. They are failed when the device is destroyed. May sleep.
+ */
+static int uhid_hid_raw_request_async(struct hid_device *hid,
+				      struct hid_raw_request *req)
+{
+	struct uhid_device *uhid = hid->driver_data;
+	int u_rtype = uhid_rtype(req->rtype);
+	struct uhid_event *ev;
+	unsigned long flags;
+	int ret = 0;
+
+	if (u_rtype < 0)
+		return u_rtype;
+
+	if (req->reqtype != HID_REQ_GET_REPORT &&
+	    req->reqtype != HID_REQ_SET_REPORT)
+		return -EIO;
+
+	if (!uhid->running ||
+	    (req->reqtype == HID_REQ_SET_REPORT && req->len > UHID_DATA_MAX))
+		return -EIO;
+
+	ev = uhid_alloc_event();
+	if (!ev)
+		return -ENOMEM;
+
+	if (req->reqtype == HID_REQ_GET_REPORT) {
+		ev->type = UHID_GET_REPORT;
+		ev->u.get_report.rnum = req->reportnum;
+		ev->u.get_report.rtype = u_rtype;
+	} else {
+		ev->type = UHID_SET_REPORT;
+		ev->u.set_report.rnum = req->reportnum;
+		ev->u.set_report.rtype = u_rtype;
+		ev->u.set_report.size = req->len;
+		memcpy(ev->u.set_report.data, req->buf, req->len);
+	}
+
+	spin_lock_irqsave(&uhid->qlock, flags);
+	if (!uhid->running) {
+		ret = -EIO;
+	} else if ((uhid->head + 1) % UHID_BUFSIZE == uhid->tail) {
+		ret = -EBUSY;
+	} else {
+		req->id = ++uhid->report_seq;
+		if (req->reqtype == HID_REQ_GET_REPORT)
+			ev->u.get_report.id = req->id;
+		else
+			ev->u.set_report.id = req->id;
+		list_add_tail(&req->entry, &uhid->async_reqs);
+		uhid_queue(uhid, ev);
+		ev = NULL;
+	}
+	spin_unlock_irqrestore(&uhid->qlock, flags);
+
+	if (ev)
+		uhid_free_event(ev);
+	return ret;
+}
+
+static struct uhid_ring_slot *uhid_ring_slot(struct uhid_ring_header *hdr,
+					     struct uhid_ring *ring, u32 index)
+{
+	return (void *)hdr + ring->data_offset +
+	       (size_t)(index & (ring->slots - 1)) * ring->slot_size;
+}
+
+/* must be called with qlock held */
+static int uhid_ring_output(struct uhid_device *uhid, __u8 *buf, size_t count,
+			    __u8 rtype)
+{
+	struct uhid_ring *out = &uhid->ring->out;
+	struct uhid_ring_slot *slot;
+	u32 head = uhid->ring_out_head;
+
+	if (count > uhid->ring_out.slot_size - sizeof(*slot))
+		return -EMSGSIZE;
+
+	if (head - READ_ONCE(out->tail) >= uhid->ring_out.slots) {
+		WRITE_ONCE(out->dropped, READ_ONCE(out->dropped) + 1);
+		return -EAGAIN;
+	}
+
+	slot = uhid_ring_slot(uhid->ring, &uhid->ring_out, head);
+	slot->timestamp = ktime_get_ns();
+	slot->size = count;
+	slot->rtype = rtype;
+	memcpy(slot->data, buf, count);
+
+	uhid->ring_out_head = head + 1;
+	smp_store_release(&out->head, head + 1);
+	wake_up_interruptible(&uhid->waitq);
+
+	return count;
+}
+
 static int uhid_hid_output_raw(struct hid_device *hid, __u8 *buf, size_t count,
 			       unsigned char report_type)
 {
@@ -330,6 +531,7 @@ static int uhid_hid_output_raw(struct hid_device *hid, __u8 *buf, size_t count,
 	__u8 rtype;
 	unsigned long flags;
 	struct uhid_event *ev;
+	int ret;
 
 	switch (report_type) {
 	case HID_FEATURE_REPORT:
@@ -345,7 +547,15 @@ static int uhid_hid_output_raw(struct hid_device *hid, __u8 *buf, size_t count,
 	if (count < 1 || count > UHID_DATA_MAX)
 		return -EINVAL;
 
-	ev = kzalloc(sizeof(*ev), GFP_KERNEL);
+	spin_lock_irqsave(&uhid->qlock, flags);
+	if (uhid->ring) {
+		ret = uhid_ring_output(uhid, buf, count, rtype);
+		spin_unlock_irqrestore(&uhid->qlock, flags);
+		return ret;
+	}
+	spin_unlock_irqrestore(&uhid->qlock, flags);
+
+	ev = uhid_alloc_event();
 	if (!ev)
 		return -ENOMEM;
 
@@ -374,6 +584,7 @@ struct hid_ll_driver uhid_hid_driver = {
 	.close = uhid_hid_close,
 	.parse = uhid_hid_parse,
 	.raw_request = uhid_hid_raw_request,
+	.raw_request_async = uhid_hid_raw_request_async,
 	.output_report = uhid_hid_output_report,
 };
 EXPORT_SYMBOL_GPL(uhid_hid_driver);
@@ -396,6 +607,52 @@ struct uhid_create_req_compat {
 	__u32 country;
 } __attribute__((__packed__));
 
+/*
+ * Copy a short event from user-space and extend it with 0s. Input events only
+ * read "size" bytes of their payload, so the zeroing stops there instead of
+ * clearing the whole 4k event for every small report.
+ */
+static int uhid_event_copy(const char __user *buffer, size_t len,
+			   struct uhid_event *event)
+{
+	size_t end = sizeof(*event);
+	u8 *buf = (u8 *)event;
+	size_t hdr;
+	u16 *size;
+
+	len = min(len, sizeof(*event));
+	if (copy_from_user(event, buffer, len))
+		return -EFAULT;
+
+	switch (event->type) {
+	case UHID_INPUT2:
+	case UHID_INPUT2_BATCH:
+		hdr = offsetof(struct uhid_event, u.input2.data);
+		size = &event->u.input2.size;
+		break;
+	case UHID_INPUT2_TS:
+		hdr = offsetof(struct uhid_event, u.input2_ts.data);
+		size = &event->u.input2_ts.size;
+		break;
+	default:
+		hdr = 0;
+		size = NULL;
+	}
+
+	if (size) {
+		if (len < hdr) {
+			memset(buf + len, 0, hdr - len);
+			len = hdr;
+		}
+		end = hdr + min_t(size_t, *size, UHID_DATA_MAX);
+	}
+
+	if (len < end)
+		memset(buf + len, 0, end - len);
+
+	return 0;
+}
+
 static int uhid_event_from_user(const char __user *buffer, size_t len,
 				struct uhid_event *event)
 {
@@ -450,19 +707,13 @@ static int uhid_event_from_user(const char __user *buffer, size_t len,
 		/* All others can be copied directly */
 	}
 
-	if (copy_from_user(event, buffer, min(len, sizeof(*event))))
-		return -EFAULT;
-
-	return 0;
+	return uhid_event_copy(buffer, len, event);
 }
 #else
 static int uhid_event_from_user(const char __user *buffer, size_t len,
 				struct uhid_event *event)
 {
-	if (copy_from_user(event, buffer, min(len, sizeof(*event))))
-		return -EFAULT;
-
-	return 0;
+	return uhid_event_copy(buffer, len, event);
 }
 #endif
 
@@ -561,6 +812,7 @@ static int uhid_dev_destroy(struct uhid_device *uhid)
 
 	uhid->running = false;
 	wake_up_interruptible(&uhid->report_wait);
+	uhid_fail_async(uhid);
 
 	cancel_work_sync(&uhid->worker);
 
@@ -592,6 +844,207 @@ static int uhid_dev_input2(struct uhid_device *uhid, struct uhid_event *ev)
 	return 0;
 }
 
+static int uhid_dev_input2_ts(struct uhid_device *uhid, struct uhid_event *ev)
+{
+	ktime_t now = ktime_get();
+	ktime_t time = ns_to_ktime(ev->u.input2_ts.timestamp);
+
+	if (!uhid->running)
+		return -EINVAL;
+
+	hid_input_report_time(uhid->hid, HID_INPUT_REPORT, ev->u.input2_ts.data,
+			      min_t(size_t, ev->u.input2_ts.size, UHID_DATA_MAX),
+			      0, time ? min(time, now) : now);
+
+	return 0;
+}
+
+static int uhid_dev_input2_batch(struct uhid_device *uhid,
+				 struct uhid_event *ev)
+{
+	size_t size = min_t(size_t, ev->u.input2_batch.size, UHID_DATA_MAX);
+	u8 *data = ev->u.input2_batch.data;
+	size_t off;
+	u16 len;
+
+	if (!uhid->running)
+		return -EINVAL;
+
+	/* validate the whole batch first so it is never delivered partially */
+	for (off = 0; off < size; off += sizeof(len) + len) {
+		if (size - off < sizeof(len))
+			return -EINVAL;
+		memcpy(&len, data + off, sizeof(len));
+		if (size - off - sizeof(len) < len)
+			return -EINVAL;
+	}
+
+	for (off = 0; off < size; off += sizeof(len) + len) {
+		memcpy(&len, data + off, sizeof(len));
+		hid_input_report(uhid->hid, HID_INPUT_REPORT,
+				 data + off + sizeof(len), len, 0);
+	}
+
+	return 0;
+}
+
+static void uhid_ring_work(struct work_struct *work)
+{
+	struct uhid_device *uhid = container_of(work, struct uhid_device,
+						ring_work);
+	struct uhid_ring *in = &uhid->ring_in;
+	struct uhid_ring_slot *slot;
+	u8 *data = uhid->input_buf.u.input2.data;
+	ktime_t time, now;
+	u32 head, tail;
+	size_t size;
+
+	mutex_lock(&uhid->devlock);
+
+	tail = uhid->ring_in_tail;
+	head = smp_load_acquire(&uhid->ring->in.head);
+
+	/* a bogus head from user-space must not make us loop forever */
+	if (head - tail > in->slots)
+		head = tail + in->slots;
+
+	for (; tail != head; tail++) {
+		slot = uhid_ring_slot(uhid->ring, in, tail);
+		size = min_t(size_t, READ_ONCE(slot->size),
+			     in->slot_size - sizeof(*slot));
+		time = ns_to_ktime(READ_ONCE(slot->timestamp));
+
+		if (!uhid->running)
+			continue;
+
+		/* drivers expect a stable buffer, so don't parse shared memory */
+		memcpy(data, slot->data, size);
+
+		now = ktime_get();
+		hid_input_report_time(uhid->hid, HID_INPUT_REPORT, data, size,
+				      0, time ? min(time, now) : now);
+	}
+
+	uhid->ring_in_tail = tail;
+	smp_store_release(&uhid->ring->in.tail, tail);
+
+	mutex_unlock(&uhid->devlock);
+}
+
+/* called with the eventfd wait queue lock held and interrupts disabled */
+static int uhid_kick_wakeup(wait_queue_entry_t *wait, unsigned int mode,
+			    int sync, void *key)
+{
+	struct uhid_device *uhid = container_of(wait, struct uhid_device,
+						kick_wait);
+	u64 cnt;
+
+	if (key_to_poll(key) & EPOLLIN) {
+		eventfd_ctx_do_read(uhid->kick, &cnt);
+		schedule_work(&uhid->ring_work);
+	}
+
+	return 0;
+}
+
+static void uhid_kick_queue_proc(struct file *file, wait_queue_head_t *wqh,
+				 poll_table *pt)
+{
+	struct uhid_device *uhid = container_of(pt, struct uhid_device,
+						kick_pt);
+
+	add_wait_queue(wqh, &uhid->kick_wait);
+}
+
+static int uhid_dev_ring_setup(struct uhid_device *uhid,
+			       struct uhid_event *ev)
+{
+	struct uhid_ring_setup_req *req = &ev->u.ring_setup;
+	struct uhid_ring_header *ring;
+	struct eventfd_ctx *kick;
+	unsigned long flags;
+	size_t in_size, out_size, size;
+	struct fd f;
+	__poll_t events;
+
+	if (uhid->ring)
+		return -EBUSY;
+
+	if (!is_power_of_2(req->in_slots) || !is_power_of_2(req->out_slots) ||
+	    req->in_slots > UHID_RING_MAX_SLOTS ||
+	    req->out_slots > UHID_RING_MAX_SLOTS)
+		return -EINVAL;
+
+	if (req->in_slot_size <= sizeof(struct uhid_ring_slot) ||
+	    req->out_slot_size <= sizeof(struct uhid_ring_slot) ||
+	    req->in_slot_size % 8 || req->out_slot_size % 8 ||
+	    req->in_slot_size > UHID_DATA_MAX + sizeof(struct uhid_ring_slot) ||
+	    req->out_slot_size > UHID_DATA_MAX + sizeof(struct uhid_ring_slot))
+		return -EINVAL;
+
+	in_size = (size_t)req->in_slots * req->in_slot_size;
+	out_size = (size_t)req->out_slots * req->out_slot_size;
+	size = PAGE_SIZE + in_size + out_size;
+	if (size > UHID_RING_MAX_SIZE)
+		return -EINVAL;
+
+	f = fdget(req->kick_fd);
+	if (!f.file)
+		return -EBADF;
+
+	kick = eventfd_ctx_fileget(f.file);
+	if (IS_ERR(kick)) {
+		fdput(f);
+		return PTR_ERR(kick);
+	}
+
+	ring = vmalloc_user(size);
+	if (!ring) {
+		eventfd_ctx_put(kick);
+		fdput(f);
+		return -ENOMEM;
+	}
+
+	ring->in.slots = req->in_slots;
+	ring->in.slot_size = req->in_slot_size;
+	ring->in.data_offset = PAGE_SIZE;
+	ring->out.slots = req->out_slots;
+	ring->out.slot_size = req->out_slot_size;
+	ring->out.data_offset = PAGE_SIZE + in_size;
+	uhid->ring_in = ring->in;
+	uhid->ring_out = ring->out;
+
+	spin_lock_irqsave(&uhid->qlock, flags);
+	/* pairs with uhid_char_mmap(), which does not take any lock */
+	smp_store_release(&uhid->ring, ring);
+	spin_unlock_irqrestore(&uhid->qlock, flags);
+
+	uhid->kick = kick;
+	init_waitqueue_func_entry(&uhid->kick_wait, uhid_kick_wakeup);
+	init_poll_funcptr(&uhid->kick_pt, uhid_kick_queue_proc);
+
+	events = vfs_poll(f.file, &uhid->kick_pt);
+	if (events & EPOLLIN)
+		schedule_work(&uhid->ring_work);
+
+	fdput(f);
+
+	return 0;
+}
+
+/* stop consuming the input ring; the mapping stays until the file is freed */
+static void uhid_ring_stop(struct uhid_device *uhid)
+{
+	u64 cnt;
+
+	if (!uhid->ring)
+		return;
+
+	eventfd_ctx_remove_wait_queue(uhid->kick, &uhid->kick_wait, &cnt);
+	cancel_work_sync(&uhid->ring_work);
+	eventfd_ctx_put(uhid->kick);
+}
+
 static int uhid_dev_get_report_reply(struct uhid_device *uhid,
 				     struct uhid_event *ev)
 {
@@ -625,8 +1078,10 @@ static int uhid_char_open(struct inode *inode, struct file *file)
 	spin_lock_init(&uhid->qlock);
 	init_waitqueue_head(&uhid->waitq);
 	init_waitqueue_head(&uhid->report_wait);
+	INIT_LIST_HEAD(&uhid->async_reqs);
 	uhid->running = false;
 	INIT_WORK(&uhid->worker, uhid_device_add_worker);
+	INIT_WORK(&uhid->ring_work, uhid_ring_work);
 
 	file->private_data = uhid;
 	stream_open(inode, file);
@@ -639,10 +1094,12 @@ static int uhid_char_release(struct inode *inode, struct file *file)
 	struct uhid_device *uhid = file->private_data;
 	unsigned int i;
 
+	uhid_ring_stop(uhid);
 	uhid_dev_destroy(uhid);
 
 	for (i = 0; i < UHID_BUFSIZE; ++i)
-		kfree(uhid->outq[i]);
+		uhid_free_event(uhid->outq[i]);
+	vfree(uhid->ring);
 
 	kfree(uhid);
 
@@ -684,7 +1141,7 @@ static ssize_t uhid_char_read(struct file *file, char __user *buffer,
 		if (copy_to_user(buffer, uhid->outq[uhid->tail], len)) {
 			ret = -EFAULT;
 		} else {
-			kfree(uhid->outq[uhid->tail]);
+			uhid_free_event(uhid->outq[uhid->tail]);
 			uhid->outq[uhid->tail] = NULL;
 
 			spin_lock_irqsave(&uhid->qlock, flags);
@@ -712,7 +1169,6 @@ static ssize_t uhid_char_write(struct file *file, const char __user *buffer,
 	if (ret)
 		return ret;
 
-	memset(&uhid->input_buf, 0, sizeof(uhid->input_buf));
 	len = min(count, sizeof(uhid->input_buf));
 
 	ret = uhid_event_from_user(buffer, len, &uhid->input_buf);
@@ -746,6 +1202,15 @@ static ssize_t uhid_char_write(struct file *file, const char __user *buffer,
 	case UHID_INPUT2:
 		ret = uhid_dev_input2(uhid, &uhid->input_buf);
 		break;
+	case UHID_INPUT2_BATCH:
+		ret = uhid_dev_input2_batch(uhid, &uhid->input_buf);
+		break;
+	case UHID_INPUT2_TS:
+		ret = uhid_dev_input2_ts(uhid, &uhid->input_buf);
+		break;
+	case UHID_RING_SETUP:
+		ret = uhid_dev_ring_setup(uhid, &uhid->input_buf);
+		break;
 	case UHID_GET_REPORT_REPLY:
 		ret = uhid_dev_get_report_reply(uhid, &uhid->input_buf);
 		break;
@@ -773,9 +1238,24 @@ static __poll_t uhid_char_poll(struct file *file, poll_table *wait)
 	if (uhid->head != uhid->tail)
 		mask |= EPOLLIN | EPOLLRDNORM;
 
+	if (uhid->ring &&
+	    READ_ONCE(uhid->ring_out_head) != READ_ONCE(uhid->ring->out.tail))
+		mask |= EPOLLIN | EPOLLRDNORM;
+
 	return mask;
 }
 
+static int uhid_char_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct uhid_device *uhid = file->private_data;
+	struct uhid_ring_header *ring = smp_load_acquire(&uhid->ring);
+
+	if (!ring)
+		return -EINVAL;
+
+	return remap_vmalloc_range(vma, ring, vma->vm_pgoff);
+}
+
 static const struct file_operations uhid_fops = {
 	.owner		= THIS_MODULE,
 	.open		= uhid_char_open,
@@ -783,6 +1263,7 @@ static const struct file_operations uhid_fops = {
 	.read		= uhid_char_read,
 	.write		= uhid_char_write,
 	.poll		= uhid_char_poll,
+	.mmap		= uhid_char_mmap,
 	.llseek		= no_llseek,
 };
 
@@ -791,7 +1272,44 @@ static struct miscdevice uhid_misc = {
 	.minor		= UHID_MINOR,
 	.name		= UHID_NAME,
 };
-module_misc_device(uhid_misc);
+
+static int __init uhid_init(void)
+{
+	int ret;
+
+	uhid_event_cache = KMEM_CACHE(uhid_event, 0);
+	if (!uhid_event_cache)
+		return -ENOMEM;
+
+	uhid_event_pool = mempool_create_slab_pool(UHID_EVENT_RESERVE,
+						   uhid_event_cache);
+	if (!uhid_event_pool) {
+		ret = -ENOMEM;
+		goto err_cache;
+	}
+
+	ret = misc_register(&uhid_misc);
+	if (ret)
+		goto err_pool;
+
+	return 0;
+
+err_pool:
+	mempool_destroy(uhid_event_pool);
+err_cache:
+	kmem_cache_destroy(uhid_event_cache);
+	return ret;
+}
+
+static void __exit uhid_exit(void)
+{
+	misc_deregister(&uhid_misc);
+	mempool_destroy(uhid_event_pool);
+	kmem_cache_destroy(uhid_event_cache);
+}
+
+module_init(uhid_init);
+module_exit(uhid_exit);
 
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("David Herrmann <dh.herrmann@gmail.com>");
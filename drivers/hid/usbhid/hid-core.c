@@ -33,6 +33,7 @@
 #include <linux/hiddev.h>
 #include <linux/hid-debug.h>
 #include <linux/hidraw.h>
+#include <trace/events/hid.h>
 #include "usbhid.h"
 
 /*
@@ -57,6 +58,11 @@ static unsigned int hid_kbpoll_interval;
 module_param_named(kbpoll, hid_kbpoll_interval, uint, 0644);
 MODULE_PARM_DESC(kbpoll, "Polling interval of keyboards");
 
+static bool hid_threaded_input;
+module_param_named(threaded_input, hid_threaded_input, bool, 0644);
+MODULE_PARM_DESC(threaded_input, "Process input reports in a per-device thread "
+		"instead of the URB completion (applies to new devices)");
+
 static unsigned int ignoreled;
 module_param_named(ignoreled, ignoreled, uint, 0644);
 MODULE_PARM_DESC(ignoreled, "Autosuspend with active leds");
@@ -76,31 +82,71 @@ static int hid_submit_out(struct hid_device *hid);
 static int hid_submit_ctrl(struct hid_device *hid);
 static void hid_cancel_delayed_stuff(struct usbhid_device *usbhid);
 
-/* Start up the input URB */
+/* Start up the input URBs which are not already submitted */
 static int hid_start_in(struct hid_device *hid)
 {
 	unsigned long flags;
 	int rc = 0;
+	unsigned int i;
 	struct usbhid_device *usbhid = hid->driver_data;
 
 	spin_lock_irqsave(&usbhid->lock, flags);
 	if (test_bit(HID_IN_POLLING, &usbhid->iofl) &&
 	    !test_bit(HID_DISCONNECTED, &usbhid->iofl) &&
-	    !test_bit(HID_SUSPENDED, &usbhid->iofl) &&
-	    !test_and_set_bit(HID_IN_RUNNING, &usbhid->iofl)) {
-		rc = usb_submit_urb(usbhid->urbin, GFP_ATOMIC);
-		if (rc != 0) {
-			clear_bit(HID_IN_RUNNING, &usbhid->iofl);
-			if (rc == -ENOSPC)
-				set_bit(HID_NO_BANDWIDTH, &usbhid->iofl);
-		} else {
+	    !test_bit(HID_SUSPENDED, &usbhid->iofl)) {
+		for (i = 0; i < usbhid->nr_in_urbs; i++) {
+			if (test_and_set_bit(i, &usbhid->in_active))
+				continue;
+			rc = usb_submit_urb(usbhid->urbin[i], GFP_ATOMIC);
+			if (rc != 0) {
+				clear_bit(i, &usbhid->in_active);
+				if (rc == -ENOSPC)
+					set_bit(HID_NO_BANDWIDTH, &usbhid->iofl);
+				break;
+			}
 			clear_bit(HID_NO_BANDWIDTH, &usbhid->iofl);
 		}
+		if (usbhid->in_active)
+			set_bit(HID_IN_RUNNING, &usbhid->iofl);
 	}
 	spin_unlock_irqrestore(&usbhid->lock, flags);
 	return rc;
 }
 
+/* An input URB completed and is not resubmitted */
+static void hid_stop_in_urb(struct usbhid_device *usbhid, struct urb *urb)
+{
+	unsigned int i;
+
+	for (i = 0; i < usbhid->nr_in_urbs; i++)
+		if (usbhid->urbin[i] == urb)
+			clear_bit(i, &usbhid->in_active);
+	if (!usbhid->in_active)
+		clear_bit(HID_IN_RUNNING, &usbhid->iofl);
+}
+
+static void hid_kill_in_urbs(struct usbhid_device *usbhid)
+{
+	unsigned int i;
+
+	for (i = 0; i < usbhid->nr_in_urbs; i++)
+		usb_kill_urb(usbhid->urbin[i]);
+
+	/* and process what they already received */
+	if (usbhid->in_worker)
+		kthread_flush_work(&usbhid->in_work);
+}
+
+static void hid_free_in_urbs(struct usbhid_device *usbhid)
+{
+	unsigned int i;
+
+	for (i = 0; i < HID_IN_URBS; i++) {
+		usb_free_urb(usbhid->urbin[i]);
+		usbhid->urbin[i] = NULL;
+	}
+}
+
 /* I/O retry timer routine */
 static void hid_retry_timeout(struct timer_list *t)
 {
@@ -122,7 +168,7 @@ static void hid_reset(struct work_struct *work)
 
 	if (test_bit(HID_CLEAR_HALT, &usbhid->iofl)) {
 		dev_dbg(&usbhid->intf->dev, "clear halt\n");
-		rc = usb_clear_halt(hid_to_usb_dev(hid), usbhid->urbin->pipe);
+		rc = usb_clear_halt(hid_to_usb_dev(hid), usbhid->urbin[0]->pipe);
 		clear_bit(HID_CLEAR_HALT, &usbhid->iofl);
 		if (rc == 0) {
 			hid_start_in(hid);
@@ -264,6 +310,107 @@ static int usbhid_restart_ctrl_queue(struct usbhid_device *usbhid)
 	return kicked;
 }
 
+static void hid_process_in(struct hid_device *hid, u8 *data, u32 size)
+{
+	struct usbhid_device *usbhid = hid->driver_data;
+
+	hid_input_report(hid, HID_INPUT_REPORT, data, size, 1);
+	/*
+	 * autosuspend refused while keys are pressed
+	 * because most keyboards don't wake up when
+	 * a key is released
+	 */
+	if (hid_check_keys_pressed(hid))
+		set_bit(HID_KEYS_PRESSED, &usbhid->iofl);
+	else
+		clear_bit(HID_KEYS_PRESSED, &usbhid->iofl);
+}
+
+/*
+ * With threaded_input, the completion handler only copies the report to
+ * a preallocated ring, and the input thread processes it. URBs of an
+ * endpoint complete one at a time, so the ring has a single producer and
+ * a single consumer.
+ */
+static void hid_in_work(struct kthread_work *work)
+{
+	struct usbhid_device *usbhid =
+		container_of(work, struct usbhid_device, in_work);
+	unsigned int tail = usbhid->in_tail;
+	unsigned int slot;
+
+	while (tail != smp_load_acquire(&usbhid->in_head)) {
+		slot = tail & (HID_IN_RING_SIZE - 1);
+		hid_process_in(usbhid->hid,
+			       usbhid->in_ring + slot * usbhid->in_slot_size,
+			       usbhid->in_ring_len[slot]);
+		smp_store_release(&usbhid->in_tail, ++tail);
+	}
+}
+
+static void hid_queue_in(struct hid_device *hid, struct urb *urb)
+{
+	struct usbhid_device *usbhid = hid->driver_data;
+	unsigned int head = usbhid->in_head;
+	unsigned int pending = head - smp_load_acquire(&usbhid->in_tail);
+	unsigned int slot = head & (HID_IN_RING_SIZE - 1);
+
+	if (pending >= HID_IN_RING_SIZE) {
+		usbhid->in_dropped++;
+		dev_warn_ratelimited(&usbhid->intf->dev,
+				     "input thread overrun, report dropped\n");
+		return;
+	}
+
+	/* the queued reports get their sequence first */
+	trace_hid_transport_report(hid, hid->input_seq + pending + 1,
+				   HID_INPUT_REPORT, urb->transfer_buffer,
+				   urb->actual_length);
+
+	memcpy(usbhid->in_ring + slot * usbhid->in_slot_size,
+	       urb->transfer_buffer, urb->actual_length);
+	usbhid->in_ring_len[slot] = urb->actual_length;
+	smp_store_release(&usbhid->in_head, head + 1);
+
+	kthread_queue_work(usbhid->in_worker, &usbhid->in_work);
+}
+
+static int hid_start_in_thread(struct hid_device *hid, unsigned int insize)
+{
+	struct usbhid_device *usbhid = hid->driver_data;
+	struct kthread_worker *worker;
+
+	usbhid->in_ring = kmalloc_array(HID_IN_RING_SIZE, insize, GFP_KERNEL);
+	if (!usbhid->in_ring)
+		return -ENOMEM;
+
+	worker = kthread_create_worker(0, "usbhid/%s", dev_name(&hid->dev));
+	if (IS_ERR(worker)) {
+		kfree(usbhid->in_ring);
+		usbhid->in_ring = NULL;
+		return PTR_ERR(worker);
+	}
+	sched_set_fifo(worker->task);
+
+	kthread_init_work(&usbhid->in_work, hid_in_work);
+	usbhid->in_slot_size = insize;
+	usbhid->in_head = 0;
+	usbhid->in_tail = 0;
+	usbhid->in_worker = worker;
+	return 0;
+}
+
+static void hid_stop_in_thread(struct usbhid_device *usbhid)
+{
+	if (!usbhid->in_worker)
+		return;
+
+	kthread_destroy_worker(usbhid->in_worker);
+	usbhid->in_worker = NULL;
+	kfree(usbhid->in_ring);
+	usbhid->in_ring = NULL;
+}
+
 /*
  * Input interrupt completion handler.
  */
@@ -280,38 +427,43 @@ static void hid_irq_in(struct urb *urb)
 		if (!test_bit(HID_OPENED, &usbhid->iofl))
 			break;
 		usbhid_mark_busy(usbhid);
+		if (unlikely(usbhid->resume_time)) {
+			dev_dbg(&usbhid->intf->dev,
+				"first report %lld us after resume\n",
+				ktime_us_delta(ktime_get(), usbhid->resume_time));
+			usbhid->resume_time = 0;
+		}
 		if (!test_bit(HID_RESUME_RUNNING, &usbhid->iofl)) {
-			hid_input_report(urb->context, HID_INPUT_REPORT,
-					 urb->transfer_buffer,
-					 urb->actual_length, 1);
-			/*
-			 * autosuspend refused while keys are pressed
-			 * because most keyboards don't wake up when
-			 * a key is released
-			 */
-			if (hid_check_keys_pressed(hid))
-				set_bit(HID_KEYS_PRESSED, &usbhid->iofl);
-			else
-				clear_bit(HID_KEYS_PRESSED, &usbhid->iofl);
+			if (usbhid->in_worker) {
+				hid_queue_in(hid, urb);
+				break;
+			}
+			/* the report is about to get the next sequence */
+			trace_hid_transport_report(hid, hid->input_seq + 1,
+						   HID_INPUT_REPORT,
+						   urb->transfer_buffer,
+						   urb->actual_length);
+			hid_process_in(hid, urb->transfer_buffer,
+				       urb->actual_length);
 		}
 		break;
 	case -EPIPE:		/* stall */
 		usbhid_mark_busy(usbhid);
-		clear_bit(HID_IN_RUNNING, &usbhid->iofl);
+		hid_stop_in_urb(usbhid, urb);
 		set_bit(HID_CLEAR_HALT, &usbhid->iofl);
 		schedule_work(&usbhid->reset_work);
 		return;
 	case -ECONNRESET:	/* unlink */
 	case -ENOENT:
 	case -ESHUTDOWN:	/* unplug */
-		clear_bit(HID_IN_RUNNING, &usbhid->iofl);
+		hid_stop_in_urb(usbhid, urb);
 		return;
 	case -EILSEQ:		/* protocol error or unplug */
 	case -EPROTO:		/* protocol error or unplug */
 	case -ETIME:		/* protocol error or unplug */
 	case -ETIMEDOUT:	/* Should never happen, but... */
 		usbhid_mark_busy(usbhid);
-		clear_bit(HID_IN_RUNNING, &usbhid->iofl);
+		hid_stop_in_urb(usbhid, urb);
 		hid_io_error(hid);
 		return;
 	default:		/* error */
@@ -321,7 +473,7 @@ static void hid_irq_in(struct urb *urb)
 
 	status = usb_submit_urb(urb, GFP_ATOMIC);
 	if (status) {
-		clear_bit(HID_IN_RUNNING, &usbhid->iofl);
+		hid_stop_in_urb(usbhid, urb);
 		if (status != -EPERM) {
 			hid_err(hid, "can't resubmit intr, %s-%s/input%d, status %d\n",
 				hid_to_usb_dev(hid)->bus->bus_name,
@@ -332,6 +484,35 @@ static void hid_irq_in(struct urb *urb)
 	}
 }
 
+/*
+ * Buffers for the queued output and control reports, taken from the pool
+ * when the report fits, so that the queue does not allocate at the rate
+ * of rumble and LED updates. Called with usbhid->lock held.
+ */
+static char *usbhid_get_report_buf(struct usbhid_device *usbhid,
+				   struct hid_report *report)
+{
+	unsigned int i;
+
+	if (hid_report_len(report) + 7 > usbhid->raw_size || !usbhid->raw_free)
+		return hid_alloc_report_buf(report, GFP_ATOMIC);
+
+	i = __ffs(usbhid->raw_free);
+	__clear_bit(i, &usbhid->raw_free);
+	return usbhid->raw_pool + i * usbhid->raw_size;
+}
+
+static void usbhid_put_report_buf(struct usbhid_device *usbhid, char *raw)
+{
+	char *pool_end = usbhid->raw_pool + HID_RAW_POOL_SIZE * usbhid->raw_size;
+
+	if (raw >= usbhid->raw_pool && raw < pool_end)
+		__set_bit((raw - usbhid->raw_pool) / usbhid->raw_size,
+			  &usbhid->raw_free);
+	else
+		kfree(raw);
+}
+
 static int hid_submit_out(struct hid_device *hid)
 {
 	struct hid_report *report;
@@ -347,7 +528,7 @@ static int hid_submit_out(struct hid_device *hid)
 	if (raw_report) {
 		memcpy(usbhid->outbuf, raw_report,
 				usbhid->urbout->transfer_buffer_length);
-		kfree(raw_report);
+		usbhid_put_report_buf(usbhid, raw_report);
 		usbhid->out[usbhid->outtail].raw_report = NULL;
 	}
 
@@ -362,26 +543,59 @@ static int hid_submit_out(struct hid_device *hid)
 	return 0;
 }
 
+/*
+ * Like usbhid_get_raw_report() and usbhid_set_raw_report(), a raw request
+ * for report 0 does not transfer byte 0 of the buffer.
+ */
+static bool usbhid_raw_request_skips_id(struct hid_device *hid,
+					struct hid_raw_request *req)
+{
+	if (req->reqtype == HID_REQ_SET_REPORT &&
+	    req->rtype == HID_OUTPUT_REPORT &&
+	    (hid->quirks & HID_QUIRK_SKIP_OUTPUT_REPORT_ID))
+		return true;
+
+	return req->reportnum == 0;
+}
+
 static int hid_submit_ctrl(struct hid_device *hid)
 {
 	struct hid_report *report;
+	struct hid_raw_request *req;
 	unsigned char dir;
 	char *raw_report;
 	int len, r;
+	unsigned int rtype, rnum;
 	struct usbhid_device *usbhid = hid->driver_data;
 
 	report = usbhid->ctrl[usbhid->ctrltail].report;
 	raw_report = usbhid->ctrl[usbhid->ctrltail].raw_report;
 	dir = usbhid->ctrl[usbhid->ctrltail].dir;
+	req = usbhid->ctrl[usbhid->ctrltail].req;
+
+	if (req) {
+		bool skip = usbhid_raw_request_skips_id(hid, req);
+
+		rtype = req->rtype;
+		rnum = req->reportnum;
+		len = req->len - skip;
+		if (dir == USB_DIR_OUT)
+			memcpy(usbhid->ctrlbuf, req->buf + skip, len);
+	} else {
+		rtype = report->type;
+		rnum = report->id;
+		len = hid_report_len(report);
+	}
 
-	len = hid_report_len(report);
 	if (dir == USB_DIR_OUT) {
 		usbhid->urbctrl->pipe = usb_sndctrlpipe(hid_to_usb_dev(hid), 0);
 		if (raw_report) {
 			memcpy(usbhid->ctrlbuf, raw_report, len);
-			kfree(raw_report);
+			usbhid_put_report_buf(usbhid, raw_report);
 			usbhid->ctrl[usbhid->ctrltail].raw_report = NULL;
 		}
+	} else if (req) {
+		usbhid->urbctrl->pipe = usb_rcvctrlpipe(hid_to_usb_dev(hid), 0);
 	} else {
 		int maxpacket;
 
@@ -399,8 +613,7 @@ static int hid_submit_ctrl(struct hid_device *hid)
 	usbhid->cr->bRequestType = USB_TYPE_CLASS | USB_RECIP_INTERFACE | dir;
 	usbhid->cr->bRequest = (dir == USB_DIR_OUT) ? HID_REQ_SET_REPORT :
 						      HID_REQ_GET_REPORT;
-	usbhid->cr->wValue = cpu_to_le16(((report->type + 1) << 8) |
-					 report->id);
+	usbhid->cr->wValue = cpu_to_le16(((rtype + 1) << 8) | rnum);
 	usbhid->cr->wIndex = cpu_to_le16(usbhid->ifnum);
 	usbhid->cr->wLength = cpu_to_le16(len);
 
@@ -470,16 +683,76 @@ static void hid_irq_out(struct urb *urb)
  * Control pipe completion handler.
  */
 
+/*
+ * Copies the result of a raw request out of the control URB, which is
+ * resubmitted for the next request before @req is completed. Raw requests
+ * are completed without usbhid->lock held, so that the callback can queue
+ * the next one. Returns what is passed to the callback.
+ */
+static int usbhid_finish_raw_request(struct hid_device *hid,
+				     struct hid_raw_request *req,
+				     struct urb *urb)
+{
+	bool skip = usbhid_raw_request_skips_id(hid, req);
+	int ret = urb->status;
+
+	if (!ret) {
+		ret = urb->actual_length;
+		if (req->reqtype == HID_REQ_GET_REPORT) {
+			req->buf[0] = req->reportnum;
+			memcpy(req->buf + skip, urb->transfer_buffer, ret);
+		}
+		/* count also the report id */
+		if (ret > 0 && skip)
+			ret++;
+	}
+
+	return ret;
+}
+
+/*
+ * Takes the raw requests off the control fifo, from the tail, which is
+ * the one being sent, to the head. Called with usbhid->lock held.
+ */
+static void usbhid_drop_raw_requests(struct usbhid_device *usbhid,
+				     struct list_head *dropped)
+{
+	unsigned int i;
+
+	for (i = usbhid->ctrltail; i != usbhid->ctrlhead;
+	     i = (i + 1) & (HID_CONTROL_FIFO_SIZE - 1)) {
+		if (usbhid->ctrl[i].req) {
+			list_add_tail(&usbhid->ctrl[i].req->entry, dropped);
+			usbhid->ctrl[i].req = NULL;
+		}
+	}
+}
+
+static void usbhid_complete_dropped(struct list_head *dropped, int err)
+{
+	struct hid_raw_request *req, *tmp;
+
+	list_for_each_entry_safe(req, tmp, dropped, entry) {
+		list_del(&req->entry);
+		req->complete(req, err);
+	}
+}
+
 static void hid_ctrl(struct urb *urb)
 {
 	struct hid_device *hid = urb->context;
 	struct usbhid_device *usbhid = hid->driver_data;
+	struct hid_raw_request *req;
+	LIST_HEAD(dropped);
 	unsigned long flags;
 	int unplug = 0, status = urb->status;
+	int ret = 0;
 
 	switch (status) {
 	case 0:			/* success */
-		if (usbhid->ctrl[usbhid->ctrltail].dir == USB_DIR_IN)
+		/* raw requests have no report */
+		if (usbhid->ctrl[usbhid->ctrltail].dir == USB_DIR_IN &&
+		    usbhid->ctrl[usbhid->ctrltail].report)
 			hid_input_report(urb->context,
 				usbhid->ctrl[usbhid->ctrltail].report->type,
 				urb->transfer_buffer, urb->actual_length, 0);
@@ -499,7 +772,14 @@ static void hid_ctrl(struct urb *urb)
 
 	spin_lock_irqsave(&usbhid->lock, flags);
 
+	/* usbhid_stop() may have taken it already */
+	req = usbhid->ctrl[usbhid->ctrltail].req;
+	usbhid->ctrl[usbhid->ctrltail].req = NULL;
+	if (req)
+		ret = usbhid_finish_raw_request(hid, req, urb);
+
 	if (unplug) {
+		usbhid_drop_raw_requests(usbhid, &dropped);
 		usbhid->ctrltail = usbhid->ctrlhead;
 	} else if (usbhid->ctrlhead != usbhid->ctrltail) {
 		usbhid->ctrltail = (usbhid->ctrltail + 1) & (HID_CONTROL_FIFO_SIZE - 1);
@@ -508,16 +788,99 @@ static void hid_ctrl(struct urb *urb)
 				hid_submit_ctrl(hid) == 0) {
 			/* Successfully submitted next urb in queue */
 			spin_unlock_irqrestore(&usbhid->lock, flags);
+			if (req)
+				req->complete(req, ret);
 			return;
 		}
 	}
 
 	clear_bit(HID_CTRL_RUNNING, &usbhid->iofl);
 	spin_unlock_irqrestore(&usbhid->lock, flags);
+	if (req)
+		req->complete(req, ret);
+	usbhid_complete_dropped(&dropped, -ESHUTDOWN);
 	usb_autopm_put_interface_async(usbhid->intf);
 	wake_up(&usbhid->wait);
 }
 
+/*
+ * With HID_QUIRK_COALESCE_OUTPUT, a report which is still queued, and not
+ * being sent yet, is updated in place instead of queueing the same report
+ * again, so that only its latest state is sent. Returns true if it was.
+ */
+static bool usbhid_coalesce_out(struct usbhid_device *usbhid,
+				struct hid_report *report)
+{
+	unsigned char i = usbhid->outtail;
+
+	if (test_bit(HID_OUT_RUNNING, &usbhid->iofl))
+		i = (i + 1) & (HID_OUTPUT_FIFO_SIZE - 1);
+
+	for (; i != usbhid->outhead; i = (i + 1) & (HID_OUTPUT_FIFO_SIZE - 1)) {
+		if (usbhid->out[i].report == report) {
+			hid_output_report(report, usbhid->out[i].raw_report);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static bool usbhid_coalesce_ctrl(struct usbhid_device *usbhid,
+				 struct hid_report *report)
+{
+	unsigned char i = usbhid->ctrltail;
+
+	if (test_bit(HID_CTRL_RUNNING, &usbhid->iofl))
+		i = (i + 1) & (HID_CONTROL_FIFO_SIZE - 1);
+
+	for (; i != usbhid->ctrlhead; i = (i + 1) & (HID_CONTROL_FIFO_SIZE - 1)) {
+		if (usbhid->ctrl[i].report == report &&
+		    usbhid->ctrl[i].dir == USB_DIR_OUT) {
+			hid_output_report(report, usbhid->ctrl[i].raw_report);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Called with usbhid->lock held, which it drops to unlink a stuck URB */
+static void usbhid_kick_ctrl_queue(struct usbhid_device *usbhid)
+{
+	/* If the queue isn't running, restart it */
+	if (!test_bit(HID_CTRL_RUNNING, &usbhid->iofl)) {
+		usbhid_restart_ctrl_queue(usbhid);
+
+	/* Otherwise see if an earlier request has timed out */
+	} else if (time_after(jiffies, usbhid->last_ctrl + HZ * 5)) {
+
+		/* Prevent autosuspend following the unlink */
+		usb_autopm_get_interface_no_resume(usbhid->intf);
+
+		/*
+		 * Prevent resubmission in case the URB completes
+		 * before we can unlink it.  We don't want to cancel
+		 * the wrong transfer!
+		 */
+		usb_block_urb(usbhid->urbctrl);
+
+		/* Drop lock to avoid deadlock if the callback runs */
+		spin_unlock(&usbhid->lock);
+
+		usb_unlink_urb(usbhid->urbctrl);
+		spin_lock(&usbhid->lock);
+		usb_unblock_urb(usbhid->urbctrl);
+
+		/* Unlink might have stopped the queue */
+		if (!test_bit(HID_CTRL_RUNNING, &usbhid->iofl))
+			usbhid_restart_ctrl_queue(usbhid);
+
+		/* Now we can allow autosuspend again */
+		usb_autopm_put_interface_async(usbhid->intf);
+	}
+}
+
 static void __usbhid_submit_report(struct hid_device *hid, struct hid_report *report,
 				   unsigned char dir)
 {
@@ -529,12 +892,16 @@ static void __usbhid_submit_report(struct hid_device *hid, struct hid_report *re
 		return;
 
 	if (usbhid->urbout && dir == USB_DIR_OUT && report->type == HID_OUTPUT_REPORT) {
+		if ((hid->quirks & HID_QUIRK_COALESCE_OUTPUT) &&
+		    usbhid_coalesce_out(usbhid, report))
+			return;
+
 		if ((head = (usbhid->outhead + 1) & (HID_OUTPUT_FIFO_SIZE - 1)) == usbhid->outtail) {
-			hid_warn(hid, "output queue full\n");
+			hid_warn_ratelimited(hid, "output queue full\n");
 			return;
 		}
 
-		usbhid->out[usbhid->outhead].raw_report = hid_alloc_report_buf(report, GFP_ATOMIC);
+		usbhid->out[usbhid->outhead].raw_report = usbhid_get_report_buf(usbhid, report);
 		if (!usbhid->out[usbhid->outhead].raw_report) {
 			hid_warn(hid, "output queueing failed\n");
 			return;
@@ -577,13 +944,17 @@ static void __usbhid_submit_report(struct hid_device *hid, struct hid_report *re
 		return;
 	}
 
+	if (dir == USB_DIR_OUT && (hid->quirks & HID_QUIRK_COALESCE_OUTPUT) &&
+	    usbhid_coalesce_ctrl(usbhid, report))
+		return;
+
 	if ((head = (usbhid->ctrlhead + 1) & (HID_CONTROL_FIFO_SIZE - 1)) == usbhid->ctrltail) {
 		hid_warn(hid, "control queue full\n");
 		return;
 	}
 
 	if (dir == USB_DIR_OUT) {
-		usbhid->ctrl[usbhid->ctrlhead].raw_report = hid_alloc_report_buf(report, GFP_ATOMIC);
+		usbhid->ctrl[usbhid->ctrlhead].raw_report = usbhid_get_report_buf(usbhid, report);
 		if (!usbhid->ctrl[usbhid->ctrlhead].raw_report) {
 			hid_warn(hid, "control queueing failed\n");
 			return;
@@ -591,40 +962,11 @@ static void __usbhid_submit_report(struct hid_device *hid, struct hid_report *re
 		hid_output_report(report, usbhid->ctrl[usbhid->ctrlhead].raw_report);
 	}
 	usbhid->ctrl[usbhid->ctrlhead].report = report;
+	usbhid->ctrl[usbhid->ctrlhead].req = NULL;
 	usbhid->ctrl[usbhid->ctrlhead].dir = dir;
 	usbhid->ctrlhead = head;
 
-	/* If the queue isn't running, restart it */
-	if (!test_bit(HID_CTRL_RUNNING, &usbhid->iofl)) {
-		usbhid_restart_ctrl_queue(usbhid);
-
-	/* Otherwise see if an earlier request has timed out */
-	} else if (time_after(jiffies, usbhid->last_ctrl + HZ * 5)) {
-
-		/* Prevent autosuspend following the unlink */
-		usb_autopm_get_interface_no_resume(usbhid->intf);
-
-		/*
-		 * Prevent resubmission in case the URB completes
-		 * before we can unlink it.  We don't want to cancel
-		 * the wrong transfer!
-		 */
-		usb_block_urb(usbhid->urbctrl);
-
-		/* Drop lock to avoid deadlock if the callback runs */
-		spin_unlock(&usbhid->lock);
-
-		usb_unlink_urb(usbhid->urbctrl);
-		spin_lock(&usbhid->lock);
-		usb_unblock_urb(usbhid->urbctrl);
-
-		/* Unlink might have stopped the queue */
-		if (!test_bit(HID_CTRL_RUNNING, &usbhid->iofl))
-			usbhid_restart_ctrl_queue(usbhid);
-
-		/* Now we can allow autosuspend again */
-		usb_autopm_put_interface_async(usbhid->intf);
-	}
+	usbhid_kick_ctrl_queue(usbhid);
 }
 
 static void usbhid_submit_report(struct hid_device *hid, struct hid_report *report, unsigned char dir)
@@ -753,7 +1095,7 @@ static void usbhid_close(struct hid_device *hid)
 
 	if (!(hid->quirks & HID_QUIRK_ALWAYS_POLL)) {
 		hid_cancel_delayed_stuff(usbhid);
-		usb_kill_urb(usbhid->urbin);
+		hid_kill_in_urbs(usbhid);
 		usbhid->intf->needs_remote_wakeup = 0;
 	}
 
@@ -852,15 +1194,26 @@ static int hid_alloc_buffers(struct usb_device *dev, struct hid_device *hid)
 {
 	struct usbhid_device *usbhid = hid->driver_data;
 
-	usbhid->inbuf = usb_alloc_coherent(dev, usbhid->bufsize, GFP_KERNEL,
-			&usbhid->inbuf_dma);
+	unsigned int i;
+
+	for (i = 0; i < usbhid->nr_in_urbs; i++) {
+		usbhid->inbuf[i] = usb_alloc_coherent(dev, usbhid->bufsize,
+				GFP_KERNEL, &usbhid->inbuf_dma[i]);
+		if (!usbhid->inbuf[i])
+			return -1;
+	}
 	usbhid->outbuf = usb_alloc_coherent(dev, usbhid->bufsize, GFP_KERNEL,
 			&usbhid->outbuf_dma);
 	usbhid->cr = kmalloc(sizeof(*usbhid->cr), GFP_KERNEL);
 	usbhid->ctrlbuf = usb_alloc_coherent(dev, usbhid->bufsize, GFP_KERNEL,
 			&usbhid->ctrlbuf_dma);
-	if (!usbhid->inbuf || !usbhid->outbuf || !usbhid->cr ||
-			!usbhid->ctrlbuf)
+	/* hid_alloc_report_buf() sized, for the queued reports */
+	usbhid->raw_size = usbhid->bufsize + 7;
+	usbhid->raw_pool = kmalloc_array(HID_RAW_POOL_SIZE, usbhid->raw_size,
+					 GFP_KERNEL);
+	usbhid->raw_free = GENMASK(HID_RAW_POOL_SIZE - 1, 0);
+	if (!usbhid->outbuf || !usbhid->cr ||
+			!usbhid->ctrlbuf || !usbhid->raw_pool)
 		return -1;
 
 	return 0;
@@ -970,10 +1323,19 @@ static void hid_free_buffers(struct usb_device *dev, struct hid_device *hid)
 {
 	struct usbhid_device *usbhid = hid->driver_data;
 
-	usb_free_coherent(dev, usbhid->bufsize, usbhid->inbuf, usbhid->inbuf_dma);
+	unsigned int i;
+
+	for (i = 0; i < HID_IN_URBS; i++) {
+		usb_free_coherent(dev, usbhid->bufsize, usbhid->inbuf[i],
+				  usbhid->inbuf_dma[i]);
+		usbhid->inbuf[i] = NULL;
+	}
 	usb_free_coherent(dev, usbhid->bufsize, usbhid->outbuf, usbhid->outbuf_dma);
 	kfree(usbhid->cr);
 	usb_free_coherent(dev, usbhid->bufsize, usbhid->ctrlbuf, usbhid->ctrlbuf_dma);
+	kfree(usbhid->raw_pool);
+	usbhid->raw_pool = NULL;
+	usbhid->raw_free = 0;
 }
 
 static int usbhid_parse(struct hid_device *hid)
@@ -1063,7 +1425,7 @@ static int usbhid_start(struct hid_device *hid)
 	struct usb_host_interface *interface = intf->cur_altsetting;
 	struct usb_device *dev = interface_to_usbdev(intf);
 	struct usbhid_device *usbhid = hid->driver_data;
-	unsigned int n, insize = 0;
+	unsigned int n, i, insize = 0;
 	int ret;
 
 	mutex_lock(&usbhid->mutex);
@@ -1083,11 +1445,20 @@ static int usbhid_start(struct hid_device *hid)
 	if (insize > HID_MAX_BUFFER_SIZE)
 		insize = HID_MAX_BUFFER_SIZE;
 
+	usbhid->nr_in_urbs = hid->quirks & HID_QUIRK_MULTI_IN_URBS ?
+			     HID_IN_URBS : 1;
+
 	if (hid_alloc_buffers(dev, hid)) {
 		ret = -ENOMEM;
 		goto fail;
 	}
 
+	if (hid_threaded_input && insize) {
+		ret = hid_start_in_thread(hid, insize);
+		if (ret)
+			goto fail;
+	}
+
 	for (n = 0; n < interface->desc.bNumEndpoints; n++) {
 		struct usb_endpoint_descriptor *endpoint;
 		int pipe;
@@ -1127,15 +1498,19 @@ static int usbhid_start(struct hid_device *hid)
 
 		ret = -ENOMEM;
 		if (usb_endpoint_dir_in(endpoint)) {
-			if (usbhid->urbin)
+			if (usbhid->urbin[0])
 				continue;
-			if (!(usbhid->urbin = usb_alloc_urb(0, GFP_KERNEL)))
-				goto fail;
+			interface->endpoint[n].latency_sensitive = true;
 			pipe = usb_rcvintpipe(dev, endpoint->bEndpointAddress);
-			usb_fill_int_urb(usbhid->urbin, dev, pipe, usbhid->inbuf, insize,
-					 hid_irq_in, hid, interval);
-			usbhid->urbin->transfer_dma = usbhid->inbuf_dma;
-			usbhid->urbin->transfer_flags |= URB_NO_TRANSFER_DMA_MAP;
+			for (i = 0; i < usbhid->nr_in_urbs; i++) {
+				if (!(usbhid->urbin[i] = usb_alloc_urb(0, GFP_KERNEL)))
+					goto fail;
+				usb_fill_int_urb(usbhid->urbin[i], dev, pipe,
+						 usbhid->inbuf[i], insize,
+						 hid_irq_in, hid, interval);
+				usbhid->urbin[i]->transfer_dma = usbhid->inbuf_dma[i];
+				usbhid->urbin[i]->transfer_flags |= URB_NO_TRANSFER_DMA_MAP;
+			}
 		} else {
 			if (usbhid->urbout)
 				continue;
@@ -1193,10 +1568,10 @@ static int usbhid_start(struct hid_device *hid)
 	return 0;
 
 fail:
-	usb_free_urb(usbhid->urbin);
+	hid_stop_in_thread(usbhid);
+	hid_free_in_urbs(usbhid);
 	usb_free_urb(usbhid->urbout);
 	usb_free_urb(usbhid->urbctrl);
-	usbhid->urbin = NULL;
 	usbhid->urbout = NULL;
 	usbhid->urbctrl = NULL;
 	hid_free_buffers(dev, hid);
@@ -1207,6 +1582,7 @@ static int usbhid_start(struct hid_device *hid)
 static void usbhid_stop(struct hid_device *hid)
 {
 	struct usbhid_device *usbhid = hid->driver_data;
+	LIST_HEAD(dropped);
 
 	if (WARN_ON(!usbhid))
 		return;
@@ -1222,29 +1598,40 @@ static void usbhid_stop(struct hid_device *hid)
 
 	spin_lock_irq(&usbhid->lock);	/* Sync with error and led handlers */
 	set_bit(HID_DISCONNECTED, &usbhid->iofl);
+	usbhid_drop_raw_requests(usbhid, &dropped);
 	while (usbhid->ctrltail != usbhid->ctrlhead) {
 		if (usbhid->ctrl[usbhid->ctrltail].dir == USB_DIR_OUT) {
-			kfree(usbhid->ctrl[usbhid->ctrltail].raw_report);
+			usbhid_put_report_buf(usbhid,
+					usbhid->ctrl[usbhid->ctrltail].raw_report);
 			usbhid->ctrl[usbhid->ctrltail].raw_report = NULL;
 		}
 
 		usbhid->ctrltail = (usbhid->ctrltail + 1) &
 			(HID_CONTROL_FIFO_SIZE - 1);
 	}
+	while (usbhid->outtail != usbhid->outhead) {
+		usbhid_put_report_buf(usbhid,
+				usbhid->out[usbhid->outtail].raw_report);
+		usbhid->out[usbhid->outtail].raw_report = NULL;
+		usbhid->outtail = (usbhid->outtail + 1) &
+			(HID_OUTPUT_FIFO_SIZE - 1);
+	}
 	spin_unlock_irq(&usbhid->lock);
 
-	usb_kill_urb(usbhid->urbin);
+	usbhid_complete_dropped(&dropped, -ENODEV);
+
+	hid_kill_in_urbs(usbhid);
 	usb_kill_urb(usbhid->urbout);
 	usb_kill_urb(usbhid->urbctrl);
 
 	hid_cancel_delayed_stuff(usbhid);
+	hid_stop_in_thread(usbhid);
 
 	hid->claimed = 0;
 
-	usb_free_urb(usbhid->urbin);
+	hid_free_in_urbs(usbhid); /* don't mess up next start */
 	usb_free_urb(usbhid->urbctrl);
 	usb_free_urb(usbhid->urbout);
-	usbhid->urbin = NULL; /* don't mess up next start */
 	usbhid->urbctrl = NULL;
 	usbhid->urbout = NULL;
 
@@ -1297,6 +1684,51 @@ static int usbhid_raw_request(struct hid_device *hid, unsigned char reportnum,
 	}
 }
 
+/*
+ * Raw requests go through the control fifo like the reports queued by
+ * usbhid_submit_report(), so they are sent one after the other without
+ * the caller waiting for each.
+ */
+static int usbhid_raw_request_async(struct hid_device *hid,
+				    struct hid_raw_request *req)
+{
+	struct usbhid_device *usbhid = hid->driver_data;
+	unsigned long flags;
+	int head, ret = 0;
+
+	if (req->reqtype != HID_REQ_GET_REPORT &&
+	    req->reqtype != HID_REQ_SET_REPORT)
+		return -EIO;
+
+	if (req->len > usbhid->bufsize)
+		return -EINVAL;
+
+	spin_lock_irqsave(&usbhid->lock, flags);
+
+	if (test_bit(HID_DISCONNECTED, &usbhid->iofl)) {
+		ret = -ENODEV;
+		goto out;
+	}
+
+	head = (usbhid->ctrlhead + 1) & (HID_CONTROL_FIFO_SIZE - 1);
+	if (head == usbhid->ctrltail) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	usbhid->ctrl[usbhid->ctrlhead].report = NULL;
+	usbhid->ctrl[usbhid->ctrlhead].raw_report = NULL;
+	usbhid->ctrl[usbhid->ctrlhead].req = req;
+	usbhid->ctrl[usbhid->ctrlhead].dir =
+		req->reqtype == HID_REQ_GET_REPORT ? USB_DIR_IN : USB_DIR_OUT;
+	usbhid->ctrlhead = head;
+
+	usbhid_kick_ctrl_queue(usbhid);
+out:
+	spin_unlock_irqrestore(&usbhid->lock, flags);
+	return ret;
+}
+
 static int usbhid_idle(struct hid_device *hid, int report, int idle,
 		int reqtype)
 {
@@ -1328,6 +1760,7 @@ struct hid_ll_driver usb_hid_driver = {
 	.request = usbhid_request,
 	.wait = usbhid_wait_io,
 	.raw_request = usbhid_raw_request,
+	.raw_request_async = usbhid_raw_request_async,
 	.output_report = usbhid_output_report,
 	.idle = usbhid_idle,
 	.may_wakeup = usbhid_may_wakeup,
@@ -1428,6 +1861,8 @@ static int usbhid_probe(struct usb_interface *intf, const struct usb_device_id *
 		goto err_free;
 	}
 
+	device_set_resume_priority(&hid->dev);
+
 	return 0;
 err_free:
 	kfree(usbhid);
@@ -1461,7 +1896,7 @@ static void hid_cancel_delayed_stuff(struct usbhid_device *usbhid)
 static void hid_cease_io(struct usbhid_device *usbhid)
 {
 	del_timer_sync(&usbhid->io_retry);
-	usb_kill_urb(usbhid->urbin);
+	hid_kill_in_urbs(usbhid);
 	usb_kill_urb(usbhid->urbctrl);
 	usb_kill_urb(usbhid->urbout);
 }
@@ -1521,10 +1956,24 @@ static int hid_post_reset(struct usb_interface *intf)
 	int status;
 	char *rdesc;
 
+	/* No need to do another reset or clear a halted endpoint */
+	spin_lock_irq(&usbhid->lock);
+	clear_bit(HID_RESET_PENDING, &usbhid->iofl);
+	clear_bit(HID_CLEAR_HALT, &usbhid->iofl);
+	spin_unlock_irq(&usbhid->lock);
+	hid_set_idle(dev, intf->cur_altsetting->desc.bInterfaceNumber, 0, 0);
+
+	/*
+	 * Get reports flowing again first, the descriptor check below
+	 * costs a control transfer of up to several hundred bytes.
+	 */
+	hid_restart_io(hid);
+
 	/* Fetch and examine the HID report descriptor. If this
 	 * has changed, then rebind. Since usbcore's check of the
 	 * configuration descriptors passed, we already know that
 	 * the size of the HID report descriptor has not changed.
+	 * An unchanged descriptor needs no reparsing.
 	 */
 	rdesc = kmalloc(hid->dev_rsize, GFP_KERNEL);
 	if (!rdesc)
@@ -1542,18 +1991,10 @@ static int hid_post_reset(struct usb_interface *intf)
 	kfree(rdesc);
 	if (status != 0) {
 		dbg_hid("report descriptor changed\n");
+		hid_cease_io(usbhid);
 		return -EPERM;
 	}
 
-	/* No need to do another reset or clear a halted endpoint */
-	spin_lock_irq(&usbhid->lock);
-	clear_bit(HID_RESET_PENDING, &usbhid->iofl);
-	clear_bit(HID_CLEAR_HALT, &usbhid->iofl);
-	spin_unlock_irq(&usbhid->lock);
-	hid_set_idle(dev, intf->cur_altsetting->desc.bInterfaceNumber, 0, 0);
-
-	hid_restart_io(hid);
-
 	return 0;
 }
 
@@ -1575,6 +2016,7 @@ static int hid_suspend(struct usb_interface *intf, pm_message_t message)
 	int status = 0;
 	bool driver_suspended = false;
 	unsigned int ledcount;
+	ktime_t start = ktime_get();
 
 	if (PMSG_IS_AUTO(message)) {
 		ledcount = hidinput_count_leds(hid);
@@ -1620,7 +2062,8 @@ static int hid_suspend(struct usb_interface *intf, pm_message_t message)
 		status = -EBUSY;
 		goto failed;
 	}
-	dev_dbg(&intf->dev, "suspend\n");
+	dev_dbg(&intf->dev, "suspend took %lld us\n",
+		ktime_us_delta(ktime_get(), start));
 	return status;
 
  failed:
@@ -1631,24 +2074,31 @@ static int hid_suspend(struct usb_interface *intf, pm_message_t message)
 static int hid_resume(struct usb_interface *intf)
 {
 	struct hid_device *hid = usb_get_intfdata (intf);
+	struct usbhid_device *usbhid = hid->driver_data;
 	int status;
 
+	usbhid->resume_time = ktime_get();
 	status = hid_resume_common(hid, true);
-	dev_dbg(&intf->dev, "resume status %d\n", status);
+	dev_dbg(&intf->dev, "resume status %d, took %lld us\n", status,
+		ktime_us_delta(ktime_get(), usbhid->resume_time));
 	return 0;
 }
 
 static int hid_reset_resume(struct usb_interface *intf)
 {
 	struct hid_device *hid = usb_get_intfdata(intf);
+	struct usbhid_device *usbhid = hid->driver_data;
 	int status;
 
+	usbhid->resume_time = ktime_get();
 	status = hid_post_reset(intf);
 	if (status >= 0 && hid->driver && hid->driver->reset_resume) {
 		int ret = hid->driver->reset_resume(hid);
 		if (ret < 0)
 			status = ret;
 	}
+	dev_dbg(&intf->dev, "reset_resume status %d, took %lld us\n", status,
+		ktime_us_delta(ktime_get(), usbhid->resume_time));
 	return status;
 }
 
@@ -44,6 +44,7 @@ struct hiddev_list {
 	struct hiddev *hiddev;
 	struct list_head node;
 	struct mutex thread_lock;
+	struct hiddev_report_values values;	/* under thread_lock */
 };
 
 /*
@@ -137,6 +138,41 @@ hiddev_lookup_usage(struct hid_device *hid, struct hiddev_usage_ref *uref)
 	return NULL;
 }
 
+/*
+ * Copy the current values of all the fields of a report, in field order.
+ * Returns the number of values, at most HID_MAX_MULTI_USAGES.
+ */
+static unsigned int hiddev_report_values(struct hid_report *report,
+					 __s32 *values)
+{
+	unsigned int i, n = 0, count;
+	struct hid_field *field;
+
+	for (i = 0; i < report->maxfield; i++) {
+		field = report->field[i];
+		count = min_t(unsigned int, field->report_count,
+			      HID_MAX_MULTI_USAGES - n);
+		memcpy(values + n, field->value, count * sizeof(*values));
+		n += count;
+	}
+
+	return n;
+}
+
+/*
+ * Readers with HIDDEV_FLAG_VALUES only get the report events, and read the
+ * values of the whole report when they get to them.
+ */
+static bool hiddev_list_wants(struct hiddev_list *list,
+			      struct hiddev_usage_ref *uref)
+{
+	if (list->flags & HIDDEV_FLAG_VALUES)
+		return uref->field_index == HID_FIELD_INDEX_NONE;
+
+	return uref->field_index != HID_FIELD_INDEX_NONE ||
+		(list->flags & HIDDEV_FLAG_REPORT) != 0;
+}
+
 static void hiddev_send_event(struct hid_device *hid,
 			      struct hiddev_usage_ref *uref)
 {
@@ -146,8 +182,7 @@ static void hiddev_send_event(struct hid_device *hid,
 
 	spin_lock_irqsave(&hiddev->list_lock, flags);
 	list_for_each_entry(list, &hiddev->list, node) {
-		if (uref->field_index != HID_FIELD_INDEX_NONE ||
-		    (list->flags & HIDDEV_FLAG_REPORT) != 0) {
+		if (hiddev_list_wants(list, uref)) {
 			list->buffer[list->head] = *uref;
 			list->head = (list->head + 1) &
 				(HIDDEV_BUFFER_SIZE - 1);
@@ -313,6 +348,43 @@ static ssize_t hiddev_write(struct file * file, const char __user * buffer, size
 	return -EINVAL;
 }
 
+/*
+ * Fill list->values for the report event @uref, for a HIDDEV_FLAG_VALUES
+ * read. Returns the size of the record, or 0 if there is nothing to return
+ * for @uref.
+ */
+static int hiddev_read_values(struct hiddev_list *list,
+			      struct hiddev_usage_ref *uref)
+{
+	struct hiddev *hiddev = list->hiddev;
+	struct hiddev_report_info rinfo;
+	struct hid_report *report;
+	int size = 0;
+
+	/* queued before the flags were changed */
+	if (uref->field_index != HID_FIELD_INDEX_NONE)
+		return 0;
+
+	mutex_lock(&hiddev->existancelock);
+	if (!hiddev->exist)
+		goto out;
+
+	rinfo.report_type = uref->report_type;
+	rinfo.report_id = uref->report_id;
+	report = hiddev_lookup_report(hiddev->hid, &rinfo);
+	if (!report)
+		goto out;
+
+	list->values.report_type = uref->report_type;
+	list->values.report_id = uref->report_id;
+	list->values.num_values = hiddev_report_values(report,
+						       list->values.values);
+	size = struct_size(&list->values, values, list->values.num_values);
+out:
+	mutex_unlock(&hiddev->existancelock);
+	return size;
+}
+
 /*
  * "read" file op
  */
@@ -323,8 +395,12 @@ static ssize_t hiddev_read(struct file * file, char __user * buffer, size_t coun
 	int event_size;
 	int retval;
 
-	event_size = ((list->flags & HIDDEV_FLAG_UREF) != 0) ?
-		sizeof(struct hiddev_usage_ref) : sizeof(struct hiddev_event);
+	if (list->flags & HIDDEV_FLAG_VALUES)
+		event_size = offsetof(struct hiddev_report_values, values);
+	else if (list->flags & HIDDEV_FLAG_UREF)
+		event_size = sizeof(struct hiddev_usage_ref);
+	else
+		event_size = sizeof(struct hiddev_event);
 
 	if (count < event_size)
 		return 0;
@@ -373,7 +449,23 @@ static ssize_t hiddev_read(struct file * file, char __user * buffer, size_t coun
 
 		while (list->head != list->tail &&
 		       retval + event_size <= count) {
-			if ((list->flags & HIDDEV_FLAG_UREF) == 0) {
+			if (list->flags & HIDDEV_FLAG_VALUES) {
+				int size = hiddev_read_values(list,
+						list->buffer + list->tail);
+
+				if (retval + size > count) {
+					/* too small for even one record */
+					if (!retval)
+						retval = -EINVAL;
+					break;
+				}
+				if (copy_to_user(buffer + retval, &list->values,
+						 size)) {
+					mutex_unlock(&list->thread_lock);
+					return -EFAULT;
+				}
+				retval += size;
+			} else if ((list->flags & HIDDEV_FLAG_UREF) == 0) {
 				if (list->buffer[list->tail].field_index != HID_FIELD_INDEX_NONE) {
 					struct hiddev_event event;
 
@@ -563,6 +655,42 @@ static noinline int hiddev_ioctl_usage(struct hiddev *hiddev, unsigned int cmd,
 	}
 }
 
+static noinline int hiddev_ioctl_values(struct hiddev *hiddev, void __user *user_arg)
+{
+	struct hiddev_report_values *values;
+	struct hiddev_report_info rinfo;
+	struct hid_report *report;
+	int r = 0;
+
+	values = kmalloc(sizeof(*values), GFP_KERNEL);
+	if (!values)
+		return -ENOMEM;
+
+	if (copy_from_user(values, user_arg,
+			   offsetof(struct hiddev_report_values, values))) {
+		r = -EFAULT;
+		goto out;
+	}
+
+	rinfo.report_type = values->report_type;
+	rinfo.report_id = values->report_id;
+	report = hiddev_lookup_report(hiddev->hid, &rinfo);
+	if (!report) {
+		r = -EINVAL;
+		goto out;
+	}
+
+	values->report_id = rinfo.report_id;
+	values->num_values = hiddev_report_values(report, values->values);
+
+	if (copy_to_user(user_arg, values,
+			 struct_size(values, values, values->num_values)))
+		r = -EFAULT;
+out:
+	kfree(values);
+	return r;
+}
+
 static noinline int hiddev_ioctl_string(struct hiddev *hiddev, unsigned int cmd, void __user *user_arg)
 {
 	struct hid_device *hid = hiddev->hid;
@@ -672,7 +800,9 @@ static long hiddev_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 
 			if ((newflags & ~HIDDEV_FLAGS) != 0 ||
 			    ((newflags & HIDDEV_FLAG_REPORT) != 0 &&
-			     (newflags & HIDDEV_FLAG_UREF) == 0))
+			     (newflags & HIDDEV_FLAG_UREF) == 0) ||
+			    ((newflags & HIDDEV_FLAG_VALUES) != 0 &&
+			     newflags != HIDDEV_FLAG_VALUES))
 				break;
 
 			list->flags = newflags;
@@ -797,6 +927,14 @@ static long hiddev_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 		r = hiddev_ioctl_usage(hiddev, cmd, user_arg);
 		break;
 
+	case HIDIOCGREPORTVALUES:
+		if (!hiddev->initialized) {
+			usbhid_init_reports(hid);
+			hiddev->initialized = true;
+		}
+		r = hiddev_ioctl_values(hiddev, user_arg);
+		break;
+
 	case HIDIOCGCOLLECTIONINFO:
 		if (copy_from_user(&cinfo, user_arg, sizeof(cinfo))) {
 			r = -EFAULT;
@@ -18,6 +18,7 @@
 #include <linux/timer.h>
 #include <linux/wait.h>
 #include <linux/workqueue.h>
+#include <linux/kthread.h>
 #include <linux/input.h>
 
 /*  API provided by hid-core.c for USB HID drivers */
@@ -48,6 +49,18 @@ struct usb_interface *usbhid_find_interface(int minor);
  */
 #define HID_IN_POLLING		14
 
+/*
+ * Number of input URBs kept queued with HID_QUIRK_MULTI_IN_URBS, so that
+ * the endpoint is still polled while a report is being processed.
+ */
+#define HID_IN_URBS		4
+
+/* Number of preallocated buffers for queued output and control reports */
+#define HID_RAW_POOL_SIZE	8
+
+/* Number of reports queued for the input thread, a power of two */
+#define HID_IN_RING_SIZE	16
+
 /*
  * USB-specific HID struct, to be pointed to
  * from struct hid_device->driver_data
@@ -61,9 +74,19 @@ struct usbhid_device {
 
 	unsigned int bufsize;                                           /* URB buffer size */
 
-	struct urb *urbin;                                              /* Input URB */
-	char *inbuf;                                                    /* Input buffer */
-	dma_addr_t inbuf_dma;                                           /* Input buffer dma */
+	struct urb *urbin[HID_IN_URBS];                                 /* Input URBs */
+	char *inbuf[HID_IN_URBS];                                       /* Input buffers */
+	dma_addr_t inbuf_dma[HID_IN_URBS];                              /* Input buffers dma */
+	unsigned int nr_in_urbs;                                        /* Input URBs in use */
+	unsigned long in_active;                                        /* Submitted input URBs */
+
+	struct kthread_worker *in_worker;                               /* Input thread, if threaded_input */
+	struct kthread_work in_work;                                    /* Processes the queued reports */
+	u8 *in_ring;                                                    /* Queued reports, in_slot_size each */
+	unsigned int in_ring_len[HID_IN_RING_SIZE];                     /* Lengths of the queued reports */
+	unsigned int in_slot_size;
+	unsigned int in_head, in_tail;                                  /* Written by the URB and the thread */
+	unsigned long in_dropped;                                       /* Reports dropped, ring full */
 
 	struct urb *urbctrl;                                            /* Control URB */
 	struct usb_ctrlrequest *cr;                                     /* Control request struct */
@@ -80,6 +103,10 @@ struct usbhid_device {
 	dma_addr_t outbuf_dma;                                          /* Output buffer dma */
 	unsigned long last_out;							/* record of last output for timeouts */
 
+	char *raw_pool;                                                 /* Queued report buffers, raw_size each */
+	unsigned int raw_size;
+	unsigned long raw_free;                                         /* Free raw_pool buffers */
+
 	struct mutex mutex;						/* start/stop/open/close */
 	spinlock_t lock;						/* fifo spinlock */
 	unsigned long iofl;                                             /* I/O flags (CTRL_RUNNING, OUT_RUNNING) */
@@ -88,6 +115,7 @@ struct usbhid_device {
 	unsigned int retry_delay;                                       /* Delay length in ms */
 	struct work_struct reset_work;                                  /* Task context for resets */
 	wait_queue_head_t wait;						/* For sleeping */
+	ktime_t resume_time;						/* Set until the first report after resume */
 };
 
 #define	hid_to_usb_dev(hid_dev) \
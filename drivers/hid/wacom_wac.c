@@ -2277,6 +2277,35 @@ static void wacom_wac_pen_usage_mapping(struct hid_device *hdev,
 	}
 }
 
+static void wacom_wac_pen_flush(struct wacom_wac *wacom_wac)
+{
+	struct hid_data *hid_data = &wacom_wac->hid_data;
+
+	if (!hid_data->pen_nvals)
+		return;
+
+	input_event_values(wacom_wac->pen_input, hid_data->pen_vals,
+			   hid_data->pen_nvals);
+	hid_data->pen_nvals = 0;
+}
+
+/*
+ * Pen events of a report are collected here and handed to the input
+ * core at once by wacom_wac_pen_report(), instead of taking the input
+ * device's event lock for each of them.
+ */
+static void wacom_wac_pen_queue(struct wacom_wac *wacom_wac, unsigned int type,
+				unsigned int code, int value)
+{
+	struct hid_data *hid_data = &wacom_wac->hid_data;
+
+	if (hid_data->pen_nvals == WACOM_PEN_VALS_MAX)
+		wacom_wac_pen_flush(wacom_wac);
+
+	hid_data->pen_vals[hid_data->pen_nvals++] =
+		(struct input_value) { type, code, value };
+}
+
 static void wacom_wac_pen_event(struct hid_device *hdev, struct hid_field *field,
 		struct hid_usage *usage, __s32 value)
 {
@@ -2400,9 +2429,9 @@ static void wacom_wac_pen_event(struct hid_device *hdev, struct hid_field *field
 
 	/* send pen events only when the pen is in range */
 	if (wacom_wac->hid_data.inrange_state)
-		input_event(input, usage->type, usage->code, value);
+		wacom_wac_pen_queue(wacom_wac, usage->type, usage->code, value);
 	else if (wacom_wac->shared->stylus_in_proximity && !wacom_wac->hid_data.sense_state)
-		input_event(input, usage->type, usage->code, 0);
+		wacom_wac_pen_queue(wacom_wac, usage->type, usage->code, 0);
 }
 
 static void wacom_wac_pen_pre_report(struct hid_device *hdev,
@@ -2420,12 +2449,13 @@ static void wacom_wac_pen_report(struct hid_device *hdev,
 {
 	struct wacom *wacom = hid_get_drvdata(hdev);
 	struct wacom_wac *wacom_wac = &wacom->wacom_wac;
-	struct input_dev *input = wacom_wac->pen_input;
 	bool range = wacom_wac->hid_data.inrange_state;
 	bool sense = wacom_wac->hid_data.sense_state;
 
-	if (wacom_wac->is_invalid_bt_frame)
+	if (wacom_wac->is_invalid_bt_frame) {
+		wacom_wac_pen_flush(wacom_wac);
 		return;
+	}
 
 	if (!wacom_wac->tool[0] && range) { /* first in range */
 		/* Going into range select tool */
@@ -2445,9 +2475,9 @@ static void wacom_wac_pen_report(struct hid_device *hdev,
 		int sw_state = wacom_wac->hid_data.barrelswitch |
 			       (wacom_wac->hid_data.barrelswitch2 << 1);
 
-		input_report_key(input, BTN_STYLUS, sw_state == 1);
-		input_report_key(input, BTN_STYLUS2, sw_state == 2);
-		input_report_key(input, BTN_STYLUS3, sw_state == 3);
+		wacom_wac_pen_queue(wacom_wac, EV_KEY, BTN_STYLUS, sw_state == 1);
+		wacom_wac_pen_queue(wacom_wac, EV_KEY, BTN_STYLUS2, sw_state == 2);
+		wacom_wac_pen_queue(wacom_wac, EV_KEY, BTN_STYLUS3, sw_state == 3);
 
 		/*
 		 * Non-USI EMR tools should have their IDs mangled to
@@ -2461,18 +2491,21 @@ static void wacom_wac_pen_report(struct hid_device *hdev,
 		 * report the BTN_TOOL_* event prior to the ABS_MISC or
 		 * MSC_SERIAL events.
 		 */
-		input_report_key(input, BTN_TOUCH,
-				wacom_wac->hid_data.tipswitch);
-		input_report_key(input, wacom_wac->tool[0], sense);
+		wacom_wac_pen_queue(wacom_wac, EV_KEY, BTN_TOUCH,
+				    wacom_wac->hid_data.tipswitch);
+		wacom_wac_pen_queue(wacom_wac, EV_KEY, wacom_wac->tool[0], sense);
 		if (wacom_wac->serial[0]) {
-			input_event(input, EV_MSC, MSC_SERIAL, wacom_wac->serial[0]);
-			input_report_abs(input, ABS_MISC, sense ? id : 0);
+			wacom_wac_pen_queue(wacom_wac, EV_MSC, MSC_SERIAL,
+					    wacom_wac->serial[0]);
+			wacom_wac_pen_queue(wacom_wac, EV_ABS, ABS_MISC,
+					    sense ? id : 0);
 		}
 
 		wacom_wac->hid_data.tipswitch = false;
 
-		input_sync(input);
+		wacom_wac_pen_queue(wacom_wac, EV_SYN, SYN_REPORT, 0);
 	}
+	wacom_wac_pen_flush(wacom_wac);
 
 	if (!sense) {
 		wacom_wac->tool[0] = 0;
@@ -2807,8 +2840,11 @@ static int wacom_wac_collection(struct hid_device *hdev, struct hid_report *repo
 	 * been called to prevent potential crashes in the report-
 	 * processing functions.
 	 */
-	if (report->type != HID_INPUT_REPORT)
+	if (report->type != HID_INPUT_REPORT) {
+		if (wacom->wacom_wac.pen_input)
+			wacom_wac_pen_flush(&wacom->wacom_wac);
 		return -1;
+	}
 
 	if (WACOM_PAD_FIELD(field))
 		return 0;
@@ -16,6 +16,9 @@
 #define WACOM_MAX_REMOTES	5
 #define WACOM_STATUS_UNKNOWN	255
 
+/* pen events buffered per report before they reach the input core */
+#define WACOM_PEN_VALS_MAX	32
+
 /* packet length for individual models */
 #define WACOM_PKGLEN_BBFUN	 9
 #define WACOM_PKGLEN_TPC1FG	 5
@@ -319,6 +322,8 @@ struct hid_data {
 	int bat_connected;
 	int ps_connected;
 	bool pad_input_event_flag;
+	unsigned int pen_nvals;
+	struct input_value pen_vals[WACOM_PEN_VALS_MAX];
 };
 
 struct wacom_remote_data {
@@ -59,6 +59,7 @@ static int apmpower_connect(struct input_handler *handler,
 	handle->dev = dev;
 	handle->handler = handler;
 	handle->name = "apm-power";
+	__set_bit(EV_PWR, handle->evbit);
 
 	error = input_register_handle(handle);
 	if (error) {
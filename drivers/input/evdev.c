@@ -11,7 +11,11 @@
 #define EVDEV_MINORS		32
 #define EVDEV_MIN_BUFFER_SIZE	64U
 #define EVDEV_BUF_PACKETS	8
+#define EVDEV_RING_MIN		64U
+#define EVDEV_RING_MAX		65536U
 
+#include <linux/debugfs.h>
+#include <linux/hrtimer.h>
 #include <linux/poll.h>
 #include <linux/sched.h>
 #include <linux/slab.h>
@@ -23,8 +27,13 @@
 #include <linux/major.h>
 #include <linux/device.h>
 #include <linux/cdev.h>
+#include <linux/seq_file.h>
+#include <linux/trace_fixed.h>
+#include <linux/uio.h>
 #include "input-compat.h"
 
+#include <trace/events/input.h>
+
 struct evdev {
 	int open;
 	struct input_handle handle;
@@ -34,9 +43,22 @@ struct evdev {
 	struct mutex mutex;
 	struct device dev;
 	struct cdev cdev;
+	struct dentry *debugfs;
 	bool exist;
 };
 
+/* EV_ABS updates coalesced for a client, see EVIOCSABSRATE */
+struct evdev_abs_rate {
+	struct evdev_client *client;
+	struct hrtimer timer;
+	ktime_t interval;
+	ktime_t next;		/* earliest delivery of a limited axis */
+	bool limited;		/* a limited axis is in the current packet */
+	DECLARE_BITMAP(mask, ABS_CNT);
+	DECLARE_BITMAP(pending, ABS_CNT);
+	s32 value[ABS_CNT];
+};
+
 struct evdev_client {
 	unsigned int head;
 	unsigned int tail;
@@ -49,6 +71,21 @@ struct evdev_client {
 	enum input_clock_type clk_type;
 	bool revoked;
 	unsigned long *evmasks[EV_CNT];
+	struct evdev_abs_rate *abs_rate;
+	/*
+	 * With a shared ring, head and packet_head are free running indices
+	 * into it instead of buffer, and ring_dropped queues a SYN_DROPPED.
+	 * The page is writable by userspace, so the record array and its
+	 * size are kept here and never read back from it.
+	 */
+	struct input_ring *ring;
+	struct input_ring_event *ring_data;
+	unsigned int ring_size;
+	bool ring_dropped;
+	/* statistics, see the evdev directory in debugfs */
+	struct pid *pid;
+	unsigned long wakeups;
+	unsigned long dropped;
 	unsigned int bufsize;
 	struct input_event buffer[];
 };
@@ -107,6 +144,10 @@ static void __evdev_flush_queue(struct evdev_client *client, unsigned int type)
 
 	BUG_ON(type == EV_SYN);
 
+	/* events in a shared ring belong to the client already */
+	if (client->ring)
+		return;
+
 	head = client->tail;
 	client->packet_head = client->tail;
 
@@ -142,10 +183,16 @@ static void __evdev_flush_queue(struct evdev_client *client, unsigned int type)
 
 static void __evdev_queue_syn_dropped(struct evdev_client *client)
 {
-	ktime_t *ev_time = input_get_timestamp(client->evdev->handle.dev);
-	struct timespec64 ts = ktime_to_timespec64(ev_time[client->clk_type]);
+	struct input_dev *dev = client->evdev->handle.dev;
+	struct timespec64 ts;
 	struct input_event ev;
 
+	if (client->ring) {
+		client->ring_dropped = true;
+		return;
+	}
+
+	ts = ktime_to_timespec64(input_get_timestamp_clk(dev, client->clk_type));
 	ev.input_event_sec = ts.tv_sec;
 	ev.input_event_usec = ts.tv_nsec / NSEC_PER_USEC;
 	ev.type = EV_SYN;
@@ -200,7 +247,11 @@ static int evdev_set_clk_type(struct evdev_client *client, unsigned int clkid)
 		 */
 		spin_lock_irqsave(&client->buffer_lock, flags);
 
-		if (client->head != client->tail) {
+		if (client->ring) {
+			/* a partially queued frame is in the old clock */
+			client->head = client->packet_head;
+			__evdev_queue_syn_dropped(client);
+		} else if (client->head != client->tail) {
 			client->packet_head = client->head = client->tail;
 			__evdev_queue_syn_dropped(client);
 		}
@@ -211,9 +262,57 @@ static int evdev_set_clk_type(struct evdev_client *client, unsigned int clkid)
 	return 0;
 }
 
+static void __evdev_ring_store(struct evdev_client *client,
+			       const struct input_event *event,
+			       unsigned int type, unsigned int code)
+{
+	struct input_ring_event *rec;
+
+	rec = &client->ring_data[client->head++ & (client->ring_size - 1)];
+	rec->sec = event->input_event_sec;
+	rec->usec = event->input_event_usec;
+	rec->type = type;
+	rec->code = code;
+	rec->value = type == event->type && code == event->code ?
+		     event->value : 0;
+}
+
+static void __evdev_ring_pass(struct evdev_client *client,
+			      const struct input_event *event)
+{
+	unsigned int tail = READ_ONCE(client->ring->tail);
+	unsigned int needed = client->ring_dropped ? 2 : 1;
+
+	if (client->head - tail + needed > client->ring_size) {
+		/* the client resyncs after SYN_DROPPED, drop the whole frame */
+		client->head = client->packet_head;
+		client->ring_dropped = true;
+		client->dropped++;
+		return;
+	}
+
+	if (client->ring_dropped) {
+		__evdev_ring_store(client, event, EV_SYN, SYN_DROPPED);
+		client->ring_dropped = false;
+	}
+
+	__evdev_ring_store(client, event, event->type, event->code);
+
+	if (event->type == EV_SYN && event->code == SYN_REPORT) {
+		client->packet_head = client->head;
+		smp_store_release(&client->ring->head, client->head);
+		kill_fasync(&client->fasync, SIGIO, POLL_IN);
+	}
+}
+
 static void __pass_event(struct evdev_client *client,
 			 const struct input_event *event)
 {
+	if (client->ring) {
+		__evdev_ring_pass(client, event);
+		return;
+	}
+
 	client->buffer[client->head++] = *event;
 	client->head &= client->bufsize - 1;
 
@@ -233,6 +332,7 @@ static void __pass_event(struct evdev_client *client,
 		};
 
 		client->packet_head = client->tail;
+		client->dropped++;
 	}
 
 	if (event->type == EV_SYN && event->code == SYN_REPORT) {
@@ -241,30 +341,186 @@ static void __pass_event(struct evdev_client *client,
 	}
 }
 
+/* queue the coalesced axis values, caller must hold client->buffer_lock */
+static void __evdev_pass_abs_pending(struct evdev_client *client,
+				     struct input_event *event)
+{
+	struct evdev_abs_rate *rate = client->abs_rate;
+	unsigned int code;
+
+	for_each_set_bit(code, rate->pending, ABS_CNT) {
+		event->type = EV_ABS;
+		event->code = code;
+		event->value = rate->value[code];
+		__pass_event(client, event);
+	}
+
+	bitmap_zero(rate->pending, ABS_CNT);
+	rate->limited = true;
+}
+
+/*
+ * Returns true if @v is a limited axis update that has to wait, in which
+ * case it is recorded. Caller must hold client->buffer_lock.
+ */
+static bool __evdev_abs_rate_defer(struct evdev_client *client,
+				   const struct input_value *v, ktime_t now)
+{
+	struct evdev_abs_rate *rate = client->abs_rate;
+
+	if (v->type != EV_ABS || v->code >= ABS_CNT ||
+	    !test_bit(v->code, rate->mask))
+		return false;
+
+	if (!ktime_before(now, rate->next)) {
+		__clear_bit(v->code, rate->pending);
+		rate->limited = true;
+		return false;
+	}
+
+	rate->value[v->code] = v->value;
+	__set_bit(v->code, rate->pending);
+	if (!hrtimer_is_queued(&rate->timer))
+		hrtimer_start(&rate->timer, rate->next, HRTIMER_MODE_ABS);
+
+	return true;
+}
+
+static ktime_t evdev_mono_to_clk(ktime_t mono, enum input_clock_type clk_type)
+{
+	switch (clk_type) {
+	case INPUT_CLK_REAL:
+		return ktime_mono_to_real(mono);
+	case INPUT_CLK_BOOT:
+		return ktime_mono_to_any(mono, TK_OFFS_BOOT);
+	default:
+		return mono;
+	}
+}
+
+/*
+ * Deliver the coalesced values in a frame of their own. Caller must hold
+ * client->buffer_lock, returns true if a frame was queued.
+ */
+static bool __evdev_abs_rate_flush(struct evdev_client *client)
+{
+	struct evdev_abs_rate *rate = client->abs_rate;
+	ktime_t now = ktime_get();
+	struct input_event event;
+	struct timespec64 ts;
+
+	/* never split a packet, the next SYN_REPORT will flush instead */
+	if (bitmap_empty(rate->pending, ABS_CNT) ||
+	    client->packet_head != client->head)
+		return false;
+
+	ts = ktime_to_timespec64(evdev_mono_to_clk(now, client->clk_type));
+	event.input_event_sec = ts.tv_sec;
+	event.input_event_usec = ts.tv_nsec / NSEC_PER_USEC;
+
+	__evdev_pass_abs_pending(client, &event);
+
+	event.type = EV_SYN;
+	event.code = SYN_REPORT;
+	event.value = 0;
+	__pass_event(client, &event);
+
+	rate->next = ktime_add(now, rate->interval);
+	rate->limited = false;
+
+	return true;
+}
+
+static enum hrtimer_restart evdev_abs_rate_timer(struct hrtimer *timer)
+{
+	struct evdev_abs_rate *rate = container_of(timer, struct evdev_abs_rate,
+						   timer);
+	struct evdev_client *client = rate->client;
+	unsigned long flags;
+	bool wakeup;
+
+	spin_lock_irqsave(&client->buffer_lock, flags);
+	wakeup = !client->revoked && __evdev_abs_rate_flush(client);
+	if (wakeup)
+		client->wakeups++;
+	spin_unlock_irqrestore(&client->buffer_lock, flags);
+
+	if (wakeup)
+		wake_up_interruptible_poll(&client->wait,
+			EPOLLIN | EPOLLOUT | EPOLLRDNORM | EPOLLWRNORM);
+
+	return HRTIMER_NORESTART;
+}
+
+/*
+ * Timestamp of the frame being passed to the clients, converted to
+ * seconds and microseconds at most once per clock.
+ */
+struct evdev_frame_time {
+	struct input_dev *dev;
+	ktime_t mono;
+	unsigned int valid;
+	time64_t sec[INPUT_CLK_MAX];
+	long usec[INPUT_CLK_MAX];
+};
+
+static void evdev_frame_stamp(struct evdev_frame_time *ft, int clk,
+			      struct input_event *event)
+{
+	struct timespec64 ts;
+
+	if (!(ft->valid & BIT(clk))) {
+		ts = ktime_to_timespec64(input_get_timestamp_clk(ft->dev, clk));
+		ft->sec[clk] = ts.tv_sec;
+		ft->usec[clk] = ts.tv_nsec / NSEC_PER_USEC;
+		ft->valid |= BIT(clk);
+	}
+
+	event->input_event_sec = ft->sec[clk];
+	event->input_event_usec = ft->usec[clk];
+}
+
 static void evdev_pass_values(struct evdev_client *client,
 			const struct input_value *vals, unsigned int count,
-			ktime_t *ev_time)
+			struct evdev_frame_time *ft)
 {
+	struct evdev_abs_rate *rate;
 	const struct input_value *v;
 	struct input_event event;
-	struct timespec64 ts;
 	bool wakeup = false;
 
 	if (client->revoked)
 		return;
 
-	ts = ktime_to_timespec64(ev_time[client->clk_type]);
-	event.input_event_sec = ts.tv_sec;
-	event.input_event_usec = ts.tv_nsec / NSEC_PER_USEC;
+	evdev_frame_stamp(ft, client->clk_type, &event);
 
 	/* Interrupts are disabled, just acquire the lock. */
 	spin_lock(&client->buffer_lock);
 
+	/* set by EVIOCSABSRATE under the buffer lock */
+	rate = client->abs_rate;
+
 	for (v = vals; v != vals + count; v++) {
 		if (__evdev_is_filtered(client, v->type, v->code))
 			continue;
 
+		if (rate && rate->interval &&
+		    __evdev_abs_rate_defer(client, v, ft->mono))
+			continue;
+
 		if (v->type == EV_SYN && v->code == SYN_REPORT) {
+			if (rate && rate->interval) {
+				if (!ktime_before(ft->mono, rate->next) &&
+				    !bitmap_empty(rate->pending, ABS_CNT))
+					__evdev_pass_abs_pending(client, &event);
+
+				if (rate->limited) {
+					rate->next = ktime_add(ft->mono,
+							       rate->interval);
+					rate->limited = false;
+				}
+			}
+
 			/* drop empty SYN_REPORT */
 			if (client->packet_head == client->head)
 				continue;
@@ -278,6 +534,9 @@ static void evdev_pass_values(struct evdev_client *client,
 		__pass_event(client, &event);
 	}
 
+	if (wakeup)
+		client->wakeups++;
+
 	spin_unlock(&client->buffer_lock);
 
 	if (wakeup)
@@ -293,21 +552,71 @@ static void evdev_events(struct input_handle *handle,
 {
 	struct evdev *evdev = handle->private;
 	struct evdev_client *client;
-	ktime_t *ev_time = input_get_timestamp(handle->dev);
+	struct evdev_frame_time ft = {
+		.dev = handle->dev,
+		.mono = input_get_timestamp_clk(handle->dev, INPUT_CLK_MONO),
+	};
 
 	rcu_read_lock();
 
 	client = rcu_dereference(evdev->grab);
 
 	if (client)
-		evdev_pass_values(client, vals, count, ev_time);
+		evdev_pass_values(client, vals, count, &ft);
 	else
 		list_for_each_entry_rcu(client, &evdev->client_list, node)
-			evdev_pass_values(client, vals, count, ev_time);
+			evdev_pass_values(client, vals, count, &ft);
 
 	rcu_read_unlock();
 }
 
+static bool evdev_client_wants(struct evdev_client *client,
+			       unsigned int type, unsigned int code)
+{
+	unsigned long flags;
+	bool wanted;
+
+	if (client->revoked)
+		return false;
+
+	spin_lock_irqsave(&client->buffer_lock, flags);
+	wanted = !__evdev_is_filtered(client, type, code);
+	spin_unlock_irqrestore(&client->buffer_lock, flags);
+
+	return wanted;
+}
+
+/*
+ * Tell whether any client still receives the given event, so that drivers
+ * can stop producing events all the clients mask.
+ */
+static bool evdev_wants(struct input_handle *handle,
+			unsigned int type, unsigned int code)
+{
+	struct evdev *evdev = handle->private;
+	struct evdev_client *client;
+	bool wanted = false;
+
+	rcu_read_lock();
+
+	client = rcu_dereference(evdev->grab);
+
+	if (client) {
+		wanted = evdev_client_wants(client, type, code);
+	} else {
+		list_for_each_entry_rcu(client, &evdev->client_list, node) {
+			if (evdev_client_wants(client, type, code)) {
+				wanted = true;
+				break;
+			}
+		}
+	}
+
+	rcu_read_unlock();
+
+	return wanted;
+}
+
 /*
  * Pass incoming event to all connected clients.
  */
@@ -350,6 +659,7 @@ static int evdev_grab(struct evdev *evdev, struct evdev_client *client)
 		return error;
 
 	rcu_assign_pointer(evdev->grab, client);
+	input_interest_changed(&evdev->handle);
 
 	return 0;
 }
@@ -365,6 +675,7 @@ static int evdev_ungrab(struct evdev *evdev, struct evdev_client *client)
 	rcu_assign_pointer(evdev->grab, NULL);
 	synchronize_rcu();
 	input_release_device(&evdev->handle);
+	input_interest_changed(&evdev->handle);
 
 	return 0;
 }
@@ -400,6 +711,9 @@ static int evdev_open_device(struct evdev *evdev)
 		retval = input_open_device(&evdev->handle);
 		if (retval)
 			evdev->open--;
+	} else {
+		/* the new client doesn't mask anything yet */
+		input_interest_changed(&evdev->handle);
 	}
 
 	mutex_unlock(&evdev->mutex);
@@ -412,6 +726,8 @@ static void evdev_close_device(struct evdev *evdev)
 
 	if (evdev->exist && !--evdev->open)
 		input_close_device(&evdev->handle);
+	else if (evdev->exist)
+		input_interest_changed(&evdev->handle);
 
 	mutex_unlock(&evdev->mutex);
 }
@@ -448,9 +764,17 @@ static int evdev_release(struct inode *inode, struct file *file)
 
 	evdev_detach_client(evdev, client);
 
+	if (client->abs_rate) {
+		hrtimer_cancel(&client->abs_rate->timer);
+		kfree(client->abs_rate);
+	}
+
+	vfree(client->ring);
+
 	for (i = 0; i < EV_CNT; ++i)
 		bitmap_free(client->evmasks[i]);
 
+	put_pid(client->pid);
 	kvfree(client);
 
 	evdev_close_device(evdev);
@@ -482,6 +806,7 @@ static int evdev_open(struct inode *inode, struct file *file)
 	client->bufsize = bufsize;
 	spin_lock_init(&client->buffer_lock);
 	client->evdev = evdev;
+	client->pid = get_pid(task_tgid(current));
 	evdev_attach_client(evdev, client);
 
 	error = evdev_open_device(evdev);
@@ -490,11 +815,13 @@ static int evdev_open(struct inode *inode, struct file *file)
 
 	file->private_data = client;
 	stream_open(inode, file);
+	file->f_mode |= FMODE_NOWAIT;
 
 	return 0;
 
  err_free_client:
 	evdev_detach_client(evdev, client);
+	put_pid(client->pid);
 	kvfree(client);
 	return error;
 }
@@ -555,11 +882,40 @@ static int evdev_fetch_next_event(struct evdev_client *client,
 	return have_event;
 }
 
-static ssize_t evdev_read(struct file *file, char __user *buffer,
-			  size_t count, loff_t *ppos)
+/*
+ * Report a SYN_REPORT handed to userspace. The event carries the frame
+ * timestamp in the client's clock, convert it back to CLOCK_MONOTONIC.
+ */
+static void evdev_trace_frame_read(struct evdev_client *client,
+				   const struct input_event *event)
 {
+	ktime_t now, offset, stamp;
+
+	if (!trace_input_frame_read_enabled() ||
+	    event->type != EV_SYN || event->code != SYN_REPORT)
+		return;
+
+	now = ktime_get();
+	offset = ktime_sub(evdev_mono_to_clk(now, client->clk_type), now);
+	stamp = ktime_set(event->input_event_sec,
+			  event->input_event_usec * NSEC_PER_USEC);
+	trace_input_frame_read(client->evdev->handle.dev,
+			       ktime_sub(stamp, offset));
+}
+
+/*
+ * Reads never block when the file is O_NONBLOCK or the caller asks for
+ * IOCB_NOWAIT, which lets io_uring complete reads inline and fall back
+ * to poll when the queue is empty.
+ */
+static ssize_t evdev_read_iter(struct kiocb *iocb, struct iov_iter *to)
+{
+	struct file *file = iocb->ki_filp;
 	struct evdev_client *client = file->private_data;
 	struct evdev *evdev = client->evdev;
+	size_t count = iov_iter_count(to);
+	bool nonblock = (file->f_flags & O_NONBLOCK) ||
+			(iocb->ki_flags & IOCB_NOWAIT);
 	struct input_event event;
 	size_t read = 0;
 	int error;
@@ -567,12 +923,14 @@ static ssize_t evdev_read(struct file *file, char __user *buffer,
 	if (count != 0 && count < input_event_size())
 		return -EINVAL;
 
+	if (READ_ONCE(client->ring))
+		return -EINVAL;
+
 	for (;;) {
 		if (!evdev->exist || client->revoked)
 			return -ENODEV;
 
-		if (client->packet_head == client->tail &&
-		    (file->f_flags & O_NONBLOCK))
+		if (client->packet_head == client->tail && nonblock)
 			return -EAGAIN;
 
 		/*
@@ -585,16 +943,17 @@ static ssize_t evdev_read(struct file *file, char __user *buffer,
 		while (read + input_event_size() <= count &&
 		       evdev_fetch_next_event(client, &event)) {
 
-			if (input_event_to_user(buffer + read, &event))
+			if (input_event_to_iter(to, &event))
 				return -EFAULT;
 
+			evdev_trace_frame_read(client, &event);
 			read += input_event_size();
 		}
 
 		if (read)
 			break;
 
-		if (!(file->f_flags & O_NONBLOCK)) {
+		if (!nonblock) {
 			error = wait_event_interruptible(client->wait,
 					client->packet_head != client->tail ||
 					!evdev->exist || client->revoked);
@@ -603,6 +962,14 @@ static ssize_t evdev_read(struct file *file, char __user *buffer,
 		}
 	}
 
+	if (read) {
+		struct input_dev *dev = evdev->handle.dev;
+
+		trace_fixed(TRACE_FIXED_INPUT_READ,
+			    dev->id.vendor << 16 | dev->id.product,
+			    read / input_event_size(), 0, 0);
+	}
+
 	return read;
 }
 
@@ -620,12 +987,28 @@ static __poll_t evdev_poll(struct file *file, poll_table *wait)
 	else
 		mask = EPOLLHUP | EPOLLERR;
 
-	if (client->packet_head != client->tail)
+	if (client->ring) {
+		if (smp_load_acquire(&client->ring->head) !=
+		    READ_ONCE(client->ring->tail))
+			mask |= EPOLLIN | EPOLLRDNORM;
+	} else if (client->packet_head != client->tail) {
 		mask |= EPOLLIN | EPOLLRDNORM;
+	}
 
 	return mask;
 }
 
+static int evdev_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct evdev_client *client = file->private_data;
+	struct input_ring *ring = READ_ONCE(client->ring);
+
+	if (!ring)
+		return -EINVAL;
+
+	return remap_vmalloc_range(vma, ring, vma->vm_pgoff);
+}
+
 #ifdef CONFIG_COMPAT
 
 #define BITS_PER_LONG_COMPAT (sizeof(compat_long_t) * 8)
@@ -940,12 +1323,100 @@ static int evdev_handle_mt_request(struct input_dev *dev,
 	return 0;
 }
 
+/*
+ * Like evdev_handle_get_val(), for all the state at once. The snapshot is
+ * taken under event_lock, so no frame is half in it.
+ */
+static int evdev_handle_get_state(struct evdev_client *client,
+				  struct input_dev *dev, void __user *p)
+{
+	const struct input_mt *mt = dev->mt;
+	struct input_state *state;
+	void __user *mt_ptr;
+	unsigned int nslots = 0;
+	int *mt_vals = NULL;
+	size_t mt_size;
+	unsigned int i;
+	int ret = 0;
+
+	state = kzalloc(sizeof(*state), GFP_KERNEL);
+	if (!state)
+		return -ENOMEM;
+
+	if (copy_from_user(state, p, offsetof(struct input_state, key))) {
+		ret = -EFAULT;
+		goto out;
+	}
+
+	if (state->flags & ~INPUT_STATE_MT) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	if (state->flags & INPUT_STATE_MT) {
+		if (!mt) {
+			ret = -EINVAL;
+			goto out;
+		}
+
+		nslots = min_t(unsigned int, state->mt_slots, mt->num_slots);
+		if (nslots) {
+			mt_vals = kcalloc(nslots, sizeof(mt->slots[0].abs),
+					  GFP_KERNEL);
+			if (!mt_vals) {
+				ret = -ENOMEM;
+				goto out;
+			}
+		}
+	}
+
+	mt_ptr = (void __user *)(unsigned long)state->mt_ptr;
+	mt_size = nslots * sizeof(mt->slots[0].abs);
+	state->mt_slots = nslots;
+
+	spin_lock_irq(&dev->event_lock);
+	spin_lock(&client->buffer_lock);
+
+	bitmap_to_arr32(state->key, dev->key, KEY_CNT);
+	bitmap_to_arr32(state->led, dev->led, LED_CNT);
+	bitmap_to_arr32(state->sw, dev->sw, SW_CNT);
+
+	if (dev->absinfo)
+		for (i = 0; i < ABS_CNT; i++)
+			state->abs[i] = dev->absinfo[i].value;
+
+	for (i = 0; i < nslots; i++)
+		memcpy(&mt_vals[i * ARRAY_SIZE(mt->slots[0].abs)],
+		       mt->slots[i].abs, sizeof(mt->slots[i].abs));
+
+	spin_unlock(&dev->event_lock);
+
+	__evdev_flush_queue(client, EV_KEY);
+	__evdev_flush_queue(client, EV_LED);
+	__evdev_flush_queue(client, EV_SW);
+	__evdev_flush_queue(client, EV_ABS);
+
+	spin_unlock_irq(&client->buffer_lock);
+
+	if (copy_to_user(p, state, sizeof(*state)) ||
+	    (mt_size && copy_to_user(mt_ptr, mt_vals, mt_size))) {
+		evdev_queue_syn_dropped(client);
+		ret = -EFAULT;
+	}
+
+out:
+	kfree(mt_vals);
+	kfree(state);
+	return ret;
+}
+
 static int evdev_revoke(struct evdev *evdev, struct evdev_client *client,
 			struct file *file)
 {
 	client->revoked = true;
 	evdev_ungrab(evdev, client);
 	input_flush_device(&evdev->handle, file);
+	input_interest_changed(&evdev->handle);
 	wake_up_interruptible_poll(&client->wait, EPOLLHUP | EPOLLERR);
 
 	return 0;
@@ -984,6 +1455,94 @@ static int evdev_set_mask(struct evdev_client *client,
 
 	bitmap_free(oldmask);
 
+	input_interest_changed(&client->evdev->handle);
+
+	return 0;
+}
+
+/* must be called with evdev-mutex held */
+static int evdev_set_ring(struct evdev_client *client, unsigned int size)
+{
+	struct input_ring *ring;
+	unsigned long flags;
+
+	if (!is_power_of_2(size) || size < EVDEV_RING_MIN ||
+	    size > EVDEV_RING_MAX)
+		return -EINVAL;
+
+	if (client->ring)
+		return -EBUSY;
+
+	ring = vmalloc_user(PAGE_SIZE + size * sizeof(struct input_ring_event));
+	if (!ring)
+		return -ENOMEM;
+
+	ring->size = size;
+	ring->data_offset = PAGE_SIZE;
+
+	spin_lock_irqsave(&client->buffer_lock, flags);
+	/* what was queued for read() is lost, let the client resync */
+	client->ring_dropped = client->tail != client->head;
+	client->head = client->tail = client->packet_head = 0;
+	client->ring_data = (void *)ring + PAGE_SIZE;
+	client->ring_size = size;
+	WRITE_ONCE(client->ring, ring);
+	spin_unlock_irqrestore(&client->buffer_lock, flags);
+
+	return 0;
+}
+
+/* must be called with evdev-mutex held */
+static int evdev_set_abs_rate(struct evdev_client *client,
+			      const struct input_abs_rate *req, int compat)
+{
+	const void __user *codes = (const void __user *)(unsigned long)req->codes_ptr;
+	struct evdev_abs_rate *rate = client->abs_rate;
+	DECLARE_BITMAP(mask, ABS_CNT);
+	unsigned long flags;
+	unsigned int code;
+	bool wakeup;
+	int error;
+
+	bitmap_zero(mask, ABS_CNT);
+	if (req->interval_us) {
+		error = bits_from_user(mask, ABS_MAX, req->codes_size, codes,
+				       compat);
+		if (error < 0)
+			return error;
+
+		for_each_set_bit(code, mask, ABS_CNT)
+			if (input_is_mt_axis(code))
+				return -EINVAL;
+	}
+
+	if (!rate) {
+		if (!req->interval_us)
+			return 0;
+
+		rate = kzalloc(sizeof(*rate), GFP_KERNEL);
+		if (!rate)
+			return -ENOMEM;
+
+		rate->client = client;
+		hrtimer_init(&rate->timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+		rate->timer.function = evdev_abs_rate_timer;
+	}
+
+	spin_lock_irqsave(&client->buffer_lock, flags);
+	client->abs_rate = rate;
+	/* deliver what was held back under the old limit */
+	wakeup = __evdev_abs_rate_flush(client);
+	bitmap_zero(rate->pending, ABS_CNT);
+	bitmap_copy(rate->mask, mask, ABS_CNT);
+	rate->interval = us_to_ktime(req->interval_us);
+	rate->next = 0;
+	spin_unlock_irqrestore(&client->buffer_lock, flags);
+
+	if (wakeup)
+		wake_up_interruptible_poll(&client->wait,
+			EPOLLIN | EPOLLOUT | EPOLLRDNORM | EPOLLWRNORM);
+
 	return 0;
 }
 
@@ -1034,6 +1593,7 @@ static long evdev_do_ioctl(struct file *file, unsigned int cmd,
 	struct input_dev *dev = evdev->handle.dev;
 	struct input_absinfo abs;
 	struct input_mask mask;
+	struct input_abs_rate abs_rate;
 	struct ff_effect effect;
 	int __user *ip = (int __user *)p;
 	unsigned int i, t, u, v;
@@ -1125,6 +1685,21 @@ static long evdev_do_ioctl(struct file *file, unsigned int cmd,
 
 		return evdev_set_clk_type(client, i);
 
+	case EVIOCSABSRATE:
+		if (copy_from_user(&abs_rate, p, sizeof(abs_rate)))
+			return -EFAULT;
+
+		return evdev_set_abs_rate(client, &abs_rate, compat_mode);
+
+	case EVIOCSRING:
+		if (get_user(u, ip))
+			return -EFAULT;
+
+		return evdev_set_ring(client, u);
+
+	case EVIOCGSTATE:
+		return evdev_handle_get_state(client, dev, p);
+
 	case EVIOCGKEYCODE:
 		return evdev_handle_get_keycode(dev, p);
 
@@ -1289,11 +1864,31 @@ static long evdev_ioctl_compat(struct file *file,
 }
 #endif
 
+static int evdev_clients_show(struct seq_file *s, void *unused)
+{
+	struct evdev *evdev = s->private;
+	struct evdev_client *client;
+
+	/* one line per open file: pid, wakeups, dropped events */
+	spin_lock(&evdev->client_lock);
+	list_for_each_entry(client, &evdev->client_list, node)
+		seq_printf(s, "%d %lu %lu\n", pid_nr(client->pid),
+			   READ_ONCE(client->wakeups),
+			   READ_ONCE(client->dropped));
+	spin_unlock(&evdev->client_lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(evdev_clients);
+
+static struct dentry *evdev_debugfs_root;
+
 static const struct file_operations evdev_fops = {
 	.owner		= THIS_MODULE,
-	.read		= evdev_read,
+	.read_iter	= evdev_read_iter,
 	.write		= evdev_write,
 	.poll		= evdev_poll,
+	.mmap		= evdev_mmap,
 	.open		= evdev_open,
 	.release	= evdev_release,
 	.unlocked_ioctl	= evdev_ioctl,
@@ -1387,6 +1982,10 @@ static int evdev_connect(struct input_handler *handler, struct input_dev *dev,
 	if (error)
 		goto err_cleanup_evdev;
 
+	evdev->debugfs = debugfs_create_file(dev_name(&evdev->dev), 0444,
+					     evdev_debugfs_root, evdev,
+					     &evdev_clients_fops);
+
 	return 0;
 
  err_cleanup_evdev:
@@ -1403,6 +2002,7 @@ static void evdev_disconnect(struct input_handle *handle)
 {
 	struct evdev *evdev = handle->private;
 
+	debugfs_remove(evdev->debugfs);
 	cdev_device_del(&evdev->cdev, &evdev->dev);
 	evdev_cleanup(evdev);
 	input_free_minor(MINOR(evdev->dev.devt));
@@ -1420,6 +2020,7 @@ MODULE_DEVICE_TABLE(input, evdev_ids);
 static struct input_handler evdev_handler = {
 	.event		= evdev_event,
 	.events		= evdev_events,
+	.wants		= evdev_wants,
 	.connect	= evdev_connect,
 	.disconnect	= evdev_disconnect,
 	.legacy_minors	= true,
@@ -1430,12 +2031,21 @@ static struct input_handler evdev_handler = {
 
 static int __init evdev_init(void)
 {
-	return input_register_handler(&evdev_handler);
+	int error;
+
+	evdev_debugfs_root = debugfs_create_dir("evdev", NULL);
+
+	error = input_register_handler(&evdev_handler);
+	if (error)
+		debugfs_remove_recursive(evdev_debugfs_root);
+
+	return error;
 }
 
 static void __exit evdev_exit(void)
 {
 	input_unregister_handler(&evdev_handler);
+	debugfs_remove_recursive(evdev_debugfs_root);
 }
 
 module_init(evdev_init);
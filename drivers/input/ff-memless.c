@@ -19,6 +19,7 @@
 #include <linux/mutex.h>
 #include <linux/spinlock.h>
 #include <linux/jiffies.h>
+#include <linux/hrtimer.h>
 #include <linux/fixp-arith.h>
 
 MODULE_LICENSE("GPL");
@@ -39,9 +40,9 @@ struct ml_effect_state {
 	struct ff_effect *effect;
 	unsigned long flags;	/* effect state (STARTED, PLAYING, etc) */
 	int count;		/* loop count of the effect */
-	unsigned long play_at;	/* start time */
-	unsigned long stop_at;	/* stop time */
-	unsigned long adj_at;	/* last time the effect was sent */
+	ktime_t play_at;	/* start time */
+	ktime_t stop_at;	/* stop time */
+	ktime_t adj_at;		/* last time the effect was sent */
 };
 
 struct ml_device {
@@ -51,6 +52,13 @@ struct ml_device {
 	struct timer_list timer;
 	struct input_dev *dev;
 
+	/* see input_ff_memless_set_period() */
+	bool hr;
+	struct hrtimer hrtimer;
+	ktime_t interval;	/* envelope update interval */
+	ktime_t period;		/* minimum time between timed updates */
+	ktime_t played_at;	/* last time an effect was sent */
+
 	int (*play_effect)(struct input_dev *dev, void *data,
 			   struct ff_effect *effect);
 };
@@ -74,32 +82,31 @@ static const struct ff_envelope *get_envelope(const struct ff_effect *effect)
 /*
  * Check for the next time envelope requires an update on memoryless devices
  */
-static unsigned long calculate_next_time(struct ml_effect_state *state)
+static ktime_t calculate_next_time(struct ml_device *ml,
+				   struct ml_effect_state *state)
 {
 	const struct ff_envelope *envelope = get_envelope(state->effect);
-	unsigned long attack_stop, fade_start, next_fade;
+	ktime_t attack_stop, fade_start, next_fade;
 
 	if (envelope->attack_length) {
-		attack_stop = state->play_at +
-			msecs_to_jiffies(envelope->attack_length);
-		if (time_before(state->adj_at, attack_stop))
-			return state->adj_at +
-					msecs_to_jiffies(FF_ENVELOPE_INTERVAL);
+		attack_stop = ktime_add_ms(state->play_at,
+					   envelope->attack_length);
+		if (ktime_before(state->adj_at, attack_stop))
+			return ktime_add(state->adj_at, ml->interval);
 	}
 
 	if (state->effect->replay.length) {
 		if (envelope->fade_length) {
 			/* check when fading should start */
-			fade_start = state->stop_at -
-					msecs_to_jiffies(envelope->fade_length);
+			fade_start = ktime_sub_ms(state->stop_at,
+						  envelope->fade_length);
 
-			if (time_before(state->adj_at, fade_start))
+			if (ktime_before(state->adj_at, fade_start))
 				return fade_start;
 
 			/* already fading, advance to next checkpoint */
-			next_fade = state->adj_at +
-					msecs_to_jiffies(FF_ENVELOPE_INTERVAL);
-			if (time_before(next_fade, state->stop_at))
+			next_fade = ktime_add(state->adj_at, ml->interval);
+			if (ktime_before(next_fade, state->stop_at))
 				return next_fade;
 		}
 
@@ -109,12 +116,32 @@ static unsigned long calculate_next_time(struct ml_effect_state *state)
 	return state->play_at;
 }
 
+static void ml_start_timer(struct ml_device *ml, ktime_t at, ktime_t now)
+{
+	if (ml->hr) {
+		/* Do not update the device more often than it can take. */
+		at = max(at, ktime_add(ml->played_at, ml->period));
+		hrtimer_start(&ml->hrtimer, at, HRTIMER_MODE_ABS_SOFT);
+	} else {
+		mod_timer(&ml->timer,
+			  jiffies + usecs_to_jiffies(ktime_us_delta(at, now)));
+	}
+}
+
+static void ml_stop_timer(struct ml_device *ml)
+{
+	if (ml->hr)
+		hrtimer_try_to_cancel(&ml->hrtimer);
+	else
+		del_timer(&ml->timer);
+}
+
 static void ml_schedule_timer(struct ml_device *ml)
 {
 	struct ml_effect_state *state;
-	unsigned long now = jiffies;
-	unsigned long earliest = 0;
-	unsigned long next_at;
+	ktime_t now = ktime_get();
+	ktime_t earliest = 0;
+	ktime_t next_at;
 	int events = 0;
 	int i;
 
@@ -128,21 +155,21 @@ static void ml_schedule_timer(struct ml_device *ml)
 			continue;
 
 		if (test_bit(FF_EFFECT_PLAYING, &state->flags))
-			next_at = calculate_next_time(state);
+			next_at = calculate_next_time(ml, state);
 		else
 			next_at = state->play_at;
 
-		if (time_before_eq(now, next_at) &&
-		    (++events == 1 || time_before(next_at, earliest)))
+		if (!ktime_after(now, next_at) &&
+		    (++events == 1 || ktime_before(next_at, earliest)))
 			earliest = next_at;
 	}
 
 	if (!events) {
 		pr_debug("no actions\n");
-		del_timer(&ml->timer);
+		ml_stop_timer(ml);
 	} else {
 		pr_debug("timer set\n");
-		mod_timer(&ml->timer, earliest);
+		ml_start_timer(ml, earliest, now);
 	}
 }
 
@@ -153,26 +180,26 @@ static int apply_envelope(struct ml_effect_state *state, int value,
 			  struct ff_envelope *envelope)
 {
 	struct ff_effect *effect = state->effect;
-	unsigned long now = jiffies;
+	ktime_t now = ktime_get();
 	int time_from_level;
 	int time_of_envelope;
 	int envelope_level;
 	int difference;
 
 	if (envelope->attack_length &&
-	    time_before(now,
-			state->play_at + msecs_to_jiffies(envelope->attack_length))) {
+	    ktime_before(now,
+			 ktime_add_ms(state->play_at, envelope->attack_length))) {
 		pr_debug("value = 0x%x, attack_level = 0x%x\n",
 			 value, envelope->attack_level);
-		time_from_level = jiffies_to_msecs(now - state->play_at);
+		time_from_level = ktime_ms_delta(now, state->play_at);
 		time_of_envelope = envelope->attack_length;
 		envelope_level = min_t(u16, envelope->attack_level, 0x7fff);
 
 	} else if (envelope->fade_length && effect->replay.length &&
-		   time_after(now,
-			      state->stop_at - msecs_to_jiffies(envelope->fade_length)) &&
-		   time_before(now, state->stop_at)) {
-		time_from_level = jiffies_to_msecs(state->stop_at - now);
+		   ktime_after(now,
+			       ktime_sub_ms(state->stop_at, envelope->fade_length)) &&
+		   ktime_before(now, state->stop_at)) {
+		time_from_level = ktime_ms_delta(state->stop_at, now);
 		time_of_envelope = envelope->fade_length;
 		envelope_level = min_t(u16, envelope->fade_level, 0x7fff);
 	} else
@@ -329,6 +356,7 @@ static int ml_get_combo_effect(struct ml_device *ml,
 {
 	struct ff_effect *effect;
 	struct ml_effect_state *state;
+	ktime_t now = ktime_get();
 	int effect_type;
 	int i;
 
@@ -344,7 +372,7 @@ static int ml_get_combo_effect(struct ml_device *ml,
 		if (!test_bit(FF_EFFECT_STARTED, &state->flags))
 			continue;
 
-		if (time_before(jiffies, state->play_at))
+		if (ktime_before(now, state->play_at))
 			continue;
 
 		/*
@@ -365,21 +393,21 @@ static int ml_get_combo_effect(struct ml_device *ml,
 			__clear_bit(FF_EFFECT_PLAYING, &state->flags);
 			__clear_bit(FF_EFFECT_STARTED, &state->flags);
 		} else if (effect->replay.length &&
-			   time_after_eq(jiffies, state->stop_at)) {
+			   !ktime_before(now, state->stop_at)) {
 
 			__clear_bit(FF_EFFECT_PLAYING, &state->flags);
 
 			if (--state->count <= 0) {
 				__clear_bit(FF_EFFECT_STARTED, &state->flags);
 			} else {
-				state->play_at = jiffies +
-					msecs_to_jiffies(effect->replay.delay);
-				state->stop_at = state->play_at +
-					msecs_to_jiffies(effect->replay.length);
+				state->play_at = ktime_add_ms(now,
+						effect->replay.delay);
+				state->stop_at = ktime_add_ms(state->play_at,
+						effect->replay.length);
 			}
 		} else {
 			__set_bit(FF_EFFECT_PLAYING, &state->flags);
-			state->adj_at = jiffies;
+			state->adj_at = now;
 			ml_combine_effects(combo_effect, state, ml->gain);
 		}
 	}
@@ -394,8 +422,11 @@ static void ml_play_effects(struct ml_device *ml)
 
 	memset(handled_bm, 0, sizeof(handled_bm));
 
-	while (ml_get_combo_effect(ml, handled_bm, &effect))
+	while (ml_get_combo_effect(ml, handled_bm, &effect)) {
 		ml->play_effect(ml->dev, ml->private, &effect);
+		if (ml->hr)
+			ml->played_at = ktime_get();
+	}
 
 	ml_schedule_timer(ml);
 }
@@ -413,6 +444,21 @@ static void ml_effect_timer(struct timer_list *t)
 	spin_unlock_irqrestore(&dev->event_lock, flags);
 }
 
+static enum hrtimer_restart ml_effect_hrtimer(struct hrtimer *t)
+{
+	struct ml_device *ml = container_of(t, struct ml_device, hrtimer);
+	struct input_dev *dev = ml->dev;
+	unsigned long flags;
+
+	pr_debug("hrtimer: updating effects\n");
+
+	spin_lock_irqsave(&dev->event_lock, flags);
+	ml_play_effects(ml);
+	spin_unlock_irqrestore(&dev->event_lock, flags);
+
+	return HRTIMER_NORESTART;
+}
+
 /*
  * Sets requested gain for FF effects. Called with dev->event_lock held.
  */
@@ -442,10 +488,10 @@ static int ml_ff_playback(struct input_dev *dev, int effect_id, int value)
 
 		__set_bit(FF_EFFECT_STARTED, &state->flags);
 		state->count = value;
-		state->play_at = jiffies +
-				 msecs_to_jiffies(state->effect->replay.delay);
-		state->stop_at = state->play_at +
-				 msecs_to_jiffies(state->effect->replay.length);
+		state->play_at = ktime_add_ms(ktime_get(),
+					      state->effect->replay.delay);
+		state->stop_at = ktime_add_ms(state->play_at,
+					      state->effect->replay.length);
 		state->adj_at = state->play_at;
 
 	} else {
@@ -472,10 +518,10 @@ static int ml_ff_upload(struct input_dev *dev,
 
 	if (test_bit(FF_EFFECT_STARTED, &state->flags)) {
 		__clear_bit(FF_EFFECT_PLAYING, &state->flags);
-		state->play_at = jiffies +
-				 msecs_to_jiffies(state->effect->replay.delay);
-		state->stop_at = state->play_at +
-				 msecs_to_jiffies(state->effect->replay.length);
+		state->play_at = ktime_add_ms(ktime_get(),
+					      state->effect->replay.delay);
+		state->stop_at = ktime_add_ms(state->play_at,
+					      state->effect->replay.length);
 		state->adj_at = state->play_at;
 		ml_schedule_timer(ml);
 	}
@@ -497,6 +543,7 @@ static void ml_ff_destroy(struct ff_device *ff)
 	 * do it here.
 	 */
 	del_timer_sync(&ml->timer);
+	hrtimer_cancel(&ml->hrtimer);
 
 	kfree(ml->private);
 }
@@ -523,7 +570,10 @@ int input_ff_create_memless(struct input_dev *dev, void *data,
 	ml->private = data;
 	ml->play_effect = play_effect;
 	ml->gain = 0xffff;
+	ml->interval = ms_to_ktime(FF_ENVELOPE_INTERVAL);
 	timer_setup(&ml->timer, ml_effect_timer, 0);
+	hrtimer_init(&ml->hrtimer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS_SOFT);
+	ml->hrtimer.function = ml_effect_hrtimer;
 
 	set_bit(FF_GAIN, dev->ffbit);
 
@@ -554,3 +604,25 @@ int input_ff_create_memless(struct input_dev *dev, void *data,
 	return 0;
 }
 EXPORT_SYMBOL_GPL(input_ff_create_memless);
+
+/**
+ * input_ff_memless_set_period() - schedule effect updates precisely
+ * @dev: input device set up with input_ff_create_memless()
+ * @period_us: shortest time between two timed updates, in microseconds
+ *
+ * By default replay and envelope steps are scheduled with a jiffies
+ * timer, so they are rounded to the timer tick and envelopes are only
+ * updated every 50 ms. After this call an hrtimer is used instead, and
+ * envelopes are updated every @period_us, which should match how often
+ * the device can take a new state. Must be called before the device is
+ * registered.
+ */
+void input_ff_memless_set_period(struct input_dev *dev, unsigned int period_us)
+{
+	struct ml_device *ml = dev->ff->private;
+
+	ml->hr = true;
+	ml->period = us_to_ktime(max(period_us, 1U));
+	ml->interval = ml->period;
+}
+EXPORT_SYMBOL_GPL(input_ff_memless_set_period);
@@ -7,6 +7,7 @@
 
 #include <linux/export.h>
 #include <linux/uaccess.h>
+#include <linux/uio.h>
 #include "input-compat.h"
 
 #ifdef CONFIG_COMPAT
@@ -59,6 +60,30 @@ int input_event_to_user(char __user *buffer,
 	return 0;
 }
 
+int input_event_to_iter(struct iov_iter *to, const struct input_event *event)
+{
+	if (in_compat_syscall() && !COMPAT_USE_64BIT_TIME) {
+		struct input_event_compat compat_event;
+
+		compat_event.sec = event->input_event_sec;
+		compat_event.usec = event->input_event_usec;
+		compat_event.type = event->type;
+		compat_event.code = event->code;
+		compat_event.value = event->value;
+
+		if (copy_to_iter(&compat_event, sizeof(compat_event), to) !=
+		    sizeof(compat_event))
+			return -EFAULT;
+
+	} else {
+		if (copy_to_iter(event, sizeof(struct input_event), to) !=
+		    sizeof(struct input_event))
+			return -EFAULT;
+	}
+
+	return 0;
+}
+
 int input_ff_effect_from_user(const char __user *buffer, size_t size,
 			      struct ff_effect *effect)
 {
@@ -114,6 +139,15 @@ int input_event_to_user(char __user *buffer,
 	return 0;
 }
 
+int input_event_to_iter(struct iov_iter *to, const struct input_event *event)
+{
+	if (copy_to_iter(event, sizeof(struct input_event), to) !=
+	    sizeof(struct input_event))
+		return -EFAULT;
+
+	return 0;
+}
+
 int input_ff_effect_from_user(const char __user *buffer, size_t size,
 			      struct ff_effect *effect)
 {
@@ -130,4 +164,5 @@ int input_ff_effect_from_user(const char __user *buffer, size_t size,
 
 EXPORT_SYMBOL_GPL(input_event_from_user);
 EXPORT_SYMBOL_GPL(input_event_to_user);
+EXPORT_SYMBOL_GPL(input_event_to_iter);
 EXPORT_SYMBOL_GPL(input_ff_effect_from_user);
@@ -105,6 +105,8 @@ static int input_leds_connect(struct input_handler *handler,
 	leds->handle.handler = handler;
 	leds->handle.name = "leds";
 	leds->handle.private = leds;
+	/* nothing is read back, only keep the handle out of other frames */
+	__set_bit(EV_LED, leds->handle.evbit);
 
 	error = input_register_handle(&leds->handle);
 	if (error)
@@ -4,9 +4,13 @@
  */
 
 #include <linux/device.h>
+#include <linux/fast_clock.h>
+#include <linux/hrtimer.h>
 #include <linux/input.h>
 #include <linux/jiffies.h>
+#include <linux/kthread.h>
 #include <linux/mutex.h>
+#include <linux/sched.h>
 #include <linux/slab.h>
 #include <linux/types.h>
 #include <linux/workqueue.h>
@@ -21,12 +25,42 @@ struct input_dev_poller {
 
 	struct input_dev *input;
 	struct delayed_work work;
+
+	/* hrtimer mode, see input_set_poll_hrtimer() */
+	struct kthread_worker *worker;
+	struct kthread_work kwork;
+	struct hrtimer timer;
+
+	u64 last_poll; /* fast_clock_now() of the last poll, 0 if none */
+	u64 achieved; /* nsec, running average of the time between polls */
 };
 
+static void input_dev_poller_poll(struct input_dev_poller *poller)
+{
+	u64 now = fast_clock_now();
+	u64 delta;
+
+	if (poller->last_poll) {
+		delta = fast_clock_to_ns(now - poller->last_poll);
+		poller->achieved = poller->achieved ?
+				   (poller->achieved * 7 + delta) >> 3 : delta;
+	}
+	poller->last_poll = now;
+
+	poller->poll(poller->input);
+}
+
 static void input_dev_poller_queue_work(struct input_dev_poller *poller)
 {
 	unsigned long delay;
 
+	if (poller->worker) {
+		hrtimer_start(&poller->timer,
+			      ms_to_ktime(poller->poll_interval),
+			      HRTIMER_MODE_REL);
+		return;
+	}
+
 	delay = msecs_to_jiffies(poller->poll_interval);
 	if (delay >= HZ)
 		delay = round_jiffies_relative(delay);
@@ -34,15 +68,45 @@ static void input_dev_poller_queue_work(struct input_dev_poller *poller)
 	queue_delayed_work(system_freezable_wq, &poller->work, delay);
 }
 
+static void input_dev_poller_cancel_work(struct input_dev_poller *poller)
+{
+	if (poller->worker) {
+		hrtimer_cancel(&poller->timer);
+		kthread_cancel_work_sync(&poller->kwork);
+	} else {
+		cancel_delayed_work_sync(&poller->work);
+	}
+}
+
 static void input_dev_poller_work(struct work_struct *work)
 {
 	struct input_dev_poller *poller =
 		container_of(work, struct input_dev_poller, work.work);
 
-	poller->poll(poller->input);
+	input_dev_poller_poll(poller);
 	input_dev_poller_queue_work(poller);
 }
 
+static void input_dev_poller_kwork(struct kthread_work *work)
+{
+	struct input_dev_poller *poller =
+		container_of(work, struct input_dev_poller, kwork);
+
+	input_dev_poller_poll(poller);
+}
+
+static enum hrtimer_restart input_dev_poller_timer(struct hrtimer *timer)
+{
+	struct input_dev_poller *poller =
+		container_of(timer, struct input_dev_poller, timer);
+
+	/* A poll still running when the timer fires is not queued twice. */
+	kthread_queue_work(poller->worker, &poller->kwork);
+	hrtimer_forward_now(timer, ms_to_ktime(READ_ONCE(poller->poll_interval)));
+
+	return HRTIMER_RESTART;
+}
+
 void input_dev_poller_finalize(struct input_dev_poller *poller)
 {
 	if (!poller->poll_interval)
@@ -55,14 +119,22 @@ void input_dev_poller_start(struct input_dev_poller *poller)
 {
 	/* Only start polling if polling is enabled */
 	if (poller->poll_interval > 0) {
-		poller->poll(poller->input);
+		poller->last_poll = 0;
+		input_dev_poller_poll(poller);
 		input_dev_poller_queue_work(poller);
 	}
 }
 
 void input_dev_poller_stop(struct input_dev_poller *poller)
 {
-	cancel_delayed_work_sync(&poller->work);
+	input_dev_poller_cancel_work(poller);
+}
+
+void input_dev_poller_destroy(struct input_dev_poller *poller)
+{
+	if (poller && poller->worker)
+		kthread_destroy_worker(poller->worker);
+	kfree(poller);
 }
 
 int input_setup_polling(struct input_dev *dev,
@@ -83,6 +155,9 @@ int input_setup_polling(struct input_dev *dev,
 	}
 
 	INIT_DELAYED_WORK(&poller->work, input_dev_poller_work);
+	kthread_init_work(&poller->kwork, input_dev_poller_kwork);
+	hrtimer_init(&poller->timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	poller->timer.function = input_dev_poller_timer;
 	poller->input = dev;
 	poller->poll = poll_fn;
 
@@ -123,6 +198,38 @@ void input_set_max_poll_interval(struct input_dev *dev, unsigned int interval)
 }
 EXPORT_SYMBOL(input_set_max_poll_interval);
 
+/**
+ * input_set_poll_hrtimer - poll the device from a dedicated thread
+ * @dev: input device set up with input_setup_polling()
+ *
+ * By default devices are polled from delayed work, so the interval is
+ * rounded to jiffies and subject to workqueue scheduling latency. After
+ * this call a high resolution timer kicks a real-time priority kthread
+ * worker for each poll instead. Meant for devices that need to be polled
+ * every few milliseconds. Must be called before the device is registered.
+ */
+int input_set_poll_hrtimer(struct input_dev *dev)
+{
+	struct kthread_worker *worker;
+
+	if (!input_dev_ensure_poller(dev))
+		return -EINVAL;
+
+	if (dev->poller->worker)
+		return 0;
+
+	worker = kthread_create_worker(KTW_FREEZABLE, "%s-poll",
+				      dev_name(&dev->dev));
+	if (IS_ERR(worker))
+		return PTR_ERR(worker);
+
+	sched_set_fifo_low(worker->task);
+	dev->poller->worker = worker;
+
+	return 0;
+}
+EXPORT_SYMBOL(input_set_poll_hrtimer);
+
 int input_get_poll_interval(struct input_dev *dev)
 {
 	if (!dev->poller)
@@ -167,7 +274,7 @@ static ssize_t input_dev_set_poll_interval(struct device *dev,
 	poller->poll_interval = interval;
 
 	if (input_device_enabled(input)) {
-		cancel_delayed_work_sync(&poller->work);
+		input_dev_poller_cancel_work(poller);
 		if (poller->poll_interval > 0)
 			input_dev_poller_queue_work(poller);
 	}
@@ -200,6 +307,20 @@ static ssize_t input_dev_get_poll_min(struct device *dev,
 
 static DEVICE_ATTR(min, 0444, input_dev_get_poll_min, NULL);
 
+static ssize_t input_dev_get_poll_achieved(struct device *dev,
+					   struct device_attribute *attr,
+					   char *buf)
+{
+	struct input_dev *input = to_input_dev(dev);
+
+	/* usec, as the requested interval may be only a few msec */
+	return sprintf(buf, "%llu\n",
+		       div_u64(READ_ONCE(input->poller->achieved),
+			       NSEC_PER_USEC));
+}
+
+static DEVICE_ATTR(achieved, 0444, input_dev_get_poll_achieved, NULL);
+
 static umode_t input_poller_attrs_visible(struct kobject *kobj,
 					  struct attribute *attr, int n)
 {
@@ -213,6 +334,7 @@ static struct attribute *input_poller_attrs[] = {
 	&dev_attr_poll.attr,
 	&dev_attr_max.attr,
 	&dev_attr_min.attr,
+	&dev_attr_achieved.attr,
 	NULL
 };
 
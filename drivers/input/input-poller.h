@@ -12,6 +12,7 @@ struct input_dev_poller;
 void input_dev_poller_finalize(struct input_dev_poller *poller);
 void input_dev_poller_start(struct input_dev_poller *poller);
 void input_dev_poller_stop(struct input_dev_poller *poller);
+void input_dev_poller_destroy(struct input_dev_poller *poller);
 
 extern struct attribute_group input_poller_attribute_group;
 
@@ -18,14 +18,21 @@
 #include <linux/major.h>
 #include <linux/proc_fs.h>
 #include <linux/sched.h>
+#include <linux/sched/cpufreq.h>
 #include <linux/seq_file.h>
 #include <linux/poll.h>
 #include <linux/device.h>
 #include <linux/mutex.h>
 #include <linux/rcupdate.h>
+#include <linux/trace_fixed.h>
 #include "input-compat.h"
 #include "input-poller.h"
 
+#define CREATE_TRACE_POINTS
+#include <trace/events/input.h>
+
+EXPORT_TRACEPOINT_SYMBOL_GPL(input_frame_read);
+
 MODULE_AUTHOR("Vojtech Pavlik <vojtech@suse.cz>");
 MODULE_DESCRIPTION("Input core");
 MODULE_LICENSE("GPL");
@@ -128,20 +135,40 @@ static unsigned int input_to_handler(struct input_handle *handle,
 static void input_pass_values(struct input_dev *dev,
 			      struct input_value *vals, unsigned int count)
 {
+	DECLARE_BITMAP(types, EV_CNT);
 	struct input_handle *handle;
 	struct input_value *v;
 
 	if (!count)
 		return;
 
+	/*
+	 * Values filtered out on the way may leave types without values
+	 * behind, which only costs a handler call that would have been
+	 * made anyway.
+	 */
+	bitmap_zero(types, EV_CNT);
+	for (v = vals; v != vals + count; v++)
+		__set_bit(v->type, types);
+
+	if (trace_input_frame_enabled() &&
+	    vals[count - 1].type == EV_SYN &&
+	    vals[count - 1].code == SYN_REPORT)
+		trace_input_frame(dev, count,
+				  input_get_timestamp_clk(dev, INPUT_CLK_MONO));
+	trace_fixed(TRACE_FIXED_INPUT_FRAME,
+		    dev->id.vendor << 16 | dev->id.product, count, 0, 0);
+
 	rcu_read_lock();
 
 	handle = rcu_dereference(dev->grab);
 	if (handle) {
-		count = input_to_handler(handle, vals, count);
+		if (bitmap_intersects(handle->evbit, types, EV_CNT))
+			count = input_to_handler(handle, vals, count);
 	} else {
 		list_for_each_entry_rcu(handle, &dev->h_list, d_node)
-			if (handle->open) {
+			if (handle->open &&
+			    bitmap_intersects(handle->evbit, types, EV_CNT)) {
 				count = input_to_handler(handle, vals, count);
 				if (!count)
 					break;
@@ -150,6 +177,9 @@ static void input_pass_values(struct input_dev *dev,
 
 	rcu_read_unlock();
 
+	if (READ_ONCE(dev->boost))
+		schedutil_input_boost();
+
 	/* trigger auto repeat for key events */
 	if (test_bit(EV_REP, dev->evbit) && test_bit(EV_KEY, dev->evbit)) {
 		for (v = vals; v != vals + count; v++) {
@@ -364,6 +394,61 @@ static int input_get_disposition(struct input_dev *dev,
 	return disposition;
 }
 
+/*
+ * Frames that do not fit in dev->vals are passed to the handlers in
+ * several pieces, each with its own SYN_REPORT and wakeup. If that
+ * happens for INPUT_SPLIT_FRAMES out of INPUT_SPLIT_WINDOW frames,
+ * the buffer is grown from a work item to fit the largest frame seen.
+ */
+#define INPUT_SPLIT_WINDOW	256
+#define INPUT_SPLIT_FRAMES	4
+#define INPUT_MAX_VALS		1024
+
+static void input_account_frame(struct input_dev *dev)
+{
+	if (dev->split_vals) {
+		dev->split_max = max(dev->split_max,
+				     dev->split_vals + dev->num_vals);
+		dev->split_vals = 0;
+
+		if (++dev->split_frames >= INPUT_SPLIT_FRAMES &&
+		    dev->max_vals < INPUT_MAX_VALS && !dev->going_away)
+			schedule_work(&dev->vals_work);
+	}
+
+	if (++dev->window_frames >= INPUT_SPLIT_WINDOW) {
+		dev->window_frames = 0;
+		dev->split_frames = 0;
+	}
+}
+
+static void input_grow_vals(struct work_struct *work)
+{
+	struct input_dev *dev = container_of(work, struct input_dev, vals_work);
+	struct input_value *vals;
+	unsigned int max_vals;
+
+	max_vals = min(READ_ONCE(dev->split_max) + 2, INPUT_MAX_VALS);
+	vals = kcalloc(max_vals, sizeof(*vals), GFP_KERNEL);
+	if (!vals)
+		return;
+
+	spin_lock_irq(&dev->event_lock);
+
+	if (max_vals > dev->max_vals) {
+		memcpy(vals, dev->vals, dev->num_vals * sizeof(*vals));
+		swap(dev->vals, vals);
+		dev->max_vals = max_vals;
+		dev->hint_events_per_packet = max_vals - 2;
+	}
+
+	dev->split_frames = 0;
+
+	spin_unlock_irq(&dev->event_lock);
+
+	kfree(vals);
+}
+
 static void input_handle_event(struct input_dev *dev,
 			       unsigned int type, unsigned int code, int value)
 {
@@ -400,8 +485,12 @@ static void input_handle_event(struct input_dev *dev,
 	}
 
 	if (disposition & INPUT_FLUSH) {
-		if (dev->num_vals >= 2)
+		if (dev->num_vals >= 2) {
 			input_pass_values(dev, dev->vals, dev->num_vals);
+			dev->stat_frames++;
+			dev->stat_values += dev->num_vals;
+		}
+		input_account_frame(dev);
 		dev->num_vals = 0;
 		/*
 		 * Reset the timestamp on flush so we won't end up
@@ -411,8 +500,11 @@ static void input_handle_event(struct input_dev *dev,
 		 */
 		dev->timestamp[INPUT_CLK_MONO] = ktime_set(0, 0);
 	} else if (dev->num_vals >= dev->max_vals - 2) {
+		dev->split_vals += dev->num_vals;
 		dev->vals[dev->num_vals++] = input_value_sync;
 		input_pass_values(dev, dev->vals, dev->num_vals);
+		dev->stat_early_flushes++;
+		dev->stat_values += dev->num_vals;
 		dev->num_vals = 0;
 	}
 
@@ -449,6 +541,110 @@ void input_event(struct input_dev *dev,
 }
 EXPORT_SYMBOL(input_event);
 
+/**
+ * input_event_values() - report a frame of input events
+ * @dev: device that generated the events
+ * @vals: array of events, normally ending with a SYN_REPORT
+ * @count: number of events in @vals
+ *
+ * This function is equivalent to calling input_event() for every entry
+ * of @vals, but it takes dev->event_lock only once for the whole frame.
+ * Drivers decoding a complete state report at once should prefer it to
+ * a sequence of input_report_*() calls, as it avoids toggling interrupts
+ * for each event. Events of types not supported by the device are
+ * skipped.
+ */
+void input_event_values(struct input_dev *dev,
+			const struct input_value *vals, unsigned int count)
+{
+	const struct input_value *v;
+	unsigned long flags;
+
+	spin_lock_irqsave(&dev->event_lock, flags);
+	for (v = vals; v != vals + count; v++)
+		if (is_event_supported(v->type, dev->evbit, EV_MAX))
+			input_handle_event(dev, v->type, v->code, v->value);
+	spin_unlock_irqrestore(&dev->event_lock, flags);
+}
+EXPORT_SYMBOL(input_event_values);
+
+/**
+ * input_group_sync() - mark the end of a report shared by sibling devices
+ * @dev: one of the input devices the report was delivered to
+ *
+ * Drivers that spread one hardware report over several input devices
+ * with the same parent call this once all the frames of the report have
+ * been reported, so that handlers joining those devices can deliver them
+ * as one frame.
+ */
+void input_group_sync(struct input_dev *dev)
+{
+	struct input_handle *handle;
+	unsigned long flags;
+
+	spin_lock_irqsave(&dev->event_lock, flags);
+	rcu_read_lock();
+
+	handle = rcu_dereference(dev->grab);
+	if (handle) {
+		if (handle->handler->group_sync)
+			handle->handler->group_sync(handle);
+	} else {
+		list_for_each_entry_rcu(handle, &dev->h_list, d_node)
+			if (handle->open && handle->handler->group_sync)
+				handle->handler->group_sync(handle);
+	}
+
+	rcu_read_unlock();
+	spin_unlock_irqrestore(&dev->event_lock, flags);
+}
+EXPORT_SYMBOL(input_group_sync);
+
+static bool input_handle_wants(struct input_handle *handle,
+			       unsigned int type, unsigned int code)
+{
+	return !handle->handler->wants ||
+	       handle->handler->wants(handle, type, code);
+}
+
+/**
+ * input_event_wanted() - check whether an event would reach any reader
+ * @dev: input device generating the event
+ * @type: type of the event
+ * @code: event code
+ *
+ * Handlers may filter events on behalf of their readers, for instance
+ * evdev clients can mask event codes with EVIOCSMASK. Drivers may use
+ * this to stop producing events nobody reads, for instance by turning
+ * off a sensor. They are told through their interest() method when the
+ * answer may have changed.
+ */
+bool input_event_wanted(struct input_dev *dev,
+			unsigned int type, unsigned int code)
+{
+	struct input_handle *handle;
+	bool wanted = false;
+
+	rcu_read_lock();
+
+	handle = rcu_dereference(dev->grab);
+	if (handle) {
+		wanted = input_handle_wants(handle, type, code);
+	} else {
+		list_for_each_entry_rcu(handle, &dev->h_list, d_node) {
+			if (handle->open &&
+			    input_handle_wants(handle, type, code)) {
+				wanted = true;
+				break;
+			}
+		}
+	}
+
+	rcu_read_unlock();
+	return wanted;
+}
+EXPORT_SYMBOL(input_event_wanted);
+
 /**
  * input_inject_event() - send input event from input handler
  * @handle: input handle to send event through
@@ -635,6 +831,8 @@ int input_open_device(struct input_handle *handle)
 			 * through this handle
 			 */
 			synchronize_rcu();
+			/* nor resizing the buffer for a device left closed */
+			cancel_work_sync(&dev->vals_work);
 			goto out;
 		}
 	}
@@ -665,6 +863,30 @@ int input_flush_device(struct input_handle *handle, struct file *file)
 }
 EXPORT_SYMBOL(input_flush_device);
 
+/**
+ * input_interest_changed - tell the driver that readers changed
+ * @handle: handle whose readers changed the events they want
+ *
+ * Handlers implementing the wants() method call this whenever its
+ * answer may have changed, so that the driver can check again with
+ * input_event_wanted(). Nothing is done while the device is closed.
+ */
+void input_interest_changed(struct input_handle *handle)
+{
+	struct input_dev *dev = handle->dev;
+
+	if (!dev->interest)
+		return;
+
+	mutex_lock(&dev->mutex);
+
+	if (dev->users && !dev->going_away && !dev->inhibited)
+		dev->interest(dev);
+
+	mutex_unlock(&dev->mutex);
+}
+EXPORT_SYMBOL(input_interest_changed);
+
 /**
  * input_close_device - close input device
  * @handle: handle through which device is being accessed
@@ -1456,6 +1678,29 @@ static ssize_t inhibited_store(struct device *dev,
 
 static DEVICE_ATTR_RW(inhibited);
 
+static ssize_t boost_show(struct device *dev, struct device_attribute *attr,
+			  char *buf)
+{
+	struct input_dev *input_dev = to_input_dev(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%d\n", READ_ONCE(input_dev->boost));
+}
+
+static ssize_t boost_store(struct device *dev, struct device_attribute *attr,
+			   const char *buf, size_t len)
+{
+	struct input_dev *input_dev = to_input_dev(dev);
+	bool boost;
+
+	if (strtobool(buf, &boost))
+		return -EINVAL;
+
+	WRITE_ONCE(input_dev->boost, boost);
+	return len;
+}
+
+static DEVICE_ATTR_RW(boost);
+
 static struct attribute *input_dev_attrs[] = {
 	&dev_attr_name.attr,
 	&dev_attr_phys.attr,
@@ -1463,6 +1708,7 @@ static struct attribute *input_dev_attrs[] = {
 	&dev_attr_modalias.attr,
 	&dev_attr_properties.attr,
 	&dev_attr_inhibited.attr,
+	&dev_attr_boost.attr,
 	NULL
 };
 
@@ -1498,6 +1744,33 @@ static const struct attribute_group input_dev_id_attr_group = {
 	.attrs	= input_dev_id_attrs,
 };
 
+#define INPUT_DEV_STAT_ATTR(name)					\
+static ssize_t input_dev_show_stat_##name(struct device *dev,		\
+					  struct device_attribute *attr, \
+					  char *buf)			\
+{									\
+	struct input_dev *input_dev = to_input_dev(dev);		\
+	return scnprintf(buf, PAGE_SIZE, "%lu\n",			\
+			 READ_ONCE(input_dev->stat_##name));		\
+}									\
+static DEVICE_ATTR(name, S_IRUGO, input_dev_show_stat_##name, NULL)
+
+INPUT_DEV_STAT_ATTR(frames);
+INPUT_DEV_STAT_ATTR(values);
+INPUT_DEV_STAT_ATTR(early_flushes);
+
+static struct attribute *input_dev_stats_attrs[] = {
+	&dev_attr_frames.attr,
+	&dev_attr_values.attr,
+	&dev_attr_early_flushes.attr,
+	NULL
+};
+
+static const struct attribute_group input_dev_stats_attr_group = {
+	.name	= "stats",
+	.attrs	= input_dev_stats_attrs,
+};
+
 static int input_print_bitmap(char *buf, int buf_size, unsigned long *bitmap,
 			      int max, int add_cr)
 {
@@ -1572,6 +1845,7 @@ static const struct attribute_group *input_dev_attr_groups[] = {
 	&input_dev_attr_group,
 	&input_dev_id_attr_group,
 	&input_dev_caps_attr_group,
+	&input_dev_stats_attr_group,
 	&input_poller_attribute_group,
 	NULL
 };
@@ -1582,7 +1856,7 @@ static void input_dev_release(struct device *device)
 
 	input_ff_destroy(dev);
 	input_mt_destroy_slots(dev);
-	kfree(dev->poller);
+	input_dev_poller_destroy(dev->poller);
 	kfree(dev->absinfo);
 	kfree(dev->vals);
 	kfree(dev);
@@ -1920,6 +2194,7 @@ struct input_dev *input_allocate_device(void)
 		timer_setup(&dev->timer, NULL, 0);
 		INIT_LIST_HEAD(&dev->h_list);
 		INIT_LIST_HEAD(&dev->node);
+		INIT_WORK(&dev->vals_work, input_grow_vals);
 
 		dev_set_name(&dev->dev, "input%lu",
 			     (unsigned long)atomic_inc_return(&input_no));
@@ -2030,34 +2305,76 @@ EXPORT_SYMBOL(input_free_device);
  *   in CLOCK_MONOTONIC
  *
  * This function is intended to provide to the input system a more
- * accurate time of when an event actually occurred. The driver should
- * call this function as soon as a timestamp is acquired ensuring
- * clock conversions in input_set_timestamp are done correctly.
+ * accurate time of when an event actually occurred.
  *
- * The system entering suspend state between timestamp acquisition and
- * calling input_set_timestamp can result in inaccurate conversions.
+ * Only the CLOCK_MONOTONIC value is stored here; CLOCK_REALTIME and
+ * CLOCK_BOOTTIME are derived from it when a handler first asks for them
+ * in input_get_timestamp_clk(), which happens when the frame is passed
+ * to the handlers. The system entering suspend state between timestamp
+ * acquisition and the end of the frame can result in inaccurate
+ * conversions.
  */
 void input_set_timestamp(struct input_dev *dev, ktime_t timestamp)
 {
 	dev->timestamp[INPUT_CLK_MONO] = timestamp;
-	dev->timestamp[INPUT_CLK_REAL] = ktime_mono_to_real(timestamp);
-	dev->timestamp[INPUT_CLK_BOOT] = ktime_mono_to_any(timestamp,
-							   TK_OFFS_BOOT);
+	dev->timestamp_clks = BIT(INPUT_CLK_MONO);
 }
 EXPORT_SYMBOL(input_set_timestamp);
 
+/**
+ * input_get_timestamp_clk - get timestamp of input events in given clock
+ * @dev: input device to get timestamp from
+ * @clk: clock the timestamp is wanted in
+ *
+ * Returns the timestamp of the current frame, converting it to @clk
+ * on first use and reusing the result for the rest of the frame. The
+ * current time is used if the driver did not set a timestamp.
+ */
+ktime_t input_get_timestamp_clk(struct input_dev *dev,
+				enum input_clock_type clk)
+{
+	ktime_t mono;
+
+	if (!dev->timestamp[INPUT_CLK_MONO])
+		input_set_timestamp(dev, ktime_get());
+
+	if (dev->timestamp_clks & BIT(clk))
+		return dev->timestamp[clk];
+
+	mono = dev->timestamp[INPUT_CLK_MONO];
+
+	switch (clk) {
+	case INPUT_CLK_REAL:
+		dev->timestamp[clk] = ktime_mono_to_real(mono);
+		break;
+	case INPUT_CLK_BOOT:
+		dev->timestamp[clk] = ktime_mono_to_any(mono, TK_OFFS_BOOT);
+		break;
+	default:
+		dev->timestamp[clk] = mono;
+		break;
+	}
+
+	dev->timestamp_clks |= BIT(clk);
+
+	return dev->timestamp[clk];
+}
+EXPORT_SYMBOL(input_get_timestamp_clk);
+
 /**
  * input_get_timestamp - get timestamp for input events
  * @dev: input device to get timestamp from
  *
- * A valid timestamp is a timestamp of non-zero value.
+ * A valid timestamp is a timestamp of non-zero value. All clocks are
+ * converted; handlers that only need one should use
+ * input_get_timestamp_clk() instead.
  */
 ktime_t *input_get_timestamp(struct input_dev *dev)
 {
-	const ktime_t invalid_timestamp = ktime_set(0, 0);
+	int clk;
 
-	if (!ktime_compare(dev->timestamp[INPUT_CLK_MONO], invalid_timestamp))
-		input_set_timestamp(dev, ktime_get());
+	for (clk = 0; clk < INPUT_CLK_MAX; clk++)
+		input_get_timestamp_clk(dev, clk);
 
 	return dev->timestamp;
 }
@@ -2196,6 +2513,8 @@ static void __input_unregister_device(struct input_dev *dev)
 
 	mutex_unlock(&input_mutex);
 
+	cancel_work_sync(&dev->vals_work);
+
 	device_del(&dev->dev);
 }
 
@@ -2348,6 +2667,8 @@ int input_register_device(struct input_dev *dev)
 err_device_del:
 	device_del(&dev->dev);
 err_free_vals:
+	/* events reported in the meantime may have queued a resize */
+	cancel_work_sync(&dev->vals_work);
 	kfree(dev->vals);
 	dev->vals = NULL;
 err_devres_free:
@@ -2478,6 +2799,10 @@ EXPORT_SYMBOL(input_handler_for_each_handle);
  * and handler's lists so that events can flow through
  * it once it is opened using input_open_device().
  *
+ * Only frames containing at least one of the event types
+ * set in handle->evbit are passed to the handler. A handle
+ * registered with an empty evbit gets all of them.
+ *
  * This function is supposed to be called from handler's
  * connect() method.
  */
@@ -2487,6 +2812,9 @@ int input_register_handle(struct input_handle *handle)
 	struct input_dev *dev = handle->dev;
 	int error;
 
+	if (bitmap_empty(handle->evbit, EV_CNT))
+		bitmap_fill(handle->evbit, EV_CNT);
+
 	/*
 	 * We take dev->mutex here to prevent race with
 	 * input_release_device().
@@ -52,6 +52,9 @@ struct joydev {
 	__u8 absmap[ABS_CNT];
 	__u8 abspam[ABS_CNT];
 	__s16 abs[ABS_CNT];
+	/* for JSIOCGSNAPSHOT, protected by the input device's event_lock */
+	__u32 generation;
+	__u32 time;
 };
 
 struct joydev_client {
@@ -142,6 +145,9 @@ static void joydev_event(struct input_handle *handle,
 
 	event.time = jiffies_to_msecs(jiffies);
 
+	joydev->generation++;
+	joydev->time = event.time;
+
 	rcu_read_lock();
 	list_for_each_entry_rcu(client, &joydev->client_list, node)
 		joydev_pass_event(client, &event);
@@ -507,6 +513,30 @@ static int joydev_handle_JSIOCSBTNMAP(struct joydev *joydev,
 }
 
 
+static int joydev_handle_JSIOCGSNAPSHOT(struct joydev *joydev,
+					void __user *argp)
+{
+	struct input_dev *dev = joydev->handle.dev;
+	struct js_snapshot snap = { };
+	int i;
+
+	spin_lock_irq(&dev->event_lock);
+
+	snap.generation = joydev->generation;
+	snap.time = joydev->time;
+	snap.axes = joydev->nabs;
+	snap.buttons = joydev->nkey;
+	memcpy(snap.axis, joydev->abs, sizeof(joydev->abs[0]) * joydev->nabs);
+
+	for (i = 0; i < joydev->nkey; i++)
+		if (test_bit(joydev->keypam[i], dev->key))
+			snap.button[i / 8] |= BIT(i % 8);
+
+	spin_unlock_irq(&dev->event_lock);
+
+	return copy_to_user(argp, &snap, sizeof(snap)) ? -EFAULT : 0;
+}
+
 static int joydev_ioctl_common(struct joydev *joydev,
 				unsigned int cmd, void __user *argp)
 {
@@ -556,6 +586,9 @@ static int joydev_ioctl_common(struct joydev *joydev,
 		return copy_to_user(argp, joydev->corr,
 			sizeof(joydev->corr[0]) * joydev->nabs) ? -EFAULT : 0;
 
+	case JSIOCGSNAPSHOT:
+		return joydev_handle_JSIOCGSNAPSHOT(joydev, argp);
+
 	}
 
 	/*
@@ -944,6 +977,8 @@ static int joydev_connect(struct input_handler *handler, struct input_dev *dev,
 	joydev->handle.name = dev_name(&joydev->dev);
 	joydev->handle.handler = handler;
 	joydev->handle.private = joydev;
+	__set_bit(EV_KEY, joydev->handle.evbit);
+	__set_bit(EV_ABS, joydev->handle.evbit);
 
 	for_each_set_bit(i, dev->absbit, ABS_CNT) {
 		joydev->absmap[i] = joydev->nabs;
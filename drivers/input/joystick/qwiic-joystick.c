@@ -108,6 +108,12 @@ static int qwiic_probe(struct i2c_client *client)
 	input_set_min_poll_interval(priv->dev, QWIIC_JSK_POLL_MIN);
 	input_set_max_poll_interval(priv->dev, QWIIC_JSK_POLL_MAX);
 
+	err = input_set_poll_hrtimer(priv->dev);
+	if (err) {
+		dev_err(&client->dev, "failed to set up poll thread: %d\n", err);
+		return err;
+	}
+
 	err = input_register_device(priv->dev);
 	if (err) {
 		dev_err(&client->dev, "failed to register joystick: %d\n", err);
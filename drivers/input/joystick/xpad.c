@@ -72,6 +72,9 @@
 
 #define XPAD_PKT_LEN 64
 
+/* keep the endpoint polled while a completed report is processed */
+#define XPAD_IN_URBS 2
+
 /*
  * xbox d-pads should map to buttons, as is required for DDR pads
  * but we map them to axes when possible to simplify things
@@ -566,6 +569,7 @@ struct xpad_output_packet {
 	bool pending;
 };
 
+/* in the order they are sent when several are pending */
 #define XPAD_OUT_CMD_IDX	0
 #define XPAD_OUT_FF_IDX		1
 #define XPAD_OUT_LED_IDX	(1 + IS_ENABLED(CONFIG_JOYSTICK_XPAD_FF))
@@ -582,9 +586,13 @@ struct usb_xpad {
 	bool pad_present;
 	bool input_created;
 
-	struct urb *irq_in;		/* urb for interrupt in report */
-	unsigned char *idata;		/* input data */
-	dma_addr_t idata_dma;
+	struct urb *irq_in[XPAD_IN_URBS];	/* urbs for interrupt in reports */
+	u8 last_idata[XPAD_PKT_LEN];	/* last processed report */
+	unsigned int last_idata_len;
+
+	unsigned long in_packets;	/* statistics, updated in xpad_irq_in */
+	unsigned long in_unchanged;
+	unsigned long in_errors;
 
 	struct urb *irq_out;		/* urb for interrupt out report */
 	struct usb_anchor irq_out_anchor;
@@ -595,7 +603,6 @@ struct usb_xpad {
 	spinlock_t odata_lock;
 
 	struct xpad_output_packet out_packets[XPAD_NUM_OUT_PACKETS];
-	int last_out_packet;
 	int init_seq;
 
 #if defined(CONFIG_JOYSTICK_XPAD_LEDS)
@@ -931,6 +938,8 @@ static void xpad_irq_in(struct urb *urb)
 {
 	struct usb_xpad *xpad = urb->context;
 	struct device *dev = &xpad->intf->dev;
+	unsigned char *data = urb->transfer_buffer;
+	unsigned int len = urb->actual_length;
 	int retval, status;
 
 	status = urb->status;
@@ -949,21 +958,35 @@ static void xpad_irq_in(struct urb *urb)
 	default:
 		dev_dbg(dev, "%s - nonzero urb status received: %d\n",
 			__func__, status);
+		xpad->in_errors++;
+		goto exit;
+	}
+
+	/*
+	 * Completions of the IN urbs are serialized, in order. Pads repeat
+	 * their whole state, skip reports that did not change anything.
+	 */
+	xpad->in_packets++;
+	if (len == xpad->last_idata_len &&
+	    !memcmp(data, xpad->last_idata, len)) {
+		xpad->in_unchanged++;
 		goto exit;
 	}
+	memcpy(xpad->last_idata, data, len);
+	xpad->last_idata_len = len;
 
 	switch (xpad->xtype) {
 	case XTYPE_XBOX360:
-		xpad360_process_packet(xpad, xpad->dev, 0, xpad->idata);
+		xpad360_process_packet(xpad, xpad->dev, 0, data);
 		break;
 	case XTYPE_XBOX360W:
-		xpad360w_process_packet(xpad, 0, xpad->idata);
+		xpad360w_process_packet(xpad, 0, data);
 		break;
 	case XTYPE_XBOXONE:
-		xpadone_process_packet(xpad, 0, xpad->idata);
+		xpadone_process_packet(xpad, 0, data);
 		break;
 	default:
-		xpad_process_packet(xpad, 0, xpad->idata);
+		xpad_process_packet(xpad, 0, data);
 	}
 
 exit:
@@ -1015,15 +1038,18 @@ static bool xpad_prepare_next_out_packet(struct usb_xpad *xpad)
 	if (xpad_prepare_next_init_packet(xpad))
 		return true;
 
+	/*
+	 * Each slot only holds the latest state of its kind, so a rumble
+	 * update queued while another one is in flight replaces it. Send
+	 * by priority rather than in turns, so rumble does not wait for
+	 * an LED update.
+	 */
 	for (i = 0; i < XPAD_NUM_OUT_PACKETS; i++) {
-		if (++xpad->last_out_packet >= XPAD_NUM_OUT_PACKETS)
-			xpad->last_out_packet = 0;
-
-		pkt = &xpad->out_packets[xpad->last_out_packet];
+		pkt = &xpad->out_packets[i];
 		if (pkt->pending) {
 			dev_dbg(&xpad->intf->dev,
 				"%s - found pending output packet %d\n",
-				__func__, xpad->last_out_packet);
+				__func__, i);
 			packet = pkt;
 			break;
 		}
@@ -1189,8 +1215,6 @@ static int xpad_inquiry_pad_presence(struct usb_xpad *xpad)
 	packet->len = 12;
 	packet->pending = true;
 
-	/* Reset the sequence so we send out presence first */
-	xpad->last_out_packet = -1;
 	retval = xpad_try_sending_next_out_packet(xpad);
 
 	spin_unlock_irqrestore(&xpad->odata_lock, flags);
@@ -1235,8 +1259,6 @@ static void xpadone_ack_mode_report(struct usb_xpad *xpad, u8 seq_num)
 	packet->data[2] = seq_num;
 	packet->pending = true;
 
-	/* Reset the sequence so we send out the ack now */
-	xpad->last_out_packet = -1;
 	xpad_try_sending_next_out_packet(xpad);
 
 	spin_unlock_irqrestore(&xpad->odata_lock, flags);
@@ -1499,17 +1521,43 @@ static int xpad_led_probe(struct usb_xpad *xpad) { return 0; }
 static void xpad_led_disconnect(struct usb_xpad *xpad) { }
 #endif
 
+static void xpad_kill_in(struct usb_xpad *xpad)
+{
+	int i;
+
+	for (i = 0; i < XPAD_IN_URBS; i++)
+		usb_kill_urb(xpad->irq_in[i]);
+}
+
+static int xpad_submit_in(struct usb_xpad *xpad)
+{
+	int i;
+
+	/* the first report after (re)start is always processed */
+	xpad->last_idata_len = 0;
+
+	for (i = 0; i < XPAD_IN_URBS; i++) {
+		if (usb_submit_urb(xpad->irq_in[i], GFP_KERNEL)) {
+			xpad_kill_in(xpad);
+			return -EIO;
+		}
+	}
+
+	return 0;
+}
+
 static int xpad_start_input(struct usb_xpad *xpad)
 {
 	int error;
 
-	if (usb_submit_urb(xpad->irq_in, GFP_KERNEL))
-		return -EIO;
+	error = xpad_submit_in(xpad);
+	if (error)
+		return error;
 
 	if (xpad->xtype == XTYPE_XBOXONE) {
 		error = xpad_start_xbox_one(xpad);
 		if (error) {
-			usb_kill_urb(xpad->irq_in);
+			xpad_kill_in(xpad);
 			return error;
 		}
 	}
@@ -1519,7 +1567,7 @@ static int xpad_start_input(struct usb_xpad *xpad)
 
 static void xpad_stop_input(struct usb_xpad *xpad)
 {
-	usb_kill_urb(xpad->irq_in);
+	xpad_kill_in(xpad);
 }
 
 static void xpad360w_poweroff_controller(struct usb_xpad *xpad)
@@ -1545,8 +1593,6 @@ static void xpad360w_poweroff_controller(struct usb_xpad *xpad)
 	packet->len = 12;
 	packet->pending = true;
 
-	/* Reset the sequence so we send out poweroff now */
-	xpad->last_out_packet = -1;
 	xpad_try_sending_next_out_packet(xpad);
 
 	spin_unlock_irqrestore(&xpad->odata_lock, flags);
@@ -1556,9 +1602,9 @@ static int xpad360w_start_input(struct usb_xpad *xpad)
 {
 	int error;
 
-	error = usb_submit_urb(xpad->irq_in, GFP_KERNEL);
+	error = xpad_submit_in(xpad);
 	if (error)
-		return -EIO;
+		return error;
 
 	/*
 	 * Send presence packet.
@@ -1569,7 +1615,7 @@ static int xpad360w_start_input(struct usb_xpad *xpad)
 	 */
 	error = xpad_inquiry_pad_presence(xpad);
 	if (error) {
-		usb_kill_urb(xpad->irq_in);
+		xpad_kill_in(xpad);
 		return error;
 	}
 
@@ -1578,7 +1624,7 @@ static int xpad360w_start_input(struct usb_xpad *xpad)
 
 static void xpad360w_stop_input(struct usb_xpad *xpad)
 {
-	usb_kill_urb(xpad->irq_in);
+	xpad_kill_in(xpad);
 
 	/* Make sure we are done with presence work if it was scheduled */
 	flush_work(&xpad->work);
@@ -1736,6 +1782,87 @@ static int xpad_init_input(struct usb_xpad *xpad)
 	return error;
 }
 
+static void xpad_free_in(struct usb_xpad *xpad)
+{
+	struct urb *urb;
+	int i;
+
+	for (i = 0; i < XPAD_IN_URBS; i++) {
+		urb = xpad->irq_in[i];
+		if (!urb)
+			continue;
+		usb_free_coherent(xpad->udev, XPAD_PKT_LEN,
+				  urb->transfer_buffer, urb->transfer_dma);
+		usb_free_urb(urb);
+	}
+}
+
+static int xpad_alloc_in(struct usb_xpad *xpad)
+{
+	struct urb *urb;
+	int i;
+
+	for (i = 0; i < XPAD_IN_URBS; i++) {
+		urb = usb_alloc_urb(0, GFP_KERNEL);
+		if (!urb)
+			return -ENOMEM;
+		xpad->irq_in[i] = urb;
+
+		urb->transfer_buffer = usb_alloc_coherent(xpad->udev,
+							  XPAD_PKT_LEN,
+							  GFP_KERNEL,
+							  &urb->transfer_dma);
+		if (!urb->transfer_buffer)
+			return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static ssize_t packets_show(struct device *dev,
+			    struct device_attribute *attr, char *buf)
+{
+	struct usb_xpad *xpad = usb_get_intfdata(to_usb_interface(dev));
+
+	return sysfs_emit(buf, "%lu\n", READ_ONCE(xpad->in_packets));
+}
+static DEVICE_ATTR_RO(packets);
+
+static ssize_t unchanged_show(struct device *dev,
+			      struct device_attribute *attr, char *buf)
+{
+	struct usb_xpad *xpad = usb_get_intfdata(to_usb_interface(dev));
+
+	return sysfs_emit(buf, "%lu\n", READ_ONCE(xpad->in_unchanged));
+}
+static DEVICE_ATTR_RO(unchanged);
+
+static ssize_t errors_show(struct device *dev,
+			   struct device_attribute *attr, char *buf)
+{
+	struct usb_xpad *xpad = usb_get_intfdata(to_usb_interface(dev));
+
+	return sysfs_emit(buf, "%lu\n", READ_ONCE(xpad->in_errors));
+}
+static DEVICE_ATTR_RO(errors);
+
+static struct attribute *xpad_stats_attrs[] = {
+	&dev_attr_packets.attr,
+	&dev_attr_unchanged.attr,
+	&dev_attr_errors.attr,
+	NULL
+};
+
+static const struct attribute_group xpad_stats_group = {
+	.name = "stats",
+	.attrs = xpad_stats_attrs,
+};
+
+static const struct attribute_group *xpad_groups[] = {
+	&xpad_stats_group,
+	NULL
+};
+
 static int xpad_probe(struct usb_interface *intf, const struct usb_device_id *id)
 {
 	struct usb_device *udev = interface_to_usbdev(intf);
@@ -1759,20 +1886,11 @@ static int xpad_probe(struct usb_interface *intf, const struct usb_device_id *id
 	usb_make_path(udev, xpad->phys, sizeof(xpad->phys));
 	strlcat(xpad->phys, "/input0", sizeof(xpad->phys));
 
-	xpad->idata = usb_alloc_coherent(udev, XPAD_PKT_LEN,
-					 GFP_KERNEL, &xpad->idata_dma);
-	if (!xpad->idata) {
-		error = -ENOMEM;
-		goto err_free_mem;
-	}
-
-	xpad->irq_in = usb_alloc_urb(0, GFP_KERNEL);
-	if (!xpad->irq_in) {
-		error = -ENOMEM;
-		goto err_free_idata;
-	}
-
 	xpad->udev = udev;
+	error = xpad_alloc_in(xpad);
+	if (error)
+		goto err_free_in_urb;
+
 	xpad->intf = intf;
 	xpad->mapping = xpad_device[i].mapping;
 	xpad->xtype = xpad_device[i].xtype;
@@ -1833,12 +1951,15 @@ static int xpad_probe(struct usb_interface *intf, const struct usb_device_id *id
 	if (error)
 		goto err_free_in_urb;
 
-	usb_fill_int_urb(xpad->irq_in, udev,
-			 usb_rcvintpipe(udev, ep_irq_in->bEndpointAddress),
-			 xpad->idata, XPAD_PKT_LEN, xpad_irq_in,
-			 xpad, ep_irq_in->bInterval);
-	xpad->irq_in->transfer_dma = xpad->idata_dma;
-	xpad->irq_in->transfer_flags |= URB_NO_TRANSFER_DMA_MAP;
+	for (i = 0; i < XPAD_IN_URBS; i++) {
+		struct urb *urb = xpad->irq_in[i];
+
+		usb_fill_int_urb(urb, udev,
+				 usb_rcvintpipe(udev, ep_irq_in->bEndpointAddress),
+				 urb->transfer_buffer, XPAD_PKT_LEN, xpad_irq_in,
+				 xpad, ep_irq_in->bInterval);
+		urb->transfer_flags |= URB_NO_TRANSFER_DMA_MAP;
+	}
 
 	usb_set_intfdata(intf, xpad);
 
@@ -1871,10 +1992,7 @@ static int xpad_probe(struct usb_interface *intf, const struct usb_device_id *id
 err_deinit_output:
 	xpad_deinit_output(xpad);
 err_free_in_urb:
-	usb_free_urb(xpad->irq_in);
-err_free_idata:
-	usb_free_coherent(udev, XPAD_PKT_LEN, xpad->idata, xpad->idata_dma);
-err_free_mem:
+	xpad_free_in(xpad);
 	kfree(xpad);
 	return error;
 }
@@ -1896,9 +2014,7 @@ static void xpad_disconnect(struct usb_interface *intf)
 
 	xpad_deinit_output(xpad);
 
-	usb_free_urb(xpad->irq_in);
-	usb_free_coherent(xpad->udev, XPAD_PKT_LEN,
-			xpad->idata, xpad->idata_dma);
+	xpad_free_in(xpad);
 
 	kfree(xpad);
 
@@ -1972,6 +2088,7 @@ static struct usb_driver xpad_driver = {
 	.resume		= xpad_resume,
 	.reset_resume	= xpad_resume,
 	.id_table	= xpad_table,
+	.dev_groups	= xpad_groups,
 };
 
 module_usb_driver(xpad_driver);
@@ -0,0 +1,732 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Merged event char devices, joining the input devices of one parent.
+ *
+ * Some controllers are split into several input devices, for instance
+ * buttons, touchscreen and motion sensors, even though the hardware sends
+ * a single report for all of them. A /dev/input/mergeX node delivers the
+ * events of all the sibling devices as one read-only stream, tagging each
+ * event with the device it came from. When the driver marks the end of a
+ * hardware report with input_group_sync(), the per-device SYN_REPORTs are
+ * replaced by a single one, so that a reader gets one wakeup per report.
+ */
+
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+
+#define MERGEDEV_MAX_SOURCES	8
+#define MERGEDEV_BUFFER_SIZE	1024
+
+#include <linux/poll.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/input.h>
+#include <linux/major.h>
+#include <linux/device.h>
+#include <linux/cdev.h>
+#include <linux/idr.h>
+
+struct mergedev_source {
+	struct input_handle handle;
+	struct mergedev *mergedev;
+	unsigned int index;
+};
+
+struct mergedev {
+	int open;
+	int num;		/* X in /dev/input/mergeX */
+	struct device *parent;
+	struct list_head node;		/* on mergedev_list */
+	struct mergedev_source *sources[MERGEDEV_MAX_SOURCES];
+	unsigned int num_sources;	/* indices handed out so far */
+	unsigned int attached;
+	struct list_head client_list;
+	spinlock_t client_lock; /* protects client_list */
+	struct mutex mutex;
+	struct device dev;
+	struct cdev cdev;
+	bool registered;
+	bool exist;
+	bool synced;		/* the driver calls input_group_sync() */
+};
+
+struct mergedev_client {
+	unsigned int head;
+	unsigned int tail;
+	unsigned int packet_head; /* [future] position of the first element of next packet */
+	spinlock_t buffer_lock; /* protects access to buffer, head and tail */
+	wait_queue_head_t wait;
+	struct mergedev *mergedev;
+	struct list_head node;
+	struct input_merge_event buffer[MERGEDEV_BUFFER_SIZE];
+};
+
+/* Groups waiting for siblings or registered, protected by input_mutex */
+static LIST_HEAD(mergedev_list);
+static DEFINE_IDA(mergedev_ida);
+
+static void mergedev_stamp(struct input_merge_event *event, ktime_t time)
+{
+	struct timespec64 ts = ktime_to_timespec64(time);
+
+	event->sec = ts.tv_sec;
+	event->usec = ts.tv_nsec / NSEC_PER_USEC;
+}
+
+static void __mergedev_pass_event(struct mergedev_client *client,
+				  const struct input_merge_event *event)
+{
+	client->buffer[client->head++] = *event;
+	client->head &= MERGEDEV_BUFFER_SIZE - 1;
+
+	if (unlikely(client->head == client->tail)) {
+		/*
+		 * This effectively "drops" all unconsumed events, leaving
+		 * EV_SYN/SYN_DROPPED plus the newest event in the queue.
+		 */
+		client->tail = (client->head - 2) & (MERGEDEV_BUFFER_SIZE - 1);
+
+		client->buffer[client->tail] = (struct input_merge_event) {
+			.sec = event->sec,
+			.usec = event->usec,
+			.type = EV_SYN,
+			.code = SYN_DROPPED,
+			.source = INPUT_MERGE_SOURCE_ALL,
+		};
+
+		client->packet_head = client->tail;
+	}
+}
+
+static void mergedev_pass_values(struct mergedev_client *client,
+				 const struct input_value *vals,
+				 unsigned int count,
+				 struct input_merge_event *event, bool synced)
+{
+	const struct input_value *v;
+	bool wakeup = false;
+
+	/* Interrupts are disabled, just acquire the lock. */
+	spin_lock(&client->buffer_lock);
+
+	for (v = vals; v != vals + count; v++) {
+		if (v->type == EV_SYN && v->code == SYN_REPORT) {
+			/* input_group_sync() closes the frame instead */
+			if (synced)
+				continue;
+
+			/* drop empty SYN_REPORT */
+			if (client->packet_head == client->head)
+				continue;
+		}
+
+		event->type = v->type;
+		event->code = v->code;
+		event->value = v->value;
+		__mergedev_pass_event(client, event);
+
+		if (v->type == EV_SYN && v->code == SYN_REPORT) {
+			client->packet_head = client->head;
+			wakeup = true;
+		}
+	}
+
+	spin_unlock(&client->buffer_lock);
+
+	if (wakeup)
+		wake_up_interruptible_poll(&client->wait, EPOLLIN | EPOLLRDNORM);
+}
+
+/*
+ * Pass incoming events to all connected clients.
+ */
+static void mergedev_events(struct input_handle *handle,
+			    const struct input_value *vals, unsigned int count)
+{
+	struct mergedev_source *source = handle->private;
+	struct mergedev *mergedev = source->mergedev;
+	struct mergedev_client *client;
+	struct input_merge_event event = { .source = source->index };
+
+	mergedev_stamp(&event,
+		       input_get_timestamp_clk(handle->dev, INPUT_CLK_MONO));
+
+	rcu_read_lock();
+
+	list_for_each_entry_rcu(client, &mergedev->client_list, node)
+		mergedev_pass_values(client, vals, count, &event,
+				     READ_ONCE(mergedev->synced));
+
+	rcu_read_unlock();
+}
+
+/*
+ * Pass incoming event to all connected clients.
+ */
+static void mergedev_event(struct input_handle *handle,
+			   unsigned int type, unsigned int code, int value)
+{
+	struct input_value vals[] = { { type, code, value } };
+
+	mergedev_events(handle, vals, 1);
+}
+
+/*
+ * Close the frame of every client with a single SYN_REPORT, stamped with
+ * the time of the first event of the frame, i.e. of the source report.
+ */
+static void mergedev_group_sync(struct input_handle *handle)
+{
+	struct mergedev_source *source = handle->private;
+	struct mergedev *mergedev = source->mergedev;
+	struct mergedev_client *client;
+	struct input_merge_event event = {
+		.type = EV_SYN,
+		.code = SYN_REPORT,
+		.source = INPUT_MERGE_SOURCE_ALL,
+	};
+	bool wakeup;
+
+	WRITE_ONCE(mergedev->synced, true);
+
+	rcu_read_lock();
+
+	list_for_each_entry_rcu(client, &mergedev->client_list, node) {
+		spin_lock(&client->buffer_lock);
+		wakeup = client->packet_head != client->head;
+		if (wakeup) {
+			event.sec = client->buffer[client->packet_head].sec;
+			event.usec = client->buffer[client->packet_head].usec;
+			__mergedev_pass_event(client, &event);
+			client->packet_head = client->head;
+		}
+		spin_unlock(&client->buffer_lock);
+
+		if (wakeup)
+			wake_up_interruptible_poll(&client->wait,
+						   EPOLLIN | EPOLLRDNORM);
+	}
+
+	rcu_read_unlock();
+}
+
+static void mergedev_free(struct device *dev)
+{
+	struct mergedev *mergedev = container_of(dev, struct mergedev, dev);
+
+	if (mergedev->num >= 0)
+		ida_free(&mergedev_ida, mergedev->num);
+	kfree(mergedev);
+}
+
+static void mergedev_attach_client(struct mergedev *mergedev,
+				   struct mergedev_client *client)
+{
+	spin_lock(&mergedev->client_lock);
+	list_add_tail_rcu(&client->node, &mergedev->client_list);
+	spin_unlock(&mergedev->client_lock);
+}
+
+static void mergedev_detach_client(struct mergedev *mergedev,
+				   struct mergedev_client *client)
+{
+	spin_lock(&mergedev->client_lock);
+	list_del_rcu(&client->node);
+	spin_unlock(&mergedev->client_lock);
+	synchronize_rcu();
+}
+
+/* Called with mergedev->mutex held, undoes a partial open on error */
+static int mergedev_open_sources(struct mergedev *mergedev)
+{
+	unsigned int i;
+	int error;
+
+	for (i = 0; i < mergedev->num_sources; i++) {
+		if (!mergedev->sources[i])
+			continue;
+
+		error = input_open_device(&mergedev->sources[i]->handle);
+		if (error)
+			goto err_close;
+	}
+
+	return 0;
+
+ err_close:
+	while (i--)
+		if (mergedev->sources[i])
+			input_close_device(&mergedev->sources[i]->handle);
+	return error;
+}
+
+static void mergedev_close_sources(struct mergedev *mergedev)
+{
+	unsigned int i;
+
+	for (i = 0; i < mergedev->num_sources; i++)
+		if (mergedev->sources[i])
+			input_close_device(&mergedev->sources[i]->handle);
+}
+
+static int mergedev_open_device(struct mergedev *mergedev)
+{
+	int retval;
+
+	retval = mutex_lock_interruptible(&mergedev->mutex);
+	if (retval)
+		return retval;
+
+	if (!mergedev->exist)
+		retval = -ENODEV;
+	else if (!mergedev->open++) {
+		retval = mergedev_open_sources(mergedev);
+		if (retval)
+			mergedev->open--;
+	}
+
+	mutex_unlock(&mergedev->mutex);
+	return retval;
+}
+
+static void mergedev_close_device(struct mergedev *mergedev)
+{
+	mutex_lock(&mergedev->mutex);
+
+	if (mergedev->exist && !--mergedev->open)
+		mergedev_close_sources(mergedev);
+
+	mutex_unlock(&mergedev->mutex);
+}
+
+/*
+ * Wake up users waiting for IO so they can disconnect from
+ * dead device.
+ */
+static void mergedev_hangup(struct mergedev *mergedev)
+{
+	struct mergedev_client *client;
+
+	spin_lock(&mergedev->client_lock);
+	list_for_each_entry(client, &mergedev->client_list, node)
+		wake_up_interruptible_poll(&client->wait, EPOLLHUP | EPOLLERR);
+	spin_unlock(&mergedev->client_lock);
+}
+
+static int mergedev_release(struct inode *inode, struct file *file)
+{
+	struct mergedev_client *client = file->private_data;
+	struct mergedev *mergedev = client->mergedev;
+
+	mergedev_detach_client(mergedev, client);
+	kvfree(client);
+
+	mergedev_close_device(mergedev);
+
+	return 0;
+}
+
+static int mergedev_open(struct inode *inode, struct file *file)
+{
+	struct mergedev *mergedev =
+			container_of(inode->i_cdev, struct mergedev, cdev);
+	struct mergedev_client *client;
+	int error;
+
+	client = kvzalloc(sizeof(*client), GFP_KERNEL);
+	if (!client)
+		return -ENOMEM;
+
+	init_waitqueue_head(&client->wait);
+	spin_lock_init(&client->buffer_lock);
+	client->mergedev = mergedev;
+	mergedev_attach_client(mergedev, client);
+
+	error = mergedev_open_device(mergedev);
+	if (error)
+		goto err_free_client;
+
+	file->private_data = client;
+	stream_open(inode, file);
+
+	return 0;
+
+ err_free_client:
+	mergedev_detach_client(mergedev, client);
+	kvfree(client);
+	return error;
+}
+
+static int mergedev_fetch_next_event(struct mergedev_client *client,
+				     struct input_merge_event *event)
+{
+	int have_event;
+
+	spin_lock_irq(&client->buffer_lock);
+
+	have_event = client->packet_head != client->tail;
+	if (have_event) {
+		*event = client->buffer[client->tail++];
+		client->tail &= MERGEDEV_BUFFER_SIZE - 1;
+	}
+
+	spin_unlock_irq(&client->buffer_lock);
+
+	return have_event;
+}
+
+static ssize_t mergedev_read(struct file *file, char __user *buffer,
+			     size_t count, loff_t *ppos)
+{
+	struct mergedev_client *client = file->private_data;
+	struct mergedev *mergedev = client->mergedev;
+	struct input_merge_event event;
+	size_t read = 0;
+	int error;
+
+	if (count != 0 && count < sizeof(event))
+		return -EINVAL;
+
+	for (;;) {
+		if (!mergedev->exist)
+			return -ENODEV;
+
+		if (client->packet_head == client->tail &&
+		    (file->f_flags & O_NONBLOCK))
+			return -EAGAIN;
+
+		/*
+		 * count == 0 is special - no IO is done but we check
+		 * for error conditions (see above).
+		 */
+		if (count == 0)
+			break;
+
+		while (read + sizeof(event) <= count &&
+		       mergedev_fetch_next_event(client, &event)) {
+
+			if (copy_to_user(buffer + read, &event, sizeof(event)))
+				return -EFAULT;
+
+			read += sizeof(event);
+		}
+
+		if (read)
+			break;
+
+		if (!(file->f_flags & O_NONBLOCK)) {
+			error = wait_event_interruptible(client->wait,
+					client->packet_head != client->tail ||
+					!mergedev->exist);
+			if (error)
+				return error;
+		}
+	}
+
+	return read;
+}
+
+/* No kernel lock - fine */
+static __poll_t mergedev_poll(struct file *file, poll_table *wait)
+{
+	struct mergedev_client *client = file->private_data;
+	struct mergedev *mergedev = client->mergedev;
+	__poll_t mask;
+
+	poll_wait(file, &client->wait, wait);
+
+	mask = mergedev->exist ? 0 : EPOLLHUP | EPOLLERR;
+	if (client->packet_head != client->tail)
+		mask |= EPOLLIN | EPOLLRDNORM;
+
+	return mask;
+}
+
+static int mergedev_get_source(struct mergedev *mergedev, void __user *p)
+{
+	struct input_merge_source info;
+	struct input_dev *dev;
+	int error;
+
+	if (copy_from_user(&info, p, sizeof(info)))
+		return -EFAULT;
+
+	error = mutex_lock_interruptible(&mergedev->mutex);
+	if (error)
+		return error;
+
+	if (!mergedev->exist) {
+		error = -ENODEV;
+		goto out;
+	}
+
+	if (info.index >= mergedev->num_sources ||
+	    !mergedev->sources[info.index]) {
+		error = -ENOENT;
+		goto out;
+	}
+
+	dev = mergedev->sources[info.index]->handle.dev;
+	info.id = dev->id;
+	strscpy_pad(info.name, dev->name ?: "", sizeof(info.name));
+
+	if (copy_to_user(p, &info, sizeof(info)))
+		error = -EFAULT;
+
+ out:
+	mutex_unlock(&mergedev->mutex);
+	return error;
+}
+
+static long mergedev_ioctl(struct file *file, unsigned int cmd,
+			   unsigned long arg)
+{
+	struct mergedev_client *client = file->private_data;
+
+	switch (cmd) {
+	case MERGEIOCGSOURCE:
+		return mergedev_get_source(client->mergedev,
+					   (void __user *)arg);
+	}
+
+	return -EINVAL;
+}
+
+static const struct file_operations mergedev_fops = {
+	.owner		= THIS_MODULE,
+	.read		= mergedev_read,
+	.poll		= mergedev_poll,
+	.open		= mergedev_open,
+	.release	= mergedev_release,
+	.unlocked_ioctl	= mergedev_ioctl,
+	.compat_ioctl	= compat_ptr_ioctl,
+	.llseek		= no_llseek,
+};
+
+/*
+ * Mark device non-existent. This prevents new users from opening the
+ * device and closes the sources, blocked readers get woken up.
+ */
+static void mergedev_cleanup(struct mergedev *mergedev)
+{
+	mutex_lock(&mergedev->mutex);
+	mergedev->exist = false;
+	if (mergedev->open)
+		mergedev_close_sources(mergedev);
+	mutex_unlock(&mergedev->mutex);
+
+	mergedev_hangup(mergedev);
+}
+
+static struct mergedev *mergedev_find(struct device *parent)
+{
+	struct mergedev *mergedev;
+
+	list_for_each_entry(mergedev, &mergedev_list, node)
+		if (mergedev->parent == parent && mergedev->exist &&
+		    mergedev->num_sources < MERGEDEV_MAX_SOURCES)
+			return mergedev;
+
+	return NULL;
+}
+
+static struct mergedev *mergedev_create(struct device *parent)
+{
+	struct mergedev *mergedev;
+
+	mergedev = kzalloc(sizeof(*mergedev), GFP_KERNEL);
+	if (!mergedev)
+		return NULL;
+
+	INIT_LIST_HEAD(&mergedev->client_list);
+	spin_lock_init(&mergedev->client_lock);
+	mutex_init(&mergedev->mutex);
+	mergedev->num = -1;
+	mergedev->parent = parent;
+	mergedev->exist = true;
+
+	mergedev->dev.class = &input_class;
+	mergedev->dev.parent = parent;
+	mergedev->dev.release = mergedev_free;
+	device_initialize(&mergedev->dev);
+
+	list_add_tail(&mergedev->node, &mergedev_list);
+
+	return mergedev;
+}
+
+/* The node only appears once there is something to merge. */
+static int mergedev_register(struct mergedev *mergedev)
+{
+	int minor;
+	int error;
+
+	if (mergedev->num < 0) {
+		mergedev->num = ida_alloc(&mergedev_ida, GFP_KERNEL);
+		if (mergedev->num < 0)
+			return mergedev->num;
+		dev_set_name(&mergedev->dev, "merge%d", mergedev->num);
+	}
+
+	minor = input_get_new_minor(-1, 0, true);
+	if (minor < 0) {
+		pr_err("failed to reserve new minor: %d\n", minor);
+		return minor;
+	}
+
+	mergedev->dev.devt = MKDEV(INPUT_MAJOR, minor);
+
+	cdev_init(&mergedev->cdev, &mergedev_fops);
+
+	error = cdev_device_add(&mergedev->cdev, &mergedev->dev);
+	if (error) {
+		input_free_minor(minor);
+		return error;
+	}
+
+	mergedev->registered = true;
+
+	return 0;
+}
+
+/*
+ * Add a device to the group of its parent. Note that input core
+ * serializes calls to connect and disconnect.
+ */
+static int mergedev_connect(struct input_handler *handler,
+			    struct input_dev *dev,
+			    const struct input_device_id *id)
+{
+	struct mergedev_source *source;
+	struct mergedev *mergedev;
+	bool created = false;
+	int error;
+
+	if (!dev->dev.parent)
+		return -ENODEV;
+
+	mergedev = mergedev_find(dev->dev.parent);
+	if (!mergedev) {
+		mergedev = mergedev_create(dev->dev.parent);
+		if (!mergedev)
+			return -ENOMEM;
+		created = true;
+	}
+
+	source = kzalloc(sizeof(*source), GFP_KERNEL);
+	if (!source) {
+		error = -ENOMEM;
+		goto err_put_mergedev;
+	}
+
+	source->mergedev = mergedev;
+	source->handle.dev = input_get_device(dev);
+	source->handle.name = "merge";
+	source->handle.handler = handler;
+	source->handle.private = source;
+
+	error = input_register_handle(&source->handle);
+	if (error)
+		goto err_free_source;
+
+	mutex_lock(&mergedev->mutex);
+	if (mergedev->open) {
+		error = input_open_device(&source->handle);
+		if (error) {
+			mutex_unlock(&mergedev->mutex);
+			goto err_unregister_handle;
+		}
+	}
+	source->index = mergedev->num_sources++;
+	mergedev->sources[source->index] = source;
+	mergedev->attached++;
+	mutex_unlock(&mergedev->mutex);
+
+	if (mergedev->attached > 1 && !mergedev->registered) {
+		error = mergedev_register(mergedev);
+		if (error)
+			pr_err("failed to register node for %s: %d\n",
+			       dev_name(mergedev->parent), error);
+	}
+
+	return 0;
+
+ err_unregister_handle:
+	input_unregister_handle(&source->handle);
+ err_free_source:
+	input_put_device(dev);
+	kfree(source);
+ err_put_mergedev:
+	if (created) {
+		list_del(&mergedev->node);
+		put_device(&mergedev->dev);
+	}
+	return error;
+}
+
+static void mergedev_disconnect(struct input_handle *handle)
+{
+	struct mergedev_source *source = handle->private;
+	struct mergedev *mergedev = source->mergedev;
+	bool open;
+
+	/* The group goes away with its first member. */
+	if (mergedev->registered) {
+		cdev_device_del(&mergedev->cdev, &mergedev->dev);
+		input_free_minor(MINOR(mergedev->dev.devt));
+		mergedev->registered = false;
+		mergedev_cleanup(mergedev);
+	}
+
+	mutex_lock(&mergedev->mutex);
+	open = mergedev->exist && mergedev->open;
+	mergedev->sources[source->index] = NULL;
+	mergedev->attached--;
+	mutex_unlock(&mergedev->mutex);
+
+	if (open)
+		input_close_device(handle);
+
+	input_unregister_handle(handle);
+	input_put_device(handle->dev);
+	kfree(source);
+
+	if (!mergedev->attached) {
+		list_del(&mergedev->node);
+		put_device(&mergedev->dev);
+	}
+}
+
+static const struct input_device_id mergedev_ids[] = {
+	{ .driver_info = 1 },	/* Matches all devices */
+	{ },			/* Terminating zero entry */
+};
+
+MODULE_DEVICE_TABLE(input, mergedev_ids);
+
+static struct input_handler mergedev_handler = {
+	.event		= mergedev_event,
+	.events		= mergedev_events,
+	.group_sync	= mergedev_group_sync,
+	.connect	= mergedev_connect,
+	.disconnect	= mergedev_disconnect,
+	.name		= "mergedev",
+	.id_table	= mergedev_ids,
+};
+
+static int __init mergedev_init(void)
+{
+	return input_register_handler(&mergedev_handler);
+}
+
+static void __exit mergedev_exit(void)
+{
+	input_unregister_handler(&mergedev_handler);
+}
+
+module_init(mergedev_init);
+module_exit(mergedev_exit);
+
+MODULE_DESCRIPTION("Input driver merged event char devices");
+MODULE_LICENSE("GPL");
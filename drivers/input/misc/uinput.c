@@ -33,6 +33,7 @@
 #define UINPUT_NAME		"uinput"
 #define UINPUT_BUFFER_SIZE	16
 #define UINPUT_NUM_REQUESTS	16
+#define UINPUT_WRITE_BATCH	64	/* events injected under one lock hold */
 
 enum uinput_state { UIST_NEW_DEVICE, UIST_SETUP_COMPLETE, UIST_CREATED };
 
@@ -52,6 +53,17 @@ struct uinput_request {
 	} u;
 };
 
+/*
+ * Upload of an effect in UI_SET_FF_ASYNC mode. Uploads of the same effect
+ * replace each other until userspace begins handling them.
+ */
+struct uinput_ff_async {
+	struct ff_effect	effect;	/* latest upload */
+	struct ff_effect	sent;	/* last upload handed to userspace */
+	bool			pending;
+	bool			has_sent;	/* protected by requests_lock */
+};
+
 struct uinput_device {
 	struct input_dev	*dev;
 	struct mutex		mutex;
@@ -63,6 +75,10 @@ struct uinput_device {
 	struct input_event	buff[UINPUT_BUFFER_SIZE];
 	unsigned int		ff_effects_max;
 
+	bool			ff_async;
+	unsigned int		ff_async_pending;
+	struct uinput_ff_async	*ff_async_effects;
+
 	struct uinput_request	*requests[UINPUT_NUM_REQUESTS];
 	wait_queue_head_t	requests_waitq;
 	spinlock_t		requests_lock;
@@ -214,6 +230,102 @@ static void uinput_flush_requests(struct uinput_device *udev)
 	}
 
 	spin_unlock(&udev->requests_lock);
+
+	/* and uploads waiting for room in UI_SET_FF_ASYNC mode */
+	wake_up(&udev->requests_waitq);
+}
+
+/*
+ * Asynchronous uploads are reported with request IDs above those of the
+ * synchronous requests, one per effect, so that userspace sees each effect
+ * at most once however often it is updated. At most UINPUT_NUM_REQUESTS
+ * effects are waiting for userspace at any time, further uploads wait for
+ * room.
+ */
+static int uinput_ff_upload_async(struct uinput_device *udev,
+				  struct ff_effect *effect)
+{
+	struct uinput_ff_async *slot;
+	int retval;
+
+	for (;;) {
+		retval = mutex_lock_interruptible(&udev->mutex);
+		if (retval)
+			return retval;
+
+		if (udev->state != UIST_CREATED) {
+			retval = -ENODEV;
+			goto out;
+		}
+
+		slot = &udev->ff_async_effects[effect->id];
+		if (slot->pending ||
+		    udev->ff_async_pending < UINPUT_NUM_REQUESTS)
+			break;
+
+		mutex_unlock(&udev->mutex);
+
+		retval = wait_event_interruptible(udev->requests_waitq,
+				READ_ONCE(udev->ff_async_pending) <
+					UINPUT_NUM_REQUESTS ||
+				READ_ONCE(udev->state) != UIST_CREATED);
+		if (retval)
+			return retval;
+	}
+
+	slot->effect = *effect;
+	if (!slot->pending) {
+		slot->pending = true;
+		udev->ff_async_pending++;
+		uinput_dev_event(udev->dev, EV_UINPUT, UI_FF_UPLOAD,
+				 UINPUT_NUM_REQUESTS + effect->id);
+	}
+
+ out:
+	mutex_unlock(&udev->mutex);
+	return retval;
+}
+
+/* Called with udev->mutex held. */
+static struct uinput_ff_async *uinput_ff_async_find(struct uinput_device *udev,
+						    unsigned int request_id)
+{
+	unsigned int id = request_id - UINPUT_NUM_REQUESTS;
+
+	if (!udev->ff_async_effects || request_id < UINPUT_NUM_REQUESTS ||
+	    id >= udev->ff_effects_max)
+		return NULL;
+
+	return &udev->ff_async_effects[id];
+}
+
+/* Called with udev->mutex held. */
+static int uinput_ff_async_begin(struct uinput_device *udev,
+				 struct uinput_ff_upload *ff_up)
+{
+	struct uinput_ff_async *slot;
+
+	slot = uinput_ff_async_find(udev, ff_up->request_id);
+	if (!slot || !slot->pending)
+		return -EINVAL;
+
+	ff_up->retval = 0;
+	ff_up->effect = slot->effect;
+
+	spin_lock(&udev->requests_lock);
+	if (slot->has_sent)
+		ff_up->old = slot->sent;
+	else
+		memset(&ff_up->old, 0, sizeof(struct ff_effect));
+	slot->has_sent = true;
+	spin_unlock(&udev->requests_lock);
+
+	slot->sent = slot->effect;
+	slot->pending = false;
+	udev->ff_async_pending--;
+	wake_up(&udev->requests_waitq);
+
+	return 0;
 }
 
 static void uinput_dev_set_gain(struct input_dev *dev, u16 gain)
@@ -249,6 +361,9 @@ static int uinput_dev_upload_effect(struct input_dev *dev,
 			effect->u.periodic.waveform == FF_CUSTOM)
 		return -EINVAL;
 
+	if (udev->ff_async)
+		return uinput_ff_upload_async(udev, effect);
+
 	request.code = UI_FF_UPLOAD;
 	request.u.upload.effect = effect;
 	request.u.upload.old = old;
@@ -260,6 +375,7 @@ static int uinput_dev_erase_effect(struct input_dev *dev, int effect_id)
 {
 	struct uinput_device *udev = input_get_drvdata(dev);
 	struct uinput_request request;
+	int retval;
 
 	if (!test_bit(EV_FF, dev->evbit))
 		return -ENOSYS;
@@ -267,7 +383,21 @@ static int uinput_dev_erase_effect(struct input_dev *dev, int effect_id)
 	request.code = UI_FF_ERASE;
 	request.u.effect_id = effect_id;
 
-	return uinput_request_submit(udev, &request);
+	retval = uinput_request_submit(udev, &request);
+
+	/*
+	 * The next upload of this ID is of a new effect. This runs under
+	 * evdev->mutex, which UI_DEV_DESTROY takes inside udev->mutex, so
+	 * only requests_lock may be taken here. The effects array lives as
+	 * long as the device is registered.
+	 */
+	if (!retval && udev->ff_async) {
+		spin_lock(&udev->requests_lock);
+		udev->ff_async_effects[effect_id].has_sent = false;
+		spin_unlock(&udev->requests_lock);
+	}
+
+	return retval;
 }
 
 static int uinput_dev_flush(struct input_dev *dev, struct file *file)
@@ -303,6 +433,10 @@ static void uinput_destroy_device(struct uinput_device *udev)
 		kfree(phys);
 		udev->dev = NULL;
 	}
+
+	kfree(udev->ff_async_effects);
+	udev->ff_async_effects = NULL;
+	udev->ff_async_pending = 0;
 }
 
 static int uinput_create_device(struct uinput_device *udev)
@@ -340,6 +474,16 @@ static int uinput_create_device(struct uinput_device *udev)
 	}
 
 	if (udev->ff_effects_max) {
+		if (udev->ff_async) {
+			udev->ff_async_effects = kcalloc(udev->ff_effects_max,
+					sizeof(*udev->ff_async_effects),
+					GFP_KERNEL);
+			if (!udev->ff_async_effects) {
+				error = -ENOMEM;
+				goto fail1;
+			}
+		}
+
 		error = input_ff_create(dev, udev->ff_effects_max);
 		if (error)
 			goto fail1;
@@ -572,24 +716,37 @@ static int uinput_setup_device_legacy(struct uinput_device *udev,
 static ssize_t uinput_inject_events(struct uinput_device *udev,
 				    const char __user *buffer, size_t count)
 {
+	struct input_value vals[UINPUT_WRITE_BATCH];
 	struct input_event ev;
 	size_t bytes = 0;
+	unsigned int n;
 
 	if (count != 0 && count < input_event_size())
 		return -EINVAL;
 
 	while (bytes + input_event_size() <= count) {
 		/*
-		 * Note that even if some events were fetched successfully
-		 * we are still going to return EFAULT instead of partial
-		 * count to let userspace know that it got it's buffers
-		 * all wrong.
+		 * Fetch a batch and hand it to the input core at once, so
+		 * that a frame written in one go is also injected in one go.
 		 */
-		if (input_event_from_user(buffer + bytes, &ev))
-			return -EFAULT;
+		for (n = 0; n < UINPUT_WRITE_BATCH &&
+			    bytes + input_event_size() <= count; n++) {
+			/*
+			 * Note that even if some events were fetched
+			 * successfully we are still going to return EFAULT
+			 * instead of partial count to let userspace know
+			 * that it got it's buffers all wrong.
+			 */
+			if (input_event_from_user(buffer + bytes, &ev))
+				return -EFAULT;
+
+			vals[n] = (struct input_value) {
+				ev.type, ev.code, ev.value
+			};
+			bytes += input_event_size();
+		}
 
-		input_event(udev->dev, ev.type, ev.code, ev.value);
-		bytes += input_event_size();
+		input_event_values(udev->dev, vals, n);
 		cond_resched();
 	}
 
@@ -936,11 +1093,27 @@ static long uinput_ioctl_handler(struct file *file, unsigned int cmd,
 		udev->dev->phys = phys;
 		goto out;
 
+	case UI_SET_FF_ASYNC:
+		if (udev->state == UIST_CREATED) {
+			retval = -EINVAL;
+			goto out;
+		}
+
+		udev->ff_async = !!arg;
+		goto out;
+
 	case UI_BEGIN_FF_UPLOAD:
 		retval = uinput_ff_upload_from_user(p, &ff_up);
 		if (retval)
 			goto out;
 
+		if (ff_up.request_id >= UINPUT_NUM_REQUESTS) {
+			retval = uinput_ff_async_begin(udev, &ff_up);
+			if (!retval)
+				retval = uinput_ff_upload_to_user(p, &ff_up);
+			goto out;
+		}
+
 		req = uinput_request_find(udev, ff_up.request_id);
 		if (!req || req->code != UI_FF_UPLOAD ||
 		    !req->u.upload.effect) {
@@ -984,6 +1157,13 @@ static long uinput_ioctl_handler(struct file *file, unsigned int cmd,
 		if (retval)
 			goto out;
 
+		/* the upload was acknowledged already */
+		if (ff_up.request_id >= UINPUT_NUM_REQUESTS) {
+			if (!uinput_ff_async_find(udev, ff_up.request_id))
+				retval = -EINVAL;
+			goto out;
+		}
+
 		req = uinput_request_find(udev, ff_up.request_id);
 		if (!req || req->code != UI_FF_UPLOAD ||
 		    !req->u.upload.effect) {
@@ -888,6 +888,9 @@ static struct mousedev *mousedev_create(struct input_dev *dev,
 	mousedev->handle.name = dev_name(&mousedev->dev);
 	mousedev->handle.handler = handler;
 	mousedev->handle.private = mousedev;
+	__set_bit(EV_KEY, mousedev->handle.evbit);
+	__set_bit(EV_REL, mousedev->handle.evbit);
+	__set_bit(EV_ABS, mousedev->handle.evbit);
 
 	mousedev->dev.class = &input_class;
 	if (dev)
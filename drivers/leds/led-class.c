@@ -527,6 +527,225 @@ void devm_led_classdev_unregister(struct device *dev,
 }
 EXPORT_SYMBOL_GPL(devm_led_classdev_unregister);
 
+/*
+ * LED groups. The group device only carries the attributes, it is
+ * allocated here so that it may outlive the driver's struct led_group.
+ */
+static ssize_t led_group_brightness_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct led_group *group = dev_get_drvdata(dev);
+	ssize_t len = 0;
+	unsigned int i;
+
+	mutex_lock(&group->lock);
+	for (i = 0; i < group->num_leds; i++) {
+		led_update_brightness(group->leds[i]);
+		len += sysfs_emit_at(buf, len, "%s%u", i ? " " : "",
+				     group->leds[i]->brightness);
+	}
+	mutex_unlock(&group->lock);
+
+	return len + sysfs_emit_at(buf, len, "\n");
+}
+
+static ssize_t led_group_brightness_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t size)
+{
+	struct led_group *group = dev_get_drvdata(dev);
+	enum led_brightness *brightness;
+	char *str, *cur, *tok;
+	unsigned int i = 0, value;
+	int ret = 0;
+
+	brightness = kcalloc(group->num_leds, sizeof(*brightness), GFP_KERNEL);
+	str = kstrdup(buf, GFP_KERNEL);
+	if (!brightness || !str) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	cur = strim(str);
+	while ((tok = strsep(&cur, " \t")) != NULL) {
+		if (!*tok)
+			continue;
+		if (i == group->num_leds || kstrtouint(tok, 0, &value)) {
+			ret = -EINVAL;
+			goto out;
+		}
+		brightness[i++] = value;
+	}
+	if (i != group->num_leds) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	ret = led_group_set_brightness(group, brightness);
+out:
+	kfree(str);
+	kfree(brightness);
+	return ret ? ret : size;
+}
+static struct device_attribute dev_attr_group_brightness =
+	__ATTR(brightness, 0644, led_group_brightness_show,
+	       led_group_brightness_store);
+
+static ssize_t leds_show(struct device *dev, struct device_attribute *attr,
+			 char *buf)
+{
+	struct led_group *group = dev_get_drvdata(dev);
+	ssize_t len = 0;
+	unsigned int i;
+
+	for (i = 0; i < group->num_leds; i++)
+		len += sysfs_emit_at(buf, len, "%s\n", group->leds[i]->name);
+
+	return len;
+}
+static DEVICE_ATTR_RO(leds);
+
+static struct attribute *led_group_attrs[] = {
+	&dev_attr_group_brightness.attr,
+	&dev_attr_leds.attr,
+	NULL,
+};
+ATTRIBUTE_GROUPS(led_group);
+
+/**
+ * led_group_set_brightness - set the brightness of all the LEDs of a group
+ * @group: the group
+ * @brightness: one value per LED, in the order of @group->leds
+ *
+ * Stops software blinking of the LEDs, clamps the values to their
+ * max_brightness and calls @group->brightness_set once. May sleep.
+ *
+ * Returns: 0 on success or negative error value on failure
+ */
+int led_group_set_brightness(struct led_group *group,
+			     const enum led_brightness *brightness)
+{
+	enum led_brightness *values;
+	struct led_classdev *led_cdev;
+	unsigned int i;
+	int ret;
+
+	values = kmemdup(brightness, group->num_leds * sizeof(*values),
+			 GFP_KERNEL);
+	if (!values)
+		return -ENOMEM;
+
+	mutex_lock(&group->lock);
+	for (i = 0; i < group->num_leds; i++) {
+		led_cdev = group->leds[i];
+		led_stop_software_blink(led_cdev);
+		values[i] = min(values[i], led_cdev->max_brightness);
+	}
+
+	ret = group->brightness_set(group, values);
+	if (!ret)
+		for (i = 0; i < group->num_leds; i++)
+			group->leds[i]->brightness = values[i];
+	mutex_unlock(&group->lock);
+
+	kfree(values);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(led_group_set_brightness);
+
+static void led_group_dev_release(struct device *dev)
+{
+	kfree(dev);
+}
+
+/**
+ * led_group_register - register a group of LEDs
+ * @parent: the device the LEDs belong to
+ * @group: the group, with all fields but the private ones set
+ *
+ * Returns: 0 on success or negative error value on failure
+ */
+int led_group_register(struct device *parent, struct led_group *group)
+{
+	struct device *dev;
+	int ret;
+
+	if (!group->name || !group->num_leds || !group->brightness_set)
+		return -EINVAL;
+
+	dev = kzalloc(sizeof(*dev), GFP_KERNEL);
+	if (!dev)
+		return -ENOMEM;
+
+	mutex_init(&group->lock);
+
+	device_initialize(dev);
+	dev->parent = parent;
+	dev->groups = led_group_groups;
+	dev->release = led_group_dev_release;
+	dev_set_drvdata(dev, group);
+
+	ret = dev_set_name(dev, "%s", group->name);
+	if (!ret)
+		ret = device_add(dev);
+	if (ret) {
+		put_device(dev);
+		return ret;
+	}
+
+	group->dev = dev;
+	return 0;
+}
+EXPORT_SYMBOL_GPL(led_group_register);
+
+/**
+ * led_group_unregister - unregister a group registered with
+ *			  led_group_register()
+ * @group: the group
+ *
+ * Must be called before the LEDs of the group are unregistered.
+ */
+void led_group_unregister(struct led_group *group)
+{
+	device_unregister(group->dev);
+	group->dev = NULL;
+}
+EXPORT_SYMBOL_GPL(led_group_unregister);
+
+static void devm_led_group_release(struct device *dev, void *res)
+{
+	led_group_unregister(*(struct led_group **)res);
+}
+
+/**
+ * devm_led_group_register - resource managed led_group_register()
+ * @parent: the device the LEDs belong to
+ * @group: the group
+ *
+ * The LEDs of the group must be registered with devm before the group,
+ * so that the group goes away first.
+ */
+int devm_led_group_register(struct device *parent, struct led_group *group)
+{
+	struct led_group **dr;
+	int rc;
+
+	dr = devres_alloc(devm_led_group_release, sizeof(*dr), GFP_KERNEL);
+	if (!dr)
+		return -ENOMEM;
+
+	rc = led_group_register(parent, group);
+	if (rc) {
+		devres_free(dr);
+		return rc;
+	}
+
+	*dr = group;
+	devres_add(parent, dr);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(devm_led_group_register);
+
 static int __init leds_init(void)
 {
 	leds_class = class_create(THIS_MODULE, "leds");
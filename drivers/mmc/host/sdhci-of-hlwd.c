@@ -16,8 +16,10 @@
  */
 
 #include <linux/delay.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/mmc/host.h>
+#include "mmc_hsq.h"
 #include "sdhci-pltfm.h"
 
 /*
@@ -26,31 +28,91 @@
 
 /*
  * We need a small delay after each write, or things go horribly wrong.
+ *
+ * Rather than spinning right after the write, remember when the delay
+ * expires and only wait for it on the next register access. Whatever
+ * the CPU does in between, including waiting for the command
+ * interrupt after the final write of a request, then counts towards
+ * the delay.
  */
 #define SDHCI_HLWD_WRITE_DELAY	5 /* usecs */
 
+struct sdhci_hlwd_host {
+	u64 write_done_ns;
+};
+
+static void sdhci_hlwd_wait(struct sdhci_host *host)
+{
+	struct sdhci_pltfm_host *pltfm_host = sdhci_priv(host);
+	struct sdhci_hlwd_host *hlwd = sdhci_pltfm_priv(pltfm_host);
+	s64 left = hlwd->write_done_ns - ktime_get_ns();
+
+	if (left > 0)
+		ndelay(left);
+}
+
+static void sdhci_hlwd_written(struct sdhci_host *host)
+{
+	struct sdhci_pltfm_host *pltfm_host = sdhci_priv(host);
+	struct sdhci_hlwd_host *hlwd = sdhci_pltfm_priv(pltfm_host);
+
+	hlwd->write_done_ns = ktime_get_ns() +
+			      SDHCI_HLWD_WRITE_DELAY * NSEC_PER_USEC;
+}
+
+static u32 sdhci_hlwd_readl(struct sdhci_host *host, int reg)
+{
+	sdhci_hlwd_wait(host);
+	return sdhci_be32bs_readl(host, reg);
+}
+
+static u16 sdhci_hlwd_readw(struct sdhci_host *host, int reg)
+{
+	sdhci_hlwd_wait(host);
+	return sdhci_be32bs_readw(host, reg);
+}
+
+static u8 sdhci_hlwd_readb(struct sdhci_host *host, int reg)
+{
+	sdhci_hlwd_wait(host);
+	return sdhci_be32bs_readb(host, reg);
+}
+
 static void sdhci_hlwd_writel(struct sdhci_host *host, u32 val, int reg)
 {
+	sdhci_hlwd_wait(host);
 	sdhci_be32bs_writel(host, val, reg);
-	udelay(SDHCI_HLWD_WRITE_DELAY);
+	sdhci_hlwd_written(host);
 }
 
 static void sdhci_hlwd_writew(struct sdhci_host *host, u16 val, int reg)
 {
+	sdhci_hlwd_wait(host);
 	sdhci_be32bs_writew(host, val, reg);
-	udelay(SDHCI_HLWD_WRITE_DELAY);
+	sdhci_hlwd_written(host);
 }
 
 static void sdhci_hlwd_writeb(struct sdhci_host *host, u8 val, int reg)
 {
+	sdhci_hlwd_wait(host);
 	sdhci_be32bs_writeb(host, val, reg);
-	udelay(SDHCI_HLWD_WRITE_DELAY);
+	sdhci_hlwd_written(host);
+}
+
+static void sdhci_hlwd_request_done(struct sdhci_host *host,
+				    struct mmc_request *mrq)
+{
+	/* Validate if the request was from software queue firstly. */
+	if (mmc_hsq_finalize_request(host->mmc, mrq))
+		return;
+
+	mmc_request_done(host->mmc, mrq);
 }
 
 static const struct sdhci_ops sdhci_hlwd_ops = {
-	.read_l = sdhci_be32bs_readl,
-	.read_w = sdhci_be32bs_readw,
-	.read_b = sdhci_be32bs_readb,
+	.read_l = sdhci_hlwd_readl,
+	.read_w = sdhci_hlwd_readw,
+	.read_b = sdhci_hlwd_readb,
 	.write_l = sdhci_hlwd_writel,
 	.write_w = sdhci_hlwd_writew,
 	.write_b = sdhci_hlwd_writeb,
@@ -58,6 +120,7 @@ static const struct sdhci_ops sdhci_hlwd_ops = {
 	.set_bus_width = sdhci_set_bus_width,
 	.reset = sdhci_reset,
 	.set_uhs_signaling = sdhci_set_uhs_signaling,
+	.request_done = sdhci_hlwd_request_done,
 };
 
 static const struct sdhci_pltfm_data sdhci_hlwd_pdata = {
@@ -68,7 +131,60 @@ static const struct sdhci_pltfm_data sdhci_hlwd_pdata = {
 
 static int sdhci_hlwd_probe(struct platform_device *pdev)
 {
-	return sdhci_pltfm_register(pdev, &sdhci_hlwd_pdata, 0);
+	struct sdhci_host *host;
+	struct mmc_hsq *hsq;
+	int ret;
+
+	host = sdhci_pltfm_init(pdev, &sdhci_hlwd_pdata,
+				sizeof(struct sdhci_hlwd_host));
+	if (IS_ERR(host))
+		return PTR_ERR(host);
+
+	sdhci_get_property(pdev);
+
+	/*
+	 * Use the host software queue, so the block layer maps and queues
+	 * the next request while the current one is transferring, and the
+	 * next command is sent as soon as the current one completes. The
+	 * slot is removable, so as on sdhci-sprd requests are completed,
+	 * and the next one issued, from the interrupt thread rather than
+	 * from hard interrupt context.
+	 */
+	host->always_defer_done = true;
+
+	hsq = devm_kzalloc(&pdev->dev, sizeof(*hsq), GFP_KERNEL);
+	if (!hsq) {
+		ret = -ENOMEM;
+		goto err_free;
+	}
+
+	ret = mmc_hsq_init(hsq, host->mmc);
+	if (ret)
+		goto err_free;
+
+	ret = sdhci_add_host(host);
+	if (ret)
+		goto err_free;
+
+	return 0;
+
+err_free:
+	sdhci_pltfm_free(pdev);
+	return ret;
+}
+
+/*
+ * Stop the controller before a kexec, so it neither raises interrupts nor
+ * transfers into memory that the next kernel already owns.
+ */
+static void sdhci_hlwd_shutdown(struct platform_device *pdev)
+{
+	struct sdhci_host *host = platform_get_drvdata(pdev);
+
+	disable_irq(host->irq);
+	sdhci_writel(host, 0, SDHCI_INT_ENABLE);
+	sdhci_writel(host, 0, SDHCI_SIGNAL_ENABLE);
+	sdhci_reset(host, SDHCI_RESET_ALL);
 }
 
 static const struct of_device_id sdhci_hlwd_of_match[] = {
@@ -86,6 +202,7 @@ static struct platform_driver sdhci_hlwd_driver = {
 	},
 	.probe = sdhci_hlwd_probe,
 	.remove = sdhci_pltfm_unregister,
+	.shutdown = sdhci_hlwd_shutdown,
 };
 
 module_platform_driver(sdhci_hlwd_driver);
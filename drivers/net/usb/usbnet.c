@@ -29,10 +29,13 @@
 #include <linux/workqueue.h>
 #include <linux/mii.h>
 #include <linux/usb.h>
+#include <linux/usb/hcd.h>
 #include <linux/usb/usbnet.h>
 #include <linux/slab.h>
 #include <linux/kernel.h>
 #include <linux/pm_runtime.h>
+#include <linux/dma-mapping.h>
+#include <net/page_pool.h>
 
 /*-------------------------------------------------------------------------*/
 
@@ -72,6 +75,13 @@ static int msg_level = -1;
 module_param (msg_level, int, 0);
 MODULE_PARM_DESC (msg_level, "Override default message level");
 
+static bool rx_page_pool = true;
+module_param(rx_page_pool, bool, 0644);
+MODULE_PARM_DESC(rx_page_pool, "Recycle rx buffers through a page pool");
+
+/* largest rx buffer taken from the page pool, 32k with 4k pages */
+#define RX_POOL_MAX_ORDER	3
+
 /*-------------------------------------------------------------------------*/
 
 static const char * const usbnet_event_names[] = {
@@ -479,6 +489,118 @@ EXPORT_SYMBOL_GPL(usbnet_defer_kevent);
 
 static void rx_complete (struct urb *urb);
 
+static unsigned int rx_headroom(struct usbnet *dev)
+{
+	if (test_bit(EVENT_NO_IP_ALIGN, &dev->flags))
+		return NET_SKB_PAD;
+	return NET_SKB_PAD + NET_IP_ALIGN;
+}
+
+/* Called at open, rx_urb_size is final by then. Without a pool, rx
+ * buffers are allocated as before.
+ */
+static void rx_pool_create(struct usbnet *dev)
+{
+	struct usb_hcd *hcd = bus_to_hcd(dev->udev->bus);
+	struct page_pool_params pp = {
+		.pool_size	= max_t(unsigned int, 2 * RX_QLEN(dev), 64),
+		.nid		= NUMA_NO_NODE,
+	};
+	struct page_pool *pool;
+	unsigned int len;
+
+	if (!rx_page_pool)
+		return;
+
+	len = SKB_DATA_ALIGN(NET_SKB_PAD + NET_IP_ALIGN + dev->rx_urb_size);
+	pp.order = get_order(len + SKB_DATA_ALIGN(sizeof(struct skb_shared_info)));
+	if (pp.order > RX_POOL_MAX_ORDER)
+		return;
+
+	/* pages are mapped once, unless the HCD has its own ideas about
+	 * where transfer buffers must be
+	 */
+	if (hcd_uses_dma(hcd) && !hcd->localmem_pool &&
+	    !hcd->driver->map_urb_for_dma) {
+		pp.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV;
+		pp.dev = hcd->self.sysdev;
+		pp.dma_dir = DMA_FROM_DEVICE;
+		pp.max_len = len;
+	}
+
+	pool = page_pool_create(&pp);
+	if (IS_ERR(pool)) {
+		netif_dbg(dev, ifup, dev->net, "no rx page pool, %ld\n",
+			  PTR_ERR(pool));
+		return;
+	}
+
+	spin_lock_irq(&dev->rx_pool_lock);
+	dev->rx_pool = pool;
+	dev->rx_pool_len = len;
+	dev->rx_dma_dev = pp.dev;
+	spin_unlock_irq(&dev->rx_pool_lock);
+}
+
+/* Pages still with the stack or in flight keep the pool around until
+ * they are returned.
+ */
+static void rx_pool_destroy(struct usbnet *dev)
+{
+	struct page_pool *pool;
+
+	spin_lock_irq(&dev->rx_pool_lock);
+	pool = dev->rx_pool;
+	dev->rx_pool = NULL;
+	spin_unlock_irq(&dev->rx_pool_lock);
+
+	page_pool_destroy(pool);
+}
+
+/* Build an rx skb around a page pool buffer, which goes back to the pool
+ * when the skb is freed. NULL if there is no pool or no buffer of @size.
+ */
+static struct sk_buff *rx_pool_alloc_skb(struct usbnet *dev, struct urb *urb,
+					 size_t size)
+{
+	unsigned int headroom = rx_headroom(dev);
+	struct page_pool *pool;
+	struct page *page = NULL;
+	struct sk_buff *skb;
+	unsigned long flags;
+
+	/* page_pool allocations must not run concurrently */
+	spin_lock_irqsave(&dev->rx_pool_lock, flags);
+	pool = dev->rx_pool;
+	if (pool) {
+		if (headroom + size <= dev->rx_pool_len)
+			page = page_pool_alloc_pages(pool,
+						     GFP_ATOMIC | __GFP_NOWARN);
+		if (page)
+			dev->rx_pool_skbs++;
+		else
+			dev->rx_pool_fallbacks++;
+	}
+	spin_unlock_irqrestore(&dev->rx_pool_lock, flags);
+	if (!page)
+		return NULL;
+
+	skb = build_skb(page_address(page), PAGE_SIZE << pool->p.order);
+	if (!skb) {
+		page_pool_put_full_page(pool, page, false);
+		return NULL;
+	}
+	skb_reserve(skb, headroom);
+	skb_mark_for_recycle(skb);
+	skb->dev = dev->net;
+
+	if (pool->p.flags & PP_FLAG_DMA_MAP) {
+		urb->transfer_dma = page_pool_get_dma_addr(page) + headroom;
+		urb->transfer_flags |= URB_NO_TRANSFER_DMA_MAP;
+	}
+	return skb;
+}
+
 static int rx_submit (struct usbnet *dev, struct urb *urb, gfp_t flags)
 {
 	struct sk_buff		*skb;
@@ -493,10 +615,15 @@ static int rx_submit (struct usbnet *dev, struct urb *urb, gfp_t flags)
 		return -ENOLINK;
 	}
 
-	if (test_bit(EVENT_NO_IP_ALIGN, &dev->flags))
-		skb = __netdev_alloc_skb(dev->net, size, flags);
-	else
-		skb = __netdev_alloc_skb_ip_align(dev->net, size, flags);
+	urb->transfer_flags &= ~URB_NO_TRANSFER_DMA_MAP;
+	skb = rx_pool_alloc_skb(dev, urb, size);
+	if (!skb) {
+		if (test_bit(EVENT_NO_IP_ALIGN, &dev->flags))
+			skb = __netdev_alloc_skb(dev->net, size, flags);
+		else
+			skb = __netdev_alloc_skb_ip_align(dev->net, size,
+							  flags);
+	}
 	if (!skb) {
 		netif_dbg(dev, rx_err, dev->net, "no rx skb\n");
 		usbnet_defer_kevent (dev, EVENT_RX_MEMORY);
@@ -594,6 +721,11 @@ static void rx_complete (struct urb *urb)
 	int			urb_status = urb->status;
 	enum skb_state		state;
 
+	/* page pool buffers are mapped for as long as they are pooled */
+	if (urb->transfer_flags & URB_NO_TRANSFER_DMA_MAP)
+		dma_sync_single_for_cpu(dev->rx_dma_dev, urb->transfer_dma,
+					urb->actual_length, DMA_FROM_DEVICE);
+
 	skb_put (skb, urb->actual_length);
 	state = rx_done;
 	entry->urb = NULL;
@@ -854,6 +986,7 @@ int usbnet_stop (struct net_device *net)
 	dev->flags = 0;
 	del_timer_sync (&dev->delay);
 	tasklet_kill (&dev->bh);
+	rx_pool_destroy(dev);
 	if (!pm)
 		usb_autopm_put_interface(dev->intf);
 
@@ -918,6 +1051,8 @@ int usbnet_open (struct net_device *net)
 		}
 	}
 
+	rx_pool_create(dev);
+
 	set_bit(EVENT_DEV_OPEN, &dev->flags);
 	netif_start_queue (net);
 	netif_info(dev, ifup, dev->net,
@@ -1060,6 +1195,39 @@ void usbnet_get_drvinfo (struct net_device *net, struct ethtool_drvinfo *info)
 }
 EXPORT_SYMBOL_GPL(usbnet_get_drvinfo);
 
+static const char usbnet_gstrings_stats[][ETH_GSTRING_LEN] = {
+	"rx_pool_skbs",
+	"rx_pool_fallbacks",
+};
+
+int usbnet_get_sset_count(struct net_device *net, int sset)
+{
+	if (sset == ETH_SS_STATS)
+		return ARRAY_SIZE(usbnet_gstrings_stats);
+	return -EOPNOTSUPP;
+}
+EXPORT_SYMBOL_GPL(usbnet_get_sset_count);
+
+void usbnet_get_strings(struct net_device *net, u32 sset, u8 *data)
+{
+	if (sset == ETH_SS_STATS)
+		memcpy(data, usbnet_gstrings_stats,
+		       sizeof(usbnet_gstrings_stats));
+}
+EXPORT_SYMBOL_GPL(usbnet_get_strings);
+
+void usbnet_get_ethtool_stats(struct net_device *net,
+			      struct ethtool_stats *stats, u64 *data)
+{
+	struct usbnet *dev = netdev_priv(net);
+
+	spin_lock_irq(&dev->rx_pool_lock);
+	data[0] = dev->rx_pool_skbs;
+	data[1] = dev->rx_pool_fallbacks;
+	spin_unlock_irq(&dev->rx_pool_lock);
+}
+EXPORT_SYMBOL_GPL(usbnet_get_ethtool_stats);
+
 u32 usbnet_get_msglevel (struct net_device *net)
 {
 	struct usbnet *dev = netdev_priv(net);
@@ -1086,6 +1254,9 @@ static const struct ethtool_ops usbnet_ethtool_ops = {
 	.get_ts_info		= ethtool_op_get_ts_info,
 	.get_link_ksettings	= usbnet_get_link_ksettings_mii,
 	.set_link_ksettings	= usbnet_set_link_ksettings_mii,
+	.get_sset_count		= usbnet_get_sset_count,
+	.get_strings		= usbnet_get_strings,
+	.get_ethtool_stats	= usbnet_get_ethtool_stats,
 };
 
 /*-------------------------------------------------------------------------*/
@@ -1716,6 +1887,7 @@ usbnet_probe (struct usb_interface *udev, const struct usb_device_id *prod)
 	skb_queue_head_init (&dev->txq);
 	skb_queue_head_init (&dev->done);
 	skb_queue_head_init(&dev->rxq_pause);
+	spin_lock_init(&dev->rx_pool_lock);
 	tasklet_setup(&dev->bh, usbnet_bh_tasklet);
 	INIT_WORK (&dev->kevent, usbnet_deferred_kevent);
 	init_usb_anchor(&dev->deferred);
@@ -713,6 +713,27 @@ struct ath_beacon {
 	bool tx_last;
 };
 
+/*
+ * A periodic TX slot for one TID, anchored to the TBTT: outside of the slots
+ * the TID's frames are kept on their mac80211 queues, and the AC is scheduled
+ * as each slot opens, so they go out at a fixed offset from the beacon. The
+ * slots are timed by a TSF generic timer. Set up through debugfs, for AP mode.
+ */
+#define ATH_TX_SLOT_LEAD	1000 /* usec */
+
+struct ath_tx_slot {
+	struct ath_gen_timer *timer;
+	bool active;
+	u8 tid;
+	u32 period;	/* usec */
+	u32 offset;	/* usec from TBTT */
+	u32 len;	/* usec */
+	u32 start;	/* TSF of the current or first slot */
+	bool holding;	/* frames held back since the last slot opened */
+	u32 opened;
+	u32 held;	/* closed periods in which frames were held back */
+};
+
 void ath9k_beacon_tasklet(struct tasklet_struct *t);
 void ath9k_beacon_config(struct ath_softc *sc, struct ieee80211_vif *main_vif,
 			 bool beacons);
@@ -722,6 +743,9 @@ void ath9k_beacon_ensure_primary_slot(struct ath_softc *sc);
 void ath9k_set_beacon(struct ath_softc *sc);
 bool ath9k_csa_is_finished(struct ath_softc *sc, struct ieee80211_vif *vif);
 void ath9k_csa_update(struct ath_softc *sc);
+int ath9k_tx_slot_set(struct ath_softc *sc, int tid, u32 period, u32 offset,
+		      u32 len);
+void ath9k_tx_slot_deinit(struct ath_softc *sc);
 
 /*******************/
 /* Link Monitoring */
@@ -1025,6 +1049,7 @@ struct ath_softc {
 	struct ath_rx rx;
 	struct ath_tx tx;
 	struct ath_beacon beacon;
+	struct ath_tx_slot tx_slot;
 
 	struct cfg80211_chan_def cur_chandef;
 	struct ath_chanctx chanctx[ATH9K_NUM_CHANCTX];
@@ -524,6 +524,131 @@ static void ath9k_beacon_init(struct ath_softc *sc, u32 nexttbtt,
 	ath9k_hw_enable_interrupts(ah);
 }
 
+/************/
+/* TX slots */
+/************/
+
+static void ath9k_tx_slot_open(void *arg)
+{
+	struct ath_softc *sc = arg;
+	struct ath_tx_slot *slot = &sc->tx_slot;
+	struct ath_txq *txq = sc->tx.txq_map[TID_TO_WME_AC(slot->tid)];
+	u32 elapsed;
+
+	/* move on to the slot that just opened, interrupts may be coalesced */
+	elapsed = ath9k_hw_gettsf32(sc->sc_ah) - slot->start;
+	if ((s32)elapsed > 0)
+		slot->start += elapsed - elapsed % slot->period;
+	slot->opened++;
+	slot->holding = false;
+
+	ath_txq_lock(sc, txq);
+	ath_txq_schedule(sc, txq);
+	ath_txq_unlock(sc, txq);
+}
+
+/*
+ * (Re)start the slots at @nexttbtt plus the slot offset. Called whenever
+ * the AP beacon timers are programmed, as a reset stops the timer too.
+ */
+static void ath9k_tx_slot_update(struct ath_softc *sc, u32 nexttbtt,
+				 bool beacons)
+{
+	struct ath_tx_slot *slot = &sc->tx_slot;
+	struct ath_hw *ah = sc->sc_ah;
+	u32 tsf;
+
+	if (!slot->timer)
+		return;
+
+	ath9k_hw_gen_timer_stop(ah, slot->timer);
+	slot->active = false;
+	slot->holding = false;
+
+	if (!beacons || !slot->period)
+		return;
+
+	slot->start = nexttbtt + slot->offset;
+	tsf = ath9k_hw_gettsf32(ah);
+	while ((s32)(slot->start - tsf) < ATH_TX_SLOT_LEAD)
+		slot->start += slot->period;
+
+	ath9k_hw_gen_timer_start(ah, slot->timer, slot->start, slot->period);
+	slot->active = true;
+}
+
+/*
+ * Give @tid a slot of @len usec every @period usec, @offset usec after the
+ * TBTT, or remove the slot with a negative @tid.
+ */
+int ath9k_tx_slot_set(struct ath_softc *sc, int tid, u32 period, u32 offset,
+		      u32 len)
+{
+	struct ath_common *common = ath9k_hw_common(sc->sc_ah);
+	struct ath_beacon_config *conf = &sc->cur_chan->beacon;
+	struct ath_tx_slot *slot = &sc->tx_slot;
+	struct ath_hw *ah = sc->sc_ah;
+	u32 intval, rem;
+	int ret = 0;
+	u64 tsf;
+
+	if (tid >= 0 && (tid >= IEEE80211_NUM_TIDS / 2 || !len ||
+			 len > period || period < ATH_TX_SLOT_LEAD))
+		return -EINVAL;
+
+	mutex_lock(&sc->mutex);
+	ath9k_ps_wakeup(sc);
+
+	if (tid < 0) {
+		if (slot->timer) {
+			ath9k_hw_gen_timer_stop(ah, slot->timer);
+			ath_gen_timer_free(ah, slot->timer);
+		}
+		memset(slot, 0, sizeof(*slot));
+		goto out;
+	}
+
+	if (!slot->timer) {
+		/* the first TSF timer, also used for P2P powersave */
+		if (ah->hw_gen_timers.timers[AR_FIRST_NDP_TIMER]) {
+			ret = -EBUSY;
+			goto out;
+		}
+		slot->timer = ath_gen_timer_alloc(ah, ath9k_tx_slot_open, NULL,
+						  sc, AR_FIRST_NDP_TIMER);
+		if (!slot->timer) {
+			ret = -ENOMEM;
+			goto out;
+		}
+	}
+
+	slot->tid = tid;
+	slot->period = period;
+	slot->offset = offset;
+	slot->len = len;
+
+	intval = TU_TO_USEC(conf->beacon_interval);
+	tsf = ath9k_hw_gettsf64(ah);
+	div_u64_rem(tsf, intval, &rem);
+	ath9k_tx_slot_update(sc, (u32)tsf + intval - rem,
+			     ah->opmode == NL80211_IFTYPE_AP &&
+			     test_bit(ATH_OP_BEACONS, &common->op_flags));
+
+	ath_dbg(common, BEACON, "TX slot for TID %d: %u/%u us at +%u us\n",
+		tid, len, period, offset);
+out:
+	ath9k_ps_restore(sc);
+	mutex_unlock(&sc->mutex);
+
+	return ret;
+}
+
+void ath9k_tx_slot_deinit(struct ath_softc *sc)
+{
+	if (sc->tx_slot.timer)
+		ath_gen_timer_free(sc->sc_ah, sc->tx_slot.timer);
+}
+
 static void ath9k_beacon_stop(struct ath_softc *sc)
 {
 	ath9k_hw_disable_interrupts(sc->sc_ah);
@@ -545,6 +670,7 @@ static void ath9k_beacon_config_ap(struct ath_softc *sc,
 
 	ath9k_cmn_beacon_config_ap(ah, conf, ATH_BCBUF);
 	ath9k_beacon_init(sc, conf->nexttbtt, conf->intval);
+	ath9k_tx_slot_update(sc, conf->nexttbtt, conf->enable_beacon);
 }
 
 static void ath9k_beacon_config_sta(struct ath_hw *ah,
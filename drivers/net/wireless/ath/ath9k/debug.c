@@ -1178,6 +1178,62 @@ static const struct file_operations fops_tpc = {
 	.llseek = default_llseek,
 };
 
+static ssize_t read_file_tx_slot(struct file *file, char __user *user_buf,
+				 size_t count, loff_t *ppos)
+{
+	struct ath_softc *sc = file->private_data;
+	struct ath_tx_slot *slot = &sc->tx_slot;
+	char buf[128];
+	unsigned int len = 0;
+
+	if (slot->period)
+		len += scnprintf(buf + len, sizeof(buf) - len,
+				 "TID %u: %u us every %u us, %u us after TBTT%s\n",
+				 slot->tid, slot->len, slot->period,
+				 slot->offset, slot->active ? "" : " (idle)");
+	else
+		len += scnprintf(buf + len, sizeof(buf) - len, "off\n");
+	len += scnprintf(buf + len, sizeof(buf) - len,
+			 "opened: %u\nheld: %u\n", slot->opened, slot->held);
+
+	return simple_read_from_buffer(user_buf, count, ppos, buf, len);
+}
+
+/* "<tid> <period> <offset> <len>", times in usec, or "off" */
+static ssize_t write_file_tx_slot(struct file *file,
+				  const char __user *user_buf,
+				  size_t count, loff_t *ppos)
+{
+	struct ath_softc *sc = file->private_data;
+	u32 period, offset, len;
+	char buf[64];
+	int tid, ret;
+
+	if (count >= sizeof(buf))
+		return -EINVAL;
+	if (copy_from_user(buf, user_buf, count))
+		return -EFAULT;
+	buf[count] = '\0';
+
+	if (sysfs_streq(buf, "off"))
+		ret = ath9k_tx_slot_set(sc, -1, 0, 0, 0);
+	else if (sscanf(buf, "%d %u %u %u", &tid, &period, &offset, &len) == 4 &&
+		 tid >= 0)
+		ret = ath9k_tx_slot_set(sc, tid, period, offset, len);
+	else
+		ret = -EINVAL;
+
+	return ret ? ret : count;
+}
+
+static const struct file_operations fops_tx_slot = {
+	.read = read_file_tx_slot,
+	.write = write_file_tx_slot,
+	.open = simple_open,
+	.owner = THIS_MODULE,
+	.llseek = default_llseek,
+};
+
 static ssize_t read_file_nf_override(struct file *file,
 				     char __user *user_buf,
 				     size_t count, loff_t *ppos)
@@ -1445,6 +1501,8 @@ int ath9k_init_debug(struct ath_hw *ah)
 			    sc, &fops_ackto);
 #endif
 	debugfs_create_file("tpc", 0600, sc->debug.debugfs_phy, sc, &fops_tpc);
+	debugfs_create_file("tx_slot", 0600, sc->debug.debugfs_phy, sc,
+			    &fops_tx_slot);
 
 	debugfs_create_file("nf_override", 0600,
 			    sc->debug.debugfs_phy, sc, &fops_nf_override);
@@ -68,13 +68,26 @@ static const struct usb_device_id ath9k_hif_usb_ids[] = {
 
 MODULE_DEVICE_TABLE(usb, ath9k_hif_usb_ids);
 
-static int __hif_usb_tx(struct hif_device_usb *hif_dev);
+static int __hif_usb_tx(struct hif_device_usb *hif_dev,
+			enum hif_usb_tx_cause cause);
 
+/*
+ * Register writes go out through a pool of URBs with coherent buffers. The
+ * URBs of the one interrupt pipe complete in order, so the skbs waiting for
+ * their completion are simply queued.
+ */
 static void hif_usb_regout_cb(struct urb *urb)
 {
-	struct cmd_buf *cmd = (struct cmd_buf *)urb->context;
+	struct hif_device_usb *hif_dev = urb->context;
+	struct sk_buff *skb = skb_dequeue(&hif_dev->regout_queue);
+	int status = urb->status;
 
-	switch (urb->status) {
+	usb_urb_pool_put(hif_dev->regout_pool, urb);
+
+	if (!skb)
+		return;
+
+	switch (status) {
 	case 0:
 		break;
 	case -ENOENT:
@@ -86,50 +99,41 @@ static void hif_usb_regout_cb(struct urb *urb)
 		break;
 	}
 
-	if (cmd) {
-		ath9k_htc_txcompletion_cb(cmd->hif_dev->htc_handle,
-					  cmd->skb, true);
-		kfree(cmd);
-	}
-
+	ath9k_htc_txcompletion_cb(hif_dev->htc_handle, skb, true);
 	return;
 free:
-	kfree_skb(cmd->skb);
-	kfree(cmd);
+	kfree_skb(skb);
 }
 
 static int hif_usb_send_regout(struct hif_device_usb *hif_dev,
 			       struct sk_buff *skb)
 {
 	struct urb *urb;
-	struct cmd_buf *cmd;
 	int ret = 0;
 
-	urb = usb_alloc_urb(0, GFP_KERNEL);
-	if (urb == NULL)
-		return -ENOMEM;
+	if (!hif_dev->regout_pool)
+		return -ENODEV;
 
-	cmd = kzalloc(sizeof(*cmd), GFP_KERNEL);
-	if (cmd == NULL) {
-		usb_free_urb(urb);
-		return -ENOMEM;
-	}
+	if (skb->len > MAX_REG_OUT_BUF_SIZE)
+		return -EMSGSIZE;
 
-	cmd->skb = skb;
-	cmd->hif_dev = hif_dev;
+	urb = usb_urb_pool_get(hif_dev->regout_pool);
+	if (urb == NULL)
+		return -EBUSY;
+
+	memcpy(urb->transfer_buffer, skb->data, skb->len);
 
 	usb_fill_int_urb(urb, hif_dev->udev,
 			 usb_sndintpipe(hif_dev->udev, USB_REG_OUT_PIPE),
-			 skb->data, skb->len,
-			 hif_usb_regout_cb, cmd, 1);
+			 urb->transfer_buffer, skb->len,
+			 hif_usb_regout_cb, hif_dev, 1);
 
-	usb_anchor_urb(urb, &hif_dev->regout_submitted);
+	skb_queue_tail(&hif_dev->regout_queue, skb);
 	ret = usb_submit_urb(urb, GFP_KERNEL);
 	if (ret) {
-		usb_unanchor_urb(urb);
-		kfree(cmd);
+		skb_unlink(skb, &hif_dev->regout_queue);
+		usb_urb_pool_put(hif_dev->regout_pool, urb);
 	}
-	usb_free_urb(urb);
 
 	return ret;
 }
@@ -301,13 +305,15 @@ static void hif_usb_tx_cb(struct urb *urb)
 	list_move_tail(&tx_buf->list, &hif_dev->tx.tx_buf);
 	hif_dev->tx.tx_buf_cnt++;
 	if (!(hif_dev->tx.flags & HIF_USB_TX_STOP))
-		__hif_usb_tx(hif_dev); /* Check for pending SKBs */
+		/* Check for pending SKBs */
+		__hif_usb_tx(hif_dev, HIF_USB_TX_CAUSE_COMPLETE);
 	TX_STAT_INC(buf_completed);
 	spin_unlock(&hif_dev->tx.tx_lock);
 }
 
 /* TX lock has to be taken */
-static int __hif_usb_tx(struct hif_device_usb *hif_dev)
+static int __hif_usb_tx(struct hif_device_usb *hif_dev,
+			enum hif_usb_tx_cause cause)
 {
 	struct tx_buf *tx_buf = NULL;
 	struct sk_buff *nskb = NULL;
@@ -330,12 +336,18 @@ static int __hif_usb_tx(struct hif_device_usb *hif_dev)
 	tx_skb_cnt = min_t(u16, hif_dev->tx.tx_skb_cnt, MAX_TX_AGGR_NUM);
 
 	for (i = 0; i < tx_skb_cnt; i++) {
-		nskb = __skb_dequeue(&hif_dev->tx.tx_skb_queue);
+		nskb = skb_peek(&hif_dev->tx.tx_skb_queue);
 
 		/* Should never be NULL */
 		BUG_ON(!nskb);
 
+		/* The rest goes into the next URB */
+		if (tx_buf->offset + nskb->len + 4 > MAX_TX_BUF_SIZE)
+			break;
+
+		__skb_unlink(nskb, &hif_dev->tx.tx_skb_queue);
 		hif_dev->tx.tx_skb_cnt--;
+		hif_dev->tx.tx_skb_bytes -= nskb->len;
 
 		buf = tx_buf->buf;
 		buf += tx_buf->offset;
@@ -344,13 +356,8 @@ static int __hif_usb_tx(struct hif_device_usb *hif_dev)
 		*hdr++ = cpu_to_le16(ATH_USB_TX_STREAM_MODE_TAG);
 		buf += 4;
 		memcpy(buf, nskb->data, nskb->len);
-		tx_buf->len = nskb->len + 4;
-
-		if (i < (tx_skb_cnt - 1))
-			tx_buf->offset += (((tx_buf->len - 1) / 4) + 1) * 4;
-
-		if (i == (tx_skb_cnt - 1))
-			tx_buf->len += tx_buf->offset;
+		tx_buf->len = tx_buf->offset + nskb->len + 4;
+		tx_buf->offset += ALIGN(nskb->len + 4, 4);
 
 		__skb_queue_tail(&tx_buf->skb_queue, nskb);
 		TX_STAT_INC(skb_queued);
@@ -370,12 +377,28 @@ static int __hif_usb_tx(struct hif_device_usb *hif_dev)
 		hif_dev->tx.tx_buf_cnt++;
 	}
 
-	if (!ret)
+	if (!ret) {
 		TX_STAT_INC(buf_queued);
+		TX_STAT_INC(buf_cause[cause]);
+	}
 
 	return ret;
 }
 
+static enum hrtimer_restart hif_usb_tx_flush_timer(struct hrtimer *timer)
+{
+	struct hif_device_usb *hif_dev =
+		container_of(timer, struct hif_device_usb, tx.flush_timer);
+	unsigned long flags;
+
+	spin_lock_irqsave(&hif_dev->tx.tx_lock, flags);
+	if (!(hif_dev->tx.flags & HIF_USB_TX_STOP))
+		__hif_usb_tx(hif_dev, HIF_USB_TX_CAUSE_TIMER);
+	spin_unlock_irqrestore(&hif_dev->tx.tx_lock, flags);
+
+	return HRTIMER_NORESTART;
+}
+
 static int hif_usb_send_tx(struct hif_device_usb *hif_dev, struct sk_buff *skb)
 {
 	struct ath9k_htc_tx_ctl *tx_ctl;
@@ -411,12 +434,25 @@ static int hif_usb_send_tx(struct hif_device_usb *hif_dev, struct sk_buff *skb)
 	    (tx_ctl->type == ATH9K_HTC_AMPDU)) {
 		__skb_queue_tail(&hif_dev->tx.tx_skb_queue, skb);
 		hif_dev->tx.tx_skb_cnt++;
+		hif_dev->tx.tx_skb_bytes += skb->len;
 	}
 
-	/* Check if AMPDUs have to be sent immediately */
+	/*
+	 * Send right away to an idle bus, otherwise batch frames until
+	 * enough are queued, an URB completes, or the flush timer fires.
+	 */
 	if ((hif_dev->tx.tx_buf_cnt == MAX_TX_URB_NUM) &&
 	    (hif_dev->tx.tx_skb_cnt < 2)) {
-		__hif_usb_tx(hif_dev);
+		__hif_usb_tx(hif_dev, HIF_USB_TX_CAUSE_IDLE);
+	} else if (hif_dev->tx.tx_skb_cnt >= MAX_TX_AGGR_NUM) {
+		__hif_usb_tx(hif_dev, HIF_USB_TX_CAUSE_COUNT);
+	} else if (hif_dev->tx.tx_skb_bytes >= TX_FLUSH_BYTES) {
+		__hif_usb_tx(hif_dev, HIF_USB_TX_CAUSE_SIZE);
+	} else if (hif_dev->tx.tx_skb_cnt &&
+		   !hrtimer_active(&hif_dev->tx.flush_timer)) {
+		hrtimer_start(&hif_dev->tx.flush_timer,
+			      ns_to_ktime(TX_FLUSH_USEC * NSEC_PER_USEC),
+			      HRTIMER_MODE_REL_SOFT);
 	}
 
 	spin_unlock_irqrestore(&hif_dev->tx.tx_lock, flags);
@@ -445,9 +481,12 @@ static void hif_usb_stop(void *hif_handle)
 	spin_lock_irqsave(&hif_dev->tx.tx_lock, flags);
 	ath9k_skb_queue_complete(hif_dev, &hif_dev->tx.tx_skb_queue, false);
 	hif_dev->tx.tx_skb_cnt = 0;
+	hif_dev->tx.tx_skb_bytes = 0;
 	hif_dev->tx.flags |= HIF_USB_TX_STOP;
 	spin_unlock_irqrestore(&hif_dev->tx.tx_lock, flags);
 
+	hrtimer_cancel(&hif_dev->tx.flush_timer);
+
 	/* The pending URBs have to be canceled. */
 	spin_lock_irqsave(&hif_dev->tx.tx_lock, flags);
 	list_for_each_entry_safe(tx_buf, tx_buf_tmp,
@@ -512,9 +551,10 @@ static void hif_usb_sta_drain(void *hif_handle, u8 idx)
 	skb_queue_walk_safe(&hif_dev->tx.tx_skb_queue, skb, tmp) {
 		if (check_index(skb, idx)) {
 			__skb_unlink(skb, &hif_dev->tx.tx_skb_queue);
+			hif_dev->tx.tx_skb_cnt--;
+			hif_dev->tx.tx_skb_bytes -= skb->len;
 			ath9k_htc_txcompletion_cb(hif_dev->htc_handle,
 						  skb, false);
-			hif_dev->tx.tx_skb_cnt--;
 			TX_STAT_INC(skb_failed);
 		}
 	}
@@ -535,11 +575,88 @@ static struct ath9k_htc_hif hif_usb = {
 	.send = hif_usb_send,
 };
 
+/*
+ * Get a buffer for an RX URB, preferring one whose frames have all been
+ * freed by the stack over a new allocation.
+ */
+static struct page *ath9k_hif_usb_rx_get_page(struct hif_device_usb *hif_dev)
+{
+	struct page *page;
+	int i;
+
+	spin_lock(&hif_dev->rx_lock);
+	for (i = 0; i < RX_PAGE_CACHE_NUM; i++) {
+		page = hif_dev->rx_page_cache[i];
+		if (page && page_ref_count(page) == 1) {
+			hif_dev->rx_page_cache[i] = NULL;
+			spin_unlock(&hif_dev->rx_lock);
+			return page;
+		}
+	}
+	spin_unlock(&hif_dev->rx_lock);
+
+	return dev_alloc_pages(RX_BUF_ORDER);
+}
+
+static void ath9k_hif_usb_rx_put_page(struct hif_device_usb *hif_dev,
+				      struct page *page)
+{
+	int i;
+
+	spin_lock(&hif_dev->rx_lock);
+	for (i = 0; i < RX_PAGE_CACHE_NUM; i++) {
+		if (!hif_dev->rx_page_cache[i]) {
+			hif_dev->rx_page_cache[i] = page;
+			spin_unlock(&hif_dev->rx_lock);
+			return;
+		}
+	}
+	spin_unlock(&hif_dev->rx_lock);
+
+	put_page(page);
+}
+
+static struct sk_buff *ath9k_hif_usb_rx_frame(struct hif_device_usb *hif_dev,
+					      struct rx_buf *rx_buf,
+					      int offset, u16 pkt_len)
+{
+	u8 *data = (u8 *)page_address(rx_buf->page) + offset;
+	struct sk_buff *nskb;
+	u16 copy = pkt_len;
+
+	/*
+	 * Leave large frames in the URB buffer, the URB is resubmitted
+	 * with a replacement buffer. Without one, copy.
+	 */
+	if (pkt_len > RX_COPY_LEN) {
+		if (!rx_buf->next_page)
+			rx_buf->next_page = ath9k_hif_usb_rx_get_page(hif_dev);
+		if (rx_buf->next_page)
+			copy = RX_HEAD_LEN;
+	}
+
+	nskb = __dev_alloc_skb(copy + 32, GFP_ATOMIC);
+	if (!nskb)
+		return NULL;
+	skb_reserve(nskb, 32);
+	RX_STAT_INC(skb_allocated);
+
+	skb_put_data(nskb, data, copy);
+	if (copy < pkt_len) {
+		get_page(rx_buf->page);
+		skb_add_rx_frag(nskb, 0, rx_buf->page, offset + copy,
+				pkt_len - copy, pkt_len - copy);
+	}
+
+	return nskb;
+}
+
 static void ath9k_hif_usb_rx_stream(struct hif_device_usb *hif_dev,
-				    struct sk_buff *skb)
+				    struct rx_buf *rx_buf, int len)
 {
 	struct sk_buff *nskb, *skb_pool[MAX_PKT_NUM_IN_TRANSFER];
-	int index = 0, i, len = skb->len;
+	u8 *buf = page_address(rx_buf->page);
+	int index = 0, i;
 	int rx_remain_len, rx_pkt_len;
 	u16 pool_index = 0;
 	u8 *ptr;
@@ -559,7 +676,7 @@ static void ath9k_hif_usb_rx_stream(struct hif_device_usb *hif_dev,
 			rx_remain_len -= hif_dev->rx_pad_len;
 			ptr += rx_pkt_len;
 
-			memcpy(ptr, skb->data, rx_remain_len);
+			memcpy(ptr, buf, rx_remain_len);
 
 			rx_pkt_len += rx_remain_len;
 			hif_dev->rx_remain_len = 0;
@@ -580,14 +697,12 @@ static void ath9k_hif_usb_rx_stream(struct hif_device_usb *hif_dev,
 		u16 pad_len;
 		int chk_idx;
 
-		ptr = (u8 *) skb->data;
-
-		pkt_len = get_unaligned_le16(ptr + index);
-		pkt_tag = get_unaligned_le16(ptr + index + 2);
+		pkt_len = get_unaligned_le16(buf + index);
+		pkt_tag = get_unaligned_le16(buf + index + 2);
 
 		if (pkt_tag != ATH_USB_RX_STREAM_MODE_TAG) {
 			RX_STAT_INC(skb_dropped);
-			return;
+			goto err;
 		}
 
 		pad_len = 4 - (pkt_len & 0x3);
@@ -614,7 +729,7 @@ static void ath9k_hif_usb_rx_stream(struct hif_device_usb *hif_dev,
 			skb_reserve(nskb, 32);
 			RX_STAT_INC(skb_allocated);
 
-			memcpy(nskb->data, &(skb->data[chk_idx+4]),
+			memcpy(nskb->data, &buf[chk_idx + 4],
 			       hif_dev->rx_transfer_len);
 
 			/* Record the buffer pointer */
@@ -626,17 +741,13 @@ static void ath9k_hif_usb_rx_stream(struct hif_device_usb *hif_dev,
 					"ath9k_htc: over RX MAX_PKT_NUM\n");
 				goto err;
 			}
-			nskb = __dev_alloc_skb(pkt_len + 32, GFP_ATOMIC);
+			nskb = ath9k_hif_usb_rx_frame(hif_dev, rx_buf,
+						      chk_idx + 4, pkt_len);
 			if (!nskb) {
 				dev_err(&hif_dev->udev->dev,
 					"ath9k_htc: RX memory allocation error\n");
 				goto err;
 			}
-			skb_reserve(nskb, 32);
-			RX_STAT_INC(skb_allocated);
-
-			memcpy(nskb->data, &(skb->data[chk_idx+4]), pkt_len);
-			skb_put(nskb, pkt_len);
 			skb_pool[pool_index++] = nskb;
 		}
 	}
@@ -654,10 +765,9 @@ static void ath9k_hif_usb_rx_cb(struct urb *urb)
 {
 	struct rx_buf *rx_buf = (struct rx_buf *)urb->context;
 	struct hif_device_usb *hif_dev = rx_buf->hif_dev;
-	struct sk_buff *skb = rx_buf->skb;
 	int ret;
 
-	if (!skb)
+	if (!rx_buf->page)
 		return;
 
 	if (!hif_dev)
@@ -675,14 +785,17 @@ static void ath9k_hif_usb_rx_cb(struct urb *urb)
 		goto resubmit;
 	}
 
-	if (likely(urb->actual_length != 0)) {
-		skb_put(skb, urb->actual_length);
-		ath9k_hif_usb_rx_stream(hif_dev, skb);
-	}
+	if (likely(urb->actual_length != 0))
+		ath9k_hif_usb_rx_stream(hif_dev, rx_buf, urb->actual_length);
 
 resubmit:
-	skb_reset_tail_pointer(skb);
-	skb_trim(skb, 0);
+	/* frames still point into the old buffer, swap it out */
+	if (rx_buf->next_page) {
+		ath9k_hif_usb_rx_put_page(hif_dev, rx_buf->page);
+		rx_buf->page = rx_buf->next_page;
+		rx_buf->next_page = NULL;
+		urb->transfer_buffer = page_address(rx_buf->page);
+	}
 
 	usb_anchor_urb(urb, &hif_dev->rx_submitted);
 	ret = usb_submit_urb(urb, GFP_ATOMIC);
@@ -693,7 +806,7 @@ static void ath9k_hif_usb_rx_cb(struct urb *urb)
 
 	return;
 free:
-	kfree_skb(skb);
+	put_page(rx_buf->page);
 	kfree(rx_buf);
 }
 
@@ -771,6 +884,8 @@ static void ath9k_hif_usb_dealloc_tx_urbs(struct hif_device_usb *hif_dev)
 	struct tx_buf *tx_buf = NULL, *tx_buf_tmp = NULL;
 	unsigned long flags;
 
+	hrtimer_cancel(&hif_dev->tx.flush_timer);
+
 	spin_lock_irqsave(&hif_dev->tx.tx_lock, flags);
 	list_for_each_entry_safe(tx_buf, tx_buf_tmp,
 				 &hif_dev->tx.tx_buf, list) {
@@ -816,6 +931,9 @@ static int ath9k_hif_usb_alloc_tx_urbs(struct hif_device_usb *hif_dev)
 	spin_lock_init(&hif_dev->tx.tx_lock);
 	__skb_queue_head_init(&hif_dev->tx.tx_skb_queue);
 	init_usb_anchor(&hif_dev->mgmt_submitted);
+	hrtimer_init(&hif_dev->tx.flush_timer, CLOCK_MONOTONIC,
+		     HRTIMER_MODE_REL_SOFT);
+	hif_dev->tx.flush_timer.function = hif_usb_tx_flush_timer;
 
 	for (i = 0; i < MAX_TX_URB_NUM; i++) {
 		tx_buf = kzalloc(sizeof(*tx_buf), GFP_KERNEL);
@@ -850,13 +968,21 @@ static int ath9k_hif_usb_alloc_tx_urbs(struct hif_device_usb *hif_dev)
 
 static void ath9k_hif_usb_dealloc_rx_urbs(struct hif_device_usb *hif_dev)
 {
+	int i;
+
 	usb_kill_anchored_urbs(&hif_dev->rx_submitted);
+
+	for (i = 0; i < RX_PAGE_CACHE_NUM; i++) {
+		if (hif_dev->rx_page_cache[i])
+			put_page(hif_dev->rx_page_cache[i]);
+		hif_dev->rx_page_cache[i] = NULL;
+	}
 }
 
 static int ath9k_hif_usb_alloc_rx_urbs(struct hif_device_usb *hif_dev)
 {
 	struct rx_buf *rx_buf = NULL;
-	struct sk_buff *skb = NULL;
+	struct page *page = NULL;
 	struct urb *urb = NULL;
 	int i, ret;
 
@@ -879,19 +1005,19 @@ static int ath9k_hif_usb_alloc_rx_urbs(struct hif_device_usb *hif_dev)
 		}
 
 		/* Allocate buffer */
-		skb = alloc_skb(MAX_RX_BUF_SIZE, GFP_KERNEL);
-		if (!skb) {
+		page = alloc_pages(GFP_KERNEL | __GFP_COMP, RX_BUF_ORDER);
+		if (!page) {
 			ret = -ENOMEM;
 			goto err_skb;
 		}
 
 		rx_buf->hif_dev = hif_dev;
-		rx_buf->skb = skb;
+		rx_buf->page = page;
 
 		usb_fill_bulk_urb(urb, hif_dev->udev,
 				  usb_rcvbulkpipe(hif_dev->udev,
 						  USB_WLAN_RX_PIPE),
-				  skb->data, MAX_RX_BUF_SIZE,
+				  page_address(page), MAX_RX_BUF_SIZE,
 				  ath9k_hif_usb_rx_cb, rx_buf);
 
 		/* Anchor URB */
@@ -914,7 +1040,7 @@ static int ath9k_hif_usb_alloc_rx_urbs(struct hif_device_usb *hif_dev)
 	return 0;
 
 err_submit:
-	kfree_skb(skb);
+	put_page(page);
 err_skb:
 	usb_free_urb(urb);
 err_urb:
@@ -1002,11 +1128,16 @@ static int ath9k_hif_usb_alloc_reg_in_urbs(struct hif_device_usb *hif_dev)
 static int ath9k_hif_usb_alloc_urbs(struct hif_device_usb *hif_dev)
 {
 	/* Register Write */
-	init_usb_anchor(&hif_dev->regout_submitted);
+	skb_queue_head_init(&hif_dev->regout_queue);
+	hif_dev->regout_pool = usb_urb_pool_create(hif_dev->udev,
+			usb_sndintpipe(hif_dev->udev, USB_REG_OUT_PIPE),
+			MAX_REG_OUT_URB_NUM, MAX_REG_OUT_BUF_SIZE, GFP_KERNEL);
+	if (!hif_dev->regout_pool)
+		goto err;
 
 	/* TX */
 	if (ath9k_hif_usb_alloc_tx_urbs(hif_dev) < 0)
-		goto err;
+		goto err_tx;
 
 	/* RX */
 	if (ath9k_hif_usb_alloc_rx_urbs(hif_dev) < 0)
@@ -1021,13 +1152,18 @@ static int ath9k_hif_usb_alloc_urbs(struct hif_device_usb *hif_dev)
 	ath9k_hif_usb_dealloc_rx_urbs(hif_dev);
 err_rx:
 	ath9k_hif_usb_dealloc_tx_urbs(hif_dev);
+err_tx:
+	usb_urb_pool_destroy(hif_dev->regout_pool);
+	hif_dev->regout_pool = NULL;
 err:
 	return -ENOMEM;
 }
 
 void ath9k_hif_usb_dealloc_urbs(struct hif_device_usb *hif_dev)
 {
-	usb_kill_anchored_urbs(&hif_dev->regout_submitted);
+	usb_urb_pool_destroy(hif_dev->regout_pool);
+	hif_dev->regout_pool = NULL;
+	skb_queue_purge(&hif_dev->regout_queue);
 	ath9k_hif_usb_dealloc_reg_in_urbs(hif_dev);
 	ath9k_hif_usb_dealloc_tx_urbs(hif_dev);
 	ath9k_hif_usb_dealloc_rx_urbs(hif_dev);
@@ -56,11 +56,30 @@ extern int htc_use_dev_fw;
 #define MAX_TX_BUF_SIZE 32768
 #define MAX_TX_AGGR_NUM 20
 
+/*
+ * Queued TX frames are packed into an URB once MAX_TX_AGGR_NUM frames or
+ * TX_FLUSH_BYTES are waiting, when an URB completes, or at the latest
+ * TX_FLUSH_USEC after the first frame was queued.
+ */
+#define TX_FLUSH_BYTES  (MAX_TX_BUF_SIZE / 2)
+#define TX_FLUSH_USEC   200
+
 #define MAX_RX_URB_NUM  8
 #define MAX_RX_BUF_SIZE 16384
 #define MAX_PKT_NUM_IN_TRANSFER 10
+#define RX_BUF_ORDER    get_order(MAX_RX_BUF_SIZE)
 
-#define MAX_REG_OUT_URB_NUM  1
+/*
+ * Frames up to RX_COPY_LEN are copied out of the RX URB buffer, larger
+ * ones only have their first RX_HEAD_LEN bytes (HTC and RX status headers,
+ * 802.11 header) copied and the rest attached as a page fragment.
+ */
+#define RX_COPY_LEN     256
+#define RX_HEAD_LEN     128
+#define RX_PAGE_CACHE_NUM MAX_RX_URB_NUM
+
+#define MAX_REG_OUT_URB_NUM  4
+#define MAX_REG_OUT_BUF_SIZE 512
 #define MAX_REG_IN_URB_NUM   64
 
 #define MAX_REG_IN_BUF_SIZE 64
@@ -87,20 +106,34 @@ struct tx_buf {
 };
 
 struct rx_buf {
-	struct sk_buff *skb;
+	struct sk_buff *skb;		/* register pipe */
+	struct page *page;		/* WLAN RX pipe */
+	struct page *next_page;		/* replaces @page once frames use it */
 	struct hif_device_usb *hif_dev;
 };
 
 #define HIF_USB_TX_STOP  BIT(0)
 #define HIF_USB_TX_FLUSH BIT(1)
 
+/* why queued TX frames were sent, for the debugfs statistics */
+enum hif_usb_tx_cause {
+	HIF_USB_TX_CAUSE_IDLE,
+	HIF_USB_TX_CAUSE_COUNT,
+	HIF_USB_TX_CAUSE_SIZE,
+	HIF_USB_TX_CAUSE_TIMER,
+	HIF_USB_TX_CAUSE_COMPLETE,
+	HIF_USB_TX_CAUSE_MAX
+};
+
 struct hif_usb_tx {
 	u8 flags;
 	u8 tx_buf_cnt;
 	u16 tx_skb_cnt;
+	u32 tx_skb_bytes;
 	struct sk_buff_head tx_skb_queue;
 	struct list_head tx_buf;
 	struct list_head tx_pending;
+	struct hrtimer flush_timer;
 	spinlock_t tx_lock;
 };
 
@@ -121,7 +154,8 @@ struct hif_device_usb {
 	struct completion fw_done;
 	struct htc_target *htc_handle;
 	struct hif_usb_tx tx;
-	struct usb_anchor regout_submitted;
+	struct usb_urb_pool *regout_pool;
+	struct sk_buff_head regout_queue;
 	struct usb_anchor rx_submitted;
 	struct usb_anchor reg_in_submitted;
 	struct usb_anchor mgmt_submitted;
@@ -132,6 +166,7 @@ struct hif_device_usb {
 	int rx_pkt_len;
 	int rx_transfer_len;
 	int rx_pad_len;
+	struct page *rx_page_cache[RX_PAGE_CACHE_NUM];
 	spinlock_t rx_lock;
 	u8 flags; /* HIF_USB_* */
 };
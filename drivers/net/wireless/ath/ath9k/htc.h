@@ -346,6 +346,7 @@ struct ath_tx_stats {
 	u32 skb_failed;
 	u32 cab_queued;
 	u32 queue_stats[IEEE80211_NUM_ACS];
+	u32 buf_cause[HIF_USB_TX_CAUSE_MAX];
 };
 
 struct ath_skbrx_stats {
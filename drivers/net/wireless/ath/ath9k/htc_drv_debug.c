@@ -194,7 +194,8 @@ static ssize_t read_file_xmit(struct file *file, char __user *user_buf,
 			      size_t count, loff_t *ppos)
 {
 	struct ath9k_htc_priv *priv = file->private_data;
-	char buf[512];
+	struct ath_tx_stats *stats = &priv->debug.tx_stats;
+	char buf[1024];
 	unsigned int len = 0;
 
 	len += scnprintf(buf + len, sizeof(buf) - len,
@@ -216,6 +217,26 @@ static ssize_t read_file_xmit(struct file *file, char __user *user_buf,
 			 "%20s : %10u\n", "CAB queued",
 			 priv->debug.tx_stats.cab_queued);
 
+	len += scnprintf(buf + len, sizeof(buf) - len,
+			 "%20s : %10u\n", "SKBs per buffer",
+			 stats->buf_queued ?
+			 stats->skb_queued / stats->buf_queued : 0);
+	len += scnprintf(buf + len, sizeof(buf) - len,
+			 "%20s : %10u\n", "Sent on idle",
+			 stats->buf_cause[HIF_USB_TX_CAUSE_IDLE]);
+	len += scnprintf(buf + len, sizeof(buf) - len,
+			 "%20s : %10u\n", "Sent on count",
+			 stats->buf_cause[HIF_USB_TX_CAUSE_COUNT]);
+	len += scnprintf(buf + len, sizeof(buf) - len,
+			 "%20s : %10u\n", "Sent on size",
+			 stats->buf_cause[HIF_USB_TX_CAUSE_SIZE]);
+	len += scnprintf(buf + len, sizeof(buf) - len,
+			 "%20s : %10u\n", "Sent on timer",
+			 stats->buf_cause[HIF_USB_TX_CAUSE_TIMER]);
+	len += scnprintf(buf + len, sizeof(buf) - len,
+			 "%20s : %10u\n", "Sent on completion",
+			 stats->buf_cause[HIF_USB_TX_CAUSE_COMPLETE]);
+
 	len += scnprintf(buf + len, sizeof(buf) - len,
 			 "%20s : %10u\n", "BE queued",
 			 priv->debug.tx_stats.queue_stats[IEEE80211_AC_BE]);
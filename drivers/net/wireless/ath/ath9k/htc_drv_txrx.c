@@ -442,9 +442,29 @@ static void ath9k_htc_check_tx_aggr(struct ath9k_htc_priv *priv,
 	rcu_read_unlock();
 }
 
-static void ath9k_htc_tx_process(struct ath9k_htc_priv *priv,
-				 struct sk_buff *skb,
-				 struct __wmi_event_txstatus *txs)
+/* Hand completed frames to mac80211, accounting for them as one batch */
+static void ath9k_htc_tx_complete(struct ath9k_htc_priv *priv,
+				  struct sk_buff_head *done)
+{
+	struct sk_buff *skb;
+
+	if (skb_queue_empty(done))
+		return;
+
+	spin_lock_bh(&priv->tx.tx_lock);
+	priv->tx.queued_cnt -= skb_queue_len(done);
+	if (WARN_ON(priv->tx.queued_cnt < 0))
+		priv->tx.queued_cnt = 0;
+	spin_unlock_bh(&priv->tx.tx_lock);
+
+	while ((skb = __skb_dequeue(done)) != NULL)
+		ieee80211_tx_status(priv->hw, skb);
+}
+
+static void __ath9k_htc_tx_process(struct ath9k_htc_priv *priv,
+				   struct sk_buff *skb,
+				   struct __wmi_event_txstatus *txs,
+				   struct sk_buff_head *done)
 {
 	struct ieee80211_vif *vif;
 	struct ath9k_htc_tx_ctl *tx_ctl;
@@ -506,11 +526,6 @@ static void ath9k_htc_tx_process(struct ath9k_htc_priv *priv,
 	ath9k_htc_check_tx_aggr(priv, vif, skb);
 
 send_mac80211:
-	spin_lock_bh(&priv->tx.tx_lock);
-	if (WARN_ON(--priv->tx.queued_cnt < 0))
-		priv->tx.queued_cnt = 0;
-	spin_unlock_bh(&priv->tx.tx_lock);
-
 	ath9k_htc_tx_clear_slot(priv, slot);
 
 	/* Remove padding before handing frame back to mac80211 */
@@ -523,7 +538,18 @@ static void ath9k_htc_tx_process(struct ath9k_htc_priv *priv,
 	}
 
 	/* Send status to mac80211 */
-	ieee80211_tx_status(priv->hw, skb);
+	__skb_queue_tail(done, skb);
+}
+
+static void ath9k_htc_tx_process(struct ath9k_htc_priv *priv,
+				 struct sk_buff *skb,
+				 struct __wmi_event_txstatus *txs)
+{
+	struct sk_buff_head done;
+
+	__skb_queue_head_init(&done);
+	__ath9k_htc_tx_process(priv, skb, txs, &done);
+	ath9k_htc_tx_complete(priv, &done);
 }
 
 static inline void ath9k_htc_tx_drainq(struct ath9k_htc_priv *priv,
@@ -650,8 +676,11 @@ void ath9k_htc_txstatus(struct ath9k_htc_priv *priv, void *wmi_event)
 	struct __wmi_event_txstatus *__txs;
 	struct sk_buff *skb;
 	struct ath9k_htc_tx_event *tx_pend;
+	struct sk_buff_head done;
 	int i;
 
+	__skb_queue_head_init(&done);
+
 	for (i = 0; i < txs->cnt; i++) {
 		WARN_ON(txs->cnt > HTC_MAX_TX_STATUS);
 
@@ -679,9 +708,12 @@ void ath9k_htc_txstatus(struct ath9k_htc_priv *priv, void *wmi_event)
 			continue;
 		}
 
-		ath9k_htc_tx_process(priv, skb, __txs);
+		__ath9k_htc_tx_process(priv, skb, __txs, &done);
 	}
 
+	/* report all frames of this event together */
+	ath9k_htc_tx_complete(priv, &done);
+
 	/* Wake TX queues if needed */
 	ath9k_htc_check_wake_queues(priv);
 }
@@ -1033,6 +1065,11 @@ static bool ath9k_rx_prepare(struct ath9k_htc_priv *priv,
 	 * can be dropped.
 	 */
 	if (unlikely(is_phyerr)) {
+		/* spectral data is parsed as a whole */
+		if (skb_linearize(skb))
+			goto rx_next;
+		hdr = (struct ieee80211_hdr *)skb->data;
+
 		/* TODO: Not using DFS processing now. */
 		if (ath_cmn_process_fft(&priv->spec_priv, hdr,
 				    &rx_stats, rx_status->mactime)) {
@@ -1108,7 +1145,7 @@ void ath9k_rx_tasklet(struct tasklet_struct *t)
 
 		spin_unlock_irqrestore(&priv->rx.rxbuflock, flags);
 
-		ieee80211_rx(priv->hw, skb);
+		ieee80211_rx_queue_napi(priv->hw, skb);
 
 		spin_lock_irqsave(&priv->rx.rxbuflock, flags);
 requeue:
@@ -1118,7 +1155,6 @@ void ath9k_rx_tasklet(struct tasklet_struct *t)
 		rxbuf = NULL;
 		spin_unlock_irqrestore(&priv->rx.rxbuflock, flags);
 	} while (1);
-
 }
 
 void ath9k_htc_rxep(void *drv_priv, struct sk_buff *skb,
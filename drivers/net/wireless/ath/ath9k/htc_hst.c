@@ -452,7 +452,7 @@ void ath9k_htc_rx_msg(struct htc_target *htc_handle,
 
 	} else {
 		if (htc_hdr->flags & HTC_FLAGS_RECV_TRAILER)
-			skb_trim(skb, len - htc_hdr->control[0]);
+			pskb_trim(skb, len - htc_hdr->control[0]);
 
 		skb_pull(skb, sizeof(struct htc_frame_hdr));
 
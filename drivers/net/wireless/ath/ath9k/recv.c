@@ -1075,6 +1075,7 @@ int ath_rx_tasklet(struct ath_softc *sc, int flush, bool hp)
 	dma_addr_t new_buf_addr;
 	unsigned int budget = 512;
 	struct ieee80211_hdr *hdr;
+	LIST_HEAD(rx_list);
 
 	if (edma)
 		dma_type = DMA_BIDIRECTIONAL;
@@ -1085,6 +1086,8 @@ int ath_rx_tasklet(struct ath_softc *sc, int flush, bool hp)
 
 	tsf = ath9k_hw_gettsf64(ah);
 
+	rcu_read_lock();
+
 	do {
 		bool decrypt_error = false;
 
@@ -1209,7 +1212,7 @@ int ath_rx_tasklet(struct ath_softc *sc, int flush, bool hp)
 		if (ieee80211_is_ack(hdr->frame_control))
 			ath_dynack_sample_ack_ts(sc->sc_ah, skb, rs.rs_tstamp);
 
-		ieee80211_rx(hw, skb);
+		ieee80211_rx_list(hw, NULL, skb, &rx_list);
 
 requeue_drop_frag:
 		if (sc->rx.frag) {
@@ -1231,6 +1234,11 @@ int ath_rx_tasklet(struct ath_softc *sc, int flush, bool hp)
 			break;
 	} while (1);
 
+	rcu_read_unlock();
+
+	/* deliver everything from this run to the stack at once */
+	netif_receive_skb_list(&rx_list);
+
 	if (!(ah->imask & ATH9K_INT_RXEOL)) {
 		ah->imask |= (ATH9K_INT_RXEOL | ATH9K_INT_RXORN);
 		ath9k_hw_set_interrupts(ah);
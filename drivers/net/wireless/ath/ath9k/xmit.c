@@ -69,6 +69,7 @@ static struct ath_buf *ath_tx_setup_buffer(struct ath_softc *sc,
 					   struct sk_buff *skb);
 static int ath_tx_prepare(struct ieee80211_hw *hw, struct sk_buff *skb,
 			  struct ath_tx_control *txctl);
+static int ath_max_framelen(int usec, int mcs, bool ht40, bool sgi);
 
 enum {
 	MCS_HT20,
@@ -749,9 +750,21 @@ static bool ath_lookup_legacy(struct ath_buf *bf)
 	return false;
 }
 
+static const struct ieee80211_ampdu_policy ath_no_ampdu_policy;
+
+static const struct ieee80211_ampdu_policy *
+ath_tid_ampdu_policy(struct ath_atx_tid *tid)
+{
+	if (!tid->an->sta)
+		return &ath_no_ampdu_policy;
+
+	return &tid->an->sta->ampdu_policy[tid->tidno];
+}
+
 static u32 ath_lookup_rate(struct ath_softc *sc, struct ath_buf *bf,
 			   struct ath_atx_tid *tid)
 {
+	const struct ieee80211_ampdu_policy *policy;
 	struct sk_buff *skb;
 	struct ieee80211_tx_info *tx_info;
 	struct ieee80211_tx_rate *rates;
@@ -763,6 +776,7 @@ static u32 ath_lookup_rate(struct ath_softc *sc, struct ath_buf *bf,
 	skb = bf->bf_mpdu;
 	tx_info = IEEE80211_SKB_CB(skb);
 	rates = bf->rates;
+	policy = ath_tid_ampdu_policy(tid);
 
 	/*
 	 * Find the lowest frame length among the rate series that will have a
@@ -790,6 +804,12 @@ static u32 ath_lookup_rate(struct ath_softc *sc, struct ath_buf *bf,
 			modeidx++;
 
 		frmlen = sc->tx.max_aggr_framelen[q][modeidx][rates[i].idx];
+		if (policy->max_duration)
+			frmlen = min_t(u32, frmlen,
+				       ath_max_framelen(policy->max_duration,
+							rates[i].idx,
+							modeidx >= MCS_HT40,
+							modeidx & 1));
 		max_4ms_framelen = min(max_4ms_framelen, frmlen);
 	}
 
@@ -813,6 +833,9 @@ static u32 ath_lookup_rate(struct ath_softc *sc, struct ath_buf *bf,
 	if (tid->an->maxampdu)
 		aggr_limit = min(aggr_limit, tid->an->maxampdu);
 
+	if (policy->max_len)
+		aggr_limit = min_t(u32, aggr_limit, policy->max_len);
+
 	return aggr_limit;
 }
 
@@ -1487,7 +1510,14 @@ static int ath_tx_sched_aggr(struct ath_softc *sc, struct ath_txq *txq,
 
 	tx_info = IEEE80211_SKB_CB(bf->bf_mpdu);
 	aggr = !!(tx_info->flags & IEEE80211_TX_CTL_AMPDU);
-	if ((aggr && txq->axq_ampdu_depth >= ATH_AGGR_MIN_QDEPTH) ||
+
+	/*
+	 * Holding frames back while the hardware has aggregates queued is
+	 * what lets larger ones build up; a delay bound on the TID means
+	 * sending what is there right away instead.
+	 */
+	if ((aggr && txq->axq_ampdu_depth >= ATH_AGGR_MIN_QDEPTH &&
+	     !ath_tid_ampdu_policy(tid)->max_delay) ||
 	    (!aggr && txq->axq_depth >= ATH_NON_AGGR_MIN_QDEPTH)) {
 		__skb_queue_tail(&tid->retry_q, bf->bf_mpdu);
 		return -EBUSY;
@@ -1914,6 +1944,26 @@ void ath_tx_cleanupq(struct ath_softc *sc, struct ath_txq *txq)
 	sc->tx.txqsetup &= ~(1<<txq->axq_qnum);
 }
 
+/* Frames of a slotted TID are only dequeued while a TX slot is open */
+static bool ath_tx_slot_closed(struct ath_softc *sc, struct ath_atx_tid *tid)
+{
+	struct ath_tx_slot *slot = &sc->tx_slot;
+	u32 elapsed;
+
+	if (!slot->active || tid->tidno != slot->tid)
+		return false;
+
+	elapsed = ath9k_hw_gettsf32(sc->sc_ah) - slot->start;
+	if ((s32)elapsed >= 0 && elapsed % slot->period < slot->len)
+		return false;
+
+	if (!slot->holding) {
+		slot->holding = true;
+		slot->held++;
+	}
+	return true;
+}
+
 /* For each acq entry, for each tid, try to schedule packets
  * for transmit until ampdu_depth has reached min Q depth.
  */
@@ -1943,8 +1993,11 @@ void ath_txq_schedule(struct ath_softc *sc, struct ath_txq *txq)
 
 		tid = (struct ath_atx_tid *)queue->drv_priv;
 
-		ret = ath_tx_sched_aggr(sc, txq, tid);
-		ath_dbg(common, QUEUE, "ath_tx_sched_aggr returned %d\n", ret);
+		if (!ath_tx_slot_closed(sc, tid)) {
+			ret = ath_tx_sched_aggr(sc, txq, tid);
+			ath_dbg(common, QUEUE,
+				"ath_tx_sched_aggr returned %d\n", ret);
+		}
 
 		force = !skb_queue_empty(&tid->retry_q);
 		ieee80211_return_txq(hw, queue, force);
@@ -17,6 +17,7 @@
 #include <linux/device.h>
 #include <linux/notifier.h>
 #include <linux/err.h>
+#include <linux/mutex.h>
 #include <linux/of.h>
 #include <linux/power_supply.h>
 #include <linux/property.h>
@@ -34,6 +35,29 @@ static struct device_type power_supply_dev_type;
 
 #define POWER_SUPPLY_DEFERRED_REGISTER_TIME	msecs_to_jiffies(10)
 
+/*
+ * Changes reported within this window after the first one are handled by
+ * a single run of the changed work: one uevent, one notification of the
+ * supplicants.
+ */
+static unsigned int changed_delay_ms = 10;
+module_param(changed_delay_ms, uint, 0644);
+MODULE_PARM_DESC(changed_delay_ms, "Window for merging the changes of a power supply, in ms");
+
+/*
+ * Supplier to supplicant relations, as found by
+ * __power_supply_is_supplied_by() when either side registers, so that
+ * a change doesn't have to walk the whole class.
+ */
+struct power_supply_link {
+	struct power_supply *supplier;
+	struct power_supply *supplicant;
+	struct list_head supplier_node;		/* in supplier->supplicants */
+	struct list_head supplicant_node;	/* in supplicant->suppliers */
+};
+
+static DEFINE_MUTEX(power_supply_links_lock);
+
 static bool __power_supply_is_supplied_by(struct power_supply *supplier,
 					 struct power_supply *supply)
 {
@@ -60,24 +84,85 @@ static bool __power_supply_is_supplied_by(struct power_supply *supplier,
 	return false;
 }
 
-static int __power_supply_changed_work(struct device *dev, void *data)
+static int power_supply_add_link(struct power_supply *supplier,
+				 struct power_supply *supplicant)
+{
+	struct power_supply_link *link;
+
+	link = kzalloc(sizeof(*link), GFP_KERNEL);
+	if (!link)
+		return -ENOMEM;
+
+	link->supplier = supplier;
+	link->supplicant = supplicant;
+	list_add_tail(&link->supplier_node, &supplier->supplicants);
+	list_add_tail(&link->supplicant_node, &supplicant->suppliers);
+
+	return 0;
+}
+
+static int __power_supply_link(struct device *dev, void *data)
 {
 	struct power_supply *psy = data;
-	struct power_supply *pst = dev_get_drvdata(dev);
+	struct power_supply *epsy = dev_get_drvdata(dev);
+	int ret;
+
+	if (epsy == psy)
+		return 0;
 
-	if (__power_supply_is_supplied_by(psy, pst)) {
-		if (pst->desc->external_power_changed)
-			pst->desc->external_power_changed(pst);
+	if (__power_supply_is_supplied_by(psy, epsy)) {
+		ret = power_supply_add_link(psy, epsy);
+		if (ret)
+			return ret;
 	}
 
+	if (__power_supply_is_supplied_by(epsy, psy))
+		return power_supply_add_link(epsy, psy);
+
 	return 0;
 }
 
+static void power_supply_unlink(struct power_supply *psy)
+{
+	struct power_supply_link *link, *tmp;
+
+	mutex_lock(&power_supply_links_lock);
+	list_for_each_entry_safe(link, tmp, &psy->supplicants, supplier_node) {
+		list_del(&link->supplier_node);
+		list_del(&link->supplicant_node);
+		kfree(link);
+	}
+	list_for_each_entry_safe(link, tmp, &psy->suppliers, supplicant_node) {
+		list_del(&link->supplier_node);
+		list_del(&link->supplicant_node);
+		kfree(link);
+	}
+	mutex_unlock(&power_supply_links_lock);
+}
+
+/* Called once @psy is in the class, finds both directions of its links. */
+static int power_supply_link(struct power_supply *psy)
+{
+	int ret;
+
+	mutex_lock(&power_supply_links_lock);
+	ret = class_for_each_device(power_supply_class, NULL, psy,
+				    __power_supply_link);
+	mutex_unlock(&power_supply_links_lock);
+
+	if (ret)
+		power_supply_unlink(psy);
+
+	return ret;
+}
+
 static void power_supply_changed_work(struct work_struct *work)
 {
 	unsigned long flags;
-	struct power_supply *psy = container_of(work, struct power_supply,
+	struct power_supply *psy = container_of(to_delayed_work(work),
+						struct power_supply,
 						changed_work);
+	struct power_supply_link *link;
 
 	dev_dbg(&psy->dev, "%s\n", __func__);
 
@@ -92,8 +177,14 @@ static void power_supply_changed_work(struct work_struct *work)
 	if (likely(psy->changed)) {
 		psy->changed = false;
 		spin_unlock_irqrestore(&psy->changed_lock, flags);
-		class_for_each_device(power_supply_class, NULL, psy,
-				      __power_supply_changed_work);
+		mutex_lock(&power_supply_links_lock);
+		list_for_each_entry(link, &psy->supplicants, supplier_node) {
+			struct power_supply *pst = link->supplicant;
+
+			if (pst->desc->external_power_changed)
+				pst->desc->external_power_changed(pst);
+		}
+		mutex_unlock(&power_supply_links_lock);
 		power_supply_update_leds(psy);
 		atomic_notifier_call_chain(&power_supply_notifier,
 				PSY_EVENT_PROP_CHANGED, psy);
@@ -121,7 +212,9 @@ void power_supply_changed(struct power_supply *psy)
 	psy->changed = true;
 	pm_stay_awake(&psy->dev);
 	spin_unlock_irqrestore(&psy->changed_lock, flags);
-	schedule_work(&psy->changed_work);
+	/* a pending run also handles this change */
+	schedule_delayed_work(&psy->changed_work,
+			      msecs_to_jiffies(READ_ONCE(changed_delay_ms)));
 }
 EXPORT_SYMBOL_GPL(power_supply_changed);
 
@@ -1156,9 +1249,11 @@ __power_supply_register(struct device *parent,
 	if (rc)
 		goto dev_set_name_failed;
 
-	INIT_WORK(&psy->changed_work, power_supply_changed_work);
+	INIT_DELAYED_WORK(&psy->changed_work, power_supply_changed_work);
 	INIT_DELAYED_WORK(&psy->deferred_register_work,
 			  power_supply_deferred_register_work);
+	INIT_LIST_HEAD(&psy->supplicants);
+	INIT_LIST_HEAD(&psy->suppliers);
 
 	rc = power_supply_check_supplies(psy);
 	if (rc) {
@@ -1175,6 +1270,10 @@ __power_supply_register(struct device *parent,
 	if (rc)
 		goto wakeup_init_failed;
 
+	rc = power_supply_link(psy);
+	if (rc)
+		goto link_failed;
+
 	rc = psy_register_thermal(psy);
 	if (rc)
 		goto register_thermal_failed;
@@ -1216,6 +1315,8 @@ __power_supply_register(struct device *parent,
 register_cooler_failed:
 	psy_unregister_thermal(psy);
 register_thermal_failed:
+	power_supply_unlink(psy);
+link_failed:
 	device_del(dev);
 wakeup_init_failed:
 device_add_failed:
@@ -1360,8 +1461,9 @@ void power_supply_unregister(struct power_supply *psy)
 {
 	WARN_ON(atomic_dec_return(&psy->use_cnt));
 	psy->removing = true;
-	cancel_work_sync(&psy->changed_work);
+	cancel_delayed_work_sync(&psy->changed_work);
 	cancel_delayed_work_sync(&psy->deferred_register_work);
+	power_supply_unlink(psy);
 	sysfs_remove_link(&psy->dev.kobj, "powers");
 	power_supply_remove_hwmon_sysfs(psy);
 	power_supply_remove_triggers(psy);
@@ -1573,6 +1573,11 @@ static int kbd_connect(struct input_handler *handler, struct input_dev *dev,
 	handle->dev = dev;
 	handle->handler = handler;
 	handle->name = "kbd";
+	__set_bit(EV_KEY, handle->evbit);
+	__set_bit(EV_MSC, handle->evbit);
+	/* pointer activity unblanks the console too */
+	__set_bit(EV_REL, handle->evbit);
+	__set_bit(EV_ABS, handle->evbit);
 
 	error = input_register_handle(handle);
 	if (error)
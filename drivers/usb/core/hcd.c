@@ -1626,7 +1626,8 @@ int usb_hcd_unlink_urb (struct urb *urb, int status)
 
 /*-------------------------------------------------------------------------*/
 
-static void __usb_hcd_giveback_urb(struct urb *urb)
+/* everything up to the completion handler, returns the former anchor */
+static struct usb_anchor *giveback_urb_start(struct urb *urb)
 {
 	struct usb_hcd *hcd = bus_to_hcd(urb->dev->bus);
 	struct usb_anchor *anchor = urb->anchor;
@@ -1647,6 +1648,22 @@ static void __usb_hcd_giveback_urb(struct urb *urb)
 
 	/* pass ownership to the completion handler */
 	urb->status = status;
+	return anchor;
+}
+
+static void giveback_urb_finish(struct urb *urb, struct usb_anchor *anchor)
+{
+	usb_anchor_resume_wakeups(anchor);
+	atomic_dec(&urb->use_count);
+	if (unlikely(atomic_read(&urb->reject)))
+		wake_up(&usb_kill_urb_queue);
+	usb_put_urb(urb);
+}
+
+static void __usb_hcd_giveback_urb(struct urb *urb)
+{
+	struct usb_anchor *anchor = giveback_urb_start(urb);
+
 	/*
 	 * This function can be called in task context inside another remote
 	 * coverage collection section, but kcov doesn't support that kind of
@@ -1656,37 +1673,96 @@ static void __usb_hcd_giveback_urb(struct urb *urb)
 	urb->complete(urb);
 	kcov_remote_stop_softirq();
 
-	usb_anchor_resume_wakeups(anchor);
-	atomic_dec(&urb->use_count);
-	if (unlikely(atomic_read(&urb->reject)))
-		wake_up(&usb_kill_urb_queue);
-	usb_put_urb(urb);
+	giveback_urb_finish(urb, anchor);
+}
+
+/*
+ * Hand isochronous URBs of one endpoint to their batch completion
+ * handler at once.  Only used from the giveback tasklet.
+ */
+static void usb_hcd_giveback_urb_batch(struct urb **urbs, unsigned int count)
+{
+	struct usb_anchor *anchors[USB_COMPLETE_BATCH_MAX];
+	unsigned int i;
+
+	for (i = 0; i < count; i++)
+		anchors[i] = giveback_urb_start(urbs[i]);
+
+	kcov_remote_start_usb_softirq((u64)urbs[0]->dev->bus->busnum);
+	urbs[0]->complete_batch(urbs, count);
+	kcov_remote_stop_softirq();
+
+	for (i = 0; i < count; i++)
+		giveback_urb_finish(urbs[i], anchors[i]);
+}
+
+/* collect the completed URBs following @urb on @list into one batch */
+static unsigned int giveback_urb_collect(struct list_head *list,
+		struct urb *urb, struct urb **batch)
+{
+	unsigned int count = 1;
+	struct urb *next;
+
+	batch[0] = urb;
+	while (count < USB_COMPLETE_BATCH_MAX) {
+		next = list_first_entry_or_null(list, struct urb, urb_list);
+		if (!next || next->ep != urb->ep ||
+		    next->complete_batch != urb->complete_batch)
+			break;
+		list_del_init(&next->urb_list);
+		batch[count++] = next;
+	}
+	return count;
 }
 
 static void usb_giveback_urb_bh(struct tasklet_struct *t)
 {
 	struct giveback_urb_bh *bh = from_tasklet(bh, t, bh);
-	struct list_head local_list;
+	LIST_HEAD(local_list);
+	LIST_HEAD(urgent_list);
+	struct urb *batch[USB_COMPLETE_BATCH_MAX];
+	struct list_head *list;
+	unsigned int count;
+	struct urb *urb;
 
 	spin_lock_irq(&bh->lock);
 	bh->running = true;
  restart:
-	list_replace_init(&bh->head, &local_list);
+	list_splice_tail_init(&bh->urgent, &urgent_list);
+	list_splice_tail_init(&bh->head, &local_list);
 	spin_unlock_irq(&bh->lock);
 
-	while (!list_empty(&local_list)) {
-		struct urb *urb;
+	for (;;) {
+		/*
+		 * Latency sensitive URBs completing meanwhile overtake the
+		 * ones collected already. Each endpoint only uses one of the
+		 * lists, so the URBs of an endpoint stay in order.
+		 */
+		if (list_empty(&urgent_list) && !list_empty(&bh->urgent)) {
+			spin_lock_irq(&bh->lock);
+			list_splice_tail_init(&bh->urgent, &urgent_list);
+			spin_unlock_irq(&bh->lock);
+		}
+
+		list = list_empty(&urgent_list) ? &local_list : &urgent_list;
+		urb = list_first_entry_or_null(list, struct urb, urb_list);
+		if (!urb)
+			break;
 
-		urb = list_entry(local_list.next, struct urb, urb_list);
 		list_del_init(&urb->urb_list);
 		bh->completing_ep = urb->ep;
-		__usb_hcd_giveback_urb(urb);
+		if (urb->complete_batch && usb_pipeisoc(urb->pipe)) {
+			count = giveback_urb_collect(list, urb, batch);
+			usb_hcd_giveback_urb_batch(batch, count);
+		} else {
+			__usb_hcd_giveback_urb(urb);
+		}
 		bh->completing_ep = NULL;
 	}
 
 	/* check if there are new URBs to giveback */
 	spin_lock_irq(&bh->lock);
-	if (!list_empty(&bh->head))
+	if (!list_empty(&bh->head) || !list_empty(&bh->urgent))
 		goto restart;
 	bh->running = false;
 	spin_unlock_irq(&bh->lock);
@@ -1699,8 +1775,9 @@ static void usb_giveback_urb_bh(struct tasklet_struct *t)
  * @status: completion status code for the URB.
  *
  * Context: atomic. The completion callback is invoked in caller's context.
- * For HCDs with HCD_BH flag set, the completion callback is invoked in tasklet
- * context (except for URBs submitted to the root hub which always complete in
+ * For HCDs with HCD_BH flag set, or controllers with giveback_in_bh set by
+ * their driver, the completion callback is invoked in tasklet context
+ * (except for URBs submitted to the root hub which always complete in
  * caller's context).
  *
  * This hands the URB from HCD to its USB device driver, using its
@@ -1716,7 +1793,7 @@ static void usb_giveback_urb_bh(struct tasklet_struct *t)
 void usb_hcd_giveback_urb(struct usb_hcd *hcd, struct urb *urb, int status)
 {
 	struct giveback_urb_bh *bh;
-	bool running, high_prio_bh;
+	bool running, high_prio_bh, urgent;
 
 	/* pass status to tasklet via unlinked */
 	if (likely(!urb->unlinked))
@@ -1727,7 +1804,12 @@ void usb_hcd_giveback_urb(struct usb_hcd *hcd, struct urb *urb, int status)
 		return;
 	}
 
-	if (usb_pipeisoc(urb->pipe) || usb_pipeint(urb->pipe)) {
+	/*
+	 * Interrupt URBs are usually input reports, don't let them wait for
+	 * a burst of isochronous completions.
+	 */
+	urgent = usb_pipeint(urb->pipe) || urb->ep->latency_sensitive;
+	if (urgent || usb_pipeisoc(urb->pipe)) {
 		bh = &hcd->high_prio_bh;
 		high_prio_bh = true;
 	} else {
@@ -1736,7 +1818,7 @@ void usb_hcd_giveback_urb(struct usb_hcd *hcd, struct urb *urb, int status)
 	}
 
 	spin_lock(&bh->lock);
-	list_add_tail(&urb->urb_list, &bh->head);
+	list_add_tail(&urb->urb_list, urgent ? &bh->urgent : &bh->head);
 	running = bh->running;
 	spin_unlock(&bh->lock);
 
@@ -2543,6 +2625,7 @@ static void init_giveback_urb_bh(struct giveback_urb_bh *bh)
 
 	spin_lock_init(&bh->lock);
 	INIT_LIST_HEAD(&bh->head);
+	INIT_LIST_HEAD(&bh->urgent);
 	tasklet_setup(&bh->bh, usb_giveback_urb_bh);
 }
 
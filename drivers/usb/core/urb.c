@@ -595,6 +595,33 @@ int usb_submit_urb(struct urb *urb, gfp_t mem_flags)
 }
 EXPORT_SYMBOL_GPL(usb_submit_urb);
 
+/**
+ * usb_submit_urbs - issue several asynchronous transfer requests
+ * @urbs: the URBs to submit, in order
+ * @count: number of URBs in @urbs
+ * @mem_flags: the type of memory to allocate, see usb_submit_urb()
+ *
+ * Meant for resubmitting a batch handed to a usb_complete_batch_t
+ * handler.  Submission stops at the first URB that fails; it and the
+ * ones after it remain owned by the caller.
+ *
+ * Return: the number of URBs submitted, or the error code from
+ * usb_submit_urb() if the first one fails.
+ */
+int usb_submit_urbs(struct urb **urbs, unsigned int count, gfp_t mem_flags)
+{
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < count; i++) {
+		ret = usb_submit_urb(urbs[i], mem_flags);
+		if (ret)
+			return i ? i : ret;
+	}
+	return count;
+}
+EXPORT_SYMBOL_GPL(usb_submit_urbs);
+
 /*-------------------------------------------------------------------*/
 
 /**
@@ -1038,3 +1065,149 @@ int usb_anchor_empty(struct usb_anchor *anchor)
 
 EXPORT_SYMBOL_GPL(usb_anchor_empty);
 
+
+/*
+ * An URB pool is a fixed set of URBs bound to one endpoint, each with a
+ * coherent transfer buffer.  Idle URBs sit on the pool's anchor; drivers
+ * take one, submit it and hand it back from the completion handler, so a
+ * steady stream of transfers never goes through the slab allocator or
+ * per-transfer DMA mapping.
+ */
+struct usb_urb_pool {
+	struct usb_device	*dev;
+	size_t			buf_size;
+	struct usb_anchor	idle;
+	unsigned int		nr_urbs;
+	struct urb		*urbs[];
+};
+
+/**
+ * usb_urb_pool_create - allocate a pool of URBs for an endpoint
+ * @dev: the device the endpoint belongs to
+ * @pipe: the endpoint's pipe
+ * @nr_urbs: how many URBs the pool holds
+ * @buf_size: size of each URB's transfer buffer, may be 0 for none
+ * @mem_flags: the type of memory to allocate, see kmalloc() for a list
+ *
+ * Every URB is set up for @dev and @pipe and, if @buf_size is not 0, gets
+ * a buffer from usb_alloc_coherent() with URB_NO_TRANSFER_DMA_MAP set.
+ * Drivers may fill in the rest, e.g. with usb_fill_int_urb() passing
+ * urb->transfer_buffer, but must leave transfer_buffer and transfer_dma
+ * alone.  The pool must be destroyed before the driver unbinds from @dev.
+ *
+ * Return: the new pool, or %NULL if out of memory.
+ */
+struct usb_urb_pool *usb_urb_pool_create(struct usb_device *dev,
+		unsigned int pipe, unsigned int nr_urbs, size_t buf_size,
+		gfp_t mem_flags)
+{
+	struct usb_urb_pool *pool;
+	struct urb *urb;
+
+	pool = kzalloc(struct_size(pool, urbs, nr_urbs), mem_flags);
+	if (!pool)
+		return NULL;
+
+	pool->dev = dev;
+	pool->buf_size = buf_size;
+	init_usb_anchor(&pool->idle);
+
+	while (pool->nr_urbs < nr_urbs) {
+		urb = usb_alloc_urb(0, mem_flags);
+		if (!urb)
+			goto fail;
+		pool->urbs[pool->nr_urbs++] = urb;
+
+		urb->dev = dev;
+		urb->pipe = pipe;
+		if (buf_size) {
+			urb->transfer_buffer = usb_alloc_coherent(dev,
+					buf_size, mem_flags, &urb->transfer_dma);
+			if (!urb->transfer_buffer)
+				goto fail;
+			urb->transfer_flags = URB_NO_TRANSFER_DMA_MAP;
+			urb->transfer_buffer_length = buf_size;
+		}
+		usb_anchor_urb(urb, &pool->idle);
+	}
+	return pool;
+
+fail:
+	usb_urb_pool_destroy(pool);
+	return NULL;
+}
+EXPORT_SYMBOL_GPL(usb_urb_pool_create);
+
+/**
+ * usb_urb_pool_destroy - free a pool of URBs
+ * @pool: the pool to free, may be %NULL
+ *
+ * URBs still in flight are killed first, which waits for their
+ * completion handlers to return them.  The caller must not hold any
+ * other URB taken from @pool.
+ *
+ * Context: must be able to sleep.
+ */
+void usb_urb_pool_destroy(struct usb_urb_pool *pool)
+{
+	struct urb *urb;
+	unsigned int i;
+
+	if (!pool)
+		return;
+
+	for (i = 0; i < pool->nr_urbs; i++)
+		usb_kill_urb(pool->urbs[i]);
+	usb_scuttle_anchored_urbs(&pool->idle);
+
+	for (i = 0; i < pool->nr_urbs; i++) {
+		urb = pool->urbs[i];
+		if (urb->transfer_flags & URB_NO_TRANSFER_DMA_MAP)
+			usb_free_coherent(pool->dev, pool->buf_size,
+					urb->transfer_buffer, urb->transfer_dma);
+		usb_free_urb(urb);
+	}
+	kfree(pool);
+}
+EXPORT_SYMBOL_GPL(usb_urb_pool_destroy);
+
+/**
+ * usb_urb_pool_get - take an idle URB from a pool
+ * @pool: the pool to take it from
+ *
+ * The URB comes back with its buffer length reset to the pool's buffer
+ * size; everything else is as the previous user left it.
+ *
+ * Context: any.
+ *
+ * Return: an idle URB, or %NULL if they are all in use.
+ */
+struct urb *usb_urb_pool_get(struct usb_urb_pool *pool)
+{
+	struct urb *urb;
+
+	urb = usb_get_from_anchor(&pool->idle);
+	if (urb && pool->buf_size) {
+		urb->transfer_flags |= URB_NO_TRANSFER_DMA_MAP;
+		urb->transfer_buffer_length = pool->buf_size;
+	}
+	return urb;
+}
+EXPORT_SYMBOL_GPL(usb_urb_pool_get);
+
+/**
+ * usb_urb_pool_put - return an URB to its pool
+ * @pool: the pool @urb was taken from
+ * @urb: the URB, which must not be in flight
+ *
+ * Usually called at the end of the completion handler, or when
+ * submitting the URB failed.
+ *
+ * Context: any.
+ */
+void usb_urb_pool_put(struct usb_urb_pool *pool, struct urb *urb)
+{
+	usb_anchor_urb(urb, &pool->idle);
+	usb_put_urb(urb);
+}
+EXPORT_SYMBOL_GPL(usb_urb_pool_put);
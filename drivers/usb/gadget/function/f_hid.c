@@ -8,6 +8,7 @@
 #include <linux/kernel.h>
 #include <linux/module.h>
 #include <linux/hid.h>
+#include <linux/hidraw.h>
 #include <linux/idr.h>
 #include <linux/cdev.h>
 #include <linux/mutex.h>
@@ -67,9 +68,10 @@ struct f_hidg {
 
 	/* send report */
 	spinlock_t			write_spinlock;
-	bool				write_pending;
+	bool				write_enabled;
 	wait_queue_head_t		write_queue;
-	struct usb_request		*req;
+	struct list_head		idle_in_req;
+	unsigned int			write_qlen;
 
 	int				minor;
 	struct cdev			cdev;
@@ -402,20 +404,31 @@ static ssize_t f_hidg_read(struct file *file, char __user *buffer,
 		return f_hidg_ssreport_read(file, buffer, count, ptr);
 }
 
+/* hand an IN request back for the next write, or free it once disabled */
+static void f_hidg_recycle_req(struct f_hidg *hidg, struct usb_request *req)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&hidg->write_spinlock, flags);
+	if (hidg->write_enabled)
+		list_add_tail(&req->list, &hidg->idle_in_req);
+	else
+		free_ep_req(hidg->in_ep, req);
+	spin_unlock_irqrestore(&hidg->write_spinlock, flags);
+
+	wake_up(&hidg->write_queue);
+}
+
 static void f_hidg_req_complete(struct usb_ep *ep, struct usb_request *req)
 {
 	struct f_hidg *hidg = (struct f_hidg *)ep->driver_data;
-	unsigned long flags;
 
-	if (req->status != 0) {
+	if (req->status != 0 && req->status != -ESHUTDOWN) {
 		ERROR(hidg->func.config->cdev,
 			"End Point Request ERROR: %d\n", req->status);
 	}
 
-	spin_lock_irqsave(&hidg->write_spinlock, flags);
-	hidg->write_pending = 0;
-	spin_unlock_irqrestore(&hidg->write_spinlock, flags);
-	wake_up(&hidg->write_queue);
+	f_hidg_recycle_req(hidg, req);
 }
 
 static ssize_t f_hidg_write(struct file *file, const char __user *buffer,
@@ -428,56 +441,48 @@ static ssize_t f_hidg_write(struct file *file, const char __user *buffer,
 
 	spin_lock_irqsave(&hidg->write_spinlock, flags);
 
-	if (!hidg->req) {
-		spin_unlock_irqrestore(&hidg->write_spinlock, flags);
-		return -ESHUTDOWN;
-	}
-
-#define WRITE_COND (!hidg->write_pending)
-try_again:
-	/* write queue */
+	/*
+	 * Up to write_qlen reports may be queued at once; writers only
+	 * wait (or get -EAGAIN) when every IN request is in flight.
+	 */
+#define WRITE_COND (!list_empty(&hidg->idle_in_req))
 	while (!WRITE_COND) {
+		if (!hidg->write_enabled) {
+			spin_unlock_irqrestore(&hidg->write_spinlock, flags);
+			return -ESHUTDOWN;
+		}
 		spin_unlock_irqrestore(&hidg->write_spinlock, flags);
 		if (file->f_flags & O_NONBLOCK)
 			return -EAGAIN;
 
-		if (wait_event_interruptible_exclusive(
-				hidg->write_queue, WRITE_COND))
+		if (wait_event_interruptible_exclusive(hidg->write_queue,
+				WRITE_COND || !hidg->write_enabled))
 			return -ERESTARTSYS;
 
 		spin_lock_irqsave(&hidg->write_spinlock, flags);
 	}
 
-	hidg->write_pending = 1;
-	req = hidg->req;
+	req = list_first_entry(&hidg->idle_in_req, struct usb_request, list);
+	list_del(&req->list);
 	count  = min_t(unsigned, count, hidg->report_length);
 
 	spin_unlock_irqrestore(&hidg->write_spinlock, flags);
 
-	if (!req) {
-		ERROR(hidg->func.config->cdev, "hidg->req is NULL\n");
-		status = -ESHUTDOWN;
-		goto release_write_pending;
-	}
-
 	status = copy_from_user(req->buf, buffer, count);
 	if (status != 0) {
 		ERROR(hidg->func.config->cdev,
 			"copy_from_user error\n");
 		status = -EINVAL;
-		goto release_write_pending;
+		goto release_req;
 	}
 
 	spin_lock_irqsave(&hidg->write_spinlock, flags);
 
 	/* when our function has been disabled by host */
-	if (!hidg->req) {
+	if (!hidg->write_enabled) {
 		free_ep_req(hidg->in_ep, req);
-		/*
-		 * TODO
-		 * Should we fail with error here?
-		 */
-		goto try_again;
+		spin_unlock_irqrestore(&hidg->write_spinlock, flags);
+		return -ESHUTDOWN;
 	}
 
 	req->status   = 0;
@@ -491,22 +496,18 @@ static ssize_t f_hidg_write(struct file *file, const char __user *buffer,
 	if (!hidg->in_ep->enabled) {
 		ERROR(hidg->func.config->cdev, "in_ep is disabled\n");
 		status = -ESHUTDOWN;
-		goto release_write_pending;
+		goto release_req;
 	}
 
 	status = usb_ep_queue(hidg->in_ep, req, GFP_ATOMIC);
 	if (status < 0)
-		goto release_write_pending;
+		goto release_req;
 	else
 		status = count;
 
 	return status;
-release_write_pending:
-	spin_lock_irqsave(&hidg->write_spinlock, flags);
-	hidg->write_pending = 0;
-	spin_unlock_irqrestore(&hidg->write_spinlock, flags);
-
-	wake_up(&hidg->write_queue);
+release_req:
+	f_hidg_recycle_req(hidg, req);
 
 	return status;
 }
@@ -562,6 +563,23 @@ static inline struct usb_request *hidg_alloc_ep_req(struct usb_ep *ep,
 	return alloc_ep_req(ep, length);
 }
 
+/* stop accepting writes and free the IN requests that are not in flight */
+static void hidg_disable_write(struct f_hidg *hidg)
+{
+	struct usb_request *req, *next;
+	unsigned long flags;
+
+	spin_lock_irqsave(&hidg->write_spinlock, flags);
+	hidg->write_enabled = false;
+	list_for_each_entry_safe(req, next, &hidg->idle_in_req, list) {
+		list_del(&req->list);
+		free_ep_req(hidg->in_ep, req);
+	}
+	spin_unlock_irqrestore(&hidg->write_spinlock, flags);
+
+	wake_up_all(&hidg->write_queue);
+}
+
 static void hidg_intout_complete(struct usb_ep *ep, struct usb_request *req)
 {
 	struct f_hidg *hidg = (struct f_hidg *) req->context;
@@ -780,21 +798,15 @@ static void hidg_disable(struct usb_function *f)
 		spin_unlock_irqrestore(&hidg->read_spinlock, flags);
 	}
 
-	spin_lock_irqsave(&hidg->write_spinlock, flags);
-	if (!hidg->write_pending) {
-		free_ep_req(hidg->in_ep, hidg->req);
-		hidg->write_pending = 1;
-	}
-
-	hidg->req = NULL;
-	spin_unlock_irqrestore(&hidg->write_spinlock, flags);
+	hidg_disable_write(hidg);
 }
 
 static int hidg_set_alt(struct usb_function *f, unsigned intf, unsigned alt)
 {
 	struct usb_composite_dev		*cdev = f->config->cdev;
 	struct f_hidg				*hidg = func_to_hidg(f);
-	struct usb_request			*req_in = NULL;
+	struct usb_request			*req_in, *next;
+	LIST_HEAD(reqs_in);
 	unsigned long				flags;
 	int i, status = 0;
 
@@ -803,6 +815,7 @@ static int hidg_set_alt(struct usb_function *f, unsigned intf, unsigned alt)
 	if (hidg->in_ep != NULL) {
 		/* restart endpoint */
 		usb_ep_disable(hidg->in_ep);
+		hidg_disable_write(hidg);
 
 		status = config_ep_by_speed(f->config->cdev->gadget, f,
 					    hidg->in_ep);
@@ -817,10 +830,16 @@ static int hidg_set_alt(struct usb_function *f, unsigned intf, unsigned alt)
 		}
 		hidg->in_ep->driver_data = hidg;
 
-		req_in = hidg_alloc_ep_req(hidg->in_ep, hidg->report_length);
-		if (!req_in) {
-			status = -ENOMEM;
-			goto disable_ep_in;
+		for (i = 0; i < hidg->write_qlen; i++) {
+			req_in = hidg_alloc_ep_req(hidg->in_ep,
+						   hidg->report_length);
+			if (!req_in) {
+				status = -ENOMEM;
+				goto free_req_in;
+			}
+			req_in->complete = f_hidg_req_complete;
+			req_in->context  = hidg;
+			list_add_tail(&req_in->list, &reqs_in);
 		}
 	}
 
@@ -867,21 +886,22 @@ static int hidg_set_alt(struct usb_function *f, unsigned intf, unsigned alt)
 
 	if (hidg->in_ep != NULL) {
 		spin_lock_irqsave(&hidg->write_spinlock, flags);
-		hidg->req = req_in;
-		hidg->write_pending = 0;
+		list_splice_tail(&reqs_in, &hidg->idle_in_req);
+		hidg->write_enabled = true;
 		spin_unlock_irqrestore(&hidg->write_spinlock, flags);
 
-		wake_up(&hidg->write_queue);
+		wake_up_all(&hidg->write_queue);
 	}
 	return 0;
 disable_out_ep:
 	if (hidg->out_ep)
 		usb_ep_disable(hidg->out_ep);
 free_req_in:
-	if (req_in)
+	list_for_each_entry_safe(req_in, next, &reqs_in, list) {
+		list_del(&req_in->list);
 		free_ep_req(hidg->in_ep, req_in);
+	}
 
-disable_ep_in:
 	if (hidg->in_ep)
 		usb_ep_disable(hidg->in_ep);
 
@@ -899,6 +919,69 @@ static const struct file_operations f_hidg_fops = {
 	.llseek		= noop_llseek,
 };
 
+#if IS_ENABLED(CONFIG_HIDRAW) && IS_REACHABLE(CONFIG_HID)
+/*
+ * Reports forwarded from a hidraw reader (HIDIOCSFORWARD) go straight into
+ * an idle IN request, from the context the HID device received them in.
+ * There is no one to wait for a request to complete, so reports arriving
+ * while all write_qlen requests are in flight are dropped.
+ */
+static int f_hidg_forward(struct file *file, const u8 *data, size_t len)
+{
+	struct f_hidg *hidg = file->private_data;
+	struct usb_request *req;
+	unsigned long flags;
+	int status;
+
+	if (!hidg)
+		return -ENODEV;
+
+	spin_lock_irqsave(&hidg->write_spinlock, flags);
+
+	if (!hidg->write_enabled || list_empty(&hidg->idle_in_req)) {
+		spin_unlock_irqrestore(&hidg->write_spinlock, flags);
+		return -EBUSY;
+	}
+
+	req = list_first_entry(&hidg->idle_in_req, struct usb_request, list);
+	list_del(&req->list);
+
+	len = min_t(size_t, len, hidg->report_length);
+	memcpy(req->buf, data, len);
+	req->status   = 0;
+	req->zero     = 0;
+	req->length   = len;
+	req->complete = f_hidg_req_complete;
+	req->context  = hidg;
+
+	spin_unlock_irqrestore(&hidg->write_spinlock, flags);
+
+	status = usb_ep_queue(hidg->in_ep, req, GFP_ATOMIC);
+	if (status < 0)
+		f_hidg_recycle_req(hidg, req);
+
+	return status;
+}
+
+static struct hidraw_sink f_hidg_sink = {
+	.fops		= &f_hidg_fops,
+	.forward	= f_hidg_forward,
+};
+
+static void hidg_register_sink(void)
+{
+	hidraw_register_sink(&f_hidg_sink);
+}
+
+static void hidg_unregister_sink(void)
+{
+	hidraw_unregister_sink(&f_hidg_sink);
+}
+#else
+static inline void hidg_register_sink(void) { }
+static inline void hidg_unregister_sink(void) { }
+#endif
+
 static int hidg_bind(struct usb_configuration *c, struct usb_function *f)
 {
 	struct usb_ep		*ep;
@@ -990,8 +1073,8 @@ static int hidg_bind(struct usb_configuration *c, struct usb_function *f)
 		goto fail;
 
 	spin_lock_init(&hidg->write_spinlock);
-	hidg->write_pending = 1;
-	hidg->req = NULL;
+	hidg->write_enabled = false;
+	INIT_LIST_HEAD(&hidg->idle_in_req);
 	spin_lock_init(&hidg->read_spinlock);
 	init_waitqueue_head(&hidg->write_queue);
 	init_waitqueue_head(&hidg->read_queue);
@@ -1018,8 +1101,6 @@ static int hidg_bind(struct usb_configuration *c, struct usb_function *f)
 	usb_free_all_descriptors(f);
 fail:
 	ERROR(f->config->cdev, "hidg_bind FAILED\n");
-	if (hidg->req != NULL)
-		free_ep_req(hidg->in_ep, hidg->req);
 
 	return status;
 }
@@ -1102,6 +1183,7 @@ F_HID_OPT(subclass, 8, 255);
 F_HID_OPT(protocol, 8, 255);
 F_HID_OPT(no_out_endpoint, 8, 1);
 F_HID_OPT(report_length, 16, 65535);
+F_HID_OPT(write_qlen, 8, 32);
 
 static ssize_t f_hid_opts_report_desc_show(struct config_item *item, char *page)
 {
@@ -1162,6 +1244,7 @@ static struct configfs_attribute *hid_attrs[] = {
 	&f_hid_opts_attr_protocol,
 	&f_hid_opts_attr_no_out_endpoint,
 	&f_hid_opts_attr_report_length,
+	&f_hid_opts_attr_write_qlen,
 	&f_hid_opts_attr_report_desc,
 	&f_hid_opts_attr_dev,
 	NULL,
@@ -1208,6 +1291,7 @@ static struct usb_function_instance *hidg_alloc_inst(void)
 	if (!opts)
 		return ERR_PTR(-ENOMEM);
 	mutex_init(&opts->lock);
+	opts->write_qlen = 1;
 	opts->func_inst.free_func_inst = hidg_free_inst;
 	ret = &opts->func_inst;
 
@@ -1281,6 +1365,7 @@ static struct usb_function *hidg_alloc(struct usb_function_instance *fi)
 	hidg->bInterfaceSubClass = opts->subclass;
 	hidg->bInterfaceProtocol = opts->protocol;
 	hidg->report_length = opts->report_length;
+	hidg->write_qlen = max_t(unsigned int, opts->write_qlen, 1);
 	hidg->report_desc_length = opts->report_desc_length;
 	if (opts->report_desc) {
 		hidg->report_desc = kmemdup(opts->report_desc,
@@ -1336,11 +1421,15 @@ int ghid_setup(struct usb_gadget *g, int count)
 	major = MAJOR(dev);
 	minors = count;
 
+	hidg_register_sink();
+
 	return 0;
 }
 
 void ghid_cleanup(void)
 {
+	hidg_unregister_sink();
+
 	if (major) {
 		unregister_chrdev_region(MKDEV(major, 0), minors);
 		major = minors = 0;
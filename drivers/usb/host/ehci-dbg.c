@@ -527,6 +527,11 @@ static ssize_t fill_bandwidth_buffer(struct debug_buffer *buf)
 
 	spin_lock_irq(&ehci->lock);
 
+	temp = scnprintf(next, size, "intr placement: %s\n\n",
+			ehci->intr_spread ? "spread" : "first fit");
+	size -= temp;
+	next += temp;
+
 	/* Dump the HS bandwidth table */
 	temp = scnprintf(next, size,
 			"HS bandwidth allocation (us per microframe)\n");
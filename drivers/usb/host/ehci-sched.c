@@ -829,8 +829,32 @@ static int check_intr_schedule(
 	return retval;
 }
 
+/* Worst HS load, plus TT budget for splits, over the uframes a slot uses */
+static unsigned intr_slot_load(
+	struct ehci_hcd		*ehci,
+	unsigned		frame,
+	unsigned		uframe,
+	struct ehci_qh		*qh
+)
+{
+	unsigned	load = 0;
+	unsigned	i, usecs;
+
+	for (i = (frame << 3) + uframe; i < EHCI_BANDWIDTH_SIZE;
+			i += qh->ps.bw_uperiod) {
+		usecs = ehci->bandwidth[i];
+		if (qh->ps.c_usecs)
+			usecs += ehci->tt_budget[i];
+		load = max(load, usecs);
+	}
+	return load;
+}
+
 /* "first fit" scheduling policy used the first time through,
- * or when the previous schedule slot can't be re-used.
+ * or when the previous schedule slot can't be re-used.  With
+ * intr_spread set, every fitting slot is checked and the least
+ * loaded one wins, so endpoints of equal period sharing a TT get
+ * separate frames and uframes instead of piling into uframe 0.
  */
 static int qh_schedule(struct ehci_hcd *ehci, struct ehci_qh *qh)
 {
@@ -863,17 +887,36 @@ static int qh_schedule(struct ehci_hcd *ehci, struct ehci_qh *qh)
 	/* "normal" case, uframing flexible except with splits */
 	if (qh->ps.bw_period) {
 		int		i;
-		unsigned	frame;
+		unsigned	frame, load;
+		unsigned	best_load = UINT_MAX;
+		unsigned	best_random = 0, best_uframe = 0, best_c_mask = 0;
 
 		for (i = qh->ps.bw_period; i > 0; --i) {
 			frame = ++ehci->random_frame & (qh->ps.bw_period - 1);
 			for (uframe = 0; uframe < 8; uframe++) {
 				status = check_intr_schedule(ehci,
 						frame, uframe, qh, &c_mask, tt);
-				if (status == 0)
+				if (status)
+					continue;
+				if (!ehci->intr_spread)
 					goto got_it;
+
+				load = intr_slot_load(ehci, frame, uframe, qh);
+				if (load < best_load) {
+					best_load = load;
+					best_random = ehci->random_frame;
+					best_uframe = uframe;
+					best_c_mask = c_mask;
+				}
 			}
 		}
+		if (best_load != UINT_MAX) {
+			ehci->random_frame = best_random;
+			uframe = best_uframe;
+			c_mask = best_c_mask;
+			status = 0;
+			goto got_it;
+		}
 
 	/* qh->ps.bw_period == 0 means every uframe */
 	} else {
@@ -145,6 +145,40 @@ static ssize_t uframe_periodic_max_store(struct device *dev,
 }
 static DEVICE_ATTR_RW(uframe_periodic_max);
 
+/*
+ * Display or change the interrupt QH placement policy:  0 for first fit,
+ * 1 to spread endpoints over the least loaded slots.  Only affects QHs
+ * scheduled afterwards.
+ */
+static ssize_t intr_spread_show(struct device *dev,
+				struct device_attribute *attr,
+				char *buf)
+{
+	struct ehci_hcd		*ehci;
+
+	ehci = hcd_to_ehci(dev_get_drvdata(dev));
+	return sysfs_emit(buf, "%d\n", ehci->intr_spread);
+}
+
+static ssize_t intr_spread_store(struct device *dev,
+				struct device_attribute *attr,
+				const char *buf, size_t count)
+{
+	struct ehci_hcd		*ehci;
+	unsigned long		flags;
+	bool			spread;
+
+	ehci = hcd_to_ehci(dev_get_drvdata(dev));
+	if (kstrtobool(buf, &spread) < 0)
+		return -EINVAL;
+
+	spin_lock_irqsave(&ehci->lock, flags);
+	ehci->intr_spread = spread;
+	spin_unlock_irqrestore(&ehci->lock, flags);
+	return count;
+}
+static DEVICE_ATTR_RW(intr_spread);
+
 
 static inline int create_sysfs_files(struct ehci_hcd *ehci)
 {
@@ -158,6 +192,10 @@ static inline int create_sysfs_files(struct ehci_hcd *ehci)
 		goto out;
 
 	i = device_create_file(controller, &dev_attr_uframe_periodic_max);
+	if (i)
+		goto out;
+
+	i = device_create_file(controller, &dev_attr_intr_spread);
 out:
 	return i;
 }
@@ -171,4 +209,5 @@ static inline void remove_sysfs_files(struct ehci_hcd *ehci)
 		device_remove_file(controller, &dev_attr_companion);
 
 	device_remove_file(controller, &dev_attr_uframe_periodic_max);
+	device_remove_file(controller, &dev_attr_intr_spread);
 }
@@ -166,6 +166,7 @@ struct ehci_hcd {			/* one per controller */
 	unsigned		isoc_count;	/* isoc activity count */
 	unsigned		periodic_count;	/* periodic activity count */
 	unsigned		uframe_periodic_max; /* max periodic time per uframe */
+	bool			intr_spread;	/* balance intr QHs, not first fit */
 
 
 	/* list of itds & sitds completed while now_frame was still active */
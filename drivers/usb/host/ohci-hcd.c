@@ -112,6 +112,12 @@ static bool no_handshake;
 module_param (no_handshake, bool, 0);
 MODULE_PARM_DESC (no_handshake, "true (not default) disables BIOS handshake");
 
+/* Completions run in the OHCI irq handler unless given back in a tasklet */
+static bool giveback_bh;
+module_param (giveback_bh, bool, 0444);
+MODULE_PARM_DESC (giveback_bh,
+	"true (not default) gives URBs back in a tasklet on all controllers");
+
 /*-------------------------------------------------------------------------*/
 
 static int number_of_tds(struct urb *urb)
@@ -370,6 +376,13 @@ ohci_endpoint_disable (struct usb_hcd *hcd, struct usb_host_endpoint *ep)
 	}
 
 	switch (ed->state) {
+	case ED_OPER:		/* idle periodic ED, see takeback_td() */
+		if (list_empty(&ed->td_list)) {
+			start_ed_unlink(ohci, ed);
+			spin_unlock_irqrestore(&ohci->lock, flags);
+			goto rescan;
+		}
+		goto leak;
 	case ED_UNLINK:		/* wait for hw to finish? */
 		/* major IRQ delivery trouble loses INTR_SF too... */
 		if (limit-- == 0) {
@@ -387,6 +400,7 @@ ohci_endpoint_disable (struct usb_hcd *hcd, struct usb_host_endpoint *ep)
 		}
 		fallthrough;
 	default:
+leak:
 		/* caller was supposed to have unlinked any requests;
 		 * that's not our job.  can't recover; must leak ed.
 		 */
@@ -463,6 +477,10 @@ static int ohci_init (struct ohci_hcd *ohci)
 	if (distrust_firmware)
 		ohci->flags |= OHCI_QUIRK_HUB_POWER;
 
+	/* glue drivers may have asked for it already */
+	if (giveback_bh)
+		hcd->giveback_in_bh = 1;
+
 	ohci->rh_state = OHCI_RH_HALTED;
 	ohci->regs = hcd->regs;
 
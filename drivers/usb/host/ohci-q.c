@@ -1162,9 +1162,16 @@ static void takeback_td(struct ohci_hcd *ohci, struct td *td)
 	if (urb_priv->td_cnt >= urb_priv->length)
 		finish_urb(ohci, urb, status);
 
-	/* clean schedule:  unlink EDs that are no longer busy */
+	/*
+	 * clean schedule:  unlink EDs that are no longer busy.  With
+	 * tasklet giveback, the completion handler resubmits only after
+	 * this; leave interrupt EDs linked rather than relinking them for
+	 * every single report.  Endpoint disable unlinks them at last.
+	 */
 	if (list_empty(&ed->td_list)) {
-		if (ed->state == ED_OPER)
+		if (ed->state == ED_OPER &&
+		    !(ed->type == PIPE_INTERRUPT &&
+		      hcd_giveback_urb_in_bh(ohci_to_hcd(ohci))))
 			start_ed_unlink(ohci, ed);
 
 	/* ... reenabling halted EDs only after fault cleanup */
@@ -1839,6 +1839,9 @@ void xhci_mem_cleanup(struct xhci_hcd *xhci)
 
 	cancel_delayed_work_sync(&xhci->cmd_timer);
 
+	xhci_free_interrupter(xhci, xhci->lowlat_ir);
+	xhci->lowlat_ir = NULL;
+
 	xhci_free_erst(xhci, &xhci->erst);
 
 	if (xhci->event_ring)
@@ -2090,18 +2093,19 @@ static int xhci_check_trb_in_td_math(struct xhci_hcd *xhci)
 	return 0;
 }
 
-static void xhci_set_hc_event_deq(struct xhci_hcd *xhci)
+static void xhci_set_ir_event_deq(struct xhci_hcd *xhci,
+		struct xhci_intr_reg __iomem *ir_set,
+		struct xhci_ring *event_ring)
 {
 	u64 temp;
 	dma_addr_t deq;
 
-	deq = xhci_trb_virt_to_dma(xhci->event_ring->deq_seg,
-			xhci->event_ring->dequeue);
+	deq = xhci_trb_virt_to_dma(event_ring->deq_seg, event_ring->dequeue);
 	if (!deq)
 		xhci_warn(xhci, "WARN something wrong with SW event ring "
 				"dequeue ptr.\n");
 	/* Update HC event ring dequeue pointer */
-	temp = xhci_read_64(xhci, &xhci->ir_set->erst_dequeue);
+	temp = xhci_read_64(xhci, &ir_set->erst_dequeue);
 	temp &= ERST_PTR_MASK;
 	/* Don't clear the EHB bit (which is RW1C) because
 	 * there might be more events to service.
@@ -2111,7 +2115,88 @@ static void xhci_set_hc_event_deq(struct xhci_hcd *xhci)
 			"// Write event ring dequeue pointer, "
 			"preserving EHB bit");
 	xhci_write_64(xhci, ((u64) deq & (u64) ~ERST_PTR_MASK) | temp,
-			&xhci->ir_set->erst_dequeue);
+			&ir_set->erst_dequeue);
+}
+
+static void xhci_set_hc_event_deq(struct xhci_hcd *xhci)
+{
+	xhci_set_ir_event_deq(xhci, xhci->ir_set, xhci->event_ring);
+}
+
+/*
+ * Set up interrupter @intr_num with an event ring of its own. The
+ * interrupter is left disabled, its moderation interval is programmed when
+ * it is enabled. Returns NULL if the host has no such interrupter or
+ * memory is short, the endpoints meant for it then use interrupter 0.
+ */
+struct xhci_interrupter *xhci_alloc_interrupter(struct xhci_hcd *xhci,
+		unsigned int intr_num, u32 imod_interval, gfp_t flags)
+{
+	struct device *dev = xhci_to_hcd(xhci)->self.sysdev;
+	struct xhci_interrupter *ir;
+	u64 val_64;
+	u32 val;
+
+	if (intr_num >= min_t(u32, HCS_MAX_INTRS(xhci->hcs_params1),
+			      ARRAY_SIZE(xhci->run_regs->ir_set)))
+		return NULL;
+
+	ir = kzalloc_node(sizeof(*ir), flags, dev_to_node(dev));
+	if (!ir)
+		return NULL;
+
+	ir->intr_num = intr_num;
+	ir->ir_set = &xhci->run_regs->ir_set[intr_num];
+	ir->imod_interval = imod_interval;
+
+	ir->event_ring = xhci_ring_alloc(xhci, ERST_NUM_SEGS, 1, TYPE_EVENT,
+					 0, flags);
+	if (!ir->event_ring)
+		goto free_ir;
+	if (xhci_alloc_erst(xhci, ir->event_ring, &ir->erst, flags))
+		goto free_ring;
+
+	val = readl(&ir->ir_set->erst_size);
+	val &= ERST_SIZE_MASK;
+	val |= ERST_NUM_SEGS;
+	writel(val, &ir->ir_set->erst_size);
+
+	/* the dequeue pointer goes first, writing the base enables the ring */
+	xhci_set_ir_event_deq(xhci, ir->ir_set, ir->event_ring);
+	val_64 = xhci_read_64(xhci, &ir->ir_set->erst_base);
+	val_64 &= ERST_PTR_MASK;
+	val_64 |= (ir->erst.erst_dma_addr & (u64) ~ERST_PTR_MASK);
+	xhci_write_64(xhci, val_64, &ir->ir_set->erst_base);
+
+	xhci_dbg_trace(xhci, trace_xhci_dbg_init,
+			"Wrote ERST address to ir_set %u.", intr_num);
+	return ir;
+
+free_ring:
+	xhci_ring_free(xhci, ir->event_ring);
+free_ir:
+	kfree(ir);
+	return NULL;
+}
+
+void xhci_free_interrupter(struct xhci_hcd *xhci, struct xhci_interrupter *ir)
+{
+	u32 val;
+
+	if (!ir)
+		return;
+
+	val = readl(&ir->ir_set->irq_pending);
+	writel(ER_IRQ_DISABLE(val), &ir->ir_set->irq_pending);
+	/* an ERST size of zero disables the event ring */
+	val = readl(&ir->ir_set->erst_size);
+	writel(val & ERST_SIZE_MASK, &ir->ir_set->erst_size);
+
+	xhci_free_erst(xhci, &ir->erst);
+	xhci_ring_free(xhci, ir->event_ring);
+	xhci_dbg_trace(xhci, trace_xhci_dbg_init,
+			"Freed event ring of ir_set %u", ir->intr_num);
+	kfree(ir);
 }
 
 static void xhci_add_in_port(struct xhci_hcd *xhci, unsigned int num_ports,
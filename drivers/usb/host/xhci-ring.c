@@ -2551,6 +2551,7 @@ static int process_bulk_intr_td(struct xhci_hcd *xhci, struct xhci_virt_ep *ep,
  * At this point, the host controller is probably hosed and should be reset.
  */
 static int handle_tx_event(struct xhci_hcd *xhci,
+		struct xhci_ring *event_ring,
 		struct xhci_transfer_event *event)
 {
 	struct xhci_virt_ep *ep;
@@ -2900,7 +2901,7 @@ static int handle_tx_event(struct xhci_hcd *xhci,
 		 * processing missed tds.
 		 */
 		if (!handling_skipped_tds)
-			inc_deq(xhci, xhci->event_ring);
+			inc_deq(xhci, event_ring);
 
 	/*
 	 * If ep->skip is set, it means there are missed tds on the
@@ -2915,8 +2916,8 @@ static int handle_tx_event(struct xhci_hcd *xhci,
 err_out:
 	xhci_err(xhci, "@%016llx %08x %08x %08x %08x\n",
 		 (unsigned long long) xhci_trb_virt_to_dma(
-			 xhci->event_ring->deq_seg,
-			 xhci->event_ring->dequeue),
+			 event_ring->deq_seg,
+			 event_ring->dequeue),
 		 lower_32_bits(le64_to_cpu(event->buffer)),
 		 upper_32_bits(le64_to_cpu(event->buffer)),
 		 le32_to_cpu(event->transfer_len),
@@ -2929,8 +2930,12 @@ static int handle_tx_event(struct xhci_hcd *xhci,
  * xhci->lock between event processing (e.g. to pass up port status changes).
  * Returns >0 for "possibly more events to process" (caller should call again),
  * otherwise 0 if done.  In future, <0 returns should indicate error code.
+ *
+ * Port status changes are only posted to the event ring of interrupter 0,
+ * @event_ring may be that of the low-latency interrupter otherwise.
  */
-static int xhci_handle_event(struct xhci_hcd *xhci)
+static int xhci_handle_event(struct xhci_hcd *xhci,
+		struct xhci_ring *event_ring)
 {
 	union xhci_trb *event;
 	int update_ptrs = 1;
@@ -2938,18 +2943,18 @@ static int xhci_handle_event(struct xhci_hcd *xhci)
 	int ret;
 
 	/* Event ring hasn't been allocated yet. */
-	if (!xhci->event_ring || !xhci->event_ring->dequeue) {
+	if (!event_ring || !event_ring->dequeue) {
 		xhci_err(xhci, "ERROR event ring not ready\n");
 		return -ENOMEM;
 	}
 
-	event = xhci->event_ring->dequeue;
+	event = event_ring->dequeue;
 	/* Does the HC or OS own the TRB? */
 	if ((le32_to_cpu(event->event_cmd.flags) & TRB_CYCLE) !=
-	    xhci->event_ring->cycle_state)
+	    event_ring->cycle_state)
 		return 0;
 
-	trace_xhci_handle_event(xhci->event_ring, &event->generic);
+	trace_xhci_handle_event(event_ring, &event->generic);
 
 	/*
 	 * Barrier between reading the TRB_CYCLE (valid) flag above and any
@@ -2968,7 +2973,7 @@ static int xhci_handle_event(struct xhci_hcd *xhci)
 		update_ptrs = 0;
 		break;
 	case TRB_TRANSFER:
-		ret = handle_tx_event(xhci, &event->trans_event);
+		ret = handle_tx_event(xhci, event_ring, &event->trans_event);
 		if (ret >= 0)
 			update_ptrs = 0;
 		break;
@@ -2992,7 +2997,7 @@ static int xhci_handle_event(struct xhci_hcd *xhci)
 
 	if (update_ptrs)
 		/* Update SW event ring dequeue pointer */
-		inc_deq(xhci, xhci->event_ring);
+		inc_deq(xhci, event_ring);
 
 	/* Are there more items on the event ring?  Caller will call us again to
 	 * check.
@@ -3006,16 +3011,18 @@ static int xhci_handle_event(struct xhci_hcd *xhci)
  * - To avoid "Event Ring Full Error" condition
  */
 static void xhci_update_erst_dequeue(struct xhci_hcd *xhci,
+		struct xhci_intr_reg __iomem *ir_set,
+		struct xhci_ring *event_ring,
 		union xhci_trb *event_ring_deq)
 {
 	u64 temp_64;
 	dma_addr_t deq;
 
-	temp_64 = xhci_read_64(xhci, &xhci->ir_set->erst_dequeue);
+	temp_64 = xhci_read_64(xhci, &ir_set->erst_dequeue);
 	/* If necessary, update the HW's version of the event ring deq ptr. */
-	if (event_ring_deq != xhci->event_ring->dequeue) {
-		deq = xhci_trb_virt_to_dma(xhci->event_ring->deq_seg,
-				xhci->event_ring->dequeue);
+	if (event_ring_deq != event_ring->dequeue) {
+		deq = xhci_trb_virt_to_dma(event_ring->deq_seg,
+				event_ring->dequeue);
 		if (deq == 0)
 			xhci_warn(xhci, "WARN something wrong with SW event ring dequeue ptr\n");
 		/*
@@ -3033,7 +3040,7 @@ static void xhci_update_erst_dequeue(struct xhci_hcd *xhci,
 
 	/* Clear the event handler busy flag (RW1C) */
 	temp_64 |= ERST_EHB;
-	xhci_write_64(xhci, temp_64, &xhci->ir_set->erst_dequeue);
+	xhci_write_64(xhci, temp_64, &ir_set->erst_dequeue);
 }
 
 /*
@@ -3102,10 +3109,11 @@ irqreturn_t xhci_irq(struct usb_hcd *hcd)
 	/* FIXME this should be a delayed service routine
 	 * that clears the EHB.
 	 */
-	while (xhci_handle_event(xhci) > 0) {
+	while (xhci_handle_event(xhci, xhci->event_ring) > 0) {
 		if (event_loop++ < TRBS_PER_SEGMENT / 2)
 			continue;
-		xhci_update_erst_dequeue(xhci, event_ring_deq);
+		xhci_update_erst_dequeue(xhci, xhci->ir_set, xhci->event_ring,
+					 event_ring_deq);
 
 		/* ring is half-full, force isoc trbs to interrupt more often */
 		if (xhci->isoc_bei_interval > AVOID_BEI_INTERVAL_MIN)
@@ -3114,7 +3122,8 @@ irqreturn_t xhci_irq(struct usb_hcd *hcd)
 		event_loop = 0;
 	}
 
-	xhci_update_erst_dequeue(xhci, event_ring_deq);
+	xhci_update_erst_dequeue(xhci, xhci->ir_set, xhci->event_ring,
+				 event_ring_deq);
 	ret = IRQ_HANDLED;
 
 out:
@@ -3128,6 +3137,48 @@ irqreturn_t xhci_msi_irq(int irq, void *hcd)
 	return xhci_irq(hcd);
 }
 
+/*
+ * MSI-X handler of the low-latency interrupter. Only transfer events are
+ * posted to its event ring. USBSTS EINT is left for xhci_irq() to clear,
+ * clearing it here could hide a pending event of interrupter 0 from it.
+ */
+irqreturn_t xhci_lowlat_irq(int irq, void *hcd)
+{
+	struct xhci_hcd *xhci = hcd_to_xhci(hcd);
+	struct xhci_interrupter *ir;
+	union xhci_trb *event_ring_deq;
+	int event_loop = 0;
+
+	spin_lock(&xhci->lock);
+	ir = xhci->lowlat_ir;
+	if (!ir)
+		goto out;
+
+	event_ring_deq = ir->event_ring->dequeue;
+	if (xhci->xhc_state & XHCI_STATE_DYING ||
+	    xhci->xhc_state & XHCI_STATE_HALTED) {
+		/* Only clear the event handler busy flag */
+		xhci_update_erst_dequeue(xhci, ir->ir_set, ir->event_ring,
+					 event_ring_deq);
+		goto out;
+	}
+
+	while (xhci_handle_event(xhci, ir->event_ring) > 0) {
+		if (event_loop++ < TRBS_PER_SEGMENT / 2)
+			continue;
+		xhci_update_erst_dequeue(xhci, ir->ir_set, ir->event_ring,
+					 event_ring_deq);
+		event_loop = 0;
+	}
+
+	xhci_update_erst_dequeue(xhci, ir->ir_set, ir->event_ring,
+				 event_ring_deq);
+out:
+	spin_unlock(&xhci->lock);
+
+	return IRQ_HANDLED;
+}
+
 /****		Endpoint Ring Operations	****/
 
 /*
@@ -3538,6 +3589,18 @@ static int xhci_align_td(struct xhci_hcd *xhci, struct urb *urb, u32 enqd_len,
 	return 1;
 }
 
+/*
+ * Transfers of latency sensitive endpoints complete on the low-latency
+ * interrupter when there is one. The flag is set before the first URB is
+ * submitted, so all the TRBs of an endpoint target the same event ring.
+ */
+static u32 xhci_urb_intr_target(struct xhci_hcd *xhci, struct urb *urb)
+{
+	if (xhci->lowlat_ir && urb->ep->latency_sensitive)
+		return xhci->lowlat_ir->intr_num;
+	return 0;
+}
+
 /* This is very similar to what ehci-q.c qtd_fill() does */
 int xhci_queue_bulk_tx(struct xhci_hcd *xhci, gfp_t mem_flags,
 		struct urb *urb, int slot_id, unsigned int ep_index)
@@ -3554,9 +3617,10 @@ int xhci_queue_bulk_tx(struct xhci_hcd *xhci, gfp_t mem_flags,
 	unsigned int start_cycle, num_sgs = 0;
 	unsigned int enqd_len, block_len, trb_buff_len, full_len;
 	int sent_len, ret;
-	u32 field, length_field, remainder;
+	u32 field, length_field, remainder, intr;
 	u64 addr, send_addr;
 
+	intr = xhci_urb_intr_target(xhci, urb);
 	ring = xhci_urb_to_transfer_ring(xhci, urb);
 	if (!ring)
 		return -EINVAL;
@@ -3656,7 +3720,7 @@ int xhci_queue_bulk_tx(struct xhci_hcd *xhci, gfp_t mem_flags,
 
 		length_field = TRB_LEN(trb_buff_len) |
 			TRB_TD_SIZE(remainder) |
-			TRB_INTR_TARGET(0);
+			TRB_INTR_TARGET(intr);
 
 		queue_trb(xhci, ring, more_trbs_coming | need_zero_pkt,
 				lower_32_bits(send_addr),
@@ -3689,7 +3753,7 @@ int xhci_queue_bulk_tx(struct xhci_hcd *xhci, gfp_t mem_flags,
 		urb_priv->td[1].last_trb = ring->enqueue;
 		urb_priv->td[1].last_trb_seg = ring->enq_seg;
 		field = TRB_TYPE(TRB_NORMAL) | ring->cycle_state | TRB_IOC;
-		queue_trb(xhci, ring, 0, 0, 0, TRB_INTR_TARGET(0), field);
+		queue_trb(xhci, ring, 0, 0, 0, TRB_INTR_TARGET(intr), field);
 		urb_priv->td[1].num_trbs++;
 	}
 
@@ -4007,7 +4071,7 @@ static int xhci_queue_isoc_tx(struct xhci_hcd *xhci, gfp_t mem_flags,
 	struct xhci_generic_trb *start_trb;
 	bool first_trb;
 	int start_cycle;
-	u32 field, length_field;
+	u32 field, length_field, intr;
 	int running_total, trb_buff_len, td_len, td_remain_len, ret;
 	u64 start_addr, addr;
 	int i, j;
@@ -4015,6 +4079,7 @@ static int xhci_queue_isoc_tx(struct xhci_hcd *xhci, gfp_t mem_flags,
 	struct xhci_virt_ep *xep;
 	int frame_id;
 
+	intr = xhci_urb_intr_target(xhci, urb);
 	xep = &xhci->devs[slot_id]->eps[ep_index];
 	ep_ring = xhci->devs[slot_id]->eps[ep_index].ring;
 
@@ -4118,7 +4183,7 @@ static int xhci_queue_isoc_tx(struct xhci_hcd *xhci, gfp_t mem_flags,
 						   urb, more_trbs_coming);
 
 			length_field = TRB_LEN(trb_buff_len) |
-				TRB_INTR_TARGET(0);
+				TRB_INTR_TARGET(intr);
 
 			/* xhci 1.1 with ETE uses TD Size field for TBC */
 			if (first_trb && xep->use_extended_tbc)
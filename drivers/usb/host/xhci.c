@@ -37,6 +37,11 @@ static unsigned long long quirks;
 module_param(quirks, ullong, S_IRUGO);
 MODULE_PARM_DESC(quirks, "Bit flags for quirks to be enabled as default");
 
+/* Latency sensitive endpoints complete on interrupter 1, with MSI-X */
+static int lowlat_imod = -1;
+module_param(lowlat_imod, int, S_IRUGO);
+MODULE_PARM_DESC(lowlat_imod, "Interrupt moderation in ns of latency sensitive endpoints, -1 to leave them on the primary interrupter");
+
 static bool td_on_ring(struct xhci_td *td, struct xhci_ring *ring)
 {
 	struct xhci_segment *seg = ring->first_seg;
@@ -347,7 +352,12 @@ static int xhci_setup_msix(struct xhci_hcd *xhci)
 	}
 
 	for (i = 0; i < xhci->msix_count; i++) {
-		ret = request_irq(pci_irq_vector(pdev, i), xhci_msi_irq, 0,
+		irq_handler_t handler = xhci_msi_irq;
+
+		/* Interrupter n signals MSI-X vector n */
+		if (xhci->lowlat_ir && i == xhci->lowlat_ir->intr_num)
+			handler = xhci_lowlat_irq;
+		ret = request_irq(pci_irq_vector(pdev, i), handler, 0,
 				"xhci_hcd", xhci_to_hcd(xhci));
 		if (ret)
 			goto disable_msix;
@@ -591,6 +601,9 @@ static int xhci_init(struct usb_hcd *hcd)
 				"xHCI doesn't need link TRB QUIRK");
 	}
 	retval = xhci_mem_init(xhci, GFP_KERNEL);
+	if (!retval && lowlat_imod >= 0)
+		xhci->lowlat_ir = xhci_alloc_interrupter(xhci, 1, lowlat_imod,
+							 GFP_KERNEL);
 	xhci_dbg_trace(xhci, trace_xhci_dbg_init, "Finished xhci_init");
 
 	/* Initializing Compliance Mode Recovery Data If Needed */
@@ -622,6 +635,36 @@ static int xhci_run_finished(struct xhci_hcd *xhci)
 	return 0;
 }
 
+/*
+ * Only MSI-X gives the low-latency interrupter a vector of its own, without
+ * it the endpoints meant for it go back to interrupter 0.
+ */
+static void xhci_enable_lowlat_ir(struct xhci_hcd *xhci)
+{
+	struct xhci_interrupter *ir = xhci->lowlat_ir;
+	u32 temp;
+
+	if (!ir)
+		return;
+
+	if (!xhci_to_hcd(xhci)->msix_enabled ||
+	    ir->intr_num >= xhci->msix_count) {
+		xhci_dbg_trace(xhci, trace_xhci_dbg_init,
+				"No MSI-X vector for ir_set %u", ir->intr_num);
+		xhci_free_interrupter(xhci, ir);
+		xhci->lowlat_ir = NULL;
+		return;
+	}
+
+	temp = readl(&ir->ir_set->irq_control);
+	temp &= ~ER_IRQ_INTERVAL_MASK;
+	temp |= (ir->imod_interval / 250) & ER_IRQ_INTERVAL_MASK;
+	writel(temp, &ir->ir_set->irq_control);
+
+	temp = readl(&ir->ir_set->irq_pending);
+	writel(ER_IRQ_ENABLE(temp), &ir->ir_set->irq_pending);
+}
+
 /*
  * Start the HC after it was halted.
  *
@@ -680,6 +723,8 @@ int xhci_run(struct usb_hcd *hcd)
 			xhci->ir_set, (unsigned int) ER_IRQ_ENABLE(temp));
 	writel(ER_IRQ_ENABLE(temp), &xhci->ir_set->irq_pending);
 
+	xhci_enable_lowlat_ir(xhci);
+
 	if (xhci->quirks & XHCI_NEC_HOST) {
 		struct xhci_command *command;
 
@@ -808,6 +853,17 @@ static void xhci_save_registers(struct xhci_hcd *xhci)
 	xhci->s3.erst_dequeue = xhci_read_64(xhci, &xhci->ir_set->erst_dequeue);
 	xhci->s3.irq_pending = readl(&xhci->ir_set->irq_pending);
 	xhci->s3.irq_control = readl(&xhci->ir_set->irq_control);
+
+	if (xhci->lowlat_ir) {
+		struct xhci_interrupter *ir = xhci->lowlat_ir;
+
+		ir->s3.erst_size = readl(&ir->ir_set->erst_size);
+		ir->s3.erst_base = xhci_read_64(xhci, &ir->ir_set->erst_base);
+		ir->s3.erst_dequeue = xhci_read_64(xhci,
+						   &ir->ir_set->erst_dequeue);
+		ir->s3.irq_pending = readl(&ir->ir_set->irq_pending);
+		ir->s3.irq_control = readl(&ir->ir_set->irq_control);
+	}
 }
 
 static void xhci_restore_registers(struct xhci_hcd *xhci)
@@ -821,6 +877,17 @@ static void xhci_restore_registers(struct xhci_hcd *xhci)
 	xhci_write_64(xhci, xhci->s3.erst_dequeue, &xhci->ir_set->erst_dequeue);
 	writel(xhci->s3.irq_pending, &xhci->ir_set->irq_pending);
 	writel(xhci->s3.irq_control, &xhci->ir_set->irq_control);
+
+	if (xhci->lowlat_ir) {
+		struct xhci_interrupter *ir = xhci->lowlat_ir;
+
+		writel(ir->s3.erst_size, &ir->ir_set->erst_size);
+		xhci_write_64(xhci, ir->s3.erst_dequeue,
+			      &ir->ir_set->erst_dequeue);
+		xhci_write_64(xhci, ir->s3.erst_base, &ir->ir_set->erst_base);
+		writel(ir->s3.irq_pending, &ir->ir_set->irq_pending);
+		writel(ir->s3.irq_control, &ir->ir_set->irq_control);
+	}
 }
 
 static void xhci_set_cmd_ring_deq(struct xhci_hcd *xhci)
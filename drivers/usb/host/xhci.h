@@ -1690,6 +1690,23 @@ struct s3_save {
 	u64	erst_dequeue;
 };
 
+/*
+ * A secondary interrupter, with an event ring and a moderation interval of
+ * its own. Transfer TRBs name it as their interrupter target, so that their
+ * completions are neither held back by the moderation of interrupter 0 nor
+ * queued behind its events. Commands and port status changes always
+ * complete on interrupter 0.
+ */
+struct xhci_interrupter {
+	struct xhci_intr_reg __iomem	*ir_set;
+	unsigned int		intr_num;
+	struct xhci_ring	*event_ring;
+	struct xhci_erst	erst;
+	/* imod_interval in ns (I * 250ns) */
+	u32			imod_interval;
+	struct s3_save		s3;
+};
+
 /* Use for lpm */
 struct dev_info {
 	u32			dev_id;
@@ -1804,6 +1821,8 @@ struct xhci_hcd {
 	struct xhci_command	*current_cmd;
 	struct xhci_ring	*event_ring;
 	struct xhci_erst	erst;
+	/* for latency sensitive endpoints, NULL if they use interrupter 0 */
+	struct xhci_interrupter	*lowlat_ir;
 	/* Scratchpad */
 	struct xhci_scratchpad  *scratchpad;
 	/* Store LPM test failed devices' information */
@@ -2049,6 +2068,9 @@ int xhci_alloc_erst(struct xhci_hcd *xhci,
 void xhci_initialize_ring_info(struct xhci_ring *ring,
 			unsigned int cycle_state);
 void xhci_free_erst(struct xhci_hcd *xhci, struct xhci_erst *erst);
+struct xhci_interrupter *xhci_alloc_interrupter(struct xhci_hcd *xhci,
+		unsigned int intr_num, u32 imod_interval, gfp_t flags);
+void xhci_free_interrupter(struct xhci_hcd *xhci, struct xhci_interrupter *ir);
 void xhci_free_endpoint_ring(struct xhci_hcd *xhci,
 		struct xhci_virt_device *virt_dev,
 		unsigned int ep_index);
@@ -2106,6 +2128,7 @@ int xhci_resume(struct xhci_hcd *xhci, bool hibernated);
 
 irqreturn_t xhci_irq(struct usb_hcd *hcd);
 irqreturn_t xhci_msi_irq(int irq, void *hcd);
+irqreturn_t xhci_lowlat_irq(int irq, void *hcd);
 int xhci_alloc_dev(struct usb_hcd *hcd, struct usb_device *udev);
 int xhci_alloc_tt_info(struct xhci_hcd *xhci,
 		struct xhci_virt_device *virt_dev,
@@ -1035,24 +1035,111 @@ static int z_erofs_decompress_pcluster(struct super_block *sb,
 	return err;
 }
 
-static void z_erofs_decompress_queue(const struct z_erofs_decompressqueue *io,
-				     struct list_head *pagepool)
-{
-	z_erofs_next_pcluster_t owned = io->head;
+/*
+ * pclusters of one queue are independent, so a queue holding several of
+ * them is decompressed by the caller and up to this many helpers on
+ * z_erofs_workqueue, all taking pclusters from the same chain.
+ */
+#define Z_EROFS_DECOMPRESS_HELPERS	7
 
-	while (owned != Z_EROFS_PCLUSTER_TAIL_CLOSED) {
-		struct z_erofs_pcluster *pcl;
+struct z_erofs_decompress_ctx {
+	struct super_block *sb;
+	spinlock_t lock;
+	z_erofs_next_pcluster_t owned;
+};
 
+struct z_erofs_decompress_helper {
+	struct work_struct work;
+	struct z_erofs_decompress_ctx *ctx;
+};
+
+static struct z_erofs_pcluster *
+z_erofs_next_pcluster(struct z_erofs_decompress_ctx *ctx)
+{
+	struct z_erofs_pcluster *pcl = NULL;
+
+	spin_lock(&ctx->lock);
+	if (ctx->owned != Z_EROFS_PCLUSTER_TAIL_CLOSED) {
 		/* no possible that 'owned' equals Z_EROFS_WORK_TPTR_TAIL */
-		DBG_BUGON(owned == Z_EROFS_PCLUSTER_TAIL);
+		DBG_BUGON(ctx->owned == Z_EROFS_PCLUSTER_TAIL);
 
 		/* no possible that 'owned' equals NULL */
-		DBG_BUGON(owned == Z_EROFS_PCLUSTER_NIL);
+		DBG_BUGON(ctx->owned == Z_EROFS_PCLUSTER_NIL);
 
-		pcl = container_of(owned, struct z_erofs_pcluster, next);
-		owned = READ_ONCE(pcl->next);
+		pcl = container_of(ctx->owned, struct z_erofs_pcluster, next);
+		/* must be read before decompression resets it */
+		ctx->owned = READ_ONCE(pcl->next);
+	}
+	spin_unlock(&ctx->lock);
+	return pcl;
+}
+
+static void z_erofs_decompress_chain(struct z_erofs_decompress_ctx *ctx,
+				     struct list_head *pagepool)
+{
+	struct z_erofs_pcluster *pcl;
+
+	while ((pcl = z_erofs_next_pcluster(ctx)))
+		z_erofs_decompress_pcluster(ctx->sb, pcl, pagepool);
+}
 
-		z_erofs_decompress_pcluster(io->sb, pcl, pagepool);
+static void z_erofs_decompress_helper_work(struct work_struct *work)
+{
+	struct z_erofs_decompress_helper *h =
+		container_of(work, struct z_erofs_decompress_helper, work);
+	LIST_HEAD(pagepool);
+
+	z_erofs_decompress_chain(h->ctx, &pagepool);
+	put_pages_list(&pagepool);
+}
+
+/* number of helpers worth waking for the chain starting at @owned */
+static unsigned int z_erofs_nr_helpers(z_erofs_next_pcluster_t owned)
+{
+	unsigned int max = min_t(unsigned int, num_online_cpus() - 1,
+				 Z_EROFS_DECOMPRESS_HELPERS);
+	unsigned int nr = 0;
+
+	while (owned != Z_EROFS_PCLUSTER_TAIL_CLOSED && nr <= max) {
+		owned = READ_ONCE(container_of(owned, struct z_erofs_pcluster,
+					       next)->next);
+		nr++;
+	}
+	return nr ? nr - 1 : 0;
+}
+
+static void z_erofs_decompress_queue(const struct z_erofs_decompressqueue *io,
+				     struct list_head *pagepool)
+{
+	struct z_erofs_decompress_helper helpers[Z_EROFS_DECOMPRESS_HELPERS];
+	struct z_erofs_decompress_ctx ctx = {
+		.sb = io->sb,
+		.lock = __SPIN_LOCK_UNLOCKED(ctx.lock),
+		.owned = io->head,
+	};
+	unsigned int i, nr = 0;
+
+	/* helpers sleep-wait below, which atomic contexts can't do */
+	if (!in_atomic() && !irqs_disabled())
+		nr = z_erofs_nr_helpers(ctx.owned);
+
+	for (i = 0; i < nr; i++) {
+		INIT_WORK_ONSTACK(&helpers[i].work,
+				  z_erofs_decompress_helper_work);
+		helpers[i].ctx = &ctx;
+		queue_work(z_erofs_workqueue, &helpers[i].work);
+	}
+
+	z_erofs_decompress_chain(&ctx, pagepool);
+
+	/*
+	 * The chain is empty now. Helpers which haven't started yet have
+	 * nothing left to do and are just cancelled, which also keeps this
+	 * from waiting on a busy workqueue when called from it.
+	 */
+	for (i = 0; i < nr; i++) {
+		cancel_work_sync(&helpers[i].work);
+		destroy_work_on_stack(&helpers[i].work);
 	}
 }
 
@@ -37,6 +37,7 @@
 #include <linux/seq_file.h>
 #include <linux/compat.h>
 #include <linux/rculist.h>
+#include <linux/hrtimer.h>
 #include <net/busy_poll.h>
 
 /*
@@ -222,6 +223,13 @@ struct eventpoll {
 	unsigned int napi_id;
 #endif
 
+	/* wakeup coalescing, set with EPIOCSCOALESCE */
+	struct hrtimer coalesce_timer;
+	u32 coalesce_usecs;
+	u32 coalesce_max_ready;
+	/* files queued on the ready list since the last wakeup */
+	atomic_t coalesce_count;
+
 #ifdef CONFIG_DEBUG_LOCK_ALLOC
 	/* tracks wakeup nests for lockdep validation */
 	u8 nests;
@@ -375,6 +383,64 @@ static inline int ep_events_available(struct eventpoll *ep)
 		READ_ONCE(ep->ovflist) != EP_UNACTIVE_PTR;
 }
 
+/*
+ * Like ep_events_available(), but a blocking waiter keeps waiting while
+ * the coalescing timer runs. Called with ep->lock held, the same lock the
+ * timer takes to wake up the waiters.
+ */
+static inline int ep_events_ready(struct eventpoll *ep)
+{
+	if (READ_ONCE(ep->coalesce_usecs) &&
+	    hrtimer_is_queued(&ep->coalesce_timer))
+		return 0;
+	return ep_events_available(ep);
+}
+
+static void ep_coalesce_wake(struct eventpoll *ep)
+{
+	unsigned long flags;
+
+	read_lock_irqsave(&ep->lock, flags);
+	atomic_set(&ep->coalesce_count, 0);
+	wake_up(&ep->wq);
+	read_unlock_irqrestore(&ep->lock, flags);
+}
+
+static enum hrtimer_restart ep_coalesce_timer(struct hrtimer *timer)
+{
+	ep_coalesce_wake(container_of(timer, struct eventpoll, coalesce_timer));
+	return HRTIMER_NORESTART;
+}
+
+/*
+ * Wake up the epoll_wait() waiters, or with coalescing start the timer
+ * and wake them early only once enough files are ready. @queued tells
+ * whether the caller just put a file on the ready list. Called from
+ * ep_poll_callback() with ep->lock held for reading.
+ */
+static void ep_wake_waiters(struct eventpoll *ep, bool queued)
+{
+	u32 usecs = READ_ONCE(ep->coalesce_usecs);
+	u32 max_ready = READ_ONCE(ep->coalesce_max_ready);
+
+	if (!usecs) {
+		wake_up(&ep->wq);
+		return;
+	}
+
+	if (queued && max_ready &&
+	    atomic_inc_return(&ep->coalesce_count) >= max_ready) {
+		hrtimer_try_to_cancel(&ep->coalesce_timer);
+		atomic_set(&ep->coalesce_count, 0);
+		wake_up(&ep->wq);
+		return;
+	}
+
+	if (!hrtimer_is_queued(&ep->coalesce_timer))
+		hrtimer_start(&ep->coalesce_timer, us_to_ktime(usecs),
+			      HRTIMER_MODE_REL);
+}
+
 #ifdef CONFIG_NET_RX_BUSY_POLL
 static bool ep_busy_loop_end(void *p, unsigned long start_time)
 {
@@ -774,6 +840,7 @@ static void ep_free(struct eventpoll *ep)
 	mutex_unlock(&ep->mtx);
 
 	mutex_unlock(&epmutex);
+	hrtimer_cancel(&ep->coalesce_timer);
 	mutex_destroy(&ep->mtx);
 	free_uid(ep->user);
 	wakeup_source_unregister(ep->ws);
@@ -854,6 +921,44 @@ static __poll_t ep_eventpoll_poll(struct file *file, poll_table *wait)
 	return __ep_eventpoll_poll(file, wait, 0);
 }
 
+/* longest wakeup delay EPIOCSCOALESCE accepts */
+#define EP_COALESCE_MAX_USECS	(100 * USEC_PER_MSEC)
+
+static long ep_eventpoll_ioctl(struct file *file, unsigned int cmd,
+			       unsigned long arg)
+{
+	struct eventpoll *ep = file->private_data;
+	void __user *uarg = (void __user *)arg;
+	struct epoll_coalesce coalesce;
+
+	switch (cmd) {
+	case EPIOCSCOALESCE:
+		if (copy_from_user(&coalesce, uarg, sizeof(coalesce)))
+			return -EFAULT;
+		if (coalesce.usecs > EP_COALESCE_MAX_USECS)
+			return -EINVAL;
+
+		mutex_lock(&ep->mtx);
+		WRITE_ONCE(ep->coalesce_max_ready, coalesce.max_ready);
+		WRITE_ONCE(ep->coalesce_usecs, coalesce.usecs);
+		/* don't leave a waiter behind a timer that won't fire now */
+		if (!coalesce.usecs && hrtimer_cancel(&ep->coalesce_timer))
+			ep_coalesce_wake(ep);
+		mutex_unlock(&ep->mtx);
+		return 0;
+
+	case EPIOCGCOALESCE:
+		coalesce.usecs = READ_ONCE(ep->coalesce_usecs);
+		coalesce.max_ready = READ_ONCE(ep->coalesce_max_ready);
+		if (copy_to_user(uarg, &coalesce, sizeof(coalesce)))
+			return -EFAULT;
+		return 0;
+
+	default:
+		return -ENOIOCTLCMD;
+	}
+}
+
 #ifdef CONFIG_PROC_FS
 static void ep_show_fdinfo(struct seq_file *m, struct file *f)
 {
@@ -885,6 +990,8 @@ static const struct file_operations eventpoll_fops = {
 #endif
 	.release	= ep_eventpoll_release,
 	.poll		= ep_eventpoll_poll,
+	.unlocked_ioctl	= ep_eventpoll_ioctl,
+	.compat_ioctl	= compat_ptr_ioctl,
 	.llseek		= noop_llseek,
 };
 
@@ -946,6 +1053,8 @@ static int ep_alloc(struct eventpoll **pep)
 	ep->rbr = RB_ROOT_CACHED;
 	ep->ovflist = EP_UNACTIVE_PTR;
 	ep->user = user;
+	hrtimer_init(&ep->coalesce_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	ep->coalesce_timer.function = ep_coalesce_timer;
 
 	*pep = ep;
 
@@ -1131,6 +1240,7 @@ static int ep_poll_callback(wait_queue_entry_t *wait, unsigned mode, int sync, v
 	struct eventpoll *ep = epi->ep;
 	__poll_t pollflags = key_to_poll(key);
 	unsigned long flags;
+	bool queued = false;
 	int ewake = 0;
 
 	read_lock_irqsave(&ep->lock, flags);
@@ -1162,12 +1272,16 @@ static int ep_poll_callback(wait_queue_entry_t *wait, unsigned mode, int sync, v
 	 * chained in ep->ovflist and requeued later on.
 	 */
 	if (READ_ONCE(ep->ovflist) != EP_UNACTIVE_PTR) {
-		if (chain_epi_lockless(epi))
+		if (chain_epi_lockless(epi)) {
 			ep_pm_stay_awake_rcu(epi);
+			queued = true;
+		}
 	} else if (!ep_is_linked(epi)) {
 		/* In the usual case, add event to ready list. */
-		if (list_add_tail_lockless(&epi->rdllink, &ep->rdllist))
+		if (list_add_tail_lockless(&epi->rdllink, &ep->rdllist)) {
 			ep_pm_stay_awake_rcu(epi);
+			queued = true;
+		}
 	}
 
 	/*
@@ -1191,7 +1305,7 @@ static int ep_poll_callback(wait_queue_entry_t *wait, unsigned mode, int sync, v
 				break;
 			}
 		}
-		wake_up(&ep->wq);
+		ep_wake_waiters(ep, queued);
 	}
 	if (waitqueue_active(&ep->poll_wait))
 		pwake++;
@@ -1787,7 +1901,7 @@ static int ep_poll(struct eventpoll *ep, struct epoll_event __user *events,
 	 * timeout, the user by definition should not care and will have to
 	 * recheck again.
 	 */
-	eavail = ep_events_available(ep);
+	eavail = timed_out ? ep_events_available(ep) : ep_events_ready(ep);
 
 	while (1) {
 		if (eavail) {
@@ -1839,7 +1953,7 @@ static int ep_poll(struct eventpoll *ep, struct epoll_event __user *events,
 		 * period of time although events are pending, so lock is
 		 * important.
 		 */
-		eavail = ep_events_available(ep);
+		eavail = ep_events_ready(ep);
 		if (!eavail)
 			__add_wait_queue_exclusive(&ep->wq, &wait);
 
@@ -1867,7 +1981,9 @@ static int ep_poll(struct eventpoll *ep, struct epoll_event __user *events,
 			 * events.
 			 */
 			if (timed_out)
-				eavail = list_empty(&wait.entry);
+				eavail = list_empty(&wait.entry) ||
+					 (READ_ONCE(ep->coalesce_usecs) &&
+					  ep_events_available(ep));
 			__remove_wait_queue(&ep->wq, &wait);
 			write_unlock_irq(&ep->lock);
 		}
@@ -2449,6 +2449,30 @@ static int f2fs_read_data_page(struct file *file, struct page *page)
 	return ret;
 }
 
+/*
+ * With flash_read, grow the readahead window to the end of the extent it
+ * starts in, so data that is contiguous on disk is read with as few
+ * requests as possible.
+ */
+static void f2fs_flash_expand_readahead(struct inode *inode,
+					struct readahead_control *rac)
+{
+	pgoff_t index = readahead_index(rac);
+	pgoff_t end = DIV_ROUND_UP(i_size_read(inode), PAGE_SIZE);
+	struct extent_info ei;
+
+	if (f2fs_compressed_file(inode) ||
+	    !f2fs_lookup_extent_cache(inode, index, &ei))
+		return;
+
+	end = min3(end, (pgoff_t)ei.fofs + ei.len, index + MAX_FLASH_RA_PAGES);
+	if (end <= index + readahead_count(rac))
+		return;
+
+	readahead_expand(rac, readahead_pos(rac),
+			 (size_t)(end - index) << PAGE_SHIFT);
+}
+
 static void f2fs_readahead(struct readahead_control *rac)
 {
 	struct inode *inode = rac->mapping->host;
@@ -2462,6 +2486,9 @@ static void f2fs_readahead(struct readahead_control *rac)
 	if (f2fs_has_inline_data(inode))
 		return;
 
+	if (test_opt(F2FS_I_SB(inode), FLASH_READ))
+		f2fs_flash_expand_readahead(inode, rac);
+
 	f2fs_mpage_readpages(inode, rac, NULL);
 }
 
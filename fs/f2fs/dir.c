@@ -1085,8 +1085,17 @@ static int f2fs_readdir(struct file *file, struct dir_context *ctx)
 	unsigned int n = ((unsigned long)ctx->pos / NR_DENTRY_IN_BLOCK);
 	struct f2fs_dentry_ptr d;
 	struct fscrypt_str fstr = FSTR_INIT(NULL, 0);
+	pgoff_t ra_dir_pages = MAX_DIR_RA_PAGES;
 	int err = 0;
 
+	/*
+	 * On SD and USB flash a large request costs little more than a
+	 * small one, so read the dentry blocks, and with readdir_ra the
+	 * inodes they point to, in bigger batches.
+	 */
+	if (test_opt(F2FS_I_SB(inode), FLASH_READ))
+		ra_dir_pages = MAX_FLASH_DIR_RA_PAGES;
+
 	if (IS_ENCRYPTED(inode)) {
 		err = fscrypt_prepare_readdir(inode);
 		if (err)
@@ -1114,7 +1123,7 @@ static int f2fs_readdir(struct file *file, struct dir_context *ctx)
 		/* readahead for multi pages of dir */
 		if (npages - n > 1 && !ra_has_index(ra, n))
 			page_cache_sync_readahead(inode->i_mapping, ra, file, n,
-				min(npages - n, (pgoff_t)MAX_DIR_RA_PAGES));
+				min(npages - n, ra_dir_pages));
 
 		dentry_page = f2fs_find_data_page(inode, n);
 		if (IS_ERR(dentry_page)) {
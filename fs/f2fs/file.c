@@ -548,6 +548,18 @@ static int f2fs_file_open(struct inode *inode, struct file *filp)
 
 	filp->f_mode |= FMODE_NOWAIT;
 
+	/*
+	 * With flash_read, map the whole of a file opened read-only into
+	 * the extent cache up front, rather than reading its dnodes one by
+	 * one as the data is read.
+	 */
+	if (test_opt(F2FS_I_SB(inode), FLASH_READ) &&
+	    !(filp->f_mode & FMODE_WRITE) && S_ISREG(inode->i_mode) &&
+	    !is_inode_flag_set(inode, FI_EXTENT_PRECACHED)) {
+		set_inode_flag(inode, FI_EXTENT_PRECACHED);
+		f2fs_precache_extents(inode);
+	}
+
 	return dquot_file_open(inode, filp);
 }
 
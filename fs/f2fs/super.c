@@ -158,6 +158,8 @@ enum {
 	Opt_gc_merge,
 	Opt_nogc_merge,
 	Opt_discard_unit,
+	Opt_flash_read,
+	Opt_noflash_read,
 	Opt_err,
 };
 
@@ -235,6 +237,8 @@ static match_table_t f2fs_tokens = {
 	{Opt_gc_merge, "gc_merge"},
 	{Opt_nogc_merge, "nogc_merge"},
 	{Opt_discard_unit, "discard_unit=%s"},
+	{Opt_flash_read, "flash_read"},
+	{Opt_noflash_read, "noflash_read"},
 	{Opt_err, NULL},
 };
 
@@ -1181,6 +1185,12 @@ static int parse_options(struct super_block *sb, char *options, bool is_remount)
 		case Opt_nogc_merge:
 			clear_opt(sbi, GC_MERGE);
 			break;
+		case Opt_flash_read:
+			set_opt(sbi, FLASH_READ);
+			break;
+		case Opt_noflash_read:
+			clear_opt(sbi, FLASH_READ);
+			break;
 		case Opt_discard_unit:
 			name = match_strdup(&args[0]);
 			if (!name)
@@ -1836,6 +1846,8 @@ static int f2fs_show_options(struct seq_file *seq, struct dentry *root)
 
 	if (test_opt(sbi, GC_MERGE))
 		seq_puts(seq, ",gc_merge");
+	if (test_opt(sbi, FLASH_READ))
+		seq_puts(seq, ",flash_read");
 
 	if (test_opt(sbi, DISABLE_ROLL_FORWARD))
 		seq_puts(seq, ",disable_roll_forward");
@@ -984,6 +984,61 @@ static int fuse_copy_pages(struct fuse_copy_state *cs, unsigned nbytes,
 	return 0;
 }
 
+/*
+ * Take the last reply argument as pipe buffers for args->out_pipe. The
+ * buffers of a spliced reply are shared with the server's pipe, data
+ * written with write() is copied into new pages. What does not fit in
+ * ap->bufs is dropped, the caller then returns a short read.
+ */
+static int fuse_copy_pipe(struct fuse_copy_state *cs, unsigned nbytes)
+{
+	struct fuse_req *req = cs->req;
+	struct fuse_args_pages *ap = container_of(req->args, typeof(*ap), args);
+	struct pipe_buffer *buf;
+	struct page *page = NULL;
+	unsigned count;
+	int err;
+
+	while (nbytes) {
+		if (ap->num_bufs == ap->max_bufs)
+			return fuse_copy_page(cs, &page, 0, nbytes, 0);
+
+		buf = &ap->bufs[ap->num_bufs];
+		if (cs->pipebufs) {
+			if (!cs->len) {
+				err = fuse_copy_fill(cs);
+				if (err)
+					return err;
+			}
+			*buf = *cs->currbuf;
+			if (!pipe_buf_get(cs->pipe, buf))
+				return -EFAULT;
+			ap->num_bufs++;
+
+			buf->flags &= ~(PIPE_BUF_FLAG_GIFT | PIPE_BUF_FLAG_CAN_MERGE);
+			buf->offset = cs->offset;
+			buf->len = fuse_copy_do(cs, NULL, &nbytes);
+		} else {
+			count = min_t(unsigned, nbytes, PAGE_SIZE);
+			buf->page = alloc_page(GFP_HIGHUSER);
+			if (!buf->page)
+				return -ENOMEM;
+			/* see fuse_dev_splice_read() */
+			buf->ops = &nosteal_pipe_buf_ops;
+			buf->flags = 0;
+			buf->offset = 0;
+			buf->len = count;
+			ap->num_bufs++;
+
+			err = fuse_copy_page(cs, &buf->page, 0, count, 0);
+			if (err)
+				return err;
+			nbytes -= count;
+		}
+	}
+	return 0;
+}
+
 /* Copy a single argument in the request to/from userspace buffer */
 static int fuse_copy_one(struct fuse_copy_state *cs, void *val, unsigned size)
 {
@@ -1825,6 +1880,15 @@ static int copy_out_args(struct fuse_copy_state *cs, struct fuse_args *args,
 			return -EINVAL;
 		lastarg->size -= diffsize;
 	}
+	if (args->out_pipe) {
+		unsigned numargs = args->out_numargs - 1;
+		int err;
+
+		err = fuse_copy_args(cs, numargs, 0, args->out_args, 0);
+		if (err)
+			return err;
+		return fuse_copy_pipe(cs, args->out_args[numargs].size);
+	}
 	return fuse_copy_args(cs, args->out_numargs, args->out_pages,
 			      args->out_args, args->page_zeroing);
 }
@@ -18,6 +18,7 @@
 #include <linux/falloc.h>
 #include <linux/uio.h>
 #include <linux/fs.h>
+#include <linux/splice.h>
 
 static int fuse_send_open(struct fuse_mount *fm, u64 nodeid,
 			  unsigned int open_flags, int opcode,
@@ -1589,6 +1590,78 @@ static ssize_t fuse_file_read_iter(struct kiocb *iocb, struct iov_iter *to)
 		return fuse_direct_read_iter(iocb, to);
 }
 
+/*
+ * Splice from a FOPEN_DIRECT_IO file without the page cache: the reply
+ * to the FUSE_READ is queued on @pipe as the pipe buffers the server
+ * spliced it from, so the data is not copied at all on the way from
+ * the server to the pipe reader. Only as much is read as fits in @pipe.
+ */
+static ssize_t fuse_direct_splice_read(struct file *in, loff_t *ppos,
+				       struct pipe_inode_info *pipe,
+				       size_t len, unsigned int flags)
+{
+	struct fuse_file *ff = in->private_data;
+	struct fuse_conn *fc = ff->fm->fc;
+	struct fuse_io_args ia = {};
+	struct fuse_args_pages *ap = &ia.ap;
+	unsigned int i = 0, slots;
+	ssize_t ret, total = 0;
+
+	slots = pipe->max_usage - pipe_occupancy(pipe->head, pipe->tail);
+	if (!slots)
+		return 0;
+
+	len = min_t(size_t, len, (size_t)slots << PAGE_SHIFT);
+	len = min_t(size_t, len, fc->max_read);
+
+	ap->bufs = kvmalloc_array(slots, sizeof(*ap->bufs), GFP_KERNEL);
+	if (!ap->bufs)
+		return -ENOMEM;
+	ap->max_bufs = slots;
+
+	fuse_read_args_fill(&ia, in, *ppos, len, FUSE_READ);
+	ap->args.out_pipe = true;
+	ret = fuse_simple_request(ff->fm, &ap->args);
+	if (ret < 0)
+		goto out;
+
+	while (i < ap->num_bufs) {
+		ret = add_to_pipe(pipe, &ap->bufs[i++]);
+		if (ret < 0)
+			break;
+		total += ret;
+	}
+	if (total) {
+		*ppos += total;
+		ret = total;
+	}
+out:
+	for (; i < ap->num_bufs; i++)
+		pipe_buf_release(pipe, &ap->bufs[i]);
+	kvfree(ap->bufs);
+
+	fuse_invalidate_atime(file_inode(in));
+	return ret;
+}
+
+static ssize_t fuse_file_splice_read(struct file *in, loff_t *ppos,
+				     struct pipe_inode_info *pipe,
+				     size_t len, unsigned int flags)
+{
+	struct fuse_file *ff = in->private_data;
+	struct inode *inode = file_inode(in);
+
+	if (fuse_is_bad(inode))
+		return -EIO;
+
+	/* out_pipe replies are only handled by the /dev/fuse transport */
+	if (!FUSE_IS_DAX(inode) && (ff->open_flags & FOPEN_DIRECT_IO) &&
+	    ff->fm->fc->iq.ops == &fuse_dev_fiq_ops)
+		return fuse_direct_splice_read(in, ppos, pipe, len, flags);
+
+	return generic_file_splice_read(in, ppos, pipe, len, flags);
+}
+
 static ssize_t fuse_file_write_iter(struct kiocb *iocb, struct iov_iter *from)
 {
 	struct file *file = iocb->ki_filp;
@@ -3141,7 +3214,7 @@ static const struct file_operations fuse_file_operations = {
 	.lock		= fuse_file_lock,
 	.get_unmapped_area = thp_get_unmapped_area,
 	.flock		= fuse_file_flock,
-	.splice_read	= generic_file_splice_read,
+	.splice_read	= fuse_file_splice_read,
 	.splice_write	= iter_file_splice_write,
 	.unlocked_ioctl	= fuse_file_ioctl,
 	.compat_ioctl	= fuse_file_compat_ioctl,
@@ -260,6 +260,7 @@ struct fuse_args {
 	bool page_zeroing:1;
 	bool page_replace:1;
 	bool may_block:1;
+	bool out_pipe:1;
 	struct fuse_in_arg in_args[3];
 	struct fuse_arg out_args[2];
 	void (*end)(struct fuse_mount *fm, struct fuse_args *args, int error);
@@ -270,6 +271,11 @@ struct fuse_args_pages {
 	struct page **pages;
 	struct fuse_page_desc *descs;
 	unsigned int num_pages;
+
+	/* Reply data as pipe buffers, for args.out_pipe */
+	struct pipe_buffer *bufs;
+	unsigned int num_bufs;
+	unsigned int max_bufs;
 };
 
 #define FUSE_ARGS(args) struct fuse_args args = {}
@@ -1066,6 +1066,11 @@ static const struct io_op_def io_op_defs[] = {
 	[IORING_OP_MKDIRAT] = {},
 	[IORING_OP_SYMLINKAT] = {},
 	[IORING_OP_LINKAT] = {},
+	[IORING_OP_READ_MULTISHOT] = {
+		.needs_file		= 1,
+		.unbound_nonreg_file	= 1,
+		.buffer_select		= 1,
+	},
 };
 
 /* requests with any of those set should undergo io_disarm_next() */
@@ -5297,17 +5302,23 @@ static bool io_poll_rewait(struct io_kiocb *req, struct io_poll_iocb *poll)
 	return false;
 }
 
+static bool io_poll_is_pure(struct io_kiocb *req)
+{
+	return req->opcode == IORING_OP_POLL_ADD ||
+	       req->opcode == IORING_OP_READ_MULTISHOT;
+}
+
 static struct io_poll_iocb *io_poll_get_double(struct io_kiocb *req)
 {
 	/* pure poll stashes this in ->async_data, poll driven retry elsewhere */
-	if (req->opcode == IORING_OP_POLL_ADD)
+	if (io_poll_is_pure(req))
 		return req->async_data;
 	return req->apoll->double_poll;
 }
 
 static struct io_poll_iocb *io_poll_get_single(struct io_kiocb *req)
 {
-	if (req->opcode == IORING_OP_POLL_ADD)
+	if (io_poll_is_pure(req))
 		return &req->poll;
 	return &req->apoll->poll;
 }
@@ -5864,6 +5875,207 @@ static int io_poll_add(struct io_kiocb *req, unsigned int issue_flags)
 	return ipt.error;
 }
 
+/* reads done per wakeup before going back to the wait queue */
+#define IO_READ_MULTISHOT_BATCH	16
+
+static void io_read_multishot_task_func(struct io_kiocb *req, bool *locked);
+
+static int io_read_multishot_wake(struct wait_queue_entry *wait, unsigned mode,
+				  int sync, void *key)
+{
+	struct io_kiocb *req = wait->private;
+
+	return __io_async_wake(req, &req->poll, key_to_poll(key),
+			       io_read_multishot_task_func);
+}
+
+/* queue the reads if the file became readable after we last looked */
+static void io_read_multishot_kick(struct io_kiocb *req, __poll_t mask)
+{
+	struct io_poll_iocb *poll = &req->poll;
+
+	if (!(mask & poll->events))
+		return;
+
+	spin_lock_irq(&poll->head->lock);
+	if (!list_empty(&poll->wait.entry))
+		__io_async_wake(req, poll, mask, io_read_multishot_task_func);
+	spin_unlock_irq(&poll->head->lock);
+}
+
+/* give back a provided buffer the read did not fill */
+static void io_kbuf_recycle(struct io_kiocb *req, struct io_buffer *kbuf,
+			    bool needs_lock)
+{
+	struct io_ring_ctx *ctx = req->ctx;
+	struct io_buffer *head;
+
+	io_ring_submit_lock(ctx, needs_lock);
+	head = xa_load(&ctx->io_buffers, req->buf_index);
+	if (head) {
+		list_add_tail(&kbuf->list, &head->list);
+	} else {
+		INIT_LIST_HEAD(&kbuf->list);
+		if (xa_insert(&ctx->io_buffers, req->buf_index, kbuf,
+			      GFP_KERNEL))
+			kfree(kbuf);
+	}
+	io_ring_submit_unlock(ctx, needs_lock);
+}
+
+static int io_read_multishot_one(struct io_kiocb *req, bool needs_lock,
+				 unsigned int *cflags)
+{
+	struct io_buffer *kbuf;
+	size_t len = MAX_RW_COUNT;
+	struct iov_iter iter;
+	struct kiocb kiocb;
+	struct iovec iov;
+	int ret;
+
+	kbuf = io_buffer_select(req, &len, req->buf_index, NULL, needs_lock);
+	if (IS_ERR(kbuf))
+		return PTR_ERR(kbuf);
+
+	ret = import_single_range(READ, u64_to_user_ptr(kbuf->addr), len,
+				  &iov, &iter);
+	if (!ret) {
+		init_sync_kiocb(&kiocb, req->file);
+		kiocb.ki_flags |= IOCB_NOWAIT;
+		ret = call_read_iter(req->file, &kiocb, &iter);
+	}
+
+	if (ret <= 0)
+		io_kbuf_recycle(req, kbuf, needs_lock);
+	else
+		*cflags = io_put_kbuf(req, kbuf);
+	return ret;
+}
+
+/*
+ * Runs from task work once the file signalled readability: read into
+ * provided buffers, one CQE each, until the file runs dry. A read error,
+ * running out of buffers, a CQE that could not be posted (-EOVERFLOW) or
+ * cancellation posts the final CQE with the error and without
+ * IORING_CQE_F_MORE. End of file does the same with a result of 0.
+ */
+static void io_read_multishot_task_func(struct io_kiocb *req, bool *locked)
+{
+	struct io_ring_ctx *ctx = req->ctx;
+	struct io_poll_iocb *poll = &req->poll;
+	struct io_kiocb *nxt;
+	unsigned int cflags;
+	bool done = false;
+	int i, ret = 0;
+
+	if (io_poll_rewait(req, poll)) {
+		spin_unlock(&ctx->completion_lock);
+		return;
+	}
+	if (poll->done) {
+		spin_unlock(&ctx->completion_lock);
+		return;
+	}
+	spin_unlock(&ctx->completion_lock);
+
+	for (i = 0; i < IO_READ_MULTISHOT_BATCH; i++) {
+		if (READ_ONCE(poll->canceled)) {
+			ret = -ECANCELED;
+			done = true;
+			break;
+		}
+
+		cflags = 0;
+		ret = io_read_multishot_one(req, !*locked, &cflags);
+		if (ret == -EAGAIN)
+			break;
+
+		spin_lock(&ctx->completion_lock);
+		if (ret <= 0) {
+			done = true;
+		} else if (io_cqring_fill_event(ctx, req->user_data, ret,
+						cflags | IORING_CQE_F_MORE)) {
+			ctx->cq_extra++;
+		} else {
+			/* the data is lost, stop before losing more */
+			ret = -EOVERFLOW;
+			done = true;
+		}
+		spin_unlock(&ctx->completion_lock);
+		if (done)
+			break;
+	}
+
+	spin_lock(&ctx->completion_lock);
+	if (!done && READ_ONCE(poll->canceled)) {
+		ret = -ECANCELED;
+		done = true;
+	}
+	if (done) {
+		io_cqring_fill_event(ctx, req->user_data, ret, 0);
+		if (ret < 0)
+			req_set_fail(req);
+		io_poll_remove_double(req);
+		hash_del(&req->hash_node);
+		poll->done = true;
+	} else {
+		req->result = 0;
+		add_wait_queue(poll->head, &poll->wait);
+	}
+	io_commit_cqring(ctx);
+	spin_unlock(&ctx->completion_lock);
+	io_cqring_ev_posted(ctx);
+
+	if (!done) {
+		io_read_multishot_kick(req, vfs_poll(req->file, NULL));
+		return;
+	}
+
+	nxt = io_put_req_find_next(req);
+	if (nxt)
+		io_req_task_submit(nxt, locked);
+}
+
+static int io_read_multishot_prep(struct io_kiocb *req,
+				  const struct io_uring_sqe *sqe)
+{
+	struct file *file = req->file;
+
+	if (unlikely(req->ctx->flags & IORING_SETUP_IOPOLL))
+		return -EINVAL;
+	if (!(req->flags & REQ_F_BUFFER_SELECT))
+		return -EINVAL;
+	if (sqe->ioprio || sqe->off || sqe->addr || sqe->len || sqe->rw_flags)
+		return -EINVAL;
+	/* only files that poll and can be read without blocking */
+	if (!(file->f_mode & FMODE_NOWAIT) || !file->f_op->read_iter ||
+	    !file_can_poll(file))
+		return -EOPNOTSUPP;
+
+	req->buf_index = READ_ONCE(sqe->buf_group);
+	io_req_set_refcount(req);
+	req->poll.events = EPOLLIN | EPOLLRDNORM;
+	return 0;
+}
+
+static int io_read_multishot(struct io_kiocb *req, unsigned int issue_flags)
+{
+	struct io_ring_ctx *ctx = req->ctx;
+	struct io_poll_table ipt;
+	__poll_t mask;
+
+	ipt.pt._qproc = io_poll_queue_proc;
+
+	mask = __io_arm_poll_handler(req, &req->poll, &ipt, req->poll.events,
+				     io_read_multishot_wake);
+	/* already readable, do the reads from task work like any wakeup */
+	if (mask && !ipt.error && req->poll.head)
+		io_read_multishot_kick(req, mask);
+	spin_unlock(&ctx->completion_lock);
+
+	return ipt.error;
+}
+
 static int io_poll_update(struct io_kiocb *req, unsigned int issue_flags)
 {
 	struct io_ring_ctx *ctx = req->ctx;
@@ -6381,6 +6593,8 @@ static int io_req_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 		return io_write_prep(req, sqe);
 	case IORING_OP_POLL_ADD:
 		return io_poll_add_prep(req, sqe);
+	case IORING_OP_READ_MULTISHOT:
+		return io_read_multishot_prep(req, sqe);
 	case IORING_OP_POLL_REMOVE:
 		return io_poll_update_prep(req, sqe);
 	case IORING_OP_FSYNC:
@@ -6669,6 +6883,9 @@ static int io_issue_sqe(struct io_kiocb *req, unsigned int issue_flags)
 	case IORING_OP_POLL_ADD:
 		ret = io_poll_add(req, issue_flags);
 		break;
+	case IORING_OP_READ_MULTISHOT:
+		ret = io_read_multishot(req, issue_flags);
+		break;
 	case IORING_OP_POLL_REMOVE:
 		ret = io_poll_update(req, issue_flags);
 		break;
@@ -860,6 +860,8 @@ static int do_dentry_open(struct file *f,
 			truncate_pagecache(inode, 0);
 	}
 
+	file_ra_replay(f);
+
 	return 0;
 
 cleanup_all:
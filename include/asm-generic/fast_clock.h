@@ -0,0 +1,23 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef __ASM_GENERIC_FAST_CLOCK_H
+#define __ASM_GENERIC_FAST_CLOCK_H
+
+#include <linux/ktime.h>
+#include <linux/timekeeping.h>
+
+static inline u64 fast_clock_now(void)
+{
+	return ktime_get_ns();
+}
+
+static inline u64 fast_clock_to_ns(u64 delta)
+{
+	return delta;
+}
+
+static inline ktime_t fast_clock_to_ktime(u64 stamp)
+{
+	return ns_to_ktime(stamp);
+}
+
+#endif /* __ASM_GENERIC_FAST_CLOCK_H */
@@ -0,0 +1,62 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _BPF_HID_H
+#define _BPF_HID_H
+
+#include <linux/hid.h>
+#include <linux/rcupdate.h>
+#include <uapi/linux/bpf.h>
+
+/* Kernel side of struct bpf_hid_report */
+struct bpf_hid_report_kern {
+	struct hid_device *hdev;
+	void *data;
+	void *data_end;
+	u32 type;
+};
+
+#ifdef CONFIG_HID_BPF
+int hid_prog_attach(const union bpf_attr *attr, struct bpf_prog *prog);
+int hid_prog_detach(const union bpf_attr *attr);
+int hid_prog_query(const union bpf_attr *attr, union bpf_attr __user *uattr);
+
+bool __hid_bpf_run_report(struct hid_device *hdev, int type, u8 *data,
+			  u32 size);
+void hid_bpf_free(struct hid_device *hdev);
+
+/* Returns false if an attached program dropped the report. */
+static inline bool hid_bpf_run_report(struct hid_device *hdev, int type,
+				      u8 *data, u32 size)
+{
+	if (!rcu_access_pointer(hdev->bpf_progs))
+		return true;
+
+	return __hid_bpf_run_report(hdev, type, data, size);
+}
+#else
+static inline int hid_prog_attach(const union bpf_attr *attr,
+				  struct bpf_prog *prog)
+{
+	return -EINVAL;
+}
+
+static inline int hid_prog_detach(const union bpf_attr *attr)
+{
+	return -EINVAL;
+}
+
+static inline int hid_prog_query(const union bpf_attr *attr,
+				 union bpf_attr __user *uattr)
+{
+	return -EINVAL;
+}
+
+static inline bool hid_bpf_run_report(struct hid_device *hdev, int type,
+				      u8 *data, u32 size)
+{
+	return true;
+}
+
+static inline void hid_bpf_free(struct hid_device *hdev) { }
+#endif
+
+#endif /* _BPF_HID_H */
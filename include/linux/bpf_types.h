@@ -61,6 +61,10 @@ BPF_PROG_TYPE(BPF_PROG_TYPE_CGROUP_SOCKOPT, cg_sockopt,
 BPF_PROG_TYPE(BPF_PROG_TYPE_LIRC_MODE2, lirc_mode2,
 	      __u32, u32)
 #endif
+#ifdef CONFIG_HID_BPF
+BPF_PROG_TYPE(BPF_PROG_TYPE_HID_REPORT, hid_report,
+	      struct bpf_hid_report, struct bpf_hid_report_kern)
+#endif
 #ifdef CONFIG_INET
 BPF_PROG_TYPE(BPF_PROG_TYPE_SK_REUSEPORT, sk_reuseport,
 	      struct sk_reuseport_md, struct sk_reuseport_kern)
@@ -0,0 +1,28 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _LINUX_FAST_CLOCK_H
+#define _LINUX_FAST_CLOCK_H
+
+/*
+ * A cheap monotonic clock for code that only needs time differences,
+ * such as per packet latency accounting and activity windows.
+ *
+ *   fast_clock_now()		raw counter, in arch specific units
+ *   fast_clock_to_ns(delta)	difference of two raw values in ns
+ *   fast_clock_ns()		nanoseconds from an arbitrary epoch
+ *   fast_clock_to_ktime(stamp)	CLOCK_MONOTONIC time of a raw value
+ *
+ * The counter is not adjusted by NTP and may not advance in suspend, so
+ * raw values and fast_clock_ns() must not be mixed with the timekeeping
+ * clocks. Convert with fast_clock_to_ktime() where a stamp is stored or
+ * exported, which costs one ktime_get().
+ *
+ * Without a cheaper counter the raw values are ktime_get_ns().
+ */
+#include <asm/fast_clock.h>
+
+static inline u64 fast_clock_ns(void)
+{
+	return fast_clock_to_ns(fast_clock_now());
+}
+
+#endif /* _LINUX_FAST_CLOCK_H */
@@ -476,6 +476,10 @@ struct address_space {
 	spinlock_t		private_lock;
 	struct list_head	private_list;
 	void			*private_data;
+#ifdef CONFIG_READAHEAD_REPLAY
+	/* recorded page cache misses, see mm/readahead_replay.c */
+	struct ra_replay	*ra_replay;
+#endif
 } __attribute__((aligned(sizeof(long)))) __randomize_layout;
 	/*
 	 * On most architectures that alignment is already the case; but
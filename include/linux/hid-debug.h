@@ -9,12 +9,15 @@
 /*
  */
 
+#include <uapi/linux/hid-debug.h>
+
 #ifdef CONFIG_DEBUG_FS
 
 #include <linux/kfifo.h>
 
 #define HID_DEBUG_BUFSIZE 512
-#define HID_DEBUG_FIFOSIZE 512
+#define HID_DEBUG_FIFOSIZE 16384
+#define HID_DEBUG_TEXTSIZE (3 * HID_DEBUG_PAYLOAD_MAX + 64)
 
 void hid_dump_input(struct hid_device *, struct hid_usage *, __s32);
 void hid_dump_report(struct hid_device *, int , u8 *, int);
@@ -26,6 +29,14 @@ void hid_debug_unregister(struct hid_device *);
 void hid_debug_init(void);
 void hid_debug_exit(void);
 void hid_debug_event(struct hid_device *, char *);
+void hid_output_latency_show(struct seq_file *);
+void hid_rdesc_cache_show(struct seq_file *);
+
+/*
+ * The events are queued as struct hid_debug_record, followed by its
+ * payload, and only formatted when read. The events_raw file returns
+ * them unformatted.
+ */
 
 struct hid_debug_list {
 	DECLARE_KFIFO_PTR(hid_debug_fifo, char);
@@ -33,6 +44,12 @@ struct hid_debug_list {
 	struct hid_device *hdev;
 	struct list_head node;
 	struct mutex read_mutex;
+
+	/* the formatted record being read, text mode only */
+	char *text;
+	unsigned int text_len;
+	unsigned int text_pos;
+	u8 *payload;
 };
 
 #else
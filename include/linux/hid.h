@@ -24,6 +24,8 @@
 #include <linux/input.h>
 #include <linux/semaphore.h>
 #include <linux/mutex.h>
+#include <linux/rcupdate.h>
+#include <linux/ratelimit.h>
 #include <linux/power_supply.h>
 #include <uapi/linux/hid.h>
 
@@ -354,6 +356,8 @@ struct hid_item {
 #define HID_QUIRK_NO_OUTPUT_REPORTS_ON_INTR_EP	BIT(18)
 #define HID_QUIRK_HAVE_SPECIAL_DRIVER		BIT(19)
 #define HID_QUIRK_INCREMENT_USAGE_ON_DUPLICATE	BIT(20)
+#define HID_QUIRK_MULTI_IN_URBS			BIT(21)
+#define HID_QUIRK_COALESCE_OUTPUT		BIT(22)
 #define HID_QUIRK_FULLSPEED_INTERVAL		BIT(28)
 #define HID_QUIRK_NO_INIT_REPORTS		BIT(29)
 #define HID_QUIRK_NO_IGNORE			BIT(30)
@@ -464,6 +468,10 @@ struct hid_field {
 	unsigned  report_count;		/* number of this field in the report */
 	unsigned  report_type;		/* (input,output,feature) */
 	__s32    *value;		/* last known value(s) */
+	__s32    *new_value;		/* scratch for the value(s) being parsed */
+	unsigned  extract;		/* how to extract the value(s), see hid-core.c */
+	unsigned long *usage_bits;	/* scratch bitmaps of the usages set in */
+	unsigned long *new_usage_bits;	/* value and new_value, for array fields */
 	__s32     logical_minimum;
 	__s32     logical_maximum;
 	__s32     physical_minimum;
@@ -508,6 +516,7 @@ struct hid_control_fifo {
 	unsigned char dir;
 	struct hid_report *report;
 	char *raw_report;
+	struct hid_raw_request *req;	/* instead of @report, see usbhid */
 };
 
 struct hid_output_fifo {
@@ -525,6 +534,10 @@ struct hid_output_fifo {
 #define HID_STAT_DUP_DETECTED	BIT(2)
 #define HID_STAT_REPROBED	BIT(3)
 
+/* Special values of hid_device.steer_cpu, see hid_input_report() */
+#define HID_STEER_OFF		-1
+#define HID_STEER_READER	-2
+
 struct hid_input {
 	struct list_head list;
 	struct hid_report *report;
@@ -547,8 +560,51 @@ enum hid_battery_status {
 	HID_BATTERY_REPORTED,		/* Device sent unsolicited battery strength report */
 };
 
+/*
+ * Output work (LEDs, rumble, queued output reports) run from hid_output_wq,
+ * an unbound high-priority workqueue shared by all HID drivers. The time
+ * from queueing to running is accounted and shown in debugfs.
+ */
+struct hid_output_work {
+	struct work_struct work;
+	work_func_t func;
+	u64 queued;				/* fast_clock_now() when queued */
+};
+
+extern struct workqueue_struct *hid_output_wq;
+
+/**
+ * struct hid_raw_request - asynchronous raw report request
+ * @reportnum: report id
+ * @buf: report data, byte 0 being the report id as with
+ *	 hid_hw_raw_request(); owned by the transport until @complete
+ * @len: size of @buf
+ * @rtype: HID_FEATURE_REPORT, HID_OUTPUT_REPORT or HID_INPUT_REPORT
+ * @reqtype: HID_REQ_GET_REPORT or HID_REQ_SET_REPORT
+ * @complete: called once with the number of bytes transferred or a
+ *	      negative error code, possibly in interrupt context
+ * @context: for the caller
+ */
+struct hid_raw_request {
+	unsigned char reportnum;
+	u8 *buf;
+	size_t len;
+	unsigned char rtype;
+	int reqtype;
+	void (*complete)(struct hid_raw_request *req, int ret);
+	void *context;
+
+	/* private: for HID core and the transport driver */
+	struct hid_device *hdev;
+	struct hid_output_work work;
+	struct list_head entry;
+	u32 id;
+};
+
 struct hid_driver;
 struct hid_ll_driver;
+struct bpf_prog_array;
+struct hid_keymap;
 
 struct hid_device {							/* device report descriptor */
 	__u8 *dev_rdesc;
@@ -567,11 +623,12 @@ struct hid_device {							/* device report descriptor */
 	enum hid_type type;						/* device type (mouse, kbd, ...) */
 	unsigned country;						/* HID country */
 	struct hid_report_enum report_enum[HID_REPORT_TYPES];
-	struct work_struct led_work;					/* delayed LED worker */
+	struct hid_output_work led_work;				/* delayed LED worker */
 
-	struct semaphore driver_input_lock;				/* protects the current driver */
+	struct semaphore driver_input_lock;				/* serializes probe, remove and debugfs */
 	struct device dev;						/* device */
 	struct hid_driver *driver;
+	struct hid_driver __rcu *input_driver;				/* driver input is delivered to */
 
 	struct hid_ll_driver *ll_driver;
 	struct mutex ll_open_lock;
@@ -592,16 +649,40 @@ struct hid_device {							/* device report descriptor */
 	enum hid_battery_status battery_status;
 	bool battery_avoid_query;
 	ktime_t battery_ratelimit_time;
+	/*
+	 * Capacity changes smaller than battery_min_delta, or closer than
+	 * battery_min_interval ms to the last notification, are only
+	 * reported with the periodic refresh. Drivers may override the
+	 * module defaults once the inputs are configured.
+	 */
+	__s32 battery_min_delta;
+	unsigned int battery_min_interval;
+	ktime_t battery_change_time;
 #endif
 
 	unsigned long status;						/* see STAT flags above */
 	unsigned claimed;						/* Claimed by hidinput, hiddev? */
 	unsigned quirks;						/* Various quirks the device can pull on us */
 	bool io_started;						/* If IO has started */
+	unsigned int input_seq;						/* Sequence of the last input report, for tracing */
+	ktime_t input_time;						/* Sample time of the current input report, or 0 */
+	unsigned long input_busy;					/* Bit 0 set while a report is processed */
+	int steer_cpu;							/* CPU to process input reports on, or HID_STEER_* */
+	int steer_queued_cpu;						/* CPU the reports in flight were queued to */
+	atomic_t steer_inflight;					/* Reports queued and not processed yet */
+	atomic_t log_dropped;						/* Messages suppressed by hid_*_ratelimited() */
+	unsigned long output_jiffies;					/* Time of the last output or SET_REPORT */
+	u8 *request_buf;						/* Reused by __hid_request() */
+	u32 request_buf_size;
+	unsigned long request_buf_busy;
 
 	struct list_head inputs;					/* The list of inputs */
+	struct hid_keymap *keymap;					/* Keycode lookup, see hid-input.c */
 	void *hiddev;							/* The hiddev structure */
 	void *hidraw;
+#ifdef CONFIG_HID_BPF
+	struct bpf_prog_array __rcu *bpf_progs;				/* Report filters, see hid-bpf.c */
+#endif
 
 	char name[128];							/* Device name */
 	char phys[64];							/* Device physical location */
@@ -624,6 +705,7 @@ struct hid_device {							/* device report descriptor */
 	struct dentry *debug_dir;
 	struct dentry *debug_rdesc;
 	struct dentry *debug_events;
+	struct dentry *debug_events_raw;
 	struct list_head debug_list;
 	spinlock_t  debug_list_lock;
 	wait_queue_head_t debug_wait;
@@ -730,7 +812,10 @@ struct hid_usage_id {
  * called.
  *
  * raw_event and event should return negative on error, any other value will
- * pass the event on to .event() typically return 0 for success.
+ * pass the event on to .event() typically return 0 for success. raw_event may
+ * also return HID_RAW_EVENT_CONSUMED when it fully decoded the report itself:
+ * the report is then only passed on to hidraw, and the generic per-field
+ * parsing, hiddev and hid-input are skipped.
  *
  * input_mapping shall return a negative value to completely ignore this usage
  * (e.g. doubled or invalid usage), zero to continue with parsing of this
@@ -742,6 +827,8 @@ struct hid_usage_id {
  * Both these functions may be NULL which means the same behavior as returning
  * zero from them.
  */
+#define HID_RAW_EVENT_CONSUMED	2
+
 struct hid_driver {
 	char *name;
 	const struct hid_device_id *id_table;
@@ -799,6 +886,9 @@ struct hid_driver {
  * @request: send report request to device (e.g. feature report)
  * @wait: wait for buffered io to complete (send/recv reports)
  * @raw_request: send raw report request to device (e.g. feature report)
+ * @raw_request_async: queue a raw report request, returns 0 if
+ *	&hid_raw_request.complete will be called; optional, HID core runs
+ *	@raw_request from a workqueue instead
  * @output_report: send output report to device
  * @idle: send idle request to device
  * @may_wakeup: return if device may act as a wakeup source during system-suspend
@@ -822,6 +912,8 @@ struct hid_ll_driver {
 	int (*raw_request) (struct hid_device *hdev, unsigned char reportnum,
 			    __u8 *buf, size_t len, unsigned char rtype,
 			    int reqtype);
+	int (*raw_request_async)(struct hid_device *hdev,
+				 struct hid_raw_request *req);
 
 	int (*output_report) (struct hid_device *hdev, __u8 *buf, size_t len);
 
@@ -889,6 +981,8 @@ extern void hidinput_disconnect(struct hid_device *);
 
 int hid_set_field(struct hid_field *, unsigned, __s32);
 int hid_input_report(struct hid_device *, int type, u8 *, u32, int);
+int hid_input_report_time(struct hid_device *hid, int type, u8 *data, u32 size,
+			  int interrupt, ktime_t time);
 int hidinput_find_field(struct hid_device *hid, unsigned int type, unsigned int code, struct hid_field **field);
 struct hid_field *hidinput_get_led_field(struct hid_device *hid);
 unsigned int hidinput_count_leds(struct hid_device *hid);
@@ -896,6 +990,10 @@ __s32 hidinput_calc_abs_res(const struct hid_field *field, __u16 code);
 void hid_output_report(struct hid_report *report, __u8 *data);
 int __hid_request(struct hid_device *hid, struct hid_report *rep, int reqtype);
 u8 *hid_alloc_report_buf(struct hid_report *report, gfp_t flags);
+void hid_init_output_work(struct hid_output_work *ow, work_func_t func);
+bool hid_queue_output_work(struct hid_output_work *ow);
+int hid_hw_raw_request_async(struct hid_device *hdev,
+			     struct hid_raw_request *req);
 struct hid_device *hid_allocate_device(void);
 struct hid_report *hid_register_report(struct hid_device *device,
 				       unsigned int type, unsigned int id,
@@ -938,7 +1036,7 @@ static inline void hid_device_io_start(struct hid_device *hid) {
 		return;
 	}
 	hid->io_started = true;
-	up(&hid->driver_input_lock);
+	rcu_assign_pointer(hid->input_driver, hid->driver);
 }
 
 /**
@@ -958,7 +1056,8 @@ static inline void hid_device_io_stop(struct hid_device *hid) {
 		return;
 	}
 	hid->io_started = false;
-	down(&hid->driver_input_lock);
+	RCU_INIT_POINTER(hid->input_driver, NULL);
+	synchronize_rcu();
 }
 
 /**
@@ -1073,6 +1172,13 @@ static inline int hid_hw_power(struct hid_device *hdev, int level)
 }
 
 
+/* record the time of an output report in hdev->output_jiffies */
+static inline void hid_hw_note_output(struct hid_device *hdev, int reqtype)
+{
+	if (reqtype == HID_REQ_SET_REPORT)
+		WRITE_ONCE(hdev->output_jiffies, jiffies);
+}
+
 /**
  * hid_hw_request - send report request to device
  *
@@ -1083,6 +1189,8 @@ static inline int hid_hw_power(struct hid_device *hdev, int level)
 static inline void hid_hw_request(struct hid_device *hdev,
 				  struct hid_report *report, int reqtype)
 {
+	hid_hw_note_output(hdev, reqtype);
+
 	if (hdev->ll_driver->request)
 		return hdev->ll_driver->request(hdev, report, reqtype);
 
@@ -1110,6 +1218,8 @@ static inline int hid_hw_raw_request(struct hid_device *hdev,
 	if (len < 1 || len > HID_MAX_BUFFER_SIZE || !buf)
 		return -EINVAL;
 
+	hid_hw_note_output(hdev, reqtype);
+
 	return hdev->ll_driver->raw_request(hdev, reportnum, buf, len,
 						    rtype, reqtype);
 }
@@ -1129,6 +1239,8 @@ static inline int hid_hw_output_report(struct hid_device *hdev, __u8 *buf,
 	if (len < 1 || len > HID_MAX_BUFFER_SIZE || !buf)
 		return -EINVAL;
 
+	hid_hw_note_output(hdev, HID_REQ_SET_REPORT);
+
 	if (hdev->ll_driver->output_report)
 		return hdev->ll_driver->output_report(hdev, buf, len);
 
@@ -1231,4 +1343,28 @@ do {									\
 #define hid_dbg_once(hid, fmt, ...)			\
 	dev_dbg_once(&(hid)->dev, fmt, ##__VA_ARGS__)
 
+/*
+ * For report and output paths: messages are rate limited per call site and
+ * printed with printk_deferred(), so that a burst of them never writes to a
+ * slow console from there. Suppressed ones are counted in the log_dropped
+ * file of the device in debugfs.
+ */
+#define hid_printk_ratelimited(hid, level, fmt, ...)			\
+do {									\
+	static DEFINE_RATELIMIT_STATE(_rs, DEFAULT_RATELIMIT_INTERVAL,	\
+				      DEFAULT_RATELIMIT_BURST);		\
+	struct hid_device *_hid = (hid);				\
+									\
+	if (__ratelimit(&_rs))						\
+		printk_deferred(level "%s %s: " fmt,			\
+				dev_driver_string(&_hid->dev),		\
+				dev_name(&_hid->dev), ##__VA_ARGS__);	\
+	else								\
+		atomic_inc(&_hid->log_dropped);				\
+} while (0)
+#define hid_err_ratelimited(hid, fmt, ...)				\
+	hid_printk_ratelimited(hid, KERN_ERR, fmt, ##__VA_ARGS__)
+#define hid_warn_ratelimited(hid, fmt, ...)				\
+	hid_printk_ratelimited(hid, KERN_WARNING, fmt, ##__VA_ARGS__)
+
 #endif
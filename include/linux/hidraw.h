@@ -5,6 +5,7 @@
 #ifndef _HIDRAW_H
 #define _HIDRAW_H
 
+#include <linux/bitmap.h>
 #include <uapi/linux/hidraw.h>
 
 
@@ -17,21 +18,47 @@ struct hidraw {
 	struct device *dev;
 	spinlock_t list_lock;
 	struct list_head list;
+	int reader_cpu;		/* CPU last seen reading or polling, or -1 */
 };
 
 struct hidraw_report {
 	__u8 *value;
 	int len;
+	u64 time;
 };
 
 struct hidraw_list {
-	struct hidraw_report buffer[HIDRAW_BUFFER_SIZE];
+	struct hidraw_report *buffer;
+	unsigned int buffer_size;	/* a power of two */
 	int head;
 	int tail;
+	u32 dropped;
+	bool batch;			/* HIDRAW_READ_BATCH */
+	bool filtered;			/* only the IDs in filter are received */
+	DECLARE_BITMAP(filter, 256);
 	struct fasync_struct *fasync;
 	struct hidraw *hidraw;
 	struct list_head node;
 	struct mutex read_mutex;
+	struct hidraw_ring *ring;	/* mmap'able ring, see HIDIOCSRING */
+	u32 ring_head;
+	u32 ring_slots;			/* private copy of the geometry */
+	u32 ring_slot_size;
+	struct file *forward;		/* see HIDIOCSFORWARD */
+	const struct hidraw_sink *sink;
+};
+
+/**
+ * struct hidraw_sink - a kind of file hidraw can forward reports to
+ * @fops: file operations of the files handled by the sink
+ * @forward: queues @len bytes of @data to @file, called with a spinlock
+ *	held from the hid_input_report() context, so it must not sleep
+ * @list: entry in the list of sinks, private to hidraw
+ */
+struct hidraw_sink {
+	const struct file_operations *fops;
+	int (*forward)(struct file *file, const u8 *data, size_t len);
+	struct list_head list;
 };
 
 #ifdef CONFIG_HIDRAW
@@ -40,12 +67,19 @@ void hidraw_exit(void);
 int hidraw_report_event(struct hid_device *, u8 *, int);
 int hidraw_connect(struct hid_device *);
 void hidraw_disconnect(struct hid_device *);
+void hidraw_register_sink(struct hidraw_sink *sink);
+void hidraw_unregister_sink(struct hidraw_sink *sink);
+struct hid_device *hidraw_get_hid_from_fd(int fd);
+int hidraw_reader_cpu(struct hid_device *hid);
 #else
 static inline int hidraw_init(void) { return 0; }
 static inline void hidraw_exit(void) { }
 static inline int hidraw_report_event(struct hid_device *hid, u8 *data, int len) { return 0; }
 static inline int hidraw_connect(struct hid_device *hid) { return -1; }
 static inline void hidraw_disconnect(struct hid_device *hid) { }
+static inline void hidraw_register_sink(struct hidraw_sink *sink) { }
+static inline void hidraw_unregister_sink(struct hidraw_sink *sink) { }
+static inline int hidraw_reader_cpu(struct hid_device *hid) { return -1; }
 #endif
 
 #endif
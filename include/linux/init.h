@@ -149,6 +149,11 @@ extern unsigned int reset_devices;
 void setup_arch(char **);
 void prepare_namespace(void);
 void __init init_rootfs(void);
+#ifdef CONFIG_BOOT_PRELOAD
+void __init boot_preload(void);
+#else
+static inline void boot_preload(void) { }
+#endif
 extern struct file_system_type rootfs_fs_type;
 
 #if defined(CONFIG_STRICT_KERNEL_RWX) || defined(CONFIG_STRICT_MODULE_RWX)
@@ -19,6 +19,7 @@
 #include <linux/device.h>
 #include <linux/fs.h>
 #include <linux/timer.h>
+#include <linux/workqueue.h>
 #include <linux/mod_devicetable.h>
 
 struct input_dev_poller;
@@ -95,6 +96,10 @@ enum input_clock_type {
  * @close: this method is called when the very last user calls
  *	input_close_device(). The meaning of close() is to stop
  *	providing events to the input core.
+ * @interest: optional method called when the events wanted by the
+ *	readers of the device may have changed, see input_event_wanted().
+ *	It is called with @mutex held while the device is open and may
+ *	sleep
  * @flush: purges the device. Most commonly used to get rid of force
  *	feedback effects loaded into the device when disconnecting
  *	from it
@@ -124,15 +129,28 @@ enum input_clock_type {
  * @node: used to place the device onto input_dev_list
  * @num_vals: number of values queued in the current frame
  * @max_vals: maximum number of values queued in a frame
+ * @split_vals: number of values of the current frame already passed to
+ *	handlers because @vals filled up
+ * @split_frames: number of frames split within the current window
+ * @window_frames: number of frames seen within the current window
+ * @split_max: size of the largest split frame seen
+ * @vals_work: grows @vals when frames are split regularly
+ * @stat_frames: number of frames passed to handlers
+ * @stat_values: number of values passed to handlers
+ * @stat_early_flushes: number of times @vals filled up mid-frame
  * @vals: array of values queued in the current frame
  * @devres_managed: indicates that devices is managed with devres framework
  *	and needs not be explicitly unregistered or freed.
  * @timestamp: storage for a timestamp set by input_set_timestamp called
  *  by a driver
+ * @timestamp_clks: bitmask of the clocks in @timestamp that have been
+ *  converted for the current frame
  * @inhibited: indicates that the input device is inhibited. If that is
  * the case then input core ignores any events generated by the device.
  * Device's close() is called when it is being inhibited and its open()
  * is called when it is being uninhibited.
+ * @boost: events from the device ask schedutil for an input boost, see
+ *	schedutil_input_boost(). Off by default, set through sysfs.
  */
 struct input_dev {
 	const char *name;
@@ -184,6 +202,7 @@ struct input_dev {
 
 	int (*open)(struct input_dev *dev);
 	void (*close)(struct input_dev *dev);
+	void (*interest)(struct input_dev *dev);
 	int (*flush)(struct input_dev *dev, struct file *file);
 	int (*event)(struct input_dev *dev, unsigned int type, unsigned int code, int value);
 
@@ -204,11 +223,24 @@ struct input_dev {
 	unsigned int max_vals;
 	struct input_value *vals;
 
+	unsigned int split_vals;
+	unsigned int split_frames;
+	unsigned int window_frames;
+	unsigned int split_max;
+	struct work_struct vals_work;
+
+	unsigned long stat_frames;
+	unsigned long stat_values;
+	unsigned long stat_early_flushes;
+
 	bool devres_managed;
 
 	ktime_t timestamp[INPUT_CLK_MAX];
+	unsigned int timestamp_clks;
 
 	bool inhibited;
+
+	bool boost;
 };
 #define to_input_dev(d) container_of(d, struct input_dev, dev)
 
@@ -285,6 +317,14 @@ struct input_handle;
  * @start: starts handler for given handle. This function is called by
  *	input core right after connect() method and also when a process
  *	that "grabbed" a device releases it
+ * @group_sync: called from input_group_sync() once a driver has reported
+ *	a hardware report spread over several input devices. Same context
+ *	as @events
+ * @wants: optional method telling whether any reader of the handle
+ *	receives events of the given type and code. Handlers which filter
+ *	events on behalf of their readers implement it, and call
+ *	input_interest_changed() when the answer may have changed. It is
+ *	called under RCU and must not sleep
  * @legacy_minors: set to %true by drivers using legacy minor ranges
  * @minor: beginning of range of 32 legacy minors for devices this driver
  *	can provide
@@ -319,6 +359,9 @@ struct input_handler {
 	int (*connect)(struct input_handler *handler, struct input_dev *dev, const struct input_device_id *id);
 	void (*disconnect)(struct input_handle *handle);
 	void (*start)(struct input_handle *handle);
+	void (*group_sync)(struct input_handle *handle);
+	bool (*wants)(struct input_handle *handle,
+		      unsigned int type, unsigned int code);
 
 	bool legacy_minors;
 	int minor;
@@ -341,6 +384,9 @@ struct input_handler {
  * @d_node: used to put the handle on device's list of attached handles
  * @h_node: used to put the handle on handler's list of handles from which
  *	it gets events
+ * @evbit: bitmap of event types the handler wants from this handle; frames
+ *	with none of them are not passed to it. Set by the handler before
+ *	input_register_handle(), which fills it when left empty
  */
 struct input_handle {
 
@@ -354,6 +400,8 @@ struct input_handle {
 
 	struct list_head	d_node;
 	struct list_head	h_node;
+
+	unsigned long evbit[BITS_TO_LONGS(EV_CNT)];
 };
 
 struct input_dev __must_check *input_allocate_device(void);
@@ -391,6 +439,7 @@ int input_setup_polling(struct input_dev *dev,
 void input_set_poll_interval(struct input_dev *dev, unsigned int interval);
 void input_set_min_poll_interval(struct input_dev *dev, unsigned int interval);
 void input_set_max_poll_interval(struct input_dev *dev, unsigned int interval);
+int input_set_poll_hrtimer(struct input_dev *dev);
 int input_get_poll_interval(struct input_dev *dev);
 
 int __must_check input_register_handler(struct input_handler *);
@@ -413,11 +462,18 @@ int input_open_device(struct input_handle *);
 void input_close_device(struct input_handle *);
 
 int input_flush_device(struct input_handle *handle, struct file *file);
+void input_interest_changed(struct input_handle *handle);
 
 void input_set_timestamp(struct input_dev *dev, ktime_t timestamp);
 ktime_t *input_get_timestamp(struct input_dev *dev);
+ktime_t input_get_timestamp_clk(struct input_dev *dev,
+				enum input_clock_type clk);
 
 void input_event(struct input_dev *dev, unsigned int type, unsigned int code, int value);
+void input_event_values(struct input_dev *dev, const struct input_value *vals, unsigned int count);
+void input_group_sync(struct input_dev *dev);
+bool input_event_wanted(struct input_dev *dev,
+			unsigned int type, unsigned int code);
 void input_inject_event(struct input_handle *handle, unsigned int type, unsigned int code, int value);
 
 static inline void input_report_key(struct input_dev *dev, unsigned int code, int value)
@@ -574,5 +630,6 @@ int input_ff_flush(struct input_dev *dev, struct file *file);
 
 int input_ff_create_memless(struct input_dev *dev, void *data,
 		int (*play_effect)(struct input_dev *, void *, struct ff_effect *));
+void input_ff_memless_set_period(struct input_dev *dev, unsigned int period_us);
 
 #endif
@@ -67,6 +67,10 @@
  *                later.
  * IRQF_NO_DEBUG - Exclude from runnaway detection for IPI and similar handlers,
  *		   depends on IRQF_PERCPU.
+ * IRQF_THREAD_INPUT, IRQF_THREAD_AUDIO, IRQF_THREAD_STORAGE - Priority class
+ *                of the handler thread. It runs SCHED_FIFO at the class
+ *                priority instead of the default of MAX_RT_PRIO / 2, unless
+ *                /proc/irq/<irq>/thread_priority overrides it.
  */
 #define IRQF_SHARED		0x00000080
 #define IRQF_PROBE_SHARED	0x00000100
@@ -82,6 +86,17 @@
 #define IRQF_COND_SUSPEND	0x00040000
 #define IRQF_NO_AUTOEN		0x00080000
 #define IRQF_NO_DEBUG		0x00100000
+#define IRQF_THREAD_INPUT	0x00200000
+#define IRQF_THREAD_AUDIO	0x00400000
+#define IRQF_THREAD_STORAGE	0x00800000
+
+#define IRQF_THREAD_CLASS	(IRQF_THREAD_INPUT | IRQF_THREAD_AUDIO | \
+				 IRQF_THREAD_STORAGE)
+
+/* SCHED_FIFO priorities of the IRQF_THREAD_* classes */
+#define IRQ_THREAD_PRIO_INPUT	60
+#define IRQ_THREAD_PRIO_AUDIO	55
+#define IRQ_THREAD_PRIO_STORAGE	45
 
 #define IRQF_TIMER		(__IRQF_TIMER | IRQF_NO_SUSPEND | IRQF_NO_THREAD)
 
@@ -59,6 +59,15 @@ static inline int get_current_ioprio(void)
 	return IOPRIO_DEFAULT;
 }
 
+/*
+ * Whether the calling task asked for its I/O to be served as interactive.
+ */
+static inline bool current_ioprio_interactive(void)
+{
+	return IOPRIO_PRIO_HINT(get_current_ioprio()) ==
+		IOPRIO_HINT_INTERACTIVE;
+}
+
 /*
  * For inheritance, return the highest of the two given priorities
  */
@@ -211,6 +211,38 @@ void devm_led_classdev_unregister(struct device *parent,
 void led_classdev_suspend(struct led_classdev *led_cdev);
 void led_classdev_resume(struct led_classdev *led_cdev);
 
+/**
+ * struct led_group - LEDs of one device set together
+ * @name: name of the group directory, under the parent device
+ * @leds: the LEDs of the group, already registered
+ * @num_leds: number of LEDs in @leds
+ * @brightness_set: set the brightness of all the LEDs at once, @brightness
+ *		    holding one value per LED in the order of @leds. May
+ *		    sleep.
+ *
+ * Controllers with a row of player LEDs can update them all with one
+ * output report. The group exposes a brightness attribute taking one
+ * value per LED, and led_group_set_brightness() to do the same from
+ * the kernel.
+ */
+struct led_group {
+	const char *name;
+	struct led_classdev **leds;
+	unsigned int num_leds;
+	int (*brightness_set)(struct led_group *group,
+			      const enum led_brightness *brightness);
+
+	/* private */
+	struct device *dev;
+	struct mutex lock;
+};
+
+int led_group_register(struct device *parent, struct led_group *group);
+int devm_led_group_register(struct device *parent, struct led_group *group);
+void led_group_unregister(struct led_group *group);
+int led_group_set_brightness(struct led_group *group,
+			     const enum led_brightness *brightness);
+
 extern struct led_classdev *of_led_get(struct device_node *np, int index);
 extern void led_put(struct led_classdev *led_cdev);
 struct led_classdev *__must_check devm_of_led_get(struct device *dev,
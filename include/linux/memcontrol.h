@@ -265,6 +265,11 @@ struct mem_cgroup {
 	 */
 	bool oom_group;
 
+	/*
+	 * Should reclaim go to other groups first, whatever memory.low says?
+	 */
+	bool latency_critical;
+
 	/* protected by memcg_oom_lock */
 	bool		oom_lock;
 	int		under_oom;
@@ -865,6 +870,32 @@ static inline struct mem_cgroup *parent_mem_cgroup(struct mem_cgroup *memcg)
 	return mem_cgroup_from_counter(memcg->memory.parent, memory);
 }
 
+/*
+ * A group is latency critical if it, or any of its ancestors, has
+ * memory.latency_critical set.
+ */
+static inline bool mem_cgroup_latency_critical(struct mem_cgroup *memcg)
+{
+	for (; memcg && !mem_cgroup_is_root(memcg);
+	     memcg = parent_mem_cgroup(memcg))
+		if (READ_ONCE(memcg->latency_critical))
+			return true;
+	return false;
+}
+
+static inline bool current_latency_critical(void)
+{
+	bool ret;
+
+	if (mem_cgroup_disabled())
+		return false;
+
+	rcu_read_lock();
+	ret = mem_cgroup_latency_critical(mem_cgroup_from_task(current));
+	rcu_read_unlock();
+	return ret;
+}
+
 static inline bool mem_cgroup_is_descendant(struct mem_cgroup *memcg,
 			      struct mem_cgroup *root)
 {
@@ -1229,6 +1260,16 @@ static inline struct mem_cgroup *parent_mem_cgroup(struct mem_cgroup *memcg)
 	return NULL;
 }
 
+static inline bool mem_cgroup_latency_critical(struct mem_cgroup *memcg)
+{
+	return false;
+}
+
+static inline bool current_latency_critical(void)
+{
+	return false;
+}
+
 static inline bool mm_match_cgroup(struct mm_struct *mm,
 		struct mem_cgroup *memcg)
 {
@@ -35,6 +35,7 @@ enum mapping_flags {
 	/* writeback related tags are not used */
 	AS_NO_WRITEBACK_TAGS = 5,
 	AS_THP_SUPPORT = 6,	/* THPs supported */
+	AS_RA_RECORD = 7,	/* recording misses for readahead replay */
 };
 
 /**
@@ -861,6 +862,29 @@ void page_cache_async_ra(struct readahead_control *, struct page *,
 void readahead_expand(struct readahead_control *ractl,
 		      loff_t new_start, size_t new_len);
 
+#ifdef CONFIG_READAHEAD_REPLAY
+void __file_ra_replay(struct file *file);
+void ra_replay_free(struct address_space *mapping);
+
+/*
+ * Issue the reads recorded with POSIX_FADV_RECORD for a file being
+ * opened, if there are any.
+ */
+static inline void file_ra_replay(struct file *file)
+{
+	if (unlikely(READ_ONCE(file->f_mapping->ra_replay)))
+		__file_ra_replay(file);
+}
+#else
+static inline void file_ra_replay(struct file *file)
+{
+}
+
+static inline void ra_replay_free(struct address_space *mapping)
+{
+}
+#endif
+
 /**
  * page_cache_sync_readahead - generic file readahead
  * @mapping: address_space which holds the pagecache and I/O vectors
@@ -285,8 +285,10 @@ struct power_supply {
 
 	/* private */
 	struct device dev;
-	struct work_struct changed_work;
+	struct delayed_work changed_work;
 	struct delayed_work deferred_register_work;
+	struct list_head supplicants;	/* links to the supplies we supply */
+	struct list_head suppliers;	/* links to the supplies supplying us */
 	spinlock_t changed_lock;
 	bool changed;
 	bool initialized;
@@ -632,6 +632,12 @@ struct sched_dl_entity {
 	unsigned int			dl_non_contending : 1;
 	unsigned int			dl_overrun	  : 1;
 
+	/*
+	 * @dl_group tells if the parameters were set by the task group's
+	 * deadline reservation (cpu.dl) rather than by the task itself.
+	 */
+	bool				dl_group;
+
 	/*
 	 * Bandwidth enforcement timer. Each -deadline task has its
 	 * own bandwidth to be enforced, thus we need one timer per task.
@@ -35,4 +35,10 @@ static inline unsigned long map_util_perf(unsigned long util)
 }
 #endif /* CONFIG_CPU_FREQ */
 
+#ifdef CONFIG_CPU_FREQ_GOV_SCHEDUTIL
+void schedutil_input_boost(void);
+#else
+static inline void schedutil_input_boost(void) { }
+#endif
+
 #endif /* _LINUX_SCHED_CPUFREQ_H */
@@ -0,0 +1,57 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+#ifndef _LINUX_TRACE_FIXED_H
+#define _LINUX_TRACE_FIXED_H
+
+#include <linux/bits.h>
+#include <linux/compiler.h>
+#include <linux/jump_label.h>
+#include <linux/types.h>
+
+/*
+ * Fixed-record per-CPU trace rings, for timeline logging cheap enough to
+ * be left on in production. Each call site has an id and writes one
+ * record of four 32-bit arguments, with no reservation, no timestamp
+ * conversion and no nesting logic beyond disabling interrupts. The
+ * records are read from tracefs fixed_ring/per_cpu/cpuN/trace_pipe_raw.
+ */
+enum trace_fixed_id {
+	TRACE_FIXED_INPUT_FRAME,	/* vendor << 16 | product, values */
+	TRACE_FIXED_INPUT_READ,		/* vendor << 16 | product, events */
+	TRACE_FIXED_HID_REPORT,		/* vendor << 16 | product, seq, type, size */
+	TRACE_FIXED_PCM_PERIOD,		/* card/device/subdevice/stream, hw_ptr, appl_ptr */
+	TRACE_FIXED_NR,
+};
+
+struct trace_fixed_rec {
+	u64 ts;			/* trace_fixed_clock() */
+	u16 id;			/* enum trace_fixed_id */
+	u16 reserved;
+	u32 pid;
+	u32 arg[4];
+};
+
+#ifdef CONFIG_TRACE_FIXED_RING
+
+DECLARE_STATIC_KEY_FALSE(trace_fixed_key);
+extern unsigned long trace_fixed_mask;
+
+void __trace_fixed(unsigned int id, u32 a0, u32 a1, u32 a2, u32 a3);
+
+static __always_inline void trace_fixed(unsigned int id, u32 a0, u32 a1,
+					u32 a2, u32 a3)
+{
+	if (static_branch_unlikely(&trace_fixed_key) &&
+	    (READ_ONCE(trace_fixed_mask) & BIT(id)))
+		__trace_fixed(id, a0, a1, a2, a3);
+}
+
+#else
+
+static inline void trace_fixed(unsigned int id, u32 a0, u32 a1, u32 a2,
+			       u32 a3)
+{
+}
+
+#endif
+
+#endif /* _LINUX_TRACE_FIXED_H */
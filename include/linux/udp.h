@@ -71,6 +71,7 @@ struct udp_sock {
 #define UDPLITE_RECV_CC  0x4		/* set via udplite setsocktopt        */
 	__u8		 pcflag;        /* marks socket as UDP-Lite if > 0    */
 	__u8		 unused[3];
+	__u32		 gro_hold_us;	/* complete GRO packets held longer */
 	/*
 	 * For encapsulation sockets.
 	 */
@@ -60,6 +60,10 @@ struct ep_device;
  * @extralen: how many bytes of "extra" are valid
  * @enabled: URBs may be submitted to this endpoint
  * @streams: number of USB-3 streams allocated on the endpoint
+ * @latency_sensitive: completions are given back ahead of the other
+ *	periodic ones, as for interrupt endpoints, and xHCI reports them
+ *	through an interrupter of their own if it has one. Set by the
+ *	driver before submitting any URB to the endpoint
  *
  * USB requests are always queued to a given endpoint, identified by a
  * descriptor within an active interface in a given USB configuration.
@@ -76,6 +80,7 @@ struct usb_host_endpoint {
 	int extralen;
 	int enabled;
 	int streams;
+	bool latency_sensitive;
 };
 
 /* host-side wrapper for one interface setting's parsed descriptors */
@@ -1378,6 +1383,10 @@ static inline void init_usb_anchor(struct usb_anchor *anchor)
 }
 
 typedef void (*usb_complete_t)(struct urb *);
+typedef void (*usb_complete_batch_t)(struct urb **, unsigned int);
+
+/* most isochronous URBs handed to one usb_complete_batch_t call */
+#define USB_COMPLETE_BATCH_MAX	16
 
 /**
  * struct urb - USB Request Block
@@ -1448,6 +1457,12 @@ typedef void (*usb_complete_t)(struct urb *);
  * @complete: Completion handler. This URB is passed as the parameter to the
  *	completion function.  The completion function may then do what
  *	it likes with the URB, including resubmitting or freeing it.
+ * @complete_batch: Optional batched completion handler for isochronous
+ *	URBs.  When the host controller gives URBs back in a tasklet,
+ *	up to USB_COMPLETE_BATCH_MAX completed URBs of the same endpoint
+ *	and with the same @complete_batch are passed to it at once, in
+ *	completion order.  Otherwise @complete is used, so it must be set
+ *	as well.
  * @iso_frame_desc: Used to provide arrays of ISO transfer buffers and to
  *	collect the transfer status for each buffer.
  *
@@ -1597,6 +1612,7 @@ struct urb {
 	int error_count;		/* (return) number of ISO errors */
 	void *context;			/* (in) context for completion */
 	usb_complete_t complete;	/* (in) completion routine */
+	usb_complete_batch_t complete_batch; /* (in) ISO batch completion */
 	struct usb_iso_packet_descriptor iso_frame_desc[];
 					/* (in) ISO ONLY */
 };
@@ -1723,6 +1739,8 @@ extern void usb_free_urb(struct urb *urb);
 #define usb_put_urb usb_free_urb
 extern struct urb *usb_get_urb(struct urb *urb);
 extern int usb_submit_urb(struct urb *urb, gfp_t mem_flags);
+extern int usb_submit_urbs(struct urb **urbs, unsigned int count,
+			   gfp_t mem_flags);
 extern int usb_unlink_urb(struct urb *urb);
 extern void usb_kill_urb(struct urb *urb);
 extern void usb_poison_urb(struct urb *urb);
@@ -1742,6 +1760,14 @@ extern struct urb *usb_get_from_anchor(struct usb_anchor *anchor);
 extern void usb_scuttle_anchored_urbs(struct usb_anchor *anchor);
 extern int usb_anchor_empty(struct usb_anchor *anchor);
 
+struct usb_urb_pool;
+struct usb_urb_pool *usb_urb_pool_create(struct usb_device *dev,
+		unsigned int pipe, unsigned int nr_urbs, size_t buf_size,
+		gfp_t mem_flags);
+void usb_urb_pool_destroy(struct usb_urb_pool *pool);
+struct urb *usb_urb_pool_get(struct usb_urb_pool *pool);
+void usb_urb_pool_put(struct usb_urb_pool *pool, struct urb *urb);
+
 #define usb_unblock_urb	usb_unpoison_urb
 
 /**
@@ -68,6 +68,7 @@ struct giveback_urb_bh {
 	bool running;
 	spinlock_t lock;
 	struct list_head  head;
+	struct list_head  urgent;	/* given back before head */
 	struct tasklet_struct bh;
 	struct usb_host_endpoint *completing_ep;
 };
@@ -174,6 +175,7 @@ struct usb_hcd {
 	unsigned		tpl_support:1; /* OTG & EH TPL support */
 	unsigned		cant_recv_wakeups:1;
 			/* wakeup requests from downstream aren't received */
+	unsigned		giveback_in_bh:1; /* HCD_BH for this controller */
 
 	unsigned int		irq;		/* irq allocated */
 	void __iomem		*regs;		/* device memory/io */
@@ -419,7 +421,7 @@ struct hc_driver {
 
 static inline int hcd_giveback_urb_in_bh(struct usb_hcd *hcd)
 {
-	return hcd->driver->flags & HCD_BH;
+	return (hcd->driver->flags & HCD_BH) || hcd->giveback_in_bh;
 }
 
 static inline bool hcd_periodic_completion_in_progress(struct usb_hcd *hcd,
@@ -27,6 +27,7 @@
  * @big_endian_mmio:	BE registers
  * @no_big_frame_no:	no big endian frame_no shift
  * @num_ports:		number of ports
+ * @giveback_in_bh:	give URBs back in a tasklet, not the irq handler
  *
  * These are general configuration options for the OHCI controller. All of
  * these options are activating more or less workarounds for some hardware.
@@ -35,6 +36,7 @@ struct usb_ohci_pdata {
 	unsigned	big_endian_desc:1;
 	unsigned	big_endian_mmio:1;
 	unsigned	no_big_frame_no:1;
+	unsigned	giveback_in_bh:1;
 	unsigned int	num_ports;
 
 	/* Turn on all power and clocks */
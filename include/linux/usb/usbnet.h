@@ -23,6 +23,8 @@
 #ifndef	__LINUX_USB_USBNET_H
 #define	__LINUX_USB_USBNET_H
 
+struct page_pool;
+
 /* interface from usbnet core to each USB networking link we handle */
 struct usbnet {
 	/* housekeeping */
@@ -68,6 +70,14 @@ struct usbnet {
 	struct usb_anchor	deferred;
 	struct tasklet_struct	bh;
 
+	/* rx buffers recycled through a page pool, see rx_submit() */
+	struct page_pool	*rx_pool;
+	spinlock_t		rx_pool_lock;
+	unsigned int		rx_pool_len;	/* headroom plus data per buffer */
+	struct device		*rx_dma_dev;	/* if rx_pool maps for DMA */
+	unsigned long		rx_pool_skbs;
+	unsigned long		rx_pool_fallbacks;
+
 	struct work_struct	kevent;
 	unsigned long		flags;
 #		define EVENT_TX_HALT	0
@@ -280,6 +290,10 @@ extern void usbnet_set_msglevel(struct net_device *, u32);
 extern void usbnet_set_rx_mode(struct net_device *net);
 extern void usbnet_get_drvinfo(struct net_device *, struct ethtool_drvinfo *);
 extern int usbnet_nway_reset(struct net_device *net);
+extern int usbnet_get_sset_count(struct net_device *net, int sset);
+extern void usbnet_get_strings(struct net_device *net, u32 sset, u8 *data);
+extern void usbnet_get_ethtool_stats(struct net_device *net,
+				     struct ethtool_stats *stats, u64 *data);
 
 extern int usbnet_manage_power(struct usbnet *, int);
 extern void usbnet_link_change(struct usbnet *, bool, bool);
@@ -641,6 +641,9 @@ struct hci_conn {
 	__u8		features[HCI_MAX_PAGES][8];
 	__u16		pkt_type;
 	__u16		link_policy;
+	__u16		sniff_min_interval;	/* 0: hdev default */
+	__u16		sniff_max_interval;
+	__u16		mode_interval;	/* from the last mode change */
 	__u8		key_type;
 	__u8		auth_type;
 	__u8		sec_level;
@@ -1113,6 +1116,7 @@ int hci_conn_security(struct hci_conn *conn, __u8 sec_level, __u8 auth_type,
 int hci_conn_switch_role(struct hci_conn *conn, __u8 role);
 
 void hci_conn_enter_active_mode(struct hci_conn *conn, __u8 force_active);
+int hci_conn_set_sniff_interval(struct hci_conn *conn, u16 min, u16 max);
 
 void hci_le_conn_failed(struct hci_conn *conn, u8 status);
 
@@ -713,6 +713,10 @@ struct cfg80211_bitrate_mask {
  * @amsdu: Enable/Disable MSDU aggregation
  * @txrate_type: Tx bitrate mask type
  * @txrate_mask: Tx bitrate to be applied for the TID
+ * @ampdu_max_len: maximum A-MPDU length in bytes, 0 for no limit
+ * @ampdu_max_duration: maximum A-MPDU duration in usec, 0 for no limit
+ * @ampdu_max_delay: maximum time in usec frames may be held back to build
+ *	a larger A-MPDU, 0 for no limit
  */
 struct cfg80211_tid_cfg {
 	bool config_override;
@@ -725,6 +729,21 @@ struct cfg80211_tid_cfg {
 	enum nl80211_tid_config amsdu;
 	enum nl80211_tx_rate_setting txrate_type;
 	struct cfg80211_bitrate_mask txrate_mask;
+	u32 ampdu_max_len;
+	u16 ampdu_max_duration;
+	u16 ampdu_max_delay;
+};
+
+/**
+ * struct cfg80211_tsf_info - TSF with a system clock correlation
+ * @tsf: TSF of the interface in usec
+ * @monotonic_ns: %CLOCK_MONOTONIC time in nsec at which @tsf was read
+ * @error_ns: maximum difference between the two, in nsec
+ */
+struct cfg80211_tsf_info {
+	u64 tsf;
+	u64 monotonic_ns;
+	u32 error_ns;
 };
 
 /**
@@ -1302,6 +1321,10 @@ struct iface_combination_params {
  * @STATION_PARAM_APPLY_UAPSD: apply new uAPSD parameters (uapsd_queues, max_sp)
  * @STATION_PARAM_APPLY_CAPABILITY: apply new capability
  * @STATION_PARAM_APPLY_PLINK_STATE: apply new plink state
+ * @STATION_PARAM_APPLY_STA_TXPOWER: apply new tx power setting
+ * @STATION_PARAM_APPLY_AIRTIME_LATENCY: apply new airtime latency class
+ * @STATION_PARAM_APPLY_PS_LOWLAT: apply new power save latency policy
+ *	(ps_lowlat_tids, ps_lowlat_interval)
  *
  * Not all station parameters have in-band "no change" signalling,
  * for those that don't these flags will are used.
@@ -1311,6 +1334,8 @@ enum station_parameters_apply_mask {
 	STATION_PARAM_APPLY_CAPABILITY = BIT(1),
 	STATION_PARAM_APPLY_PLINK_STATE = BIT(2),
 	STATION_PARAM_APPLY_STA_TXPOWER = BIT(3),
+	STATION_PARAM_APPLY_AIRTIME_LATENCY = BIT(4),
+	STATION_PARAM_APPLY_PS_LOWLAT = BIT(5),
 };
 
 /**
@@ -1376,6 +1401,12 @@ struct sta_txpwr {
  * @he_capa: HE capabilities of station
  * @he_capa_len: the length of the HE capabilities
  * @airtime_weight: airtime scheduler weight for this station
+ * @airtime_latency_critical: serve this station ahead of the weighted
+ *	airtime order, within a budget (only applied with
+ *	%STATION_PARAM_APPLY_AIRTIME_LATENCY)
+ * @ps_lowlat_tids: TIDs of a periodic, latency-critical stream to the station
+ *	while it is in power save
+ * @ps_lowlat_interval: period of that stream in usec
  * @txpwr: transmit power for an associated station
  * @he_6ghz_capa: HE 6 GHz Band capabilities of station
  */
@@ -1409,6 +1440,9 @@ struct station_parameters {
 	const struct ieee80211_he_cap_elem *he_capa;
 	u8 he_capa_len;
 	u16 airtime_weight;
+	bool airtime_latency_critical;
+	u8 ps_lowlat_tids;
+	u32 ps_lowlat_interval;
 	struct sta_txpwr txpwr;
 	const struct ieee80211_he_6ghz_capa *he_6ghz_capa;
 };
@@ -4018,6 +4052,9 @@ struct mgmt_frame_regs {
  * @set_sar_specs: Update the SAR (TX power) settings.
  *
  * @color_change: Initiate a color change.
+ *
+ * @get_tsf: Read the TSF of the interface together with the %CLOCK_MONOTONIC
+ *	time it was read at. This callback may sleep.
  */
 struct cfg80211_ops {
 	int	(*suspend)(struct wiphy *wiphy, struct cfg80211_wowlan *wow);
@@ -4348,6 +4385,8 @@ struct cfg80211_ops {
 	int	(*color_change)(struct wiphy *wiphy,
 				struct net_device *dev,
 				struct cfg80211_color_change_settings *params);
+	int	(*get_tsf)(struct wiphy *wiphy, struct net_device *dev,
+			   struct cfg80211_tsf_info *tsf);
 };
 
 /*
@@ -5391,6 +5430,8 @@ static inline void wiphy_unlock(struct wiphy *wiphy)
  * @cac_time_ms: CAC time in ms
  * @ps: powersave mode is enabled
  * @ps_timeout: dynamic powersave timeout
+ * @rt_scan_policy: scan handling while the interface carries real-time
+ *	traffic, set by cfg80211 from userspace and read-only for drivers
  * @ap_unexpected_nlportid: (private) netlink port ID of application
  *	registered for unexpected class 3 frames (AP mode)
  * @conn: (private) cfg80211 software SME connection state machine data
@@ -5456,6 +5497,8 @@ struct wireless_dev {
 	bool ps;
 	int ps_timeout;
 
+	enum nl80211_rt_scan_policy rt_scan_policy;
+
 	int beacon_interval;
 
 	u32 ap_unexpected_nlportid;
@@ -2035,6 +2035,24 @@ struct ieee80211_sta_txpwr {
 	enum nl80211_tx_power_setting type;
 };
 
+/**
+ * struct ieee80211_ampdu_policy - A-MPDU formation limits for a TID
+ *
+ * Set with %NL80211_CMD_SET_TID_CONFIG, for latency-sensitive streams
+ * that want small, prompt aggregates rather than the largest ones the
+ * block-ack window allows. Zero means no limit in all fields.
+ *
+ * @max_len: maximum A-MPDU length in bytes
+ * @max_duration: maximum A-MPDU duration in usec at the selected rate
+ * @max_delay: maximum time in usec frames may be held back waiting for
+ *	a larger aggregate to form
+ */
+struct ieee80211_ampdu_policy {
+	u32 max_len;
+	u16 max_duration;
+	u16 max_delay;
+};
+
 /**
  * struct ieee80211_sta - station table entry
  *
@@ -2080,6 +2098,8 @@ struct ieee80211_sta_txpwr {
  * @support_p2p_ps: indicates whether the STA supports P2P PS mechanism or not.
  * @max_rc_amsdu_len: Maximum A-MSDU size in bytes recommended by rate control.
  * @max_tid_amsdu_len: Maximum A-MSDU size in bytes for this TID
+ * @ampdu_policy: per-TID A-MPDU limits configured by userspace, only set
+ *	for drivers with %IEEE80211_HW_SUPPORTS_AMPDU_POLICY
  * @txpwr: the station tx power configuration
  * @txq: per-TID data TX queues (if driver uses the TXQ abstraction); note that
  *	the last entry (%IEEE80211_NUM_TIDS) is used for non-data frames
@@ -2124,6 +2144,7 @@ struct ieee80211_sta {
 	bool support_p2p_ps;
 	u16 max_rc_amsdu_len;
 	u16 max_tid_amsdu_len[IEEE80211_NUM_TIDS];
+	struct ieee80211_ampdu_policy ampdu_policy[IEEE80211_NUM_TIDS];
 	struct ieee80211_sta_txpwr txpwr;
 
 	struct ieee80211_txq *txq[IEEE80211_NUM_TIDS + 1];
@@ -2411,6 +2432,14 @@ struct ieee80211_txq {
  *	usage and 802.11 frames with %RX_FLAG_ONLY_MONITOR set for monitor to
  *	the stack.
  *
+ * @IEEE80211_HW_SUPPORTS_AMPDU_POLICY: The driver honours the per-TID
+ *	&struct ieee80211_ampdu_policy limits of a station when it forms
+ *	A-MPDUs; mac80211 then accepts them with %NL80211_CMD_SET_TID_CONFIG.
+ *
+ * @IEEE80211_HW_NEEDS_RX_NAPI: The driver has no NAPI context of its own
+ *	(e.g. USB or SDIO devices) and passes received frames through
+ *	ieee80211_rx_queue_napi(); mac80211 then runs a NAPI instance for it.
+ *
  * @NUM_IEEE80211_HW_FLAGS: number of hardware flags, used for sizing arrays
  */
 enum ieee80211_hw_flags {
@@ -2466,6 +2495,8 @@ enum ieee80211_hw_flags {
 	IEEE80211_HW_SUPPORTS_TX_ENCAP_OFFLOAD,
 	IEEE80211_HW_SUPPORTS_RX_DECAP_OFFLOAD,
 	IEEE80211_HW_SUPPORTS_CONC_MON_RX_DECAP,
+	IEEE80211_HW_SUPPORTS_AMPDU_POLICY,
+	IEEE80211_HW_NEEDS_RX_NAPI,
 
 	/* keep last, obviously */
 	NUM_IEEE80211_HW_FLAGS
@@ -4586,6 +4617,23 @@ static inline void ieee80211_rx(struct ieee80211_hw *hw, struct sk_buff *skb)
  */
 void ieee80211_rx_irqsafe(struct ieee80211_hw *hw, struct sk_buff *skb);
 
+/**
+ * ieee80211_rx_queue_napi - receive frame through the mac80211 NAPI context
+ *
+ * For drivers that set %IEEE80211_HW_NEEDS_RX_NAPI. The frame is queued
+ * and handed to ieee80211_rx_napi() from a NAPI poll that mac80211 runs
+ * on behalf of the driver, so received packets carry a NAPI ID and go
+ * through GRO, and sockets reading them can busy poll.
+ *
+ * May be called from process or softirq context, but not from hard IRQ
+ * context. Calls to this function and the other receive functions may
+ * not be mixed for a single hardware.
+ *
+ * @hw: the hardware this frame came in on
+ * @skb: the buffer to receive, owned by mac80211 after this call
+ */
+void ieee80211_rx_queue_napi(struct ieee80211_hw *hw, struct sk_buff *skb);
+
 /**
  * ieee80211_rx_ni - receive frame (in process context)
  *
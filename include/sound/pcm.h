@@ -15,6 +15,7 @@
 #include <linux/mm.h>
 #include <linux/bitops.h>
 #include <linux/pm_qos.h>
+#include <linux/hrtimer.h>
 #include <linux/refcount.h>
 
 #define snd_pcm_substream_chip(substream) ((substream)->private_data)
@@ -457,6 +458,8 @@ struct snd_pcm_substream {
         /* -- timer section -- */
 	struct snd_timer *timer;		/* timer */
 	unsigned timer_running: 1;	/* time is running */
+	struct hrtimer hw_ptr_timer;	/* periodic hw_ptr update */
+	ktime_t hw_ptr_interval;
 	long wait_time;	/* time in ms for R/W to wait for avail */
 	/* -- next substream -- */
 	struct snd_pcm_substream *next;
@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: GPL-2.0-or-later */
+/*
+ * HID report lifecycle tracepoints
+ *
+ * Every stage of a report carries the same sequence number, assigned by
+ * hid_input_report(), so that the latency of each stage can be measured.
+ */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM hid
+
+#if !defined(_TRACE_HID_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_HID_H
+
+#include <linux/hid.h>
+#include <linux/tracepoint.h>
+
+DECLARE_EVENT_CLASS(hid_report,
+	TP_PROTO(const struct hid_device *hdev, unsigned int seq, int type,
+		 const u8 *data, u32 len),
+	TP_ARGS(hdev, seq, type, data, len),
+	TP_STRUCT__entry(
+		__field(int,		id		)
+		__field(unsigned int,	seq		)
+		__field(int,		type		)
+		__field(unsigned int,	report_id	)
+		__field(u32,		len		)
+	),
+	TP_fast_assign(
+		__entry->id = hdev->id;
+		__entry->seq = seq;
+		__entry->type = type;
+		__entry->report_id = len && hdev->report_enum[type].numbered ?
+				     data[0] : 0;
+		__entry->len = len;
+	),
+	TP_printk("hid-%d seq=%u type=%d id=%u len=%u",
+		  __entry->id, __entry->seq, __entry->type,
+		  __entry->report_id, __entry->len)
+);
+
+/* a transport driver received a report, before hid_input_report() */
+DEFINE_EVENT(hid_report, hid_transport_report,
+	TP_PROTO(const struct hid_device *hdev, unsigned int seq, int type,
+		 const u8 *data, u32 len),
+	TP_ARGS(hdev, seq, type, data, len)
+);
+
+/* hid_input_report() entry */
+DEFINE_EVENT(hid_report, hid_input_report,
+	TP_PROTO(const struct hid_device *hdev, unsigned int seq, int type,
+		 const u8 *data, u32 len),
+	TP_ARGS(hdev, seq, type, data, len)
+);
+
+/* the report is passed to the driver's raw_event */
+DEFINE_EVENT(hid_report, hid_raw_event,
+	TP_PROTO(const struct hid_device *hdev, unsigned int seq, int type,
+		 const u8 *data, u32 len),
+	TP_ARGS(hdev, seq, type, data, len)
+);
+
+/* the report is queued to the hidraw readers */
+DEFINE_EVENT(hid_report, hid_hidraw_report,
+	TP_PROTO(const struct hid_device *hdev, unsigned int seq, int type,
+		 const u8 *data, u32 len),
+	TP_ARGS(hdev, seq, type, data, len)
+);
+
+/* the report is fully processed, hid-input events reached the handlers */
+DEFINE_EVENT(hid_report, hid_report_done,
+	TP_PROTO(const struct hid_device *hdev, unsigned int seq, int type,
+		 const u8 *data, u32 len),
+	TP_ARGS(hdev, seq, type, data, len)
+);
+
+#endif /* _TRACE_HID_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Input frame tracepoints
+ *
+ * input_frame fires when a frame ending in SYN_REPORT is passed to the
+ * handlers and input_frame_read when a reader consumes its SYN_REPORT.
+ * Both carry the CLOCK_MONOTONIC timestamp of the frame, so the pair
+ * gives the latency from the driver to userspace.
+ */
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM input
+
+#if !defined(_TRACE_INPUT_H) || defined(TRACE_HEADER_MULTI_READ)
+#define _TRACE_INPUT_H
+
+#include <linux/input.h>
+#include <linux/ktime.h>
+#include <linux/tracepoint.h>
+
+TRACE_EVENT(input_frame,
+	TP_PROTO(struct input_dev *dev, unsigned int count, ktime_t time),
+	TP_ARGS(dev, count, time),
+	TP_STRUCT__entry(
+		__string(	name,	dev_name(&dev->dev)	)
+		__field(	unsigned int,	count		)
+		__field(	s64,		time		)
+	),
+	TP_fast_assign(
+		__assign_str(name, dev_name(&dev->dev));
+		__entry->count = count;
+		__entry->time = ktime_to_ns(time);
+	),
+	TP_printk("%s count=%u time=%lld",
+		  __get_str(name), __entry->count, __entry->time)
+);
+
+TRACE_EVENT(input_frame_read,
+	TP_PROTO(struct input_dev *dev, ktime_t time),
+	TP_ARGS(dev, time),
+	TP_STRUCT__entry(
+		__string(	name,	dev_name(&dev->dev)	)
+		__field(	s64,		time		)
+	),
+	TP_fast_assign(
+		__assign_str(name, dev_name(&dev->dev));
+		__entry->time = ktime_to_ns(time);
+	),
+	TP_printk("%s time=%lld", __get_str(name), __entry->time)
+);
+
+#endif /* _TRACE_INPUT_H */
+
+/* This part must be outside protection */
+#include <trace/define_trace.h>
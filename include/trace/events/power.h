@@ -223,6 +223,42 @@ TRACE_EVENT(device_pm_callback_end,
 		__get_str(driver), __get_str(device), __entry->error)
 );
 
+/*
+ * Emitted when a device is done resuming: @ready_us after the resume phase
+ * began, of which @busy_us went into resuming the device once its parent
+ * and suppliers were done.
+ */
+TRACE_EVENT(device_pm_resumed,
+
+	TP_PROTO(struct device *dev, s64 ready_us, s64 busy_us, bool async),
+
+	TP_ARGS(dev, ready_us, busy_us, async),
+
+	TP_STRUCT__entry(
+		__string(device, dev_name(dev))
+		__string(driver, dev_driver_string(dev))
+		__field(s64, ready_us)
+		__field(s64, busy_us)
+		__field(bool, async)
+		__field(bool, priority)
+	),
+
+	TP_fast_assign(
+		__assign_str(device, dev_name(dev));
+		__assign_str(driver, dev_driver_string(dev));
+		__entry->ready_us = ready_us;
+		__entry->busy_us = busy_us;
+		__entry->async = async;
+		__entry->priority = dev->power.resume_priority;
+	),
+
+	TP_printk("%s %s, ready=%lldus busy=%lldus%s%s",
+		__get_str(driver), __get_str(device),
+		__entry->ready_us, __entry->busy_us,
+		__entry->async ? " async" : "",
+		__entry->priority ? " priority" : "")
+);
+
 TRACE_EVENT(suspend_resume,
 
 	TP_PROTO(const char *action, int val, bool start),
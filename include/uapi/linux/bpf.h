@@ -285,6 +285,12 @@ union bpf_iter_link_info {
  *			LIRC device path (eg /dev/lircN). Requires the kernel
  *			to be compiled with **CONFIG_BPF_LIRC_MODE2**.
  *
+ *		**BPF_PROG_TYPE_HID_REPORT**
+ *
+ *			hidraw device path (eg /dev/hidrawN), open for
+ *			writing. Requires the kernel to be compiled with
+ *			**CONFIG_HID_BPF**.
+ *
  *		**BPF_PROG_TYPE_SK_SKB**,
  *		**BPF_PROG_TYPE_SK_MSG**
  *
@@ -431,6 +437,12 @@ union bpf_iter_link_info {
  *			LIRC device path (eg /dev/lircN). Requires the kernel
  *			to be compiled with **CONFIG_BPF_LIRC_MODE2**.
  *
+ *		**BPF_PROG_TYPE_HID_REPORT**
+ *
+ *			hidraw device path (eg /dev/hidrawN), open for
+ *			writing. Requires the kernel to be compiled with
+ *			**CONFIG_HID_BPF**.
+ *
  *		**BPF_PROG_QUERY** always fetches the number of programs
  *		attached and the *attach_flags* which were used to attach those
  *		programs. Additionally, if *prog_ids* is nonzero and the number
@@ -949,6 +961,7 @@ enum bpf_prog_type {
 	BPF_PROG_TYPE_LSM,
 	BPF_PROG_TYPE_SK_LOOKUP,
 	BPF_PROG_TYPE_SYSCALL, /* a program that can execute syscalls */
+	BPF_PROG_TYPE_HID_REPORT,
 };
 
 enum bpf_attach_type {
@@ -994,6 +1007,7 @@ enum bpf_attach_type {
 	BPF_SK_REUSEPORT_SELECT,
 	BPF_SK_REUSEPORT_SELECT_OR_MIGRATE,
 	BPF_PERF_EVENT,
+	BPF_HID_REPORT,
 	__MAX_BPF_ATTACH_TYPE
 };
 
@@ -6228,6 +6242,20 @@ struct bpf_sk_lookup {
 	__u32 local_port;	/* Host byte order */
 };
 
+/*
+ * User accessible data for HID_REPORT programs. The report, starting with
+ * its ID if the device uses numbered reports, may be rewritten in place.
+ * Returning 0 drops the report, 1 passes it on. Add new fields at the end.
+ */
+struct bpf_hid_report {
+	__u32 data;
+	__u32 data_end;
+	__u32 type;		/* HID_INPUT_REPORT, ... */
+	__u32 bus;		/* BUS_USB, BUS_BLUETOOTH, ... */
+	__u32 vendor;
+	__u32 product;
+};
+
 /*
  * struct btf_ptr is used for typed pointer representation; the
  * type id is used to render the pointer data as the appropriate type
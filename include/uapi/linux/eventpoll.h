@@ -18,6 +18,7 @@
 /* For O_CLOEXEC */
 #include <linux/fcntl.h>
 #include <linux/types.h>
+#include <linux/ioctl.h>
 
 /* Flags for epoll_create1.  */
 #define EPOLL_CLOEXEC O_CLOEXEC
@@ -79,6 +80,21 @@ struct epoll_event {
 	__u64 data;
 } EPOLL_PACKED;
 
+/*
+ * Wakeup coalescing for an epoll instance. The first event that becomes
+ * ready while a thread waits in epoll_wait() starts a timer of @usecs;
+ * the waiter is woken when it expires, or as soon as @max_ready files
+ * are ready when @max_ready is not zero. @usecs of zero disables it.
+ */
+struct epoll_coalesce {
+	__u32 usecs;
+	__u32 max_ready;
+};
+
+#define EPOLL_IOC_TYPE		0x8A
+#define EPIOCSCOALESCE		_IOW(EPOLL_IOC_TYPE, 0x01, struct epoll_coalesce)
+#define EPIOCGCOALESCE		_IOR(EPOLL_IOC_TYPE, 0x02, struct epoll_coalesce)
+
 #ifdef CONFIG_PM_SLEEP
 static inline void ep_take_care_of_epollwakeup(struct epoll_event *epev)
 {
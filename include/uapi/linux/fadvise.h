@@ -19,4 +19,8 @@
 #define POSIX_FADV_NOREUSE	5 /* Data will be accessed once.  */
 #endif
 
+/* Linux specific, record the access pattern and prefetch it on later opens */
+#define POSIX_FADV_RECORD	8 /* Start recording page cache misses.  */
+#define POSIX_FADV_REPLAY	9 /* Stop recording, read what was recorded.  */
+
 #endif	/* FADVISE_H_INCLUDED */
@@ -0,0 +1,34 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+/*
+ * Binary format of the events_raw file in the debugfs directory of a HID
+ * device.
+ */
+#ifndef _UAPI_HID_DEBUG_H
+#define _UAPI_HID_DEBUG_H
+
+#include <linux/types.h>
+
+/* most bytes of payload a record carries */
+#define HID_DEBUG_PAYLOAD_MAX 1024
+
+enum hid_debug_kind {
+	HID_DEBUG_TEXT,		/* free form text from hid_debug_event() */
+	HID_DEBUG_REPORT,	/* a raw report, as received */
+	HID_DEBUG_INPUT,	/* a usage value passed to hid-input */
+};
+
+/*
+ * Each event is one of these records, followed by len bytes of payload.
+ */
+struct hid_debug_record {
+	__u64 time;		/* CLOCK_MONOTONIC, in ns */
+	__u32 usage;		/* HID_DEBUG_INPUT only */
+	__s32 value;		/* HID_DEBUG_INPUT only */
+	__u16 size;		/* size of the report or text */
+	__u16 len;		/* bytes of payload, at most HID_DEBUG_PAYLOAD_MAX */
+	__u8 kind;		/* enum hid_debug_kind */
+	__u8 type;		/* report type, HID_DEBUG_REPORT only */
+	__u16 reserved;
+};
+
+#endif /* _UAPI_HID_DEBUG_H */
@@ -0,0 +1,67 @@
+/* SPDX-License-Identifier: GPL-2.0 WITH Linux-syscall-note */
+/*
+ * Latest state of the Nintendo Wii U gamepads (DRC), as published by
+ * hid-nintendo-wiiu in the drc_state attribute of the DRH HID device.
+ */
+#ifndef _UAPI_HID_NINTENDO_WIIU_H
+#define _UAPI_HID_NINTENDO_WIIU_H
+
+#include <linux/types.h>
+
+#define WIIU_DRC_MAX_PADS	2
+
+/* Bits of wiiu_drc_state.buttons */
+#define WIIU_DRC_BTN_SYNC	(1U << 0)
+#define WIIU_DRC_BTN_HOME	(1U << 1)
+#define WIIU_DRC_BTN_MINUS	(1U << 2)
+#define WIIU_DRC_BTN_PLUS	(1U << 3)
+#define WIIU_DRC_BTN_R		(1U << 4)
+#define WIIU_DRC_BTN_L		(1U << 5)
+#define WIIU_DRC_BTN_ZR		(1U << 6)
+#define WIIU_DRC_BTN_ZL		(1U << 7)
+#define WIIU_DRC_BTN_DOWN	(1U << 8)
+#define WIIU_DRC_BTN_UP		(1U << 9)
+#define WIIU_DRC_BTN_RIGHT	(1U << 10)
+#define WIIU_DRC_BTN_LEFT	(1U << 11)
+#define WIIU_DRC_BTN_Y		(1U << 12)
+#define WIIU_DRC_BTN_X		(1U << 13)
+#define WIIU_DRC_BTN_B		(1U << 14)
+#define WIIU_DRC_BTN_A		(1U << 15)
+#define WIIU_DRC_BTN_TV		(1U << 21)
+#define WIIU_DRC_BTN_R3		(1U << 22)
+#define WIIU_DRC_BTN_L3		(1U << 23)
+#define WIIU_DRC_BTN_POWER	(1U << 25)
+
+/*
+ * State decoded from the last report of one DRC. The driver updates it
+ * once per report, with seq odd during the update. A reader takes a
+ * consistent copy by reading seq, waiting for it to be even, copying the
+ * rest with a read barrier on either side and reading seq again, and
+ * retrying if it changed. A seq of zero means no report was received.
+ *
+ * The sticks are in the range of the joypad's ABS_X..ABS_RY axes, the
+ * touch position in the range of the touchscreen's ABS_X and ABS_Y and
+ * the motion values in the raw units of the accelerometer device.
+ */
+struct wiiu_drc_state {
+	__u32 seq;
+	__u16 report_seq;		/* sequence number of the report */
+	__u8 volume;
+	__u8 touch;			/* screen is touched */
+	__s64 time_ns;			/* CLOCK_MONOTONIC sampling time */
+	__u32 buttons;			/* WIIU_DRC_BTN_* */
+	__s16 sticks[4];		/* left x, y, right x, y */
+	__u16 touch_x;
+	__u16 touch_y;
+	__s16 accel[3];
+	__s16 magn[3];
+	__s32 gyro[3];
+	__u32 reserved[2];
+};
+
+/* Layout of the drc_state page, indexed by DRC number minus one */
+struct wiiu_drh_state {
+	struct wiiu_drc_state pads[WIIU_DRC_MAX_PADS];
+};
+
+#endif /* _UAPI_HID_NINTENDO_WIIU_H */
@@ -136,6 +136,19 @@ struct hiddev_usage_ref_multi {
 	__s32 values[HID_MAX_MULTI_USAGES];
 };
 
+/* hiddev_report_values is used for reading the values of all the fields of a
+ * report at once, in field order.  Fill in report_type and report_id, on
+ * return num_values holds the number of values.  With HIDDEV_FLAG_VALUES,
+ * read() returns one such record per report sent by the device, with only
+ * num_values values following the header.
+ */
+struct hiddev_report_values {
+	__u32 report_type;
+	__u32 report_id;
+	__u32 num_values;
+	__s32 values[HID_MAX_MULTI_USAGES];
+};
+
 /* FIELD_INDEX_NONE is returned in read() data from the kernel when flags
  * is set to (HIDDEV_FLAG_UREF | HIDDEV_FLAG_REPORT) and a new report has
  * been sent by the device 
@@ -146,7 +159,7 @@ struct hiddev_usage_ref_multi {
  * Protocol version.
  */
 
-#define HID_VERSION		0x010004
+#define HID_VERSION		0x010005
 
 /*
  * IOCTLs (0x00 - 0x7f)
@@ -175,12 +188,16 @@ struct hiddev_usage_ref_multi {
 #define HIDIOCGUSAGES		_IOWR('H', 0x13, struct hiddev_usage_ref_multi)
 #define HIDIOCSUSAGES		_IOW('H', 0x14, struct hiddev_usage_ref_multi)
 
+/* For reading all the values of a report */
+#define HIDIOCGREPORTVALUES	_IOWR('H', 0x15, struct hiddev_report_values)
+
 /* 
  * Flags to be used in HIDIOCSFLAG
  */
 #define HIDDEV_FLAG_UREF	0x1
 #define HIDDEV_FLAG_REPORT	0x2
-#define HIDDEV_FLAGS		0x3
+#define HIDDEV_FLAG_VALUES	0x4
+#define HIDDEV_FLAGS		0x7
 
 /* To traverse the input report descriptor info for a HID device, perform the 
  * following:
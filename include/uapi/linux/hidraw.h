@@ -30,6 +30,57 @@ struct hidraw_devinfo {
 	__s16 product;
 };
 
+/*
+ * Input reports can be received through a ring mapped by mmap() instead
+ * of read(), once set up with HIDIOCSRING. The mapping starts with
+ * struct hidraw_ring, and the slots follow at data_offset. The kernel
+ * advances head past each report it stores, userspace advances tail past
+ * the reports it consumed. Each slot starts with struct hidraw_ring_slot,
+ * whose len is the length of the report, which was truncated if larger
+ * than slot_size - sizeof(struct hidraw_ring_slot).
+ */
+struct hidraw_ring_setup {
+	__u32 slots;		/* number of slots, a power of two */
+	__u32 slot_size;	/* size of a slot, a multiple of 8 */
+};
+
+struct hidraw_ring {
+	__u32 head;		/* written by the kernel */
+	__u32 tail;		/* written by userspace */
+	__u32 slots;
+	__u32 slot_size;
+	__u32 data_offset;	/* offset of the first slot in the mapping */
+	__u32 dropped;		/* reports dropped because the ring was full */
+};
+
+struct hidraw_ring_slot {
+	__u32 len;
+	__u32 reserved;
+	__u8 data[];
+};
+
+/*
+ * In HIDRAW_READ_BATCH mode, read() returns as many queued reports as fit,
+ * each starting with this header and padded to a multiple of 8 bytes.
+ */
+struct hidraw_event_header {
+	__u64 timestamp;	/* CLOCK_MONOTONIC, in ns */
+	__u32 len;
+	__u32 reserved;
+};
+
+#define HIDRAW_READ_SINGLE	0	/* read() returns one bare report */
+#define HIDRAW_READ_BATCH	1
+
+/*
+ * Only receive the input reports whose ID has its bit set in ids, bit n
+ * being bit n % 8 of ids[n / 8]. Reports of devices which do not number
+ * their reports have ID 0. Setting no bit at all removes the filter.
+ */
+struct hidraw_report_filter {
+	__u8 ids[32];
+};
+
 /* ioctl interface */
 #define HIDIOCGRDESCSIZE	_IOR('H', 0x01, int)
 #define HIDIOCGRDESC		_IOR('H', 0x02, struct hidraw_report_descriptor)
@@ -46,11 +97,29 @@ struct hidraw_devinfo {
 /* The first byte of SOUTPUT and GOUTPUT is the report number */
 #define HIDIOCSOUTPUT(len)    _IOC(_IOC_WRITE|_IOC_READ, 'H', 0x0B, len)
 #define HIDIOCGOUTPUT(len)    _IOC(_IOC_WRITE|_IOC_READ, 'H', 0x0C, len)
+#define HIDIOCSRING		_IOW('H', 0x0D, struct hidraw_ring_setup)
+/* number of reports buffered for read(), a power of two */
+#define HIDIOCSBUFSIZE		_IOW('H', 0x0E, int)
+/* number of reports dropped because the buffer was full */
+#define HIDIOCGDROPPED		_IOR('H', 0x0F, __u32)
+/* HIDRAW_READ_SINGLE or HIDRAW_READ_BATCH */
+#define HIDIOCSREADMODE		_IOW('H', 0x10, int)
+#define HIDIOCSFILTER		_IOW('H', 0x11, struct hidraw_report_filter)
+/*
+ * Hand the input reports to the file descriptor passed, which must be of
+ * a kind the kernel can forward to (such as a USB HID gadget), instead of
+ * queueing them for read(). -1 stops forwarding.
+ */
+#define HIDIOCSFORWARD		_IOW('H', 0x12, int)
 
 #define HIDRAW_FIRST_MINOR 0
 #define HIDRAW_MAX_DEVICES 64
-/* number of reports to buffer */
+/* number of reports to buffer, by default and at most */
 #define HIDRAW_BUFFER_SIZE 64
+#define HIDRAW_MAX_BUFFER_SIZE 4096
+/* limits of the mmap'able ring */
+#define HIDRAW_RING_MAX_SLOTS 4096
+#define HIDRAW_RING_MAX_SIZE (16 << 20)
 
 
 /* kernel-only API declarations */
@@ -126,6 +126,80 @@ struct input_mask {
 	__u64 codes_ptr;
 };
 
+struct input_abs_rate {
+	__u32 interval_us;
+	__u32 codes_size;
+	__u64 codes_ptr;
+};
+
+/*
+ * Snapshot of the device state, see EVIOCGSTATE. Bit n of a bitmap is bit
+ * n % 32 of element n / 32. With INPUT_STATE_MT set in flags, mt_ptr points
+ * to room for mt_slots slots of INPUT_STATE_MT_CODES values each, in the
+ * order ABS_MT_TOUCH_MAJOR to ABS_MT_TOOL_Y.
+ */
+#define INPUT_STATE_MT		0x1
+#define INPUT_STATE_MT_CODES	(ABS_MT_TOOL_Y - ABS_MT_TOUCH_MAJOR + 1)
+
+struct input_state {
+	__u64 mt_ptr;
+	__u32 flags;
+	__u32 mt_slots;		/* slots at mt_ptr, set to the slots filled */
+	__u32 key[(KEY_CNT + 31) / 32];
+	__u32 led[(LED_CNT + 31) / 32];
+	__u32 sw[(SW_CNT + 31) / 32];
+	__s32 abs[ABS_CNT];	/* latest value of every axis */
+};
+
+/*
+ * Shared event ring, see EVIOCSRING. The records use a fixed 64-bit time
+ * so that the layout does not depend on the ABI of the client.
+ */
+struct input_ring {
+	__u32 head;		/* written by the kernel after each SYN_REPORT */
+	__u32 tail;		/* written by the client */
+	__u32 size;		/* number of records, a power of two */
+	__u32 data_offset;	/* offset of the first record in the mapping */
+};
+
+struct input_ring_event {
+	__s64 sec;
+	__u32 usec;
+	__u16 type;
+	__u16 code;
+	__s32 value;
+	__u32 reserved;
+};
+
+/*
+ * Records read from a merged device node, /dev/input/mergeX. It joins the
+ * input devices sharing one parent device, "source" is the index of the
+ * device the event came from, see MERGEIOCGSOURCE. The time is always
+ * CLOCK_MONOTONIC. If the driver reports where a hardware report ends,
+ * that report is delivered as one frame ended by a single SYN_REPORT
+ * from INPUT_MERGE_SOURCE_ALL, in which a source may have reported
+ * several samples in order. Otherwise, each SYN_REPORT of a source is
+ * passed on.
+ */
+struct input_merge_event {
+	__s64 sec;
+	__u32 usec;
+	__u16 type;
+	__u16 code;
+	__s32 value;
+	__u16 source;
+	__u16 reserved;
+};
+
+/* Source of SYN_REPORT and SYN_DROPPED events covering all the sources */
+#define INPUT_MERGE_SOURCE_ALL	0xffff
+
+struct input_merge_source {
+	__u32 index;
+	struct input_id id;
+	char name[64];
+};
+
 #define EVIOCGVERSION		_IOR('E', 0x01, int)			/* get driver version */
 #define EVIOCGID		_IOR('E', 0x02, struct input_id)	/* get device ID */
 #define EVIOCGREP		_IOR('E', 0x03, unsigned int[2])	/* get repeat settings */
@@ -239,6 +313,64 @@ struct input_mask {
 
 #define EVIOCSCLOCKID		_IOW('E', 0xa0, int)			/* Set clockid to be used for timestamps */
 
+/**
+ * EVIOCSABSRATE - Limit the rate of absolute axis updates
+ *
+ * This ioctl limits how often this client receives EV_ABS updates for the
+ * axes set in the bitmap at "codes_ptr", which is "codes_size" bytes large
+ * and laid out as for EVIOCSMASK. Updates to these axes that arrive less
+ * than "interval_us" microseconds after the last delivered one are
+ * coalesced: only the latest value of each axis is kept, and it is
+ * delivered in its own SYN_REPORT frame once the interval has elapsed, or
+ * earlier along with the next frame that is delivered anyway. An
+ * "interval_us" of 0 removes the limit. Other clients of the device are not
+ * affected.
+ *
+ * Multitouch axes, including ABS_MT_SLOT, cannot be limited, EINVAL is
+ * returned if any is set.
+ */
+#define EVIOCSABSRATE		_IOW('E', 0xa1, struct input_abs_rate)	/* Limit the rate of EV_ABS updates */
+
+/**
+ * EVIOCSRING - Deliver events through a shared ring
+ *
+ * The argument is the number of records of the ring, a power of two
+ * between 64 and 65536. Afterwards the client maps the ring with mmap():
+ * the mapping starts with struct input_ring, and data_offset bytes in are
+ * the struct input_ring_event records. Record n is at index
+ * n & (size - 1); head and tail only ever increase.
+ *
+ * Events are then only delivered through the ring, and read() fails with
+ * EINVAL. The kernel publishes whole frames. When the ring is full, the
+ * frame being queued is dropped and the next delivered frame starts with
+ * SYN_DROPPED, just as with read(). Events queued before the switch are
+ * dropped the same way. poll() reports EPOLLIN while the ring is not
+ * empty. The ring can be set up only once per file.
+ */
+#define EVIOCSRING		_IOW('E', 0xa2, __u32)			/* Deliver events through a shared ring */
+
+/**
+ * MERGEIOCGSOURCE - Describe a source of a merged device
+ *
+ * Fills in the id and name of the input device with the given index. Fails
+ * with ENOENT when there is no such source, so that a client can iterate
+ * from index 0. Only valid on /dev/input/mergeX nodes.
+ */
+#define MERGEIOCGSOURCE		_IOWR('E', 0xa3, struct input_merge_source)	/* Describe a merged source */
+
+/**
+ * EVIOCGSTATE - Get the whole device state at once
+ *
+ * Fills in the key, LED and switch bitmaps and the value of every axis of
+ * struct input_state, and with INPUT_STATE_MT the values of the MT slots,
+ * as one consistent snapshot. Events of these types still queued for the
+ * client are dropped, as with EVIOCGKEY, so that what is read afterwards
+ * follows the snapshot. This is meant for resyncing after SYN_DROPPED in a
+ * single call. Axis limits are not included, see EVIOCGABS. EINVAL is
+ * returned for unknown flags, or INPUT_STATE_MT on a device without slots.
+ */
+#define EVIOCGSTATE		_IOWR('E', 0xa4, struct input_state)	/* Get key, LED, switch and axis state */
+
 /*
  * IDs.
  */
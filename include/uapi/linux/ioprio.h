@@ -16,6 +16,26 @@
 	((((class) & IOPRIO_CLASS_MASK) << IOPRIO_CLASS_SHIFT) | \
 	 ((data) & IOPRIO_PRIO_MASK))
 
+/*
+ * The data of a priority is split into a level, in the low 3 bits, and a
+ * hint to the I/O schedulers, in the 10 bits above it. Hints do not change
+ * the meaning of the class and level, schedulers that do not know a hint
+ * ignore it.
+ */
+#define IOPRIO_LEVEL_NR_BITS	3
+#define IOPRIO_LEVEL_MASK	((1UL << IOPRIO_LEVEL_NR_BITS) - 1)
+#define IOPRIO_HINT_SHIFT	IOPRIO_LEVEL_NR_BITS
+#define IOPRIO_HINT_NR_BITS	10
+#define IOPRIO_HINT_MASK	((1UL << IOPRIO_HINT_NR_BITS) - 1)
+
+#define IOPRIO_PRIO_LEVEL(ioprio)	((ioprio) & IOPRIO_LEVEL_MASK)
+#define IOPRIO_PRIO_HINT(ioprio)	\
+	(((ioprio) >> IOPRIO_HINT_SHIFT) & IOPRIO_HINT_MASK)
+#define IOPRIO_PRIO_VALUE_HINT(class, level, hint)	\
+	IOPRIO_PRIO_VALUE(class, (((hint) & IOPRIO_HINT_MASK) << \
+				  IOPRIO_HINT_SHIFT) | \
+				 ((level) & IOPRIO_LEVEL_MASK))
+
 /*
  * These are the io priority groups as implemented by the BFQ and mq-deadline
  * schedulers. RT is the realtime class, it always gets premium service. For
@@ -37,6 +57,16 @@ enum {
 #define IOPRIO_NR_LEVELS	8
 #define IOPRIO_BE_NR		IOPRIO_NR_LEVELS
 
+/*
+ * I/O priority hints. INTERACTIVE marks the I/O of a foreground
+ * application a user is waiting on, such as a game streaming in assets:
+ * BFQ serves it with low latency whatever its other tunables say.
+ */
+enum {
+	IOPRIO_HINT_NONE,
+	IOPRIO_HINT_INTERACTIVE,
+};
+
 enum {
 	IOPRIO_WHO_PROCESS = 1,
 	IOPRIO_WHO_PGRP,
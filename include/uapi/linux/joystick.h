@@ -66,6 +66,22 @@ struct js_event {
 #define JSIOCSBTNMAP		_IOW('j', 0x33, __u16[KEY_MAX - BTN_MISC + 1])	/* set button mapping */
 #define JSIOCGBTNMAP		_IOR('j', 0x34, __u16[KEY_MAX - BTN_MISC + 1])	/* get button mapping */
 
+#define JSIOCGSNAPSHOT		_IOR('j', 0x41, struct js_snapshot)		/* get current state */
+
+/*
+ * Current state of all axes and buttons, see JSIOCGSNAPSHOT
+ */
+
+struct js_snapshot {
+	__u32 generation;	/* incremented with every axis or button change */
+	__u32 time;		/* timestamp of the last change in milliseconds */
+	__u8 axes;		/* number of valid entries in axis */
+	__u8 reserved;
+	__u16 buttons;		/* number of valid bits in button */
+	__s16 axis[ABS_CNT];
+	__u8 button[(KEY_MAX - BTN_MISC + 1) / 8];	/* button n is bit n % 8 of byte n / 8 */
+};
+
 /*
  * Types and constants for get/set correction
  */
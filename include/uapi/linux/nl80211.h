@@ -327,7 +327,9 @@
  *	either a dump request for all interfaces or a specific get with a
  *	single %NL80211_ATTR_IFINDEX is supported.
  * @NL80211_CMD_SET_INTERFACE: Set type of a virtual interface, requires
- *	%NL80211_ATTR_IFINDEX and %NL80211_ATTR_IFTYPE.
+ *	%NL80211_ATTR_IFINDEX and %NL80211_ATTR_IFTYPE. Can also set how scans
+ *	and off-channel work are handled while the interface carries real-time
+ *	traffic with %NL80211_ATTR_RT_SCAN_POLICY.
  * @NL80211_CMD_NEW_INTERFACE: Newly created virtual interface or response
  *	to %NL80211_CMD_GET_INTERFACE. Has %NL80211_ATTR_IFINDEX,
  *	%NL80211_ATTR_WIPHY and %NL80211_ATTR_IFTYPE attributes. Can also
@@ -1197,6 +1199,13 @@
  * @NL80211_CMD_COLOR_CHANGE_ABORTED: Notify userland, that the color change has
  *	been aborted
  *
+ * @NL80211_CMD_GET_TSF: Read the interface's TSF (%NL80211_ATTR_TSF) together
+ *	with the %CLOCK_MONOTONIC time it was read at
+ *	(%NL80211_ATTR_TSF_MONOTONIC) and the error bound of that pairing
+ *	(%NL80211_ATTR_TSF_ERROR), for synchronizing to the radio clock.
+ *	The same TSF is reported as the hardware RX timestamp of received
+ *	frames once enabled with %SIOCSHWTSTAMP on the interface.
+ *
  * @NL80211_CMD_COLOR_CHANGE_COMPLETED: Notify userland that the color change
  *	has completed
  *
@@ -1440,6 +1449,8 @@ enum nl80211_commands {
 	NL80211_CMD_COLOR_CHANGE_ABORTED,
 	NL80211_CMD_COLOR_CHANGE_COMPLETED,
 
+	NL80211_CMD_GET_TSF,
+
 	/* add new commands above here */
 
 	/* used to define NL80211_CMD_MAX below */
@@ -2593,6 +2604,32 @@ enum nl80211_commands {
  * @NL80211_ATTR_COLOR_CHANGE_ELEMS: Nested set of attributes containing the IE
  *	information for the time while performing a color switch.
  *
+ * @NL80211_ATTR_AIRTIME_LATENCY_CRITICAL: u8 attribute, set to 1 to have the
+ *	airtime scheduler serve the station ahead of the weighted fair order,
+ *	within a capped airtime budget, 0 to return it to the normal order;
+ *	used with %NL80211_CMD_SET_STATION and %NL80211_CMD_NEW_STATION.
+ *	Requires %NL80211_EXT_FEATURE_AIRTIME_FAIRNESS.
+ *
+ * @NL80211_ATTR_TSF: TSF of the interface in usec (u64), see
+ *	%NL80211_CMD_GET_TSF
+ * @NL80211_ATTR_TSF_MONOTONIC: %CLOCK_MONOTONIC time in nsec (u64) at which
+ *	%NL80211_ATTR_TSF was read
+ * @NL80211_ATTR_TSF_ERROR: maximum error in nsec (u32) between the two, the
+ *	read is bracketed by two system clock reads and the midpoint is used
+ *
+ * @NL80211_ATTR_RT_SCAN_POLICY: u32 attribute with a value from
+ *	&enum nl80211_rt_scan_policy, marks an interface as carrying real-time
+ *	traffic and selects what happens to scans while it is up; used with
+ *	%NL80211_CMD_SET_INTERFACE and reported by %NL80211_CMD_GET_INTERFACE.
+ *
+ * @NL80211_ATTR_PS_LOWLAT_TIDS: u8 bitmap of the TIDs on which a power saving
+ *	station receives a periodic, latency-critical stream; 0 clears the
+ *	policy. Used with %NL80211_CMD_SET_STATION and %NL80211_CMD_NEW_STATION
+ *	for associated stations of an AP or P2P GO, requires
+ *	%NL80211_EXT_FEATURE_PS_LOWLAT_DELIVERY.
+ * @NL80211_ATTR_PS_LOWLAT_INTERVAL: u32 attribute with the period of that
+ *	stream in usec, required with a non-zero %NL80211_ATTR_PS_LOWLAT_TIDS.
+ *
  * @NUM_NL80211_ATTR: total number of nl80211_attrs available
  * @NL80211_ATTR_MAX: highest attribute number currently defined
  * @__NL80211_ATTR_AFTER_LAST: internal use
@@ -3096,6 +3133,17 @@ enum nl80211_attrs {
 	NL80211_ATTR_COLOR_CHANGE_COLOR,
 	NL80211_ATTR_COLOR_CHANGE_ELEMS,
 
+	NL80211_ATTR_AIRTIME_LATENCY_CRITICAL,
+
+	NL80211_ATTR_TSF,
+	NL80211_ATTR_TSF_MONOTONIC,
+	NL80211_ATTR_TSF_ERROR,
+
+	NL80211_ATTR_RT_SCAN_POLICY,
+
+	NL80211_ATTR_PS_LOWLAT_TIDS,
+	NL80211_ATTR_PS_LOWLAT_INTERVAL,
+
 	/* add attributes here, update the policy in nl80211.c */
 
 	__NL80211_ATTR_AFTER_LAST,
@@ -5093,6 +5141,14 @@ enum nl80211_tx_rate_setting {
  *	with the parameters passed through %NL80211_ATTR_TX_RATES.
  *	configuration is applied to the data frame for the tid to that connected
  *	station.
+ * @NL80211_TID_CONFIG_ATTR_AMPDU_MAX_LEN: Maximum length in bytes (u32) of
+ *	an A-MPDU built for the TIDs specified in %NL80211_TID_CONFIG_ATTR_TIDS,
+ *	0 for no limit beyond the ones the device and the peer impose.
+ * @NL80211_TID_CONFIG_ATTR_AMPDU_MAX_DURATION: Maximum airtime in usec (u16)
+ *	of such an A-MPDU at the selected rate, 0 for no limit.
+ * @NL80211_TID_CONFIG_ATTR_AMPDU_MAX_DELAY: Maximum time in usec (u16) the
+ *	driver may hold frames of these TIDs back to build a larger A-MPDU,
+ *	0 for no limit.
  */
 enum nl80211_tid_config_attr {
 	__NL80211_TID_CONFIG_ATTR_INVALID,
@@ -5109,6 +5165,9 @@ enum nl80211_tid_config_attr {
 	NL80211_TID_CONFIG_ATTR_AMSDU_CTRL,
 	NL80211_TID_CONFIG_ATTR_TX_RATE_TYPE,
 	NL80211_TID_CONFIG_ATTR_TX_RATE,
+	NL80211_TID_CONFIG_ATTR_AMPDU_MAX_LEN,
+	NL80211_TID_CONFIG_ATTR_AMPDU_MAX_DURATION,
+	NL80211_TID_CONFIG_ATTR_AMPDU_MAX_DELAY,
 
 	/* keep last */
 	__NL80211_TID_CONFIG_ATTR_AFTER_LAST,
@@ -5994,6 +6053,11 @@ enum nl80211_feature_flags {
  *
  * @NL80211_EXT_FEATURE_BSS_COLOR: The driver supports BSS color collision
  *	detection and change announcemnts.
+ * @NL80211_EXT_FEATURE_PS_LOWLAT_DELIVERY: The driver supports the power save
+ *	delivery policy set with %NL80211_ATTR_PS_LOWLAT_TIDS: when a U-APSD
+ *	trigger finds none of those frames buffered but the next one is due
+ *	within the stream period, the service period is kept open, and the
+ *	station awake, until it is queued.
  *
  * @NUM_NL80211_EXT_FEATURES: number of extended features.
  * @MAX_NL80211_EXT_FEATURES: highest extended feature index.
@@ -6060,6 +6124,7 @@ enum nl80211_ext_feature_index {
 	NL80211_EXT_FEATURE_SECURE_RTT,
 	NL80211_EXT_FEATURE_PROT_RANGE_NEGO_AND_MEASURE,
 	NL80211_EXT_FEATURE_BSS_COLOR,
+	NL80211_EXT_FEATURE_PS_LOWLAT_DELIVERY,
 
 	/* add new features before the definition below */
 	NUM_NL80211_EXT_FEATURES,
@@ -6195,6 +6260,26 @@ enum nl80211_scan_flags {
 	NL80211_SCAN_FLAG_COLOCATED_6GHZ			= 1<<14,
 };
 
+/**
+ * enum nl80211_rt_scan_policy - scanning with real-time traffic
+ *
+ * Set on an interface with %NL80211_ATTR_RT_SCAN_POLICY, the strictest
+ * policy of all running interfaces of a wiphy applies.
+ *
+ * @NL80211_RT_SCAN_ALLOW: no real-time traffic, scan normally (default)
+ * @NL80211_RT_SCAN_SPLIT: scans leave the operating channel for a single
+ *	channel at a time and wait for pending frames to go out before each
+ *	dwell, offloaded scans are requested with %NL80211_SCAN_FLAG_LOW_SPAN
+ *	if supported. Remain-on-channel is shortened and rate-limited.
+ * @NL80211_RT_SCAN_REFUSE: as %NL80211_RT_SCAN_SPLIT, but scan and scheduled
+ *	scan requests are refused with -EBUSY
+ */
+enum nl80211_rt_scan_policy {
+	NL80211_RT_SCAN_ALLOW,
+	NL80211_RT_SCAN_SPLIT,
+	NL80211_RT_SCAN_REFUSE,
+};
+
 /**
  * enum nl80211_acl_policy - access control policy
  *
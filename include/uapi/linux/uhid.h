@@ -40,6 +40,9 @@ enum uhid_event_type {
 	UHID_INPUT2,
 	UHID_SET_REPORT,
 	UHID_SET_REPORT_REPLY,
+	UHID_INPUT2_BATCH,
+	UHID_INPUT2_TS,
+	UHID_RING_SETUP,
 };
 
 struct uhid_create2_req {
@@ -78,6 +81,81 @@ struct uhid_input2_req {
 	__u8 data[UHID_DATA_MAX];
 } __attribute__((__packed__));
 
+/*
+ * UHID_INPUT2_BATCH carries several input reports in one write(). "data"
+ * holds "size" bytes of back-to-back records, each a native-endian __u16
+ * report length followed by that many bytes of report data. Records are
+ * not padded or aligned.
+ */
+struct uhid_input2_batch_req {
+	__u16 size;
+	__u8 data[UHID_DATA_MAX];
+} __attribute__((__packed__));
+
+/*
+ * UHID_INPUT2_TS is UHID_INPUT2 with the CLOCK_MONOTONIC time, in
+ * nanoseconds, at which the report was sampled. It is used as the input
+ * event and hidraw timestamp. Times in the future are clamped to the
+ * current time, 0 means the report is timestamped on arrival.
+ */
+struct uhid_input2_ts_req {
+	__u64 timestamp;
+	__u16 size;
+	__u8 data[UHID_DATA_MAX];
+} __attribute__((__packed__));
+
+/*
+ * UHID_RING_SETUP creates a pair of rings, mapped with mmap() on the uhid fd.
+ * The mapping starts with one page holding struct uhid_ring_header. Input
+ * reports are written to the input ring by user-space, which then signals the
+ * eventfd "kick_fd". UHID_OUTPUT events are written to the output ring by the
+ * kernel instead of being queued for read(), and poll() reports EPOLLIN while
+ * it is not empty. All other events are still delivered through read().
+ *
+ * Each ring is a power of two of slots, each slot_size bytes large and
+ * starting with struct uhid_ring_slot. "head" is only written by the
+ * producer, "tail" only by the consumer, and both only ever increase; the
+ * slot of an index is index & (slots - 1). A full output ring makes the
+ * output request fail and increments "dropped".
+ */
+struct uhid_ring_setup_req {
+	__u32 in_slots;
+	__u32 in_slot_size;
+	__u32 out_slots;
+	__u32 out_slot_size;
+	__s32 kick_fd;
+} __attribute__((__packed__));
+
+struct uhid_ring {
+	__u32 head;
+	__u32 tail;
+	__u32 slots;
+	__u32 slot_size;
+	__u32 data_offset;	/* offset of the first slot in the mapping */
+	__u32 dropped;
+};
+
+struct uhid_ring_header {
+	struct uhid_ring in;
+	struct uhid_ring out;
+};
+
+/*
+ * "timestamp" is the CLOCK_MONOTONIC sample time in nanoseconds, see
+ * UHID_INPUT2_TS, and is set by the kernel on output. "rtype" is the
+ * UHID_*_REPORT type of an output report and ignored on input.
+ */
+struct uhid_ring_slot {
+	__u64 timestamp;
+	__u16 size;
+	__u8 rtype;
+	__u8 reserved[5];
+	__u8 data[];
+};
+
+#define UHID_RING_MAX_SLOTS	4096
+#define UHID_RING_MAX_SIZE	(16 << 20)
+
 struct uhid_output_req {
 	__u8 data[UHID_DATA_MAX];
 	__u16 size;
@@ -191,6 +269,9 @@ struct uhid_event {
 		struct uhid_get_report_reply_req get_report_reply;
 		struct uhid_create2_req create2;
 		struct uhid_input2_req input2;
+		struct uhid_input2_batch_req input2_batch;
+		struct uhid_input2_ts_req input2_ts;
+		struct uhid_ring_setup_req ring_setup;
 		struct uhid_set_report_req set_report;
 		struct uhid_set_report_reply_req set_report_reply;
 		struct uhid_start_req start;
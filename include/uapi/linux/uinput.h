@@ -151,6 +151,20 @@ struct uinput_abs_setup {
 #define UI_BEGIN_FF_ERASE	_IOWR(UINPUT_IOCTL_BASE, 202, struct uinput_ff_erase)
 #define UI_END_FF_ERASE		_IOW(UINPUT_IOCTL_BASE, 203, struct uinput_ff_erase)
 
+/**
+ * UI_SET_FF_ASYNC - acknowledge effect uploads without waiting
+ *
+ * With a non-zero argument, effect uploads return as soon as they are
+ * queued to userspace instead of waiting for UI_END_FF_UPLOAD, so that
+ * EVIOCSFF does not block on the uinput client. Uploads of an effect that
+ * userspace has not begun handling yet are merged, UI_BEGIN_FF_UPLOAD
+ * returns the latest parameters, and "old" those returned by the previous
+ * UI_BEGIN_FF_UPLOAD of the effect. The retval given to UI_END_FF_UPLOAD is
+ * ignored. Erasing effects still waits for userspace. Must be issued before
+ * UI_DEV_CREATE.
+ */
+#define UI_SET_FF_ASYNC		_IOW(UINPUT_IOCTL_BASE, 204, int)
+
 /**
  * UI_GET_SYSNAME - get the sysfs name of the created uinput device
  *
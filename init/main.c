@@ -1637,4 +1637,5 @@ static noinline void __init kernel_init_freeable(void)
 	 */
 
 	integrity_load_keys();
+	boot_preload();
 }
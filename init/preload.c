@@ -0,0 +1,138 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * init/preload.c - preload firmware and modules once the root is mounted
+ *
+ * Drivers that request their firmware at probe time and modules loaded
+ * from hotplug events each wait for the filesystem in turn. The images
+ * and modules listed with
+ *
+ *   preload_firmware=ath9k_htc/htc_9271-1.4.0.fw,rtl_bt/rtl8761b_fw.bin
+ *   preload_modules=btusb,hid-nintendo
+ *
+ * are all started at once as soon as the root filesystem is mounted.
+ * Both may be given more than once, so the lists can also be kept in the
+ * "kernel" section of a boot config file.
+ *
+ * Firmware is read on the unbound workqueue and held for PRELOAD_FW_HOLD.
+ * A request_firmware() of the same name meanwhile, even one racing with
+ * the preload, gets the image from the firmware cache rather than from
+ * the filesystem. Modules are loaded with request_module_nowait().
+ */
+
+#define pr_fmt(fmt) "preload: " fmt
+
+#include <linux/firmware.h>
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/kmod.h>
+#include <linux/list.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/workqueue.h>
+
+#define PRELOAD_MAX_ARGS	16
+#define PRELOAD_FW_HOLD		(60 * HZ)
+
+struct preload_fw {
+	struct work_struct work;
+	struct list_head list;
+	const struct firmware *fw;
+	char name[];
+};
+
+static char *preload_fw_args[PRELOAD_MAX_ARGS] __initdata;
+static unsigned int preload_fw_nr_args __initdata;
+static char *preload_mod_args[PRELOAD_MAX_ARGS] __initdata;
+static unsigned int preload_mod_nr_args __initdata;
+
+/* only changed before the release work is queued */
+static LIST_HEAD(preload_fw_list);
+
+static int __init preload_firmware_setup(char *str)
+{
+	if (preload_fw_nr_args < PRELOAD_MAX_ARGS)
+		preload_fw_args[preload_fw_nr_args++] = str;
+	else
+		pr_warn("too many preload_firmware= lists, ignoring %s\n", str);
+	return 1;
+}
+__setup("preload_firmware=", preload_firmware_setup);
+
+static int __init preload_modules_setup(char *str)
+{
+	if (preload_mod_nr_args < PRELOAD_MAX_ARGS)
+		preload_mod_args[preload_mod_nr_args++] = str;
+	else
+		pr_warn("too many preload_modules= lists, ignoring %s\n", str);
+	return 1;
+}
+__setup("preload_modules=", preload_modules_setup);
+
+static void preload_fw_work(struct work_struct *work)
+{
+	struct preload_fw *p = container_of(work, struct preload_fw, work);
+
+	if (request_firmware_direct(&p->fw, p->name, NULL)) {
+		pr_info("firmware %s not found\n", p->name);
+		p->fw = NULL;
+	}
+}
+
+static void preload_fw_release(struct work_struct *work)
+{
+	struct preload_fw *p, *tmp;
+
+	list_for_each_entry_safe(p, tmp, &preload_fw_list, list) {
+		flush_work(&p->work);
+		release_firmware(p->fw);
+		list_del(&p->list);
+		kfree(p);
+	}
+}
+static DECLARE_DELAYED_WORK(preload_fw_release_work, preload_fw_release);
+
+static void __init preload_firmware(char *names)
+{
+	struct preload_fw *p;
+	char *name;
+
+	while ((name = strsep(&names, ",")) != NULL) {
+		if (!*name)
+			continue;
+
+		p = kzalloc(struct_size(p, name, strlen(name) + 1), GFP_KERNEL);
+		if (!p)
+			return;
+		strcpy(p->name, name);
+		INIT_WORK(&p->work, preload_fw_work);
+		list_add_tail(&p->list, &preload_fw_list);
+		queue_work(system_unbound_wq, &p->work);
+	}
+}
+
+static void __init preload_modules(char *names)
+{
+	char *name;
+
+	while ((name = strsep(&names, ",")) != NULL) {
+		if (*name)
+			request_module_nowait("%s", name);
+	}
+}
+
+/*
+ * Called from kernel_init_freeable() once the root filesystem is mounted,
+ * or the initramfs is unpacked when it brings its own init.
+ */
+void __init boot_preload(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < preload_fw_nr_args; i++)
+		preload_firmware(preload_fw_args[i]);
+	if (!list_empty(&preload_fw_list))
+		schedule_delayed_work(&preload_fw_release_work, PRELOAD_FW_HOLD);
+
+	for (i = 0; i < preload_mod_nr_args; i++)
+		preload_modules(preload_mod_args[i]);
+}
@@ -383,6 +383,11 @@ void dma_direct_sync_sg_for_device(struct device *dev,
 	for_each_sg(sgl, sg, nents, i) {
 		phys_addr_t paddr = dma_to_phys(dev, sg_dma_address(sg));
 
+		if (unlikely(is_dma_small_buffer(paddr))) {
+			dma_small_sync_for_device(paddr, sg->length, dir);
+			continue;
+		}
+
 		if (unlikely(is_swiotlb_buffer(dev, paddr)))
 			swiotlb_sync_single_for_device(dev, paddr, sg->length,
 						       dir);
@@ -406,6 +411,11 @@ void dma_direct_sync_sg_for_cpu(struct device *dev,
 	for_each_sg(sgl, sg, nents, i) {
 		phys_addr_t paddr = dma_to_phys(dev, sg_dma_address(sg));
 
+		if (unlikely(is_dma_small_buffer(paddr))) {
+			dma_small_sync_for_cpu(paddr, sg->length, dir);
+			continue;
+		}
+
 		if (!dev_is_dma_coherent(dev))
 			arch_sync_dma_for_cpu(paddr, sg->length, dir);
 
@@ -51,11 +51,54 @@ static inline void dma_direct_sync_sg_for_cpu(struct device *dev,
 }
 #endif
 
+#ifdef CONFIG_DMA_SMALL_POOL
+#define DMA_SMALL_SLOT_SIZE	256
+
+bool is_dma_small_buffer(phys_addr_t paddr);
+dma_addr_t dma_small_map(struct device *dev, phys_addr_t orig, size_t size,
+		enum dma_data_direction dir);
+void dma_small_unmap(phys_addr_t paddr, size_t size,
+		enum dma_data_direction dir, unsigned long attrs);
+void dma_small_sync_for_device(phys_addr_t paddr, size_t size,
+		enum dma_data_direction dir);
+void dma_small_sync_for_cpu(phys_addr_t paddr, size_t size,
+		enum dma_data_direction dir);
+#else
+#define DMA_SMALL_SLOT_SIZE	0
+
+static inline bool is_dma_small_buffer(phys_addr_t paddr)
+{
+	return false;
+}
+static inline dma_addr_t dma_small_map(struct device *dev, phys_addr_t orig,
+		size_t size, enum dma_data_direction dir)
+{
+	return DMA_MAPPING_ERROR;
+}
+static inline void dma_small_unmap(phys_addr_t paddr, size_t size,
+		enum dma_data_direction dir, unsigned long attrs)
+{
+}
+static inline void dma_small_sync_for_device(phys_addr_t paddr, size_t size,
+		enum dma_data_direction dir)
+{
+}
+static inline void dma_small_sync_for_cpu(phys_addr_t paddr, size_t size,
+		enum dma_data_direction dir)
+{
+}
+#endif /* CONFIG_DMA_SMALL_POOL */
+
 static inline void dma_direct_sync_single_for_device(struct device *dev,
 		dma_addr_t addr, size_t size, enum dma_data_direction dir)
 {
 	phys_addr_t paddr = dma_to_phys(dev, addr);
 
+	if (unlikely(is_dma_small_buffer(paddr))) {
+		dma_small_sync_for_device(paddr, size, dir);
+		return;
+	}
+
 	if (unlikely(is_swiotlb_buffer(dev, paddr)))
 		swiotlb_sync_single_for_device(dev, paddr, size, dir);
 
@@ -68,6 +111,11 @@ static inline void dma_direct_sync_single_for_cpu(struct device *dev,
 {
 	phys_addr_t paddr = dma_to_phys(dev, addr);
 
+	if (unlikely(is_dma_small_buffer(paddr))) {
+		dma_small_sync_for_cpu(paddr, size, dir);
+		return;
+	}
+
 	if (!dev_is_dma_coherent(dev)) {
 		arch_sync_dma_for_cpu(paddr, size, dir);
 		arch_sync_dma_for_cpu_all();
@@ -100,8 +148,17 @@ static inline dma_addr_t dma_direct_map_page(struct device *dev,
 		return DMA_MAPPING_ERROR;
 	}
 
-	if (!dev_is_dma_coherent(dev) && !(attrs & DMA_ATTR_SKIP_CPU_SYNC))
+	if (!dev_is_dma_coherent(dev) && !(attrs & DMA_ATTR_SKIP_CPU_SYNC)) {
+		/* slots don't keep the low address bits a device may need */
+		if (size <= DMA_SMALL_SLOT_SIZE && !PageHighMem(page) &&
+		    !dma_get_min_align_mask(dev)) {
+			dma_addr_t small = dma_small_map(dev, phys, size, dir);
+
+			if (small != DMA_MAPPING_ERROR)
+				return small;
+		}
 		arch_sync_dma_for_device(phys, size, dir);
+	}
 	return dma_addr;
 }
 
@@ -110,6 +167,11 @@ static inline void dma_direct_unmap_page(struct device *dev, dma_addr_t addr,
 {
 	phys_addr_t phys = dma_to_phys(dev, addr);
 
+	if (unlikely(is_dma_small_buffer(phys))) {
+		dma_small_unmap(phys, size, dir, attrs);
+		return;
+	}
+
 	if (!(attrs & DMA_ATTR_SKIP_CPU_SYNC))
 		dma_direct_sync_single_for_cpu(dev, addr, size, dir);
 
@@ -0,0 +1,219 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Bounce small streaming mappings of non-coherent devices through an
+ * uncached pool.
+ *
+ * Mapping a few bytes for a non-coherent device costs a cache clean or
+ * flush of their lines, and with partial lines the neighbouring data is
+ * written back or invalidated along with them. Mappings of up to
+ * DMA_SMALL_SLOT_SIZE bytes are instead copied to a slot of a pool of
+ * uncached memory set aside at boot, and the device is given the slot.
+ * Neither the map nor the unmap does any cache maintenance then, only the
+ * copy in the direction of the transfer. When the pool is exhausted or out
+ * of reach of the device, the mapping falls back to the usual path.
+ */
+#include <linux/bitmap.h>
+#include <linux/debugfs.h>
+#include <linux/dma-map-ops.h>
+#include <linux/init.h>
+#include <linux/mm.h>
+#include <linux/slab.h>
+#include <linux/spinlock.h>
+#include <linux/vmalloc.h>
+#include "direct.h"
+
+struct dma_small_slot {
+	phys_addr_t orig;
+	size_t size;
+};
+
+static unsigned int dma_small_nslots = 256;
+
+static phys_addr_t dma_small_start;
+static phys_addr_t dma_small_end;
+static void *dma_small_vaddr;
+
+/* protects dma_small_used and dma_small_next */
+static DEFINE_SPINLOCK(dma_small_lock);
+static unsigned long *dma_small_used;
+static unsigned int dma_small_next;
+static struct dma_small_slot *dma_small_slots;
+
+static unsigned long dma_small_maps;
+static unsigned long dma_small_misses;
+
+static int __init early_dma_small(char *p)
+{
+	return kstrtouint(p, 0, &dma_small_nslots);
+}
+early_param("dma_small_slots", early_dma_small);
+
+bool is_dma_small_buffer(phys_addr_t paddr)
+{
+	return paddr >= dma_small_start && paddr < dma_small_end;
+}
+
+static void *dma_small_slot_vaddr(unsigned int i)
+{
+	return dma_small_vaddr + i * DMA_SMALL_SLOT_SIZE;
+}
+
+static unsigned int dma_small_index(phys_addr_t paddr)
+{
+	return (paddr - dma_small_start) / DMA_SMALL_SLOT_SIZE;
+}
+
+/*
+ * Returns the bus address of a slot holding a copy of @orig, or
+ * DMA_MAPPING_ERROR when the caller has to map @orig itself. @orig must
+ * be in lowmem.
+ */
+dma_addr_t dma_small_map(struct device *dev, phys_addr_t orig, size_t size,
+		enum dma_data_direction dir)
+{
+	phys_addr_t paddr;
+	dma_addr_t dma_addr;
+	unsigned long flags;
+	unsigned int i;
+
+	if (!dma_small_used ||
+	    !dma_capable(dev, phys_to_dma(dev, dma_small_start),
+			 dma_small_end - dma_small_start, true))
+		return DMA_MAPPING_ERROR;
+
+	spin_lock_irqsave(&dma_small_lock, flags);
+	i = find_next_zero_bit(dma_small_used, dma_small_nslots,
+			       dma_small_next);
+	if (i >= dma_small_nslots)
+		i = find_first_zero_bit(dma_small_used, dma_small_nslots);
+	if (i >= dma_small_nslots) {
+		dma_small_misses++;
+		spin_unlock_irqrestore(&dma_small_lock, flags);
+		return DMA_MAPPING_ERROR;
+	}
+	__set_bit(i, dma_small_used);
+	dma_small_next = i + 1;
+	dma_small_maps++;
+	spin_unlock_irqrestore(&dma_small_lock, flags);
+
+	dma_small_slots[i].orig = orig;
+	dma_small_slots[i].size = size;
+
+	paddr = dma_small_start + i * DMA_SMALL_SLOT_SIZE;
+	dma_addr = phys_to_dma(dev, paddr);
+
+	if (dir == DMA_TO_DEVICE || dir == DMA_BIDIRECTIONAL)
+		memcpy(dma_small_slot_vaddr(i), phys_to_virt(orig), size);
+
+	return dma_addr;
+}
+
+void dma_small_sync_for_device(phys_addr_t paddr, size_t size,
+		enum dma_data_direction dir)
+{
+	unsigned int i = dma_small_index(paddr);
+	unsigned long offset = paddr - dma_small_start - i * DMA_SMALL_SLOT_SIZE;
+
+	if (WARN_ON_ONCE(offset + size > dma_small_slots[i].size))
+		return;
+
+	if (dir == DMA_TO_DEVICE || dir == DMA_BIDIRECTIONAL)
+		memcpy(dma_small_slot_vaddr(i) + offset,
+		       phys_to_virt(dma_small_slots[i].orig + offset), size);
+}
+
+void dma_small_sync_for_cpu(phys_addr_t paddr, size_t size,
+		enum dma_data_direction dir)
+{
+	unsigned int i = dma_small_index(paddr);
+	unsigned long offset = paddr - dma_small_start - i * DMA_SMALL_SLOT_SIZE;
+
+	if (WARN_ON_ONCE(offset + size > dma_small_slots[i].size))
+		return;
+
+	if (dir == DMA_FROM_DEVICE || dir == DMA_BIDIRECTIONAL)
+		memcpy(phys_to_virt(dma_small_slots[i].orig + offset),
+		       dma_small_slot_vaddr(i) + offset, size);
+}
+
+void dma_small_unmap(phys_addr_t paddr, size_t size,
+		enum dma_data_direction dir, unsigned long attrs)
+{
+	unsigned int i = dma_small_index(paddr);
+	unsigned long flags;
+
+	if (!(attrs & DMA_ATTR_SKIP_CPU_SYNC))
+		dma_small_sync_for_cpu(paddr, size, dir);
+
+	spin_lock_irqsave(&dma_small_lock, flags);
+	__clear_bit(i, dma_small_used);
+	spin_unlock_irqrestore(&dma_small_lock, flags);
+}
+
+static int dma_small_show(struct seq_file *m, void *v)
+{
+	unsigned long flags;
+	unsigned int used;
+
+	spin_lock_irqsave(&dma_small_lock, flags);
+	used = bitmap_weight(dma_small_used, dma_small_nslots);
+	spin_unlock_irqrestore(&dma_small_lock, flags);
+
+	seq_printf(m, "slots:  %u x %u\n", dma_small_nslots,
+		   DMA_SMALL_SLOT_SIZE);
+	seq_printf(m, "used:   %u\n", used);
+	seq_printf(m, "maps:   %lu\n", READ_ONCE(dma_small_maps));
+	seq_printf(m, "misses: %lu\n", READ_ONCE(dma_small_misses));
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(dma_small);
+
+static int __init dma_small_init(void)
+{
+	size_t size = dma_small_nslots * DMA_SMALL_SLOT_SIZE;
+	struct dma_small_slot *slots;
+	unsigned long *used;
+	struct page *page;
+	void *vaddr;
+
+	if (!size)
+		return 0;
+
+	page = alloc_pages(GFP_KERNEL, get_order(size));
+	if (!page)
+		goto err;
+
+	arch_dma_prep_coherent(page, size);
+	vaddr = dma_common_contiguous_remap(page, size,
+					    pgprot_dmacoherent(PAGE_KERNEL),
+					    __builtin_return_address(0));
+	if (!vaddr)
+		goto free_page;
+
+	used = bitmap_zalloc(dma_small_nslots, GFP_KERNEL);
+	slots = kcalloc(dma_small_nslots, sizeof(*slots), GFP_KERNEL);
+	if (!used || !slots)
+		goto free_all;
+
+	dma_small_slots = slots;
+	dma_small_vaddr = vaddr;
+	dma_small_start = page_to_phys(page);
+	dma_small_end = dma_small_start + size;
+	dma_small_used = used;
+
+	debugfs_create_file("dma_small", 0400, NULL, NULL, &dma_small_fops);
+	pr_info("DMA: %u small buffer slots of %u bytes\n", dma_small_nslots,
+		DMA_SMALL_SLOT_SIZE);
+	return 0;
+
+free_all:
+	kfree(slots);
+	bitmap_free(used);
+	dma_common_free_remap(vaddr, size);
+free_page:
+	__free_pages(page, get_order(size));
+err:
+	pr_err("DMA: failed to set up the small buffer pool\n");
+	return -ENOMEM;
+}
+postcore_initcall(dma_small_init);
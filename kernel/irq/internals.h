@@ -129,6 +129,11 @@ static inline void unregister_handler_proc(unsigned int irq,
 extern bool irq_can_set_affinity_usr(unsigned int irq);
 
 extern void irq_set_thread_affinity(struct irq_desc *desc);
+extern int irq_set_thread_priority(struct irq_desc *desc, unsigned int prio);
+#ifdef CONFIG_SMP
+extern int irq_set_thread_affinity_mask(struct irq_desc *desc,
+					const struct cpumask *mask);
+#endif
 
 extern int irq_do_set_affinity(struct irq_data *data,
 			       const struct cpumask *dest, bool force);
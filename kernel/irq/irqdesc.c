@@ -88,6 +88,8 @@ static void desc_smp_init(struct irq_desc *desc, int node,
 #ifdef CONFIG_GENERIC_PENDING_IRQ
 	cpumask_clear(desc->pending_mask);
 #endif
+	if (desc->thread_affinity)
+		cpumask_clear(desc->thread_affinity);
 #ifdef CONFIG_NUMA
 	desc->irq_common_data.node = node;
 #endif
@@ -120,6 +122,7 @@ static void desc_set_defaults(unsigned int irq, struct irq_desc *desc, int node,
 	desc->irq_count = 0;
 	desc->irqs_unhandled = 0;
 	desc->tot_count = 0;
+	desc->thread_prio = 0;
 	desc->name = NULL;
 	desc->owner = owner;
 	for_each_possible_cpu(cpu)
@@ -371,6 +374,7 @@ static void free_masks(struct irq_desc *desc)
 #ifdef CONFIG_GENERIC_IRQ_EFFECTIVE_AFF_MASK
 	free_cpumask_var(desc->irq_common_data.effective_affinity);
 #endif
+	kfree(desc->thread_affinity);
 }
 #else
 static inline void free_masks(struct irq_desc *desc) { }
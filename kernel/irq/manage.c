@@ -1141,7 +1141,11 @@ irq_thread_check_affinity(struct irq_desc *desc, struct irqaction *action)
 	 * This code is triggered unconditionally. Check the affinity
 	 * mask pointer. For CPU_MASK_OFFSTACK=n this is optimized out.
 	 */
-	if (cpumask_available(desc->irq_common_data.affinity)) {
+	if (desc->thread_affinity &&
+	    cpumask_intersects(desc->thread_affinity, cpu_online_mask)) {
+		/* set through /proc/irq/<irq>/thread_affinity_list */
+		cpumask_copy(mask, desc->thread_affinity);
+	} else if (cpumask_available(desc->irq_common_data.affinity)) {
 		const struct cpumask *m;
 
 		m = irq_data_get_effective_affinity_mask(&desc->irq_data);
@@ -1155,11 +1159,96 @@ irq_thread_check_affinity(struct irq_desc *desc, struct irqaction *action)
 		set_cpus_allowed_ptr(current, mask);
 	free_cpumask_var(mask);
 }
+
+/*
+ * Pin the handler threads of @desc to @mask, independently of the hard
+ * irq affinity. An empty mask makes them follow the irq again.
+ */
+int irq_set_thread_affinity_mask(struct irq_desc *desc,
+				 const struct cpumask *mask)
+{
+	struct cpumask *m;
+	unsigned long flags;
+
+	if (!cpumask_empty(mask) && !cpumask_intersects(mask, cpu_online_mask))
+		return -EINVAL;
+
+	mutex_lock(&desc->request_mutex);
+	if (!desc->thread_affinity) {
+		m = kzalloc(cpumask_size(), GFP_KERNEL);
+		if (!m) {
+			mutex_unlock(&desc->request_mutex);
+			return -ENOMEM;
+		}
+		raw_spin_lock_irqsave(&desc->lock, flags);
+		desc->thread_affinity = m;
+		raw_spin_unlock_irqrestore(&desc->lock, flags);
+	}
+
+	raw_spin_lock_irqsave(&desc->lock, flags);
+	cpumask_copy(desc->thread_affinity, mask);
+	irq_set_thread_affinity(desc);
+	raw_spin_unlock_irqrestore(&desc->lock, flags);
+	mutex_unlock(&desc->request_mutex);
+
+	return 0;
+}
 #else
 static inline void
 irq_thread_check_affinity(struct irq_desc *desc, struct irqaction *action) { }
 #endif
 
+/*
+ * SCHED_FIFO priority for the threads of @action: the one set through
+ * /proc/irq/<irq>/thread_priority, else the class the driver asked for,
+ * else the default.
+ */
+static int irq_thread_priority(struct irq_desc *desc, struct irqaction *action)
+{
+	if (desc->thread_prio)
+		return desc->thread_prio;
+	if (action->flags & IRQF_THREAD_INPUT)
+		return IRQ_THREAD_PRIO_INPUT;
+	if (action->flags & IRQF_THREAD_AUDIO)
+		return IRQ_THREAD_PRIO_AUDIO;
+	if (action->flags & IRQF_THREAD_STORAGE)
+		return IRQ_THREAD_PRIO_STORAGE;
+	return MAX_RT_PRIO / 2;
+}
+
+static void irq_thread_set_priority(struct task_struct *t, int prio)
+{
+	struct sched_param param = { .sched_priority = prio };
+
+	sched_setscheduler_nocheck(t, SCHED_FIFO, &param);
+}
+
+/*
+ * Set the priority of the handler threads of @desc. 0 goes back to the
+ * priority of the driver's class, or the default.
+ */
+int irq_set_thread_priority(struct irq_desc *desc, unsigned int prio)
+{
+	struct irqaction *action;
+	int p;
+
+	if (prio >= MAX_RT_PRIO)
+		return -EINVAL;
+
+	mutex_lock(&desc->request_mutex);
+	desc->thread_prio = prio;
+	for_each_action_of_desc(desc, action) {
+		p = irq_thread_priority(desc, action);
+		if (action->thread)
+			irq_thread_set_priority(action->thread, p);
+		if (action->secondary && action->secondary->thread)
+			irq_thread_set_priority(action->secondary->thread, p);
+	}
+	mutex_unlock(&desc->request_mutex);
+
+	return 0;
+}
+
 /*
  * Interrupts which are not explicitly requested as threaded
  * interrupts rely on the implicit bh/preempt disable of the hard irq
@@ -1350,6 +1439,7 @@ static int irq_setup_forced_threading(struct irqaction *new)
 		new->secondary->dev_id = new->dev_id;
 		new->secondary->irq = new->irq;
 		new->secondary->name = new->name;
+		new->secondary->flags = new->flags & IRQF_THREAD_CLASS;
 	}
 	/* Deal with the primary handler */
 	set_bit(IRQTF_FORCED_THREAD, &new->thread_flags);
@@ -1424,7 +1514,7 @@ setup_irq_thread(struct irqaction *new, unsigned int irq, bool secondary)
 	if (IS_ERR(t))
 		return PTR_ERR(t);
 
-	sched_set_fifo(t);
+	irq_thread_set_priority(t, irq_thread_priority(irq_to_desc(irq), new));
 
 	/*
 	 * We keep the reference to the task struct even if
@@ -214,6 +214,56 @@ static const struct proc_ops irq_affinity_list_proc_ops = {
 	.proc_write	= irq_affinity_list_proc_write,
 };
 
+static int irq_thread_affinity_proc_show(struct seq_file *m, void *v)
+{
+	struct irq_desc *desc = irq_to_desc((long)m->private);
+	unsigned long flags;
+	cpumask_var_t mask;
+
+	if (!zalloc_cpumask_var(&mask, GFP_KERNEL))
+		return -ENOMEM;
+
+	raw_spin_lock_irqsave(&desc->lock, flags);
+	if (desc->thread_affinity)
+		cpumask_copy(mask, desc->thread_affinity);
+	raw_spin_unlock_irqrestore(&desc->lock, flags);
+
+	seq_printf(m, "%*pbl\n", cpumask_pr_args(mask));
+	free_cpumask_var(mask);
+	return 0;
+}
+
+static ssize_t irq_thread_affinity_proc_write(struct file *file,
+		const char __user *buffer, size_t count, loff_t *pos)
+{
+	unsigned int irq = (int)(long)PDE_DATA(file_inode(file));
+	cpumask_var_t new_value;
+	int err;
+
+	if (!zalloc_cpumask_var(&new_value, GFP_KERNEL))
+		return -ENOMEM;
+
+	err = cpumask_parselist_user(buffer, count, new_value);
+	if (!err)
+		err = irq_set_thread_affinity_mask(irq_to_desc(irq), new_value);
+
+	free_cpumask_var(new_value);
+	return err ?: count;
+}
+
+static int irq_thread_affinity_proc_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, irq_thread_affinity_proc_show, PDE_DATA(inode));
+}
+
+static const struct proc_ops irq_thread_affinity_proc_ops = {
+	.proc_open	= irq_thread_affinity_proc_open,
+	.proc_read	= seq_read,
+	.proc_lseek	= seq_lseek,
+	.proc_release	= single_release,
+	.proc_write	= irq_thread_affinity_proc_write,
+};
+
 #ifdef CONFIG_GENERIC_IRQ_EFFECTIVE_AFF_MASK
 static int irq_effective_aff_proc_show(struct seq_file *m, void *v)
 {
@@ -285,6 +335,40 @@ static int irq_node_proc_show(struct seq_file *m, void *v)
 }
 #endif
 
+static int irq_thread_prio_proc_show(struct seq_file *m, void *v)
+{
+	struct irq_desc *desc = irq_to_desc((long)m->private);
+
+	seq_printf(m, "%u\n", READ_ONCE(desc->thread_prio));
+	return 0;
+}
+
+static ssize_t irq_thread_prio_proc_write(struct file *file,
+		const char __user *buffer, size_t count, loff_t *pos)
+{
+	unsigned int irq = (int)(long)PDE_DATA(file_inode(file));
+	unsigned int prio;
+	int err;
+
+	err = kstrtouint_from_user(buffer, count, 0, &prio);
+	if (!err)
+		err = irq_set_thread_priority(irq_to_desc(irq), prio);
+	return err ?: count;
+}
+
+static int irq_thread_prio_proc_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, irq_thread_prio_proc_show, PDE_DATA(inode));
+}
+
+static const struct proc_ops irq_thread_prio_proc_ops = {
+	.proc_open	= irq_thread_prio_proc_open,
+	.proc_read	= seq_read,
+	.proc_lseek	= seq_lseek,
+	.proc_release	= single_release,
+	.proc_write	= irq_thread_prio_proc_write,
+};
+
 static int irq_spurious_proc_show(struct seq_file *m, void *v)
 {
 	struct irq_desc *desc = irq_to_desc((long) m->private);
@@ -376,6 +460,10 @@ void register_irq_proc(unsigned int irq, struct irq_desc *desc)
 
 	proc_create_single_data("node", 0444, desc->dir, irq_node_proc_show,
 			irqp);
+
+	/* create /proc/irq/<irq>/thread_affinity_list */
+	proc_create_data("thread_affinity_list", 0644, desc->dir,
+			 &irq_thread_affinity_proc_ops, irqp);
 # ifdef CONFIG_GENERIC_IRQ_EFFECTIVE_AFF_MASK
 	proc_create_single_data("effective_affinity", 0444, desc->dir,
 			irq_effective_aff_proc_show, irqp);
@@ -386,6 +474,10 @@ void register_irq_proc(unsigned int irq, struct irq_desc *desc)
 	proc_create_single_data("spurious", 0444, desc->dir,
 			irq_spurious_proc_show, (void *)(long)irq);
 
+	/* create /proc/irq/<irq>/thread_priority */
+	proc_create_data("thread_priority", 0644, desc->dir,
+			 &irq_thread_prio_proc_ops, (void *)(long)irq);
+
 out_unlock:
 	mutex_unlock(&register_lock);
 }
@@ -401,12 +493,14 @@ void unregister_irq_proc(unsigned int irq, struct irq_desc *desc)
 	remove_proc_entry("affinity_hint", desc->dir);
 	remove_proc_entry("smp_affinity_list", desc->dir);
 	remove_proc_entry("node", desc->dir);
+	remove_proc_entry("thread_affinity_list", desc->dir);
 # ifdef CONFIG_GENERIC_IRQ_EFFECTIVE_AFF_MASK
 	remove_proc_entry("effective_affinity", desc->dir);
 	remove_proc_entry("effective_affinity_list", desc->dir);
 # endif
 #endif
 	remove_proc_entry("spurious", desc->dir);
+	remove_proc_entry("thread_priority", desc->dir);
 
 	sprintf(name, "%u", irq);
 	remove_proc_entry(name, root_irq_dir);
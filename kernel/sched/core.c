@@ -7235,7 +7235,8 @@ static int __sched_setscheduler(struct task_struct *p,
 			return -EINVAL;
 	}
 
-	if (attr->sched_flags & ~(SCHED_FLAG_ALL | SCHED_FLAG_SUGOV))
+	if (attr->sched_flags & ~(SCHED_FLAG_ALL | SCHED_FLAG_SUGOV |
+				  SCHED_FLAG_DL_GROUP))
 		return -EINVAL;
 
 	/*
@@ -7301,7 +7302,7 @@ static int __sched_setscheduler(struct task_struct *p,
 	}
 
 	if (user) {
-		if (attr->sched_flags & SCHED_FLAG_SUGOV)
+		if (attr->sched_flags & (SCHED_FLAG_SUGOV | SCHED_FLAG_DL_GROUP))
 			return -EINVAL;
 
 		retval = security_task_setscheduler(p);
@@ -7437,6 +7438,8 @@ static int __sched_setscheduler(struct task_struct *p,
 	if (!(attr->sched_flags & SCHED_FLAG_KEEP_PARAMS)) {
 		__setscheduler_params(p, attr);
 		__setscheduler_prio(p, newprio);
+		/* a policy not set by cpu.dl takes the task out of it */
+		p->dl.dl_group = !!(attr->sched_flags & SCHED_FLAG_DL_GROUP);
 	}
 	__setscheduler_uclamp(p, attr);
 
@@ -9956,13 +9959,79 @@ static int cpu_cgroup_can_attach(struct cgroup_taskset *tset)
 	return ret;
 }
 
+/*
+ * Deadline reservations: once an administrator sets cpu.dl on a group,
+ * every thread in it that runs a fair policy becomes SCHED_DEADLINE with
+ * the group's runtime and period. Joining only needs write access to the
+ * group's cgroup.threads, not CAP_SYS_NICE, but admission control still
+ * applies. Threads go back to SCHED_NORMAL when they leave the group or
+ * the reservation is removed. Threads they fork start out SCHED_NORMAL.
+ */
+static DEFINE_MUTEX(dl_group_mutex);
+
+static void sched_group_dl_apply(struct task_group *tg, struct task_struct *p)
+{
+	struct sched_attr attr = { .size = sizeof(attr) };
+	u64 runtime = tg->dl_runtime;
+
+	lockdep_assert_held(&dl_group_mutex);
+
+	if (runtime) {
+		if (!p->dl.dl_group && !fair_policy(p->policy))
+			return;
+		attr.sched_policy = SCHED_DEADLINE;
+		attr.sched_flags = SCHED_FLAG_RESET_ON_FORK |
+				   SCHED_FLAG_DL_GROUP;
+		attr.sched_runtime = runtime;
+		attr.sched_deadline = tg->dl_period;
+		attr.sched_period = tg->dl_period;
+	} else {
+		if (!p->dl.dl_group)
+			return;
+		attr.sched_policy = SCHED_NORMAL;
+		attr.sched_nice = task_nice(p);
+	}
+
+	/* sets or clears p->dl.dl_group along with the policy */
+	if (sched_setattr_nocheck(p, &attr))
+		atomic64_inc(&tg->dl_rejected);
+}
+
 static void cpu_cgroup_attach(struct cgroup_taskset *tset)
 {
 	struct task_struct *task;
 	struct cgroup_subsys_state *css;
 
-	cgroup_taskset_for_each(task, css, tset)
+	mutex_lock(&dl_group_mutex);
+	cgroup_taskset_for_each(task, css, tset) {
 		sched_move_task(task);
+		sched_group_dl_apply(css_tg(css), task);
+	}
+	mutex_unlock(&dl_group_mutex);
+}
+
+static int tg_set_dl_reservation(struct task_group *tg, u64 period,
+				 u64 runtime)
+{
+	struct css_task_iter it;
+	struct task_struct *p;
+
+	if (runtime == RUNTIME_INF)
+		runtime = 0;
+	else if (runtime < (1ULL << DL_SCALE) || runtime > period)
+		return -EINVAL;
+
+	mutex_lock(&dl_group_mutex);
+	tg->dl_runtime = runtime;
+	tg->dl_period = period;
+
+	css_task_iter_start(&tg->css, 0, &it);
+	while ((p = css_task_iter_next(&it)))
+		sched_group_dl_apply(tg, p);
+	css_task_iter_end(&it);
+	mutex_unlock(&dl_group_mutex);
+
+	return 0;
 }
 
 #ifdef CONFIG_UCLAMP_TASK_GROUP
@@ -10722,6 +10791,43 @@ static ssize_t cpu_max_write(struct kernfs_open_file *of,
 }
 #endif
 
+static int cpu_dl_show(struct seq_file *sf, void *v)
+{
+	struct task_group *tg = css_tg(seq_css(sf));
+	u64 runtime = READ_ONCE(tg->dl_runtime);
+	u64 period = READ_ONCE(tg->dl_period);
+
+	if (!period)
+		period = 10 * NSEC_PER_MSEC;
+	cpu_period_quota_print(sf, div_u64(period, NSEC_PER_USEC),
+			       runtime ? div_u64(runtime, NSEC_PER_USEC) : -1);
+	return 0;
+}
+
+static ssize_t cpu_dl_write(struct kernfs_open_file *of,
+			    char *buf, size_t nbytes, loff_t off)
+{
+	struct task_group *tg = css_tg(of_css(of));
+	u64 period = READ_ONCE(tg->dl_period) ?: 10 * NSEC_PER_MSEC;
+	u64 runtime;
+	int ret;
+
+	period = div_u64(period, NSEC_PER_USEC);
+	ret = cpu_period_quota_parse(buf, &period, &runtime);
+	if (!ret)
+		ret = tg_set_dl_reservation(tg, period, runtime);
+	return ret ?: nbytes;
+}
+
+static int cpu_dl_stat_show(struct seq_file *sf, void *v)
+{
+	struct task_group *tg = css_tg(seq_css(sf));
+
+	seq_printf(sf, "overruns %lld\n", atomic64_read(&tg->dl_overruns));
+	seq_printf(sf, "rejected %lld\n", atomic64_read(&tg->dl_rejected));
+	return 0;
+}
+
 static struct cftype cpu_files[] = {
 #ifdef CONFIG_FAIR_GROUP_SCHED
 	{
@@ -10771,6 +10877,17 @@ static struct cftype cpu_files[] = {
 		.write = cpu_uclamp_max_write,
 	},
 #endif
+	{
+		.name = "dl",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = cpu_dl_show,
+		.write = cpu_dl_write,
+	},
+	{
+		.name = "dl.stat",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = cpu_dl_stat_show,
+	},
 	{ }	/* terminate */
 };
 
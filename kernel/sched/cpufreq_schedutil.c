@@ -15,9 +15,14 @@
 
 #define IOWAIT_BOOST_MIN	(SCHED_CAPACITY_SCALE / 8)
 
+#define INPUT_BOOST_MS_DEFAULT	40
+#define INPUT_BOOST_PCT_DEFAULT	50
+
 struct sugov_tunables {
 	struct gov_attr_set	attr_set;
 	unsigned int		rate_limit_us;
+	unsigned int		input_boost_ms;
+	unsigned int		input_boost_pct;
 };
 
 struct sugov_policy {
@@ -42,6 +47,7 @@ struct sugov_policy {
 
 	bool			limits_changed;
 	bool			need_freq_update;
+	bool			input_boosted;
 };
 
 struct sugov_cpu {
@@ -65,8 +71,38 @@ struct sugov_cpu {
 
 static DEFINE_PER_CPU(struct sugov_cpu, sugov_cpu);
 
+/* jiffies of the last input event that asked for a boost */
+static unsigned long input_boost_stamp;
+
+/**
+ * schedutil_input_boost() - Signal user input activity.
+ *
+ * Called by the input core for devices that have boosting enabled. For
+ * input_boost_ms after the last call, every schedutil policy keeps the
+ * utilization of its CPUs at or above input_boost_pct of their capacity,
+ * so that the work following an input event does not start at the lowest
+ * frequency. May be called from any context.
+ */
+void schedutil_input_boost(void)
+{
+	unsigned long now = jiffies;
+
+	if (READ_ONCE(input_boost_stamp) != now)
+		WRITE_ONCE(input_boost_stamp, now);
+}
+EXPORT_SYMBOL_GPL(schedutil_input_boost);
+
 /************************ Governor internals ***********************/
 
+static bool sugov_input_boosting(struct sugov_policy *sg_policy)
+{
+	unsigned int ms = READ_ONCE(sg_policy->tunables->input_boost_ms);
+	unsigned long stamp = READ_ONCE(input_boost_stamp);
+
+	return ms && stamp &&
+	       time_before(jiffies, stamp + msecs_to_jiffies(ms));
+}
+
 static bool sugov_should_update_freq(struct sugov_policy *sg_policy, u64 time)
 {
 	s64 delta_ns;
@@ -95,6 +131,13 @@ static bool sugov_should_update_freq(struct sugov_policy *sg_policy, u64 time)
 		return true;
 	}
 
+	/* act on the start of an input boost without waiting for the limit */
+	if (sugov_input_boosting(sg_policy) != sg_policy->input_boosted) {
+		sg_policy->input_boosted = !sg_policy->input_boosted;
+		if (sg_policy->input_boosted)
+			return true;
+	}
+
 	delta_ns = time - sg_policy->last_freq_update_time;
 
 	return delta_ns >= sg_policy->freq_update_delay_ns;
@@ -293,6 +336,26 @@ static void sugov_iowait_apply(struct sugov_cpu *sg_cpu, u64 time)
 		sg_cpu->util = boost;
 }
 
+/**
+ * sugov_input_apply() - Apply the input boost to a CPU.
+ * @sg_cpu: the sugov data for the cpu to boost
+ *
+ * While an input boost is active, raise the utilization of the CPU to the
+ * input_boost_pct floor.
+ */
+static void sugov_input_apply(struct sugov_cpu *sg_cpu)
+{
+	struct sugov_policy *sg_policy = sg_cpu->sg_policy;
+	unsigned long boost;
+
+	if (!sg_policy->input_boosted)
+		return;
+
+	boost = sg_cpu->max * READ_ONCE(sg_policy->tunables->input_boost_pct) / 100;
+	if (sg_cpu->util < boost)
+		sg_cpu->util = boost;
+}
+
 #ifdef CONFIG_NO_HZ_COMMON
 static bool sugov_cpu_is_busy(struct sugov_cpu *sg_cpu)
 {
@@ -329,6 +392,7 @@ static inline bool sugov_update_single_common(struct sugov_cpu *sg_cpu,
 
 	sugov_get_util(sg_cpu);
 	sugov_iowait_apply(sg_cpu, time);
+	sugov_input_apply(sg_cpu);
 
 	return true;
 }
@@ -418,6 +482,7 @@ static unsigned int sugov_next_freq_shared(struct sugov_cpu *sg_cpu, u64 time)
 
 		sugov_get_util(j_sg_cpu);
 		sugov_iowait_apply(j_sg_cpu, time);
+		sugov_input_apply(j_sg_cpu);
 		j_util = j_sg_cpu->util;
 		j_max = j_sg_cpu->max;
 
@@ -531,8 +596,54 @@ rate_limit_us_store(struct gov_attr_set *attr_set, const char *buf, size_t count
 
 static struct governor_attr rate_limit_us = __ATTR_RW(rate_limit_us);
 
+static ssize_t input_boost_ms_show(struct gov_attr_set *attr_set, char *buf)
+{
+	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
+
+	return sprintf(buf, "%u\n", tunables->input_boost_ms);
+}
+
+static ssize_t
+input_boost_ms_store(struct gov_attr_set *attr_set, const char *buf, size_t count)
+{
+	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
+	unsigned int ms;
+
+	if (kstrtouint(buf, 10, &ms) || ms > MSEC_PER_SEC)
+		return -EINVAL;
+
+	WRITE_ONCE(tunables->input_boost_ms, ms);
+	return count;
+}
+
+static struct governor_attr input_boost_ms = __ATTR_RW(input_boost_ms);
+
+static ssize_t input_boost_pct_show(struct gov_attr_set *attr_set, char *buf)
+{
+	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
+
+	return sprintf(buf, "%u\n", tunables->input_boost_pct);
+}
+
+static ssize_t
+input_boost_pct_store(struct gov_attr_set *attr_set, const char *buf, size_t count)
+{
+	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
+	unsigned int pct;
+
+	if (kstrtouint(buf, 10, &pct) || pct > 100)
+		return -EINVAL;
+
+	WRITE_ONCE(tunables->input_boost_pct, pct);
+	return count;
+}
+
+static struct governor_attr input_boost_pct = __ATTR_RW(input_boost_pct);
+
 static struct attribute *sugov_attrs[] = {
 	&rate_limit_us.attr,
+	&input_boost_ms.attr,
+	&input_boost_pct.attr,
 	NULL
 };
 ATTRIBUTE_GROUPS(sugov);
@@ -696,6 +807,8 @@ static int sugov_init(struct cpufreq_policy *policy)
 	}
 
 	tunables->rate_limit_us = cpufreq_policy_transition_delay_us(policy);
+	tunables->input_boost_ms = INPUT_BOOST_MS_DEFAULT;
+	tunables->input_boost_pct = INPUT_BOOST_PCT_DEFAULT;
 
 	policy->governor_data = sg_policy;
 	sg_policy->tunables = tunables;
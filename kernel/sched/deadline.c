@@ -1307,6 +1307,11 @@ static void update_curr_dl(struct rq *rq)
 		    (dl_se->flags & SCHED_FLAG_DL_OVERRUN))
 			dl_se->dl_overrun = 1;
 
+#ifdef CONFIG_CGROUP_SCHED
+		if (dl_runtime_exceeded(dl_se) && dl_se->dl_group)
+			atomic64_inc(&task_group(curr)->dl_overruns);
+#endif
+
 		__dequeue_task_dl(rq, curr, 0);
 		if (unlikely(is_dl_boosted(dl_se) || !start_dl_timer(curr)))
 			enqueue_task_dl(rq, curr, ENQUEUE_REPLENISH);
@@ -2840,6 +2845,7 @@ void __dl_clear_params(struct task_struct *p)
 	dl_se->dl_yielded		= 0;
 	dl_se->dl_non_contending	= 0;
 	dl_se->dl_overrun		= 0;
+	dl_se->dl_group			= false;
 
 #ifdef CONFIG_RT_MUTEXES
 	dl_se->pi_se			= dl_se;
@@ -227,6 +227,13 @@ static inline void update_avg(u64 *avg, u64 sample)
  */
 #define SCHED_FLAG_SUGOV	0x10000000
 
+/*
+ * Internal flag of the parameters a task group's deadline reservation
+ * (cpu.dl) sets. Any other change of the task's policy makes it leave the
+ * reservation, see sched_dl_entity::dl_group.
+ */
+#define SCHED_FLAG_DL_GROUP	0x20000000
+
 #define SCHED_DL_FLAGS (SCHED_FLAG_RECLAIM | SCHED_FLAG_DL_OVERRUN | SCHED_FLAG_SUGOV)
 
 static inline bool dl_entity_is_special(struct sched_dl_entity *dl_se)
@@ -429,6 +436,12 @@ struct task_group {
 
 	struct cfs_bandwidth	cfs_bandwidth;
 
+	/* SCHED_DEADLINE reservation given to tasks joining the group */
+	u64			dl_runtime;
+	u64			dl_period;
+	atomic64_t		dl_overruns;
+	atomic64_t		dl_rejected;
+
 #ifdef CONFIG_UCLAMP_TASK_GROUP
 	/* The two decimal precision [%] value requested from user-space */
 	unsigned int		uclamp_pct[UCLAMP_CNT];
@@ -47,6 +47,7 @@ enum trace_type {
 	TRACE_HWLAT,
 	TRACE_OSNOISE,
 	TRACE_TIMERLAT,
+	TRACE_INPUT_LAT,
 	TRACE_RAW_DATA,
 	TRACE_FUNC_REPEATS,
 
@@ -99,6 +100,8 @@ enum trace_type {
 #define FTRACE_ENTRY_PACKED(name, struct_name, id, tstruct, print)	\
 	FTRACE_ENTRY(name, struct_name, id, PARAMS(tstruct), PARAMS(print)) __packed
 
+#define INPUT_LAT_NAME_SIZE	16
+
 #include "trace_entries.h"
 
 /* Use this for memory failure errors */
@@ -448,6 +451,7 @@ extern void __ftrace_bad_type(void);
 		IF_ASSIGN(var, ent, struct hwlat_entry, TRACE_HWLAT);	\
 		IF_ASSIGN(var, ent, struct osnoise_entry, TRACE_OSNOISE);\
 		IF_ASSIGN(var, ent, struct timerlat_entry, TRACE_TIMERLAT);\
+		IF_ASSIGN(var, ent, struct input_lat_entry, TRACE_INPUT_LAT);\
 		IF_ASSIGN(var, ent, struct raw_data_entry, TRACE_RAW_DATA);\
 		IF_ASSIGN(var, ent, struct trace_mmiotrace_rw,		\
 			  TRACE_MMIO_RW);				\
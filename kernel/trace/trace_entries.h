@@ -401,3 +401,21 @@ FTRACE_ENTRY(timerlat, timerlat_entry,
 		 __entry->context,
 		 __entry->timer_latency)
 );
+
+FTRACE_ENTRY(input_lat, input_lat_entry,
+
+	TRACE_INPUT_LAT,
+
+	F_STRUCT(
+		__array(	char,	name,	INPUT_LAT_NAME_SIZE	)
+		__field(	int,			read		)
+		__field(	unsigned int,		count		)
+		__field(	u64,			latency		)
+	),
+
+	F_printk("%s\tread:%d\tcount:%u\tlatency:%llu\n",
+		 __entry->name,
+		 __entry->read,
+		 __entry->count,
+		 __entry->latency)
+);
@@ -0,0 +1,371 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * trace_fixed.c - fixed-record per-CPU trace rings
+ *
+ * A minimal alternative to the ring buffer for a few call sites that are
+ * meant to be traced all the time. Each CPU has an array of fixed-size
+ * records and a free running head; a writer disables interrupts, fills
+ * the record at the head with the raw arch clock (the timebase on
+ * powerpc) and advances the head. There is no reservation, no commit,
+ * no timestamp delta encoding and no 64-bit arithmetic on the record
+ * path beyond the clock read. Old records are overwritten when a reader
+ * falls behind.
+ *
+ * tracefs fixed_ring/:
+ *   enable				mask of enum trace_fixed_id to record
+ *   events				ids and names of the call sites
+ *   format				layout of the records and the clock
+ *   stats				records written and lost per CPU
+ *   per_cpu/cpuN/trace_pipe_raw	consuming read of binary records
+ *
+ * The per-CPU arrays hold trace_fixed_records records each, a power of
+ * two set with trace_fixed_records= on the command line, and are
+ * allocated when first enabled.
+ */
+#include <linux/cpumask.h>
+#include <linux/irq_work.h>
+#include <linux/log2.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/trace_clock.h>
+#include <linux/trace_fixed.h>
+#include <linux/tracefs.h>
+#include <linux/uaccess.h>
+#include <linux/wait.h>
+#include "trace.h"
+
+#ifndef trace_fixed_clock
+#define trace_fixed_clock()	trace_clock_local()
+#define TRACE_FIXED_CLOCK	"local"
+#endif
+
+#define TRACE_FIXED_DEFAULT_RECORDS	1024
+#define TRACE_FIXED_MAX_RECORDS		(1U << 20)
+
+struct trace_fixed_ring {
+	struct trace_fixed_rec *recs;
+	unsigned int head;		/* written by the local CPU only */
+	unsigned int tail;		/* under read_mutex */
+	unsigned long lost;		/* under read_mutex */
+	bool waiting;
+	struct irq_work work;
+	wait_queue_head_t wait;
+	struct mutex read_mutex;
+};
+
+static DEFINE_PER_CPU(struct trace_fixed_ring, trace_fixed_rings);
+static unsigned int trace_fixed_records = TRACE_FIXED_DEFAULT_RECORDS;
+static bool trace_fixed_allocated;
+static DEFINE_MUTEX(trace_fixed_mutex);
+
+DEFINE_STATIC_KEY_FALSE(trace_fixed_key);
+EXPORT_SYMBOL_GPL(trace_fixed_key);
+
+unsigned long trace_fixed_mask;
+EXPORT_SYMBOL_GPL(trace_fixed_mask);
+
+static const char *const trace_fixed_names[TRACE_FIXED_NR] = {
+	[TRACE_FIXED_INPUT_FRAME]	= "input_frame",
+	[TRACE_FIXED_INPUT_READ]	= "input_read",
+	[TRACE_FIXED_HID_REPORT]	= "hid_report",
+	[TRACE_FIXED_PCM_PERIOD]	= "pcm_period",
+};
+
+static int __init set_trace_fixed_records(char *str)
+{
+	unsigned long records;
+
+	if (kstrtoul(str, 0, &records) || !records)
+		return 0;
+
+	records = min_t(unsigned long, records, TRACE_FIXED_MAX_RECORDS);
+	trace_fixed_records = roundup_pow_of_two(records);
+	return 1;
+}
+__setup("trace_fixed_records=", set_trace_fixed_records);
+
+void notrace __trace_fixed(unsigned int id, u32 a0, u32 a1, u32 a2, u32 a3)
+{
+	struct trace_fixed_ring *ring;
+	struct trace_fixed_rec *rec;
+	unsigned long flags;
+	unsigned int head;
+
+	local_irq_save(flags);
+	ring = this_cpu_ptr(&trace_fixed_rings);
+	head = ring->head;
+	rec = &ring->recs[head & (trace_fixed_records - 1)];
+
+	rec->ts = trace_fixed_clock();
+	rec->id = id;
+	rec->reserved = 0;
+	rec->pid = current->pid;
+	rec->arg[0] = a0;
+	rec->arg[1] = a1;
+	rec->arg[2] = a2;
+	rec->arg[3] = a3;
+
+	/* the record is complete before a reader can see the new head */
+	smp_store_release(&ring->head, head + 1);
+
+	/*
+	 * No barrier against the reader setting waiting, a missed wakeup
+	 * is caught by the reader's timeout instead.
+	 */
+	if (unlikely(READ_ONCE(ring->waiting)))
+		irq_work_queue(&ring->work);
+	local_irq_restore(flags);
+}
+EXPORT_SYMBOL_GPL(__trace_fixed);
+
+static void trace_fixed_wake(struct irq_work *work)
+{
+	struct trace_fixed_ring *ring = container_of(work,
+						     struct trace_fixed_ring,
+						     work);
+
+	wake_up_interruptible(&ring->wait);
+}
+
+/* Called with trace_fixed_mutex held */
+static int trace_fixed_alloc(void)
+{
+	size_t size = trace_fixed_records * sizeof(struct trace_fixed_rec);
+	struct trace_fixed_ring *ring;
+	int cpu;
+
+	if (trace_fixed_allocated)
+		return 0;
+
+	for_each_possible_cpu(cpu) {
+		ring = per_cpu_ptr(&trace_fixed_rings, cpu);
+		ring->recs = kvmalloc_node(size, GFP_KERNEL | __GFP_ZERO,
+					   cpu_to_node(cpu));
+		if (!ring->recs)
+			goto err;
+	}
+
+	trace_fixed_allocated = true;
+	return 0;
+
+err:
+	for_each_possible_cpu(cpu) {
+		ring = per_cpu_ptr(&trace_fixed_rings, cpu);
+		kvfree(ring->recs);
+		ring->recs = NULL;
+	}
+	return -ENOMEM;
+}
+
+static ssize_t
+trace_fixed_pipe_read(struct file *filp, char __user *ubuf, size_t cnt,
+		      loff_t *ppos)
+{
+	struct trace_fixed_ring *ring = filp->private_data;
+	unsigned int size = trace_fixed_records;
+	struct trace_fixed_rec rec;
+	unsigned int head;
+	ssize_t read = 0;
+	int ret = 0;
+
+	if (cnt < sizeof(rec))
+		return -EINVAL;
+
+	mutex_lock(&ring->read_mutex);
+	while (!read) {
+		head = smp_load_acquire(&ring->head);
+		if (head == ring->tail) {
+			if (filp->f_flags & O_NONBLOCK) {
+				ret = -EAGAIN;
+				break;
+			}
+
+			WRITE_ONCE(ring->waiting, true);
+			ret = wait_event_interruptible_timeout(ring->wait,
+					smp_load_acquire(&ring->head) != ring->tail,
+					HZ / 10);
+			WRITE_ONCE(ring->waiting, false);
+			if (ret < 0)
+				break;
+			ret = 0;
+			continue;
+		}
+
+		if (head - ring->tail > size) {
+			ring->lost += head - ring->tail - size;
+			ring->tail = head - size;
+		}
+
+		while (ring->tail != head && cnt - read >= sizeof(rec)) {
+			rec = ring->recs[ring->tail & (size - 1)];
+
+			/* the writer may have lapped us while copying */
+			smp_rmb();
+			if (READ_ONCE(ring->head) - ring->tail >= size) {
+				ring->lost++;
+				ring->tail++;
+				continue;
+			}
+
+			if (copy_to_user(ubuf + read, &rec, sizeof(rec))) {
+				ret = -EFAULT;
+				goto out;
+			}
+			ring->tail++;
+			read += sizeof(rec);
+		}
+	}
+out:
+	mutex_unlock(&ring->read_mutex);
+
+	return read ? read : ret;
+}
+
+static const struct file_operations trace_fixed_pipe_fops = {
+	.open		= tracing_open_generic,
+	.read		= trace_fixed_pipe_read,
+	.llseek		= no_llseek,
+};
+
+static ssize_t
+trace_fixed_enable_read(struct file *filp, char __user *ubuf, size_t cnt,
+			loff_t *ppos)
+{
+	char buf[32];
+	int len;
+
+	len = snprintf(buf, sizeof(buf), "%#lx\n", READ_ONCE(trace_fixed_mask));
+	return simple_read_from_buffer(ubuf, cnt, ppos, buf, len);
+}
+
+static ssize_t
+trace_fixed_enable_write(struct file *filp, const char __user *ubuf,
+			 size_t cnt, loff_t *ppos)
+{
+	unsigned long val;
+	int ret;
+
+	ret = kstrtoul_from_user(ubuf, cnt, 0, &val);
+	if (ret)
+		return ret;
+
+	if (val & ~GENMASK(TRACE_FIXED_NR - 1, 0))
+		return -EINVAL;
+
+	mutex_lock(&trace_fixed_mutex);
+	if (val) {
+		ret = trace_fixed_alloc();
+		if (ret)
+			goto out;
+	}
+
+	WRITE_ONCE(trace_fixed_mask, val);
+	if (val && !static_key_enabled(&trace_fixed_key))
+		static_branch_enable(&trace_fixed_key);
+	else if (!val && static_key_enabled(&trace_fixed_key))
+		static_branch_disable(&trace_fixed_key);
+out:
+	mutex_unlock(&trace_fixed_mutex);
+
+	return ret ? ret : cnt;
+}
+
+static const struct file_operations trace_fixed_enable_fops = {
+	.open		= tracing_open_generic,
+	.read		= trace_fixed_enable_read,
+	.write		= trace_fixed_enable_write,
+	.llseek		= generic_file_llseek,
+};
+
+static int trace_fixed_events_show(struct seq_file *m, void *v)
+{
+	unsigned int id;
+
+	for (id = 0; id < TRACE_FIXED_NR; id++)
+		seq_printf(m, "%u %s%s\n", id, trace_fixed_names[id],
+			   READ_ONCE(trace_fixed_mask) & BIT(id) ?
+			   " [enabled]" : "");
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(trace_fixed_events);
+
+#define TRACE_FIXED_FIELD(m, type, field)				\
+	seq_printf(m, "\tfield:%s;\toffset:%zu;\tsize:%zu;\n", type,	\
+		   offsetof(struct trace_fixed_rec, field),		\
+		   sizeof_field(struct trace_fixed_rec, field))
+
+static int trace_fixed_format_show(struct seq_file *m, void *v)
+{
+	seq_printf(m, "clock: %s\n", TRACE_FIXED_CLOCK);
+	seq_printf(m, "record_size: %zu\n", sizeof(struct trace_fixed_rec));
+	seq_printf(m, "records_per_cpu: %u\n", trace_fixed_records);
+	seq_puts(m, "format:\n");
+	TRACE_FIXED_FIELD(m, "u64 ts", ts);
+	TRACE_FIXED_FIELD(m, "u16 id", id);
+	TRACE_FIXED_FIELD(m, "u16 reserved", reserved);
+	TRACE_FIXED_FIELD(m, "u32 pid", pid);
+	TRACE_FIXED_FIELD(m, "u32 arg[4]", arg);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(trace_fixed_format);
+
+static int trace_fixed_stats_show(struct seq_file *m, void *v)
+{
+	struct trace_fixed_ring *ring;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		ring = per_cpu_ptr(&trace_fixed_rings, cpu);
+		seq_printf(m, "cpu%d: written %u lost %lu\n", cpu,
+			   READ_ONCE(ring->head), READ_ONCE(ring->lost));
+	}
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(trace_fixed_stats);
+
+static __init int trace_fixed_init(void)
+{
+	struct trace_fixed_ring *ring;
+	struct dentry *top, *per_cpu, *dir;
+	char name[16];
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		ring = per_cpu_ptr(&trace_fixed_rings, cpu);
+		init_irq_work(&ring->work, trace_fixed_wake);
+		init_waitqueue_head(&ring->wait);
+		mutex_init(&ring->read_mutex);
+	}
+
+	if (tracing_init_dentry())
+		return 0;
+
+	top = tracefs_create_dir("fixed_ring", NULL);
+	if (!top)
+		return -ENOMEM;
+
+	trace_create_file("enable", 0644, top, NULL, &trace_fixed_enable_fops);
+	trace_create_file("events", 0444, top, NULL, &trace_fixed_events_fops);
+	trace_create_file("format", 0444, top, NULL, &trace_fixed_format_fops);
+	trace_create_file("stats", 0444, top, NULL, &trace_fixed_stats_fops);
+
+	per_cpu = tracefs_create_dir("per_cpu", top);
+	if (!per_cpu)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		snprintf(name, sizeof(name), "cpu%d", cpu);
+		dir = tracefs_create_dir(name, per_cpu);
+		if (!dir)
+			continue;
+		trace_create_file("trace_pipe_raw", 0440, dir,
+				  per_cpu_ptr(&trace_fixed_rings, cpu),
+				  &trace_fixed_pipe_fops);
+	}
+
+	return 0;
+}
+late_initcall(trace_fixed_init);
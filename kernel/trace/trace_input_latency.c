@@ -0,0 +1,266 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * trace_input_latency.c - input frame to read latency tracer
+ *
+ * Measures the time from an input frame, the values up to a SYN_REPORT,
+ * being passed to the handlers in input_pass_values() until an evdev
+ * reader consumes its SYN_REPORT. Reads through io_uring go through
+ * evdev's read_iter and are covered as well. The frame timestamp is the
+ * one of the input device, which drivers calling input_set_timestamp()
+ * take in their hard interrupt handler.
+ *
+ * Both ends are recorded in the ring buffer. As with the wakeup tracers,
+ * a new maximum latency, or with tracing_thresh set any latency above it,
+ * takes a snapshot into the max buffer, so enabling other events (irq,
+ * sched, hid) shows what the frame was waiting for.
+ */
+#include <linux/input.h>
+#include <linux/seq_file.h>
+#include <linux/spinlock.h>
+#include <linux/tracefs.h>
+#include <trace/events/input.h>
+#include "trace.h"
+
+#define INPUT_LAT_MAX_DEVS	32
+#define INPUT_LAT_BUCKETS	12	/* log2 of microseconds, last one open */
+
+struct input_lat_dev {
+	const struct input_dev *dev;
+	char name[INPUT_LAT_NAME_SIZE];
+	u64 frames;
+	u64 reads;
+	u64 total_ns;
+	u64 max_ns;
+	u64 hist[INPUT_LAT_BUCKETS];
+};
+
+static struct trace_array	*input_lat_trace;
+static bool			input_lat_busy;
+static bool			input_lat_enabled;
+
+/* protects input_lat_devs and the max latency check */
+static DEFINE_RAW_SPINLOCK(input_lat_lock);
+static struct input_lat_dev input_lat_devs[INPUT_LAT_MAX_DEVS];
+
+/*
+ * Devices are only told apart by pointer and name, never dereferenced
+ * after the probe returns. Caller holds input_lat_lock, NULL when the
+ * table is full.
+ */
+static struct input_lat_dev *input_lat_lookup(const struct input_dev *dev)
+{
+	const char *name = dev_name(&dev->dev);
+	struct input_lat_dev *d;
+
+	for (d = input_lat_devs; d < input_lat_devs + INPUT_LAT_MAX_DEVS; d++) {
+		if (!d->dev) {
+			d->dev = dev;
+			strscpy(d->name, name, sizeof(d->name));
+			return d;
+		}
+		if (d->dev == dev && !strncmp(d->name, name, sizeof(d->name) - 1))
+			return d;
+	}
+
+	return NULL;
+}
+
+static void trace_input_lat_sample(const struct input_dev *dev, bool read,
+				   unsigned int count, u64 latency)
+{
+	struct trace_array *tr = input_lat_trace;
+	struct trace_event_call *call = &event_input_lat;
+	struct trace_buffer *buffer = tr->array_buffer.buffer;
+	struct ring_buffer_event *event;
+	struct input_lat_entry *entry;
+
+	event = trace_buffer_lock_reserve(buffer, TRACE_INPUT_LAT,
+					  sizeof(*entry), tracing_gen_ctx());
+	if (!event)
+		return;
+	entry = ring_buffer_event_data(event);
+	strscpy(entry->name, dev_name(&dev->dev), sizeof(entry->name));
+	entry->read	= read;
+	entry->count	= count;
+	entry->latency	= latency;
+
+	if (!call_filter_check_discard(call, entry, buffer, event))
+		trace_buffer_unlock_commit_nostack(buffer, event);
+}
+
+static bool input_lat_report(struct trace_array *tr, u64 delta)
+{
+	if (tracing_thresh)
+		return delta >= tracing_thresh;
+
+	return delta > tr->max_latency;
+}
+
+static void probe_input_frame(void *ignore, struct input_dev *dev,
+			      unsigned int count, ktime_t time)
+{
+	struct input_lat_dev *d;
+	unsigned long flags;
+
+	if (!READ_ONCE(input_lat_enabled))
+		return;
+
+	raw_spin_lock_irqsave(&input_lat_lock, flags);
+	d = input_lat_lookup(dev);
+	if (d)
+		d->frames++;
+	raw_spin_unlock_irqrestore(&input_lat_lock, flags);
+
+	trace_input_lat_sample(dev, false, count, 0);
+}
+
+static void probe_input_frame_read(void *ignore, struct input_dev *dev,
+				   ktime_t time)
+{
+	struct trace_array *tr = input_lat_trace;
+	struct input_lat_dev *d;
+	unsigned long flags;
+	unsigned int bucket;
+	s64 delta;
+
+	if (!READ_ONCE(input_lat_enabled))
+		return;
+
+	delta = max_t(s64, ktime_to_ns(ktime_sub(ktime_get(), time)), 0);
+	bucket = min_t(unsigned int, ilog2(div_u64(delta, NSEC_PER_USEC) | 1),
+		       INPUT_LAT_BUCKETS - 1);
+
+	trace_input_lat_sample(dev, true, 0, delta);
+
+	raw_spin_lock_irqsave(&input_lat_lock, flags);
+	d = input_lat_lookup(dev);
+	if (d) {
+		d->reads++;
+		d->total_ns += delta;
+		d->max_ns = max_t(u64, d->max_ns, delta);
+		d->hist[bucket]++;
+	}
+
+	if (input_lat_report(tr, delta) && likely(!is_tracing_stopped())) {
+		tr->max_latency = delta;
+		update_max_tr(tr, current, smp_processor_id(), NULL);
+	}
+	raw_spin_unlock_irqrestore(&input_lat_lock, flags);
+}
+
+static int input_lat_hist_show(struct seq_file *m, void *v)
+{
+	struct input_lat_dev d;
+	unsigned int i, j;
+
+	for (i = 0; i < INPUT_LAT_MAX_DEVS; i++) {
+		raw_spin_lock_irq(&input_lat_lock);
+		d = input_lat_devs[i];
+		raw_spin_unlock_irq(&input_lat_lock);
+
+		if (!d.dev)
+			break;
+
+		seq_printf(m, "%s frames %llu reads %llu avg_ns %llu max_ns %llu\n",
+			   d.name, d.frames, d.reads,
+			   d.reads ? div64_u64(d.total_ns, d.reads) : 0,
+			   d.max_ns);
+		for (j = 0; j < INPUT_LAT_BUCKETS; j++)
+			seq_printf(m, "  %s%5u us: %llu\n",
+				   j == INPUT_LAT_BUCKETS - 1 ? ">=" : "< ",
+				   j == INPUT_LAT_BUCKETS - 1 ? 1U << j : 2U << j,
+				   d.hist[j]);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(input_lat_hist);
+
+static void input_lat_tracer_start(struct trace_array *tr)
+{
+	WRITE_ONCE(input_lat_enabled, true);
+}
+
+static void input_lat_tracer_stop(struct trace_array *tr)
+{
+	WRITE_ONCE(input_lat_enabled, false);
+}
+
+static int input_lat_tracer_init(struct trace_array *tr)
+{
+	int ret;
+
+	/* Only allow one instance to enable this */
+	if (input_lat_busy)
+		return -EBUSY;
+
+	input_lat_trace = tr;
+	tr->max_latency = 0;
+
+	raw_spin_lock_irq(&input_lat_lock);
+	memset(input_lat_devs, 0, sizeof(input_lat_devs));
+	raw_spin_unlock_irq(&input_lat_lock);
+
+	ret = register_trace_input_frame(probe_input_frame, NULL);
+	if (ret) {
+		pr_info("input latency trace: Couldn't activate tracepoint probe to input_frame\n");
+		return ret;
+	}
+
+	ret = register_trace_input_frame_read(probe_input_frame_read, NULL);
+	if (ret) {
+		pr_info("input latency trace: Couldn't activate tracepoint probe to input_frame_read\n");
+		unregister_trace_input_frame(probe_input_frame, NULL);
+		return ret;
+	}
+
+	if (tracer_tracing_is_on(tr))
+		input_lat_tracer_start(tr);
+
+	input_lat_busy = true;
+
+	return 0;
+}
+
+static void input_lat_tracer_reset(struct trace_array *tr)
+{
+	input_lat_tracer_stop(tr);
+	unregister_trace_input_frame_read(probe_input_frame_read, NULL);
+	unregister_trace_input_frame(probe_input_frame, NULL);
+	tracepoint_synchronize_unregister();
+
+	input_lat_busy = false;
+}
+
+static struct tracer input_lat_tracer __read_mostly =
+{
+	.name		= "input_latency",
+	.init		= input_lat_tracer_init,
+	.reset		= input_lat_tracer_reset,
+	.start		= input_lat_tracer_start,
+	.stop		= input_lat_tracer_stop,
+	.print_max	= true,
+	.allow_instances = true,
+	.use_max_tr	= true,
+};
+
+__init static int init_input_lat_tracer(void)
+{
+	struct dentry *top_dir;
+	int ret;
+
+	ret = register_tracer(&input_lat_tracer);
+	if (ret)
+		return ret;
+
+	if (tracing_init_dentry())
+		return 0;
+
+	top_dir = tracefs_create_dir("input_latency", NULL);
+	if (top_dir)
+		trace_create_file("hist", 0444, top_dir, NULL,
+				  &input_lat_hist_fops);
+
+	return 0;
+}
+late_initcall(init_input_lat_tracer);
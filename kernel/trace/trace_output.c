@@ -1352,6 +1352,55 @@ static struct trace_event trace_timerlat_event = {
 	.funcs		= &trace_timerlat_funcs,
 };
 
+/* TRACE_INPUT_LAT */
+static enum print_line_t
+trace_input_lat_print(struct trace_iterator *iter, int flags,
+		      struct trace_event *event)
+{
+	struct trace_entry *entry = iter->ent;
+	struct trace_seq *s = &iter->seq;
+	struct input_lat_entry *field;
+
+	trace_assign_type(field, entry);
+
+	if (field->read)
+		trace_seq_printf(s, "%s read latency %9llu ns\n",
+				 field->name, field->latency);
+	else
+		trace_seq_printf(s, "%s frame values %u\n",
+				 field->name, field->count);
+
+	return trace_handle_return(s);
+}
+
+static enum print_line_t
+trace_input_lat_raw(struct trace_iterator *iter, int flags,
+		    struct trace_event *event)
+{
+	struct input_lat_entry *field;
+	struct trace_seq *s = &iter->seq;
+
+	trace_assign_type(field, iter->ent);
+
+	trace_seq_printf(s, "%s %d %u %llu\n",
+			 field->name,
+			 field->read,
+			 field->count,
+			 field->latency);
+
+	return trace_handle_return(s);
+}
+
+static struct trace_event_functions trace_input_lat_funcs = {
+	.trace		= trace_input_lat_print,
+	.raw		= trace_input_lat_raw,
+};
+
+static struct trace_event trace_input_lat_event = {
+	.type		= TRACE_INPUT_LAT,
+	.funcs		= &trace_input_lat_funcs,
+};
+
 /* TRACE_BPUTS */
 static enum print_line_t
 trace_bputs_print(struct trace_iterator *iter, int flags,
@@ -1564,6 +1613,7 @@ static struct trace_event *events[] __initdata = {
 	&trace_hwlat_event,
 	&trace_osnoise_event,
 	&trace_timerlat_event,
+	&trace_input_lat_event,
 	&trace_raw_data_event,
 	&trace_func_repeats_event,
 	NULL
@@ -57,6 +57,8 @@ int generic_fadvise(struct file *file, loff_t offset, loff_t len, int advice)
 		case POSIX_FADV_WILLNEED:
 		case POSIX_FADV_NOREUSE:
 		case POSIX_FADV_DONTNEED:
+		case POSIX_FADV_RECORD:
+		case POSIX_FADV_REPLAY:
 			/* no bad return value, but ignore advice */
 			break;
 		default:
@@ -171,6 +173,10 @@ int generic_fadvise(struct file *file, loff_t offset, loff_t len, int advice)
 			}
 		}
 		break;
+	case POSIX_FADV_RECORD:
+		return ra_replay_start(file);
+	case POSIX_FADV_REPLAY:
+		return ra_replay_finish(file);
 	default:
 		return -EINVAL;
 	}
@@ -59,6 +59,28 @@ static inline void force_page_cache_readahead(struct address_space *mapping,
 	force_page_cache_ra(&ractl, nr_to_read);
 }
 
+#ifdef CONFIG_READAHEAD_REPLAY
+void ra_replay_record(struct address_space *mapping, pgoff_t index,
+		unsigned long nr);
+int ra_replay_start(struct file *file);
+int ra_replay_finish(struct file *file);
+#else
+static inline void ra_replay_record(struct address_space *mapping,
+		pgoff_t index, unsigned long nr)
+{
+}
+
+static inline int ra_replay_start(struct file *file)
+{
+	return -EINVAL;
+}
+
+static inline int ra_replay_finish(struct file *file)
+{
+	return -EINVAL;
+}
+#endif
+
 unsigned find_lock_entries(struct address_space *mapping, pgoff_t start,
 		pgoff_t end, struct pagevec *pvec, pgoff_t *indices);
 
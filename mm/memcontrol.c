@@ -6429,6 +6429,38 @@ static ssize_t memory_oom_group_write(struct kernfs_open_file *of,
 	return nbytes;
 }
 
+static int memory_latency_critical_show(struct seq_file *m, void *v)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_seq(m);
+
+	seq_printf(m, "%d\n", memcg->latency_critical);
+
+	return 0;
+}
+
+static ssize_t memory_latency_critical_write(struct kernfs_open_file *of,
+					     char *buf, size_t nbytes,
+					     loff_t off)
+{
+	struct mem_cgroup *memcg = mem_cgroup_from_css(of_css(of));
+	int ret, latency_critical;
+
+	buf = strstrip(buf);
+	if (!buf)
+		return -EINVAL;
+
+	ret = kstrtoint(buf, 0, &latency_critical);
+	if (ret)
+		return ret;
+
+	if (latency_critical != 0 && latency_critical != 1)
+		return -EINVAL;
+
+	WRITE_ONCE(memcg->latency_critical, latency_critical);
+
+	return nbytes;
+}
+
 static struct cftype memory_files[] = {
 	{
 		.name = "current",
@@ -6487,6 +6519,12 @@ static struct cftype memory_files[] = {
 		.seq_show = memory_oom_group_show,
 		.write = memory_oom_group_write,
 	},
+	{
+		.name = "latency_critical",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.seq_show = memory_latency_critical_show,
+		.write = memory_latency_critical_write,
+	},
 	{ }	/* terminate */
 };
 
@@ -22,6 +22,7 @@
 #include <linux/mm_inline.h>
 #include <linux/blk-cgroup.h>
 #include <linux/fadvise.h>
+#include <linux/ioprio.h>
 #include <linux/sched/mm.h>
 
 #include "internal.h"
@@ -557,13 +558,18 @@ void page_cache_sync_ra(struct readahead_control *ractl,
 {
 	bool do_forced_ra = ractl->file && (ractl->file->f_mode & FMODE_RANDOM);
 
+	if (unlikely(test_bit(AS_RA_RECORD, &ractl->mapping->flags)))
+		ra_replay_record(ractl->mapping, readahead_index(ractl),
+				 req_count);
+
 	/*
 	 * Even if read-ahead is disabled, issue this request as read-ahead
 	 * as we'll need it to satisfy the requested range. The forced
 	 * read-ahead will do the right thing and limit the read to just the
 	 * requested range, which we'll set to 1 page for this case.
 	 */
-	if (!ractl->ra->ra_pages || blk_cgroup_congested()) {
+	if (!ractl->ra->ra_pages ||
+	    (blk_cgroup_congested() && !current_ioprio_interactive())) {
 		if (!ractl->file)
 			return;
 		req_count = 1;
@@ -597,13 +603,17 @@ void page_cache_async_ra(struct readahead_control *ractl,
 	ClearPageReadahead(page);
 
 	/*
-	 * Defer asynchronous read-ahead on IO congestion.
+	 * Defer asynchronous read-ahead on IO congestion, unless the reader
+	 * is interactive: its read-ahead goes out with its own priority and
+	 * is what it will be waiting on next.
 	 */
-	if (inode_read_congested(ractl->mapping->host))
-		return;
+	if (!current_ioprio_interactive()) {
+		if (inode_read_congested(ractl->mapping->host))
+			return;
 
-	if (blk_cgroup_congested())
-		return;
+		if (blk_cgroup_congested())
+			return;
+	}
 
 	/* do read-ahead */
 	ondemand_readahead(ractl, true, req_count);
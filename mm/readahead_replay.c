@@ -0,0 +1,291 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * mm/readahead_replay.c - record and replay file readahead.
+ *
+ * The on-demand readahead only detects sequential streams. Applications
+ * that read a file in a repeatable but non-sequential order, such as a
+ * game loading a level out of a packed asset archive, only get a small
+ * synchronous read for every miss.
+ *
+ * POSIX_FADV_RECORD makes the page cache record the misses of a file,
+ * as extents of page indices, until POSIX_FADV_REPLAY is given. The
+ * trace is then sorted, merged and kept with the inode, and every later
+ * open for reading issues all the recorded reads at once, in file order
+ * and under one plug, without waiting for them. Traces live as long as
+ * the inode is in the inode cache.
+ */
+
+#include <linux/kernel.h>
+#include <linux/blkdev.h>
+#include <linux/capability.h>
+#include <linux/fs.h>
+#include <linux/pagemap.h>
+#include <linux/refcount.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/spinlock.h>
+
+#include "internal.h"
+
+#define RA_REPLAY_MAX_EXTENTS	512
+
+struct ra_replay_extent {
+	pgoff_t index;
+	unsigned int nr;
+};
+
+struct ra_replay {
+	refcount_t ref;
+	unsigned int nr;
+	unsigned int max;
+	struct ra_replay_extent ext[];
+};
+
+/* protects mapping->ra_replay and the trace being recorded */
+static DEFINE_SPINLOCK(ra_replay_lock);
+
+static void ra_replay_put(struct ra_replay *rp)
+{
+	if (rp && refcount_dec_and_test(&rp->ref))
+		kvfree(rp);
+}
+
+/*
+ * Called from page_cache_sync_ra() with AS_RA_RECORD set, for every page
+ * cache miss. Misses that continue the previous one extend it. Once the
+ * trace is full, further misses are not recorded.
+ */
+void ra_replay_record(struct address_space *mapping, pgoff_t index,
+		unsigned long nr)
+{
+	struct ra_replay *rp;
+	struct ra_replay_extent *last;
+
+	nr = min_t(unsigned long, nr, UINT_MAX);
+
+	spin_lock(&ra_replay_lock);
+	rp = mapping->ra_replay;
+	if (!rp || !test_bit(AS_RA_RECORD, &mapping->flags))
+		goto out;
+
+	last = rp->nr ? &rp->ext[rp->nr - 1] : NULL;
+	if (last && last->index + last->nr == index &&
+	    last->nr + nr <= UINT_MAX) {
+		last->nr += nr;
+	} else if (rp->nr < rp->max) {
+		rp->ext[rp->nr].index = index;
+		rp->ext[rp->nr].nr = nr;
+		rp->nr++;
+	}
+out:
+	spin_unlock(&ra_replay_lock);
+}
+
+/*
+ * A trace is replayed in the context of whoever opens the file next, so
+ * only the owner of the inode or an administrator may record one.
+ */
+static bool ra_replay_may_record(struct file *file)
+{
+	return inode_owner_or_capable(file_mnt_user_ns(file),
+				      file_inode(file)) ||
+	       capable(CAP_SYS_ADMIN);
+}
+
+/*
+ * Start recording the misses of @file's mapping, dropping any previous
+ * trace. Restarting a recording in progress starts it over.
+ */
+int ra_replay_start(struct file *file)
+{
+	struct address_space *mapping = file->f_mapping;
+	struct ra_replay *rp, *old;
+
+	if (!(file->f_mode & FMODE_READ))
+		return -EBADF;
+
+	if (!ra_replay_may_record(file))
+		return -EPERM;
+
+	rp = kvmalloc(struct_size(rp, ext, RA_REPLAY_MAX_EXTENTS), GFP_KERNEL);
+	if (!rp)
+		return -ENOMEM;
+	refcount_set(&rp->ref, 1);
+	rp->nr = 0;
+	rp->max = RA_REPLAY_MAX_EXTENTS;
+
+	spin_lock(&ra_replay_lock);
+	old = mapping->ra_replay;
+	mapping->ra_replay = rp;
+	set_bit(AS_RA_RECORD, &mapping->flags);
+	spin_unlock(&ra_replay_lock);
+
+	ra_replay_put(old);
+	return 0;
+}
+
+static int ra_replay_cmp(const void *a, const void *b)
+{
+	const struct ra_replay_extent *x = a, *y = b;
+
+	if (x->index != y->index)
+		return x->index < y->index ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Sort the trace by index and merge the extents that overlap or touch,
+ * then keep a copy sized to what is left. Returns false if there was
+ * nothing to keep.
+ */
+static bool ra_replay_compact(struct address_space *mapping,
+		struct ra_replay *rec)
+{
+	struct ra_replay *rp;
+	unsigned int i, n = 0;
+
+	sort(rec->ext, rec->nr, sizeof(rec->ext[0]), ra_replay_cmp, NULL);
+
+	for (i = 0; i < rec->nr; i++) {
+		struct ra_replay_extent *e = &rec->ext[i];
+		struct ra_replay_extent *last = n ? &rec->ext[n - 1] : NULL;
+		pgoff_t end = e->index + e->nr;
+
+		if (last && e->index <= last->index + last->nr &&
+		    end - last->index <= UINT_MAX) {
+			if (end > last->index + last->nr)
+				last->nr = end - last->index;
+			continue;
+		}
+		rec->ext[n++] = *e;
+	}
+
+	if (!n)
+		return false;
+
+	rp = kvmalloc(struct_size(rp, ext, n), GFP_KERNEL);
+	if (!rp)
+		return false;
+	refcount_set(&rp->ref, 1);
+	rp->nr = n;
+	rp->max = n;
+	memcpy(rp->ext, rec->ext, n * sizeof(rp->ext[0]));
+
+	spin_lock(&ra_replay_lock);
+	/* a new recording may have been started meanwhile */
+	if (!mapping->ra_replay) {
+		mapping->ra_replay = rp;
+		rp = NULL;
+	}
+	spin_unlock(&ra_replay_lock);
+
+	ra_replay_put(rp);
+	return true;
+}
+
+/*
+ * Issue the reads of the trace, in file order. Pages already in the page
+ * cache are skipped, and do_page_cache_ra() stops at the end of the file,
+ * so a trace of a file that has since shrunk does no harm.
+ */
+static void ra_replay_issue(struct file *file, struct ra_replay *rp)
+{
+	struct address_space *mapping = file->f_mapping;
+	struct blk_plug plug;
+	unsigned int i;
+
+	if (unlikely(!mapping->a_ops->readpage && !mapping->a_ops->readpages &&
+			!mapping->a_ops->readahead))
+		return;
+
+	blk_start_plug(&plug);
+	for (i = 0; i < rp->nr; i++) {
+		DEFINE_READAHEAD(ractl, file, &file->f_ra, mapping,
+				 rp->ext[i].index);
+		unsigned long nr = rp->ext[i].nr;
+
+		/* same 2 megabyte units as force_page_cache_ra() */
+		while (nr) {
+			unsigned long this_chunk = min_t(unsigned long, nr,
+					(2 * 1024 * 1024) / PAGE_SIZE);
+
+			ractl._index = rp->ext[i].index + rp->ext[i].nr - nr;
+			do_page_cache_ra(&ractl, this_chunk, 0);
+			nr -= this_chunk;
+		}
+	}
+	blk_finish_plug(&plug);
+}
+
+static struct ra_replay *ra_replay_get(struct address_space *mapping)
+{
+	struct ra_replay *rp;
+
+	spin_lock(&ra_replay_lock);
+	rp = mapping->ra_replay;
+	if (rp && !test_bit(AS_RA_RECORD, &mapping->flags))
+		refcount_inc(&rp->ref);
+	else
+		rp = NULL;
+	spin_unlock(&ra_replay_lock);
+
+	return rp;
+}
+
+/*
+ * Stop a recording in progress and keep its trace, then replay the trace
+ * for @file.
+ */
+int ra_replay_finish(struct file *file)
+{
+	struct address_space *mapping = file->f_mapping;
+	struct ra_replay *rec = NULL, *rp;
+
+	if (!(file->f_mode & FMODE_READ))
+		return -EBADF;
+
+	spin_lock(&ra_replay_lock);
+	if (test_and_clear_bit(AS_RA_RECORD, &mapping->flags)) {
+		rec = mapping->ra_replay;
+		mapping->ra_replay = NULL;
+	}
+	spin_unlock(&ra_replay_lock);
+
+	if (rec) {
+		ra_replay_compact(mapping, rec);
+		ra_replay_put(rec);
+	}
+
+	rp = ra_replay_get(mapping);
+	if (rp) {
+		ra_replay_issue(file, rp);
+		ra_replay_put(rp);
+	}
+	return 0;
+}
+
+/*
+ * Called through file_ra_replay() when a file with a trace is opened.
+ */
+void __file_ra_replay(struct file *file)
+{
+	struct ra_replay *rp;
+
+	if (!(file->f_mode & FMODE_READ) || (file->f_flags & O_DIRECT))
+		return;
+
+	rp = ra_replay_get(file->f_mapping);
+	if (!rp)
+		return;
+
+	ra_replay_issue(file, rp);
+	ra_replay_put(rp);
+}
+
+/* Called when the inode is destroyed. */
+void ra_replay_free(struct address_space *mapping)
+{
+	clear_bit(AS_RA_RECORD, &mapping->flags);
+	ra_replay_put(mapping->ra_replay);
+	mapping->ra_replay = NULL;
+}
@@ -111,6 +111,13 @@ struct scan_control {
 	unsigned int memcg_low_reclaim:1;
 	unsigned int memcg_low_skipped:1;
 
+	/*
+	 * Reclaim on behalf of a task in a memory.latency_critical group.
+	 * Only clean page cache is reclaimed in the first passes, so the
+	 * task doesn't wait on swap out unless memory is really short.
+	 */
+	unsigned int latency_bound:1;
+
 	unsigned int hibernation_mode:1;
 
 	/* One of the zones is ready for compaction */
@@ -157,6 +164,12 @@ struct scan_control {
 	struct reclaim_state reclaim_state;
 };
 
+/*
+ * Priority down to which memory.latency_critical groups are spared, and
+ * their own reclaim sticks to page cache.
+ */
+#define LATENCY_PRIORITY	(DEF_PRIORITY / 2)
+
 #ifdef ARCH_HAS_PREFETCHW
 #define prefetchw_prev_lru_page(_page, _base, _field)			\
 	do {								\
@@ -2590,6 +2603,11 @@ static void get_scan_count(struct lruvec *lruvec, struct scan_control *sc,
 		goto out;
 	}
 
+	if (sc->latency_bound && sc->priority > LATENCY_PRIORITY) {
+		scan_balance = SCAN_FILE;
+		goto out;
+	}
+
 	/*
 	 * Global reclaim will swap to prevent OOM even with no
 	 * swappiness, but memcg users want to use this knob to
@@ -2972,6 +2990,8 @@ static inline bool should_continue_reclaim(struct pglist_data *pgdat,
 static void shrink_node_memcgs(pg_data_t *pgdat, struct scan_control *sc)
 {
 	struct mem_cgroup *target_memcg = sc->target_mem_cgroup;
+	bool spare_latency = !mem_cgroup_latency_critical(target_memcg) &&
+			     sc->priority > LATENCY_PRIORITY;
 	struct mem_cgroup *memcg;
 
 	memcg = mem_cgroup_iter(target_memcg, NULL, NULL);
@@ -3010,6 +3030,17 @@ static void shrink_node_memcgs(pg_data_t *pgdat, struct scan_control *sc)
 			memcg_memory_event(memcg, MEMCG_LOW);
 		}
 
+		/*
+		 * Latency critical groups are passed over until
+		 * reclaim from everybody else gets difficult, or
+		 * came up with nothing at all.
+		 */
+		if (spare_latency && !sc->memcg_low_reclaim &&
+		    mem_cgroup_latency_critical(memcg)) {
+			sc->memcg_low_skipped = 1;
+			continue;
+		}
+
 		reclaimed = sc->nr_reclaimed;
 		scanned = sc->nr_scanned;
 
@@ -3608,6 +3639,7 @@ unsigned long try_to_free_pages(struct zonelist *zonelist, int order,
 		.may_writepage = !laptop_mode,
 		.may_unmap = 1,
 		.may_swap = 1,
+		.latency_bound = current_latency_critical(),
 	};
 
 	/*
@@ -3696,6 +3728,7 @@ unsigned long try_to_free_mem_cgroup_pages(struct mem_cgroup *memcg,
 		.may_writepage = !laptop_mode,
 		.may_unmap = 1,
 		.may_swap = may_swap,
+		.latency_bound = current_latency_critical(),
 	};
 	/*
 	 * Traverse the ZONELIST_FALLBACK zonelist of the current node to put
@@ -130,6 +130,7 @@ module_param_named(same_filled_pages_enabled, zswap_same_filled_pages_enabled,
 **********************************/
 
 struct crypto_acomp_ctx {
+	struct crypto_comp *comp;
 	struct crypto_acomp *acomp;
 	struct acomp_req *req;
 	struct crypto_wait wait;
@@ -446,9 +447,24 @@ static int zswap_cpu_comp_prepare(unsigned int cpu, struct hlist_node *node)
 {
 	struct zswap_pool *pool = hlist_entry(node, struct zswap_pool, node);
 	struct crypto_acomp_ctx *acomp_ctx = per_cpu_ptr(pool->acomp_ctx, cpu);
+	struct crypto_comp *comp;
 	struct crypto_acomp *acomp;
 	struct acomp_req *req;
 
+	acomp_ctx->mutex = per_cpu(zswap_mutex, cpu);
+	acomp_ctx->dstmem = per_cpu(zswap_dstmem, cpu);
+
+	/*
+	 * Software compressors are used directly through their synchronous
+	 * interface. Going through acomp would make the scomp layer copy
+	 * every page through its own per-cpu scratch buffers and back.
+	 */
+	comp = crypto_alloc_comp(pool->tfm_name, 0, 0);
+	if (!IS_ERR(comp)) {
+		acomp_ctx->comp = comp;
+		return 0;
+	}
+
 	acomp = crypto_alloc_acomp_node(pool->tfm_name, 0, 0, cpu_to_node(cpu));
 	if (IS_ERR(acomp)) {
 		pr_err("could not alloc crypto acomp %s : %ld\n",
@@ -475,9 +491,6 @@ static int zswap_cpu_comp_prepare(unsigned int cpu, struct hlist_node *node)
 	acomp_request_set_callback(req, CRYPTO_TFM_REQ_MAY_BACKLOG,
 				   crypto_req_done, &acomp_ctx->wait);
 
-	acomp_ctx->mutex = per_cpu(zswap_mutex, cpu);
-	acomp_ctx->dstmem = per_cpu(zswap_dstmem, cpu);
-
 	return 0;
 }
 
@@ -487,15 +500,92 @@ static int zswap_cpu_comp_dead(unsigned int cpu, struct hlist_node *node)
 	struct crypto_acomp_ctx *acomp_ctx = per_cpu_ptr(pool->acomp_ctx, cpu);
 
 	if (!IS_ERR_OR_NULL(acomp_ctx)) {
+		if (!IS_ERR_OR_NULL(acomp_ctx->comp))
+			crypto_free_comp(acomp_ctx->comp);
 		if (!IS_ERR_OR_NULL(acomp_ctx->req))
 			acomp_request_free(acomp_ctx->req);
 		if (!IS_ERR_OR_NULL(acomp_ctx->acomp))
 			crypto_free_acomp(acomp_ctx->acomp);
+		/* the CPU may come back and take the acomp path instead */
+		acomp_ctx->comp = NULL;
+		acomp_ctx->req = NULL;
+		acomp_ctx->acomp = NULL;
 	}
 
 	return 0;
 }
 
+/*
+ * Compress @page into acomp_ctx->dstmem, which is PAGE_SIZE * 2 bytes.
+ * Caller holds acomp_ctx->mutex.
+ */
+static int zswap_compress(struct crypto_acomp_ctx *acomp_ctx,
+			  struct page *page, unsigned int *dlen)
+{
+	struct scatterlist input, output;
+	u8 *src;
+	int ret;
+
+	*dlen = PAGE_SIZE * 2;
+	if (acomp_ctx->comp) {
+		src = kmap_atomic(page);
+		ret = crypto_comp_compress(acomp_ctx->comp, src, PAGE_SIZE,
+					   acomp_ctx->dstmem, dlen);
+		kunmap_atomic(src);
+		return ret;
+	}
+
+	sg_init_table(&input, 1);
+	sg_set_page(&input, page, PAGE_SIZE, 0);
+	sg_init_one(&output, acomp_ctx->dstmem, PAGE_SIZE * 2);
+	acomp_request_set_params(acomp_ctx->req, &input, &output, PAGE_SIZE, *dlen);
+	/*
+	 * it maybe looks a little bit silly that we send an asynchronous request,
+	 * then wait for its completion synchronously. This makes the process look
+	 * synchronous in fact.
+	 * Theoretically, acomp supports users send multiple acomp requests in one
+	 * acomp instance, then get those requests done simultaneously. but in this
+	 * case, frontswap actually does store and load page by page, there is no
+	 * existing method to send the second page before the first page is done
+	 * in one thread doing frontswap.
+	 * but in different threads running on different cpu, we have different
+	 * acomp instance, so multiple threads can do (de)compression in parallel.
+	 */
+	ret = crypto_wait_req(crypto_acomp_compress(acomp_ctx->req), &acomp_ctx->wait);
+	*dlen = acomp_ctx->req->dlen;
+	return ret;
+}
+
+/*
+ * Decompress @slen bytes at @src into @page. Returns the decompressed
+ * length in @dlen. Caller holds acomp_ctx->mutex.
+ */
+static int zswap_decompress(struct crypto_acomp_ctx *acomp_ctx,
+			    const u8 *src, unsigned int slen,
+			    struct page *page, unsigned int *dlen)
+{
+	struct scatterlist input, output;
+	u8 *dst;
+	int ret;
+
+	*dlen = PAGE_SIZE;
+	if (acomp_ctx->comp) {
+		dst = kmap_atomic(page);
+		ret = crypto_comp_decompress(acomp_ctx->comp, src, slen,
+					     dst, dlen);
+		kunmap_atomic(dst);
+		return ret;
+	}
+
+	sg_init_one(&input, src, slen);
+	sg_init_table(&output, 1);
+	sg_set_page(&output, page, PAGE_SIZE, 0);
+	acomp_request_set_params(acomp_ctx->req, &input, &output, slen, *dlen);
+	ret = crypto_wait_req(crypto_acomp_decompress(acomp_ctx->req), &acomp_ctx->wait);
+	*dlen = acomp_ctx->req->dlen;
+	return ret;
+}
+
 /*********************************
 * pool functions
 **********************************/
@@ -932,7 +1022,6 @@ static int zswap_writeback_entry(struct zpool *pool, unsigned long handle)
 	pgoff_t offset;
 	struct zswap_entry *entry;
 	struct page *page;
-	struct scatterlist input, output;
 	struct crypto_acomp_ctx *acomp_ctx;
 
 	u8 *src, *tmp = NULL;
@@ -989,15 +1078,9 @@ static int zswap_writeback_entry(struct zpool *pool, unsigned long handle)
 	case ZSWAP_SWAPCACHE_NEW: /* page is locked */
 		/* decompress */
 		acomp_ctx = raw_cpu_ptr(entry->pool->acomp_ctx);
-		dlen = PAGE_SIZE;
 
 		mutex_lock(acomp_ctx->mutex);
-		sg_init_one(&input, src, entry->length);
-		sg_init_table(&output, 1);
-		sg_set_page(&output, page, PAGE_SIZE, 0);
-		acomp_request_set_params(acomp_ctx->req, &input, &output, entry->length, dlen);
-		ret = crypto_wait_req(crypto_acomp_decompress(acomp_ctx->req), &acomp_ctx->wait);
-		dlen = acomp_ctx->req->dlen;
+		ret = zswap_decompress(acomp_ctx, src, entry->length, page, &dlen);
 		mutex_unlock(acomp_ctx->mutex);
 
 		BUG_ON(ret);
@@ -1059,7 +1142,11 @@ static int zswap_is_page_same_filled(void *ptr, unsigned long *value)
 	unsigned long *page;
 
 	page = (unsigned long *)ptr;
-	for (pos = 1; pos < PAGE_SIZE / sizeof(*page); pos++) {
+	/* most pages that are not same-filled differ at the two ends */
+	if (page[PAGE_SIZE / sizeof(*page) - 1] != page[0])
+		return 0;
+
+	for (pos = 1; pos < PAGE_SIZE / sizeof(*page) - 1; pos++) {
 		if (page[pos] != page[0])
 			return 0;
 	}
@@ -1084,10 +1171,9 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 {
 	struct zswap_tree *tree = zswap_trees[type];
 	struct zswap_entry *entry, *dupentry;
-	struct scatterlist input, output;
 	struct crypto_acomp_ctx *acomp_ctx;
 	int ret;
-	unsigned int hlen, dlen = PAGE_SIZE;
+	unsigned int hlen, dlen;
 	unsigned long handle, value;
 	char *buf;
 	u8 *src, *dst;
@@ -1160,27 +1246,7 @@ static int zswap_frontswap_store(unsigned type, pgoff_t offset,
 	mutex_lock(acomp_ctx->mutex);
 
 	dst = acomp_ctx->dstmem;
-	sg_init_table(&input, 1);
-	sg_set_page(&input, page, PAGE_SIZE, 0);
-
-	/* zswap_dstmem is of size (PAGE_SIZE * 2). Reflect same in sg_list */
-	sg_init_one(&output, dst, PAGE_SIZE * 2);
-	acomp_request_set_params(acomp_ctx->req, &input, &output, PAGE_SIZE, dlen);
-	/*
-	 * it maybe looks a little bit silly that we send an asynchronous request,
-	 * then wait for its completion synchronously. This makes the process look
-	 * synchronous in fact.
-	 * Theoretically, acomp supports users send multiple acomp requests in one
-	 * acomp instance, then get those requests done simultaneously. but in this
-	 * case, frontswap actually does store and load page by page, there is no
-	 * existing method to send the second page before the first page is done
-	 * in one thread doing frontswap.
-	 * but in different threads running on different cpu, we have different
-	 * acomp instance, so multiple threads can do (de)compression in parallel.
-	 */
-	ret = crypto_wait_req(crypto_acomp_compress(acomp_ctx->req), &acomp_ctx->wait);
-	dlen = acomp_ctx->req->dlen;
-
+	ret = zswap_compress(acomp_ctx, page, &dlen);
 	if (ret) {
 		ret = -EINVAL;
 		goto put_dstmem;
@@ -1249,7 +1315,6 @@ static int zswap_frontswap_load(unsigned type, pgoff_t offset,
 {
 	struct zswap_tree *tree = zswap_trees[type];
 	struct zswap_entry *entry;
-	struct scatterlist input, output;
 	struct crypto_acomp_ctx *acomp_ctx;
 	u8 *src, *dst, *tmp;
 	unsigned int dlen;
@@ -1283,7 +1348,6 @@ static int zswap_frontswap_load(unsigned type, pgoff_t offset,
 	}
 
 	/* decompress */
-	dlen = PAGE_SIZE;
 	src = zpool_map_handle(entry->pool->zpool, entry->handle, ZPOOL_MM_RO);
 	if (zpool_evictable(entry->pool->zpool))
 		src += sizeof(struct zswap_header);
@@ -1298,11 +1362,7 @@ static int zswap_frontswap_load(unsigned type, pgoff_t offset,
 
 	acomp_ctx = raw_cpu_ptr(entry->pool->acomp_ctx);
 	mutex_lock(acomp_ctx->mutex);
-	sg_init_one(&input, src, entry->length);
-	sg_init_table(&output, 1);
-	sg_set_page(&output, page, PAGE_SIZE, 0);
-	acomp_request_set_params(acomp_ctx->req, &input, &output, entry->length, dlen);
-	ret = crypto_wait_req(crypto_acomp_decompress(acomp_ctx->req), &acomp_ctx->wait);
+	ret = zswap_decompress(acomp_ctx, src, entry->length, page, &dlen);
 	mutex_unlock(acomp_ctx->mutex);
 
 	if (zpool_can_sleep_mapped(entry->pool->zpool))
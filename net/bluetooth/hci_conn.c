@@ -490,9 +490,18 @@ static void hci_conn_idle(struct work_struct *work)
 
 	if (!test_and_set_bit(HCI_CONN_MODE_CHANGE_PEND, &conn->flags)) {
 		struct hci_cp_sniff_mode cp;
+		u16 min = READ_ONCE(conn->sniff_min_interval);
+		u16 max = READ_ONCE(conn->sniff_max_interval);
+
+		/* a range being changed from sysfs may be seen half set */
+		if (!min || !max || min > max) {
+			min = hdev->sniff_min_interval;
+			max = hdev->sniff_max_interval;
+		}
+
 		cp.handle       = cpu_to_le16(conn->handle);
-		cp.max_interval = cpu_to_le16(hdev->sniff_max_interval);
-		cp.min_interval = cpu_to_le16(hdev->sniff_min_interval);
+		cp.max_interval = cpu_to_le16(max);
+		cp.min_interval = cpu_to_le16(min);
 		cp.attempt      = cpu_to_le16(4);
 		cp.timeout      = cpu_to_le16(1);
 		hci_send_cmd(hdev, HCI_OP_SNIFF_MODE, sizeof(cp), &cp);
@@ -1594,6 +1603,71 @@ void hci_conn_enter_active_mode(struct hci_conn *conn, __u8 force_active)
 				   msecs_to_jiffies(hdev->idle_timeout));
 }
 
+struct hci_conn_sniff_kick {
+	struct work_struct work;
+	struct hci_dev *hdev;
+	__u16 handle;
+};
+
+/* Wake up a link in sniff mode, so that it goes idle with its new range */
+static void hci_conn_sniff_kick_work(struct work_struct *work)
+{
+	struct hci_conn_sniff_kick *kick =
+		container_of(work, struct hci_conn_sniff_kick, work);
+	struct hci_dev *hdev = kick->hdev;
+	struct hci_conn *conn;
+
+	hci_dev_lock(hdev);
+	conn = hci_conn_hash_lookup_handle(hdev, kick->handle);
+	if (conn && conn->type == ACL_LINK)
+		hci_conn_enter_active_mode(conn, 1);
+	hci_dev_unlock(hdev);
+
+	hci_dev_put(hdev);
+	kfree(kick);
+}
+
+/**
+ * hci_conn_set_sniff_interval - set the sniff interval range of a link
+ * @conn: ACL link
+ * @min: minimum interval in baseband slots (0.625ms), 0 for the default
+ * @max: maximum interval in baseband slots, 0 for the default
+ *
+ * Lets a profile trade power for latency, e.g. an input device while a
+ * game runs. A link in sniff mode is woken up, so that the new range
+ * applies when it goes idle again. The interval the controller picked
+ * is reported in conn->mode_interval once the link enters sniff mode.
+ *
+ * Does not take hci_dev_lock, so it may be called from a sysfs attribute
+ * of the link, whose removal runs under that lock. The wake up is done
+ * from a work item instead, which looks the link up by its handle.
+ */
+int hci_conn_set_sniff_interval(struct hci_conn *conn, u16 min, u16 max)
+{
+	struct hci_conn_sniff_kick *kick;
+
+	if (conn->type != ACL_LINK)
+		return -EINVAL;
+
+	if (min % 2 || max % 2 || !min != !max || min > max)
+		return -EINVAL;
+
+	kick = kmalloc(sizeof(*kick), GFP_KERNEL);
+	if (!kick)
+		return -ENOMEM;
+
+	WRITE_ONCE(conn->sniff_min_interval, min);
+	WRITE_ONCE(conn->sniff_max_interval, max);
+
+	INIT_WORK(&kick->work, hci_conn_sniff_kick_work);
+	kick->hdev = hci_dev_hold(conn->hdev);
+	kick->handle = conn->handle;
+	schedule_work(&kick->work);
+
+	return 0;
+}
+EXPORT_SYMBOL(hci_conn_set_sniff_interval);
+
 /* Drop all connection on the device */
 void hci_conn_hash_flush(struct hci_dev *hdev)
 {
@@ -14,8 +14,55 @@ static void bt_link_release(struct device *dev)
 	kfree(conn);
 }
 
+/* requested sniff interval range in slots, "0 0" for the adapter default */
+static ssize_t sniff_interval_show(struct device *dev,
+				   struct device_attribute *attr, char *buf)
+{
+	struct hci_conn *conn = to_hci_conn(dev);
+
+	return sysfs_emit(buf, "%u %u\n", READ_ONCE(conn->sniff_min_interval),
+			  READ_ONCE(conn->sniff_max_interval));
+}
+
+static ssize_t sniff_interval_store(struct device *dev,
+				    struct device_attribute *attr,
+				    const char *buf, size_t count)
+{
+	struct hci_conn *conn = to_hci_conn(dev);
+	u16 min, max;
+	int err;
+
+	if (sscanf(buf, "%hu %hu", &min, &max) != 2)
+		return -EINVAL;
+
+	/* no hci_dev_lock, hci_conn_del() removes this file under it */
+	err = hci_conn_set_sniff_interval(conn, min, max);
+
+	return err ? err : count;
+}
+static DEVICE_ATTR_RW(sniff_interval);
+
+/* interval of the current mode in slots, 0 while active */
+static ssize_t mode_interval_show(struct device *dev,
+				  struct device_attribute *attr, char *buf)
+{
+	struct hci_conn *conn = to_hci_conn(dev);
+
+	return sysfs_emit(buf, "%u\n", conn->mode == HCI_CM_ACTIVE ?
+			  0 : conn->mode_interval);
+}
+static DEVICE_ATTR_RO(mode_interval);
+
+static struct attribute *bt_link_attrs[] = {
+	&dev_attr_sniff_interval.attr,
+	&dev_attr_mode_interval.attr,
+	NULL
+};
+ATTRIBUTE_GROUPS(bt_link);
+
 static const struct device_type bt_link = {
 	.name    = "link",
+	.groups  = bt_link_groups,
 	.release = bt_link_release,
 };
 
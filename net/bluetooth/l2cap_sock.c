@@ -1590,6 +1590,14 @@ static struct sk_buff *l2cap_sock_alloc_skb_cb(struct l2cap_chan *chan,
 
 	skb->priority = sk->sk_priority;
 
+	/*
+	 * HID output reports (rumble, LEDs) should not queue up behind
+	 * bulk and audio traffic on the same adapter. Only the default
+	 * priority is raised, SO_PRIORITY still wins.
+	 */
+	if (!skb->priority && chan->psm == cpu_to_le16(L2CAP_PSM_HIDP_INTR))
+		skb->priority = HCI_PRIO_MAX - 1;
+
 	bt_cb(skb)->l2cap.chan = chan;
 
 	return skb;
@@ -2722,6 +2722,12 @@ int udp_lib_setsockopt(struct sock *sk, int level, int optname,
 		release_sock(sk);
 		break;
 
+	case UDP_GRO_HOLD:
+		if (val < 0)
+			return -EINVAL;
+		WRITE_ONCE(up->gro_hold_us, val);
+		break;
+
 	/*
 	 * 	UDP-Lite's partial checksum coverage (RFC 3828).
 	 */
@@ -2810,6 +2816,10 @@ int udp_lib_getsockopt(struct sock *sk, int level, int optname,
 		val = up->gro_enabled;
 		break;
 
+	case UDP_GRO_HOLD:
+		val = READ_ONCE(up->gro_hold_us);
+		break;
+
 	/* The following two cannot be changed on UDP sockets, the return is
 	 * always 0 (which corresponds to the full checksum coverage of UDP). */
 	case UDPLITE_SEND_CSCOV:
@@ -425,10 +425,19 @@ static struct sk_buff *udp4_ufo_fragment(struct sk_buff *skb,
 }
 
 #define UDP_GRO_CNT_MAX 64
-static struct sk_buff *udp_gro_receive_segment(struct list_head *head,
+/* The first segment of @p arrived more than the socket's UDP_GRO_HOLD ago */
+static bool udp_gro_hold_expired(const struct sk_buff *p, u32 hold_us)
+{
+	return hold_us && p->tstamp &&
+	       ktime_us_delta(ktime_get_real(), p->tstamp) >= hold_us;
+}
+
+static struct sk_buff *udp_gro_receive_segment(struct sock *sk,
+					       struct list_head *head,
 					       struct sk_buff *skb)
 {
 	struct udphdr *uh = udp_gro_udphdr(skb);
+	u32 hold_us = sk ? READ_ONCE(udp_sk(sk)->gro_hold_us) : 0;
 	struct sk_buff *pp = NULL;
 	struct udphdr *uh2;
 	struct sk_buff *p;
@@ -496,12 +505,17 @@ static struct sk_buff *udp_gro_receive_segment(struct list_head *head,
 		}
 
 		if (ret || ulen != ntohs(uh2->len) ||
-		    NAPI_GRO_CB(p)->count >= UDP_GRO_CNT_MAX)
+		    NAPI_GRO_CB(p)->count >= UDP_GRO_CNT_MAX ||
+		    udp_gro_hold_expired(p, hold_us))
 			pp = p;
 
 		return pp;
 	}
 
+	/* start of a new GRO packet, remember when for UDP_GRO_HOLD */
+	if (hold_us && !skb->tstamp)
+		__net_timestamp(skb);
+
 	/* mismatch, but we never need to flush */
 	return NULL;
 }
@@ -525,7 +539,8 @@ struct sk_buff *udp_gro_receive(struct list_head *head, struct sk_buff *skb,
 
 		if ((!sk && (skb->dev->features & NETIF_F_GRO_UDP_FWD)) ||
 		    (sk && udp_sk(sk)->gro_enabled) || NAPI_GRO_CB(skb)->is_flist)
-			return call_gro_receive(udp_gro_receive_segment, head, skb);
+			return call_gro_receive_sk(udp_gro_receive_segment, sk,
+						   head, skb);
 
 		/* no GRO, be sure flush the current packet */
 		goto out;
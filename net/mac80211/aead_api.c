@@ -15,21 +15,47 @@
 
 #include "aead_api.h"
 
-int aead_encrypt(struct crypto_aead *tfm, u8 *b_0, u8 *aad, size_t aad_len,
-		 u8 *data, size_t data_len, u8 *mic)
+/*
+ * The request is followed by room for the AAD, since the callers keep it
+ * on the stack, which may not be mapped for the scatterlist.
+ */
+struct aead_request *aead_req_alloc(struct crypto_aead *tfm, size_t aad_len)
 {
-	size_t mic_len = crypto_aead_authsize(tfm);
-	struct scatterlist sg[3];
 	struct aead_request *aead_req;
 	int reqsize = sizeof(*aead_req) + crypto_aead_reqsize(tfm);
-	u8 *__aad;
-	int ret;
 
 	aead_req = kzalloc(reqsize + aad_len, GFP_ATOMIC);
-	if (!aead_req)
-		return -ENOMEM;
+	if (aead_req)
+		aead_request_set_tfm(aead_req, tfm);
+
+	return aead_req;
+}
+
+void aead_req_free(struct aead_request *aead_req)
+{
+	kfree_sensitive(aead_req);
+}
+
+static u8 *aead_req_aad(struct aead_request *aead_req)
+{
+	struct crypto_aead *tfm = crypto_aead_reqtfm(aead_req);
+
+	return (u8 *)aead_req + sizeof(*aead_req) + crypto_aead_reqsize(tfm);
+}
+
+/*
+ * Encrypt with a request from aead_req_alloc(), which may be used again
+ * for the next frame. @aad_len must not exceed the one it was allocated
+ * for.
+ */
+int aead_encrypt_req(struct aead_request *aead_req, u8 *b_0, u8 *aad,
+		     size_t aad_len, u8 *data, size_t data_len, u8 *mic)
+{
+	struct crypto_aead *tfm = crypto_aead_reqtfm(aead_req);
+	size_t mic_len = crypto_aead_authsize(tfm);
+	struct scatterlist sg[3];
+	u8 *__aad = aead_req_aad(aead_req);
 
-	__aad = (u8 *)aead_req + reqsize;
 	memcpy(__aad, aad, aad_len);
 
 	sg_init_table(sg, 3);
@@ -37,12 +63,25 @@ int aead_encrypt(struct crypto_aead *tfm, u8 *b_0, u8 *aad, size_t aad_len,
 	sg_set_buf(&sg[1], data, data_len);
 	sg_set_buf(&sg[2], mic, mic_len);
 
-	aead_request_set_tfm(aead_req, tfm);
 	aead_request_set_crypt(aead_req, sg, sg, data_len, b_0);
 	aead_request_set_ad(aead_req, sg[0].length);
 
-	ret = crypto_aead_encrypt(aead_req);
-	kfree_sensitive(aead_req);
+	return crypto_aead_encrypt(aead_req);
+}
+
+int aead_encrypt(struct crypto_aead *tfm, u8 *b_0, u8 *aad, size_t aad_len,
+		 u8 *data, size_t data_len, u8 *mic)
+{
+	struct aead_request *aead_req;
+	int ret;
+
+	aead_req = aead_req_alloc(tfm, aad_len);
+	if (!aead_req)
+		return -ENOMEM;
+
+	ret = aead_encrypt_req(aead_req, b_0, aad, aad_len, data, data_len,
+			       mic);
+	aead_req_free(aead_req);
 
 	return ret;
 }
@@ -53,18 +92,17 @@ int aead_decrypt(struct crypto_aead *tfm, u8 *b_0, u8 *aad, size_t aad_len,
 	size_t mic_len = crypto_aead_authsize(tfm);
 	struct scatterlist sg[3];
 	struct aead_request *aead_req;
-	int reqsize = sizeof(*aead_req) + crypto_aead_reqsize(tfm);
 	u8 *__aad;
 	int err;
 
 	if (data_len == 0)
 		return -EINVAL;
 
-	aead_req = kzalloc(reqsize + aad_len, GFP_ATOMIC);
+	aead_req = aead_req_alloc(tfm, aad_len);
 	if (!aead_req)
 		return -ENOMEM;
 
-	__aad = (u8 *)aead_req + reqsize;
+	__aad = aead_req_aad(aead_req);
 	memcpy(__aad, aad, aad_len);
 
 	sg_init_table(sg, 3);
@@ -72,12 +110,11 @@ int aead_decrypt(struct crypto_aead *tfm, u8 *b_0, u8 *aad, size_t aad_len,
 	sg_set_buf(&sg[1], data, data_len);
 	sg_set_buf(&sg[2], mic, mic_len);
 
-	aead_request_set_tfm(aead_req, tfm);
 	aead_request_set_crypt(aead_req, sg, sg, data_len + mic_len, b_0);
 	aead_request_set_ad(aead_req, sg[0].length);
 
 	err = crypto_aead_decrypt(aead_req);
-	kfree_sensitive(aead_req);
+	aead_req_free(aead_req);
 
 	return err;
 }
@@ -10,6 +10,13 @@ struct crypto_aead *
 aead_key_setup_encrypt(const char *alg, const u8 key[],
 		       size_t key_len, size_t mic_len);
 
+struct aead_request *aead_req_alloc(struct crypto_aead *tfm, size_t aad_len);
+
+void aead_req_free(struct aead_request *aead_req);
+
+int aead_encrypt_req(struct aead_request *aead_req, u8 *b_0, u8 *aad,
+		     size_t aad_len, u8 *data, size_t data_len, u8 *mic);
+
 int aead_encrypt(struct crypto_aead *tfm, u8 *b_0, u8 *aad,
 		 size_t aad_len, u8 *data,
 		 size_t data_len, u8 *mic);
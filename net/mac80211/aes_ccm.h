@@ -27,6 +27,27 @@ ieee80211_aes_ccm_encrypt(struct crypto_aead *tfm,
 			    data, data_len, mic);
 }
 
+static inline struct aead_request *
+ieee80211_aes_ccm_req_alloc(struct crypto_aead *tfm)
+{
+	return aead_req_alloc(tfm, CCM_AAD_LEN - 2);
+}
+
+static inline void ieee80211_aes_ccm_req_free(struct aead_request *req)
+{
+	aead_req_free(req);
+}
+
+static inline int
+ieee80211_aes_ccm_encrypt_req(struct aead_request *req,
+			      u8 *b_0, u8 *aad, u8 *data,
+			      size_t data_len, u8 *mic)
+{
+	return aead_encrypt_req(req, b_0, aad + 2,
+				be16_to_cpup((__be16 *)aad),
+				data, data_len, mic);
+}
+
 static inline int
 ieee80211_aes_ccm_decrypt(struct crypto_aead *tfm,
 			  u8 *b_0, u8 *aad, u8 *data,
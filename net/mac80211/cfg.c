@@ -1690,6 +1690,15 @@ static int sta_apply_parameters(struct ieee80211_local *local,
 	if (params->airtime_weight)
 		sta_apply_airtime_params(local, sta, params);
 
+	if (params->sta_modify_mask & STATION_PARAM_APPLY_AIRTIME_LATENCY)
+		sta_airtime_set_lowlat(local, sta,
+				       params->airtime_latency_critical);
+
+	if (params->sta_modify_mask & STATION_PARAM_APPLY_PS_LOWLAT) {
+		sta->ps_lowlat.tids = params->ps_lowlat_tids;
+		sta->ps_lowlat.interval = params->ps_lowlat_interval;
+		sta->ps_lowlat.last = 0;
+	}
 
 	/* set the STA state after all sta info from usermode has been set */
 	if (test_sta_flag(sta, WLAN_STA_TDLS_PEER) ||
@@ -4086,29 +4095,70 @@ ieee80211_abort_pmsr(struct wiphy *wiphy, struct wireless_dev *dev,
 	return drv_abort_pmsr(local, sdata, request);
 }
 
+static void ieee80211_apply_ampdu_policy(struct sta_info *sta,
+					 struct cfg80211_tid_cfg *conf)
+{
+	unsigned long tids = conf->tids;
+	int tid;
+
+	for_each_set_bit(tid, &tids, IEEE80211_NUM_TIDS) {
+		struct ieee80211_ampdu_policy *policy =
+			&sta->sta.ampdu_policy[tid];
+
+		if (conf->mask & BIT(NL80211_TID_CONFIG_ATTR_AMPDU_MAX_LEN))
+			policy->max_len = conf->ampdu_max_len;
+		if (conf->mask & BIT(NL80211_TID_CONFIG_ATTR_AMPDU_MAX_DURATION))
+			policy->max_duration = conf->ampdu_max_duration;
+		if (conf->mask & BIT(NL80211_TID_CONFIG_ATTR_AMPDU_MAX_DELAY))
+			policy->max_delay = conf->ampdu_max_delay;
+	}
+
+	conf->mask &= ~IEEE80211_TID_CONFIG_AMPDU_POLICY;
+}
+
 static int ieee80211_set_tid_config(struct wiphy *wiphy,
 				    struct net_device *dev,
 				    struct cfg80211_tid_config *tid_conf)
 {
 	struct ieee80211_sub_if_data *sdata = IEEE80211_DEV_TO_SUB_IF(dev);
+	struct ieee80211_local *local = sdata->local;
+	bool drv_conf = false;
 	struct sta_info *sta;
-	int ret;
+	int ret = 0;
+	u32 i;
 
-	if (!sdata->local->ops->set_tid_config)
+	if (!local->ops->set_tid_config &&
+	    !ieee80211_hw_check(&local->hw, SUPPORTS_AMPDU_POLICY))
 		return -EOPNOTSUPP;
 
-	if (!tid_conf->peer)
-		return drv_set_tid_config(sdata->local, sdata, NULL, tid_conf);
+	if (!tid_conf->peer) {
+		if (!local->ops->set_tid_config)
+			return -EOPNOTSUPP;
+		return drv_set_tid_config(local, sdata, NULL, tid_conf);
+	}
 
-	mutex_lock(&sdata->local->sta_mtx);
+	mutex_lock(&local->sta_mtx);
 	sta = sta_info_get_bss(sdata, tid_conf->peer);
 	if (!sta) {
-		mutex_unlock(&sdata->local->sta_mtx);
+		mutex_unlock(&local->sta_mtx);
 		return -ENOENT;
 	}
 
-	ret = drv_set_tid_config(sdata->local, sdata, &sta->sta, tid_conf);
-	mutex_unlock(&sdata->local->sta_mtx);
+	/* mac80211 keeps the A-MPDU policy, pass the rest to the driver */
+	for (i = 0; i < tid_conf->n_tid_conf; i++) {
+		ieee80211_apply_ampdu_policy(sta, &tid_conf->tid_conf[i]);
+		if (tid_conf->tid_conf[i].mask)
+			drv_conf = true;
+	}
+
+	if (drv_conf) {
+		if (local->ops->set_tid_config)
+			ret = drv_set_tid_config(local, sdata, &sta->sta,
+						 tid_conf);
+		else
+			ret = -EOPNOTSUPP;
+	}
+	mutex_unlock(&local->sta_mtx);
 
 	return ret;
 }
@@ -4118,28 +4168,64 @@ static int ieee80211_reset_tid_config(struct wiphy *wiphy,
 				      const u8 *peer, u8 tids)
 {
 	struct ieee80211_sub_if_data *sdata = IEEE80211_DEV_TO_SUB_IF(dev);
+	struct ieee80211_local *local = sdata->local;
+	unsigned long tid_map = tids;
 	struct sta_info *sta;
-	int ret;
+	int tid, ret = 0;
 
-	if (!sdata->local->ops->reset_tid_config)
+	if (!local->ops->reset_tid_config &&
+	    !ieee80211_hw_check(&local->hw, SUPPORTS_AMPDU_POLICY))
 		return -EOPNOTSUPP;
 
-	if (!peer)
-		return drv_reset_tid_config(sdata->local, sdata, NULL, tids);
+	if (!peer) {
+		if (!local->ops->reset_tid_config)
+			return -EOPNOTSUPP;
+		return drv_reset_tid_config(local, sdata, NULL, tids);
+	}
 
-	mutex_lock(&sdata->local->sta_mtx);
+	mutex_lock(&local->sta_mtx);
 	sta = sta_info_get_bss(sdata, peer);
 	if (!sta) {
-		mutex_unlock(&sdata->local->sta_mtx);
+		mutex_unlock(&local->sta_mtx);
 		return -ENOENT;
 	}
 
-	ret = drv_reset_tid_config(sdata->local, sdata, &sta->sta, tids);
-	mutex_unlock(&sdata->local->sta_mtx);
+	for_each_set_bit(tid, &tid_map, IEEE80211_NUM_TIDS)
+		memset(&sta->sta.ampdu_policy[tid], 0,
+		       sizeof(sta->sta.ampdu_policy[tid]));
+
+	if (local->ops->reset_tid_config)
+		ret = drv_reset_tid_config(local, sdata, &sta->sta, tids);
+	mutex_unlock(&local->sta_mtx);
 
 	return ret;
 }
 
+static int ieee80211_get_tsf(struct wiphy *wiphy, struct net_device *dev,
+			     struct cfg80211_tsf_info *tsf)
+{
+	struct ieee80211_sub_if_data *sdata = IEEE80211_DEV_TO_SUB_IF(dev);
+	struct ieee80211_local *local = sdata->local;
+	u64 before, after, val;
+
+	if (!local->ops->get_tsf)
+		return -EOPNOTSUPP;
+
+	/* bracket the read, it may be a bus transaction for some drivers */
+	before = ktime_get_ns();
+	val = drv_get_tsf(local, sdata);
+	after = ktime_get_ns();
+
+	if (val == -1ULL)
+		return -EOPNOTSUPP;
+
+	tsf->tsf = val;
+	tsf->monotonic_ns = before + (after - before) / 2;
+	tsf->error_ns = min_t(u64, DIV_ROUND_UP(after - before, 2), U32_MAX);
+
+	return 0;
+}
+
 static int ieee80211_set_sar_specs(struct wiphy *wiphy,
 				   struct cfg80211_sar_specs *sar)
 {
@@ -4442,6 +4528,7 @@ const struct cfg80211_ops mac80211_config_ops = {
 	.abort_pmsr = ieee80211_abort_pmsr,
 	.probe_mesh_link = ieee80211_probe_mesh_link,
 	.set_tid_config = ieee80211_set_tid_config,
+	.get_tsf = ieee80211_get_tsf,
 	.reset_tid_config = ieee80211_reset_tid_config,
 	.set_sar_specs = ieee80211_set_sar_specs,
 	.color_change = ieee80211_color_change,
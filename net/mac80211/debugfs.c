@@ -504,6 +504,8 @@ static const char *hw_flag_names[] = {
 	FLAG(SUPPORTS_TX_ENCAP_OFFLOAD),
 	FLAG(SUPPORTS_RX_DECAP_OFFLOAD),
 	FLAG(SUPPORTS_CONC_MON_RX_DECAP),
+	FLAG(SUPPORTS_AMPDU_POLICY),
+	FLAG(NEEDS_RX_NAPI),
 #undef FLAG
 };
 
@@ -80,6 +80,7 @@ static const char * const sta_flag_names[] = {
 	FLAG(PS_DELIVER),
 	FLAG(USES_ENCRYPTION),
 	FLAG(DECAP_OFFLOAD),
+	FLAG(PS_HOLD),
 #undef FLAG
 };
 
@@ -119,6 +120,22 @@ static ssize_t sta_num_ps_buf_frames_read(struct file *file,
 }
 STA_OPS(num_ps_buf_frames);
 
+static ssize_t sta_ps_lowlat_read(struct file *file, char __user *userbuf,
+				  size_t count, loff_t *ppos)
+{
+	struct sta_info *sta = file->private_data;
+	struct sta_ps_lowlat *pl = &sta->ps_lowlat;
+	char buf[100], *p = buf;
+
+	p += scnprintf(p, sizeof(buf) + buf - p, "tids: 0x%02x\n", pl->tids);
+	p += scnprintf(p, sizeof(buf) + buf - p, "interval: %u us\n",
+		       pl->interval);
+	p += scnprintf(p, sizeof(buf) + buf - p, "holds: %u\nhits: %u\n",
+		       pl->holds, pl->hold_hits);
+	return simple_read_from_buffer(userbuf, count, ppos, buf, p - buf);
+}
+STA_OPS(ps_lowlat);
+
 static ssize_t sta_last_seq_ctrl_read(struct file *file, char __user *userbuf,
 				      size_t count, loff_t *ppos)
 {
@@ -218,9 +235,10 @@ static ssize_t sta_airtime_read(struct file *file, char __user *userbuf,
 	}
 
 	p += scnprintf(p, bufsz + buf - p,
-		"RX: %llu us\nTX: %llu us\nWeight: %u\n"
+		"RX: %llu us\nTX: %llu us\nWeight: %u\nLatency-critical: %s\n"
 		"Virt-T: VO: %lld us VI: %lld us BE: %lld us BK: %lld us\n",
 		rx_airtime, tx_airtime, sta->airtime[0].weight,
+		sta->airtime[0].lowlat ? "yes" : "no",
 		v_t[0], v_t[1], v_t[2], v_t[3]);
 
 	rv = simple_read_from_buffer(userbuf, count, ppos, buf, p - buf);
@@ -1018,6 +1036,7 @@ void ieee80211_sta_debugfs_add(struct sta_info *sta)
 	DEBUGFS_ADD(flags);
 	DEBUGFS_ADD(aid);
 	DEBUGFS_ADD(num_ps_buf_frames);
+	DEBUGFS_ADD(ps_lowlat);
 	DEBUGFS_ADD(last_seq_ctrl);
 	DEBUGFS_ADD(agg_status);
 	DEBUGFS_ADD(ht_capa);
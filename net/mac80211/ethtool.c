@@ -8,6 +8,7 @@
  * Copyright (C) 2018 Intel Corporation
  */
 #include <linux/types.h>
+#include <linux/net_tstamp.h>
 #include <net/cfg80211.h>
 #include "ieee80211_i.h"
 #include "sta_info.h"
@@ -229,6 +230,24 @@ static void ieee80211_get_regs(struct net_device *dev,
 	regs->len = 0;
 }
 
+static int ieee80211_get_ts_info(struct net_device *dev,
+				 struct ethtool_ts_info *info)
+{
+	struct ieee80211_sub_if_data *sdata = IEEE80211_DEV_TO_SUB_IF(dev);
+
+	ethtool_op_get_ts_info(dev, info);
+
+	/* mactime based, see ieee80211_eth_ioctl() */
+	if (sdata->vif.type != NL80211_IFTYPE_MONITOR) {
+		info->so_timestamping |= SOF_TIMESTAMPING_RX_HARDWARE |
+					 SOF_TIMESTAMPING_RAW_HARDWARE;
+		info->rx_filters = BIT(HWTSTAMP_FILTER_NONE) |
+				   BIT(HWTSTAMP_FILTER_ALL);
+	}
+
+	return 0;
+}
+
 const struct ethtool_ops ieee80211_ethtool_ops = {
 	.get_drvinfo = cfg80211_get_drvinfo,
 	.get_regs_len = ieee80211_get_regs_len,
@@ -239,4 +258,5 @@ const struct ethtool_ops ieee80211_ethtool_ops = {
 	.get_strings = ieee80211_get_strings,
 	.get_ethtool_stats = ieee80211_get_stats,
 	.get_sset_count = ieee80211_get_sset_count,
+	.get_ts_info = ieee80211_get_ts_info,
 };
@@ -829,6 +829,7 @@ enum txq_info_flags {
 	IEEE80211_TXQ_AMPDU,
 	IEEE80211_TXQ_NO_AMSDU,
 	IEEE80211_TXQ_STOP_NETIF_TX,
+	IEEE80211_TXQ_LAUNCH_WAIT,
 };
 
 /**
@@ -839,16 +840,20 @@ enum txq_info_flags {
  *	a fq_flow which is already owned by a different tin
  * @def_cvars: codel vars for @def_flow
  * @schedule_order: used with ieee80211_local->active_txqs
- * @frags: used to keep fragments created after dequeue
+ * @frags: used to keep fragments created after dequeue, and a frame held
+ *	until its SO_TXTIME launch time
+ * @launch_timer: wakes the TXQ at the launch time of the held frame
  */
 struct txq_info {
 	struct fq_tin tin;
 	struct codel_vars def_cvars;
 	struct codel_stats cstats;
 	struct rb_node schedule_order;
+	u32 schedule_round;
 
 	struct sk_buff_head frags;
 	unsigned long flags;
+	struct hrtimer launch_timer;
 
 	/* keep last! */
 	struct ieee80211_txq txq;
@@ -917,6 +922,7 @@ struct ieee80211_sub_if_data {
 	__be16 control_port_protocol;
 	bool control_port_no_encrypt;
 	bool control_port_no_preauth;
+	bool rx_hwtstamp; /* TSF as RX hardware timestamp, see SIOCSHWTSTAMP */
 	bool control_port_over_nl80211;
 	int encrypt_headroom;
 
@@ -1165,6 +1171,10 @@ enum mac80211_scan_state {
  *                     is < IEEE80211_AQL_THRESHOLD
  * @aql_txq_limit_high: AQL limit when total outstanding airtime
  *                      is > IEEE80211_AQL_THRESHOLD
+ * @lowlat_stations: number of latency-critical stations, the scheduler only
+ *                   looks for them when this is non-zero
+ * @schedule_round: incremented by ieee80211_txq_schedule_start(), so that a
+ *                  latency-critical queue is put first only once per round
  */
 struct airtime_sched_info {
 	spinlock_t lock;
@@ -1178,9 +1188,16 @@ struct airtime_sched_info {
 	u64 weight_sum_reciprocal;
 	u32 aql_txq_limit_low;
 	u32 aql_txq_limit_high;
+	int lowlat_stations;
+	u32 schedule_round;
 };
 DECLARE_STATIC_KEY_FALSE(aql_disable);
 
+#define IEEE80211_TID_CONFIG_AMPDU_POLICY			\
+	(BIT(NL80211_TID_CONFIG_ATTR_AMPDU_MAX_LEN) |		\
+	 BIT(NL80211_TID_CONFIG_ATTR_AMPDU_MAX_DURATION) |	\
+	 BIT(NL80211_TID_CONFIG_ATTR_AMPDU_MAX_DELAY))
+
 struct ieee80211_local {
 	/* embed the driver visible part.
 	 * don't cast (use the static inlines below), but we keep
@@ -1284,6 +1301,11 @@ struct ieee80211_local {
 	struct sk_buff_head skb_queue;
 	struct sk_buff_head skb_queue_unreliable;
 
+	/* NAPI context for drivers setting IEEE80211_HW_NEEDS_RX_NAPI */
+	struct net_device napi_dev;
+	struct napi_struct rx_napi;
+	struct sk_buff_head rx_napi_queue;
+
 	spinlock_t rx_path_lock;
 
 	/* Station data */
@@ -1347,6 +1369,7 @@ struct ieee80211_local {
 	u8 scan_addr[ETH_ALEN];
 
 	unsigned long leave_oper_channel_time;
+	unsigned long scan_suspend_time;
 	enum mac80211_scan_state next_scan_state;
 	struct delayed_work scan_work;
 	struct ieee80211_sub_if_data __rcu *scan_sdata;
@@ -1445,6 +1468,7 @@ struct ieee80211_local {
 	struct list_head roc_list;
 	struct work_struct hw_roc_start, hw_roc_done;
 	unsigned long hw_roc_start_time;
+	unsigned long rt_roc_start_time;
 	u64 roc_cookie_counter;
 
 	struct idr ack_status_frames;
@@ -1695,6 +1719,9 @@ static inline void airtime_weight_sum_set(struct airtime_sched_info *air_sched,
  * 20 ms because the main mechanism for catching up idle stations is the active
  * state as described above; i.e., the hard limit should only be hit in
  * pathological cases.
+ *
+ * The activity times are only compared with each other, so they are taken
+ * from fast_clock_ns() rather than the timekeeping clocks.
  */
 #define AIRTIME_ACTIVE_DURATION (100 * NSEC_PER_MSEC)
 #define AIRTIME_MAX_BEHIND 20000 /* 20 ms */
@@ -1712,6 +1739,26 @@ static inline void airtime_set_active(struct airtime_sched_info *air_sched,
 	list_move_tail(&air_info->list, &air_sched->active_list);
 }
 
+/* Latency-critical stations are served ahead of the virtual time order, but
+ * only for up to AIRTIME_LOWLAT_BUDGET of airtime in every
+ * AIRTIME_LOWLAT_PERIOD. The airtime they use within the budget doesn't
+ * advance their virtual time; once the budget is used up they are scheduled
+ * (and charged) like every other station until the next period starts, so a
+ * station marked latency-critical can't starve the others.
+ */
+#define AIRTIME_LOWLAT_PERIOD (20 * NSEC_PER_MSEC)
+#define AIRTIME_LOWLAT_BUDGET 5000 /* 5 ms */
+
+static inline bool airtime_lowlat_eligible(struct airtime_info *air_info,
+					   u64 now)
+{
+	if (!air_info->lowlat)
+		return false;
+
+	return air_info->lowlat_used < AIRTIME_LOWLAT_BUDGET ||
+	       air_info->lowlat_start < now - AIRTIME_LOWLAT_PERIOD;
+}
+
 static inline bool airtime_catchup_v_t(struct airtime_sched_info *air_sched,
 				       u64 v_t, u64 now)
 {
@@ -1881,6 +1928,8 @@ void ieee80211_sched_scan_stopped_work(struct work_struct *work);
 /* off-channel/mgmt-tx */
 void ieee80211_offchannel_stop_vifs(struct ieee80211_local *local);
 void ieee80211_offchannel_return(struct ieee80211_local *local);
+bool ieee80211_offchannel_rt_active(struct ieee80211_local *local,
+				    bool *tx_pending);
 void ieee80211_roc_setup(struct ieee80211_local *local);
 void ieee80211_start_next_roc(struct ieee80211_local *local);
 void ieee80211_roc_purge(struct ieee80211_local *local,
@@ -2035,6 +2084,7 @@ void ieee80211_stop_tx_ba_cb(struct sta_info *sta, int tid,
 void ieee80211_ba_session_work(struct work_struct *work);
 void ieee80211_tx_ba_session_handle_start(struct sta_info *sta, int tid);
 void ieee80211_release_reorder_timeout(struct sta_info *sta, int tid);
+int ieee80211_rx_napi_poll(struct napi_struct *napi, int budget);
 
 u8 ieee80211_mcs_to_chains(const struct ieee80211_mcs_info *mcs);
 enum nl80211_smps_mode
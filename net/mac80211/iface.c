@@ -16,6 +16,7 @@
 #include <linux/netdevice.h>
 #include <linux/rtnetlink.h>
 #include <linux/kcov.h>
+#include <linux/net_tstamp.h>
 #include <net/mac80211.h>
 #include <net/ieee80211_radiotap.h>
 #include "ieee80211_i.h"
@@ -710,6 +711,51 @@ ieee80211_get_stats64(struct net_device *dev, struct rtnl_link_stats64 *stats)
 	dev_fetch_sw_netstats(stats, dev->tstats);
 }
 
+/*
+ * There is no PHC; the RX hardware timestamp is the TSF at the start of
+ * the frame (in the nanosecond field), for correlating with the TSF and
+ * system time pairs from NL80211_CMD_GET_TSF.
+ */
+static int ieee80211_eth_ioctl(struct net_device *dev, struct ifreq *ifr,
+			       int cmd)
+{
+	struct ieee80211_sub_if_data *sdata = IEEE80211_DEV_TO_SUB_IF(dev);
+	struct hwtstamp_config config;
+
+	switch (cmd) {
+	case SIOCSHWTSTAMP:
+		if (copy_from_user(&config, ifr->ifr_data, sizeof(config)))
+			return -EFAULT;
+
+		if (config.flags)
+			return -EINVAL;
+
+		if (config.tx_type != HWTSTAMP_TX_OFF)
+			return -ERANGE;
+
+		if (config.rx_filter == HWTSTAMP_FILTER_NONE) {
+			sdata->rx_hwtstamp = false;
+		} else {
+			sdata->rx_hwtstamp = true;
+			config.rx_filter = HWTSTAMP_FILTER_ALL;
+		}
+		break;
+	case SIOCGHWTSTAMP:
+		memset(&config, 0, sizeof(config));
+		config.tx_type = HWTSTAMP_TX_OFF;
+		config.rx_filter = sdata->rx_hwtstamp ? HWTSTAMP_FILTER_ALL :
+							HWTSTAMP_FILTER_NONE;
+		break;
+	default:
+		return -EOPNOTSUPP;
+	}
+
+	if (copy_to_user(ifr->ifr_data, &config, sizeof(config)))
+		return -EFAULT;
+
+	return 0;
+}
+
 static const struct net_device_ops ieee80211_dataif_ops = {
 	.ndo_open		= ieee80211_open,
 	.ndo_stop		= ieee80211_stop,
@@ -719,6 +765,7 @@ static const struct net_device_ops ieee80211_dataif_ops = {
 	.ndo_set_mac_address 	= ieee80211_change_mac,
 	.ndo_select_queue	= ieee80211_netdev_select_queue,
 	.ndo_get_stats64	= ieee80211_get_stats64,
+	.ndo_eth_ioctl		= ieee80211_eth_ioctl,
 };
 
 static u16 ieee80211_monitor_select_queue(struct net_device *dev,
@@ -769,6 +816,7 @@ static const struct net_device_ops ieee80211_dataif_8023_ops = {
 	.ndo_set_mac_address	= ieee80211_change_mac,
 	.ndo_select_queue	= ieee80211_netdev_select_queue,
 	.ndo_get_stats64	= ieee80211_get_stats64,
+	.ndo_eth_ioctl		= ieee80211_eth_ioctl,
 };
 
 static bool ieee80211_iftype_supports_hdr_offload(enum nl80211_iftype iftype)
@@ -595,6 +595,13 @@ ieee80211_key_alloc(u32 cipher, int idx, size_t key_len,
 			kfree(key);
 			return ERR_PTR(err);
 		}
+		key->u.ccmp.tx_req = ieee80211_aes_ccm_req_alloc(key->u.ccmp.tfm);
+		if (!key->u.ccmp.tx_req) {
+			ieee80211_aes_key_free(key->u.ccmp.tfm);
+			kfree(key);
+			return ERR_PTR(-ENOMEM);
+		}
+		spin_lock_init(&key->u.ccmp.tx_req_lock);
 		break;
 	case WLAN_CIPHER_SUITE_CCMP_256:
 		key->conf.iv_len = IEEE80211_CCMP_256_HDR_LEN;
@@ -613,6 +620,13 @@ ieee80211_key_alloc(u32 cipher, int idx, size_t key_len,
 			kfree(key);
 			return ERR_PTR(err);
 		}
+		key->u.ccmp.tx_req = ieee80211_aes_ccm_req_alloc(key->u.ccmp.tfm);
+		if (!key->u.ccmp.tx_req) {
+			ieee80211_aes_key_free(key->u.ccmp.tfm);
+			kfree(key);
+			return ERR_PTR(-ENOMEM);
+		}
+		spin_lock_init(&key->u.ccmp.tx_req_lock);
 		break;
 	case WLAN_CIPHER_SUITE_AES_CMAC:
 	case WLAN_CIPHER_SUITE_BIP_CMAC_256:
@@ -702,6 +716,7 @@ static void ieee80211_key_free_common(struct ieee80211_key *key)
 	switch (key->conf.cipher) {
 	case WLAN_CIPHER_SUITE_CCMP:
 	case WLAN_CIPHER_SUITE_CCMP_256:
+		ieee80211_aes_ccm_req_free(key->u.ccmp.tx_req);
 		ieee80211_aes_key_free(key->u.ccmp.tfm);
 		break;
 	case WLAN_CIPHER_SUITE_AES_CMAC:
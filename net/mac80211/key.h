@@ -20,6 +20,7 @@
 #define NUM_DEFAULT_BEACON_KEYS 2
 #define INVALID_PTK_KEYIDX 2 /* Keyidx always pointing to a NULL key for PTK */
 
+struct aead_request;
 struct ieee80211_local;
 struct ieee80211_sub_if_data;
 struct sta_info;
@@ -90,6 +91,9 @@ struct ieee80211_key {
 			 */
 			u8 rx_pn[IEEE80211_NUM_TIDS + 1][IEEE80211_CCMP_PN_LEN];
 			struct crypto_aead *tfm;
+			/* reused by every frame encrypted in software */
+			struct aead_request *tx_req;
+			spinlock_t tx_req_lock;
 			u32 replays; /* dot11RSNAStatsCCMPReplays */
 		} ccmp;
 		struct {
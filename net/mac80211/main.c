@@ -638,6 +638,7 @@ struct ieee80211_hw *ieee80211_alloc_hw_nm(size_t priv_data_len,
 		wiphy_ext_feature_set(wiphy, NL80211_EXT_FEATURE_TXQS);
 
 	wiphy_ext_feature_set(wiphy, NL80211_EXT_FEATURE_RRM);
+	wiphy_ext_feature_set(wiphy, NL80211_EXT_FEATURE_PS_LOWLAT_DELIVERY);
 
 	wiphy->bss_priv_size = sizeof(struct ieee80211_bss);
 
@@ -759,6 +760,7 @@ struct ieee80211_hw *ieee80211_alloc_hw_nm(size_t priv_data_len,
 
 	skb_queue_head_init(&local->skb_queue);
 	skb_queue_head_init(&local->skb_queue_unreliable);
+	skb_queue_head_init(&local->rx_napi_queue);
 
 	ieee80211_alloc_led_names(local);
 
@@ -1116,6 +1118,11 @@ int ieee80211_register_hw(struct ieee80211_hw *hw)
 		wiphy_ext_feature_set(local->hw.wiphy,
 				      NL80211_EXT_FEATURE_DEL_IBSS_STA);
 
+	/* the A-MPDU policy is kept by mac80211 for the driver to apply */
+	if (ieee80211_hw_check(hw, SUPPORTS_AMPDU_POLICY))
+		local->hw.wiphy->tid_config_support.peer |=
+			IEEE80211_TID_CONFIG_AMPDU_POLICY;
+
 	/*
 	 * Calculate scan IE length -- we need this to alloc
 	 * memory and to subtract from the driver limit. It
@@ -1238,6 +1245,13 @@ int ieee80211_register_hw(struct ieee80211_hw *hw)
 
 	ieee80211_led_init(local);
 
+	if (ieee80211_hw_check(hw, NEEDS_RX_NAPI)) {
+		init_dummy_netdev(&local->napi_dev);
+		netif_napi_add(&local->napi_dev, &local->rx_napi,
+			       ieee80211_rx_napi_poll, NAPI_POLL_WEIGHT);
+		napi_enable(&local->rx_napi);
+	}
+
 	result = ieee80211_txq_setup_flows(local);
 	if (result)
 		goto fail_flows;
@@ -1357,6 +1371,10 @@ int ieee80211_register_hw(struct ieee80211_hw *hw)
 	rtnl_unlock();
  fail_rate:
  fail_flows:
+	if (ieee80211_hw_check(hw, NEEDS_RX_NAPI)) {
+		napi_disable(&local->rx_napi);
+		netif_napi_del(&local->rx_napi);
+	}
 	ieee80211_led_exit(local);
 	destroy_workqueue(local->workqueue);
  fail_workqueue:
@@ -1407,6 +1425,12 @@ void ieee80211_unregister_hw(struct ieee80211_hw *hw)
 	skb_queue_purge(&local->skb_queue);
 	skb_queue_purge(&local->skb_queue_unreliable);
 
+	if (ieee80211_hw_check(hw, NEEDS_RX_NAPI)) {
+		napi_disable(&local->rx_napi);
+		netif_napi_del(&local->rx_napi);
+		skb_queue_purge(&local->rx_napi_queue);
+	}
+
 	wiphy_unregister(local->hw.wiphy);
 	destroy_workqueue(local->workqueue);
 	ieee80211_led_exit(local);
@@ -11,10 +11,15 @@
  * Copyright (C) 2019 Intel Corporation
  */
 #include <linux/export.h>
+#include <net/sch_generic.h>
 #include <net/mac80211.h>
 #include "ieee80211_i.h"
 #include "driver-ops.h"
 
+/* remain-on-channel limits with real-time traffic, duration in ms */
+#define IEEE80211_RT_ROC_MAX_DURATION	30
+#define IEEE80211_RT_ROC_INTERVAL	(HZ / 2)
+
 /*
  * Tell our hardware to disable PS.
  * Optionally inform AP that we will go to sleep so that it will buffer
@@ -166,6 +171,40 @@ void ieee80211_offchannel_return(struct ieee80211_local *local)
 					false);
 }
 
+/*
+ * Check if any interface carries real-time traffic, see
+ * enum nl80211_rt_scan_policy, and optionally if it has frames
+ * waiting to go out.
+ */
+bool ieee80211_offchannel_rt_active(struct ieee80211_local *local,
+				    bool *tx_pending)
+{
+	struct ieee80211_sub_if_data *sdata;
+	bool active = false;
+
+	if (tx_pending)
+		*tx_pending = false;
+
+	rcu_read_lock();
+	list_for_each_entry_rcu(sdata, &local->interfaces, list) {
+		if (!ieee80211_sdata_running(sdata) || !sdata->dev ||
+		    sdata->wdev.rt_scan_policy == NL80211_RT_SCAN_ALLOW)
+			continue;
+
+		active = true;
+		if (!tx_pending)
+			break;
+
+		if (!qdisc_all_tx_empty(sdata->dev)) {
+			*tx_pending = true;
+			break;
+		}
+	}
+	rcu_read_unlock();
+
+	return active;
+}
+
 static void ieee80211_roc_notify_destroy(struct ieee80211_roc_work *roc)
 {
 	/* was never transmitted */
@@ -544,6 +583,24 @@ static int ieee80211_start_roc_work(struct ieee80211_local *local,
 	if (local->use_chanctx && !local->ops->remain_on_channel)
 		return -EOPNOTSUPP;
 
+	/*
+	 * With real-time traffic, keep remain-on-channel short and don't
+	 * let it leave the operating channel more often than every
+	 * IEEE80211_RT_ROC_INTERVAL. Frames that need to go out off-channel
+	 * (mgmt-TX) are only shortened.
+	 */
+	if (ieee80211_offchannel_rt_active(local, NULL)) {
+		if (!txskb && local->rt_roc_start_time &&
+		    time_before(jiffies, local->rt_roc_start_time +
+					 IEEE80211_RT_ROC_INTERVAL))
+			return -EBUSY;
+
+		if (!txskb)
+			local->rt_roc_start_time = jiffies;
+		duration = min_t(unsigned int, duration,
+				 IEEE80211_RT_ROC_MAX_DURATION);
+	}
+
 	roc = kzalloc(sizeof(*roc), GFP_KERNEL);
 	if (!roc)
 		return -ENOMEM;
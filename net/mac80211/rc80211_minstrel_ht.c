@@ -458,6 +458,70 @@ minstrel_ht_get_tp_avg(struct minstrel_ht_sta *mi, int group, int rate,
 	return MINSTREL_TRUNC(100 * ((prob_avg * 1000000) / nsecs));
 }
 
+/*
+ * Return the expected time in usec to deliver a single frame at a rate,
+ * counting the expected number of attempts, or 0 if even the attempts that
+ * fit within MINSTREL_LATENCY_DEADLINE are likely (>10%) to all fail
+ */
+static unsigned int
+minstrel_ht_get_latency(struct minstrel_priv *mp, struct minstrel_ht_sta *mi,
+			int group, int rate, int prob_avg)
+{
+	unsigned int overhead = mi->overhead, tx_time, tries, fail;
+
+	if (prob_avg < MINSTREL_FRAC(10, 100))
+		return 0;
+
+	if (minstrel_ht_is_legacy_group(group))
+		overhead = mi->overhead_legacy;
+
+	tx_time = overhead + ((minstrel_mcs_groups[group].duration[rate] <<
+			       minstrel_mcs_groups[group].shift) / 1000);
+
+	tries = min(MINSTREL_LATENCY_DEADLINE / tx_time, mp->max_retry);
+	if (!tries)
+		return 0;
+
+	/* probability of all tries within the deadline failing */
+	fail = MINSTREL_FRAC(1, 1) - prob_avg;
+	while (--tries)
+		fail = MINSTREL_TRUNC(fail * (MINSTREL_FRAC(1, 1) - prob_avg));
+	if (fail > MINSTREL_FRAC(10, 100))
+		return 0;
+
+	return min_t(unsigned int, tx_time * MINSTREL_FRAC(1, 1) / prob_avg,
+		     U16_MAX);
+}
+
+/*
+ * Find & sort the rates with the lowest expected delivery time
+ */
+static void
+minstrel_ht_sort_best_lat_rates(struct minstrel_ht_sta *mi, u16 index,
+				u16 *lat_list)
+{
+	unsigned int cur_lat, tmp_lat;
+	int j = MAX_THR_RATES;
+
+	cur_lat = minstrel_get_ratestats(mi, index)->latency;
+	if (!cur_lat)
+		return;
+
+	do {
+		tmp_lat = minstrel_get_ratestats(mi, lat_list[j - 1])->latency;
+		if (tmp_lat && tmp_lat <= cur_lat)
+			break;
+		j--;
+	} while (j > 0);
+
+	if (j < MAX_THR_RATES - 1) {
+		memmove(&lat_list[j + 1], &lat_list[j], (sizeof(*lat_list) *
+		       (MAX_THR_RATES - (j + 1))));
+	}
+	if (j < MAX_THR_RATES)
+		lat_list[j] = index;
+}
+
 /*
  * Find & sort topmost throughput rates
  *
@@ -989,14 +1053,19 @@ minstrel_ht_refill_sample_rates(struct minstrel_ht_sta *mi)
 static void
 minstrel_ht_update_stats(struct minstrel_priv *mp, struct minstrel_ht_sta *mi)
 {
+	struct sta_info *sta = container_of(mi->sta, struct sta_info, sta);
 	struct minstrel_mcs_group_data *mg;
 	struct minstrel_rate_stats *mrs;
 	int group, i, j, cur_prob;
 	u16 tmp_mcs_tp_rate[MAX_THR_RATES], tmp_group_tp_rate[MAX_THR_RATES];
 	u16 tmp_legacy_tp_rate[MAX_THR_RATES], tmp_max_prob_rate;
+	u16 tmp_lat_rate[MAX_THR_RATES];
 	u16 index;
 	bool ht_supported = mi->sta->ht_cap.ht_supported;
 
+	/* latency-critical stations get their rates picked for latency */
+	mi->latency_mode = sta->airtime[IEEE80211_AC_VI].lowlat;
+
 	if (mi->ampdu_packets > 0) {
 		if (!ieee80211_hw_check(mp->hw, TX_STATUS_NO_AMPDU_LEN))
 			mi->avg_ampdu_len = minstrel_ewma(mi->avg_ampdu_len,
@@ -1032,6 +1101,8 @@ minstrel_ht_update_stats(struct minstrel_priv *mp, struct minstrel_ht_sta *mi)
 	tmp_max_prob_rate = index;
 	for (j = 0; j < ARRAY_SIZE(tmp_mcs_tp_rate); j++)
 		tmp_mcs_tp_rate[j] = index;
+	for (j = 0; j < ARRAY_SIZE(tmp_lat_rate); j++)
+		tmp_lat_rate[j] = index;
 
 	/* Find best rate sets within all MCS groups*/
 	for (group = 0; group < ARRAY_SIZE(minstrel_mcs_groups); group++) {
@@ -1065,6 +1136,12 @@ minstrel_ht_update_stats(struct minstrel_priv *mp, struct minstrel_ht_sta *mi)
 				mrs->prob_avg = max(last_prob, mrs->prob_avg);
 			cur_prob = mrs->prob_avg;
 
+			mrs->latency = minstrel_ht_get_latency(mp, mi, group, i,
+							       cur_prob);
+			if (mi->latency_mode)
+				minstrel_ht_sort_best_lat_rates(mi, index,
+								tmp_lat_rate);
+
 			if (minstrel_ht_get_tp_avg(mi, group, i, cur_prob) == 0)
 				continue;
 
@@ -1083,7 +1160,11 @@ minstrel_ht_update_stats(struct minstrel_priv *mp, struct minstrel_ht_sta *mi)
 	/* Assign new rate set per sta */
 	minstrel_ht_assign_best_tp_rates(mi, tmp_mcs_tp_rate,
 					 tmp_legacy_tp_rate);
-	memcpy(mi->max_tp_rate, tmp_mcs_tp_rate, sizeof(mi->max_tp_rate));
+	if (mi->latency_mode)
+		memcpy(mi->max_tp_rate, tmp_lat_rate, sizeof(mi->max_tp_rate));
+	else
+		memcpy(mi->max_tp_rate, tmp_mcs_tp_rate,
+		       sizeof(mi->max_tp_rate));
 
 	for (group = 0; group < ARRAY_SIZE(minstrel_mcs_groups); group++) {
 		if (!mi->supported[group])
@@ -1268,6 +1349,11 @@ minstrel_calc_retransmit(struct minstrel_priv *mp, struct minstrel_ht_sta *mi,
 	unsigned int t_slot = 9; /* FIXME */
 	unsigned int ampdu_len = minstrel_ht_avg_ampdu_len(mi);
 	unsigned int overhead = 0, overhead_rtscts = 0;
+	unsigned int segment_size = mp->segment_size;
+
+	/* the whole chain has to fit the deadline in latency mode */
+	if (mi->latency_mode)
+		segment_size = MINSTREL_LATENCY_DEADLINE;
 
 	mrs = minstrel_get_ratestats(mi, index);
 	if (mrs->prob_avg < MINSTREL_FRAC(1, 10)) {
@@ -1310,9 +1396,9 @@ minstrel_calc_retransmit(struct minstrel_priv *mp, struct minstrel_ht_sta *mi,
 		tx_time += ctime + overhead + tx_time_data;
 		tx_time_rtscts += ctime + overhead_rtscts + tx_time_data;
 
-		if (tx_time_rtscts < mp->segment_size)
+		if (tx_time_rtscts < segment_size)
 			mrs->retry_count_rtscts++;
-	} while ((tx_time < mp->segment_size) &&
+	} while ((tx_time < segment_size) &&
 	         (++mrs->retry_count < mp->max_retry));
 }
 
@@ -1491,6 +1577,14 @@ minstrel_ht_get_rate(void *priv, struct ieee80211_sta *sta, void *priv_sta,
 	    (info->control.flags & IEEE80211_TX_CTRL_PORT_CTRL_PROTO))
 		return;
 
+	/*
+	 * Don't put latency-critical (VO/VI) frames on a probe rate, leave the
+	 * sampling to the station's other traffic
+	 */
+	if (mi->latency_mode &&
+	    skb_get_queue_mapping(txrc->skb) <= IEEE80211_AC_VI)
+		return;
+
 	if (time_is_after_jiffies(mi->sample_time))
 		return;
 
@@ -72,6 +72,14 @@
 #define MINSTREL_SAMPLE_RATES		5 /* rates per sample type */
 #define MINSTREL_SAMPLE_INTERVAL	(HZ / 50)
 
+/*
+ * Latency mode, used for latency-critical stations: rates are ranked by the
+ * expected time to deliver a frame instead of by throughput, and a rate is
+ * only used if its retry chain delivers with high probability within this
+ * deadline (usec).
+ */
+#define MINSTREL_LATENCY_DEADLINE	2000
+
 struct minstrel_priv {
 	struct ieee80211_hw *hw;
 	bool has_mrr;
@@ -120,6 +128,9 @@ struct minstrel_rate_stats {
 	u16 prob_avg;
 	u16 prob_avg_1;
 
+	/* expected delivery time in usec, 0 if the deadline can't be met */
+	u16 latency;
+
 	/* maximum retry counts */
 	u8 retry_count;
 	u8 retry_count_rtscts;
@@ -181,6 +192,9 @@ struct minstrel_ht_sta {
 	/* tx flags to add for frames for this sta */
 	u32 tx_flags;
 
+	/* rank rates by expected delivery time, see MINSTREL_LATENCY_DEADLINE */
+	bool latency_mode;
+
 	u8 band;
 
 	u8 sample_seq;
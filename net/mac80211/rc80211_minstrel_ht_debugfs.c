@@ -127,7 +127,7 @@ minstrel_ht_stats_dump(struct minstrel_ht_sta *mi, int i, char *p)
 
 		p += sprintf(p, "%4u.%1u    %4u.%1u     %3u.%1u"
 				"     %3u   %3u %-3u   "
-				"%9llu   %-9llu\n",
+				"%9llu   %-9llu  %5u\n",
 				tp_max / 10, tp_max % 10,
 				tp_avg / 10, tp_avg % 10,
 				eprob / 10, eprob % 10,
@@ -135,7 +135,8 @@ minstrel_ht_stats_dump(struct minstrel_ht_sta *mi, int i, char *p)
 				mrs->last_success,
 				mrs->last_attempts,
 				(unsigned long long)mrs->succ_hist,
-				(unsigned long long)mrs->att_hist);
+				(unsigned long long)mrs->att_hist,
+				mrs->latency);
 	}
 
 	return p;
@@ -158,9 +159,9 @@ minstrel_ht_stats_open(struct inode *inode, struct file *file)
 
 	p += sprintf(p, "\n");
 	p += sprintf(p,
-		     "              best    ____________rate__________    ____statistics___    _____last____    ______sum-of________\n");
+		     "              best    ____________rate__________    ____statistics___    _____last____    ______sum-of________   latency\n");
 	p += sprintf(p,
-		     "mode guard #  rate   [name   idx airtime  max_tp]  [avg(tp) avg(prob)]  [retry|suc|att]  [#success | #attempts]\n");
+		     "mode guard #  rate   [name   idx airtime  max_tp]  [avg(tp) avg(prob)]  [retry|suc|att]  [#success | #attempts]  [usec]\n");
 
 	p = minstrel_ht_stats_dump(mi, MINSTREL_CCK_GROUP, p);
 	for (i = 0; i < MINSTREL_CCK_GROUP; i++)
@@ -176,6 +177,8 @@ minstrel_ht_stats_open(struct inode *inode, struct file *file)
 		p += sprintf(p, "Average # of aggregated frames per A-MPDU: %d.%d\n",
 			MINSTREL_TRUNC(mi->avg_ampdu_len),
 			MINSTREL_TRUNC(mi->avg_ampdu_len * 10) % 10);
+	p += sprintf(p, "Rate selection: %s\n",
+		     mi->latency_mode ? "latency" : "throughput");
 	ms->len = p - ms->buf;
 	WARN_ON(ms->len + sizeof(*ms) > 32768);
 
@@ -279,12 +282,13 @@ minstrel_ht_stats_csv_dump(struct minstrel_ht_sta *mi, int i, char *p)
 				mrs->last_attempts,
 				(unsigned long long)mrs->succ_hist,
 				(unsigned long long)mrs->att_hist);
-		p += sprintf(p, "%d,%d,%d.%d\n",
+		p += sprintf(p, "%d,%d,%d.%d,%u\n",
 				max(0, (int) mi->total_packets -
 				(int) mi->sample_packets),
 				mi->sample_packets,
 				MINSTREL_TRUNC(mi->avg_ampdu_len),
-				MINSTREL_TRUNC(mi->avg_ampdu_len * 10) % 10);
+				MINSTREL_TRUNC(mi->avg_ampdu_len * 10) % 10,
+				mrs->latency);
 	}
 
 	return p;
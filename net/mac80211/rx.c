@@ -2569,6 +2569,30 @@ static bool ieee80211_frame_allowed(struct ieee80211_rx_data *rx, __le16 fc)
 	return true;
 }
 
+/*
+ * TSF at the start of the frame in usec, for reporting as hardware RX
+ * timestamp (see ieee80211_eth_ioctl()), or 0 if not enabled or unknown
+ */
+static u64 ieee80211_rx_tsf(struct ieee80211_rx_data *rx,
+			    unsigned int mpdu_len)
+{
+	struct ieee80211_rx_status *status = IEEE80211_SKB_RXCB(rx->skb);
+
+	if (!rx->sdata->rx_hwtstamp || !ieee80211_have_rx_timestamp(status))
+		return 0;
+
+	if (status->flag & RX_FLAG_MACTIME_START)
+		return status->mactime;
+
+	return ieee80211_calculate_rx_timestamp(rx->local, status, mpdu_len, 0);
+}
+
+static void ieee80211_rx_set_hwtstamp(struct sk_buff *skb, u64 tsf)
+{
+	if (tsf)
+		skb_hwtstamps(skb)->hwtstamp = ns_to_ktime(tsf * NSEC_PER_USEC);
+}
+
 static void ieee80211_deliver_skb_to_local_stack(struct sk_buff *skb,
 						 struct ieee80211_rx_data *rx)
 {
@@ -2729,6 +2753,7 @@ __ieee80211_rx_h_amsdu(struct ieee80211_rx_data *rx, u8 data_offset)
 	struct sk_buff_head frame_list;
 	struct ethhdr ethhdr;
 	const u8 *check_da = ethhdr.h_dest, *check_sa = ethhdr.h_source;
+	u64 tsf = ieee80211_rx_tsf(rx, skb->len);
 
 	if (unlikely(ieee80211_has_a4(hdr->frame_control))) {
 		check_da = NULL;
@@ -2772,6 +2797,7 @@ __ieee80211_rx_h_amsdu(struct ieee80211_rx_data *rx, u8 data_offset)
 			continue;
 		}
 
+		ieee80211_rx_set_hwtstamp(rx->skb, tsf);
 		ieee80211_deliver_skb(rx);
 	}
 
@@ -3008,6 +3034,9 @@ ieee80211_rx_h_data(struct ieee80211_rx_data *rx)
 		return RX_DROP_MONITOR;
 	}
 
+	/* conversion is in place, the timestamp stays with the skb */
+	ieee80211_rx_set_hwtstamp(rx->skb, ieee80211_rx_tsf(rx, rx->skb->len));
+
 	err = __ieee80211_data_to_8023(rx, &port_control);
 	if (unlikely(err))
 		return RX_DROP_UNUSABLE;
@@ -4467,6 +4496,8 @@ static void ieee80211_rx_8023(struct ieee80211_rx_data *rx,
 	}
 	/* end of statistics */
 
+	ieee80211_rx_set_hwtstamp(skb, ieee80211_rx_tsf(rx, orig_len));
+
 	stats->last_rx = jiffies;
 	stats->last_rate = sta_stats_encode_rate(status);
 
@@ -5026,3 +5057,40 @@ void ieee80211_rx_irqsafe(struct ieee80211_hw *hw, struct sk_buff *skb)
 	tasklet_schedule(&local->tasklet);
 }
 EXPORT_SYMBOL(ieee80211_rx_irqsafe);
+
+void ieee80211_rx_queue_napi(struct ieee80211_hw *hw, struct sk_buff *skb)
+{
+	struct ieee80211_local *local = hw_to_local(hw);
+
+	if (WARN_ON_ONCE(!ieee80211_hw_check(hw, NEEDS_RX_NAPI))) {
+		ieee80211_rx_ni(hw, skb);
+		return;
+	}
+
+	skb_queue_tail(&local->rx_napi_queue, skb);
+
+	local_bh_disable();
+	napi_schedule(&local->rx_napi);
+	local_bh_enable();
+}
+EXPORT_SYMBOL(ieee80211_rx_queue_napi);
+
+int ieee80211_rx_napi_poll(struct napi_struct *napi, int budget)
+{
+	struct ieee80211_local *local = container_of(napi,
+						     struct ieee80211_local,
+						     rx_napi);
+	struct sk_buff *skb;
+	int done = 0;
+
+	while (done < budget &&
+	       (skb = skb_dequeue(&local->rx_napi_queue))) {
+		ieee80211_rx_napi(&local->hw, NULL, skb, napi);
+		done++;
+	}
+
+	if (done < budget)
+		napi_complete_done(napi, done);
+
+	return done;
+}
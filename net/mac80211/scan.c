@@ -28,6 +28,8 @@
 #define IEEE80211_PROBE_DELAY (HZ / 33)
 #define IEEE80211_CHANNEL_TIME (HZ / 33)
 #define IEEE80211_PASSIVE_CHANNEL_TIME (HZ / 9)
+/* longest wait for real-time traffic to drain before the next channel */
+#define IEEE80211_RT_SCAN_MAX_DEFER (HZ / 2)
 
 void ieee80211_rx_bss_put(struct ieee80211_local *local,
 			  struct ieee80211_bss *bss)
@@ -448,6 +450,8 @@ static void __ieee80211_scan_completed(struct ieee80211_hw *hw, bool aborted)
 	kfree(local->hw_scan_req);
 	local->hw_scan_req = NULL;
 
+	trace_scan_end(local, aborted);
+
 	scan_req = rcu_dereference_protected(local->scan_req,
 					     lockdep_is_held(&local->mtx));
 
@@ -749,6 +753,8 @@ static int __ieee80211_start_scan(struct ieee80211_sub_if_data *sdata,
 	rcu_assign_pointer(local->scan_req, req);
 	rcu_assign_pointer(local->scan_sdata, sdata);
 
+	trace_scan_start(local, sdata, req, hw_scan);
+
 	if (req->flags & NL80211_SCAN_FLAG_RANDOM_ADDR)
 		get_random_mask_addr(local->scan_addr,
 				     req->mac_addr,
@@ -850,6 +856,7 @@ static void ieee80211_scan_state_decision(struct ieee80211_local *local,
 	bool associated = false;
 	bool tx_empty = true;
 	bool bad_latency;
+	bool realtime, rt_tx_pending;
 	struct ieee80211_sub_if_data *sdata;
 	struct ieee80211_channel *next_chan;
 	enum mac80211_scan_state next_scan_state;
@@ -878,6 +885,8 @@ static void ieee80211_scan_state_decision(struct ieee80211_local *local,
 	}
 	mutex_unlock(&local->iflist_mtx);
 
+	realtime = ieee80211_offchannel_rt_active(local, &rt_tx_pending);
+
 	scan_req = rcu_dereference_protected(local->scan_req,
 					     lockdep_is_held(&local->mtx));
 
@@ -895,7 +904,13 @@ static void ieee80211_scan_state_decision(struct ieee80211_local *local,
 				 ieee80211_scan_get_channel_time(next_chan),
 				 local->leave_oper_channel_time + HZ / 8);
 
-	if (associated && !tx_empty) {
+	if (realtime && (rt_tx_pending || local->scan_channel_idx)) {
+		/*
+		 * real-time traffic: only scan a single channel on each
+		 * trip off the operating channel, and never abort
+		 */
+		next_scan_state = SCAN_SUSPEND;
+	} else if (associated && !tx_empty) {
 		if (scan_req->flags & NL80211_SCAN_FLAG_LOW_PRIORITY)
 			next_scan_state = SCAN_ABORT;
 		else
@@ -1012,6 +1027,9 @@ static void ieee80211_scan_state_suspend(struct ieee80211_local *local,
 	/* disable PS */
 	ieee80211_offchannel_return(local);
 
+	trace_scan_suspend(local);
+	local->scan_suspend_time = jiffies;
+
 	*next_delay = HZ / 5;
 	/* afterwards, resume scan & go to next channel */
 	local->next_scan_state = SCAN_RESUME;
@@ -1020,6 +1038,19 @@ static void ieee80211_scan_state_suspend(struct ieee80211_local *local,
 static void ieee80211_scan_state_resume(struct ieee80211_local *local,
 					unsigned long *next_delay)
 {
+	bool rt_tx_pending;
+
+	/* let pending real-time frames go out first, but not forever */
+	if (ieee80211_offchannel_rt_active(local, &rt_tx_pending) &&
+	    rt_tx_pending &&
+	    time_before(jiffies, local->scan_suspend_time +
+				 IEEE80211_RT_SCAN_MAX_DEFER)) {
+		*next_delay = HZ / 50;
+		return;
+	}
+
+	trace_scan_resume(local);
+
 	ieee80211_offchannel_stop_vifs(local);
 
 	if (local->ops->flush) {
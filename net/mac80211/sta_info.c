@@ -17,6 +17,7 @@
 #include <linux/if_arp.h>
 #include <linux/timer.h>
 #include <linux/rtnetlink.h>
+#include <linux/fast_clock.h>
 
 #include <net/codel.h>
 #include <net/mac80211.h>
@@ -130,6 +131,7 @@ static void __cleanup_single_sta(struct sta_info *sta)
 		mesh_sta_cleanup(sta);
 
 	cancel_work_sync(&sta->drv_deliver_wk);
+	hrtimer_cancel(&sta->ps_lowlat.hold_timer);
 
 	/*
 	 * Destroy aggregation state here. It would be nice to wait for the
@@ -279,6 +281,9 @@ void sta_info_free(struct ieee80211_local *local, struct sta_info *sta)
 	if (sta->rate_ctrl)
 		rate_control_free_sta(sta);
 
+	if (sta->airtime[0].lowlat)
+		sta_airtime_set_lowlat(local, sta, false);
+
 	sta_dbg(sta->sdata, "Destroyed STA %pM\n", sta->sta.addr);
 
 	if (sta->sta.txq[0])
@@ -318,6 +323,36 @@ static void sta_deliver_ps_frames(struct work_struct *wk)
 	local_bh_enable();
 }
 
+/* A held uAPSD service period ends, with the frame or with a QoS null */
+static enum hrtimer_restart sta_ps_lowlat_hold_end(struct hrtimer *timer)
+{
+	struct sta_info *sta = container_of(timer, struct sta_info,
+					    ps_lowlat.hold_timer);
+
+	/* the station woke up meanwhile, the SP is over */
+	if (!test_and_clear_sta_flag(sta, WLAN_STA_PS_HOLD))
+		return HRTIMER_NORESTART;
+
+	/*
+	 * Without a frame of the stream the deadline has passed, so the
+	 * delivery below must end the SP with a QoS null rather than hold
+	 * it again.
+	 */
+	sta->ps_lowlat.no_hold = !READ_ONCE(sta->ps_lowlat.hit);
+
+	clear_sta_flag(sta, WLAN_STA_SP);
+
+	if (!test_sta_flag(sta, WLAN_STA_PS_DRIVER)) {
+		ieee80211_sta_ps_deliver_uapsd(sta);
+		/* unused if other frames were buffered meanwhile */
+		sta->ps_lowlat.no_hold = false;
+	} else {
+		set_sta_flag(sta, WLAN_STA_UAPSD);
+	}
+
+	return HRTIMER_NORESTART;
+}
+
 static int sta_prepare_rate_control(struct ieee80211_local *local,
 				    struct sta_info *sta, gfp_t gfp)
 {
@@ -355,6 +390,9 @@ struct sta_info *sta_info_alloc(struct ieee80211_sub_if_data *sdata,
 	spin_lock_init(&sta->lock);
 	spin_lock_init(&sta->ps_lock);
 	INIT_WORK(&sta->drv_deliver_wk, sta_deliver_ps_frames);
+	hrtimer_init(&sta->ps_lowlat.hold_timer, CLOCK_MONOTONIC,
+		     HRTIMER_MODE_ABS_SOFT);
+	sta->ps_lowlat.hold_timer.function = sta_ps_lowlat_hold_end;
 	INIT_WORK(&sta->ampdu_mlme.work, ieee80211_ba_session_work);
 	mutex_init(&sta->ampdu_mlme.mtx);
 #ifdef CONFIG_MAC80211_MESH
@@ -1318,6 +1356,8 @@ void ieee80211_sta_ps_deliver_wakeup(struct sta_info *sta)
 		return;
 
 	clear_sta_flag(sta, WLAN_STA_SP);
+	clear_sta_flag(sta, WLAN_STA_PS_HOLD);
+	sta->ps_lowlat.no_hold = false;
 
 	BUILD_BUG_ON(BITS_TO_LONGS(IEEE80211_NUM_TIDS) > 1);
 	sta->driver_buffered_tids = 0;
@@ -1566,6 +1606,69 @@ ieee80211_sta_ps_get_frames(struct sta_info *sta, int n_frames, u8 ignored_acs,
 	}
 }
 
+/*
+ * A uAPSD trigger found nothing to deliver. If the next frame of the
+ * station's latency-critical stream is due soon, hold the service period
+ * open for it, up to IEEE80211_PS_HOLD_MAX, rather than ending it with a
+ * QoS null and leaving the frame buffered until the next trigger.
+ */
+static bool ieee80211_sta_ps_hold(struct sta_info *sta, u8 ignored_acs)
+{
+	struct sta_ps_lowlat *pl = &sta->ps_lowlat;
+	unsigned long tids = pl->tids;
+	u64 now, due;
+	int tid;
+
+	/* the SP was held already and nothing came */
+	if (pl->no_hold) {
+		pl->no_hold = false;
+		return false;
+	}
+
+	for_each_set_bit(tid, &tids, IEEE80211_NUM_TIDS)
+		if (!(ignored_acs &
+		      ieee80211_ac_to_qos_mask[ieee80211_ac_from_tid(tid)]))
+			break;
+	if (tid >= IEEE80211_NUM_TIDS || !pl->last)
+		return false;
+
+	/* allow the stream a quarter of its period of jitter */
+	now = ktime_get_ns();
+	due = pl->last + (u64)pl->interval * (NSEC_PER_USEC * 5 / 4);
+	if (now >= due)
+		return false;
+	due = min_t(u64, due, now + IEEE80211_PS_HOLD_MAX * NSEC_PER_USEC);
+
+	WRITE_ONCE(pl->hit, false);
+	set_sta_flag(sta, WLAN_STA_PS_HOLD);
+	pl->holds++;
+	hrtimer_start(&pl->hold_timer, ns_to_ktime(due), HRTIMER_MODE_ABS_SOFT);
+
+	ps_dbg(sta->sdata, "STA %pM aid %d holding SP for %llu us\n",
+	       sta->sta.addr, sta->sta.aid, div_u64(due - now, NSEC_PER_USEC));
+	return true;
+}
+
+/*
+ * Called when a frame on @tid was put on the PS buffer of @sta. Frames of
+ * the latency-critical stream end a service period held open for them.
+ */
+void ieee80211_sta_ps_lowlat_buffered(struct sta_info *sta, int tid)
+{
+	struct sta_ps_lowlat *pl = &sta->ps_lowlat;
+
+	if (tid >= IEEE80211_NUM_TIDS || !(pl->tids & BIT(tid)))
+		return;
+
+	pl->last = ktime_get_ns();
+
+	if (test_sta_flag(sta, WLAN_STA_PS_HOLD)) {
+		pl->hold_hits++;
+		WRITE_ONCE(pl->hit, true);
+		hrtimer_start(&pl->hold_timer, 0, HRTIMER_MODE_REL_SOFT);
+	}
+}
+
 static void
 ieee80211_sta_ps_deliver_response(struct sta_info *sta,
 				  int n_frames, u8 ignored_acs,
@@ -1606,8 +1709,12 @@ ieee80211_sta_ps_deliver_response(struct sta_info *sta,
 		 *	in the QoS Capability element from delivery-enabled ACs,
 		 *	that are destined for the non-AP STA.
 		 *
-		 * Since we have no other MSDU/MMPDU, transmit a QoS null frame.
+		 * Since we have no other MSDU/MMPDU, transmit a QoS null frame,
+		 * unless the SP is held open for a latency-critical frame.
 		 */
+		if (reason == IEEE80211_FRAME_RELEASE_UAPSD &&
+		    ieee80211_sta_ps_hold(sta, ignored_acs))
+			return;
 
 		/* This will evaluate to 1, 3, 5 or 7. */
 		for (ac = IEEE80211_AC_VO; ac < IEEE80211_NUM_ACS; ac++)
@@ -1914,6 +2021,23 @@ void ieee80211_register_airtime(struct ieee80211_txq *txq,
 	air_info->tx_airtime += tx_airtime;
 	air_info->rx_airtime += rx_airtime;
 
+	if (air_info->lowlat) {
+		u64 now = fast_clock_ns();
+
+		if (air_info->lowlat_start < now - AIRTIME_LOWLAT_PERIOD) {
+			air_info->lowlat_start = now;
+			air_info->lowlat_used = 0;
+		}
+
+		/* within the budget, don't charge, but don't bank credit */
+		if (air_info->lowlat_used < AIRTIME_LOWLAT_BUDGET) {
+			air_info->lowlat_used += airtime >> 8;
+			if (air_info->v_t < air_sched->v_t)
+				air_info->v_t = air_sched->v_t;
+			goto out;
+		}
+	}
+
 	if (air_sched->weight_sum) {
 		weight_sum = air_sched->weight_sum;
 		weight_sum_reciprocal = air_sched->weight_sum_reciprocal;
@@ -1927,11 +2051,32 @@ void ieee80211_register_airtime(struct ieee80211_txq *txq,
 				weight_sum_reciprocal) >> IEEE80211_RECIPROCAL_SHIFT_64;
 	air_info->v_t += (u32)((airtime + (air_info->weight >> 1)) *
 			       air_info->weight_reciprocal) >> IEEE80211_RECIPROCAL_SHIFT_32;
+out:
 	ieee80211_resort_txq(&local->hw, txq);
 
 	spin_unlock_bh(&air_sched->lock);
 }
 
+void sta_airtime_set_lowlat(struct ieee80211_local *local,
+			    struct sta_info *sta, bool lowlat)
+{
+	u8 ac;
+
+	for (ac = 0; ac < IEEE80211_NUM_ACS; ac++) {
+		struct airtime_sched_info *air_sched = &local->airtime[ac];
+		struct airtime_info *air_info = &sta->airtime[ac];
+
+		spin_lock_bh(&air_sched->lock);
+		if (air_info->lowlat != lowlat) {
+			air_info->lowlat = lowlat;
+			air_info->lowlat_used = 0;
+			air_info->lowlat_start = 0;
+			air_sched->lowlat_stations += lowlat ? 1 : -1;
+		}
+		spin_unlock_bh(&air_sched->lock);
+	}
+}
+
 void ieee80211_sta_register_airtime(struct ieee80211_sta *pubsta, u8 tid,
 				    u32 tx_airtime, u32 rx_airtime)
 {
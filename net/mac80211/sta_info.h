@@ -13,6 +13,7 @@
 #include <linux/types.h>
 #include <linux/if_ether.h>
 #include <linux/workqueue.h>
+#include <linux/hrtimer.h>
 #include <linux/average.h>
 #include <linux/bitfield.h>
 #include <linux/etherdevice.h>
@@ -72,6 +73,8 @@
  * @WLAN_STA_USES_ENCRYPTION: This station was configured for encryption,
  *	so drop all packets without a key later.
  * @WLAN_STA_DECAP_OFFLOAD: This station uses rx decap offload
+ * @WLAN_STA_PS_HOLD: A uAPSD service period is held open for the next frame
+ *	of a latency-critical stream, see &struct sta_ps_lowlat.
  *
  * @NUM_WLAN_STA_FLAGS: number of defined flags
  */
@@ -104,6 +107,7 @@ enum ieee80211_sta_info_flags {
 	WLAN_STA_PS_DELIVER,
 	WLAN_STA_USES_ENCRYPTION,
 	WLAN_STA_DECAP_OFFLOAD,
+	WLAN_STA_PS_HOLD,
 
 	NUM_WLAN_STA_FLAGS,
 };
@@ -147,14 +151,52 @@ struct airtime_info {
 	u32 aql_limit_high;
 	u32 weight_reciprocal;
 	u16 weight;
+	bool lowlat; /* latency-critical, see AIRTIME_LOWLAT_BUDGET */
+	u32 lowlat_used;
+	u64 lowlat_start;
 };
 
 void ieee80211_sta_update_pending_airtime(struct ieee80211_local *local,
 					  struct sta_info *sta, u8 ac,
 					  u16 tx_airtime, bool tx_completed);
+void sta_airtime_set_lowlat(struct ieee80211_local *local,
+			    struct sta_info *sta, bool lowlat);
 void ieee80211_register_airtime(struct ieee80211_txq *txq,
 				u32 tx_airtime, u32 rx_airtime);
 
+/* longest a uAPSD service period is held open, in usec */
+#define IEEE80211_PS_HOLD_MAX	20000
+
+/**
+ * struct sta_ps_lowlat - power save delivery of a latency-critical stream
+ *
+ * Set from userspace for a station that receives frames at a known cadence
+ * while in power save, e.g. video to a handheld that sends uAPSD triggers
+ * with its own periodic input. When a trigger finds nothing to deliver but
+ * the next frame of the stream is due, the service period isn't ended: the
+ * station stays awake until EOSP and gets the frame as soon as it's queued
+ * instead of at its next trigger or beacon.
+ *
+ * @tids: TIDs of the stream, only on delivery-enabled ACs it has an effect
+ * @interval: period of the stream in usec
+ * @last: CLOCK_MONOTONIC time in ns the last frame of the stream was buffered
+ * @hold_timer: ends a held service period
+ * @hit: a frame of the stream arrived in the held service period
+ * @no_hold: the held service period expired, end it with a QoS null
+ * @holds: number of service periods held open
+ * @hold_hits: number of those a frame arrived in
+ */
+struct sta_ps_lowlat {
+	u8 tids;
+	u32 interval;
+	u64 last;
+	struct hrtimer hold_timer;
+	bool hit;
+	bool no_hold;
+	u32 holds;
+	u32 hold_hits;
+};
+
 struct sta_info;
 
 /**
@@ -515,6 +557,7 @@ struct ieee80211_fragment_cache {
  *	the station when it leaves powersave or polls for frames
  * @driver_buffered_tids: bitmap of TIDs the driver has data buffered on
  * @txq_buffered_tids: bitmap of TIDs that mac80211 has txq data buffered on
+ * @ps_lowlat: power save delivery policy for a latency-critical stream
  * @assoc_at: clock boottime (in ns) of last association
  * @last_connected: time (in seconds) when a station got connected
  * @last_seq_ctrl: last received seq/frag number from this STA (per TID
@@ -613,6 +656,7 @@ struct sta_info {
 	struct sk_buff_head tx_filtered[IEEE80211_NUM_ACS];
 	unsigned long driver_buffered_tids;
 	unsigned long txq_buffered_tids;
+	struct sta_ps_lowlat ps_lowlat;
 
 	u64 assoc_at;
 	long last_connected;
@@ -859,6 +903,7 @@ u8 sta_info_tx_streams(struct sta_info *sta);
 void ieee80211_sta_ps_deliver_wakeup(struct sta_info *sta);
 void ieee80211_sta_ps_deliver_poll_response(struct sta_info *sta);
 void ieee80211_sta_ps_deliver_uapsd(struct sta_info *sta);
+void ieee80211_sta_ps_lowlat_buffered(struct sta_info *sta, int tid);
 
 unsigned long ieee80211_sta_last_active(struct sta_info *sta);
 
@@ -2892,6 +2892,71 @@ TRACE_EVENT(drv_twt_teardown_request,
 	)
 );
 
+/*
+ * Tracing for scans, to match them with traffic interruptions
+ */
+
+TRACE_EVENT(scan_start,
+	TP_PROTO(struct ieee80211_local *local,
+		 struct ieee80211_sub_if_data *sdata,
+		 struct cfg80211_scan_request *req, bool hw_scan),
+
+	TP_ARGS(local, sdata, req, hw_scan),
+
+	TP_STRUCT__entry(
+		LOCAL_ENTRY
+		VIF_ENTRY
+		__field(u32, n_channels)
+		__field(u32, flags)
+		__field(bool, hw_scan)
+	),
+
+	TP_fast_assign(
+		LOCAL_ASSIGN;
+		VIF_ASSIGN;
+		__entry->n_channels = req->n_channels;
+		__entry->flags = req->flags;
+		__entry->hw_scan = hw_scan;
+	),
+
+	TP_printk(
+		LOCAL_PR_FMT VIF_PR_FMT " channels:%u flags:0x%x hw_scan:%d",
+		LOCAL_PR_ARG, VIF_PR_ARG, __entry->n_channels,
+		__entry->flags, __entry->hw_scan
+	)
+);
+
+TRACE_EVENT(scan_end,
+	TP_PROTO(struct ieee80211_local *local, bool aborted),
+
+	TP_ARGS(local, aborted),
+
+	TP_STRUCT__entry(
+		LOCAL_ENTRY
+		__field(bool, aborted)
+	),
+
+	TP_fast_assign(
+		LOCAL_ASSIGN;
+		__entry->aborted = aborted;
+	),
+
+	TP_printk(
+		LOCAL_PR_FMT " aborted:%d",
+		LOCAL_PR_ARG, __entry->aborted
+	)
+);
+
+DEFINE_EVENT(local_only_evt, scan_suspend,
+	TP_PROTO(struct ieee80211_local *local),
+	TP_ARGS(local)
+);
+
+DEFINE_EVENT(local_only_evt, scan_resume,
+	TP_PROTO(struct ieee80211_local *local),
+	TP_ARGS(local)
+);
+
 #endif /* !__MAC80211_DRIVER_TRACE || TRACE_HEADER_MULTI_READ */
 
 #undef TRACE_INCLUDE_PATH
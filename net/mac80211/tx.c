@@ -18,8 +18,9 @@
 #include <linux/bitmap.h>
 #include <linux/rcupdate.h>
 #include <linux/export.h>
-#include <linux/timekeeping.h>
+#include <linux/fast_clock.h>
 #include <net/net_namespace.h>
+#include <net/sock.h>
 #include <net/ieee80211_radiotap.h>
 #include <net/cfg80211.h>
 #include <net/mac80211.h>
@@ -486,6 +487,7 @@ ieee80211_tx_h_unicast_ps_buf(struct ieee80211_tx_data *tx)
 		      test_sta_flag(sta, WLAN_STA_PS_DELIVER)) &&
 		     !(info->flags & IEEE80211_TX_CTL_NO_PS_BUFFER))) {
 		int ac = skb_get_queue_mapping(tx->skb);
+		int tid = IEEE80211_NUM_TIDS;
 
 		if (ieee80211_is_mgmt(hdr->frame_control) &&
 		    !ieee80211_is_bufferable_mmpdu(hdr->frame_control)) {
@@ -525,9 +527,14 @@ ieee80211_tx_h_unicast_ps_buf(struct ieee80211_tx_data *tx)
 		info->control.vif = &tx->sdata->vif;
 		info->control.flags |= IEEE80211_TX_INTCFL_NEED_TXPROCESSING;
 		info->flags &= ~IEEE80211_TX_TEMPORARY_FLAGS;
+		/* once queued, the frame may be delivered and freed at once */
+		if (ieee80211_is_data_qos(hdr->frame_control))
+			tid = tx->skb->priority;
 		skb_queue_tail(&sta->ps_tx_buf[ac], tx->skb);
 		spin_unlock(&sta->ps_lock);
 
+		ieee80211_sta_ps_lowlat_buffered(sta, tid);
+
 		if (!timer_pending(&local->sta_cleanup))
 			mod_timer(&local->sta_cleanup,
 				  round_jiffies(jiffies +
@@ -1163,6 +1170,13 @@ ieee80211_aggr_check(struct ieee80211_sub_if_data *sdata,
 	    skb->protocol == sdata->control_port_protocol)
 		return;
 
+	/* The ADDBA handshake holds back the TID's frames, don't wait for it
+	 * on the video queue of a latency-critical station.
+	 */
+	if (sta->airtime[IEEE80211_AC_VI].lowlat &&
+	    skb_get_queue_mapping(skb) == IEEE80211_AC_VI)
+		return;
+
 	tid = skb->priority & IEEE80211_QOS_CTL_TID_MASK;
 	if (likely(sta->ampdu_mlme.tid_tx[tid]))
 		return;
@@ -1472,6 +1486,18 @@ void ieee80211_txq_remove_vlan(struct ieee80211_local *local,
 	spin_unlock_bh(&fq->lock);
 }
 
+static enum hrtimer_restart ieee80211_txq_launch_timer(struct hrtimer *timer)
+{
+	struct txq_info *txqi = container_of(timer, struct txq_info,
+					     launch_timer);
+	struct ieee80211_sub_if_data *sdata = vif_to_sdata(txqi->txq.vif);
+
+	clear_bit(IEEE80211_TXQ_LAUNCH_WAIT, &txqi->flags);
+	schedule_and_wake_txq(sdata->local, txqi);
+
+	return HRTIMER_NORESTART;
+}
+
 void ieee80211_txq_init(struct ieee80211_sub_if_data *sdata,
 			struct sta_info *sta,
 			struct txq_info *txqi, int tid)
@@ -1481,6 +1507,9 @@ void ieee80211_txq_init(struct ieee80211_sub_if_data *sdata,
 	codel_stats_init(&txqi->cstats);
 	__skb_queue_head_init(&txqi->frags);
 	RB_CLEAR_NODE(&txqi->schedule_order);
+	hrtimer_init(&txqi->launch_timer, CLOCK_MONOTONIC,
+		     HRTIMER_MODE_ABS_SOFT);
+	txqi->launch_timer.function = ieee80211_txq_launch_timer;
 
 	txqi->txq.vif = &sdata->vif;
 
@@ -1524,6 +1553,8 @@ void ieee80211_txq_purge(struct ieee80211_local *local,
 	ieee80211_purge_tx_queue(&local->hw, &txqi->frags);
 	spin_unlock_bh(&fq->lock);
 
+	hrtimer_cancel(&txqi->launch_timer);
+	clear_bit(IEEE80211_TXQ_LAUNCH_WAIT, &txqi->flags);
 	ieee80211_unschedule_txq(&local->hw, &txqi->txq, true);
 }
 
@@ -3339,6 +3370,11 @@ static bool ieee80211_amsdu_aggregate(struct ieee80211_sub_if_data *sdata,
 		max_amsdu_len = min_t(int, max_amsdu_len,
 				      sta->sta.max_tid_amsdu_len[tid]);
 
+	/* an A-MSDU must also fit the A-MPDU length limit of the TID */
+	if (sta->sta.ampdu_policy[tid].max_len)
+		max_amsdu_len = min_t(int, max_amsdu_len,
+				      sta->sta.ampdu_policy[tid].max_len);
+
 	flow_idx = fq_flow_idx(fq, skb);
 
 	spin_lock_bh(&fq->lock);
@@ -3615,6 +3651,63 @@ static bool ieee80211_xmit_fast(struct ieee80211_sub_if_data *sdata,
 	return true;
 }
 
+/*
+ * Frames of SO_TXTIME sockets carry their launch time in skb->tstamp, in
+ * the clock of the socket. Frames due within the slack go out right away,
+ * and launch times further away than a second are taken as bogus.
+ */
+#define IEEE80211_TX_LAUNCH_SLACK_NS	(50 * NSEC_PER_USEC)
+#define IEEE80211_TX_LAUNCH_MAX_NS	NSEC_PER_SEC
+
+static ktime_t ieee80211_skb_launch_time(struct sk_buff *skb)
+{
+	struct sock *sk = skb->sk;
+
+	if (!skb->tstamp || !sk || !sk_fullsock(sk) ||
+	    !sock_flag(sk, SOCK_TXTIME))
+		return 0;
+
+	switch (sk->sk_clockid) {
+	case CLOCK_MONOTONIC:
+		return skb->tstamp;
+	case CLOCK_TAI:
+		return ktime_sub(skb->tstamp, ktime_mono_to_any(0, TK_OFFS_TAI));
+	case CLOCK_REALTIME:
+		return ktime_sub(skb->tstamp, ktime_mono_to_any(0, TK_OFFS_REAL));
+	case CLOCK_BOOTTIME:
+		return ktime_sub(skb->tstamp, ktime_mono_to_any(0, TK_OFFS_BOOT));
+	default:
+		return 0;
+	}
+}
+
+/*
+ * Called with fq->lock held for a frame about to be dequeued. A frame that
+ * is early is put back at the head of the TXQ, which drops out of the
+ * driver's schedule until the launch timer wakes it up again. Frames
+ * queued behind it wait as well, as with the ETF qdisc.
+ */
+static bool ieee80211_txq_hold(struct txq_info *txqi, struct sk_buff *skb)
+{
+	ktime_t launch = ieee80211_skb_launch_time(skb);
+	s64 delta;
+
+	if (likely(!launch))
+		return false;
+
+	delta = ktime_to_ns(ktime_sub(launch, ktime_get()));
+	if (delta <= IEEE80211_TX_LAUNCH_SLACK_NS ||
+	    delta > IEEE80211_TX_LAUNCH_MAX_NS)
+		return false;
+
+	IEEE80211_SKB_CB(skb)->control.flags |=
+		IEEE80211_TX_INTCFL_NEED_TXPROCESSING;
+	__skb_queue_head(&txqi->frags, skb);
+	set_bit(IEEE80211_TXQ_LAUNCH_WAIT, &txqi->flags);
+	hrtimer_start(&txqi->launch_timer, launch, HRTIMER_MODE_ABS_SOFT);
+	return true;
+}
+
 struct sk_buff *ieee80211_tx_dequeue(struct ieee80211_hw *hw,
 				     struct ieee80211_txq *txq)
 {
@@ -3661,6 +3754,11 @@ struct sk_buff *ieee80211_tx_dequeue(struct ieee80211_hw *hw,
 	if (!skb)
 		goto out;
 
+	if (unlikely(ieee80211_txq_hold(txqi, skb))) {
+		skb = NULL;
+		goto out;
+	}
+
 	spin_unlock_bh(&fq->lock);
 
 	hdr = (struct ieee80211_hdr *)skb->data;
@@ -3811,11 +3909,35 @@ struct sk_buff *ieee80211_tx_dequeue(struct ieee80211_hw *hw,
 }
 EXPORT_SYMBOL(ieee80211_tx_dequeue);
 
+/* the first latency-critical queue with budget left not served this round */
+static struct txq_info *
+ieee80211_next_lowlat_txq(struct ieee80211_hw *hw,
+			  struct airtime_sched_info *air_sched, u64 now)
+{
+	struct txq_info *txqi;
+	struct rb_node *node;
+
+	for (node = rb_first_cached(&air_sched->active_txqs); node;
+	     node = rb_next(node)) {
+		txqi = container_of(node, struct txq_info, schedule_order);
+
+		if (txqi->schedule_round == air_sched->schedule_round ||
+		    !airtime_lowlat_eligible(to_airtime_info(&txqi->txq), now) ||
+		    !ieee80211_txq_airtime_check(hw, &txqi->txq))
+			continue;
+
+		txqi->schedule_round = air_sched->schedule_round;
+		return txqi;
+	}
+
+	return NULL;
+}
+
 struct ieee80211_txq *ieee80211_next_txq(struct ieee80211_hw *hw, u8 ac)
 {
 	struct ieee80211_local *local = hw_to_local(hw);
 	struct airtime_sched_info *air_sched;
-	u64 now = ktime_get_boottime_ns();
+	u64 now = fast_clock_ns();
 	struct ieee80211_txq *ret = NULL;
 	struct airtime_info *air_info;
 	struct txq_info *txqi = NULL;
@@ -3825,6 +3947,15 @@ struct ieee80211_txq *ieee80211_next_txq(struct ieee80211_hw *hw, u8 ac)
 	air_sched = &local->airtime[ac];
 	spin_lock_bh(&air_sched->lock);
 
+	if (air_sched->lowlat_stations) {
+		txqi = ieee80211_next_lowlat_txq(hw, air_sched, now);
+		if (txqi) {
+			air_sched->last_schedule_activity = now;
+			ret = &txqi->txq;
+			goto out;
+		}
+	}
+
 	node = air_sched->schedule_pos;
 
 begin:
@@ -3942,7 +4073,7 @@ void ieee80211_update_airtime_weight(struct ieee80211_local *local,
 	u64 weight_sum = 0;
 
 	if (unlikely(!now))
-		now = ktime_get_boottime_ns();
+		now = fast_clock_ns();
 
 	lockdep_assert_held(&air_sched->lock);
 
@@ -3968,7 +4099,7 @@ void ieee80211_schedule_txq(struct ieee80211_hw *hw,
 	struct ieee80211_local *local = hw_to_local(hw);
 	struct txq_info *txqi = to_txq_info(txq);
 	struct airtime_sched_info *air_sched;
-	u64 now = ktime_get_boottime_ns();
+	u64 now = fast_clock_ns();
 	struct airtime_info *air_info;
 	u8 ac = txq->ac;
 	bool was_active;
@@ -4026,7 +4157,7 @@ static void __ieee80211_unschedule_txq(struct ieee80211_hw *hw,
 
 	if (!purge)
 		airtime_set_active(air_sched, air_info,
-				   ktime_get_boottime_ns());
+				   fast_clock_ns());
 
 	rb_erase_cached(&txqi->schedule_order,
 			&air_sched->active_txqs);
@@ -4054,7 +4185,8 @@ void ieee80211_return_txq(struct ieee80211_hw *hw,
 	spin_lock_bh(&local->airtime[txq->ac].lock);
 
 	if (!RB_EMPTY_NODE(&txqi->schedule_order) && !force &&
-	    !txq_has_queue(txq))
+	    (!txq_has_queue(txq) ||
+	     test_bit(IEEE80211_TXQ_LAUNCH_WAIT, &txqi->flags)))
 		__ieee80211_unschedule_txq(hw, txq, false);
 
 	spin_unlock_bh(&local->airtime[txq->ac].lock);
@@ -4114,7 +4246,13 @@ bool ieee80211_txq_may_transmit(struct ieee80211_hw *hw,
 	if (RB_EMPTY_NODE(&txqi->schedule_order))
 		goto out;
 
-	now = ktime_get_boottime_ns();
+	now = fast_clock_ns();
+
+	if (airtime_lowlat_eligible(to_airtime_info(txq), now)) {
+		air_sched->last_schedule_activity = now;
+		ret = true;
+		goto out;
+	}
 
 	/* Like in ieee80211_next_txq(), make sure the first station in the
 	 * scheduling order is eligible for transmission to avoid starvation.
@@ -4148,6 +4286,7 @@ void ieee80211_txq_schedule_start(struct ieee80211_hw *hw, u8 ac)
 
 	spin_lock_bh(&air_sched->lock);
 	air_sched->schedule_pos = NULL;
+	air_sched->schedule_round++;
 	spin_unlock_bh(&air_sched->lock);
 }
 EXPORT_SYMBOL(ieee80211_txq_schedule_start);
@@ -415,6 +415,7 @@ static int ccmp_encrypt_skb(struct ieee80211_tx_data *tx, struct sk_buff *skb,
 	u64 pn64;
 	u8 aad[CCM_AAD_LEN];
 	u8 b_0[AES_BLOCK_SIZE];
+	int ret;
 
 	if (info->control.hw_key &&
 	    !(info->control.hw_key->flags & IEEE80211_KEY_FLAG_GENERATE_IV) &&
@@ -469,8 +470,14 @@ static int ccmp_encrypt_skb(struct ieee80211_tx_data *tx, struct sk_buff *skb,
 
 	pos += IEEE80211_CCMP_HDR_LEN;
 	ccmp_special_blocks(skb, pn, b_0, aad);
-	return ieee80211_aes_ccm_encrypt(key->u.ccmp.tfm, b_0, aad, pos, len,
-					 skb_put(skb, mic_len));
+
+	/* the key's request is shared with the other TX queues */
+	spin_lock_bh(&key->u.ccmp.tx_req_lock);
+	ret = ieee80211_aes_ccm_encrypt_req(key->u.ccmp.tx_req, b_0, aad, pos,
+					    len, skb_put(skb, mic_len));
+	spin_unlock_bh(&key->u.ccmp.tx_req_lock);
+
+	return ret;
 }
 
 
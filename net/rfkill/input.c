@@ -228,6 +228,8 @@ static int rfkill_connect(struct input_handler *handler, struct input_dev *dev,
 	handle->dev = dev;
 	handle->handler = handler;
 	handle->name = "rfkill";
+	__set_bit(EV_KEY, handle->evbit);
+	__set_bit(EV_SW, handle->evbit);
 
 	/* causes rfkill_start() to be called */
 	error = input_register_handle(handle);
@@ -406,6 +406,9 @@ nl80211_tid_config_attr_policy[NL80211_TID_CONFIG_ATTR_MAX + 1] = {
 			NLA_POLICY_MAX(NLA_U8, NL80211_TX_RATE_FIXED),
 	[NL80211_TID_CONFIG_ATTR_TX_RATE] =
 			NLA_POLICY_NESTED(nl80211_txattr_policy),
+	[NL80211_TID_CONFIG_ATTR_AMPDU_MAX_LEN] = { .type = NLA_U32 },
+	[NL80211_TID_CONFIG_ATTR_AMPDU_MAX_DURATION] = { .type = NLA_U16 },
+	[NL80211_TID_CONFIG_ATTR_AMPDU_MAX_DELAY] = { .type = NLA_U16 },
 };
 
 static const struct nla_policy
@@ -763,6 +766,15 @@ static const struct nla_policy nl80211_policy[NUM_NL80211_ATTR] = {
 	[NL80211_ATTR_COLOR_CHANGE_COUNT] = { .type = NLA_U8 },
 	[NL80211_ATTR_COLOR_CHANGE_COLOR] = { .type = NLA_U8 },
 	[NL80211_ATTR_COLOR_CHANGE_ELEMS] = NLA_POLICY_NESTED(nl80211_policy),
+	[NL80211_ATTR_AIRTIME_LATENCY_CRITICAL] = NLA_POLICY_MAX(NLA_U8, 1),
+	[NL80211_ATTR_TSF] = { .type = NLA_REJECT },
+	[NL80211_ATTR_TSF_MONOTONIC] = { .type = NLA_REJECT },
+	[NL80211_ATTR_TSF_ERROR] = { .type = NLA_REJECT },
+	[NL80211_ATTR_RT_SCAN_POLICY] =
+		NLA_POLICY_MAX(NLA_U32, NL80211_RT_SCAN_REFUSE),
+	[NL80211_ATTR_PS_LOWLAT_TIDS] = { .type = NLA_U8 },
+	[NL80211_ATTR_PS_LOWLAT_INTERVAL] =
+		NLA_POLICY_RANGE(NLA_U32, 1000, 1000000),
 };
 
 /* policy for the key attributes */
@@ -3585,7 +3597,8 @@ static int nl80211_send_iface(struct sk_buff *msg, u32 portid, u32 seq, int flag
 	    nla_put_u32(msg, NL80211_ATTR_GENERATION,
 			rdev->devlist_generation ^
 			(cfg80211_rdev_list_generation << 2)) ||
-	    nla_put_u8(msg, NL80211_ATTR_4ADDR, wdev->use_4addr))
+	    nla_put_u8(msg, NL80211_ATTR_4ADDR, wdev->use_4addr) ||
+	    nla_put_u32(msg, NL80211_ATTR_RT_SCAN_POLICY, wdev->rt_scan_policy))
 		goto nla_put_failure;
 
 	if (rdev->ops->get_channel) {
@@ -3881,6 +3894,7 @@ static int nl80211_set_interface(struct sk_buff *skb, struct genl_info *info)
 	enum nl80211_iftype otype, ntype;
 	struct net_device *dev = info->user_ptr[1];
 	bool change = false;
+	int rt_scan_policy = -1;
 
 	memset(&params, 0, sizeof(params));
 
@@ -3926,6 +3940,10 @@ static int nl80211_set_interface(struct sk_buff *skb, struct genl_info *info)
 	if (err > 0)
 		change = true;
 
+	if (info->attrs[NL80211_ATTR_RT_SCAN_POLICY])
+		rt_scan_policy =
+			nla_get_u32(info->attrs[NL80211_ATTR_RT_SCAN_POLICY]);
+
 	if (change)
 		err = cfg80211_change_iface(rdev, dev, ntype, &params);
 	else
@@ -3934,6 +3952,12 @@ static int nl80211_set_interface(struct sk_buff *skb, struct genl_info *info)
 	if (!err && params.use_4addr != -1)
 		dev->ieee80211_ptr->use_4addr = params.use_4addr;
 
+	if (!err && rt_scan_policy != -1 &&
+	    rt_scan_policy != dev->ieee80211_ptr->rt_scan_policy) {
+		dev->ieee80211_ptr->rt_scan_policy = rt_scan_policy;
+		change = true;
+	}
+
 	if (change && !err) {
 		struct wireless_dev *wdev = dev->ieee80211_ptr;
 
@@ -6166,6 +6190,8 @@ int cfg80211_check_station_change(struct wiphy *wiphy,
 	    statype != CFG80211_STA_AP_CLIENT_UNASSOC) {
 		if (params->vlan)
 			return -EINVAL;
+		if (params->sta_modify_mask & STATION_PARAM_APPLY_PS_LOWLAT)
+			return -EINVAL;
 	}
 
 	switch (statype) {
@@ -6400,6 +6426,31 @@ static int nl80211_parse_sta_txpower_setting(struct genl_info *info,
 	return 0;
 }
 
+static int nl80211_parse_sta_ps_lowlat(struct genl_info *info,
+				       struct station_parameters *params)
+{
+	struct cfg80211_registered_device *rdev = info->user_ptr[0];
+
+	if (!info->attrs[NL80211_ATTR_PS_LOWLAT_TIDS])
+		return 0;
+
+	if (!wiphy_ext_feature_isset(&rdev->wiphy,
+				     NL80211_EXT_FEATURE_PS_LOWLAT_DELIVERY))
+		return -EOPNOTSUPP;
+
+	params->ps_lowlat_tids =
+		nla_get_u8(info->attrs[NL80211_ATTR_PS_LOWLAT_TIDS]);
+	if (params->ps_lowlat_tids) {
+		if (!info->attrs[NL80211_ATTR_PS_LOWLAT_INTERVAL])
+			return -EINVAL;
+		params->ps_lowlat_interval =
+			nla_get_u32(info->attrs[NL80211_ATTR_PS_LOWLAT_INTERVAL]);
+	}
+	params->sta_modify_mask |= STATION_PARAM_APPLY_PS_LOWLAT;
+
+	return 0;
+}
+
 static int nl80211_set_station(struct sk_buff *skb, struct genl_info *info)
 {
 	struct cfg80211_registered_device *rdev = info->user_ptr[0];
@@ -6495,11 +6546,22 @@ static int nl80211_set_station(struct sk_buff *skb, struct genl_info *info)
 		params.airtime_weight =
 			nla_get_u16(info->attrs[NL80211_ATTR_AIRTIME_WEIGHT]);
 
-	if (params.airtime_weight &&
+	if (info->attrs[NL80211_ATTR_AIRTIME_LATENCY_CRITICAL]) {
+		params.airtime_latency_critical =
+			nla_get_u8(info->attrs[NL80211_ATTR_AIRTIME_LATENCY_CRITICAL]);
+		params.sta_modify_mask |= STATION_PARAM_APPLY_AIRTIME_LATENCY;
+	}
+
+	if ((params.airtime_weight ||
+	     params.sta_modify_mask & STATION_PARAM_APPLY_AIRTIME_LATENCY) &&
 	    !wiphy_ext_feature_isset(&rdev->wiphy,
 				     NL80211_EXT_FEATURE_AIRTIME_FAIRNESS))
 		return -EOPNOTSUPP;
 
+	err = nl80211_parse_sta_ps_lowlat(info, &params);
+	if (err)
+		return err;
+
 	err = nl80211_parse_sta_txpower_setting(info, &params);
 	if (err)
 		return err;
@@ -6638,11 +6700,22 @@ static int nl80211_new_station(struct sk_buff *skb, struct genl_info *info)
 		params.airtime_weight =
 			nla_get_u16(info->attrs[NL80211_ATTR_AIRTIME_WEIGHT]);
 
-	if (params.airtime_weight &&
+	if (info->attrs[NL80211_ATTR_AIRTIME_LATENCY_CRITICAL]) {
+		params.airtime_latency_critical =
+			nla_get_u8(info->attrs[NL80211_ATTR_AIRTIME_LATENCY_CRITICAL]);
+		params.sta_modify_mask |= STATION_PARAM_APPLY_AIRTIME_LATENCY;
+	}
+
+	if ((params.airtime_weight ||
+	     params.sta_modify_mask & STATION_PARAM_APPLY_AIRTIME_LATENCY) &&
 	    !wiphy_ext_feature_isset(&rdev->wiphy,
 				     NL80211_EXT_FEATURE_AIRTIME_FAIRNESS))
 		return -EOPNOTSUPP;
 
+	err = nl80211_parse_sta_ps_lowlat(info, &params);
+	if (err)
+		return err;
+
 	err = nl80211_parse_sta_txpower_setting(info, &params);
 	if (err)
 		return err;
@@ -8254,6 +8327,21 @@ nl80211_check_scan_flags(struct wiphy *wiphy, struct wireless_dev *wdev,
 	return 0;
 }
 
+static enum nl80211_rt_scan_policy
+nl80211_rt_scan_policy(struct cfg80211_registered_device *rdev)
+{
+	enum nl80211_rt_scan_policy policy = NL80211_RT_SCAN_ALLOW;
+	struct wireless_dev *wdev;
+
+	list_for_each_entry(wdev, &rdev->wiphy.wdev_list, list) {
+		if (!wdev->netdev || !netif_running(wdev->netdev))
+			continue;
+		policy = max(policy, wdev->rt_scan_policy);
+	}
+
+	return policy;
+}
+
 static int nl80211_trigger_scan(struct sk_buff *skb, struct genl_info *info)
 {
 	struct cfg80211_registered_device *rdev = info->user_ptr[0];
@@ -8265,6 +8353,7 @@ static int nl80211_trigger_scan(struct sk_buff *skb, struct genl_info *info)
 	struct wiphy *wiphy;
 	int err, tmp, n_ssids = 0, n_channels, i;
 	size_t ie_len;
+	enum nl80211_rt_scan_policy rt_policy;
 
 	wiphy = &rdev->wiphy;
 
@@ -8277,6 +8366,13 @@ static int nl80211_trigger_scan(struct sk_buff *skb, struct genl_info *info)
 	if (rdev->scan_req || rdev->scan_msg)
 		return -EBUSY;
 
+	rt_policy = nl80211_rt_scan_policy(rdev);
+	if (rt_policy == NL80211_RT_SCAN_REFUSE) {
+		GENL_SET_ERR_MSG(info,
+				 "scan refused while carrying real-time traffic");
+		return -EBUSY;
+	}
+
 	if (info->attrs[NL80211_ATTR_SCAN_FREQ_KHZ]) {
 		if (!wiphy_ext_feature_isset(wiphy,
 					     NL80211_EXT_FEATURE_SCAN_FREQ_KHZ))
@@ -8458,6 +8554,13 @@ static int nl80211_trigger_scan(struct sk_buff *skb, struct genl_info *info)
 	if (err)
 		goto out_free;
 
+	/* keep offloaded scans off the operating channel as briefly as possible */
+	if (rt_policy == NL80211_RT_SCAN_SPLIT &&
+	    wiphy_ext_feature_isset(wiphy, NL80211_EXT_FEATURE_LOW_SPAN_SCAN) &&
+	    !(request->flags & (NL80211_SCAN_FLAG_LOW_POWER |
+				NL80211_SCAN_FLAG_HIGH_ACCURACY)))
+		request->flags |= NL80211_SCAN_FLAG_LOW_SPAN;
+
 	request->no_cck =
 		nla_get_flag(info->attrs[NL80211_ATTR_TX_NO_CCK_RATE]);
 
@@ -8998,6 +9101,12 @@ static int nl80211_start_sched_scan(struct sk_buff *skb,
 	if (!rdev->wiphy.max_sched_scan_reqs || !rdev->ops->sched_scan_start)
 		return -EOPNOTSUPP;
 
+	if (nl80211_rt_scan_policy(rdev) == NL80211_RT_SCAN_REFUSE) {
+		GENL_SET_ERR_MSG(info,
+				 "scan refused while carrying real-time traffic");
+		return -EBUSY;
+	}
+
 	want_multi = info->attrs[NL80211_ATTR_SCHED_SCAN_MULTI];
 	err = cfg80211_sched_scan_req_possible(rdev, want_multi);
 	if (err)
@@ -11628,6 +11737,50 @@ static int nl80211_get_power_save(struct sk_buff *skb, struct genl_info *info)
 	return err;
 }
 
+static int nl80211_get_tsf(struct sk_buff *skb, struct genl_info *info)
+{
+	struct cfg80211_registered_device *rdev = info->user_ptr[0];
+	struct net_device *dev = info->user_ptr[1];
+	struct cfg80211_tsf_info tsf = {};
+	struct sk_buff *msg;
+	void *hdr;
+	int err;
+
+	if (!rdev->ops->get_tsf)
+		return -EOPNOTSUPP;
+
+	err = rdev_get_tsf(rdev, dev, &tsf);
+	if (err)
+		return err;
+
+	msg = nlmsg_new(NLMSG_DEFAULT_SIZE, GFP_KERNEL);
+	if (!msg)
+		return -ENOMEM;
+
+	hdr = nl80211hdr_put(msg, info->snd_portid, info->snd_seq, 0,
+			     NL80211_CMD_GET_TSF);
+	if (!hdr) {
+		err = -ENOBUFS;
+		goto free_msg;
+	}
+
+	if (nla_put_u64_64bit(msg, NL80211_ATTR_TSF, tsf.tsf,
+			      NL80211_ATTR_PAD) ||
+	    nla_put_u64_64bit(msg, NL80211_ATTR_TSF_MONOTONIC,
+			      tsf.monotonic_ns, NL80211_ATTR_PAD) ||
+	    nla_put_u32(msg, NL80211_ATTR_TSF_ERROR, tsf.error_ns))
+		goto nla_put_failure;
+
+	genlmsg_end(msg, hdr);
+	return genlmsg_reply(msg, info);
+
+ nla_put_failure:
+	err = -ENOBUFS;
+ free_msg:
+	nlmsg_free(msg);
+	return err;
+}
+
 static const struct nla_policy
 nl80211_attr_cqm_policy[NL80211_ATTR_CQM_MAX + 1] = {
 	[NL80211_ATTR_CQM_RSSI_THOLD] = { .type = NLA_BINARY },
@@ -14735,6 +14888,25 @@ static int parse_tid_conf(struct cfg80211_registered_device *rdev,
 		tid_conf->mask |= BIT(NL80211_TID_CONFIG_ATTR_TX_RATE_TYPE);
 	}
 
+	if (attrs[NL80211_TID_CONFIG_ATTR_AMPDU_MAX_LEN]) {
+		tid_conf->mask |= BIT(NL80211_TID_CONFIG_ATTR_AMPDU_MAX_LEN);
+		tid_conf->ampdu_max_len =
+			nla_get_u32(attrs[NL80211_TID_CONFIG_ATTR_AMPDU_MAX_LEN]);
+	}
+
+	if (attrs[NL80211_TID_CONFIG_ATTR_AMPDU_MAX_DURATION]) {
+		u32 idx = NL80211_TID_CONFIG_ATTR_AMPDU_MAX_DURATION;
+
+		tid_conf->mask |= BIT(idx);
+		tid_conf->ampdu_max_duration = nla_get_u16(attrs[idx]);
+	}
+
+	if (attrs[NL80211_TID_CONFIG_ATTR_AMPDU_MAX_DELAY]) {
+		tid_conf->mask |= BIT(NL80211_TID_CONFIG_ATTR_AMPDU_MAX_DELAY);
+		tid_conf->ampdu_max_delay =
+			nla_get_u16(attrs[NL80211_TID_CONFIG_ATTR_AMPDU_MAX_DELAY]);
+	}
+
 	if (peer)
 		mask = rdev->wiphy.tid_config_support.peer;
 	else
@@ -15907,6 +16079,13 @@ static const struct genl_small_ops nl80211_small_ops[] = {
 		.internal_flags = NL80211_FLAG_NEED_NETDEV_UP |
 				  NL80211_FLAG_NEED_RTNL,
 	},
+	{
+		.cmd = NL80211_CMD_GET_TSF,
+		.validate = GENL_DONT_VALIDATE_STRICT | GENL_DONT_VALIDATE_DUMP,
+		.doit = nl80211_get_tsf,
+		/* can be retrieved by unprivileged users */
+		.internal_flags = NL80211_FLAG_NEED_NETDEV_UP,
+	},
 };
 
 static struct genl_family nl80211_fam __ro_after_init = {
@@ -1381,4 +1381,17 @@ static inline int rdev_color_change(struct cfg80211_registered_device *rdev,
 	return ret;
 }
 
+static inline int rdev_get_tsf(struct cfg80211_registered_device *rdev,
+			       struct net_device *dev,
+			       struct cfg80211_tsf_info *tsf)
+{
+	int ret;
+
+	trace_rdev_get_tsf(&rdev->wiphy, dev);
+	ret = rdev->ops->get_tsf(&rdev->wiphy, dev, tsf);
+	trace_rdev_return_int(&rdev->wiphy, ret);
+
+	return ret;
+}
+
 #endif /* __CFG80211_RDEV_OPS */
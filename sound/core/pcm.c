@@ -692,6 +692,7 @@ int snd_pcm_new_stream(struct snd_pcm *pcm, int stream, int substream_count)
 		}
 		substream->group = &substream->self_group;
 		snd_pcm_group_init(&substream->self_group);
+		snd_pcm_hw_ptr_timer_init(substream);
 		list_add_tail(&substream->link_list, &substream->self_group.substreams);
 		atomic_set(&substream->mmap_count, 0);
 		prev = substream;
@@ -983,6 +984,7 @@ void snd_pcm_detach_substream(struct snd_pcm_substream *substream)
 	if (PCM_RUNTIME_CHECK(substream))
 		return;
 	runtime = substream->runtime;
+	hrtimer_cancel(&substream->hw_ptr_timer);
 	if (runtime->private_free != NULL)
 		runtime->private_free(runtime);
 	free_pages_exact(runtime->status,
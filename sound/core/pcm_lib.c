@@ -10,6 +10,8 @@
 #include <linux/time.h>
 #include <linux/math64.h>
 #include <linux/export.h>
+#include <linux/moduleparam.h>
+#include <linux/trace_fixed.h>
 #include <sound/core.h>
 #include <sound/control.h>
 #include <sound/tlv.h>
@@ -33,6 +35,12 @@
 static int fill_silence_frames(struct snd_pcm_substream *substream,
 			       snd_pcm_uframes_t off, snd_pcm_uframes_t frames);
 
+static unsigned int hw_ptr_update_us;
+module_param(hw_ptr_update_us, uint, 0644);
+MODULE_PARM_DESC(hw_ptr_update_us, "Update the hw_ptr of running streams every N us (0 = only on period interrupts).");
+
+#define HW_PTR_UPDATE_MIN_US	100
+
 /*
  * fill ring buffer with silence
  * runtime->silence_start: starting pointer to silence area
@@ -1816,6 +1824,12 @@ void snd_pcm_period_elapsed_under_stream_lock(struct snd_pcm_substream *substrea
 	    snd_pcm_update_hw_ptr0(substream, 1) < 0)
 		goto _end;
 
+	trace_fixed(TRACE_FIXED_PCM_PERIOD,
+		    substream->pcm->card->number << 16 |
+		    substream->pcm->device << 8 |
+		    substream->number << 1 | substream->stream,
+		    runtime->status->hw_ptr, runtime->control->appl_ptr, 0);
+
 #ifdef CONFIG_SND_PCM_TIMER
 	if (substream->timer_running)
 		snd_timer_interrupt(substream->timer, 1);
@@ -1850,6 +1864,66 @@ void snd_pcm_period_elapsed(struct snd_pcm_substream *substream)
 }
 EXPORT_SYMBOL(snd_pcm_period_elapsed);
 
+/*
+ * Periodic hw_ptr update: lets applications follow the position through
+ * the mmapped status record between period interrupts, or without any
+ * when they asked for no period wakeups.
+ */
+static enum hrtimer_restart snd_pcm_hw_ptr_timer_func(struct hrtimer *timer)
+{
+	struct snd_pcm_substream *substream =
+		container_of(timer, struct snd_pcm_substream, hw_ptr_timer);
+	enum hrtimer_restart ret = HRTIMER_NORESTART;
+	unsigned long flags;
+
+	snd_pcm_stream_lock_irqsave(substream, flags);
+	/* stopped, or stopped and restarted while we waited for the lock */
+	if (!substream->runtime || !snd_pcm_running(substream) ||
+	    hrtimer_is_queued(timer))
+		goto unlock;
+
+	if (snd_pcm_update_hw_ptr(substream) < 0 ||
+	    !snd_pcm_running(substream))
+		goto unlock;
+
+	hrtimer_forward_now(timer, substream->hw_ptr_interval);
+	ret = HRTIMER_RESTART;
+ unlock:
+	snd_pcm_stream_unlock_irqrestore(substream, flags);
+	return ret;
+}
+
+void snd_pcm_hw_ptr_timer_init(struct snd_pcm_substream *substream)
+{
+	hrtimer_init(&substream->hw_ptr_timer, CLOCK_MONOTONIC,
+		     HRTIMER_MODE_REL_SOFT);
+	substream->hw_ptr_timer.function = snd_pcm_hw_ptr_timer_func;
+}
+
+/* called with the stream lock held when the stream starts running */
+void snd_pcm_hw_ptr_timer_start(struct snd_pcm_substream *substream)
+{
+	struct snd_pcm_runtime *runtime = substream->runtime;
+	unsigned int us = READ_ONCE(hw_ptr_update_us);
+	u64 interval, period;
+
+	/* the pointer callback of nonatomic streams may sleep */
+	if (!us || substream->pcm->nonatomic)
+		return;
+
+	interval = (u64)max_t(unsigned int, us, HW_PTR_UPDATE_MIN_US) *
+		   NSEC_PER_USEC;
+	period = div_u64((u64)runtime->period_size * NSEC_PER_SEC,
+			 runtime->rate);
+	/* period interrupts are frequent enough already */
+	if (!runtime->no_period_wakeup && interval >= period)
+		return;
+
+	substream->hw_ptr_interval = ns_to_ktime(interval);
+	hrtimer_start(&substream->hw_ptr_timer, substream->hw_ptr_interval,
+		      HRTIMER_MODE_REL_SOFT);
+}
+
 /*
  * Wait until avail_min data becomes available
  * Returns a negative error code if any error occurs during operation.
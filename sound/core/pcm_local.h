@@ -29,6 +29,15 @@ int snd_pcm_update_state(struct snd_pcm_substream *substream,
 			 struct snd_pcm_runtime *runtime);
 int snd_pcm_update_hw_ptr(struct snd_pcm_substream *substream);
 
+void snd_pcm_hw_ptr_timer_init(struct snd_pcm_substream *substream);
+void snd_pcm_hw_ptr_timer_start(struct snd_pcm_substream *substream);
+
+static inline void snd_pcm_hw_ptr_timer_stop(struct snd_pcm_substream *substream)
+{
+	/* the callback may be spinning on the stream lock, it bails out */
+	hrtimer_try_to_cancel(&substream->hw_ptr_timer);
+}
+
 void snd_pcm_playback_silence(struct snd_pcm_substream *substream,
 			      snd_pcm_uframes_t new_hw_ptr);
 
@@ -599,6 +599,7 @@ static inline void snd_pcm_timer_notify(struct snd_pcm_substream *substream,
 
 void snd_pcm_sync_stop(struct snd_pcm_substream *substream, bool sync_irq)
 {
+	hrtimer_cancel(&substream->hw_ptr_timer);
 	if (substream->runtime && substream->runtime->stop_operating) {
 		substream->runtime->stop_operating = false;
 		if (substream->ops && substream->ops->sync_stop)
@@ -1389,6 +1390,7 @@ static void snd_pcm_post_start(struct snd_pcm_substream *substream,
 	if (substream->stream == SNDRV_PCM_STREAM_PLAYBACK &&
 	    runtime->silence_size > 0)
 		snd_pcm_playback_silence(substream, ULONG_MAX);
+	snd_pcm_hw_ptr_timer_start(substream);
 	snd_pcm_timer_notify(substream, SNDRV_TIMER_EVENT_MSTART);
 }
 
@@ -1447,6 +1449,7 @@ static void snd_pcm_post_stop(struct snd_pcm_substream *substream,
 			      snd_pcm_state_t state)
 {
 	struct snd_pcm_runtime *runtime = substream->runtime;
+	snd_pcm_hw_ptr_timer_stop(substream);
 	if (runtime->status->state != state) {
 		snd_pcm_trigger_tstamp(substream);
 		runtime->status->state = state;
@@ -1570,11 +1573,13 @@ static void snd_pcm_post_pause(struct snd_pcm_substream *substream,
 	snd_pcm_trigger_tstamp(substream);
 	if (pause_pushed(state)) {
 		runtime->status->state = SNDRV_PCM_STATE_PAUSED;
+		snd_pcm_hw_ptr_timer_stop(substream);
 		snd_pcm_timer_notify(substream, SNDRV_TIMER_EVENT_MPAUSE);
 		wake_up(&runtime->sleep);
 		wake_up(&runtime->tsleep);
 	} else {
 		runtime->status->state = SNDRV_PCM_STATE_RUNNING;
+		snd_pcm_hw_ptr_timer_start(substream);
 		snd_pcm_timer_notify(substream, SNDRV_TIMER_EVENT_MCONTINUE);
 	}
 }
@@ -1642,6 +1647,7 @@ static void snd_pcm_post_suspend(struct snd_pcm_substream *substream,
 	snd_pcm_trigger_tstamp(substream);
 	runtime->status->suspended_state = runtime->status->state;
 	runtime->status->state = SNDRV_PCM_STATE_SUSPENDED;
+	snd_pcm_hw_ptr_timer_stop(substream);
 	snd_pcm_timer_notify(substream, SNDRV_TIMER_EVENT_MSUSPEND);
 	wake_up(&runtime->sleep);
 	wake_up(&runtime->tsleep);
@@ -1753,6 +1759,8 @@ static void snd_pcm_post_resume(struct snd_pcm_substream *substream,
 	struct snd_pcm_runtime *runtime = substream->runtime;
 	snd_pcm_trigger_tstamp(substream);
 	runtime->status->state = runtime->status->suspended_state;
+	if (snd_pcm_running(substream))
+		snd_pcm_hw_ptr_timer_start(substream);
 	snd_pcm_timer_notify(substream, SNDRV_TIMER_EVENT_MRESUME);
 }
 
@@ -1038,21 +1038,32 @@ static struct timespec64 get_framing_tstamp(struct snd_rawmidi_substream *substr
 	return ts64;
 }
 
-/**
- * snd_rawmidi_receive - receive the input data from the device
- * @substream: the rawmidi substream
- * @buffer: the buffer pointer
- * @count: the data size to read
- *
- * Reads the data from the internal buffer.
- *
- * Return: The size of read data, or a negative error code on failure.
- */
-int snd_rawmidi_receive(struct snd_rawmidi_substream *substream,
-			const unsigned char *buffer, int count)
+/* @when in CLOCK_MONOTONIC, converted to the clock of the substream */
+static struct timespec64 convert_framing_tstamp(struct snd_rawmidi_substream *substream,
+						ktime_t when)
+{
+	struct timespec64 ts64 = {0, 0};
+
+	switch (substream->clock_type) {
+	case SNDRV_RAWMIDI_MODE_CLOCK_MONOTONIC_RAW:
+		ts64 = ktime_to_timespec64(ktime_sub(ktime_get_raw(),
+						     ktime_sub(ktime_get(), when)));
+		break;
+	case SNDRV_RAWMIDI_MODE_CLOCK_MONOTONIC:
+		ts64 = ktime_to_timespec64(when);
+		break;
+	case SNDRV_RAWMIDI_MODE_CLOCK_REALTIME:
+		ts64 = ktime_to_timespec64(ktime_mono_to_real(when));
+		break;
+	}
+	return ts64;
+}
+
+static int __snd_rawmidi_receive(struct snd_rawmidi_substream *substream,
+				 const unsigned char *buffer, int count,
+				 const struct timespec64 *tstamp)
 {
 	unsigned long flags;
-	struct timespec64 ts64 = get_framing_tstamp(substream);
 	int result = 0, count1;
 	struct snd_rawmidi_runtime *runtime = substream->runtime;
 
@@ -1066,7 +1077,7 @@ int snd_rawmidi_receive(struct snd_rawmidi_substream *substream,
 
 	spin_lock_irqsave(&runtime->lock, flags);
 	if (substream->framing == SNDRV_RAWMIDI_MODE_FRAMING_TSTAMP) {
-		result = receive_with_tstamp_framing(substream, buffer, count, &ts64);
+		result = receive_with_tstamp_framing(substream, buffer, count, tstamp);
 	} else if (count == 1) {	/* special case, faster code */
 		substream->bytes++;
 		if (runtime->avail < runtime->buffer_size) {
@@ -1114,8 +1125,48 @@ int snd_rawmidi_receive(struct snd_rawmidi_substream *substream,
 	spin_unlock_irqrestore(&runtime->lock, flags);
 	return result;
 }
+
+/**
+ * snd_rawmidi_receive - receive the input data from the device
+ * @substream: the rawmidi substream
+ * @buffer: the buffer pointer
+ * @count: the data size to read
+ *
+ * Reads the data from the internal buffer.
+ *
+ * Return: The size of read data, or a negative error code on failure.
+ */
+int snd_rawmidi_receive(struct snd_rawmidi_substream *substream,
+			const unsigned char *buffer, int count)
+{
+	struct timespec64 ts64 = get_framing_tstamp(substream);
+
+	return __snd_rawmidi_receive(substream, buffer, count, &ts64);
+}
 EXPORT_SYMBOL(snd_rawmidi_receive);
 
+/**
+ * snd_rawmidi_receive_at - receive the input data with its arrival time
+ * @substream: the rawmidi substream
+ * @buffer: the buffer pointer
+ * @count: the data size to read
+ * @when: CLOCK_MONOTONIC time the data arrived at the device
+ *
+ * Like snd_rawmidi_receive(), for drivers which know better than the
+ * time of the call when the data arrived. @when is used for the frames
+ * of substreams in framing mode.
+ *
+ * Return: The size of read data, or a negative error code on failure.
+ */
+int snd_rawmidi_receive_at(struct snd_rawmidi_substream *substream,
+			   const unsigned char *buffer, int count, ktime_t when)
+{
+	struct timespec64 ts64 = convert_framing_tstamp(substream, when);
+
+	return __snd_rawmidi_receive(substream, buffer, count, &ts64);
+}
+EXPORT_SYMBOL(snd_rawmidi_receive_at);
+
 static long snd_rawmidi_kernel_read1(struct snd_rawmidi_substream *substream,
 				     unsigned char __user *userbuf,
 				     unsigned char *kernelbuf, long count)
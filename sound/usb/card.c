@@ -69,9 +69,11 @@ static int device_setup[SNDRV_CARDS]; /* device parameter for this card */
 static bool ignore_ctl_error;
 static bool autoclock = true;
 static bool lowlatency = true;
+static bool lowlatency_urbs;
 static char *quirk_alias[SNDRV_CARDS];
 static char *delayed_register[SNDRV_CARDS];
 static bool implicit_fb[SNDRV_CARDS];
+static bool implicit_fb_smooth;
 static unsigned int quirk_flags[SNDRV_CARDS];
 
 bool snd_usb_use_vmalloc = true;
@@ -96,12 +98,16 @@ module_param(autoclock, bool, 0444);
 MODULE_PARM_DESC(autoclock, "Enable auto-clock selection for UAC2 devices (default: yes).");
 module_param(lowlatency, bool, 0444);
 MODULE_PARM_DESC(lowlatency, "Enable low latency playback (default: yes).");
+module_param(lowlatency_urbs, bool, 0444);
+MODULE_PARM_DESC(lowlatency_urbs, "Use playback URBs of at most 1ms in low latency mode (default: no).");
 module_param_array(quirk_alias, charp, NULL, 0444);
 MODULE_PARM_DESC(quirk_alias, "Quirk aliases, e.g. 0123abcd:5678beef.");
 module_param_array(delayed_register, charp, NULL, 0444);
 MODULE_PARM_DESC(delayed_register, "Quirk for delayed registration, given by id:iface, e.g. 0123abcd:4.");
 module_param_array(implicit_fb, bool, NULL, 0444);
 MODULE_PARM_DESC(implicit_fb, "Apply generic implicit feedback sync mode.");
+module_param(implicit_fb_smooth, bool, 0444);
+MODULE_PARM_DESC(implicit_fb_smooth, "Derive implicit feedback packet sizes from a smoothed rate estimate (default: no).");
 module_param_array(quirk_flags, uint, NULL, 0444);
 MODULE_PARM_DESC(quirk_flags, "Driver quirk bit flags.");
 module_param_named(use_vmalloc, snd_usb_use_vmalloc, bool, 0444);
@@ -625,8 +631,10 @@ static int snd_usb_audio_create(struct usb_interface *intf,
 	chip->card = card;
 	chip->setup = device_setup[idx];
 	chip->generic_implicit_fb = implicit_fb[idx];
+	chip->implicit_fb_smooth = implicit_fb_smooth;
 	chip->autoclock = autoclock;
 	chip->lowlatency = lowlatency;
+	chip->lowlatency_urbs = lowlatency && lowlatency_urbs;
 	atomic_set(&chip->active, 1); /* avoid autopm during probing */
 	atomic_set(&chip->usage_count, 0);
 	atomic_set(&chip->shutdown, 0);
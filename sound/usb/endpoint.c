@@ -515,6 +515,58 @@ static void snd_complete_urb(struct urb *urb)
 	clear_bit(ctx->index, &ep->active_mask);
 }
 
+/*
+ * complete callback for a batch of inbound urbs of one endpoint
+ *
+ * The batch is retired and prepared in order, and then resubmitted at once.
+ * Each urb is still retired by itself, as in snd_complete_urb().
+ */
+static void snd_complete_urbs(struct urb **urbs, unsigned int count)
+{
+	struct snd_urb_ctx *ctx = urbs[0]->context;
+	struct snd_usb_endpoint *ep = ctx->ep;
+	unsigned int i, unsubmitted = 0;
+	int err;
+
+	for (i = 0; i < count; i++) {
+		ctx = urbs[i]->context;
+		if (unlikely(urbs[i]->status == -ENOENT ||	/* unlinked */
+			     urbs[i]->status == -ENODEV ||	/* device removed */
+			     urbs[i]->status == -ECONNRESET ||	/* unlinked */
+			     urbs[i]->status == -ESHUTDOWN))	/* device disabled */
+			goto exit_clear;
+		/* device disconnected */
+		if (unlikely(atomic_read(&ep->chip->shutdown)))
+			goto exit_clear;
+
+		if (unlikely(!ep_state_running(ep)))
+			goto exit_clear;
+
+		retire_inbound_urb(ep, ctx);
+		/* can be stopped during retire callback */
+		if (unlikely(!ep_state_running(ep)))
+			goto exit_clear;
+
+		prepare_inbound_urb(ep, ctx);
+	}
+
+	err = usb_submit_urbs(urbs, count, GFP_ATOMIC);
+	if (err == count)
+		return;
+
+	usb_audio_err(ep->chip, "cannot submit urb (err = %d)\n",
+		      err < 0 ? err : -EIO);
+	notify_xrun(ep);
+	if (err > 0)
+		unsubmitted = err;
+
+exit_clear:
+	for (i = unsubmitted; i < count; i++) {
+		ctx = urbs[i]->context;
+		clear_bit(ctx->index, &ep->active_mask);
+	}
+}
+
 /*
  * Find or create a refcount object for the given interface
  *
@@ -1076,6 +1128,11 @@ static int data_ep_set_params(struct snd_usb_endpoint *ep)
 	 * a period fits as evenly as possible in the smallest number of
 	 * URBs.  The total number of URBs is adjusted to the size of the
 	 * ALSA buffer, subject to the MAX_URBS and MAX_QUEUE limits.
+	 *
+	 * With the lowlatency_urbs option, playback URBs are sized like
+	 * capture ones instead (at most 1 ms and smaller than a period),
+	 * so the queue in front of the device is only as deep as the ALSA
+	 * buffer asks for and each URB is filled right before it is sent.
 	 */
 	} else {
 		/* determine how small a packet can be */
@@ -1089,11 +1146,21 @@ static int data_ep_set_params(struct snd_usb_endpoint *ep)
 		/* how many packets will contain an entire ALSA period? */
 		max_packs_per_period = DIV_ROUND_UP(ep->cur_period_bytes, minsize);
 
-		/* how many URBs will contain a period? */
-		urbs_per_period = DIV_ROUND_UP(max_packs_per_period,
-				max_packs_per_urb);
-		/* how many packets are needed in each URB? */
-		urb_packs = DIV_ROUND_UP(max_packs_per_period, urbs_per_period);
+		if (chip->lowlatency_urbs) {
+			urb_packs = min(max_packs_per_urb, packs_per_ms);
+			while (urb_packs > 1 &&
+			       urb_packs * maxsize >= ep->cur_period_bytes)
+				urb_packs >>= 1;
+			urbs_per_period = DIV_ROUND_UP(max_packs_per_period,
+						       urb_packs);
+		} else {
+			/* how many URBs will contain a period? */
+			urbs_per_period = DIV_ROUND_UP(max_packs_per_period,
+					max_packs_per_urb);
+			/* how many packets are needed in each URB? */
+			urb_packs = DIV_ROUND_UP(max_packs_per_period,
+						 urbs_per_period);
+		}
 
 		/* limit the number of frames in a single URB */
 		ep->max_urb_frames = DIV_ROUND_UP(ep->cur_period_frames,
@@ -1129,6 +1196,8 @@ static int data_ep_set_params(struct snd_usb_endpoint *ep)
 		u->urb->interval = 1 << ep->datainterval;
 		u->urb->context = u;
 		u->urb->complete = snd_complete_urb;
+		if (usb_pipein(ep->pipe))
+			u->urb->complete_batch = snd_complete_urbs;
 		INIT_LIST_HEAD(&u->ready_list);
 	}
 
@@ -1176,6 +1245,8 @@ static int sync_ep_set_params(struct snd_usb_endpoint *ep)
 		u->urb->interval = 1 << ep->syncinterval;
 		u->urb->context = u;
 		u->urb->complete = snd_complete_urb;
+		if (usb_pipein(ep->pipe))
+			u->urb->complete_batch = snd_complete_urbs;
 	}
 
 	ep->nurbs = SYNC_URBS;
@@ -1495,6 +1566,39 @@ void snd_usb_endpoint_free_all(struct snd_usb_audio *chip)
 		kfree(ip);
 }
 
+/* weight of the newest capture URB in the implicit feedback rate estimate */
+#define IMPLICIT_FB_SMOOTHING	16
+
+/*
+ * Feed the frames per packet of a captured URB into the rate estimate of
+ * an implicit feedback sink.  ep->freqm holds the estimate in the same
+ * Q16.16 fs/fps format as for explicit feedback.  Called with ep->lock.
+ */
+static void implicit_fb_track_rate(struct snd_usb_endpoint *ep,
+				   struct snd_usb_endpoint *sender,
+				   const struct urb *urb)
+{
+	struct snd_urb_ctx *in_ctx = urb->context;
+	unsigned int frames = 0, packets = 0, rate;
+	int i;
+
+	for (i = 0; i < in_ctx->packets; i++) {
+		if (urb->iso_frame_desc[i].status)
+			continue;
+		frames += urb->iso_frame_desc[i].actual_length / sender->stride;
+		packets++;
+	}
+	if (!packets)
+		return;
+
+	rate = ((frames << 16) / packets) >> sender->datainterval;
+	/* a short or bogus capture URB shouldn't drag the estimate along */
+	if (rate < ep->freqn - ep->freqn / 8 || rate > ep->freqmax)
+		return;
+
+	ep->freqm += ((int)rate - (int)ep->freqm) / IMPLICIT_FB_SMOOTHING;
+}
+
 /*
  * snd_usb_handle_sync_urb: parse an USB sync packet
  *
@@ -1563,15 +1667,30 @@ static void snd_usb_handle_sync_urb(struct snd_usb_endpoint *ep,
 		 * by the stride, use the sender stride to calculate the length
 		 * in case the number of channels differ between the implicitly
 		 * fed-back endpoint and the synchronizing endpoint.
+		 *
+		 * In smoothing mode, only the packet count is taken over; the
+		 * sizes come from the rate estimate through the same phase
+		 * accumulator as for explicit feedback, so that capture side
+		 * jitter doesn't turn into playback packet size jitter.
 		 */
 
 		out_packet->packets = in_ctx->packets;
-		for (i = 0; i < in_ctx->packets; i++) {
-			if (urb->iso_frame_desc[i].status == 0)
+		if (ep->chip->implicit_fb_smooth) {
+			implicit_fb_track_rate(ep, sender, urb);
+			for (i = 0; i < in_ctx->packets; i++) {
+				ep->phase = (ep->phase & 0xffff)
+					+ (ep->freqm << ep->datainterval);
 				out_packet->packet_size[i] =
-					urb->iso_frame_desc[i].actual_length / sender->stride;
-			else
-				out_packet->packet_size[i] = 0;
+					min(ep->phase >> 16, ep->maxframesize);
+			}
+		} else {
+			for (i = 0; i < in_ctx->packets; i++) {
+				if (urb->iso_frame_desc[i].status == 0)
+					out_packet->packet_size[i] =
+						urb->iso_frame_desc[i].actual_length / sender->stride;
+				else
+					out_packet->packet_size[i] = 0;
+			}
 		}
 
 		spin_unlock_irqrestore(&ep->lock, flags);
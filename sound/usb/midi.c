@@ -78,6 +78,10 @@ MODULE_AUTHOR("Clemens Ladisch <clemens@ladisch.de>");
 MODULE_DESCRIPTION("USB Audio/MIDI helper module");
 MODULE_LICENSE("Dual BSD/GPL");
 
+static bool low_latency;
+module_param(low_latency, bool, 0444);
+MODULE_PARM_DESC(low_latency, "Poll interrupt MIDI inputs every (micro)frame.");
+
 struct snd_usb_midi_in_endpoint;
 struct snd_usb_midi_out_endpoint;
 struct snd_usb_midi_endpoint;
@@ -162,6 +166,7 @@ struct snd_usb_midi_in_endpoint {
 	u8 last_cin;
 	u8 error_resubmit;
 	int current_port;
+	ktime_t urb_tstamp;	/* completion time of the current input URB */
 };
 
 static void snd_usbmidi_do_output(struct snd_usb_midi_out_endpoint *ep);
@@ -218,7 +223,7 @@ static void snd_usbmidi_input_data(struct snd_usb_midi_in_endpoint *ep,
 	}
 	if (!test_bit(port->substream->number, &ep->umidi->input_triggered))
 		return;
-	snd_rawmidi_receive(port->substream, data, length);
+	snd_rawmidi_receive_at(port->substream, data, length, ep->urb_tstamp);
 }
 
 #ifdef DUMP_PACKETS
@@ -241,6 +246,11 @@ static void snd_usbmidi_in_urb_complete(struct urb *urb)
 	struct snd_usb_midi_in_endpoint *ep = urb->context;
 
 	if (urb->status == 0) {
+		/*
+		 * All messages of a packet arrived together; stamp them with
+		 * the completion rather than with the time each one is parsed.
+		 */
+		ep->urb_tstamp = ktime_get();
 		dump_urb("received", urb->transfer_buffer, urb->actual_length);
 		ep->umidi->usb_protocol_ops->input(ep, urb->transfer_buffer,
 						   urb->actual_length);
@@ -1264,7 +1274,7 @@ static int snd_usbmidi_in_endpoint_create(struct snd_usb_midi *umidi,
 	struct snd_usb_midi_in_endpoint *ep;
 	void *buffer;
 	unsigned int pipe;
-	int length;
+	int length, interval;
 	unsigned int i;
 	int err;
 
@@ -1286,6 +1296,7 @@ static int snd_usbmidi_in_endpoint_create(struct snd_usb_midi *umidi,
 	else
 		pipe = usb_rcvbulkpipe(umidi->dev, ep_info->in_ep);
 	length = usb_maxpacket(umidi->dev, pipe, 0);
+	interval = low_latency ? 1 : ep_info->in_interval;
 	for (i = 0; i < INPUT_URBS; ++i) {
 		buffer = usb_alloc_coherent(umidi->dev, length, GFP_KERNEL,
 					    &ep->urbs[i]->transfer_dma);
@@ -1297,7 +1308,7 @@ static int snd_usbmidi_in_endpoint_create(struct snd_usb_midi *umidi,
 			usb_fill_int_urb(ep->urbs[i], umidi->dev,
 					 pipe, buffer, length,
 					 snd_usbmidi_in_urb_complete,
-					 ep, ep_info->in_interval);
+					 ep, interval);
 		else
 			usb_fill_bulk_urb(ep->urbs[i], umidi->dev,
 					  pipe, buffer, length,
@@ -53,9 +53,11 @@ struct snd_usb_audio {
 
 	int setup;			/* from the 'device_setup' module param */
 	bool generic_implicit_fb;	/* from the 'implicit_fb' module param */
+	bool implicit_fb_smooth;	/* from the 'implicit_fb_smooth' module param */
 	bool autoclock;			/* from the 'autoclock' module param */
 
 	bool lowlatency;		/* from the 'lowlatency' module param */
+	bool lowlatency_urbs;		/* from the 'lowlatency_urbs' module param */
 	struct usb_host_interface *ctrl_intf;	/* the audio control interface */
 	struct media_device *media_dev;
 	struct media_intf_devnode *ctl_intf_media_devnode;
@@ -0,0 +1,696 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Replay HID reports through /dev/uhid and measure how long they take to
+ * reach hidraw and evdev readers, and how much CPU time each report costs.
+ *
+ * Without arguments, every built-in profile is replayed briefly and the test
+ * passes if hidraw saw every report. As a benchmark, pick a profile and a
+ * rate, or replay a hid-recorder capture:
+ *
+ *   hid_replay [-p mouse|pro|drc|touch] [-f recording] [-r rate] [-n count]
+ *              [-b batch]
+ *
+ * Latencies are measured from just before the write() to /dev/uhid to the
+ * return of the read() in the reader thread. The n-th hidraw report and the
+ * n-th evdev SYN_REPORT are matched with the n-th report sent, so evdev
+ * numbers are only meaningful when every report changes some input state,
+ * which the synthetic reports of the built-in profiles do.
+ */
+
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <glob.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <linux/input.h>
+#include <linux/uhid.h>
+
+#include "../kselftest.h"
+
+#define MAX_REPORT	UHID_DATA_MAX
+
+struct profile {
+	const char *name;
+	const char *desc;
+	const uint8_t *rd;
+	size_t rd_size;
+	size_t report_size;
+	unsigned int rate;
+	/* fill report @seq so that it differs from report @seq - 1 */
+	void (*fill)(uint8_t *data, unsigned int seq);
+};
+
+/* 3 buttons, relative X/Y and wheel, no report ID */
+static const uint8_t mouse_rd[] = {
+	0x05, 0x01, 0x09, 0x02, 0xa1, 0x01, 0x09, 0x01,
+	0xa1, 0x00, 0x05, 0x09, 0x19, 0x01, 0x29, 0x03,
+	0x15, 0x00, 0x25, 0x01, 0x95, 0x03, 0x75, 0x01,
+	0x81, 0x02, 0x95, 0x01, 0x75, 0x05, 0x81, 0x01,
+	0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x09, 0x38,
+	0x15, 0x81, 0x25, 0x7f, 0x75, 0x08, 0x95, 0x03,
+	0x81, 0x06, 0xc0, 0xc0,
+};
+
+static void mouse_fill(uint8_t *data, unsigned int seq)
+{
+	memset(data, 0, 4);
+	data[1] = seq & 1 ? 1 : 0xff;
+}
+
+/*
+ * Shaped like the Switch Pro controller full report 0x30: report ID, 16
+ * buttons, four 16 bit sticks and vendor data up to 64 bytes.
+ */
+static const uint8_t pro_rd[] = {
+	0x05, 0x01, 0x09, 0x05, 0xa1, 0x01, 0x85, 0x30,
+	0x05, 0x09, 0x19, 0x01, 0x29, 0x10, 0x15, 0x00,
+	0x25, 0x01, 0x75, 0x01, 0x95, 0x10, 0x81, 0x02,
+	0x05, 0x01, 0x09, 0x30, 0x09, 0x31, 0x09, 0x33,
+	0x09, 0x34, 0x15, 0x00, 0x27, 0xff, 0xff, 0x00,
+	0x00, 0x75, 0x10, 0x95, 0x04, 0x81, 0x02, 0x06,
+	0x00, 0xff, 0x09, 0x01, 0x15, 0x00, 0x26, 0xff,
+	0x00, 0x75, 0x08, 0x95, 0x35, 0x81, 0x02, 0xc0,
+};
+
+static void pro_fill(uint8_t *data, unsigned int seq)
+{
+	memset(data, 0, 64);
+	data[0] = 0x30;
+	data[4] = 0x80 + (seq & 1);
+}
+
+/* Shaped like the Wii U DRC: one vendor defined 128 byte report */
+static const uint8_t drc_rd[] = {
+	0x06, 0x00, 0xff, 0x09, 0x01, 0xa1, 0x01, 0x85,
+	0x01, 0x09, 0x01, 0x15, 0x00, 0x26, 0xff, 0x00,
+	0x75, 0x08, 0x95, 0x7f, 0x81, 0x02, 0xc0,
+};
+
+static void drc_fill(uint8_t *data, unsigned int seq)
+{
+	memset(data, 0, 128);
+	data[0] = 0x01;
+	data[1] = seq;
+	data[2] = seq >> 8;
+}
+
+/*
+ * A touchscreen handled by hid-multitouch: report ID 1, ten contacts of
+ * tip switch, contact ID and 12 bit X/Y each, then the contact count.
+ */
+#define TOUCH_CONTACTS	10
+#define TOUCH_FINGER							\
+	0x09, 0x22, 0xa1, 0x02, 0x09, 0x42, 0x15, 0x00,			\
+	0x25, 0x01, 0x75, 0x01, 0x95, 0x01, 0x81, 0x02,			\
+	0x75, 0x07, 0x81, 0x03, 0x09, 0x51, 0x25, 0x09,			\
+	0x75, 0x08, 0x81, 0x02, 0x05, 0x01, 0x09, 0x30,			\
+	0x09, 0x31, 0x26, 0xff, 0x0f, 0x75, 0x10, 0x95,			\
+	0x02, 0x81, 0x02, 0x05, 0x0d, 0xc0
+
+static const uint8_t touch_rd[] = {
+	0x05, 0x0d, 0x09, 0x04, 0xa1, 0x01, 0x85, 0x01,
+	TOUCH_FINGER, TOUCH_FINGER, TOUCH_FINGER, TOUCH_FINGER,
+	TOUCH_FINGER, TOUCH_FINGER, TOUCH_FINGER, TOUCH_FINGER,
+	TOUCH_FINGER, TOUCH_FINGER,
+	0x09, 0x54, 0x25, 0x0a, 0x75, 0x08, 0x95, 0x01,
+	0x81, 0x02, 0xc0,
+};
+
+static void touch_fill(uint8_t *data, unsigned int seq)
+{
+	unsigned int i, x, y;
+
+	memset(data, 0, 2 + 6 * TOUCH_CONTACTS);
+	data[0] = 0x01;
+	for (i = 0; i < TOUCH_CONTACTS; i++) {
+		uint8_t *c = &data[1 + 6 * i];
+
+		x = 200 + 350 * i + (seq & 1);
+		y = 2000 + (seq & 1);
+		c[0] = 1;
+		c[1] = i;
+		c[2] = x;
+		c[3] = x >> 8;
+		c[4] = y;
+		c[5] = y >> 8;
+	}
+	data[1 + 6 * TOUCH_CONTACTS] = TOUCH_CONTACTS;
+}
+
+static const struct profile profiles[] = {
+	{ "mouse", "1 kHz mouse", mouse_rd, sizeof(mouse_rd), 4, 1000, mouse_fill },
+	{ "pro", "Switch Pro controller", pro_rd, sizeof(pro_rd), 64, 120, pro_fill },
+	{ "drc", "Wii U DRC", drc_rd, sizeof(drc_rd), 128, 180, drc_fill },
+	{ "touch", "10 finger touchscreen", touch_rd, sizeof(touch_rd),
+	  2 + 6 * TOUCH_CONTACTS, 240, touch_fill },
+};
+
+struct report {
+	uint16_t size;
+	uint8_t data[MAX_REPORT];
+};
+
+struct reader {
+	const char *name;
+	int fd;
+	bool evdev;
+	uint64_t *recv;
+	unsigned int count;
+	unsigned int max;
+	pthread_t thread;
+};
+
+static volatile bool stop;
+static uint64_t *sent;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int uhid_write(int fd, const struct uhid_event *ev, size_t len)
+{
+	ssize_t ret = write(fd, ev, len);
+
+	if (ret < 0)
+		return -errno;
+	return ret == len ? 0 : -EFAULT;
+}
+
+static int uhid_create(int fd, const uint8_t *rd, size_t rd_size,
+		       const char *uniq)
+{
+	struct uhid_event ev;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.type = UHID_CREATE2;
+	snprintf((char *)ev.u.create2.name, sizeof(ev.u.create2.name),
+		 "hid-replay");
+	snprintf((char *)ev.u.create2.uniq, sizeof(ev.u.create2.uniq), "%s",
+		 uniq);
+	memcpy(ev.u.create2.rd_data, rd, rd_size);
+	ev.u.create2.rd_size = rd_size;
+	ev.u.create2.bus = BUS_VIRTUAL;
+	ev.u.create2.vendor = 0x0001;
+	ev.u.create2.product = 0x0001;
+
+	return uhid_write(fd, &ev, sizeof(ev));
+}
+
+static void uhid_destroy(int fd)
+{
+	struct uhid_event ev = { .type = UHID_DESTROY };
+
+	uhid_write(fd, &ev, sizeof(ev));
+}
+
+/* wait for the kernel to bind a driver to the new device */
+static int uhid_wait_start(int fd)
+{
+	struct pollfd pfd = { .fd = fd, .events = POLLIN };
+	struct uhid_event ev;
+
+	while (poll(&pfd, 1, 2000) > 0) {
+		if (read(fd, &ev, sizeof(ev)) <= 0)
+			return -EIO;
+		if (ev.type == UHID_START)
+			return 0;
+	}
+
+	return -ETIMEDOUT;
+}
+
+/* find the hidraw node of our device from its uniq string */
+static int find_hidraw(const char *uniq, char *hidraw, size_t len)
+{
+	char path[512], line[256], match[128];
+	struct dirent *de;
+	bool found;
+	DIR *dir;
+	FILE *f;
+
+	snprintf(match, sizeof(match), "HID_UNIQ=%s\n", uniq);
+
+	dir = opendir("/sys/class/hidraw");
+	if (!dir)
+		return -errno;
+
+	while ((de = readdir(dir))) {
+		if (strncmp(de->d_name, "hidraw", 6))
+			continue;
+
+		snprintf(path, sizeof(path), "/sys/class/hidraw/%s/device/uevent",
+			 de->d_name);
+		f = fopen(path, "r");
+		if (!f)
+			continue;
+
+		found = false;
+		while (fgets(line, sizeof(line), f))
+			if (!strcmp(line, match))
+				found = true;
+		fclose(f);
+
+		if (found) {
+			snprintf(hidraw, len, "%s", de->d_name);
+			closedir(dir);
+			return 0;
+		}
+	}
+
+	closedir(dir);
+	return -ENOENT;
+}
+
+static int open_nodes(const char *uniq, int *hidraw_fd, int *evdev_fd)
+{
+	char hidraw[64], path[512];
+	glob_t g;
+	int i, ret = -ENOENT;
+
+	/* udev may still be creating the nodes */
+	for (i = 0; i < 40 && ret; i++) {
+		ret = find_hidraw(uniq, hidraw, sizeof(hidraw));
+		if (!ret) {
+			snprintf(path, sizeof(path), "/dev/%s", hidraw);
+			*hidraw_fd = open(path, O_RDONLY);
+			ret = *hidraw_fd < 0 ? -errno : 0;
+		}
+		if (ret)
+			usleep(50000);
+	}
+	if (ret)
+		return ret;
+
+	*evdev_fd = -1;
+	snprintf(path, sizeof(path),
+		 "/sys/class/hidraw/%s/device/input/input*/event*", hidraw);
+	if (!glob(path, 0, NULL, &g)) {
+		snprintf(path, sizeof(path), "/dev/input/%s",
+			 strrchr(g.gl_pathv[0], '/') + 1);
+		*evdev_fd = open(path, O_RDONLY);
+		globfree(&g);
+	}
+
+	return 0;
+}
+
+static void *reader_thread(void *arg)
+{
+	struct reader *r = arg;
+	struct pollfd pfd = { .fd = r->fd, .events = POLLIN };
+	struct input_event iev[64];
+	uint8_t buf[MAX_REPORT];
+	uint64_t t;
+	ssize_t len;
+	int i;
+
+	while (!stop && r->count < r->max) {
+		if (poll(&pfd, 1, 100) <= 0)
+			continue;
+
+		len = read(r->fd, r->evdev ? (void *)iev : (void *)buf,
+			   r->evdev ? sizeof(iev) : sizeof(buf));
+		t = now_ns();
+		if (len <= 0)
+			break;
+
+		if (!r->evdev) {
+			r->recv[r->count++] = t;
+			continue;
+		}
+
+		for (i = 0; i < len / sizeof(iev[0]) && r->count < r->max; i++)
+			if (iev[i].type == EV_SYN && iev[i].code == SYN_REPORT)
+				r->recv[r->count++] = t;
+	}
+
+	return NULL;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void print_latency(struct reader *r, unsigned int sent_count)
+{
+	unsigned int n = r->count < sent_count ? r->count : sent_count;
+	uint64_t *lat;
+	unsigned int i;
+
+	if (!n) {
+		ksft_print_msg("%s: no reports received\n", r->name);
+		return;
+	}
+
+	lat = calloc(n, sizeof(*lat));
+	if (!lat)
+		return;
+
+	for (i = 0; i < n; i++)
+		lat[i] = r->recv[i] - sent[i];
+	qsort(lat, n, sizeof(*lat), cmp_u64);
+
+	ksft_print_msg("%s: %u/%u reports, latency us p50 %.1f p90 %.1f p99 %.1f p99.9 %.1f max %.1f\n",
+		       r->name, r->count, sent_count,
+		       lat[n / 2] / 1000.0, lat[n * 90 / 100] / 1000.0,
+		       lat[n * 99 / 100] / 1000.0, lat[n * 999 / 1000] / 1000.0,
+		       lat[n - 1] / 1000.0);
+	free(lat);
+}
+
+static uint64_t cpu_ns(void)
+{
+	struct rusage ru;
+
+	getrusage(RUSAGE_SELF, &ru);
+	return (ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) * 1000000000ULL +
+	       (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) * 1000ULL;
+}
+
+/* send reports[0..count) in batches of @batch, paced at @rate per second */
+static int replay(int fd, const struct report *reports, unsigned int nr_reports,
+		  unsigned int count, unsigned int rate, unsigned int batch)
+{
+	struct uhid_event ev;
+	struct timespec next;
+	uint64_t period = 1000000000ULL * batch / rate;
+	unsigned int i, j;
+	size_t len, off;
+	uint64_t t;
+	int ret;
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+
+	for (i = 0; i < count; i += batch) {
+		memset(&ev, 0, offsetof(struct uhid_event, u.input2.data));
+
+		if (batch == 1) {
+			const struct report *r = &reports[i % nr_reports];
+
+			ev.type = UHID_INPUT2;
+			ev.u.input2.size = r->size;
+			memcpy(ev.u.input2.data, r->data, r->size);
+			len = offsetof(struct uhid_event, u.input2.data) + r->size;
+		} else {
+			ev.type = UHID_INPUT2_BATCH;
+			for (j = 0, off = 0; j < batch && i + j < count; j++) {
+				const struct report *r = &reports[(i + j) % nr_reports];
+
+				if (off + sizeof(r->size) + r->size > UHID_DATA_MAX)
+					break;
+				memcpy(ev.u.input2_batch.data + off, &r->size,
+				       sizeof(r->size));
+				memcpy(ev.u.input2_batch.data + off + sizeof(r->size),
+				       r->data, r->size);
+				off += sizeof(r->size) + r->size;
+			}
+			ev.u.input2_batch.size = off;
+			len = offsetof(struct uhid_event, u.input2_batch.data) + off;
+		}
+
+		t = now_ns();
+		for (j = i; j < i + batch && j < count; j++)
+			sent[j] = t;
+
+		ret = uhid_write(fd, &ev, len);
+		if (ret)
+			return ret;
+
+		next.tv_nsec += period;
+		while (next.tv_nsec >= 1000000000L) {
+			next.tv_nsec -= 1000000000L;
+			next.tv_sec++;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+	}
+
+	return 0;
+}
+
+static int parse_hex(char *s, uint8_t *out, size_t max)
+{
+	size_t n = 0;
+	char *end;
+
+	while (n < max) {
+		unsigned long v = strtoul(s, &end, 16);
+
+		if (end == s)
+			break;
+		out[n++] = v;
+		s = end;
+	}
+
+	return n;
+}
+
+/*
+ * Read a hid-recorder capture: "R: <len> <bytes>" is the descriptor and every
+ * "E: <time> <len> <bytes>" line is a report. Timing is not preserved.
+ */
+static struct report *load_recording(const char *file, uint8_t *rd,
+				     size_t *rd_size, unsigned int *nr)
+{
+	struct report *reports = NULL, *tmp;
+	unsigned int n = 0, alloc = 0;
+	char line[16384], *p;
+	FILE *f;
+
+	f = fopen(file, "r");
+	if (!f)
+		return NULL;
+
+	*rd_size = 0;
+	while (fgets(line, sizeof(line), f)) {
+		if (!strncmp(line, "R:", 2)) {
+			p = line + 2;
+			strtoul(p, &p, 10);
+			*rd_size = parse_hex(p, rd, HID_MAX_DESCRIPTOR_SIZE);
+		} else if (!strncmp(line, "E:", 2)) {
+			if (n == alloc) {
+				alloc = alloc ? alloc * 2 : 256;
+				tmp = realloc(reports, alloc * sizeof(*reports));
+				if (!tmp)
+					break;
+				reports = tmp;
+			}
+			p = line + 2;
+			strtod(p, &p);
+			strtoul(p, &p, 10);
+			reports[n].size = parse_hex(p, reports[n].data, MAX_REPORT);
+			if (reports[n].size)
+				n++;
+		}
+	}
+
+	fclose(f);
+	*nr = n;
+
+	if (!n || !*rd_size) {
+		free(reports);
+		return NULL;
+	}
+
+	return reports;
+}
+
+static int run(const char *name, const uint8_t *rd, size_t rd_size,
+	       const struct report *reports, unsigned int nr_reports,
+	       unsigned int count, unsigned int rate, unsigned int batch)
+{
+	struct reader readers[2] = {
+		{ .name = "hidraw", .fd = -1 },
+		{ .name = "evdev", .fd = -1, .evdev = true },
+	};
+	uint64_t cpu, wall;
+	char uniq[64];
+	int fd, ret, i;
+
+	fd = open("/dev/uhid", O_RDWR | O_CLOEXEC);
+	if (fd < 0)
+		return -errno;
+
+	snprintf(uniq, sizeof(uniq), "hid-replay-%d-%s", getpid(), name);
+	ret = uhid_create(fd, rd, rd_size, uniq);
+	if (!ret)
+		ret = uhid_wait_start(fd);
+	if (!ret)
+		ret = open_nodes(uniq, &readers[0].fd, &readers[1].fd);
+	if (ret)
+		goto out;
+
+	sent = calloc(count, sizeof(*sent));
+	for (i = 0; i < 2; i++) {
+		readers[i].max = count;
+		readers[i].recv = calloc(count, sizeof(uint64_t));
+	}
+	if (!sent || !readers[0].recv || !readers[1].recv) {
+		ret = -ENOMEM;
+		goto free;
+	}
+
+	stop = false;
+	for (i = 0; i < 2; i++)
+		if (readers[i].fd >= 0)
+			pthread_create(&readers[i].thread, NULL, reader_thread,
+				       &readers[i]);
+
+	cpu = cpu_ns();
+	wall = now_ns();
+	ret = replay(fd, reports, nr_reports, count, rate, batch);
+
+	/* give the readers a moment to catch up */
+	for (i = 0; i < 20 && readers[0].count < count; i++)
+		usleep(10000);
+	stop = true;
+
+	for (i = 0; i < 2; i++)
+		if (readers[i].fd >= 0)
+			pthread_join(readers[i].thread, NULL);
+	cpu = cpu_ns() - cpu;
+	wall = now_ns() - wall;
+
+	ksft_print_msg("%s: %u reports at %u Hz, batch %u, %.1f s, cpu %.0f ns/report\n",
+		       name, count, rate, batch, wall / 1e9,
+		       (double)cpu / count);
+	for (i = 0; i < 2; i++)
+		if (readers[i].fd >= 0)
+			print_latency(&readers[i], count);
+
+	if (!ret && readers[0].count != count)
+		ret = -EPIPE;
+
+free:
+	for (i = 0; i < 2; i++) {
+		if (readers[i].fd >= 0)
+			close(readers[i].fd);
+		free(readers[i].recv);
+	}
+	free(sent);
+
+out:
+	uhid_destroy(fd);
+	close(fd);
+	return ret;
+}
+
+static void finish(void)
+{
+	if (ksft_get_fail_cnt())
+		ksft_exit_fail();
+	ksft_exit_pass();
+}
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [-p mouse|pro|drc|touch] [-f recording] [-r rate] [-n count] [-b batch]\n",
+		argv0);
+	exit(KSFT_FAIL);
+}
+
+int main(int argc, char **argv)
+{
+	static uint8_t rd[HID_MAX_DESCRIPTOR_SIZE];
+	const struct profile *profile = NULL;
+	unsigned int count = 0, rate = 0, batch = 1, nr;
+	const char *recording = NULL;
+	struct report *reports;
+	size_t rd_size;
+	unsigned int i, j;
+	int opt, ret;
+
+	while ((opt = getopt(argc, argv, "p:f:r:n:b:")) != -1) {
+		switch (opt) {
+		case 'p':
+			for (i = 0; i < ARRAY_SIZE(profiles); i++)
+				if (!strcmp(optarg, profiles[i].name))
+					profile = &profiles[i];
+			if (!profile)
+				usage(argv[0]);
+			break;
+		case 'f':
+			recording = optarg;
+			break;
+		case 'r':
+			rate = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			count = strtoul(optarg, NULL, 0);
+			break;
+		case 'b':
+			batch = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	if (!batch)
+		usage(argv[0]);
+
+	if (access("/dev/uhid", R_OK | W_OK))
+		ksft_exit_skip("cannot open /dev/uhid, need root and CONFIG_UHID\n");
+
+	ksft_print_header();
+
+	if (recording) {
+		reports = load_recording(recording, rd, &rd_size, &nr);
+		if (!reports)
+			ksft_exit_fail_msg("cannot load %s\n", recording);
+
+		ksft_set_plan(1);
+		ret = run(recording, rd, rd_size, reports, nr,
+			  count ? count : nr, rate ? rate : 1000, batch);
+		ksft_test_result(!ret, "replay %s: %s\n", recording,
+				 strerror(-ret));
+		free(reports);
+		finish();
+	}
+
+	ksft_set_plan(profile ? 1 : ARRAY_SIZE(profiles));
+
+	reports = calloc(2, sizeof(*reports));
+	if (!reports)
+		ksft_exit_fail_msg("out of memory\n");
+
+	for (i = 0; i < ARRAY_SIZE(profiles); i++) {
+		const struct profile *p = &profiles[i];
+
+		if (profile && profile != p)
+			continue;
+
+		/* two alternating reports, so every one changes the state */
+		for (j = 0; j < 2; j++) {
+			reports[j].size = p->report_size;
+			p->fill(reports[j].data, j);
+		}
+
+		ret = run(p->name, p->rd, p->rd_size, reports, 2,
+			  count ? count : p->rate, rate ? rate : p->rate, batch);
+		ksft_test_result(!ret, "%s (%s): %s\n", p->name, p->desc,
+				 strerror(-ret));
+	}
+
+	free(reports);
+	finish();
+}
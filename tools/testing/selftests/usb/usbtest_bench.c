@@ -0,0 +1,344 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Benchmark URB submission and completion through the usbtest driver.
+ *
+ * Needs a device bound to usbtest, typically gadget zero (g_zero, or the
+ * sourcesink function) connected through a real host controller or through
+ * dummy_hcd. Measures:
+ *
+ *   - round-trip latency of single interrupt and bulk transfers, each
+ *     one usbtest ioctl of one URB, from the duration usbtest reports
+ *   - bulk and isochronous throughput with 1..N URBs queued at once
+ *
+ * and prints percentiles over the repeated runs. Tests the device has no
+ * endpoints for are skipped.
+ *
+ *   usbtest_bench [-D /dev/bus/usb/BBB/DDD -i ifno] [-w] [-q depths]
+ *                 [-n runs] [-l length]
+ *
+ * -w measures OUT instead of IN transfers, -q takes a comma separated
+ * list of queue depths (default 1,2,4,8).
+ */
+
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <linux/types.h>
+#include <linux/usbdevice_fs.h>
+
+#include "../kselftest.h"
+
+#define USBTEST_DRIVER	"/sys/bus/usb/drivers/usbtest"
+#define MAX_DEPTHS	16
+#define MAX_SGLEN	128	/* as in usbtest */
+
+/* mirrors struct usbtest_param_64 in drivers/usb/misc/usbtest.c */
+struct usbtest_param {
+	/* inputs */
+	__u32		test_num;
+	__u32		iterations;
+	__u32		length;
+	__u32		vary;
+	__u32		sglen;
+
+	/* outputs */
+	__s64		duration_sec;
+	__s64		duration_usec;
+};
+
+#define USBTEST_REQUEST	_IOWR('U', 100, struct usbtest_param)
+
+/* usbtest test numbers, IN and OUT */
+struct bench {
+	const char *name;
+	unsigned int test_in, test_out;
+	bool queued;		/* throughput over a URB queue */
+	unsigned int length;	/* default transfer length */
+	unsigned int bytes;	/* rough data per throughput run */
+};
+
+static const struct bench benches[] = {
+	{ "interrupt latency", 26, 25, false, 64, 0 },
+	{ "bulk latency", 2, 1, false, 512, 0 },
+	{ "bulk throughput", 28, 27, true, 16384, 4 << 20 },
+	{ "iso throughput", 16, 15, true, 3072, 1 << 20 },
+};
+
+static int usbtest(int fd, int ifno, struct usbtest_param *param)
+{
+	struct usbdevfs_ioctl wrapper = {
+		.ifno = ifno,
+		.ioctl_code = USBTEST_REQUEST,
+		.data = param,
+	};
+
+	if (ioctl(fd, USBDEVFS_IOCTL, &wrapper) < 0)
+		return -errno;
+	return 0;
+}
+
+static double duration_us(const struct usbtest_param *param)
+{
+	return param->duration_sec * 1e6 + param->duration_usec;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void print_percentiles(const char *label, const char *unit,
+			      double *v, unsigned int n)
+{
+	qsort(v, n, sizeof(*v), cmp_double);
+	ksft_print_msg("%s: %u runs, %s p50 %.1f p90 %.1f p99 %.1f min %.1f max %.1f\n",
+		       label, n, unit, v[n / 2], v[n * 90 / 100],
+		       v[n * 99 / 100], v[0], v[n - 1]);
+}
+
+/* one URB per ioctl; usbtest's duration covers setup, submit and wait */
+static int run_latency(int fd, int ifno, const char *label,
+		       unsigned int test, unsigned int length,
+		       unsigned int runs)
+{
+	struct usbtest_param param;
+	unsigned int i;
+	double *lat;
+	int ret = 0;
+
+	lat = calloc(runs, sizeof(*lat));
+	if (!lat)
+		return -ENOMEM;
+
+	for (i = 0; i < runs; i++) {
+		memset(&param, 0, sizeof(param));
+		param.test_num = test;
+		param.iterations = 1;
+		param.length = length;
+		ret = usbtest(fd, ifno, &param);
+		if (ret)
+			goto out;
+		lat[i] = duration_us(&param);
+	}
+	print_percentiles(label, "latency us", lat, runs);
+out:
+	free(lat);
+	return ret;
+}
+
+static int run_throughput(int fd, int ifno, const char *label,
+			  unsigned int test, unsigned int length,
+			  unsigned int bytes, unsigned int depth,
+			  unsigned int runs)
+{
+	struct usbtest_param param;
+	unsigned int i, iterations;
+	double *mbps, *urb_us;
+	char name[64];
+	int ret = -ENOMEM;
+
+	iterations = bytes / (length * depth);
+	if (!iterations)
+		iterations = 1;
+
+	mbps = calloc(runs, sizeof(*mbps));
+	urb_us = calloc(runs, sizeof(*urb_us));
+	if (!mbps || !urb_us)
+		goto out;
+
+	for (i = 0; i < runs; i++) {
+		memset(&param, 0, sizeof(param));
+		param.test_num = test;
+		param.iterations = iterations;
+		param.length = length;
+		param.sglen = depth;
+		ret = usbtest(fd, ifno, &param);
+		if (ret)
+			goto out;
+		mbps[i] = (double)iterations * depth * length /
+			  duration_us(&param);
+		urb_us[i] = duration_us(&param) / (iterations * depth);
+	}
+
+	snprintf(name, sizeof(name), "%s, depth %u", label, depth);
+	print_percentiles(name, "MB/s", mbps, runs);
+	print_percentiles(name, "us per URB", urb_us, runs);
+out:
+	free(mbps);
+	free(urb_us);
+	return ret;
+}
+
+static int read_sysfs_int(const char *dir, const char *attr, int *val)
+{
+	char path[512];
+	FILE *f;
+	int ret;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, attr);
+	f = fopen(path, "r");
+	if (!f)
+		return -errno;
+	ret = fscanf(f, "%d", val) == 1 ? 0 : -EINVAL;
+	fclose(f);
+	return ret;
+}
+
+/* first interface bound to usbtest, as a usbfs node and interface number */
+static int find_usbtest(char *node, size_t size, int *ifno)
+{
+	char dev[256], intf[512];
+	struct dirent *de;
+	int busnum, devnum;
+	DIR *dir;
+	char *colon;
+	int ret = -ENODEV;
+
+	dir = opendir(USBTEST_DRIVER);
+	if (!dir)
+		return -ENODEV;
+
+	while ((de = readdir(dir))) {
+		colon = strchr(de->d_name, ':');
+		if (!colon)
+			continue;
+
+		snprintf(intf, sizeof(intf), USBTEST_DRIVER "/%s", de->d_name);
+		snprintf(dev, sizeof(dev), "/sys/bus/usb/devices/%.*s",
+			 (int)(colon - de->d_name), de->d_name);
+		if (sscanf(colon + 1, "%*d.%d", ifno) != 1 ||
+		    read_sysfs_int(dev, "busnum", &busnum) ||
+		    read_sysfs_int(dev, "devnum", &devnum))
+			continue;
+
+		snprintf(node, size, "/dev/bus/usb/%03d/%03d", busnum, devnum);
+		ret = 0;
+		break;
+	}
+	closedir(dir);
+	return ret;
+}
+
+static void finish(void)
+{
+	if (ksft_get_fail_cnt())
+		ksft_exit_fail();
+	ksft_exit_pass();
+}
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [-D /dev/bus/usb/BBB/DDD -i ifno] [-w] [-q depths] [-n runs] [-l length]\n",
+		argv0);
+	exit(KSFT_FAIL);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int depths[MAX_DEPTHS] = { 1, 2, 4, 8 };
+	unsigned int nr_depths = 4, runs = 0, length = 0;
+	unsigned int i, j, test, plan = 0;
+	const char *device = NULL;
+	bool out = false;
+	char node[64];
+	int opt, fd, ret, ifno = 0;
+	char *tok;
+
+	while ((opt = getopt(argc, argv, "D:i:wq:n:l:")) != -1) {
+		switch (opt) {
+		case 'D':
+			device = optarg;
+			break;
+		case 'i':
+			ifno = strtoul(optarg, NULL, 0);
+			break;
+		case 'w':
+			out = true;
+			break;
+		case 'q':
+			nr_depths = 0;
+			for (tok = strtok(optarg, ","); tok;
+			     tok = strtok(NULL, ",")) {
+				if (nr_depths == MAX_DEPTHS)
+					usage(argv[0]);
+				depths[nr_depths] = strtoul(tok, NULL, 0);
+				if (!depths[nr_depths] ||
+				    depths[nr_depths] > MAX_SGLEN)
+					usage(argv[0]);
+				nr_depths++;
+			}
+			if (!nr_depths)
+				usage(argv[0]);
+			break;
+		case 'n':
+			runs = strtoul(optarg, NULL, 0);
+			if (!runs)
+				usage(argv[0]);
+			break;
+		case 'l':
+			length = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	if (!device) {
+		if (find_usbtest(node, sizeof(node), &ifno))
+			ksft_exit_skip("no device bound to usbtest, load dummy_hcd, g_zero and usbtest\n");
+		device = node;
+	}
+
+	fd = open(device, O_RDWR);
+	if (fd < 0)
+		ksft_exit_skip("cannot open %s: %s\n", device, strerror(errno));
+
+	ksft_print_header();
+	for (i = 0; i < ARRAY_SIZE(benches); i++)
+		plan += benches[i].queued ? nr_depths : 1;
+	ksft_set_plan(plan);
+	ksft_print_msg("%s interface %d, %s transfers\n", device, ifno,
+		       out ? "OUT" : "IN");
+
+	for (i = 0; i < ARRAY_SIZE(benches); i++) {
+		const struct bench *b = &benches[i];
+		unsigned int len = length ? length : b->length;
+
+		test = out ? b->test_out : b->test_in;
+		for (j = 0; j < (b->queued ? nr_depths : 1); j++) {
+			if (b->queued)
+				ret = run_throughput(fd, ifno, b->name, test,
+						     len, b->bytes, depths[j],
+						     runs ? runs : 20);
+			else
+				ret = run_latency(fd, ifno, b->name, test, len,
+						  runs ? runs : 500);
+
+			if (ret == -EOPNOTSUPP)
+				ksft_test_result_skip("%s: no such endpoint\n",
+						      b->name);
+			else if (b->queued)
+				ksft_test_result(!ret, "%s, depth %u: %s\n",
+						 b->name, depths[j],
+						 strerror(-ret));
+			else
+				ksft_test_result(!ret, "%s: %s\n", b->name,
+						 strerror(-ret));
+		}
+	}
+
+	close(fd);
+	finish();
+}